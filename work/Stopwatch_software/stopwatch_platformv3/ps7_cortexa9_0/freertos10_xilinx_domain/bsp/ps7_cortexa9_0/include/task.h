@@ -168,6 +168,24 @@ typedef struct xTASK_STATUS
     configSTACK_DEPTH_TYPE usStackHighWaterMark;  /* The minimum amount of stack space that has remained for the task since the task was created.  The closer this value is to zero the closer the task has come to overflowing its stack. */
 } TaskStatus_t;
 
+/* Timing of the periodic tasks created with xTaskCreateEdf(), in ticks. */
+typedef struct xTASK_EDF_PARAMETERS
+{
+    TickType_t xPeriod;   /* Time between the releases of two jobs. */
+    TickType_t xDeadline; /* Time after its release by which a job must end, at most xPeriod. */
+    TickType_t xBudget;   /* Worst case time a job runs, checked by admission control. */
+} TaskEdfParameters_t;
+
+/* Used with vTaskEdfGetStats(). */
+typedef struct xTASK_EDF_STATS
+{
+    uint32_t ulJobs;           /* Jobs ended by xTaskEdfWaitForNextPeriod(). */
+    uint32_t ulDeadlineMisses; /* Jobs ended after their deadline. */
+    uint32_t ulBudgetOverruns; /* Jobs that ran for more ticks than xBudget. */
+    TickType_t xMaxLateness;   /* Latest end after a deadline, in ticks. */
+    uint32_t ulDensity;        /* Budget over deadline admitted for the task, in millionths. */
+} TaskEdfStats_t;
+
 /* Possible return values for eTaskConfirmSleepModeStatus(). */
 typedef enum
 {
@@ -185,6 +203,14 @@ typedef enum
  */
 #define tskIDLE_PRIORITY    ( ( UBaseType_t ) 0U )
 
+/**
+ * Core affinity mask of a task that may run on any core.  Tasks are created
+ * with it.
+ *
+ * \ingroup TaskUtils
+ */
+#define tskNO_AFFINITY      ( ( UBaseType_t ) -1 )
+
 /**
  * task. h
  *
@@ -903,6 +929,159 @@ BaseType_t xTaskDelayUntil( TickType_t * const pxPreviousWakeTime,
  */
 BaseType_t xTaskAbortDelay( TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
 
+/**
+ * task. h
+ * @code{c}
+ * BaseType_t xTaskAbortDelayFromISR( TaskHandle_t xTask, BaseType_t *pxHigherPriorityTaskWoken );
+ * @endcode
+ *
+ * INCLUDE_xTaskAbortDelay must be defined as 1 in FreeRTOSConfig.h for this
+ * function to be available.
+ *
+ * A version of xTaskAbortDelay() that can be called from an interrupt service
+ * routine, limited to tasks that are not waiting on an object: a task blocked
+ * in vTaskDelay(), vTaskDelayUntil() or a task notification wait with a
+ * timeout returns from that call.  Tasks blocked on a queue, semaphore, event
+ * group or stream buffer, or blocked without a timeout, are left alone.
+ *
+ * @param xTask The handle of the task to remove from the Blocked state.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if the woken task has a
+ * priority above the running task, a context switch should then be requested
+ * before the interrupt is exited.
+ *
+ * @return pdPASS if the task was woken, otherwise pdFAIL.
+ *
+ * \defgroup xTaskAbortDelayFromISR xTaskAbortDelayFromISR
+ * \ingroup TaskCtrl
+ */
+BaseType_t xTaskAbortDelayFromISR( TaskHandle_t xTask,
+                                   BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * BaseType_t xTaskCreateEdf( TaskFunction_t pxTaskCode,
+ *                            const char * const pcName,
+ *                            const configSTACK_DEPTH_TYPE usStackDepth,
+ *                            void * const pvParameters,
+ *                            const TaskEdfParameters_t * const pxEdfParameters,
+ *                            TaskHandle_t * const pxCreatedTask );
+ * @endcode
+ *
+ * configUSE_EDF_SCHEDULING and configSUPPORT_DYNAMIC_ALLOCATION must be defined
+ * as 1 in FreeRTOSConfig.h for this function to be available.
+ *
+ * Creates a periodic task scheduled earliest deadline first.  All such tasks
+ * run at configEDF_PRIORITY, above or below the fixed priority tasks like any
+ * task of that priority, and among themselves the ready job with the earliest
+ * deadline runs.  The first job is released at once, the task ends each job
+ * with xTaskEdfWaitForNextPeriod().
+ *
+ * Admission control refuses the task when the sum of budget over deadline of
+ * all the EDF tasks would exceed configEDF_UTILISATION_LIMIT percent.  Deleting
+ * an EDF task gives its share back.
+ *
+ * @param pxTaskCode, pcName, usStackDepth, pvParameters, pxCreatedTask As for
+ * xTaskCreate().
+ *
+ * @param pxEdfParameters Period, relative deadline and budget of the task.
+ *
+ * @return pdPASS if the task was created, pdFAIL if admission control refused
+ * it, otherwise errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY.
+ *
+ * \defgroup xTaskCreateEdf xTaskCreateEdf
+ * \ingroup Tasks
+ */
+#if ( configUSE_EDF_SCHEDULING == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+    BaseType_t xTaskCreateEdf( TaskFunction_t pxTaskCode,
+                               const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                               const configSTACK_DEPTH_TYPE usStackDepth,
+                               void * const pvParameters,
+                               const TaskEdfParameters_t * const pxEdfParameters,
+                               TaskHandle_t * const pxCreatedTask ) PRIVILEGED_FUNCTION;
+#endif
+
+/**
+ * task. h
+ * @code{c}
+ * BaseType_t xTaskCreateEdfStatic( TaskFunction_t pxTaskCode,
+ *                                  const char * const pcName,
+ *                                  const uint32_t ulStackDepth,
+ *                                  void * const pvParameters,
+ *                                  const TaskEdfParameters_t * const pxEdfParameters,
+ *                                  StackType_t * const puxStackBuffer,
+ *                                  StaticTask_t * const pxTaskBuffer,
+ *                                  TaskHandle_t * const pxCreatedTask );
+ * @endcode
+ *
+ * configUSE_EDF_SCHEDULING and configSUPPORT_STATIC_ALLOCATION must be defined
+ * as 1 in FreeRTOSConfig.h for this function to be available.
+ *
+ * As xTaskCreateEdf(), with the stack and the task structure in the buffers
+ * given as for xTaskCreateStatic().  A refused task leaves the buffers unused.
+ *
+ * @return pdPASS if the task was created, pdFAIL if admission control refused
+ * it.
+ *
+ * \defgroup xTaskCreateEdfStatic xTaskCreateEdfStatic
+ * \ingroup Tasks
+ */
+#if ( configUSE_EDF_SCHEDULING == 1 ) && ( configSUPPORT_STATIC_ALLOCATION == 1 )
+    BaseType_t xTaskCreateEdfStatic( TaskFunction_t pxTaskCode,
+                                     const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                     const uint32_t ulStackDepth,
+                                     void * const pvParameters,
+                                     const TaskEdfParameters_t * const pxEdfParameters,
+                                     StackType_t * const puxStackBuffer,
+                                     StaticTask_t * const pxTaskBuffer,
+                                     TaskHandle_t * const pxCreatedTask ) PRIVILEGED_FUNCTION;
+#endif
+
+/**
+ * task. h
+ * @code{c}
+ * BaseType_t xTaskEdfWaitForNextPeriod( void );
+ * @endcode
+ *
+ * configUSE_EDF_SCHEDULING must be defined as 1 in FreeRTOSConfig.h for this
+ * function to be available.
+ *
+ * Ends the current job of the calling EDF task and blocks until the release
+ * of the next one, one period after the release of the current one.  If that
+ * release has passed already the task stays ready with the deadline of the
+ * next job.
+ *
+ * @return pdTRUE if the job ended before its deadline, otherwise pdFALSE.
+ *
+ * \defgroup xTaskEdfWaitForNextPeriod xTaskEdfWaitForNextPeriod
+ * \ingroup TaskCtrl
+ */
+BaseType_t xTaskEdfWaitForNextPeriod( void ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * void vTaskEdfGetStats( TaskHandle_t xTask, TaskEdfStats_t * pxStats );
+ * @endcode
+ *
+ * configUSE_EDF_SCHEDULING must be defined as 1 in FreeRTOSConfig.h for this
+ * function to be available.
+ *
+ * Reads the job, deadline miss and budget overrun counts of an EDF task.
+ * Budgets are charged a tick at a time, to the job running when the tick
+ * interrupt occurs.
+ *
+ * @param xTask The task, NULL for the calling task.
+ *
+ * @param pxStats Filled with the counts.
+ *
+ * \defgroup vTaskEdfGetStats vTaskEdfGetStats
+ * \ingroup TaskCtrl
+ */
+void vTaskEdfGetStats( TaskHandle_t xTask,
+                       TaskEdfStats_t * pxStats ) PRIVILEGED_FUNCTION;
+
 /**
  * task. h
  * @code{c}
@@ -1088,6 +1267,51 @@ void vTaskGetInfo( TaskHandle_t xTask,
 void vTaskPrioritySet( TaskHandle_t xTask,
                        UBaseType_t uxNewPriority ) PRIVILEGED_FUNCTION;
 
+#if ( configNUMBER_OF_CORES > 1 )
+
+/**
+ * task. h
+ * @code{c}
+ * void vTaskCoreAffinitySet( const TaskHandle_t xTask, UBaseType_t uxCoreAffinityMask );
+ * @endcode
+ *
+ * Only available when configNUMBER_OF_CORES is greater than 1.
+ *
+ * Sets the cores a task may run on.  Bit n of uxCoreAffinityMask set allows
+ * core n, tskNO_AFFINITY allows all cores.  If the task is running on a core
+ * it is no longer allowed on, that core reschedules.
+ *
+ * @param xTask Handle of the task.  Passing a NULL handle sets the affinity of
+ * the calling task.
+ *
+ * @param uxCoreAffinityMask The cores the task may run on, at least one.
+ *
+ * \defgroup vTaskCoreAffinitySet vTaskCoreAffinitySet
+ * \ingroup TaskCtrl
+ */
+    void vTaskCoreAffinitySet( const TaskHandle_t xTask,
+                               UBaseType_t uxCoreAffinityMask ) PRIVILEGED_FUNCTION;
+
+/**
+ * task. h
+ * @code{c}
+ * UBaseType_t uxTaskCoreAffinityGet( const TaskHandle_t xTask );
+ * @endcode
+ *
+ * Only available when configNUMBER_OF_CORES is greater than 1.
+ *
+ * @param xTask Handle of the task.  Passing a NULL handle returns the affinity
+ * of the calling task.
+ *
+ * @return The core affinity mask of the task.
+ *
+ * \defgroup uxTaskCoreAffinityGet uxTaskCoreAffinityGet
+ * \ingroup TaskCtrl
+ */
+    UBaseType_t uxTaskCoreAffinityGet( const TaskHandle_t xTask ) PRIVILEGED_FUNCTION;
+
+#endif /* configNUMBER_OF_CORES */
+
 /**
  * task. h
  * @code{c}
@@ -1683,6 +1907,25 @@ configSTACK_DEPTH_TYPE uxTaskGetStackHighWaterMark2( TaskHandle_t xTask ) PRIVIL
                                         uint32_t * pulIdleTaskStackSize ); /*lint !e526 Symbol not defined as it is an application callback. */
 #endif
 
+#if ( ( configSUPPORT_STATIC_ALLOCATION == 1 ) && ( configNUMBER_OF_CORES > 1 ) )
+
+/**
+ * task.h
+ * @code{c}
+ * void vApplicationGetPassiveIdleTaskMemory( StaticTask_t ** ppxIdleTaskTCBBuffer, StackType_t ** ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize, BaseType_t xPassiveIdleTaskIndex )
+ * @endcode
+ *
+ * As vApplicationGetIdleTaskMemory(), for the idle tasks of the cores other
+ * than core 0.  It is called once for each of them.
+ *
+ * @param xPassiveIdleTaskIndex The index of the idle task, 0 for core 1.
+ */
+    void vApplicationGetPassiveIdleTaskMemory( StaticTask_t ** ppxIdleTaskTCBBuffer,
+                                               StackType_t ** ppxIdleTaskStackBuffer,
+                                               uint32_t * pulIdleTaskStackSize,
+                                               BaseType_t xPassiveIdleTaskIndex ); /*lint !e526 Symbol not defined as it is an application callback. */
+#endif
+
 /**
  * task.h
  * @code{c}
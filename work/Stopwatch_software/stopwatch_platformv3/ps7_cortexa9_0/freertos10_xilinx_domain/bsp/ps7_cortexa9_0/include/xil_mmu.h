@@ -61,6 +61,8 @@ extern "C" {
 
 /* Normal write back cacheable shareable */
 #define NORM_WB_CACHE 0x15DE6
+/* Normal non-cacheable is bufferable: the store buffer merges writes */
+#define NORM_WRITE_COMBINE NORM_NONCACHE
 
 /* shareability attribute */
 #define SHAREABLE (0x1 << 16)
@@ -73,6 +75,14 @@ extern "C" {
 *@endcond
 */
 
+/**
+ * Second level page tables available to Xil_MmuSetRegionAttributes, each
+ * maps one 1 MB section with 4 KB pages and takes 1 KB of memory.
+ */
+#ifndef XIL_MMU_NUM_PAGE_TABLES
+#define XIL_MMU_NUM_PAGE_TABLES	4U
+#endif
+
 /************************** Variable Definitions *****************************/
 
 /************************** Function Prototypes ******************************/
@@ -81,6 +91,9 @@ void Xil_SetTlbAttributes(INTPTR Addr, u32 attrib);
 void Xil_EnableMMU(void);
 void Xil_DisableMMU(void);
 void* Xil_MemMap(UINTPTR PhysAddr, size_t size, u32 flags);
+s32 Xil_MmuSetRegionAttributes(INTPTR Addr, u32 Size, u32 attrib);
+void Xil_MmuBeginUpdate(void);
+void Xil_MmuEndUpdate(void);
 
 #ifdef __cplusplus
 }
@@ -62,7 +62,17 @@
 
 #define configMESSAGE_BUFFER 0
 
+/* The static build, every kernel object in static storage and no heap
+(stopwatch_v3/src/static_alloc.h), is selected by building the BSP and the
+application with -DconfigSUPPORT_STATIC_ALLOCATION=1
+-DconfigSUPPORT_DYNAMIC_ALLOCATION=0, as make -C sim STATIC=1 does. */
+#ifndef configSUPPORT_STATIC_ALLOCATION
 #define configSUPPORT_STATIC_ALLOCATION 0
+#endif
+
+#ifndef configSUPPORT_DYNAMIC_ALLOCATION
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#endif
 
 #define configUSE_16_BIT_TICKS 0
 
@@ -80,6 +90,14 @@
 
 #define configTOTAL_HEAP_SIZE ( ( size_t ) ( 65536 ) )
 
+#define configUSE_FAST_HEAP 1
+
+#define configFAST_HEAP_SIZE ( ( size_t ) ( 65536 ) )
+
+#define configFAST_HEAP_SECTION ".ocm_heap"
+
+#define configFAST_HEAP_TASK_PRIORITY (configMAX_PRIORITIES - 4)
+
 #define configMAX_TASK_NAME_LEN 10
 
 #define configIDLE_SHOULD_YIELD 1
@@ -97,16 +115,51 @@
 #define configUSE_QUEUE_SETS 1
 
 #define configUSE_TASK_NOTIFICATIONS 1
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 2
 
 #define configCHECK_FOR_STACK_OVERFLOW 2
+/* Off by default: the guarded stacks need the separate stack heap and their own
+pool in OCM.  -DconfigUSE_STACK_GUARD_PAGES=1 turns them on with the pool below,
+see portStackGuard.c. */
+#ifndef configUSE_STACK_GUARD_PAGES
+#define configUSE_STACK_GUARD_PAGES 0
+#endif
+#ifndef configSTACK_GUARD_POOL_SIZE
+#define configSTACK_GUARD_POOL_SIZE 0x1C000
+#endif
+#define configSTACK_GUARD_SECTION ".ocm_stacks"
+#ifndef configSTACK_GUARD_PAGES
+#define configSTACK_GUARD_PAGES 1
+#endif
 
 #define configUSE_TASK_FPU_SUPPORT 2
+/* Off by default, see portmacro.h for the code that must not use the FPU with
+it. */
+#ifndef configUSE_LAZY_FPU_SWITCHING
+#define configUSE_LAZY_FPU_SWITCHING 0
+#endif
+#define configUSE_IRQ_STATS 0
+#define configNUM_FAST_INTERRUPTS 4
+#define configUSE_PMU_PROFILING 0
+#define configPMU_PROFILE_REGIONS 16
+#define configPMU_PROFILE_TASKS 16
+#define configUSE_SAMPLING_PROFILER 0
+#define configSAMPLING_PROFILER_HZ 997
+#define configSAMPLING_PROFILER_SAMPLES 4096
+#define configUSE_HR_TIMER 0
+#define configHR_TIMER_SPIN_US 10
+#define configNUMBER_OF_CORES 1
+#define configUSE_EDF_SCHEDULING 0
+#define configEDF_PRIORITY 2
+#define configEDF_UTILISATION_LIMIT 90
+#define configSMP_YIELD_SGI 2
 
 #define configQUEUE_REGISTRY_SIZE 10
 
-#define configUSE_STATS_FORMATTING_FUNCTIONS 1
+/* The formatting functions allocate their buffer */
+#define configUSE_STATS_FORMATTING_FUNCTIONS configSUPPORT_DYNAMIC_ALLOCATION
 
-#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 0
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 1
 
 #define configGENERATE_RUN_TIME_STATS 0
 
@@ -129,6 +182,7 @@
 #define INCLUDE_xTimerPendFunctionCall       1
 #define INCLUDE_pcTaskGetTaskName            1
 #define INCLUDE_xTaskGetHandle               1
+#define INCLUDE_xTaskAbortDelay              1
 #define portPOINTER_SIZE_TYPE	uint32_t
 #define portTICK_TYPE_IS_ATOMIC 1
 #define configMESSAGE_BUFFER_LENGTH_TYPE uint32_t
@@ -138,11 +192,14 @@
 #define configINTERRUPT_CONTROLLER_BASE_ADDRESS         ( XPAR_PS7_SCUGIC_0_DIST_BASEADDR )
 #define configINTERRUPT_CONTROLLER_CPU_INTERFACE_OFFSET ( -0xf00 )
 #define configUNIQUE_INTERRUPT_PRIORITIES                32
+/* Prototypes are hidden from the port assembly files that include this file. */
+#ifndef __ASSEMBLER__
 void vApplicationAssert( const char *pcFile, uint32_t ulLine );
 void FreeRTOS_SetupTickInterrupt( void );
+void FreeRTOS_ClearTickInterrupt( void );
+#endif
 #define configSETUP_TICK_INTERRUPT() FreeRTOS_SetupTickInterrupt()
 
-void FreeRTOS_ClearTickInterrupt( void );
 #define configCLEAR_TICK_INTERRUPT()	FreeRTOS_ClearTickInterrupt()
 
 #define portSET_INTERRUPT_MASK_FROM_ISR()	ulPortSetInterruptMask()
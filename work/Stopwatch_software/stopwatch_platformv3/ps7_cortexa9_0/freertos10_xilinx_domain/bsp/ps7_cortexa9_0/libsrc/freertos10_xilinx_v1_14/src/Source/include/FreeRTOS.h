@@ -151,6 +151,27 @@
     #error Missing definition:  configUSE_IDLE_HOOK must be defined in FreeRTOSConfig.h as either 1 or 0.  See the Configuration section of the FreeRTOS API documentation for details.
 #endif
 
+/* Called from the idle tasks of the cores other than core 0 when
+ * configNUMBER_OF_CORES is greater than 1. */
+#ifndef configUSE_PASSIVE_IDLE_HOOK
+    #define configUSE_PASSIVE_IDLE_HOOK    0
+#endif
+
+/* Earliest deadline first scheduling of the tasks created with
+ * xTaskCreateEdf(), which all run at configEDF_PRIORITY.  Admission control
+ * hands out at most configEDF_UTILISATION_LIMIT percent of the processor. */
+#ifndef configUSE_EDF_SCHEDULING
+    #define configUSE_EDF_SCHEDULING    0
+#endif
+
+#ifndef configEDF_PRIORITY
+    #define configEDF_PRIORITY    2
+#endif
+
+#ifndef configEDF_UTILISATION_LIMIT
+    #define configEDF_UTILISATION_LIMIT    100
+#endif
+
 #ifndef configUSE_TICK_HOOK
     #error Missing definition:  configUSE_TICK_HOOK must be defined in FreeRTOSConfig.h as either 1 or 0.  See the Configuration section of the FreeRTOS API documentation for details.
 #endif
@@ -1301,6 +1322,14 @@ typedef struct xSTATIC_TCB
     #if ( configUSE_POSIX_ERRNO == 1 )
         int iDummy22;
     #endif
+    #if ( configUSE_EDF_SCHEDULING == 1 )
+        TickType_t xDummy23[ 7 ];
+        uint32_t ulDummy24[ 4 ];
+    #endif
+    #if ( configNUMBER_OF_CORES > 1 )
+        BaseType_t xDummy25;
+        UBaseType_t uxDummy26;
+    #endif
 } StaticTask_t;
 
 /*
@@ -180,6 +180,44 @@ void vPortInitialiseBlocks( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetMinimumEverFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 
+#ifndef configUSE_FAST_HEAP
+    #define configUSE_FAST_HEAP    0
+#endif
+
+#if ( configUSE_FAST_HEAP == 1 )
+
+/* Pools managed by heap_6.c.  The fast pool lives in on-chip memory, the bulk
+ * pool in DDR. */
+    typedef enum
+    {
+        eHeapPoolFast = 0,
+        eHeapPoolBulk,
+        eHeapPoolCount
+    } eHeapPool;
+
+/*
+ * Placement hinted allocation.  pvPortMallocFast() falls back to the bulk pool
+ * when the fast pool is exhausted.  Memory from either function is released
+ * with vPortFree().
+ */
+    void * pvPortMallocFast( size_t xSize ) PRIVILEGED_FUNCTION;
+    void * pvPortMallocBulk( size_t xSize ) PRIVILEGED_FUNCTION;
+
+/*
+ * Same as vPortGetHeapStats(), but for a single pool.
+ */
+    void vPortGetHeapPoolStats( eHeapPool ePool,
+                                HeapStats_t * pxHeapStats ) PRIVILEGED_FUNCTION;
+
+/*
+ * Number of requests for ePool that were served from another pool.
+ */
+    size_t xPortGetHeapPoolFallbacks( eHeapPool ePool ) PRIVILEGED_FUNCTION;
+#else
+    #define pvPortMallocFast    pvPortMalloc
+    #define pvPortMallocBulk    pvPortMalloc
+#endif
+
 #if ( configSTACK_ALLOCATION_FROM_SEPARATE_HEAP == 1 )
     void * pvPortMallocStack( size_t xSize ) PRIVILEGED_FUNCTION;
     void vPortFreeStack( void * pv ) PRIVILEGED_FUNCTION;
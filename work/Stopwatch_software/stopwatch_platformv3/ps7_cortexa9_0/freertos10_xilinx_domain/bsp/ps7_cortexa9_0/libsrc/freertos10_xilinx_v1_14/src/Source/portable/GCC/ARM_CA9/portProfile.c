@@ -0,0 +1,384 @@
+/*
+ * FreeRTOS Kernel V10.5.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ * Copyright (C) 2009-2021 Xilinx, Inc. All rights reserved.
+ * Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * PMU based profiling of code regions and tasks (configUSE_PMU_PROFILING).
+ *
+ * The cycle counter and three PMU event counters (instructions, L1 data cache
+ * refills and branch mispredictions) run freely, and the two L2 cache
+ * controller event counters count data read requests and hits.  Each task owns
+ * a set of 64-bit "virtual" counters: the trace hooks add the hardware counter
+ * deltas to the outgoing task on every context switch, so a region only counts
+ * the events of the task that executed it, plus the interrupts taken meanwhile.
+ *
+ * The L2 counters are shared with CPU1 and the DMA masters, so L2 misses are
+ * only meaningful while nothing else is using the L2.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if( configUSE_PMU_PROFILING == 1 )
+
+/* Xilinx includes. */
+#include "xil_io.h"
+#include "xil_printf.h"
+#include "xl2cc.h"
+#include "xl2cc_counter.h"
+#include "xparameters_ps.h"
+#include "xpm_counter.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+
+/* The A9 does not implement the architectural "instruction executed" event,
+instructions leaving register renaming is the closest count. */
+#define portPMU_EVENT_INSTRUCTIONS		XPM_EVENT_INSTRRENAME
+#define portPMU_EVENT_L1D_MISSES		XPM_EVENT_DATA_CACHEREFILL
+#define portPMU_EVENT_BRANCH_MISSES		XPM_EVENT_BRANCHMISS
+
+#define portPMU_PMCR_ENABLE				0x1UL
+#define portPMU_CYCLE_COUNTER_ENABLE	0x80000000UL
+
+/* Reset both L2 event counters and keep them enabled.  The L2 counters
+saturate instead of wrapping, so they are restarted on every switch in. */
+#define portL2CC_EVENT_COUNTERS_RESTART	0x7UL
+
+typedef struct xPMU_PROFILE_TASK
+{
+	PMUProfile_t xProfile;
+	char pcName[ configMAX_TASK_NAME_LEN ];	/* Copied, the slot outlives deleted tasks */
+} PMUProfileTask_t;
+
+typedef struct xPMU_PROFILE_REGION
+{
+	PMUProfile_t xProfile;
+	const char *pcName;
+	uint64_t ullStart[ portPMU_NUM_EVENTS ];
+} PMUProfileRegion_t;
+
+static PMUProfileTask_t xProfileTasks[ configPMU_PROFILE_TASKS ];
+static UBaseType_t uxProfileTasksUsed = 0;
+static PMUProfileRegion_t xProfileRegions[ configPMU_PROFILE_REGIONS ];
+
+/* Collects the events of tasks created once xProfileTasks[] is full. */
+static PMUProfileTask_t xProfileUntracked = { .pcName = "(other)" };
+
+/* Task running now and the hardware counters when it was switched in. */
+static PMUProfileTask_t *pxProfileCurrent = &xProfileUntracked;
+static uint32_t ulProfileSwitchIn[ portPMU_NUM_EVENTS ];
+
+/* PMU event counter used for each event, cycles use the cycle counter. */
+static uint32_t ulProfileCounter[ portPMU_NUM_EVENTS ];
+static BaseType_t xProfileStarted = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static inline uint32_t prvProfileReadPMU( uint32_t ulCounter )
+{
+	mtcp( XREG_CP15_EVENT_CNTR_SEL, ulCounter );
+	isb();
+	return mfcp( XREG_CP15_PERF_MONITOR_COUNT );
+}
+/*-----------------------------------------------------------*/
+
+static void prvProfileReadCounters( uint32_t *pulCounters )
+{
+uint32_t ulRequests, ulHits;
+
+	pulCounters[ portPMU_CYCLES ] = mfcp( XREG_CP15_PERF_CYCLE_COUNTER );
+	pulCounters[ portPMU_INSTRUCTIONS ] = prvProfileReadPMU( ulProfileCounter[ portPMU_INSTRUCTIONS ] );
+	pulCounters[ portPMU_L1D_MISSES ] = prvProfileReadPMU( ulProfileCounter[ portPMU_L1D_MISSES ] );
+	pulCounters[ portPMU_BRANCH_MISSES ] = prvProfileReadPMU( ulProfileCounter[ portPMU_BRANCH_MISSES ] );
+
+	/* Counter 0 counts data read requests, counter 1 data read hits. */
+	ulRequests = Xil_In32( XPS_L2CC_BASEADDR + XPS_L2CC_EVNT_CNT0_VAL_OFFSET );
+	ulHits = Xil_In32( XPS_L2CC_BASEADDR + XPS_L2CC_EVNT_CNT1_VAL_OFFSET );
+	pulCounters[ portPMU_L2_MISSES ] = ulRequests - ulHits;
+}
+/*-----------------------------------------------------------*/
+
+/* Virtual counters of the running task, called with interrupts masked. */
+static void prvProfileReadTask( uint64_t *pullEvents )
+{
+uint32_t ulNow[ portPMU_NUM_EVENTS ];
+uint32_t ulEvent;
+
+	prvProfileReadCounters( ulNow );
+	for( ulEvent = 0; ulEvent < portPMU_NUM_EVENTS; ulEvent++ )
+	{
+		pullEvents[ ulEvent ] = pxProfileCurrent->xProfile.ullEvents[ ulEvent ] +
+								( uint32_t ) ( ulNow[ ulEvent ] - ulProfileSwitchIn[ ulEvent ] );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvProfileStart( void )
+{
+uint32_t ulEvent;
+
+	ulProfileCounter[ portPMU_INSTRUCTIONS ] = Xpm_SetUpAnEvent( portPMU_EVENT_INSTRUCTIONS );
+	ulProfileCounter[ portPMU_L1D_MISSES ] = Xpm_SetUpAnEvent( portPMU_EVENT_L1D_MISSES );
+	ulProfileCounter[ portPMU_BRANCH_MISSES ] = Xpm_SetUpAnEvent( portPMU_EVENT_BRANCH_MISSES );
+	for( ulEvent = portPMU_INSTRUCTIONS; ulEvent < portPMU_NUM_EVENTS; ulEvent++ )
+	{
+		configASSERT( ( ulEvent == portPMU_L2_MISSES ) || ( ulProfileCounter[ ulEvent ] != XPM_NO_COUNTERS_AVAILABLE ) );
+	}
+
+	mtcp( XREG_CP15_COUNT_ENABLE_SET, mfcp( XREG_CP15_COUNT_ENABLE_SET ) | portPMU_CYCLE_COUNTER_ENABLE );
+	mtcp( XREG_CP15_PERF_MONITOR_CTRL, mfcp( XREG_CP15_PERF_MONITOR_CTRL ) | portPMU_PMCR_ENABLE );
+	isb();
+
+	XL2cc_EventCtrInit( XL2CC_DRREQ, XL2CC_DRHIT );
+	XL2cc_EventCtrStart();
+
+	xProfileStarted = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortProfileTaskCreate( void *pvTCB, const char *pcName )
+{
+PMUProfileTask_t *pxTask = NULL;
+
+	/* The counters have to run before the first task is switched in. */
+	if( xProfileStarted == pdFALSE )
+	{
+		prvProfileStart();
+	}
+
+	if( uxProfileTasksUsed < configPMU_PROFILE_TASKS )
+	{
+		/* Slots are never reused, deleted tasks keep their statistics. */
+		pxTask = &( xProfileTasks[ uxProfileTasksUsed++ ] );
+		strncpy( pxTask->pcName, pcName, configMAX_TASK_NAME_LEN - 1 );
+	}
+
+	vTaskSetThreadLocalStoragePointer( ( TaskHandle_t ) pvTCB, portPMU_PROFILE_TLS_INDEX, pxTask );
+}
+/*-----------------------------------------------------------*/
+
+void vPortProfileSwitchOut( void )
+{
+uint32_t ulNow[ portPMU_NUM_EVENTS ];
+uint32_t ulEvent, ulDelta;
+PMUProfile_t *pxProfile = &( pxProfileCurrent->xProfile );
+
+	prvProfileReadCounters( ulNow );
+	for( ulEvent = 0; ulEvent < portPMU_NUM_EVENTS; ulEvent++ )
+	{
+		ulDelta = ulNow[ ulEvent ] - ulProfileSwitchIn[ ulEvent ];
+		pxProfile->ullEvents[ ulEvent ] += ulDelta;
+		if( ( ulEvent == portPMU_CYCLES ) && ( ulDelta > pxProfile->ulMaxCycles ) )
+		{
+			pxProfile->ulMaxCycles = ulDelta;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortProfileSwitchIn( void *pvProfile )
+{
+	pxProfileCurrent = ( pvProfile != NULL ) ? ( PMUProfileTask_t * ) pvProfile : &xProfileUntracked;
+	pxProfileCurrent->xProfile.ulCount++;
+
+	Xil_Out32( XPS_L2CC_BASEADDR + XPS_L2CC_EVNT_CNTRL_OFFSET, portL2CC_EVENT_COUNTERS_RESTART );
+	prvProfileReadCounters( ulProfileSwitchIn );
+	ulProfileSwitchIn[ portPMU_L2_MISSES ] = 0UL;
+}
+/*-----------------------------------------------------------*/
+
+void vPortProfileSetRegionName( uint32_t ulRegion, const char *pcName )
+{
+	configASSERT( ulRegion < configPMU_PROFILE_REGIONS );
+	xProfileRegions[ ulRegion ].pcName = pcName;
+}
+/*-----------------------------------------------------------*/
+
+void vPortProfileRegionBegin( uint32_t ulRegion )
+{
+uint32_t ulMask;
+
+	configASSERT( ulRegion < configPMU_PROFILE_REGIONS );
+
+	ulMask = portSET_INTERRUPT_MASK_FROM_ISR();
+	prvProfileReadTask( xProfileRegions[ ulRegion ].ullStart );
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( ulMask );
+}
+/*-----------------------------------------------------------*/
+
+void vPortProfileRegionEnd( uint32_t ulRegion )
+{
+uint64_t ullNow[ portPMU_NUM_EVENTS ];
+uint32_t ulMask, ulEvent, ulCycles;
+PMUProfileRegion_t *pxRegion;
+
+	configASSERT( ulRegion < configPMU_PROFILE_REGIONS );
+	pxRegion = &( xProfileRegions[ ulRegion ] );
+
+	ulMask = portSET_INTERRUPT_MASK_FROM_ISR();
+	prvProfileReadTask( ullNow );
+	for( ulEvent = 0; ulEvent < portPMU_NUM_EVENTS; ulEvent++ )
+	{
+		pxRegion->xProfile.ullEvents[ ulEvent ] += ullNow[ ulEvent ] - pxRegion->ullStart[ ulEvent ];
+	}
+	ulCycles = ( uint32_t ) ( ullNow[ portPMU_CYCLES ] - pxRegion->ullStart[ portPMU_CYCLES ] );
+	if( ulCycles > pxRegion->xProfile.ulMaxCycles )
+	{
+		pxRegion->xProfile.ulMaxCycles = ulCycles;
+	}
+	pxRegion->xProfile.ulCount++;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( ulMask );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortGetProfileRegion( uint32_t ulRegion, PMUProfile_t *pxProfile )
+{
+uint32_t ulMask;
+
+	if( ulRegion >= configPMU_PROFILE_REGIONS )
+	{
+		return pdFAIL;
+	}
+
+	ulMask = portSET_INTERRUPT_MASK_FROM_ISR();
+	*pxProfile = xProfileRegions[ ulRegion ].xProfile;
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( ulMask );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortGetProfileTask( UBaseType_t uxIndex, PMUProfile_t *pxProfile, const char **ppcName )
+{
+uint32_t ulMask;
+PMUProfileTask_t *pxTask;
+
+	if( uxIndex > uxProfileTasksUsed )
+	{
+		return pdFAIL;
+	}
+
+	/* The last index reports the tasks that did not get a slot. */
+	pxTask = ( uxIndex < uxProfileTasksUsed ) ? &( xProfileTasks[ uxIndex ] ) : &xProfileUntracked;
+
+	ulMask = portSET_INTERRUPT_MASK_FROM_ISR();
+	*pxProfile = pxTask->xProfile;
+	if( pxTask == pxProfileCurrent )
+	{
+		/* Include the time slice that is still running. */
+		prvProfileReadTask( pxProfile->ullEvents );
+	}
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( ulMask );
+
+	*ppcName = pxTask->pcName;
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vPortResetProfile( void )
+{
+uint32_t ulMask;
+UBaseType_t uxIndex;
+
+	ulMask = portSET_INTERRUPT_MASK_FROM_ISR();
+	for( uxIndex = 0; uxIndex < configPMU_PROFILE_REGIONS; uxIndex++ )
+	{
+		memset( &( xProfileRegions[ uxIndex ].xProfile ), 0, sizeof( PMUProfile_t ) );
+	}
+	for( uxIndex = 0; uxIndex < uxProfileTasksUsed; uxIndex++ )
+	{
+		memset( &( xProfileTasks[ uxIndex ].xProfile ), 0, sizeof( PMUProfile_t ) );
+	}
+	memset( &( xProfileUntracked.xProfile ), 0, sizeof( PMUProfile_t ) );
+
+	/* Restart the time slice of the running task. */
+	prvProfileReadCounters( ulProfileSwitchIn );
+	ulProfileSwitchIn[ portPMU_L2_MISSES ] = 0UL;
+	Xil_Out32( XPS_L2CC_BASEADDR + XPS_L2CC_EVNT_CNTRL_OFFSET, portL2CC_EVENT_COUNTERS_RESTART );
+	portCLEAR_INTERRUPT_MASK_FROM_ISR( ulMask );
+}
+/*-----------------------------------------------------------*/
+
+static void prvProfilePrintLine( const char *pcName, uint32_t ulIndex, const PMUProfile_t *pxProfile )
+{
+uint32_t ulCycles = ( uint32_t ) ( pxProfile->ullEvents[ portPMU_CYCLES ] / pxProfile->ulCount );
+uint32_t ulInstructions = ( uint32_t ) ( pxProfile->ullEvents[ portPMU_INSTRUCTIONS ] / pxProfile->ulCount );
+
+	if( pcName != NULL )
+	{
+		xil_printf( "%-16s", pcName );
+	}
+	else
+	{
+		xil_printf( "region %-9u", ulIndex );
+	}
+
+	/* IPC in hundredths, xil_printf() has no floating point. */
+	xil_printf( " %10u %10u %10u %10u %4u.%02u %10u %10u %10u\r\n", pxProfile->ulCount, ulCycles,
+				pxProfile->ulMaxCycles, ulInstructions,
+				( ulCycles != 0UL ) ? ( ulInstructions / ulCycles ) : 0UL,
+				( ulCycles != 0UL ) ? ( ( ulInstructions % ulCycles ) * 100UL / ulCycles ) : 0UL,
+				( uint32_t ) ( pxProfile->ullEvents[ portPMU_L1D_MISSES ] / pxProfile->ulCount ),
+				( uint32_t ) ( pxProfile->ullEvents[ portPMU_L2_MISSES ] / pxProfile->ulCount ),
+				( uint32_t ) ( pxProfile->ullEvents[ portPMU_BRANCH_MISSES ] / pxProfile->ulCount ) );
+}
+/*-----------------------------------------------------------*/
+
+void vPortPrintProfile( void )
+{
+PMUProfile_t xProfile;
+const char *pcName;
+uint32_t ulIndex;
+
+	xil_printf( "Region/task      count      avg(cyc)   max(cyc)   avg(instr) IPC     avg(L1D)   avg(L2)    avg(brmiss)\r\n" );
+	for( ulIndex = 0; ulIndex < configPMU_PROFILE_REGIONS; ulIndex++ )
+	{
+		( void ) xPortGetProfileRegion( ulIndex, &xProfile );
+		if( xProfile.ulCount != 0UL )
+		{
+			prvProfilePrintLine( xProfileRegions[ ulIndex ].pcName, ulIndex, &xProfile );
+		}
+	}
+
+	/* Per task figures are per time slice. */
+	for( ulIndex = 0; xPortGetProfileTask( ulIndex, &xProfile, &pcName ) == pdPASS; ulIndex++ )
+	{
+		if( xProfile.ulCount != 0UL )
+		{
+			prvProfilePrintLine( pcName, ulIndex, &xProfile );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_PMU_PROFILING */
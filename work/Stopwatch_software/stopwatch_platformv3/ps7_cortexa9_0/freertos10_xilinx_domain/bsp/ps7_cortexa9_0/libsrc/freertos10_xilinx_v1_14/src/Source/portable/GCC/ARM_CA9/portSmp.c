@@ -0,0 +1,286 @@
+/*
+ * FreeRTOS Kernel V10.5.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ * Copyright (C) 2009-2021 Xilinx, Inc. All rights reserved.
+ * Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * Symmetric multiprocessing on both Cortex-A9 cores (configNUMBER_OF_CORES 2).
+ *
+ * tasks.c serialises the kernel with two recursive spin locks.  The task lock
+ * is held while a task has the scheduler suspended and by the core switching
+ * context, the ISR lock in critical sections and by the FromISR API.  A lock
+ * remembers the core owning it, so the same core can take it again, and is
+ * only released when it has been given back as many times as it was taken.
+ * Waiting cores sleep in WFE until the owner releases it with SEV.
+ *
+ * A core makes the other one reschedule with configSMP_YIELD_SGI, whose
+ * handler just pends a context switch on the way out of the interrupt.
+ *
+ * CPU1 is held in the boot ROM's WFE loop until the scheduler starts.  CPU0
+ * then writes the address of vPortSecondaryEntry (portASM.S) to the boot
+ * ROM's jump location.  CPU1 enables its MMU with CPU0's translation table,
+ * its caches and the VFP, takes the exception stacks below and continues in
+ * vPortSecondaryStart(), which enables its GIC CPU interface and starts the
+ * task vTaskStartScheduler() selected for it.  All peripheral interrupts stay
+ * routed to CPU0, CPU1 only takes the yield SGI.
+ */
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if( configNUMBER_OF_CORES > 1 )
+
+/* Xilinx includes. */
+#include "xil_io.h"
+#include "xil_cache.h"
+#include "xscugic.h"
+
+/* Word the boot ROM's WFE loop on CPU1 jumps through when it is not 0. */
+#define portSMP_CPU1_START_ADDRESS		0xFFFFFFF0UL
+
+/* GIC CPU interface control: enable secure and non-secure interrupts, and let
+secure reads of ICCIAR acknowledge non-secure ones, as XScuGic does for CPU0. */
+#define portSMP_GIC_CPU_ENABLE			0x07UL
+
+/* Exception stacks of CPU1, the same sizes as CPU0's in lscript.ld. */
+#define portSMP_IRQ_STACK_SIZE			1024
+#define portSMP_SVC_STACK_SIZE			2048
+#define portSMP_ABT_STACK_SIZE			1024
+#define portSMP_UND_STACK_SIZE			1024
+
+typedef struct xSMP_LOCK
+{
+	volatile uint32_t ulOwner;	/* Core ID + 1, 0 when free. */
+	uint32_t ulCount;			/* Only changed by the owner. */
+} SMPLock_t;
+
+/* Entry point of CPU1, in portASM.S. */
+extern void vPortSecondaryEntry( void );
+
+/* Starts the task selected for the core, in portASM.S. */
+extern void vPortRestoreTaskContext( void );
+
+extern XScuGic xInterruptController;
+extern volatile uint32_t ulPortYieldRequired[ configNUMBER_OF_CORES ];
+
+void vPortSecondaryStart( void );
+
+static SMPLock_t xTaskLock = { 0UL, 0UL };
+static SMPLock_t xISRLock = { 0UL, 0UL };
+
+static uint64_t ullIRQStack[ portSMP_IRQ_STACK_SIZE / sizeof( uint64_t ) ];
+static uint64_t ullSVCStack[ portSMP_SVC_STACK_SIZE / sizeof( uint64_t ) ];
+static uint64_t ullABTStack[ portSMP_ABT_STACK_SIZE / sizeof( uint64_t ) ];
+static uint64_t ullUNDStack[ portSMP_UND_STACK_SIZE / sizeof( uint64_t ) ];
+
+/* Read by vPortSecondaryEntry before CPU1 has its caches enabled. */
+__attribute__(( used )) uint32_t ulPortSecondaryTTBR0 = 0UL;
+__attribute__(( used )) void * const pvPortSecondaryStacks[ 4 ] =
+{
+	&( ullIRQStack[ portSMP_IRQ_STACK_SIZE / sizeof( uint64_t ) ] ),
+	&( ullABTStack[ portSMP_ABT_STACK_SIZE / sizeof( uint64_t ) ] ),
+	&( ullUNDStack[ portSMP_UND_STACK_SIZE / sizeof( uint64_t ) ] ),
+	&( ullSVCStack[ portSMP_SVC_STACK_SIZE / sizeof( uint64_t ) ] )
+};
+
+/* Set by CPU1 once it no longer needs anything from CPU0. */
+static volatile BaseType_t xSecondaryStarted = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static void prvLockGet( SMPLock_t *pxLock )
+{
+const uint32_t ulOwner = ( uint32_t ) portGET_CORE_ID() + 1UL;
+uint32_t ulValue, ulFailed;
+
+	/* Only this core can have written its own ID, so the test needs no
+	exclusive access. */
+	if( pxLock->ulOwner == ulOwner )
+	{
+		pxLock->ulCount++;
+		return;
+	}
+
+	for( ;; )
+	{
+		__asm volatile ( "LDREX	%0, [%1]" : "=r" ( ulValue ) : "r" ( &( pxLock->ulOwner ) ) : "memory" );
+		if( ulValue != 0UL )
+		{
+			/* Held by the other core, sleep until it releases a lock. */
+			__asm volatile ( "CLREX		\n"
+							 "WFE		\n" ::: "memory" );
+			continue;
+		}
+
+		__asm volatile ( "STREX	%0, %2, [%1]" : "=&r" ( ulFailed ) : "r" ( &( pxLock->ulOwner ) ), "r" ( ulOwner ) : "memory" );
+		if( ulFailed == 0UL )
+		{
+			break;
+		}
+	}
+
+	/* Nothing protected by the lock may be read before it is owned. */
+	__asm volatile ( "DMB" ::: "memory" );
+	pxLock->ulCount = 1UL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvLockRelease( SMPLock_t *pxLock )
+{
+	configASSERT( pxLock->ulOwner == ( uint32_t ) portGET_CORE_ID() + 1UL );
+
+	if( --( pxLock->ulCount ) == 0UL )
+	{
+		/* Everything written under the lock must be visible before it is
+		free, and the store must have completed before the waiter is woken. */
+		__asm volatile ( "DMB" ::: "memory" );
+		pxLock->ulOwner = 0UL;
+		__asm volatile ( "DSB		\n"
+						 "SEV		\n" ::: "memory" );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetTaskLock( void )
+{
+	prvLockGet( &xTaskLock );
+}
+/*-----------------------------------------------------------*/
+
+void vPortReleaseTaskLock( void )
+{
+	prvLockRelease( &xTaskLock );
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetISRLock( void )
+{
+	prvLockGet( &xISRLock );
+}
+/*-----------------------------------------------------------*/
+
+void vPortReleaseISRLock( void )
+{
+	prvLockRelease( &xISRLock );
+}
+/*-----------------------------------------------------------*/
+
+/* Only used for the other core, tasks.c defers a yield of the calling core to
+the end of its critical section or interrupt. */
+void vPortYieldCore( BaseType_t xCoreID )
+{
+	configASSERT( ( xCoreID >= 0 ) && ( xCoreID < configNUMBER_OF_CORES ) && ( xCoreID != portGET_CORE_ID() ) );
+
+	XScuGic_SoftwareIntr( &xInterruptController, configSMP_YIELD_SGI, 1UL << xCoreID );
+}
+/*-----------------------------------------------------------*/
+
+/* tasks.c has already set the core's yield pending flag, only the context
+switch on the way out of the interrupt is left to request. */
+static void prvYieldHandler( uint32_t ulICCIAR )
+{
+	( void ) ulICCIAR;
+	ulPortYieldRequired[ portGET_CORE_ID() ] = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+#if( configNUM_FAST_INTERRUPTS == 0 )
+	static void prvYieldGenericHandler( void *pvCallBackRef )
+	{
+		( void ) pvCallBackRef;
+		prvYieldHandler( configSMP_YIELD_SGI );
+	}
+#endif
+/*-----------------------------------------------------------*/
+
+/* SGI priorities are banked, so each core sets its own. */
+static void prvYieldInterruptEnable( void )
+{
+uint8_t ucPriority, ucTrigger;
+
+	XScuGic_GetPriorityTriggerType( &xInterruptController, configSMP_YIELD_SGI, &ucPriority, &ucTrigger );
+	XScuGic_SetPriorityTriggerType( &xInterruptController, configSMP_YIELD_SGI, portLOWEST_USABLE_INTERRUPT_PRIORITY << portPRIORITY_SHIFT, ucTrigger );
+	vPortEnableInterrupt( configSMP_YIELD_SGI );
+}
+/*-----------------------------------------------------------*/
+
+void vPortStartSecondaryCores( void )
+{
+BaseType_t xStatus;
+
+	/* Called by xPortStartScheduler() with IRQs disabled, the yield
+	interrupt is only taken once the first task runs. */
+	#if( configNUM_FAST_INTERRUPTS > 0 )
+		xStatus = xPortInstallFastInterruptHandler( configSMP_YIELD_SGI, prvYieldHandler, portLOWEST_USABLE_INTERRUPT_PRIORITY );
+	#else
+		xStatus = xPortInstallInterruptHandler( configSMP_YIELD_SGI, prvYieldGenericHandler, NULL );
+	#endif
+	configASSERT( xStatus == pdPASS );
+	( void ) xStatus; /* Remove compiler warning if configASSERT() is not defined. */
+	prvYieldInterruptEnable();
+
+	/* CPU1 starts with its MMU and caches off, so everything it reads before
+	enabling them (this, the stack table, the translation table, the kernel
+	state) must be in memory. */
+	__asm volatile ( "MRC p15, 0, %0, c2, c0, 0" : "=r" ( ulPortSecondaryTTBR0 ) );
+	Xil_DCacheFlush();
+
+	Xil_Out32( portSMP_CPU1_START_ADDRESS, ( uint32_t ) vPortSecondaryEntry );
+	Xil_DCacheFlushRange( portSMP_CPU1_START_ADDRESS, sizeof( uint32_t ) );
+	__asm volatile ( "DSB		\n"
+					 "SEV		\n" ::: "memory" );
+
+	/* Kernel state changed before CPU1 runs its first task could go
+	unnoticed, wait for it. */
+	while( xSecondaryStarted == pdFALSE )
+	{
+		__asm volatile ( "WFE" ::: "memory" );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Called by vPortSecondaryEntry on CPU1, in SVC mode with IRQs disabled and
+the MMU, caches and VFP enabled. */
+void vPortSecondaryStart( void )
+{
+	/* The distributor is shared and already initialised by CPU0, only the
+	banked CPU interface and SGI settings are CPU1's own.  The priority mask is
+	set by vPortRestoreTaskContext. */
+	Xil_Out32( portINTERRUPT_CONTROLLER_CPU_INTERFACE_ADDRESS + portICCBPR_BINARY_POINT_OFFSET, 0UL );
+	Xil_Out32( portINTERRUPT_CONTROLLER_CPU_INTERFACE_ADDRESS + XSCUGIC_CONTROL_OFFSET, portSMP_GIC_CPU_ENABLE );
+	prvYieldInterruptEnable();
+
+	xSecondaryStarted = pdTRUE;
+	__asm volatile ( "DSB		\n"
+					 "SEV		\n" ::: "memory" );
+
+	vPortRestoreTaskContext();
+}
+
+#endif /* configNUMBER_OF_CORES */
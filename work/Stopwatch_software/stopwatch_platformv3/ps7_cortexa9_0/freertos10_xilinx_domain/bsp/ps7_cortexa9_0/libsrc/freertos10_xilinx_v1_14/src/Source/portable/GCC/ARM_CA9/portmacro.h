@@ -69,20 +69,51 @@ typedef uint32_t TickType_t;
 #define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
 #define portBYTE_ALIGNMENT			8
 
+/* Cores the scheduler runs tasks on, see the SMP section below. */
+#ifndef configNUMBER_OF_CORES
+	#define configNUMBER_OF_CORES 1
+#endif
+
+#if( configNUMBER_OF_CORES > 1 )
+	/* The CPU ID field of MPIDR, 0 or 1. */
+	static inline BaseType_t xPortGetCoreID( void )
+	{
+	uint32_t ulMPIDR;
+
+		__asm volatile ( "MRC p15, 0, %0, c0, c0, 5" : "=r" ( ulMPIDR ) );
+		return ( BaseType_t ) ( ulMPIDR & 3UL );
+	}
+	#define portGET_CORE_ID()		xPortGetCoreID()
+#else
+	#define portGET_CORE_ID()		( ( BaseType_t ) 0 )
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* Task utilities. */
 
 /* Called at the end of an ISR that can cause a context switch. */
-#define portEND_SWITCHING_ISR( xSwitchRequired )\
-{												\
-extern uint32_t ulPortYieldRequired;			\
-												\
-	if( xSwitchRequired != pdFALSE )			\
-	{											\
-		ulPortYieldRequired = pdTRUE;			\
-	}											\
-}
+#if( configNUMBER_OF_CORES > 1 )
+	#define portEND_SWITCHING_ISR( xSwitchRequired )\
+	{												\
+	extern uint32_t ulPortYieldRequired[];			\
+													\
+		if( xSwitchRequired != pdFALSE )			\
+		{											\
+			ulPortYieldRequired[ portGET_CORE_ID() ] = pdTRUE;\
+		}											\
+	}
+#else
+	#define portEND_SWITCHING_ISR( xSwitchRequired )\
+	{												\
+	extern uint32_t ulPortYieldRequired;			\
+													\
+		if( xSwitchRequired != pdFALSE )			\
+		{											\
+			ulPortYieldRequired = pdTRUE;			\
+		}											\
+	}
+#endif
 
 #define portYIELD_FROM_ISR( x ) portEND_SWITCHING_ISR( x )
 #define portYIELD() __asm volatile ( "SWI 0" ::: "memory" );
@@ -100,8 +131,16 @@ extern void vPortInstallFreeRTOSVectorTable( void );
 
 /* These macros do not globally disable/enable interrupts.  They do mask off
 interrupts that have a priority below configMAX_API_CALL_INTERRUPT_PRIORITY. */
-#define portENTER_CRITICAL()		vPortEnterCritical();
-#define portEXIT_CRITICAL()			vPortExitCritical();
+#if( configNUMBER_OF_CORES > 1 )
+	/* Take the SMP locks as well, see tasks.c. */
+	extern void vTaskEnterCritical( void );
+	extern void vTaskExitCritical( void );
+	#define portENTER_CRITICAL()		vTaskEnterCritical();
+	#define portEXIT_CRITICAL()			vTaskExitCritical();
+#else
+	#define portENTER_CRITICAL()		vPortEnterCritical();
+	#define portEXIT_CRITICAL()			vPortExitCritical();
+#endif
 #define portDISABLE_INTERRUPTS()	ulPortSetInterruptMask()
 #define portENABLE_INTERRUPTS()		vPortClearInterruptMask( 0 )
 
@@ -144,6 +183,34 @@ void FreeRTOS_Tick_Handler( void );
  */
 BaseType_t xPortInstallInterruptHandler( uint8_t ucInterruptID, XInterruptHandler pxHandler, void *pvCallBackRef );
 
+/* Number of hot interrupts that can be installed with
+xPortInstallFastInterruptHandler().  0 removes the fast path altogether. */
+#ifndef configNUM_FAST_INTERRUPTS
+	#define configNUM_FAST_INTERRUPTS 0
+#endif
+
+#if( configNUM_FAST_INTERRUPTS > 0 )
+	/*
+	 * Installs pxHandler as the dedicated handler for ucInterruptID.
+	 * FreeRTOS_IRQ_Handler calls it directly, bypassing
+	 * vApplicationIRQHandler(), the XScuGic handler table and the generic
+	 * driver interrupt handlers, so pxHandler must acknowledge the peripheral
+	 * itself.  It receives the ICCIAR value and can use the FromISR API.
+	 * Fast interrupts are not counted by configUSE_IRQ_STATS, which is why the
+	 * tick stays on the regular dispatch.
+	 *
+	 * ucPriority is the GIC priority given to the interrupt, in the same units
+	 * as configMAX_API_CALL_INTERRUPT_PRIORITY and not above it (numerically
+	 * lower).  portFAST_INTERRUPT_PRIORITY is the highest allowed.
+	 *
+	 * pdPASS is returned if the handler was installed, pdFAIL if all
+	 * configNUM_FAST_INTERRUPTS slots are in use.
+	 */
+	typedef void ( *PortFastInterruptHandler_t )( uint32_t ulICCIAR );
+	BaseType_t xPortInstallFastInterruptHandler( uint8_t ucInterruptID, PortFastInterruptHandler_t pxHandler, uint8_t ucPriority );
+	#define portFAST_INTERRUPT_PRIORITY		configMAX_API_CALL_INTERRUPT_PRIORITY
+#endif
+
 /*
  * Enables the interrupt, within the interrupt controller, for the peripheral
  * specified by the ucInterruptID parameter.
@@ -182,6 +249,351 @@ by default. */
 #endif
 #define portTASK_USES_FLOATING_POINT() vPortTaskUsesFPU()
 
+/* If configUSE_LAZY_FPU_SWITCHING is set to 1 the FPU registers are not saved
+and restored on every context switch.  The VFP is disabled when switching to a
+task that does not own the current register contents, and the first floating
+point instruction executed by that task traps to the undefined instruction
+handler, which saves the registers of the previous owner and loads those of the
+current task.  Tasks that never use the FPU never pay for it.  Interrupt
+handlers run with the FPU enabled but, as without lazy switching, must save the
+registers they use (vApplicationFPUSafeIRQHandler()).  Requires
+configUSE_TASK_FPU_SUPPORT to be 2.
+
+The context switch itself, vTaskSwitchContext() called from
+FreeRTOS_SWI_Handler or at the end of FreeRTOS_IRQ_Handler, runs in SVC mode
+with the FPEXC of the task switched out, and the trap only loads registers for
+a task in system mode: a VFP instruction there halts in FreeRTOS_Undefined when
+the FPU is disabled, and overwrites the owner's registers when it is not.  So
+vTaskSwitchContext() and everything it calls, the trace macros, the run time
+counter and vApplicationStackOverflowHook(), must not use the FPU.  With
+-mfpu=vfpv3 GCC only emits VFP instructions for floating point code. */
+#ifndef configUSE_LAZY_FPU_SWITCHING
+	#define configUSE_LAZY_FPU_SWITCHING 0
+#endif
+
+#if( configUSE_LAZY_FPU_SWITCHING == 1 )
+	/* The FPU owner must be forgotten when it is deleted, as its registers
+	would otherwise be saved into freed memory. */
+	void vPortCleanUpTaskFPU( void *pvTCB );
+	#define portCLEAN_UP_TCB( pxTCB ) vPortCleanUpTaskFPU( ( void * ) ( pxTCB ) )
+
+	/* Number of times the FPU registers were switched between tasks. */
+	uint32_t ulPortGetLazyFPUSwitchCount( void );
+#endif
+
+/* If configUSE_IRQ_STATS is set to 1 vApplicationIRQHandler() timestamps the
+entry and exit of every interrupt handler with the global timer and keeps, per
+interrupt ID, the number of calls, the longest and total handler time and log2
+histograms of the handler time and of the interrupt nesting depth.  Handler
+times exclude the time spent in nested interrupts and are in global timer ticks
+(half the CPU clock).  Interrupts installed with
+xPortInstallFastInterruptHandler() bypass vApplicationIRQHandler() and are not
+counted. */
+#ifndef configUSE_IRQ_STATS
+	#define configUSE_IRQ_STATS 0
+#endif
+
+#if( configUSE_IRQ_STATS == 1 )
+	/* Bucket n counts handler times in [ 2^n, 2^(n+1) ) ticks, the last bucket
+	also counts everything longer. */
+	#define portIRQ_STATS_DURATION_BUCKETS	20
+	/* Bucket n counts entries at nesting depth n + 1. */
+	#define portIRQ_STATS_NESTING_BUCKETS	4
+
+	typedef struct xIRQ_STATS
+	{
+		uint32_t ulCount;
+		uint32_t ulMaxTicks;
+		uint64_t ullTotalTicks;
+		uint32_t ulDurationHistogram[ portIRQ_STATS_DURATION_BUCKETS ];
+		uint32_t ulNestingHistogram[ portIRQ_STATS_NESTING_BUCKETS ];
+	} IRQStats_t;
+
+	/* Copies the statistics of ulInterruptID, returns pdFAIL for an invalid
+	ID. */
+	BaseType_t xPortGetIRQStats( uint32_t ulInterruptID, IRQStats_t *pxStats );
+	void vPortResetIRQStats( void );
+
+	/* Prints a line per interrupt ID that was taken at least once. */
+	void vPortPrintIRQStats( void );
+#endif
+
+/* If configUSE_PMU_PROFILING is set to 1 portProfile.c keeps cycles,
+instructions, L1 data cache misses, L2 data read misses and branch
+mispredictions per task, switching the PMU counts in and out on every context
+switch, and per code region between vPortProfileRegionBegin() and
+vPortProfileRegionEnd().  Regions are measured on the virtual counters of the
+calling task, so time spent in other tasks is not counted.  The task profile
+pointer lives in the last thread local storage pointer. */
+#ifndef configUSE_PMU_PROFILING
+	#define configUSE_PMU_PROFILING 0
+#endif
+
+#if( configUSE_PMU_PROFILING == 1 )
+	#ifndef configPMU_PROFILE_REGIONS
+		#define configPMU_PROFILE_REGIONS	16
+	#endif
+	#ifndef configPMU_PROFILE_TASKS
+		#define configPMU_PROFILE_TASKS		16
+	#endif
+
+	#if( configNUM_THREAD_LOCAL_STORAGE_POINTERS < 1 )
+		#error configUSE_PMU_PROFILING needs configNUM_THREAD_LOCAL_STORAGE_POINTERS of at least 1
+	#endif
+	#define portPMU_PROFILE_TLS_INDEX	( configNUM_THREAD_LOCAL_STORAGE_POINTERS - 1 )
+
+	#define portPMU_CYCLES			0
+	#define portPMU_INSTRUCTIONS	1
+	#define portPMU_L1D_MISSES		2
+	#define portPMU_L2_MISSES		3
+	#define portPMU_BRANCH_MISSES	4
+	#define portPMU_NUM_EVENTS		5
+
+	typedef struct xPMU_PROFILE
+	{
+		uint32_t ulCount;		/* Completed regions, or time slices of a task. */
+		uint32_t ulMaxCycles;	/* Longest region or time slice. */
+		uint64_t ullEvents[ portPMU_NUM_EVENTS ];
+	} PMUProfile_t;
+
+	void vPortProfileSetRegionName( uint32_t ulRegion, const char *pcName );
+	void vPortProfileRegionBegin( uint32_t ulRegion );
+	void vPortProfileRegionEnd( uint32_t ulRegion );
+
+	/* Copy the aggregates of a region, or of the task slot uxIndex (the slot
+	after the last task collects the tasks that did not get one).  Both return
+	pdFAIL for an index out of range. */
+	BaseType_t xPortGetProfileRegion( uint32_t ulRegion, PMUProfile_t *pxProfile );
+	BaseType_t xPortGetProfileTask( UBaseType_t uxIndex, PMUProfile_t *pxProfile, const char **ppcName );
+	void vPortResetProfile( void );
+
+	/* Prints per region and per time slice averages. */
+	void vPortPrintProfile( void );
+
+	/* Kernel trace hooks, expanded inside tasks.c. */
+	void vPortProfileTaskCreate( void *pvTCB, const char *pcName );
+	void vPortProfileSwitchOut( void );
+	void vPortProfileSwitchIn( void *pvProfile );
+
+	#if defined( traceTASK_SWITCHED_IN ) || defined( traceTASK_SWITCHED_OUT ) || defined( traceTASK_CREATE )
+		#error configUSE_PMU_PROFILING cannot be combined with other task trace hooks
+	#endif
+	#define traceTASK_CREATE( pxNewTCB )	vPortProfileTaskCreate( ( pxNewTCB ), ( pxNewTCB )->pcTaskName )
+	#define traceTASK_SWITCHED_OUT()		vPortProfileSwitchOut()
+	#define traceTASK_SWITCHED_IN()			vPortProfileSwitchIn( pxCurrentTCB->pvThreadLocalStoragePointers[ portPMU_PROFILE_TLS_INDEX ] )
+#endif
+
+/* If configUSE_SAMPLING_PROFILER is set to 1 portSampler.c samples the
+interrupted PC and the running task configSAMPLING_PROFILER_HZ times a second
+from the SCU private watchdog, used as a timer, into a ring of
+configSAMPLING_PROFILER_SAMPLES samples (8 bytes each). */
+#ifndef configUSE_SAMPLING_PROFILER
+	#define configUSE_SAMPLING_PROFILER 0
+#endif
+
+#if( configUSE_SAMPLING_PROFILER == 1 )
+	#ifndef configSAMPLING_PROFILER_HZ
+		/* Not a multiple of the tick rate, so periodic tasks do not alias. */
+		#define configSAMPLING_PROFILER_HZ		997
+	#endif
+	#ifndef configSAMPLING_PROFILER_SAMPLES
+		#define configSAMPLING_PROFILER_SAMPLES	4096
+	#endif
+	#ifndef configSAMPLING_PROFILER_TASKS
+		/* Tasks named in a dump, with more the tasks show as addresses. */
+		#define configSAMPLING_PROFILER_TASKS	32
+	#endif
+
+	BaseType_t xPortSamplerStart( void );
+	void vPortSamplerStop( void );
+
+	/* Samples taken since the last dump, including those overwritten. */
+	uint32_t ulPortSamplerGetCount( void );
+
+	/* Prints the samples as "S <task> <pc> <count>" lines between a header and
+	END, for tools/sample_flamegraph.py, then starts a new collection.  Must be
+	called from a task, it blocks to let the console drain. */
+	void vPortSamplerDump( void );
+#endif
+
+/* If configUSE_HR_TIMER is set to 1 portHrTimer.c provides delays and
+notification timeouts in microseconds.  Their deadlines are kept in a list
+sorted by deadline and the comparator of the global timer wakes the tasks, the
+tick timeout is only a fallback.  Delays shorter than configHR_TIMER_SPIN_US
+are spun.  Needs INCLUDE_xTaskAbortDelay. */
+#ifndef configUSE_HR_TIMER
+	#define configUSE_HR_TIMER 0
+#endif
+
+#if( configUSE_HR_TIMER == 1 )
+	#ifndef configHR_TIMER_SPIN_US
+		#define configHR_TIMER_SPIN_US	10
+	#endif
+
+	typedef struct xHR_TIMER_STATS
+	{
+		uint32_t ulBlocked;			/* Waits that blocked. */
+		uint32_t ulSpun;			/* Delays too short to block. */
+		uint32_t ulInterrupts;		/* Comparator interrupts. */
+		uint32_t ulRetries;			/* Deadlines that expired before their task blocked. */
+		uint32_t ulMaxLateCounts;	/* Worst wake up after a deadline, in global timer counts. */
+	} HRTimerStats_t;
+
+	/* Blocks the calling task for at least ulMicroseconds.  Spins, without
+	blocking, for short delays and before the scheduler has started. */
+	void vTaskDelayUs( uint32_t ulMicroseconds );
+
+	/* xTaskNotifyWait() with its timeout given in microseconds. */
+	BaseType_t xTaskNotifyWaitUs( uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, uint32_t ulTimeoutUs );
+
+	void vPortGetHrTimerStats( HRTimerStats_t *pxStats );
+#endif
+
+/* If configUSE_STACK_GUARD_PAGES is set to 1 portStackGuard.c allocates the
+task stacks from configSTACK_GUARD_POOL_SIZE bytes mapped with 4 KB pages, each
+stack directly above configSTACK_GUARD_PAGES pages mapped as translation
+faults.  An overflow takes a data abort on the guard and
+vApplicationStackOverflowHook() is called with the running task, also for an
+overflow that the configCHECK_FOR_STACK_OVERFLOW pattern would miss.  Each
+stack takes whole pages plus its guard, stacks that do not fit in the pool come
+from the heap unguarded.  Static stacks get a guard too, see pxPortStaticStack()
+below.  A frame larger than the guard can step over it unnoticed, so
+configSTACK_GUARD_PAGES * 4 KB must exceed the largest function frame on a task
+stack. */
+#ifndef configUSE_STACK_GUARD_PAGES
+	#define configUSE_STACK_GUARD_PAGES 0
+#endif
+
+#if( configUSE_STACK_GUARD_PAGES == 1 )
+	#ifndef configSTACK_GUARD_POOL_SIZE
+		#define configSTACK_GUARD_POOL_SIZE		0x10000
+	#endif
+	#ifndef configSTACK_GUARD_SECTION
+		#define configSTACK_GUARD_SECTION		".ocm_stacks"
+	#endif
+	#ifndef configSTACK_GUARD_PAGES
+		/* Pages without access under each stack. */
+		#define configSTACK_GUARD_PAGES			1
+	#endif
+	#if( configSTACK_GUARD_PAGES < 1 )
+		#error configSTACK_GUARD_PAGES must be at least 1
+	#endif
+	#ifndef configSTACK_GUARD_STATIC_STACKS
+		/* Static stacks that can be given a guard. */
+		#define configSTACK_GUARD_STATIC_STACKS	16
+	#endif
+
+	/* The kernel takes the stacks from pvPortMallocStack(). */
+	#ifndef configSTACK_ALLOCATION_FROM_SEPARATE_HEAP
+		#define configSTACK_ALLOCATION_FROM_SEPARATE_HEAP 1
+	#endif
+	#if( configSTACK_ALLOCATION_FROM_SEPARATE_HEAP != 1 )
+		#error configUSE_STACK_GUARD_PAGES needs configSTACK_ALLOCATION_FROM_SEPARATE_HEAP set to 1
+	#endif
+
+	typedef struct xSTACK_GUARD_STATS
+	{
+		uint32_t ulGuardedStacks;	/* Stacks with a guard now, from the pool or static. */
+		uint32_t ulUnguardedStacks;	/* Stacks that did not fit in the pool, or static stacks beyond configSTACK_GUARD_STATIC_STACKS. */
+		uint32_t ulPagesCarved;		/* Pool pages given to stacks and guards. */
+		uint32_t ulPagesFree;		/* Pool pages never used. */
+	} StackGuardStats_t;
+
+	void vPortGetStackGuardStats( StackGuardStats_t *pxStats );
+#endif
+
+/* Stacks of statically created tasks (configSUPPORT_STATIC_ALLOCATION).  A
+buffer of portSTATIC_STACK_WORDS( uxDepth ) words declared with
+portSTATIC_STACK_ATTRIBUTES holds a stack of at least uxDepth words, and
+pxPortStaticStack() returns the stack to pass to xTaskCreateStatic() and its
+depth.  With configUSE_STACK_GUARD_PAGES the buffer is configSTACK_GUARD_PAGES
+guard pages and the stack pages above them, page aligned in
+configSTACK_GUARD_SECTION, and pxPortStaticStack() removes the access to the
+guard.  The guard stays when the task is deleted, and a buffer given again to
+a new task keeps it without being protected or counted twice. */
+#if( configUSE_STACK_GUARD_PAGES == 1 )
+	#define portSTACK_GUARD_PAGE_SIZE	4096UL
+	#define portSTACK_GUARD_SIZE		( ( uint32_t ) configSTACK_GUARD_PAGES * portSTACK_GUARD_PAGE_SIZE )
+	#define portSTATIC_STACK_WORDS( uxDepth )	( ( ( ( ( ( ( uxDepth ) * sizeof( StackType_t ) ) + portSTACK_GUARD_PAGE_SIZE - 1UL ) / portSTACK_GUARD_PAGE_SIZE ) * portSTACK_GUARD_PAGE_SIZE ) + portSTACK_GUARD_SIZE ) / sizeof( StackType_t ) )
+	#define portSTATIC_STACK_ATTRIBUTES			__attribute__( ( section( configSTACK_GUARD_SECTION ), aligned( portSTACK_GUARD_PAGE_SIZE ) ) )
+
+	StackType_t *pxPortStaticStack( StackType_t *pxBuffer, uint32_t ulBufferWords, uint32_t *pulStackDepth );
+#else
+	#define portSTATIC_STACK_WORDS( uxDepth )	( uxDepth )
+	#define portSTATIC_STACK_ATTRIBUTES
+	#define pxPortStaticStack( pxBuffer, ulBufferWords, pulStackDepth )	( *( pulStackDepth ) = ( ulBufferWords ), ( pxBuffer ) )
+#endif
+
+/* If configNUMBER_OF_CORES is set to 2 the scheduler runs tasks on both
+Cortex-A9 cores, each running the highest priority ready tasks it is allowed to
+(see vTaskCoreAffinitySet()).  Kernel data is protected by two recursive spin
+locks in portSmp.c: the task lock, held while a task has the scheduler
+suspended, and the ISR lock, held in critical sections and by the FromISR API.
+A core makes the other one reschedule with configSMP_YIELD_SGI, the tick stays
+on CPU0.  portSmp.c starts CPU1, so the application must not (STOPWATCH_AMP).
+The sampling profiler only samples CPU0. */
+#if( configNUMBER_OF_CORES > 1 )
+	#if( configNUMBER_OF_CORES != 2 )
+		#error The Zynq-7000 has two Cortex-A9 cores
+	#endif
+	#if( configUSE_LAZY_FPU_SWITCHING == 1 )
+		#error configUSE_LAZY_FPU_SWITCHING needs a single core, the FPU owner is per core and a task may move
+	#endif
+	#if( configUSE_IRQ_STATS == 1 )
+		#error configUSE_IRQ_STATS needs a single core, the statistics are not locked
+	#endif
+	#if( configUSE_PMU_PROFILING == 1 )
+		#error configUSE_PMU_PROFILING needs a single core, the PMU counters are per core
+	#endif
+	#if( configUSE_HR_TIMER == 1 )
+		#error configUSE_HR_TIMER needs a single core, the comparator interrupt is private to CPU0
+	#endif
+
+	/* SGIs 0 and 1 are the AMP mailbox doorbells. */
+	#ifndef configSMP_YIELD_SGI
+		#define configSMP_YIELD_SGI		2
+	#endif
+
+	/* Interrupts xCoreID so that it reschedules. */
+	void vPortYieldCore( BaseType_t xCoreID );
+	#define portYIELD_CORE( xCoreID )	vPortYieldCore( xCoreID )
+
+	void vPortGetTaskLock( void );
+	void vPortReleaseTaskLock( void );
+	void vPortGetISRLock( void );
+	void vPortReleaseISRLock( void );
+	#define portGET_TASK_LOCK()			vPortGetTaskLock()
+	#define portRELEASE_TASK_LOCK()		vPortReleaseTaskLock()
+	#define portGET_ISR_LOCK()			vPortGetISRLock()
+	#define portRELEASE_ISR_LOCK()		vPortReleaseISRLock()
+
+	/* Critical nesting of the task running on each core. */
+	extern volatile uint32_t ulCriticalNesting[ configNUMBER_OF_CORES ];
+	#define portGET_CRITICAL_NESTING_COUNT()		( ulCriticalNesting[ portGET_CORE_ID() ] )
+	#define portINCREMENT_CRITICAL_NESTING_COUNT()	( ulCriticalNesting[ portGET_CORE_ID() ]++ )
+	#define portDECREMENT_CRITICAL_NESTING_COUNT()	( ulCriticalNesting[ portGET_CORE_ID() ]-- )
+
+	/* Mask without taking a lock, for code touching only its own core's
+	state. */
+	#define portSET_CORE_INTERRUPT_MASK()			ulPortSetInterruptMask()
+	#define portCLEAR_CORE_INTERRUPT_MASK( x )		vPortClearInterruptMask( x )
+
+	/* The FromISR API must also exclude the other core. */
+	UBaseType_t uxTaskEnterCriticalFromISR( void );
+	void vTaskExitCriticalFromISR( UBaseType_t uxSavedInterruptStatus );
+	#undef portSET_INTERRUPT_MASK_FROM_ISR
+	#undef portCLEAR_INTERRUPT_MASK_FROM_ISR
+	#define portSET_INTERRUPT_MASK_FROM_ISR()		uxTaskEnterCriticalFromISR()
+	#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )	vTaskExitCriticalFromISR( x )
+
+	/* A yield inside a critical section is deferred to its end. */
+	void vTaskYieldWithinAPI( void );
+	#define portYIELD_WITHIN_API()					vTaskYieldWithinAPI()
+
+	extern volatile uint32_t ulPortInterruptNesting[ configNUMBER_OF_CORES ];
+	#define portASSERT_IF_IN_ISR()	configASSERT( ulPortInterruptNesting[ portGET_CORE_ID() ] == 0 )
+#endif
+
 #define portLOWEST_INTERRUPT_PRIORITY ( ( ( uint32_t ) configUNIQUE_INTERRUPT_PRIORITIES ) - 1UL )
 #define portLOWEST_USABLE_INTERRUPT_PRIORITY ( portLOWEST_INTERRUPT_PRIORITY - 1UL )
 
@@ -67,6 +67,71 @@
     #define taskYIELD_IF_USING_PREEMPTION()    portYIELD_WITHIN_API()
 #endif
 
+#if ( configNUMBER_OF_CORES > 1 )
+
+/* With more than one core the ready lists are shared and each core runs the
+ * highest priority ready task its affinity mask allows, see
+ * prvSelectHighestPriorityTask().  A running task stays in its ready list,
+ * xTaskRunState records the core it runs on.  Only a core changes its own
+ * running task, other cores ask it to reschedule with portYIELD_CORE(). */
+    #if ( configUSE_PREEMPTION == 0 )
+        #error configNUMBER_OF_CORES > 1 needs configUSE_PREEMPTION
+    #endif
+    #if ( configUSE_TICKLESS_IDLE != 0 )
+        #error configUSE_TICKLESS_IDLE is not supported with configNUMBER_OF_CORES > 1
+    #endif
+    #if ( configGENERATE_RUN_TIME_STATS == 1 ) || ( configUSE_NEWLIB_REENTRANT == 1 ) || ( configUSE_C_RUNTIME_TLS_SUPPORT == 1 ) || ( configUSE_POSIX_ERRNO == 1 )
+        #error Run time stats and the per task C library state are kept for a single core only
+    #endif
+    #if ( portCRITICAL_NESTING_IN_TCB == 1 )
+        #error configNUMBER_OF_CORES > 1 needs the port to keep the critical nesting count per core
+    #endif
+
+    #define taskTASK_NOT_RUNNING    ( ( BaseType_t ) -1 )
+    #define taskTASK_IS_RUNNING( pxTCB )    ( ( pxTCB )->xTaskRunState != taskTASK_NOT_RUNNING )
+
+/* pdTRUE if the calling core must yield to pxTCB, which has just been readied
+ * or raised in priority.  If a different core has to run it, that core is
+ * interrupted instead. */
+    #define taskMUST_PREEMPT( pxTCB )             ( prvYieldForTask( pxTCB ) != pdFALSE )
+    #define taskMUST_PREEMPT_OR_EQUAL( pxTCB )    ( prvYieldForTask( pxTCB ) != pdFALSE )
+#else
+    #define taskTASK_IS_RUNNING( pxTCB )    ( ( pxTCB ) == pxCurrentTCB )
+    #if ( configUSE_EDF_SCHEDULING == 1 )
+
+/* Between two tasks of configEDF_PRIORITY the earlier deadline preempts, the
+ * later one never does. */
+        #define taskMUST_PREEMPT( pxTCB ) \
+    ( ( ( pxTCB )->uxPriority > pxCurrentTCB->uxPriority ) || ( prvEdfMustPreempt( pxTCB ) != pdFALSE ) )
+        #define taskMUST_PREEMPT_OR_EQUAL( pxTCB )                                          \
+    ( ( ( pxTCB )->uxPriority > pxCurrentTCB->uxPriority ) ||                               \
+      ( ( ( pxTCB )->uxPriority == pxCurrentTCB->uxPriority ) &&                            \
+        ( ( ( pxTCB )->uxPriority != ( UBaseType_t ) configEDF_PRIORITY ) || ( prvEdfMustPreempt( pxTCB ) != pdFALSE ) ) ) )
+    #else
+        #define taskMUST_PREEMPT( pxTCB )             ( ( pxTCB )->uxPriority > pxCurrentTCB->uxPriority )
+        #define taskMUST_PREEMPT_OR_EQUAL( pxTCB )    ( ( pxTCB )->uxPriority >= pxCurrentTCB->uxPriority )
+    #endif
+#endif /* configNUMBER_OF_CORES */
+
+#if ( configUSE_EDF_SCHEDULING == 1 )
+
+/* Tasks created with xTaskCreateEdf() all run at configEDF_PRIORITY, where
+ * the ready list is kept in order of absolute deadline instead of round robin
+ * and its head runs.  Deadlines and budgets are counted in ticks. */
+    #if ( configNUMBER_OF_CORES > 1 )
+        #error configUSE_EDF_SCHEDULING needs configNUMBER_OF_CORES 1
+    #endif
+    #if ( configEDF_PRIORITY <= 0 ) || ( configEDF_PRIORITY >= configMAX_PRIORITIES )
+        #error configEDF_PRIORITY must be above the idle priority and below configMAX_PRIORITIES
+    #endif
+
+    #define taskEDF_PPM    ( 1000000UL )
+
+/* pdTRUE if tick xA comes after tick xB, for ticks less than half the tick
+ * range apart. */
+    #define taskEDF_IS_LATER( xA, xB )    ( ( TickType_t ) ( ( xA ) - ( xB ) - ( TickType_t ) 1 ) < ( portMAX_DELAY >> 1 ) )
+#endif /* configUSE_EDF_SCHEDULING */
+
 /* Values that can be assigned to the ucNotifyState member of the TCB. */
 #define taskNOT_WAITING_NOTIFICATION              ( ( uint8_t ) 0 ) /* Must be zero as it is the initialised value. */
 #define taskWAITING_NOTIFICATION                  ( ( uint8_t ) 1 )
@@ -115,6 +180,24 @@
     #define configIDLE_TASK_NAME    "IDLE"
 #endif
 
+#if ( configUSE_EDF_SCHEDULING == 1 )
+
+/* The head of the EDF ready list has the earliest deadline. */
+    #define taskSELECT_READY_TASK( uxPriority )                                                    \
+    {                                                                                              \
+        if( ( uxPriority ) == ( UBaseType_t ) configEDF_PRIORITY )                                 \
+        {                                                                                          \
+            pxCurrentTCB = listGET_OWNER_OF_HEAD_ENTRY( &( pxReadyTasksLists[ ( uxPriority ) ] ) ); \
+        }                                                                                          \
+        else                                                                                       \
+        {                                                                                          \
+            listGET_OWNER_OF_NEXT_ENTRY( pxCurrentTCB, &( pxReadyTasksLists[ ( uxPriority ) ] ) ); \
+        }                                                                                          \
+    }
+#else
+    #define taskSELECT_READY_TASK( uxPriority )    listGET_OWNER_OF_NEXT_ENTRY( pxCurrentTCB, &( pxReadyTasksLists[ ( uxPriority ) ] ) )
+#endif
+
 #if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 0 )
 
 /* If configUSE_PORT_OPTIMISED_TASK_SELECTION is 0 then task selection is
@@ -146,7 +229,7 @@
                                                                               \
         /* listGET_OWNER_OF_NEXT_ENTRY indexes through the list, so the tasks of \
          * the  same priority get an equal share of the processor time. */                    \
-        listGET_OWNER_OF_NEXT_ENTRY( pxCurrentTCB, &( pxReadyTasksLists[ uxTopPriority ] ) ); \
+        taskSELECT_READY_TASK( uxTopPriority );                                               \
         uxTopReadyPriority = uxTopPriority;                                                   \
     } /* taskSELECT_HIGHEST_PRIORITY_TASK */
 
@@ -176,7 +259,7 @@
         /* Find the highest priority list that contains ready tasks. */                         \
         portGET_HIGHEST_PRIORITY( uxTopPriority, uxTopReadyPriority );                          \
         configASSERT( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ uxTopPriority ] ) ) > 0 ); \
-        listGET_OWNER_OF_NEXT_ENTRY( pxCurrentTCB, &( pxReadyTasksLists[ uxTopPriority ] ) );   \
+        taskSELECT_READY_TASK( uxTopPriority );                                                 \
     } /* taskSELECT_HIGHEST_PRIORITY_TASK() */
 
 /*-----------------------------------------------------------*/
@@ -214,14 +297,31 @@
 
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_EDF_SCHEDULING == 1 )
+    #define taskINSERT_READY( pxTCB )                                                                          \
+    {                                                                                                          \
+        if( ( pxTCB )->uxPriority == ( UBaseType_t ) configEDF_PRIORITY )                                      \
+        {                                                                                                      \
+            prvEdfInsertReady( pxTCB );                                                                        \
+        }                                                                                                      \
+        else                                                                                                   \
+        {                                                                                                      \
+            listINSERT_END( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), &( ( pxTCB )->xStateListItem ) ); \
+        }                                                                                                      \
+    }
+#else
+    #define taskINSERT_READY( pxTCB )    listINSERT_END( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), &( ( pxTCB )->xStateListItem ) )
+#endif
+
 /*
  * Place the task represented by pxTCB into the appropriate ready list for
- * the task.  It is inserted at the end of the list.
+ * the task.  It is inserted at the end of the list, or in deadline order at
+ * configEDF_PRIORITY.
  */
-#define prvAddTaskToReadyList( pxTCB )                                                                 \
-    traceMOVED_TASK_TO_READY_STATE( pxTCB );                                                           \
-    taskRECORD_READY_PRIORITY( ( pxTCB )->uxPriority );                                                \
-    listINSERT_END( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), &( ( pxTCB )->xStateListItem ) ); \
+#define prvAddTaskToReadyList( pxTCB )                  \
+    traceMOVED_TASK_TO_READY_STATE( pxTCB );            \
+    taskRECORD_READY_PRIORITY( ( pxTCB )->uxPriority ); \
+    taskINSERT_READY( pxTCB );                          \
     tracePOST_MOVED_TASK_TO_READY_STATE( pxTCB )
 /*-----------------------------------------------------------*/
 
@@ -318,6 +418,25 @@ typedef struct tskTaskControlBlock       /* The old naming convention is used to
     #if ( configUSE_POSIX_ERRNO == 1 )
         int iTaskErrno;
     #endif
+
+    #if ( configUSE_EDF_SCHEDULING == 1 )
+        TickType_t xEdfPeriod;           /*< 0 for the tasks outside the EDF class. */
+        TickType_t xEdfDeadline;         /*< Relative to the release of each job. */
+        TickType_t xEdfBudget;           /*< Ticks each job may run. */
+        TickType_t xEdfRelease;          /*< Release of the current job. */
+        TickType_t xEdfAbsoluteDeadline; /*< Deadline of the current job. */
+        TickType_t xEdfUsed;             /*< Ticks the current job has run. */
+        TickType_t xEdfMaxLateness;
+        uint32_t ulEdfDensity;           /*< Budget over deadline, in millionths, counted by admission control. */
+        uint32_t ulEdfJobs;
+        uint32_t ulEdfDeadlineMisses;
+        uint32_t ulEdfBudgetOverruns;
+    #endif
+
+    #if ( configNUMBER_OF_CORES > 1 )
+        volatile BaseType_t xTaskRunState; /*< Core the task runs on, or taskTASK_NOT_RUNNING. */
+        UBaseType_t uxCoreAffinityMask;    /*< Bit n is set if the task may run on core n. */
+    #endif
 } tskTCB;
 
 /* The old tskTCB name is maintained above then typedefed to the new TCB_t name
@@ -326,7 +445,16 @@ typedef tskTCB TCB_t;
 
 /*lint -save -e956 A manual analysis and inspection has been used to determine
  * which static variables must be declared volatile. */
-portDONT_DISCARD PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
+#if ( configNUMBER_OF_CORES == 1 )
+    portDONT_DISCARD PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
+#else
+
+/* The task running on each core.  A task reads its own entry with interrupts
+ * masked, as it can move to the other core between reading the core ID and
+ * reading the entry. */
+    portDONT_DISCARD PRIVILEGED_DATA TCB_t * volatile pxCurrentTCBs[ configNUMBER_OF_CORES ] = { NULL };
+    #define pxCurrentTCB    xTaskGetCurrentTaskHandle()
+#endif
 
 /* Lists for ready and blocked tasks. --------------------
  * xDelayedTaskList1 and xDelayedTaskList2 could be moved to function scope but
@@ -364,11 +492,25 @@ PRIVILEGED_DATA static volatile TickType_t xTickCount = ( TickType_t ) configINI
 PRIVILEGED_DATA static volatile UBaseType_t uxTopReadyPriority = tskIDLE_PRIORITY;
 PRIVILEGED_DATA static volatile BaseType_t xSchedulerRunning = pdFALSE;
 PRIVILEGED_DATA static volatile TickType_t xPendedTicks = ( TickType_t ) 0U;
-PRIVILEGED_DATA static volatile BaseType_t xYieldPending = pdFALSE;
 PRIVILEGED_DATA static volatile BaseType_t xNumOfOverflows = ( BaseType_t ) 0;
 PRIVILEGED_DATA static UBaseType_t uxTaskNumber = ( UBaseType_t ) 0U;
 PRIVILEGED_DATA static volatile TickType_t xNextTaskUnblockTime = ( TickType_t ) 0U; /* Initialised to portMAX_DELAY before the scheduler starts. */
-PRIVILEGED_DATA static TaskHandle_t xIdleTaskHandle = NULL;                          /*< Holds the handle of the idle task.  The idle task is created automatically when the scheduler is started. */
+
+#if ( configNUMBER_OF_CORES == 1 )
+    PRIVILEGED_DATA static volatile BaseType_t xYieldPending = pdFALSE;
+    PRIVILEGED_DATA static TaskHandle_t xIdleTaskHandle = NULL; /*< Holds the handle of the idle task.  The idle task is created automatically when the scheduler is started. */
+#else
+
+/* A yield is pending on a core when it was asked to reschedule and has not
+ * done it yet.  Only accessed with the ISR lock held. */
+    PRIVILEGED_DATA static volatile BaseType_t xYieldPendings[ configNUMBER_OF_CORES ] = { pdFALSE };
+    #define xYieldPending    xYieldPendings[ portGET_CORE_ID() ]
+
+/* One idle task pinned to each core.  Only the one of core 0 runs the idle
+ * hook and frees deleted tasks, xTaskGetIdleTaskHandle() returns it. */
+    PRIVILEGED_DATA static TaskHandle_t xIdleTaskHandles[ configNUMBER_OF_CORES ] = { NULL };
+    #define xIdleTaskHandle    xIdleTaskHandles[ 0 ]
+#endif
 
 /* Improve support for OpenOCD. The kernel tracks Ready tasks via priority lists.
  * For tracking the state of remote threads, OpenOCD uses uxTopUsedPriority
@@ -385,6 +527,12 @@ const volatile UBaseType_t uxTopUsedPriority = configMAX_PRIORITIES - 1U;
  * accessed from a critical section. */
 PRIVILEGED_DATA static volatile UBaseType_t uxSchedulerSuspended = ( UBaseType_t ) pdFALSE;
 
+#if ( configUSE_EDF_SCHEDULING == 1 )
+
+/* Sum of the densities of the EDF tasks, in millionths of the processor. */
+    PRIVILEGED_DATA static uint32_t ulEdfDensity = 0U;
+#endif
+
 #if ( configGENERATE_RUN_TIME_STATS == 1 )
 
 /* Do not move these variables to function scope as doing so prevents the
@@ -546,6 +694,67 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
  */
 static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
 
+#if ( configNUMBER_OF_CORES > 1 )
+
+/*
+ * Makes xCoreID run the highest priority ready task it may run, that is not
+ * already running on another core.  Called with both kernel locks held.
+ */
+    static void prvSelectHighestPriorityTask( BaseType_t xCoreID ) PRIVILEGED_FUNCTION;
+
+/*
+ * Finds the core that should run pxTCB in place of its current task, the
+ * allowed core running the lowest priority task below the priority of pxTCB.
+ * Another core is interrupted, pdTRUE is returned if it is the calling core.
+ * Called with the ISR lock held.
+ */
+    static BaseType_t prvYieldForTask( const TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+/*
+ * Asks xCoreID to reschedule.  Called with the ISR lock held.
+ */
+    static void prvYieldCore( BaseType_t xCoreID ) PRIVILEGED_FUNCTION;
+
+/*
+ * The idle task of the cores other than core 0.  It neither frees deleted
+ * tasks nor runs the idle hook, the idle task of core 0 does.
+ */
+    static portTASK_FUNCTION_PROTO( prvPassiveIdleTask, pvParameters ) PRIVILEGED_FUNCTION;
+
+#endif /* configNUMBER_OF_CORES */
+
+#if ( configUSE_EDF_SCHEDULING == 1 )
+
+/*
+ * Inserts pxTCB, of configEDF_PRIORITY, into its ready list behind the tasks
+ * whose deadline is earlier or the same.  Tasks outside the EDF class only
+ * reach that priority by inheriting it, they are given the current tick as
+ * deadline.
+ */
+    static void prvEdfInsertReady( TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+/*
+ * pdTRUE if pxTCB and the running task both run at configEDF_PRIORITY and
+ * pxTCB has the earlier deadline.
+ */
+    static BaseType_t prvEdfMustPreempt( const TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+/*
+ * Creates an EDF task once admission control accepts it, in the buffers given
+ * by xTaskCreateEdfStatic(), or from the heap for xTaskCreateEdf() when
+ * pxTaskBuffer is NULL.
+ */
+    static BaseType_t prvCreateEdfTask( TaskFunction_t pxTaskCode,
+                                        const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                        const configSTACK_DEPTH_TYPE usStackDepth,
+                                        void * const pvParameters,
+                                        const TaskEdfParameters_t * const pxEdfParameters,
+                                        StackType_t * const puxStackBuffer,
+                                        StaticTask_t * const pxTaskBuffer,
+                                        TaskHandle_t * const pxCreatedTask ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_EDF_SCHEDULING */
+
 /*
  * freertos_tasks_c_additions_init() should only be called if the user definable
  * macro FREERTOS_TASKS_C_ADDITIONS_INIT() is defined, as that is the only macro
@@ -718,6 +927,31 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
 
 #if ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
 
+    /* With the multi pool heap the stack and TCB of tasks at or above
+     * configFAST_HEAP_TASK_PRIORITY are placed in the fast (on-chip) pool,
+     * unless the port allocates the stacks itself.  Keep the threshold above
+     * the bulk of the tasks: the pool is small, and once it is full the fast
+     * requests end up in DDR, counted by xPortGetHeapPoolFallbacks() and
+     * traced by traceMALLOC_FALLBACK(). */
+    #if ( configUSE_FAST_HEAP == 1 )
+        #ifndef configFAST_HEAP_TASK_PRIORITY
+            #define configFAST_HEAP_TASK_PRIORITY    ( configMAX_PRIORITIES )
+        #endif
+        #if ( configFAST_HEAP_TASK_PRIORITY == 0 )
+            #define prvTaskMalloc( uxPriority, xSize )    pvPortMallocFast( xSize )
+        #else
+            #define prvTaskMalloc( uxPriority, xSize )    ( ( ( uxPriority ) >= ( UBaseType_t ) configFAST_HEAP_TASK_PRIORITY ) ? pvPortMallocFast( xSize ) : pvPortMalloc( xSize ) )
+        #endif
+        #if ( configSTACK_ALLOCATION_FROM_SEPARATE_HEAP == 1 )
+            #define prvTaskMallocStack( uxPriority, xSize )    pvPortMallocStack( xSize )
+        #else
+            #define prvTaskMallocStack                    prvTaskMalloc
+        #endif
+    #else
+        #define prvTaskMalloc( uxPriority, xSize )         pvPortMalloc( xSize )
+        #define prvTaskMallocStack( uxPriority, xSize )    pvPortMallocStack( xSize )
+    #endif
+
     BaseType_t xTaskCreate( TaskFunction_t pxTaskCode,
                             const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
                             const configSTACK_DEPTH_TYPE usStackDepth,
@@ -736,7 +970,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
             /* Allocate space for the TCB.  Where the memory comes from depends on
              * the implementation of the port malloc function and whether or not static
              * allocation is being used. */
-            pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) );
+            pxNewTCB = ( TCB_t * ) prvTaskMalloc( uxPriority, sizeof( TCB_t ) );
 
             if( pxNewTCB != NULL )
             {
@@ -745,7 +979,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
                 /* Allocate space for the stack used by the task being created.
                  * The base of the stack memory stored in the TCB so the task can
                  * be deleted later if required. */
-                pxNewTCB->pxStack = ( StackType_t * ) pvPortMallocStack( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+                pxNewTCB->pxStack = ( StackType_t * ) prvTaskMallocStack( uxPriority, ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
 
                 if( pxNewTCB->pxStack == NULL )
                 {
@@ -760,12 +994,12 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
             StackType_t * pxStack;
 
             /* Allocate space for the stack used by the task being created. */
-            pxStack = pvPortMallocStack( ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) ); /*lint !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack and this allocation is the stack. */
+            pxStack = prvTaskMallocStack( uxPriority, ( ( ( size_t ) usStackDepth ) * sizeof( StackType_t ) ) ); /*lint !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack and this allocation is the stack. */
 
             if( pxStack != NULL )
             {
                 /* Allocate space for the TCB. */
-                pxNewTCB = ( TCB_t * ) pvPortMalloc( sizeof( TCB_t ) ); /*lint !e9087 !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack, and the first member of TCB_t is always a pointer to the task's stack. */
+                pxNewTCB = ( TCB_t * ) prvTaskMalloc( uxPriority, sizeof( TCB_t ) ); /*lint !e9087 !e9079 All values returned by pvPortMalloc() have at least the alignment required by the MCU's stack, and the first member of TCB_t is always a pointer to the task's stack. */
 
                 if( pxNewTCB != NULL )
                 {
@@ -940,6 +1174,30 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
     listSET_LIST_ITEM_VALUE( &( pxNewTCB->xEventListItem ), ( TickType_t ) configMAX_PRIORITIES - ( TickType_t ) uxPriority ); /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
     listSET_LIST_ITEM_OWNER( &( pxNewTCB->xEventListItem ), pxNewTCB );
 
+    #if ( configNUMBER_OF_CORES > 1 )
+    {
+        pxNewTCB->xTaskRunState = taskTASK_NOT_RUNNING;
+        pxNewTCB->uxCoreAffinityMask = tskNO_AFFINITY;
+    }
+    #endif
+
+    #if ( configUSE_EDF_SCHEDULING == 1 )
+    {
+        /* xTaskCreateEdf() sets the parameters once the task is created. */
+        pxNewTCB->xEdfPeriod = ( TickType_t ) 0U;
+        pxNewTCB->xEdfDeadline = ( TickType_t ) 0U;
+        pxNewTCB->xEdfBudget = ( TickType_t ) 0U;
+        pxNewTCB->xEdfRelease = ( TickType_t ) 0U;
+        pxNewTCB->xEdfAbsoluteDeadline = ( TickType_t ) 0U;
+        pxNewTCB->xEdfUsed = ( TickType_t ) 0U;
+        pxNewTCB->xEdfMaxLateness = ( TickType_t ) 0U;
+        pxNewTCB->ulEdfDensity = 0U;
+        pxNewTCB->ulEdfJobs = 0U;
+        pxNewTCB->ulEdfDeadlineMisses = 0U;
+        pxNewTCB->ulEdfBudgetOverruns = 0U;
+    }
+    #endif
+
     #if ( portUSING_MPU_WRAPPERS == 1 )
     {
         vPortStoreTaskMPUSettings( &( pxNewTCB->xMPUSettings ), xRegions, pxNewTCB->pxStack, ulStackDepth );
@@ -1031,6 +1289,20 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
     {
         uxCurrentNumberOfTasks++;
 
+        #if ( configNUMBER_OF_CORES > 1 )
+        {
+            /* The tasks the cores start with are chosen by
+             * vTaskStartScheduler(). */
+            if( uxCurrentNumberOfTasks == ( UBaseType_t ) 1 )
+            {
+                prvInitialiseTaskLists();
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        #else /* configNUMBER_OF_CORES */
         if( pxCurrentTCB == NULL )
         {
             /* There are no other tasks, or all the other tasks are in
@@ -1070,6 +1342,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                 mtCOVERAGE_TEST_MARKER();
             }
         }
+        #endif /* configNUMBER_OF_CORES */
 
         uxTaskNumber++;
 
@@ -1084,26 +1357,45 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
         prvAddTaskToReadyList( pxNewTCB );
 
         portSETUP_TCB( pxNewTCB );
+
+        #if ( configNUMBER_OF_CORES > 1 )
+        {
+            /* A yield of this core is pending until the critical section is
+             * left. */
+            if( xSchedulerRunning != pdFALSE )
+            {
+                ( void ) prvYieldForTask( pxNewTCB );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        #endif
     }
     taskEXIT_CRITICAL();
 
-    if( xSchedulerRunning != pdFALSE )
+    #if ( configNUMBER_OF_CORES == 1 )
     {
-        /* If the created task is of a higher priority than the current task
-         * then it should run now. */
-        if( pxCurrentTCB->uxPriority < pxNewTCB->uxPriority )
+        if( xSchedulerRunning != pdFALSE )
         {
-            taskYIELD_IF_USING_PREEMPTION();
+            /* If the created task is of a higher priority than the current task
+             * then it should run now. */
+            if( pxCurrentTCB->uxPriority < pxNewTCB->uxPriority )
+            {
+                taskYIELD_IF_USING_PREEMPTION();
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
         }
         else
         {
             mtCOVERAGE_TEST_MARKER();
         }
     }
-    else
-    {
-        mtCOVERAGE_TEST_MARKER();
-    }
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -1112,6 +1404,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
     void vTaskDelete( TaskHandle_t xTaskToDelete )
     {
         TCB_t * pxTCB;
+        BaseType_t xDeleteTCBInIdleTask;
 
         taskENTER_CRITICAL();
         {
@@ -1129,6 +1422,15 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                 mtCOVERAGE_TEST_MARKER();
             }
 
+            #if ( configUSE_EDF_SCHEDULING == 1 )
+            {
+                /* Admission control can give the processor time of the task
+                 * to a new one. */
+                ulEdfDensity -= pxTCB->ulEdfDensity;
+                pxTCB->ulEdfDensity = 0U;
+            }
+            #endif
+
             /* Is the task waiting on an event also? */
             if( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) != NULL )
             {
@@ -1145,7 +1447,12 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
              * not return. */
             uxTaskNumber++;
 
-            if( pxTCB == pxCurrentTCB )
+            /* On more than one core the task can be running on the other core,
+             * it is then freed by the idle task once that core has switched
+             * away from it. */
+            xDeleteTCBInIdleTask = taskTASK_IS_RUNNING( pxTCB );
+
+            if( xDeleteTCBInIdleTask != pdFALSE )
             {
                 /* A task is deleting itself.  This cannot complete within the
                  * task itself, as a context switch to another task is required.
@@ -1169,6 +1476,15 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                  * hence xYieldPending is used to latch that a context switch is
                  * required. */
                 portPRE_TASK_DELETE_HOOK( pxTCB, &xYieldPending );
+
+                #if ( configNUMBER_OF_CORES > 1 )
+                {
+                    /* Running here the task yields when the critical section
+                     * is left. */
+                    configASSERT( ( pxTCB->xTaskRunState != portGET_CORE_ID() ) || ( uxSchedulerSuspended == 0 ) );
+                    prvYieldCore( pxTCB->xTaskRunState );
+                }
+                #endif
             }
             else
             {
@@ -1185,25 +1501,29 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
         /* If the task is not deleting itself, call prvDeleteTCB from outside of
          * critical section. If a task deletes itself, prvDeleteTCB is called
          * from prvCheckTasksWaitingTermination which is called from Idle task. */
-        if( pxTCB != pxCurrentTCB )
+        if( xDeleteTCBInIdleTask == pdFALSE )
         {
             prvDeleteTCB( pxTCB );
         }
 
         /* Force a reschedule if it is the currently running task that has just
          * been deleted. */
-        if( xSchedulerRunning != pdFALSE )
+        #if ( configNUMBER_OF_CORES == 1 )
         {
-            if( pxTCB == pxCurrentTCB )
-            {
-                configASSERT( uxSchedulerSuspended == 0 );
-                portYIELD_WITHIN_API();
-            }
-            else
+            if( xSchedulerRunning != pdFALSE )
             {
-                mtCOVERAGE_TEST_MARKER();
+                if( pxTCB == pxCurrentTCB )
+                {
+                    configASSERT( uxSchedulerSuspended == 0 );
+                    portYIELD_WITHIN_API();
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
             }
         }
+        #endif
     }
 
 #endif /* INCLUDE_vTaskDelete */
@@ -1219,10 +1539,13 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
 
         configASSERT( pxPreviousWakeTime );
         configASSERT( ( xTimeIncrement > 0U ) );
-        configASSERT( uxSchedulerSuspended == 0 );
 
         vTaskSuspendAll();
         {
+            /* Checked once suspended, another core may hold the scheduler
+             * suspended until then. */
+            configASSERT( uxSchedulerSuspended == 1U );
+
             /* Minor optimisation.  The tick count cannot change in this
              * block. */
             const TickType_t xConstTickCount = xTickCount;
@@ -1305,9 +1628,9 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
         /* A delay time of zero just forces a reschedule. */
         if( xTicksToDelay > ( TickType_t ) 0U )
         {
-            configASSERT( uxSchedulerSuspended == 0 );
             vTaskSuspendAll();
             {
+                configASSERT( uxSchedulerSuspended == 1U );
                 traceTASK_DELAY();
 
                 /* A task that is removed from the event list while the
@@ -1353,9 +1676,10 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
 
         configASSERT( pxTCB );
 
-        if( pxTCB == pxCurrentTCB )
+        if( taskTASK_IS_RUNNING( pxTCB ) )
         {
-            /* The task calling this function is querying its own state. */
+            /* The task calling this function is querying its own state, or
+             * the task runs on another core. */
             eReturn = eRunning;
         }
         else
@@ -1543,6 +1867,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
 
             if( uxCurrentBasePriority != uxNewPriority )
             {
+                #if ( configNUMBER_OF_CORES == 1 )
                 /* The priority change may have readied a task of higher
                  * priority than the calling task. */
                 if( uxNewPriority > uxCurrentBasePriority )
@@ -1581,6 +1906,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                      * require a yield as the running task must be above the
                      * new priority of the task being modified. */
                 }
+                #endif /* configNUMBER_OF_CORES */
 
                 /* Remember the ready list the task might be referenced from
                  * before its uxPriority member is changed so the
@@ -1648,6 +1974,30 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                     mtCOVERAGE_TEST_MARKER();
                 }
 
+                #if ( configNUMBER_OF_CORES > 1 )
+                {
+                    /* A running task lowered may no longer be one of the
+                     * highest priority ready tasks, a ready task raised may now
+                     * be.  The yields are pending until the critical section is
+                     * left. */
+                    if( taskTASK_IS_RUNNING( pxTCB ) )
+                    {
+                        if( uxNewPriority < uxCurrentBasePriority )
+                        {
+                            prvYieldCore( pxTCB->xTaskRunState );
+                        }
+                    }
+                    else if( uxNewPriority > uxCurrentBasePriority )
+                    {
+                        ( void ) prvYieldForTask( pxTCB );
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+                #endif /* configNUMBER_OF_CORES */
+
                 if( xYieldRequired != pdFALSE )
                 {
                     taskYIELD_IF_USING_PREEMPTION();
@@ -1720,6 +2070,23 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                 }
             }
             #endif /* if ( configUSE_TASK_NOTIFICATIONS == 1 ) */
+
+            #if ( configNUMBER_OF_CORES > 1 )
+            {
+                /* The core running the task switches away from it, if it is
+                 * this core the yield is pending until the critical section is
+                 * left. */
+                if( taskTASK_IS_RUNNING( pxTCB ) )
+                {
+                    configASSERT( ( pxTCB->xTaskRunState != portGET_CORE_ID() ) || ( uxSchedulerSuspended == 0 ) );
+                    prvYieldCore( pxTCB->xTaskRunState );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            #endif /* configNUMBER_OF_CORES */
         }
         taskEXIT_CRITICAL();
 
@@ -1738,6 +2105,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
             mtCOVERAGE_TEST_MARKER();
         }
 
+        #if ( configNUMBER_OF_CORES == 1 )
         if( pxTCB == pxCurrentTCB )
         {
             if( xSchedulerRunning != pdFALSE )
@@ -1769,6 +2137,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
         {
             mtCOVERAGE_TEST_MARKER();
         }
+        #endif /* configNUMBER_OF_CORES */
     }
 
 #endif /* INCLUDE_vTaskSuspend */
@@ -1845,7 +2214,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                     prvAddTaskToReadyList( pxTCB );
 
                     /* A higher priority task may have just been resumed. */
-                    if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+                    if( taskMUST_PREEMPT_OR_EQUAL( pxTCB ) )
                     {
                         /* This yield may not cause the task just resumed to run,
                          * but will leave the lists in the correct state for the
@@ -1913,7 +2282,7 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                 {
                     /* Ready lists can be accessed so move the task from the
                      * suspended list to the ready list directly. */
-                    if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+                    if( taskMUST_PREEMPT_OR_EQUAL( pxTCB ) )
                     {
                         xYieldRequired = pdTRUE;
 
@@ -1994,6 +2363,54 @@ void vTaskStartScheduler( void )
     }
     #endif /* configSUPPORT_STATIC_ALLOCATION */
 
+    #if ( configNUMBER_OF_CORES > 1 )
+    {
+        BaseType_t xCoreID;
+
+        /* Each core has an idle task of its own, pinned to it, so a core
+         * always has a task to run. */
+        if( xReturn == pdPASS )
+        {
+            xIdleTaskHandles[ 0 ]->uxCoreAffinityMask = ( UBaseType_t ) 1U;
+        }
+
+        for( xCoreID = 1; ( xCoreID < ( BaseType_t ) configNUMBER_OF_CORES ) && ( xReturn == pdPASS ); xCoreID++ )
+        {
+            #if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+            {
+                StaticTask_t * pxIdleTaskTCBBuffer = NULL;
+                StackType_t * pxIdleTaskStackBuffer = NULL;
+                uint32_t ulIdleTaskStackSize;
+
+                vApplicationGetPassiveIdleTaskMemory( &pxIdleTaskTCBBuffer, &pxIdleTaskStackBuffer, &ulIdleTaskStackSize, xCoreID - 1 );
+                xIdleTaskHandles[ xCoreID ] = xTaskCreateStatic( prvPassiveIdleTask,
+                                                                 configIDLE_TASK_NAME,
+                                                                 ulIdleTaskStackSize,
+                                                                 ( void * ) NULL,
+                                                                 portPRIVILEGE_BIT,
+                                                                 pxIdleTaskStackBuffer,
+                                                                 pxIdleTaskTCBBuffer );
+                xReturn = ( xIdleTaskHandles[ xCoreID ] != NULL ) ? pdPASS : pdFAIL;
+            }
+            #else
+            {
+                xReturn = xTaskCreate( prvPassiveIdleTask,
+                                       configIDLE_TASK_NAME,
+                                       configMINIMAL_STACK_SIZE,
+                                       ( void * ) NULL,
+                                       portPRIVILEGE_BIT,
+                                       &xIdleTaskHandles[ xCoreID ] );
+            }
+            #endif /* configSUPPORT_STATIC_ALLOCATION */
+
+            if( xReturn == pdPASS )
+            {
+                xIdleTaskHandles[ xCoreID ]->uxCoreAffinityMask = ( UBaseType_t ) 1U << xCoreID;
+            }
+        }
+    }
+    #endif /* configNUMBER_OF_CORES */
+
     #if ( configUSE_TIMERS == 1 )
     {
         if( xReturn == pdPASS )
@@ -2045,6 +2462,19 @@ void vTaskStartScheduler( void )
          * FreeRTOSConfig.h file. */
         portCONFIGURE_TIMER_FOR_RUN_TIME_STATS();
 
+        #if ( configNUMBER_OF_CORES > 1 )
+        {
+            BaseType_t xCoreID;
+
+            /* Choose the first task of every core, xPortStartScheduler()
+             * starts the other cores on theirs. */
+            for( xCoreID = 0; xCoreID < ( BaseType_t ) configNUMBER_OF_CORES; xCoreID++ )
+            {
+                prvSelectHighestPriorityTask( xCoreID );
+            }
+        }
+        #endif
+
         traceTASK_SWITCHED_IN();
 
         /* Setting up the timer tick is hardware specific and thus in the
@@ -2098,9 +2528,28 @@ void vTaskSuspendAll( void )
      * do not otherwise exhibit real time behaviour. */
     portSOFTWARE_BARRIER();
 
-    /* The scheduler is suspended if uxSchedulerSuspended is non-zero.  An increment
-     * is used to allow calls to vTaskSuspendAll() to nest. */
-    ++uxSchedulerSuspended;
+    #if ( configNUMBER_OF_CORES > 1 )
+        if( xSchedulerRunning != pdFALSE )
+        {
+            UBaseType_t uxSavedInterruptStatus;
+
+            /* The task lock is held until xTaskResumeAll(), which keeps the
+             * other cores out of the kernel.  Interrupts are masked while it is
+             * taken so the task cannot move to another core. */
+            uxSavedInterruptStatus = portSET_CORE_INTERRUPT_MASK();
+            portGET_TASK_LOCK();
+            portGET_ISR_LOCK();
+            ++uxSchedulerSuspended;
+            portRELEASE_ISR_LOCK();
+            portCLEAR_CORE_INTERRUPT_MASK( uxSavedInterruptStatus );
+        }
+        else
+    #endif /* configNUMBER_OF_CORES */
+    {
+        /* The scheduler is suspended if uxSchedulerSuspended is non-zero.  An increment
+         * is used to allow calls to vTaskSuspendAll() to nest. */
+        ++uxSchedulerSuspended;
+    }
 
     /* Enforces ordering for ports and optimised compilers that may otherwise place
      * the above increment elsewhere. */
@@ -2189,6 +2638,17 @@ BaseType_t xTaskResumeAll( void )
     {
         --uxSchedulerSuspended;
 
+        #if ( configNUMBER_OF_CORES > 1 )
+        {
+            /* Taken by vTaskSuspendAll(), the critical section still holds
+             * it. */
+            if( xSchedulerRunning != pdFALSE )
+            {
+                portRELEASE_TASK_LOCK();
+            }
+        }
+        #endif
+
         if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
         {
             if( uxCurrentNumberOfTasks > ( UBaseType_t ) 0U )
@@ -2205,7 +2665,7 @@ BaseType_t xTaskResumeAll( void )
 
                     /* If the moved task has a priority higher than or equal to
                      * the current task then a yield must be performed. */
-                    if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+                    if( taskMUST_PREEMPT_OR_EQUAL( pxTCB ) )
                     {
                         xYieldPending = pdTRUE;
                     }
@@ -2691,7 +3151,7 @@ BaseType_t xTaskCatchUpTicks( TickType_t xTicksToCatchUp )
                     /* Preemption is on, but a context switch should only be
                      * performed if the unblocked task has a priority that is
                      * higher than the currently executing task. */
-                    if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                    if( taskMUST_PREEMPT( pxTCB ) )
                     {
                         /* Pend the yield to be performed when the scheduler
                          * is unsuspended. */
@@ -2713,57 +3173,408 @@ BaseType_t xTaskCatchUpTicks( TickType_t xTicksToCatchUp )
 
         return xReturn;
     }
+/*-----------------------------------------------------------*/
 
-#endif /* INCLUDE_xTaskAbortDelay */
-/*----------------------------------------------------------*/
-
-BaseType_t xTaskIncrementTick( void )
-{
-    TCB_t * pxTCB;
-    TickType_t xItemValue;
-    BaseType_t xSwitchRequired = pdFALSE;
-
-    /* Called by the portable layer each time a tick interrupt occurs.
-     * Increments the tick then checks to see if the new tick value will cause any
-     * tasks to be unblocked. */
-    traceTASK_INCREMENT_TICK( xTickCount );
-
-    if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
+    BaseType_t xTaskAbortDelayFromISR( TaskHandle_t xTask,
+                                       BaseType_t * const pxHigherPriorityTaskWoken )
     {
-        /* Minor optimisation.  The tick count cannot change in this
-         * block. */
-        const TickType_t xConstTickCount = xTickCount + ( TickType_t ) 1;
+        TCB_t * pxTCB = xTask;
+        BaseType_t xReturn = pdFAIL;
+        UBaseType_t uxSavedInterruptStatus;
+        const List_t * pxStateList;
 
-        /* Increment the RTOS tick, switching the delayed and overflowed
-         * delayed lists if it wraps to 0. */
-        xTickCount = xConstTickCount;
+        configASSERT( pxTCB );
 
-        if( xConstTickCount == ( TickType_t ) 0U ) /*lint !e774 'if' does not always evaluate to false as it is looking for an overflow. */
-        {
-            taskSWITCH_DELAYED_LISTS();
-        }
-        else
-        {
-            mtCOVERAGE_TEST_MARKER();
-        }
+        portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
 
-        /* See if this tick has made a timeout expire.  Tasks are stored in
-         * the  queue in the order of their wake time - meaning once one task
-         * has been found whose block time has not expired there is no need to
-         * look any further down the list. */
-        if( xConstTickCount >= xNextTaskUnblockTime )
+        uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
         {
-            for( ; ; )
+            pxStateList = listLIST_ITEM_CONTAINER( &( pxTCB->xStateListItem ) );
+
+            /* Only a task delayed with a timeout and not waiting on an event
+             * list is woken.  An interrupt cannot tell whether the object owning
+             * an event list is locked, and a task whose event list item is
+             * already in the pending ready list has been unblocked. */
+            if( ( ( pxStateList == pxDelayedTaskList ) || ( pxStateList == pxOverflowDelayedTaskList ) ) &&
+                ( listLIST_ITEM_CONTAINER( &( pxTCB->xEventListItem ) ) == NULL ) )
             {
-                if( listLIST_IS_EMPTY( pxDelayedTaskList ) != pdFALSE )
+                xReturn = pdPASS;
+
+                if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
                 {
-                    /* The delayed list is empty.  Set xNextTaskUnblockTime
-                     * to the maximum possible value so it is extremely
-                     * unlikely that the
-                     * if( xTickCount >= xNextTaskUnblockTime ) test will pass
-                     * next time through. */
-                    xNextTaskUnblockTime = portMAX_DELAY; /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
-                    break;
+                    ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                    prvAddTaskToReadyList( pxTCB );
+                }
+                else
+                {
+                    /* The delayed lists cannot be accessed while the scheduler
+                     * is suspended, xTaskResumeAll() moves the task. */
+                    vListInsertEnd( &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
+                }
+
+                #if ( configUSE_PREEMPTION == 1 )
+                {
+                    if( taskMUST_PREEMPT( pxTCB ) )
+                    {
+                        if( pxHigherPriorityTaskWoken != NULL )
+                        {
+                            *pxHigherPriorityTaskWoken = pdTRUE;
+                        }
+
+                        /* Mark that a yield is pending in case the user is not
+                         * using the "xHigherPriorityTaskWoken" parameter. */
+                        xYieldPending = pdTRUE;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+                #endif /* configUSE_PREEMPTION */
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+
+        return xReturn;
+    }
+
+#endif /* INCLUDE_xTaskAbortDelay */
+/*----------------------------------------------------------*/
+
+#if ( configUSE_EDF_SCHEDULING == 1 )
+
+    static TickType_t prvEdfDeadline( const TCB_t * pxTCB )
+    {
+        TickType_t xDeadline;
+
+        if( pxTCB->xEdfPeriod != ( TickType_t ) 0U )
+        {
+            xDeadline = pxTCB->xEdfAbsoluteDeadline;
+        }
+        else
+        {
+            xDeadline = xTickCount;
+        }
+
+        return xDeadline;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvEdfInsertReady( TCB_t * pxTCB )
+    {
+        List_t * const pxList = &( pxReadyTasksLists[ configEDF_PRIORITY ] );
+        ListItem_t * const pxNewListItem = &( pxTCB->xStateListItem );
+        const TickType_t xDeadline = prvEdfDeadline( pxTCB );
+        ListItem_t * pxIterator;
+
+        listSET_LIST_ITEM_VALUE( pxNewListItem, xDeadline );
+
+        /* As vListInsert(), with a comparison that survives the tick count
+         * wrapping.  The list index is not used at this priority. */
+        for( pxIterator = ( ListItem_t * ) &( pxList->xListEnd ); pxIterator->pxNext != ( ListItem_t * ) &( pxList->xListEnd ); pxIterator = pxIterator->pxNext ) /*lint !e826 !e740 !e9087 The mini list structure is used as the list end to save RAM. */
+        {
+            if( taskEDF_IS_LATER( listGET_LIST_ITEM_VALUE( pxIterator->pxNext ), xDeadline ) )
+            {
+                break;
+            }
+        }
+
+        pxNewListItem->pxNext = pxIterator->pxNext;
+        pxNewListItem->pxNext->pxPrevious = pxNewListItem;
+        pxNewListItem->pxPrevious = pxIterator;
+        pxIterator->pxNext = pxNewListItem;
+        pxNewListItem->pxContainer = pxList;
+
+        ( pxList->uxNumberOfItems )++;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvEdfMustPreempt( const TCB_t * pxTCB )
+    {
+        BaseType_t xReturn = pdFALSE;
+
+        if( ( pxTCB->uxPriority == ( UBaseType_t ) configEDF_PRIORITY ) &&
+            ( pxCurrentTCB->uxPriority == ( UBaseType_t ) configEDF_PRIORITY ) &&
+            ( taskEDF_IS_LATER( prvEdfDeadline( pxCurrentTCB ), prvEdfDeadline( pxTCB ) ) ) )
+        {
+            xReturn = pdTRUE;
+        }
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvCreateEdfTask( TaskFunction_t pxTaskCode,
+                                        const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                        const configSTACK_DEPTH_TYPE usStackDepth,
+                                        void * const pvParameters,
+                                        const TaskEdfParameters_t * const pxEdfParameters,
+                                        StackType_t * const puxStackBuffer,
+                                        StaticTask_t * const pxTaskBuffer,
+                                        TaskHandle_t * const pxCreatedTask )
+    {
+        TaskHandle_t xHandle = NULL;
+        TCB_t * pxTCB;
+        uint32_t ulDensity;
+        BaseType_t xReturn;
+
+        configASSERT( pxEdfParameters );
+        configASSERT( pxEdfParameters->xPeriod > ( TickType_t ) 0U );
+        configASSERT( pxEdfParameters->xBudget > ( TickType_t ) 0U );
+        configASSERT( ( pxEdfParameters->xDeadline > ( TickType_t ) 0U ) && ( pxEdfParameters->xDeadline <= pxEdfParameters->xPeriod ) );
+
+        /* With deadlines no longer than the periods, the task set can be
+         * scheduled when the budgets over the deadlines sum to 1 at most. */
+        ulDensity = ( uint32_t ) ( ( ( ( uint64_t ) pxEdfParameters->xBudget * taskEDF_PPM ) + pxEdfParameters->xDeadline - 1U ) / pxEdfParameters->xDeadline );
+
+        /* Neither is the new task switched in nor can another task be
+         * admitted until its parameters are set. */
+        vTaskSuspendAll();
+        {
+            if( ( ( uint64_t ) ulEdfDensity + ulDensity ) > ( ( uint64_t ) configEDF_UTILISATION_LIMIT * ( taskEDF_PPM / 100UL ) ) )
+            {
+                traceTASK_CREATE_FAILED();
+                xReturn = pdFAIL;
+            }
+            else
+            {
+            #if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+                if( pxTaskBuffer != NULL )
+                {
+                    xHandle = xTaskCreateStatic( pxTaskCode, pcName, ( uint32_t ) usStackDepth, pvParameters, configEDF_PRIORITY, puxStackBuffer, pxTaskBuffer );
+                    xReturn = ( xHandle != NULL ) ? pdPASS : pdFAIL;
+                }
+                else
+            #endif
+                {
+                    #if ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+                        xReturn = xTaskCreate( pxTaskCode, pcName, usStackDepth, pvParameters, configEDF_PRIORITY, &xHandle );
+                    #else
+                        xReturn = pdFAIL;
+                    #endif
+                }
+            }
+
+            if( xReturn == pdPASS )
+            {
+                pxTCB = xHandle;
+
+                taskENTER_CRITICAL();
+                {
+                    ulEdfDensity += ulDensity;
+                    pxTCB->ulEdfDensity = ulDensity;
+                    pxTCB->xEdfPeriod = pxEdfParameters->xPeriod;
+                    pxTCB->xEdfDeadline = pxEdfParameters->xDeadline;
+                    pxTCB->xEdfBudget = pxEdfParameters->xBudget;
+                    pxTCB->xEdfRelease = xTickCount;
+                    pxTCB->xEdfAbsoluteDeadline = pxTCB->xEdfRelease + pxTCB->xEdfDeadline;
+
+                    /* Move the task to the place of its first deadline. */
+                    ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                    prvAddTaskToReadyList( pxTCB );
+
+                    if( ( xSchedulerRunning == pdFALSE ) && ( pxCurrentTCB->uxPriority == ( UBaseType_t ) configEDF_PRIORITY ) )
+                    {
+                        /* The scheduler starts the earliest deadline. */
+                        pxCurrentTCB = listGET_OWNER_OF_HEAD_ENTRY( &( pxReadyTasksLists[ configEDF_PRIORITY ] ) ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too. */
+                    }
+                }
+                taskEXIT_CRITICAL();
+
+                if( pxCreatedTask != NULL )
+                {
+                    *pxCreatedTask = xHandle;
+                }
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        return xReturn;
+    }
+/*-----------------------------------------------------------*/
+
+    #if ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+        BaseType_t xTaskCreateEdf( TaskFunction_t pxTaskCode,
+                                   const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                   const configSTACK_DEPTH_TYPE usStackDepth,
+                                   void * const pvParameters,
+                                   const TaskEdfParameters_t * const pxEdfParameters,
+                                   TaskHandle_t * const pxCreatedTask )
+        {
+            return prvCreateEdfTask( pxTaskCode, pcName, usStackDepth, pvParameters, pxEdfParameters, NULL, NULL, pxCreatedTask );
+        }
+
+    #endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+    #if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+
+        BaseType_t xTaskCreateEdfStatic( TaskFunction_t pxTaskCode,
+                                         const char * const pcName, /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+                                         const uint32_t ulStackDepth,
+                                         void * const pvParameters,
+                                         const TaskEdfParameters_t * const pxEdfParameters,
+                                         StackType_t * const puxStackBuffer,
+                                         StaticTask_t * const pxTaskBuffer,
+                                         TaskHandle_t * const pxCreatedTask )
+        {
+            configASSERT( puxStackBuffer != NULL );
+            configASSERT( pxTaskBuffer != NULL );
+
+            return prvCreateEdfTask( pxTaskCode, pcName, ( configSTACK_DEPTH_TYPE ) ulStackDepth, pvParameters, pxEdfParameters, puxStackBuffer, pxTaskBuffer, pxCreatedTask );
+        }
+
+    #endif /* configSUPPORT_STATIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+    BaseType_t xTaskEdfWaitForNextPeriod( void )
+    {
+        TCB_t * pxTCB;
+        TickType_t xConstTickCount, xNextRelease;
+        BaseType_t xDeadlineMet, xAlreadyYielded;
+
+        vTaskSuspendAll();
+        {
+            pxTCB = pxCurrentTCB;
+            configASSERT( pxTCB->xEdfPeriod != ( TickType_t ) 0U );
+
+            /* The tick count cannot change while the scheduler is suspended. */
+            xConstTickCount = xTickCount;
+            pxTCB->ulEdfJobs++;
+
+            /* A job ending in the tick of its deadline has missed it. */
+            xDeadlineMet = taskEDF_IS_LATER( pxTCB->xEdfAbsoluteDeadline, xConstTickCount ) ? pdTRUE : pdFALSE;
+
+            if( xDeadlineMet == pdFALSE )
+            {
+                pxTCB->ulEdfDeadlineMisses++;
+
+                if( ( TickType_t ) ( xConstTickCount - pxTCB->xEdfAbsoluteDeadline ) > pxTCB->xEdfMaxLateness )
+                {
+                    pxTCB->xEdfMaxLateness = xConstTickCount - pxTCB->xEdfAbsoluteDeadline;
+                }
+            }
+
+            xNextRelease = pxTCB->xEdfRelease + pxTCB->xEdfPeriod;
+            pxTCB->xEdfRelease = xNextRelease;
+            pxTCB->xEdfAbsoluteDeadline = xNextRelease + pxTCB->xEdfDeadline;
+            pxTCB->xEdfUsed = ( TickType_t ) 0U;
+
+            if( taskEDF_IS_LATER( xNextRelease, xConstTickCount ) )
+            {
+                traceTASK_DELAY_UNTIL( xNextRelease );
+                prvAddCurrentTaskToDelayedList( xNextRelease - xConstTickCount, pdFALSE );
+            }
+            else
+            {
+                /* The next job is released already, it waits behind the jobs
+                 * of earlier deadline.  Releases are not skipped, a task late
+                 * by more than a period catches up. */
+                taskENTER_CRITICAL();
+                {
+                    ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                    prvAddTaskToReadyList( pxTCB );
+                }
+                taskEXIT_CRITICAL();
+            }
+        }
+        xAlreadyYielded = xTaskResumeAll();
+
+        if( xAlreadyYielded == pdFALSE )
+        {
+            portYIELD_WITHIN_API();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        return xDeadlineMet;
+    }
+/*-----------------------------------------------------------*/
+
+    void vTaskEdfGetStats( TaskHandle_t xTask,
+                           TaskEdfStats_t * pxStats )
+    {
+        const TCB_t * pxTCB;
+
+        configASSERT( pxStats );
+
+        taskENTER_CRITICAL();
+        {
+            pxTCB = prvGetTCBFromHandle( xTask );
+            pxStats->ulJobs = pxTCB->ulEdfJobs;
+            pxStats->ulDeadlineMisses = pxTCB->ulEdfDeadlineMisses;
+            pxStats->ulBudgetOverruns = pxTCB->ulEdfBudgetOverruns;
+            pxStats->xMaxLateness = pxTCB->xEdfMaxLateness;
+            pxStats->ulDensity = pxTCB->ulEdfDensity;
+        }
+        taskEXIT_CRITICAL();
+    }
+
+#endif /* configUSE_EDF_SCHEDULING */
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskIncrementTick( void )
+{
+    TCB_t * pxTCB;
+    TickType_t xItemValue;
+    BaseType_t xSwitchRequired = pdFALSE;
+
+    #if ( configNUMBER_OF_CORES > 1 )
+        UBaseType_t uxSavedInterruptStatus;
+
+        /* Only one core handles the tick, but the other cores change the
+         * lists too. */
+        uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+    #endif
+
+    /* Called by the portable layer each time a tick interrupt occurs.
+     * Increments the tick then checks to see if the new tick value will cause any
+     * tasks to be unblocked. */
+    traceTASK_INCREMENT_TICK( xTickCount );
+
+    if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
+    {
+        /* Minor optimisation.  The tick count cannot change in this
+         * block. */
+        const TickType_t xConstTickCount = xTickCount + ( TickType_t ) 1;
+
+        /* Increment the RTOS tick, switching the delayed and overflowed
+         * delayed lists if it wraps to 0. */
+        xTickCount = xConstTickCount;
+
+        if( xConstTickCount == ( TickType_t ) 0U ) /*lint !e774 'if' does not always evaluate to false as it is looking for an overflow. */
+        {
+            taskSWITCH_DELAYED_LISTS();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        /* See if this tick has made a timeout expire.  Tasks are stored in
+         * the  queue in the order of their wake time - meaning once one task
+         * has been found whose block time has not expired there is no need to
+         * look any further down the list. */
+        if( xConstTickCount >= xNextTaskUnblockTime )
+        {
+            for( ; ; )
+            {
+                if( listLIST_IS_EMPTY( pxDelayedTaskList ) != pdFALSE )
+                {
+                    /* The delayed list is empty.  Set xNextTaskUnblockTime
+                     * to the maximum possible value so it is extremely
+                     * unlikely that the
+                     * if( xTickCount >= xNextTaskUnblockTime ) test will pass
+                     * next time through. */
+                    xNextTaskUnblockTime = portMAX_DELAY; /*lint !e961 MISRA exception as the casts are only redundant for some ports. */
+                    break;
                 }
                 else
                 {
@@ -2819,7 +3630,7 @@ BaseType_t xTaskIncrementTick( void )
                          * processing time (which happens when both
                          * preemption and time slicing are on) is
                          * handled below.*/
-                        if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                        if( taskMUST_PREEMPT( pxTCB ) )
                         {
                             xSwitchRequired = pdTRUE;
                         }
@@ -2833,12 +3644,33 @@ BaseType_t xTaskIncrementTick( void )
             }
         }
 
+        #if ( configUSE_EDF_SCHEDULING == 1 )
+        {
+            /* The tick is charged to the job running when it occurs, an
+             * overrun is counted once per job. */
+            if( pxCurrentTCB->xEdfPeriod != ( TickType_t ) 0U )
+            {
+                pxCurrentTCB->xEdfUsed++;
+
+                if( pxCurrentTCB->xEdfUsed == ( TickType_t ) ( pxCurrentTCB->xEdfBudget + 1U ) )
+                {
+                    pxCurrentTCB->ulEdfBudgetOverruns++;
+                }
+            }
+        }
+        #endif /* configUSE_EDF_SCHEDULING */
+
         /* Tasks of equal priority to the currently running task will share
          * processing time (time slice) if preemption is on, and the application
-         * writer has not explicitly turned time slicing off. */
-        #if ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) )
+         * writer has not explicitly turned time slicing off.  The EDF tasks
+         * run in deadline order instead. */
+        #if ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) && ( configNUMBER_OF_CORES == 1 ) )
         {
-            if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ) ) > ( UBaseType_t ) 1 )
+            if( ( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ) ) > ( UBaseType_t ) 1 )
+                #if ( configUSE_EDF_SCHEDULING == 1 )
+                    && ( pxCurrentTCB->uxPriority != ( UBaseType_t ) configEDF_PRIORITY )
+                #endif
+                )
             {
                 xSwitchRequired = pdTRUE;
             }
@@ -2847,6 +3679,37 @@ BaseType_t xTaskIncrementTick( void )
                 mtCOVERAGE_TEST_MARKER();
             }
         }
+        #elif ( ( configUSE_TIME_SLICING == 1 ) && ( configNUMBER_OF_CORES > 1 ) )
+        {
+            BaseType_t xCoreID, xOtherCoreID;
+            UBaseType_t uxPriority, uxRunning;
+
+            /* A core shares its time slice when more tasks are ready at its
+             * priority than there are cores running that priority.  A yield
+             * of this core sets xYieldPending, checked below. */
+            for( xCoreID = 0; xCoreID < ( BaseType_t ) configNUMBER_OF_CORES; xCoreID++ )
+            {
+                uxPriority = pxCurrentTCBs[ xCoreID ]->uxPriority;
+                uxRunning = 0;
+
+                for( xOtherCoreID = 0; xOtherCoreID < ( BaseType_t ) configNUMBER_OF_CORES; xOtherCoreID++ )
+                {
+                    if( pxCurrentTCBs[ xOtherCoreID ]->uxPriority == uxPriority )
+                    {
+                        uxRunning++;
+                    }
+                }
+
+                if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ uxPriority ] ) ) > uxRunning )
+                {
+                    prvYieldCore( xCoreID );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+        }
         #endif /* ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) ) */
 
         #if ( configUSE_TICK_HOOK == 1 )
@@ -2890,6 +3753,10 @@ BaseType_t xTaskIncrementTick( void )
         #endif
     }
 
+    #if ( configNUMBER_OF_CORES > 1 )
+        taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+    #endif
+
     return xSwitchRequired;
 }
 /*-----------------------------------------------------------*/
@@ -2956,58 +3823,248 @@ BaseType_t xTaskIncrementTick( void )
         TaskHookFunction_t xReturn;
         UBaseType_t uxSavedInterruptStatus;
 
-        /* If xTask is NULL then set the calling task's hook. */
-        pxTCB = prvGetTCBFromHandle( xTask );
+        /* If xTask is NULL then set the calling task's hook. */
+        pxTCB = prvGetTCBFromHandle( xTask );
+
+        /* Save the hook function in the TCB.  A critical section is required as
+         * the value can be accessed from an interrupt. */
+        uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+        {
+            xReturn = pxTCB->pxTaskTag;
+        }
+        portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+        return xReturn;
+    }
+
+#endif /* configUSE_APPLICATION_TASK_TAG */
+/*-----------------------------------------------------------*/
+
+#if ( configUSE_APPLICATION_TASK_TAG == 1 )
+
+    BaseType_t xTaskCallApplicationTaskHook( TaskHandle_t xTask,
+                                             void * pvParameter )
+    {
+        TCB_t * xTCB;
+        BaseType_t xReturn;
+
+        /* If xTask is NULL then we are calling our own task hook. */
+        if( xTask == NULL )
+        {
+            xTCB = pxCurrentTCB;
+        }
+        else
+        {
+            xTCB = xTask;
+        }
+
+        if( xTCB->pxTaskTag != NULL )
+        {
+            xReturn = xTCB->pxTaskTag( pvParameter );
+        }
+        else
+        {
+            xReturn = pdFAIL;
+        }
+
+        return xReturn;
+    }
+
+#endif /* configUSE_APPLICATION_TASK_TAG */
+/*-----------------------------------------------------------*/
+
+#if ( configNUMBER_OF_CORES > 1 )
+
+    static void prvSelectHighestPriorityTask( BaseType_t xCoreID )
+    {
+        TCB_t * const pxPreviousTCB = pxCurrentTCBs[ xCoreID ];
+        TCB_t * pxTCB = NULL;
+        TCB_t * pxCandidateTCB;
+        List_t * pxList;
+        ListItem_t * pxItem;
+        UBaseType_t uxPriority = ( UBaseType_t ) configMAX_PRIORITIES;
+        UBaseType_t uxSteps;
+        const UBaseType_t uxCoreBit = ( UBaseType_t ) 1U << xCoreID;
+
+        while( ( pxTCB == NULL ) && ( uxPriority > ( UBaseType_t ) 0U ) )
+        {
+            uxPriority--;
+            pxList = &( pxReadyTasksLists[ uxPriority ] );
+
+            /* Walk the whole ring once, starting after the task this core ran
+             * last if it is still in this list, else after the task chosen
+             * last at this priority, so that tasks of equal priority take
+             * turns as with listGET_OWNER_OF_NEXT_ENTRY().  Starting from the
+             * shared index alone, a core that rescheduled in between can leave
+             * it just before the task this core runs, which then always wins
+             * over a task only this core may run.  Tasks running on another
+             * core and tasks this core may not run are passed over. */
+            if( ( pxPreviousTCB != NULL ) &&
+                ( listIS_CONTAINED_WITHIN( pxList, &( pxPreviousTCB->xStateListItem ) ) != pdFALSE ) )
+            {
+                pxItem = &( pxPreviousTCB->xStateListItem );
+            }
+            else
+            {
+                pxItem = pxList->pxIndex;
+            }
+
+            for( uxSteps = listCURRENT_LIST_LENGTH( pxList ) + ( UBaseType_t ) 1U; uxSteps > ( UBaseType_t ) 0U; uxSteps-- )
+            {
+                pxItem = listGET_NEXT( pxItem );
+
+                if( pxItem == listGET_END_MARKER( pxList ) )
+                {
+                    continue;
+                }
+
+                pxCandidateTCB = listGET_LIST_ITEM_OWNER( pxItem ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too. */
+
+                if( ( ( pxCandidateTCB->xTaskRunState == taskTASK_NOT_RUNNING ) || ( pxCandidateTCB->xTaskRunState == xCoreID ) ) &&
+                    ( ( pxCandidateTCB->uxCoreAffinityMask & uxCoreBit ) != 0U ) )
+                {
+                    pxList->pxIndex = pxItem;
+                    pxTCB = pxCandidateTCB;
+                    break;
+                }
+            }
+        }
+
+        /* The idle task of the core can always run. */
+        configASSERT( pxTCB != NULL );
+
+        if( pxTCB != pxPreviousTCB )
+        {
+            if( pxPreviousTCB != NULL )
+            {
+                pxPreviousTCB->xTaskRunState = taskTASK_NOT_RUNNING;
+            }
+
+            pxTCB->xTaskRunState = xCoreID;
+            pxCurrentTCBs[ xCoreID ] = pxTCB;
+
+            /* The task switched out may still be ready, and of a higher
+             * priority than the task running on another core. */
+            if( ( pxPreviousTCB != NULL ) &&
+                ( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxPreviousTCB->uxPriority ] ), &( pxPreviousTCB->xStateListItem ) ) != pdFALSE ) )
+            {
+                ( void ) prvYieldForTask( pxPreviousTCB );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static BaseType_t prvYieldForTask( const TCB_t * pxTCB )
+    {
+        const BaseType_t xThisCoreID = portGET_CORE_ID();
+        BaseType_t xCoreID, xLowestCoreID = -1;
+        BaseType_t xReturn = pdFALSE;
+        UBaseType_t uxLowestPriority = pxTCB->uxPriority;
+        UBaseType_t uxPriority, uxSavedInterruptStatus;
+
+        /* The ISR lock is recursive, so this can also be called with only the
+         * scheduler suspended. */
+        uxSavedInterruptStatus = portSET_CORE_INTERRUPT_MASK();
+        portGET_ISR_LOCK();
+
+        if( ( xSchedulerRunning != pdFALSE ) && ( taskTASK_IS_RUNNING( pxTCB ) == pdFALSE ) )
+        {
+            for( xCoreID = 0; xCoreID < ( BaseType_t ) configNUMBER_OF_CORES; xCoreID++ )
+            {
+                /* A core that is already going to reschedule will consider
+                 * the task anyway. */
+                if( ( ( pxTCB->uxCoreAffinityMask & ( ( UBaseType_t ) 1U << xCoreID ) ) == 0U ) ||
+                    ( xYieldPendings[ xCoreID ] != pdFALSE ) )
+                {
+                    continue;
+                }
+
+                /* Of the cores running a lower priority task, prefer the one
+                 * running the lowest, and this core on a tie. */
+                uxPriority = pxCurrentTCBs[ xCoreID ]->uxPriority;
 
-        /* Save the hook function in the TCB.  A critical section is required as
-         * the value can be accessed from an interrupt. */
-        uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+                if( ( uxPriority < uxLowestPriority ) ||
+                    ( ( uxPriority == uxLowestPriority ) && ( xLowestCoreID >= 0 ) && ( xCoreID == xThisCoreID ) ) )
+                {
+                    uxLowestPriority = uxPriority;
+                    xLowestCoreID = xCoreID;
+                }
+            }
+
+            if( xLowestCoreID >= 0 )
+            {
+                prvYieldCore( xLowestCoreID );
+                xReturn = ( xLowestCoreID == xThisCoreID ) ? pdTRUE : pdFALSE;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
         {
-            xReturn = pxTCB->pxTaskTag;
+            mtCOVERAGE_TEST_MARKER();
         }
-        portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+        portRELEASE_ISR_LOCK();
+        portCLEAR_CORE_INTERRUPT_MASK( uxSavedInterruptStatus );
 
         return xReturn;
     }
-
-#endif /* configUSE_APPLICATION_TASK_TAG */
 /*-----------------------------------------------------------*/
 
-#if ( configUSE_APPLICATION_TASK_TAG == 1 )
-
-    BaseType_t xTaskCallApplicationTaskHook( TaskHandle_t xTask,
-                                             void * pvParameter )
+    static void prvYieldCore( BaseType_t xCoreID )
     {
-        TCB_t * xTCB;
-        BaseType_t xReturn;
+        UBaseType_t uxSavedInterruptStatus;
 
-        /* If xTask is NULL then we are calling our own task hook. */
-        if( xTask == NULL )
-        {
-            xTCB = pxCurrentTCB;
-        }
-        else
+        uxSavedInterruptStatus = portSET_CORE_INTERRUPT_MASK();
+        portGET_ISR_LOCK();
+
+        if( xCoreID == portGET_CORE_ID() )
         {
-            xTCB = xTask;
+            /* Carried out at the end of the interrupt, critical section or
+             * scheduler suspension the caller is in. */
+            xYieldPendings[ xCoreID ] = pdTRUE;
         }
-
-        if( xTCB->pxTaskTag != NULL )
+        else if( xYieldPendings[ xCoreID ] == pdFALSE )
         {
-            xReturn = xTCB->pxTaskTag( pvParameter );
+            /* Cleared when the core reschedules, so it is interrupted once. */
+            xYieldPendings[ xCoreID ] = pdTRUE;
+            portYIELD_CORE( xCoreID );
         }
         else
         {
-            xReturn = pdFAIL;
+            mtCOVERAGE_TEST_MARKER();
         }
 
-        return xReturn;
+        portRELEASE_ISR_LOCK();
+        portCLEAR_CORE_INTERRUPT_MASK( uxSavedInterruptStatus );
     }
 
-#endif /* configUSE_APPLICATION_TASK_TAG */
+#endif /* configNUMBER_OF_CORES */
 /*-----------------------------------------------------------*/
 
 void vTaskSwitchContext( void )
 {
+    #if ( configNUMBER_OF_CORES > 1 )
+        const BaseType_t xCoreID = portGET_CORE_ID();
+
+        /* Called with interrupts disabled.  Waits while another core has the
+         * scheduler suspended.  A task never switches out inside a critical
+         * section, its yields are pending until it leaves it. */
+        portGET_TASK_LOCK();
+        portGET_ISR_LOCK();
+        configASSERT( portGET_CRITICAL_NESTING_COUNT() == 0 );
+    #endif
+
     if( uxSchedulerSuspended != ( UBaseType_t ) pdFALSE )
     {
         /* The scheduler is currently suspended - do not allow a context
@@ -3059,7 +4116,11 @@ void vTaskSwitchContext( void )
 
         /* Select a new task to run using either the generic C or port
          * optimised asm code. */
-        taskSELECT_HIGHEST_PRIORITY_TASK(); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+        #if ( configNUMBER_OF_CORES == 1 )
+            taskSELECT_HIGHEST_PRIORITY_TASK(); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+        #else
+            prvSelectHighestPriorityTask( xCoreID );
+        #endif
         traceTASK_SWITCHED_IN();
 
         /* After the new task is switched in, update the global errno. */
@@ -3077,6 +4138,11 @@ void vTaskSwitchContext( void )
         }
         #endif
     }
+
+    #if ( configNUMBER_OF_CORES > 1 )
+        portRELEASE_ISR_LOCK();
+        portRELEASE_TASK_LOCK();
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -3214,7 +4280,7 @@ BaseType_t xTaskRemoveFromEventList( const List_t * const pxEventList )
         listINSERT_END( &( xPendingReadyList ), &( pxUnblockedTCB->xEventListItem ) );
     }
 
-    if( pxUnblockedTCB->uxPriority > pxCurrentTCB->uxPriority )
+    if( taskMUST_PREEMPT( pxUnblockedTCB ) )
     {
         /* Return true if the task removed from the event list has a higher
          * priority than the calling task.  This allows the calling task to know if
@@ -3272,7 +4338,7 @@ void vTaskRemoveFromUnorderedEventList( ListItem_t * pxEventListItem,
     listREMOVE_ITEM( &( pxUnblockedTCB->xStateListItem ) );
     prvAddTaskToReadyList( pxUnblockedTCB );
 
-    if( pxUnblockedTCB->uxPriority > pxCurrentTCB->uxPriority )
+    if( taskMUST_PREEMPT( pxUnblockedTCB ) )
     {
         /* The unblocked task has a priority above that of the calling task, so
          * a context switch is required.  This function is called with the
@@ -3463,8 +4529,9 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
              * A critical region is not required here as we are just reading from
              * the list, and an occasional incorrect value will not matter.  If
              * the ready list at the idle priority contains more than one task
-             * then a task other than the idle task is ready to execute. */
-            if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( UBaseType_t ) 1 )
+             * per core then a task other than an idle task is ready to
+             * execute. */
+            if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( UBaseType_t ) configNUMBER_OF_CORES )
             {
                 taskYIELD();
             }
@@ -3541,6 +4608,43 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
 }
 /*-----------------------------------------------------------*/
 
+#if ( configNUMBER_OF_CORES > 1 )
+
+    static portTASK_FUNCTION( prvPassiveIdleTask, pvParameters )
+    {
+        /* Stop warnings. */
+        ( void ) pvParameters;
+
+        for( ; ; )
+        {
+            #if ( configIDLE_SHOULD_YIELD == 1 )
+            {
+                /* As in prvIdleTask(). */
+                if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( UBaseType_t ) configNUMBER_OF_CORES )
+                {
+                    taskYIELD();
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            #endif /* configIDLE_SHOULD_YIELD */
+
+            #if ( configUSE_PASSIVE_IDLE_HOOK == 1 )
+            {
+                extern void vApplicationPassiveIdleHook( void );
+
+                /* As vApplicationIdleHook(), it must not block. */
+                vApplicationPassiveIdleHook();
+            }
+            #endif /* configUSE_PASSIVE_IDLE_HOOK */
+        }
+    }
+
+#endif /* configNUMBER_OF_CORES */
+/*-----------------------------------------------------------*/
+
 #if ( configUSE_TICKLESS_IDLE != 0 )
 
     eSleepModeStatus eTaskConfirmSleepModeStatus( void )
@@ -3696,19 +4800,61 @@ static void prvCheckTasksWaitingTermination( void )
 
         /* uxDeletedTasksWaitingCleanUp is used to prevent taskENTER_CRITICAL()
          * being called too often in the idle task. */
-        while( uxDeletedTasksWaitingCleanUp > ( UBaseType_t ) 0U )
+        #if ( configNUMBER_OF_CORES == 1 )
         {
-            taskENTER_CRITICAL();
+            while( uxDeletedTasksWaitingCleanUp > ( UBaseType_t ) 0U )
             {
-                pxTCB = listGET_OWNER_OF_HEAD_ENTRY( ( &xTasksWaitingTermination ) ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
-                ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
-                --uxCurrentNumberOfTasks;
-                --uxDeletedTasksWaitingCleanUp;
+                taskENTER_CRITICAL();
+                {
+                    pxTCB = listGET_OWNER_OF_HEAD_ENTRY( ( &xTasksWaitingTermination ) ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+                    ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                    --uxCurrentNumberOfTasks;
+                    --uxDeletedTasksWaitingCleanUp;
+                }
+                taskEXIT_CRITICAL();
+
+                prvDeleteTCB( pxTCB );
             }
-            taskEXIT_CRITICAL();
+        }
+        #else /* configNUMBER_OF_CORES */
+        {
+            ListItem_t const * pxEnd;
+            ListItem_t * pxItem;
 
-            prvDeleteTCB( pxTCB );
+            /* A deleted task can still be running on the core that deleted it
+             * or was interrupted to switch away from it.  Only the tasks no
+             * core runs any more are freed. */
+            while( uxDeletedTasksWaitingCleanUp > ( UBaseType_t ) 0U )
+            {
+                pxTCB = NULL;
+
+                taskENTER_CRITICAL();
+                {
+                    pxEnd = listGET_END_MARKER( &xTasksWaitingTermination );
+
+                    for( pxItem = listGET_HEAD_ENTRY( &xTasksWaitingTermination ); pxItem != pxEnd; pxItem = listGET_NEXT( pxItem ) )
+                    {
+                        if( taskTASK_IS_RUNNING( ( TCB_t * ) listGET_LIST_ITEM_OWNER( pxItem ) ) == pdFALSE )
+                        {
+                            pxTCB = listGET_LIST_ITEM_OWNER( pxItem ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too. */
+                            ( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+                            --uxCurrentNumberOfTasks;
+                            --uxDeletedTasksWaitingCleanUp;
+                            break;
+                        }
+                    }
+                }
+                taskEXIT_CRITICAL();
+
+                if( pxTCB == NULL )
+                {
+                    break;
+                }
+
+                prvDeleteTCB( pxTCB );
+            }
         }
+        #endif /* configNUMBER_OF_CORES */
     }
     #endif /* INCLUDE_vTaskDelete */
 }
@@ -3761,7 +4907,7 @@ static void prvCheckTasksWaitingTermination( void )
          * state is just set to whatever is passed in. */
         if( eState != eInvalid )
         {
-            if( pxTCB == pxCurrentTCB )
+            if( taskTASK_IS_RUNNING( pxTCB ) )
             {
                 pxTaskStatus->eCurrentState = eRunning;
             }
@@ -4017,21 +5163,35 @@ static void prvResetNextTaskUnblockTime( void )
 }
 /*-----------------------------------------------------------*/
 
-#if ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) )
+#if ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) || ( configNUMBER_OF_CORES > 1 ) )
 
     TaskHandle_t xTaskGetCurrentTaskHandle( void )
     {
         TaskHandle_t xReturn;
 
-        /* A critical section is not required as this is not called from
-         * an interrupt and the current TCB will always be the same for any
-         * individual execution thread. */
-        xReturn = pxCurrentTCB;
+        #if ( configNUMBER_OF_CORES == 1 )
+        {
+            /* A critical section is not required as this is not called from
+             * an interrupt and the current TCB will always be the same for any
+             * individual execution thread. */
+            xReturn = pxCurrentTCB;
+        }
+        #else
+        {
+            UBaseType_t uxSavedInterruptStatus;
+
+            /* Interrupts are masked so the task cannot move to the other core
+             * between reading the core ID and reading its current task. */
+            uxSavedInterruptStatus = portSET_CORE_INTERRUPT_MASK();
+            xReturn = pxCurrentTCBs[ portGET_CORE_ID() ];
+            portCLEAR_CORE_INTERRUPT_MASK( uxSavedInterruptStatus );
+        }
+        #endif /* configNUMBER_OF_CORES */
 
         return xReturn;
     }
 
-#endif /* ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) ) */
+#endif /* ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) || ( configNUMBER_OF_CORES > 1 ) ) */
 /*-----------------------------------------------------------*/
 
 #if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
@@ -4313,6 +5473,21 @@ static void prvResetNextTaskUnblockTime( void )
                         }
 
                         prvAddTaskToReadyList( pxTCB );
+
+                        #if ( configNUMBER_OF_CORES > 1 )
+                        {
+                            /* The holder may be running on the other core, at
+                             * a priority that no longer entitles it to. */
+                            if( taskTASK_IS_RUNNING( pxTCB ) != pdFALSE )
+                            {
+                                prvYieldCore( pxTCB->xTaskRunState );
+                            }
+                            else
+                            {
+                                mtCOVERAGE_TEST_MARKER();
+                            }
+                        }
+                        #endif /* configNUMBER_OF_CORES */
                     }
                     else
                     {
@@ -4401,6 +5576,205 @@ static void prvResetNextTaskUnblockTime( void )
 #endif /* portCRITICAL_NESTING_IN_TCB */
 /*-----------------------------------------------------------*/
 
+#if ( configNUMBER_OF_CORES > 1 )
+
+    void vTaskEnterCritical( void )
+    {
+        portDISABLE_INTERRUPTS();
+
+        if( xSchedulerRunning != pdFALSE )
+        {
+            /* The outermost critical section takes both locks, so the other
+             * core can neither run kernel code nor an interrupt's FromISR
+             * call until it is left. */
+            if( portGET_CRITICAL_NESTING_COUNT() == 0U )
+            {
+                portGET_TASK_LOCK();
+                portGET_ISR_LOCK();
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            portINCREMENT_CRITICAL_NESTING_COUNT();
+
+            /* As in the single core version, only assert on the outermost
+             * entry in case the assert function uses a critical section. */
+            if( portGET_CRITICAL_NESTING_COUNT() == 1U )
+            {
+                portASSERT_IF_IN_ISR();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    void vTaskExitCritical( void )
+    {
+        BaseType_t xYieldCurrentTask;
+
+        if( xSchedulerRunning != pdFALSE )
+        {
+            if( portGET_CRITICAL_NESTING_COUNT() > 0U )
+            {
+                portDECREMENT_CRITICAL_NESTING_COUNT();
+
+                if( portGET_CRITICAL_NESTING_COUNT() == 0U )
+                {
+                    /* A yield requested inside the critical section by
+                     * prvYieldCore() is carried out now, unless the scheduler
+                     * is suspended, in which case xTaskResumeAll() does it. */
+                    xYieldCurrentTask = ( ( xYieldPendings[ portGET_CORE_ID() ] != pdFALSE ) && ( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE ) ) ? pdTRUE : pdFALSE;
+
+                    portRELEASE_ISR_LOCK();
+                    portRELEASE_TASK_LOCK();
+                    portENABLE_INTERRUPTS();
+
+                    if( xYieldCurrentTask != pdFALSE )
+                    {
+                        portYIELD();
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    UBaseType_t uxTaskEnterCriticalFromISR( void )
+    {
+        UBaseType_t uxSavedInterruptStatus;
+
+        /* Only the ISR lock: the other core may be in a task with the
+         * scheduler suspended, which only holds the task lock. */
+        uxSavedInterruptStatus = portSET_CORE_INTERRUPT_MASK();
+        portGET_ISR_LOCK();
+
+        return uxSavedInterruptStatus;
+    }
+/*-----------------------------------------------------------*/
+
+    void vTaskExitCriticalFromISR( UBaseType_t uxSavedInterruptStatus )
+    {
+        portRELEASE_ISR_LOCK();
+        portCLEAR_CORE_INTERRUPT_MASK( uxSavedInterruptStatus );
+    }
+/*-----------------------------------------------------------*/
+
+    void vTaskYieldWithinAPI( void )
+    {
+        UBaseType_t uxSavedInterruptStatus, uxCriticalNesting;
+
+        uxSavedInterruptStatus = portSET_CORE_INTERRUPT_MASK();
+        uxCriticalNesting = portGET_CRITICAL_NESTING_COUNT();
+
+        /* The locks cannot be given up in the middle of a critical section,
+         * so a yield from inside one is left to vTaskExitCritical(). */
+        if( uxCriticalNesting > 0U )
+        {
+            xYieldPendings[ portGET_CORE_ID() ] = pdTRUE;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        portCLEAR_CORE_INTERRUPT_MASK( uxSavedInterruptStatus );
+
+        if( uxCriticalNesting == 0U )
+        {
+            portYIELD();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    void vTaskCoreAffinitySet( const TaskHandle_t xTask,
+                               UBaseType_t uxCoreAffinityMask )
+    {
+        TCB_t * pxTCB;
+
+        configASSERT( ( uxCoreAffinityMask & ( ( ( UBaseType_t ) 1U << configNUMBER_OF_CORES ) - 1U ) ) != 0U );
+
+        taskENTER_CRITICAL();
+        {
+            pxTCB = prvGetTCBFromHandle( xTask );
+            pxTCB->uxCoreAffinityMask = uxCoreAffinityMask;
+
+            if( xSchedulerRunning != pdFALSE )
+            {
+                if( taskTASK_IS_RUNNING( pxTCB ) != pdFALSE )
+                {
+                    /* Move the task off a core it may no longer run on. */
+                    if( ( uxCoreAffinityMask & ( ( UBaseType_t ) 1U << pxTCB->xTaskRunState ) ) == 0U )
+                    {
+                        prvYieldCore( pxTCB->xTaskRunState );
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+                }
+                else if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxTCB->uxPriority ] ), &( pxTCB->xStateListItem ) ) != pdFALSE )
+                {
+                    /* A ready task may now be allowed on a core running a
+                     * lower priority task. */
+                    ( void ) prvYieldForTask( pxTCB );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+/*-----------------------------------------------------------*/
+
+    UBaseType_t uxTaskCoreAffinityGet( const TaskHandle_t xTask )
+    {
+        const TCB_t * pxTCB;
+        UBaseType_t uxCoreAffinityMask;
+
+        taskENTER_CRITICAL();
+        {
+            pxTCB = prvGetTCBFromHandle( xTask );
+            uxCoreAffinityMask = pxTCB->uxCoreAffinityMask;
+        }
+        taskEXIT_CRITICAL();
+
+        return uxCoreAffinityMask;
+    }
+
+#endif /* configNUMBER_OF_CORES */
+/*-----------------------------------------------------------*/
+
 #if ( configUSE_STATS_FORMATTING_FUNCTIONS > 0 )
 
     static char * prvWriteNameToBuffer( char * pcBuffer,
@@ -4943,7 +6317,7 @@ TickType_t uxTaskResetEventItemValue( void )
                 }
                 #endif
 
-                if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                if( taskMUST_PREEMPT( pxTCB ) )
                 {
                     /* The notified task has a priority above the currently
                      * executing task so a yield is required. */
@@ -5078,7 +6452,7 @@ TickType_t uxTaskResetEventItemValue( void )
                     listINSERT_END( &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
                 }
 
-                if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                if( taskMUST_PREEMPT( pxTCB ) )
                 {
                     /* The notified task has a priority above the currently
                      * executing task so a yield is required. */
@@ -5169,7 +6543,7 @@ TickType_t uxTaskResetEventItemValue( void )
                     listINSERT_END( &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
                 }
 
-                if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+                if( taskMUST_PREEMPT( pxTCB ) )
                 {
                     /* The notified task has a priority above the currently
                      * executing task so a yield is required. */
@@ -0,0 +1,709 @@
+/*
+ * FreeRTOS Kernel V10.5.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * A two pool variant of heap_4.c for the Zynq-7000 port.  The heap is split
+ * into a "fast" pool that lives in the low latency on-chip memory (OCM) and a
+ * "bulk" pool that lives in DDR.  Each pool is managed exactly like heap_4.c -
+ * free blocks are kept in address order and adjacent blocks are coalesced as
+ * they are freed - but the pools never share blocks.
+ *
+ * pvPortMalloc() and pvPortMallocBulk() allocate from DDR.  pvPortMallocFast()
+ * allocates from OCM and falls back to DDR if the OCM pool is exhausted; the
+ * number of such fallbacks is recorded in the per pool statistics and each one
+ * is reported through traceMALLOC_FALLBACK().  vPortFree()
+ * works out which pool a block belongs to from its address, so memory obtained
+ * from any of the allocation functions can be freed with vPortFree().
+ *
+ * The OCM pool is placed in the configFAST_HEAP_SECTION linker section, which
+ * the application linker script must map onto OCM (ps7_ram_0).
+ *
+ * See heap_4.c and heap_5.c for the single pool implementations, and the
+ * memory management pages of https://www.FreeRTOS.org for more information.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+ * all the API functions to use the MPU wrappers.  That should only be done when
+ * task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* The BSP library compiles every source file, in a static only build
+ * (configSUPPORT_DYNAMIC_ALLOCATION 0) this one is left empty so neither the
+ * pools nor the allocator end up in the image. */
+#if ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+#if ( configUSE_FAST_HEAP == 0 )
+    #error This file must not be used if configUSE_FAST_HEAP is 0, use heap_4.c instead
+#endif
+
+#if ( configSTACK_ALLOCATION_FROM_SEPARATE_HEAP == 1 ) && ( configUSE_STACK_GUARD_PAGES == 0 )
+    #error Task stacks are placed by heap_6.c unless portStackGuard.c allocates them, configSTACK_ALLOCATION_FROM_SEPARATE_HEAP must be 0
+#endif
+
+#ifndef configFAST_HEAP_SECTION
+    #define configFAST_HEAP_SECTION    ".ocm_heap"
+#endif
+
+#ifndef configHEAP_CLEAR_MEMORY_ON_FREE
+    #define configHEAP_CLEAR_MEMORY_ON_FREE    0
+#endif
+
+/* Called with the block a pvPortMallocFast() request got from DDR instead. */
+#ifndef traceMALLOC_FALLBACK
+    #define traceMALLOC_FALLBACK( pvAddress, xSize )
+#endif
+
+/* Block sizes must not get too small. */
+#define heapMINIMUM_BLOCK_SIZE    ( ( size_t ) ( xHeapStructSize << 1 ) )
+
+/* Assumes 8bit bytes! */
+#define heapBITS_PER_BYTE         ( ( size_t ) 8 )
+
+/* Max value that fits in a size_t type. */
+#define heapSIZE_MAX              ( ~( ( size_t ) 0 ) )
+
+/* Check if multiplying a and b will result in overflow. */
+#define heapMULTIPLY_WILL_OVERFLOW( a, b )    ( ( ( a ) > 0 ) && ( ( b ) > ( heapSIZE_MAX / ( a ) ) ) )
+
+/* Check if adding a and b will result in overflow. */
+#define heapADD_WILL_OVERFLOW( a, b )         ( ( a ) > ( heapSIZE_MAX - ( b ) ) )
+
+/* MSB of the xBlockSize member of an BlockLink_t structure is used to track
+ * the allocation status of a block.  When MSB of the xBlockSize member of
+ * an BlockLink_t structure is set then the block belongs to the application.
+ * When the bit is free the block is still part of the free heap space. */
+#define heapBLOCK_ALLOCATED_BITMASK    ( ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 ) )
+#define heapBLOCK_SIZE_IS_VALID( xBlockSize )    ( ( ( xBlockSize ) & heapBLOCK_ALLOCATED_BITMASK ) == 0 )
+#define heapBLOCK_IS_ALLOCATED( pxBlock )        ( ( ( pxBlock->xBlockSize ) & heapBLOCK_ALLOCATED_BITMASK ) != 0 )
+#define heapALLOCATE_BLOCK( pxBlock )            ( ( pxBlock->xBlockSize ) |= heapBLOCK_ALLOCATED_BITMASK )
+#define heapFREE_BLOCK( pxBlock )                ( ( pxBlock->xBlockSize ) &= ~heapBLOCK_ALLOCATED_BITMASK )
+
+/*-----------------------------------------------------------*/
+
+/* Allocate the memory for the heap.  The bulk (DDR) pool is the traditional
+ * ucHeap array so configAPPLICATION_ALLOCATED_HEAP keeps its usual meaning. */
+#if ( configAPPLICATION_ALLOCATED_HEAP == 1 )
+    extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#else
+    PRIVILEGED_DATA static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#endif /* configAPPLICATION_ALLOCATED_HEAP */
+
+PRIVILEGED_DATA static uint8_t ucFastHeap[ configFAST_HEAP_SIZE ] __attribute__( ( section( configFAST_HEAP_SECTION ), aligned( portBYTE_ALIGNMENT ) ) );
+
+/* Define the linked list structure.  This is used to link free blocks in order
+ * of their memory address. */
+typedef struct A_BLOCK_LINK
+{
+    struct A_BLOCK_LINK * pxNextFreeBlock; /*<< The next free block in the list. */
+    size_t xBlockSize;                     /*<< The size of the free block. */
+} BlockLink_t;
+
+/* Everything heap_4.c keeps in file scope variables is kept per pool. */
+typedef struct HEAP_POOL
+{
+    BlockLink_t xStart;                     /*<< Marks the start of the free list. */
+    BlockLink_t * pxEnd;                    /*<< Marks the end of the free list, placed at the end of the pool. */
+    uint8_t * pucPoolStart;                 /*<< First byte of the backing array, used to find the owner of a block. */
+    uint8_t * pucPoolEnd;                   /*<< One past the last byte of the backing array. */
+    size_t xFreeBytesRemaining;
+    size_t xMinimumEverFreeBytesRemaining;
+    size_t xNumberOfSuccessfulAllocations;
+    size_t xNumberOfSuccessfulFrees;
+    size_t xNumberOfFallbacks;              /*<< Requests for this pool that had to be served by another pool. */
+} HeapPool_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Inserts a block of memory that is being freed into the correct position in
+ * the list of free memory blocks of pxPool.  The block being freed will be
+ * merged with the block in front it and/or the block behind it if the memory
+ * blocks are adjacent to each other.
+ */
+static void prvInsertBlockIntoFreeList( HeapPool_t * pxPool,
+                                        BlockLink_t * pxBlockToInsert ) PRIVILEGED_FUNCTION;
+
+/*
+ * Called automatically to setup the free lists of both pools the first time
+ * any allocation function is called.
+ */
+static void prvHeapInit( void ) PRIVILEGED_FUNCTION;
+
+/*
+ * Sets up the free list of a single pool over the given array.
+ */
+static void prvPoolInit( HeapPool_t * pxPool,
+                         uint8_t * pucPool,
+                         size_t xPoolSize ) PRIVILEGED_FUNCTION;
+
+/*
+ * Allocates from a single pool.  Must be called with the scheduler suspended.
+ * xWantedSize already includes the block header and alignment padding.
+ */
+static void * prvPoolAllocate( HeapPool_t * pxPool,
+                               size_t xWantedSize ) PRIVILEGED_FUNCTION;
+
+/*
+ * Common implementation of the pvPortMalloc*() family.  ePreferredPool is
+ * tried first, then the bulk pool if that is different.
+ */
+static void * prvHeapAllocate( eHeapPool ePreferredPool,
+                               size_t xWantedSize ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+/* The size of the structure placed at the beginning of each allocated memory
+ * block must by correctly byte aligned. */
+static const size_t xHeapStructSize = ( sizeof( BlockLink_t ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* The pools, indexed by eHeapPool. */
+PRIVILEGED_DATA static HeapPool_t xPools[ eHeapPoolCount ];
+
+/* Set once prvHeapInit() has run. */
+PRIVILEGED_DATA static BaseType_t xHeapHasBeenInitialised = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static void * prvPoolAllocate( HeapPool_t * pxPool,
+                               size_t xWantedSize )
+{
+    BlockLink_t * pxBlock;
+    BlockLink_t * pxPreviousBlock;
+    BlockLink_t * pxNewBlockLink;
+    void * pvReturn = NULL;
+
+    if( ( xWantedSize > 0 ) && ( xWantedSize <= pxPool->xFreeBytesRemaining ) )
+    {
+        /* Traverse the list from the start (lowest address) block until
+         * one of adequate size is found. */
+        pxPreviousBlock = &( pxPool->xStart );
+        pxBlock = pxPool->xStart.pxNextFreeBlock;
+
+        while( ( pxBlock->xBlockSize < xWantedSize ) && ( pxBlock->pxNextFreeBlock != NULL ) )
+        {
+            pxPreviousBlock = pxBlock;
+            pxBlock = pxBlock->pxNextFreeBlock;
+        }
+
+        /* If the end marker was reached then a block of adequate size
+         * was not found. */
+        if( pxBlock != pxPool->pxEnd )
+        {
+            /* Return the memory space pointed to - jumping over the
+             * BlockLink_t structure at its start. */
+            pvReturn = ( void * ) ( ( ( uint8_t * ) pxPreviousBlock->pxNextFreeBlock ) + xHeapStructSize );
+
+            /* This block is being returned for use so must be taken out
+             * of the list of free blocks. */
+            pxPreviousBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+
+            /* If the block is larger than required it can be split into
+             * two. */
+            if( ( pxBlock->xBlockSize - xWantedSize ) > heapMINIMUM_BLOCK_SIZE )
+            {
+                /* This block is to be split into two.  Create a new
+                 * block following the number of bytes requested. The void
+                 * cast is used to prevent byte alignment warnings from the
+                 * compiler. */
+                pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+                configASSERT( ( ( ( size_t ) pxNewBlockLink ) & portBYTE_ALIGNMENT_MASK ) == 0 );
+
+                /* Calculate the sizes of two blocks split from the
+                 * single block. */
+                pxNewBlockLink->xBlockSize = pxBlock->xBlockSize - xWantedSize;
+                pxBlock->xBlockSize = xWantedSize;
+
+                /* Insert the new block into the list of free blocks. */
+                prvInsertBlockIntoFreeList( pxPool, pxNewBlockLink );
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            pxPool->xFreeBytesRemaining -= pxBlock->xBlockSize;
+
+            if( pxPool->xFreeBytesRemaining < pxPool->xMinimumEverFreeBytesRemaining )
+            {
+                pxPool->xMinimumEverFreeBytesRemaining = pxPool->xFreeBytesRemaining;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+
+            /* The block is being returned - it is allocated and owned
+             * by the application and has no "next" block. */
+            heapALLOCATE_BLOCK( pxBlock );
+            pxBlock->pxNextFreeBlock = NULL;
+            pxPool->xNumberOfSuccessfulAllocations++;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void * prvHeapAllocate( eHeapPool ePreferredPool,
+                               size_t xWantedSize )
+{
+    void * pvReturn = NULL;
+    size_t xAdditionalRequiredSize;
+
+    vTaskSuspendAll();
+    {
+        /* If this is the first call to malloc then the heap will require
+         * initialisation to setup the list of free blocks. */
+        if( xHeapHasBeenInitialised == pdFALSE )
+        {
+            prvHeapInit();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        if( xWantedSize > 0 )
+        {
+            /* The wanted size must be increased so it can contain a BlockLink_t
+             * structure in addition to the requested amount of bytes. Some
+             * additional increment may also be needed for alignment. */
+            xAdditionalRequiredSize = xHeapStructSize + portBYTE_ALIGNMENT - ( xWantedSize & portBYTE_ALIGNMENT_MASK );
+
+            if( heapADD_WILL_OVERFLOW( xWantedSize, xAdditionalRequiredSize ) == 0 )
+            {
+                xWantedSize += xAdditionalRequiredSize;
+            }
+            else
+            {
+                xWantedSize = 0;
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        /* Check the block size we are trying to allocate is not so large that the
+         * top bit is set.  The top bit of the block size member of the BlockLink_t
+         * structure is used to determine who owns the block - the application or
+         * the kernel, so it must be free. */
+        if( heapBLOCK_SIZE_IS_VALID( xWantedSize ) != 0 )
+        {
+            pvReturn = prvPoolAllocate( &( xPools[ ePreferredPool ] ), xWantedSize );
+
+            if( ( pvReturn == NULL ) && ( ePreferredPool != eHeapPoolBulk ) && ( xWantedSize > 0 ) )
+            {
+                /* The preferred pool is exhausted.  Slower memory is better
+                 * than no memory, so try DDR and remember that it happened. */
+                pvReturn = prvPoolAllocate( &( xPools[ eHeapPoolBulk ] ), xWantedSize );
+
+                if( pvReturn != NULL )
+                {
+                    xPools[ ePreferredPool ].xNumberOfFallbacks++;
+                    traceMALLOC_FALLBACK( pvReturn, xWantedSize );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        traceMALLOC( pvReturn, xWantedSize );
+    }
+    ( void ) xTaskResumeAll();
+
+    #if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+    {
+        if( pvReturn == NULL )
+        {
+            vApplicationMallocFailedHook();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+    #endif /* if ( configUSE_MALLOC_FAILED_HOOK == 1 ) */
+
+    configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    return prvHeapAllocate( eHeapPoolBulk, xWantedSize );
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortMallocFast( size_t xWantedSize )
+{
+    return prvHeapAllocate( eHeapPoolFast, xWantedSize );
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortMallocBulk( size_t xWantedSize )
+{
+    return prvHeapAllocate( eHeapPoolBulk, xWantedSize );
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void * pv )
+{
+    uint8_t * puc = ( uint8_t * ) pv;
+    BlockLink_t * pxLink;
+    HeapPool_t * pxPool = NULL;
+    BaseType_t x;
+
+    if( pv != NULL )
+    {
+        /* Find the pool the block was allocated from. */
+        for( x = 0; x < ( BaseType_t ) eHeapPoolCount; x++ )
+        {
+            if( ( puc >= xPools[ x ].pucPoolStart ) && ( puc < xPools[ x ].pucPoolEnd ) )
+            {
+                pxPool = &( xPools[ x ] );
+                break;
+            }
+        }
+
+        configASSERT( pxPool != NULL );
+
+        /* The memory being freed will have an BlockLink_t structure immediately
+         * before it. */
+        puc -= xHeapStructSize;
+
+        /* This casting is to keep the compiler from issuing warnings. */
+        pxLink = ( void * ) puc;
+
+        configASSERT( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 );
+        configASSERT( pxLink->pxNextFreeBlock == NULL );
+
+        if( ( pxPool != NULL ) && ( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 ) )
+        {
+            if( pxLink->pxNextFreeBlock == NULL )
+            {
+                /* The block is being returned to the heap - it is no longer
+                 * allocated. */
+                heapFREE_BLOCK( pxLink );
+                #if ( configHEAP_CLEAR_MEMORY_ON_FREE == 1 )
+                {
+                    ( void ) memset( puc + xHeapStructSize, 0, pxLink->xBlockSize - xHeapStructSize );
+                }
+                #endif
+
+                vTaskSuspendAll();
+                {
+                    /* Add this block to the list of free blocks. */
+                    pxPool->xFreeBytesRemaining += pxLink->xBlockSize;
+                    traceFREE( pv, pxLink->xBlockSize );
+                    prvInsertBlockIntoFreeList( pxPool, ( ( BlockLink_t * ) pxLink ) );
+                    pxPool->xNumberOfSuccessfulFrees++;
+                }
+                ( void ) xTaskResumeAll();
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+    return xPools[ eHeapPoolFast ].xFreeBytesRemaining + xPools[ eHeapPoolBulk ].xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+    /* The minimums of the two pools may have been reached at different times,
+     * so this is a lower bound rather than an exact figure. */
+    return xPools[ eHeapPoolFast ].xMinimumEverFreeBytesRemaining + xPools[ eHeapPoolBulk ].xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+    /* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+void * pvPortCalloc( size_t xNum,
+                     size_t xSize )
+{
+    void * pv = NULL;
+
+    if( heapMULTIPLY_WILL_OVERFLOW( xNum, xSize ) == 0 )
+    {
+        pv = pvPortMalloc( xNum * xSize );
+
+        if( pv != NULL )
+        {
+            ( void ) memset( pv, 0, xNum * xSize );
+        }
+    }
+
+    return pv;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPoolInit( HeapPool_t * pxPool,
+                         uint8_t * pucPool,
+                         size_t xPoolSize ) /* PRIVILEGED_FUNCTION */
+{
+    BlockLink_t * pxFirstFreeBlock;
+    uint8_t * pucAlignedHeap;
+    portPOINTER_SIZE_TYPE uxAddress;
+    size_t xTotalHeapSize = xPoolSize;
+
+    pxPool->pucPoolStart = pucPool;
+    pxPool->pucPoolEnd = pucPool + xPoolSize;
+
+    /* Ensure the heap starts on a correctly aligned boundary. */
+    uxAddress = ( portPOINTER_SIZE_TYPE ) pucPool;
+
+    if( ( uxAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
+    {
+        uxAddress += ( portBYTE_ALIGNMENT - 1 );
+        uxAddress &= ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK );
+        xTotalHeapSize -= uxAddress - ( portPOINTER_SIZE_TYPE ) pucPool;
+    }
+
+    pucAlignedHeap = ( uint8_t * ) uxAddress;
+
+    /* xStart is used to hold a pointer to the first item in the list of free
+     * blocks.  The void cast is used to prevent compiler warnings. */
+    pxPool->xStart.pxNextFreeBlock = ( void * ) pucAlignedHeap;
+    pxPool->xStart.xBlockSize = ( size_t ) 0;
+
+    /* pxEnd is used to mark the end of the list of free blocks and is inserted
+     * at the end of the heap space. */
+    uxAddress = ( ( portPOINTER_SIZE_TYPE ) pucAlignedHeap ) + xTotalHeapSize;
+    uxAddress -= xHeapStructSize;
+    uxAddress &= ~( ( portPOINTER_SIZE_TYPE ) portBYTE_ALIGNMENT_MASK );
+    pxPool->pxEnd = ( BlockLink_t * ) uxAddress;
+    pxPool->pxEnd->xBlockSize = 0;
+    pxPool->pxEnd->pxNextFreeBlock = NULL;
+
+    /* To start with there is a single free block that is sized to take up the
+     * entire pool, minus the space taken by pxEnd. */
+    pxFirstFreeBlock = ( BlockLink_t * ) pucAlignedHeap;
+    pxFirstFreeBlock->xBlockSize = ( size_t ) ( uxAddress - ( portPOINTER_SIZE_TYPE ) pxFirstFreeBlock );
+    pxFirstFreeBlock->pxNextFreeBlock = pxPool->pxEnd;
+
+    /* Only one block exists - and it covers the entire usable pool. */
+    pxPool->xMinimumEverFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
+    pxPool->xFreeBytesRemaining = pxFirstFreeBlock->xBlockSize;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void ) /* PRIVILEGED_FUNCTION */
+{
+    prvPoolInit( &( xPools[ eHeapPoolFast ] ), ucFastHeap, configFAST_HEAP_SIZE );
+    prvPoolInit( &( xPools[ eHeapPoolBulk ] ), ucHeap, configTOTAL_HEAP_SIZE );
+    xHeapHasBeenInitialised = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertBlockIntoFreeList( HeapPool_t * pxPool,
+                                        BlockLink_t * pxBlockToInsert ) /* PRIVILEGED_FUNCTION */
+{
+    BlockLink_t * pxIterator;
+    uint8_t * puc;
+
+    /* Iterate through the list until a block is found that has a higher address
+     * than the block being inserted. */
+    for( pxIterator = &( pxPool->xStart ); pxIterator->pxNextFreeBlock < pxBlockToInsert; pxIterator = pxIterator->pxNextFreeBlock )
+    {
+        /* Nothing to do here, just iterate to the right position. */
+    }
+
+    /* Do the block being inserted, and the block it is being inserted after
+     * make a contiguous block of memory? */
+    puc = ( uint8_t * ) pxIterator;
+
+    if( ( puc + pxIterator->xBlockSize ) == ( uint8_t * ) pxBlockToInsert )
+    {
+        pxIterator->xBlockSize += pxBlockToInsert->xBlockSize;
+        pxBlockToInsert = pxIterator;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    /* Do the block being inserted, and the block it is being inserted before
+     * make a contiguous block of memory? */
+    puc = ( uint8_t * ) pxBlockToInsert;
+
+    if( ( puc + pxBlockToInsert->xBlockSize ) == ( uint8_t * ) pxIterator->pxNextFreeBlock )
+    {
+        if( pxIterator->pxNextFreeBlock != pxPool->pxEnd )
+        {
+            /* Form one big block from the two blocks. */
+            pxBlockToInsert->xBlockSize += pxIterator->pxNextFreeBlock->xBlockSize;
+            pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock->pxNextFreeBlock;
+        }
+        else
+        {
+            pxBlockToInsert->pxNextFreeBlock = pxPool->pxEnd;
+        }
+    }
+    else
+    {
+        pxBlockToInsert->pxNextFreeBlock = pxIterator->pxNextFreeBlock;
+    }
+
+    /* If the block being inserted plugged a gab, so was merged with the block
+     * before and the block after, then it's pxNextFreeBlock pointer will have
+     * already been set, and should not be set here as that would make it point
+     * to itself. */
+    if( pxIterator != pxBlockToInsert )
+    {
+        pxIterator->pxNextFreeBlock = pxBlockToInsert;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapPoolStats( eHeapPool ePool,
+                            HeapStats_t * pxHeapStats )
+{
+    HeapPool_t * pxPool = &( xPools[ ePool ] );
+    BlockLink_t * pxBlock;
+    size_t xBlocks = 0, xMaxSize = 0, xMinSize = portMAX_DELAY; /* portMAX_DELAY used as a portable way of getting the maximum value. */
+
+    configASSERT( ePool < eHeapPoolCount );
+
+    vTaskSuspendAll();
+    {
+        pxBlock = pxPool->xStart.pxNextFreeBlock;
+
+        /* pxBlock will be NULL if the heap has not been initialised.  The heap
+         * is initialised automatically when the first allocation is made. */
+        if( pxBlock != NULL )
+        {
+            while( pxBlock != pxPool->pxEnd )
+            {
+                /* Increment the number of blocks and record the largest block seen
+                 * so far. */
+                xBlocks++;
+
+                if( pxBlock->xBlockSize > xMaxSize )
+                {
+                    xMaxSize = pxBlock->xBlockSize;
+                }
+
+                if( pxBlock->xBlockSize < xMinSize )
+                {
+                    xMinSize = pxBlock->xBlockSize;
+                }
+
+                /* Move to the next block in the chain until the last block is
+                 * reached. */
+                pxBlock = pxBlock->pxNextFreeBlock;
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+    pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMinSize;
+    pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+
+    taskENTER_CRITICAL();
+    {
+        pxHeapStats->xAvailableHeapSpaceInBytes = pxPool->xFreeBytesRemaining;
+        pxHeapStats->xNumberOfSuccessfulAllocations = pxPool->xNumberOfSuccessfulAllocations;
+        pxHeapStats->xNumberOfSuccessfulFrees = pxPool->xNumberOfSuccessfulFrees;
+        pxHeapStats->xMinimumEverFreeBytesRemaining = pxPool->xMinimumEverFreeBytesRemaining;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetHeapPoolFallbacks( eHeapPool ePool )
+{
+    configASSERT( ePool < eHeapPoolCount );
+    return xPools[ ePool ].xNumberOfFallbacks;
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t * pxHeapStats )
+{
+    HeapStats_t xFast, xBulk;
+
+    vPortGetHeapPoolStats( eHeapPoolFast, &xFast );
+    vPortGetHeapPoolStats( eHeapPoolBulk, &xBulk );
+
+    pxHeapStats->xAvailableHeapSpaceInBytes = xFast.xAvailableHeapSpaceInBytes + xBulk.xAvailableHeapSpaceInBytes;
+    pxHeapStats->xSizeOfLargestFreeBlockInBytes = ( xFast.xSizeOfLargestFreeBlockInBytes > xBulk.xSizeOfLargestFreeBlockInBytes ) ? xFast.xSizeOfLargestFreeBlockInBytes : xBulk.xSizeOfLargestFreeBlockInBytes;
+    pxHeapStats->xSizeOfSmallestFreeBlockInBytes = ( xFast.xSizeOfSmallestFreeBlockInBytes < xBulk.xSizeOfSmallestFreeBlockInBytes ) ? xFast.xSizeOfSmallestFreeBlockInBytes : xBulk.xSizeOfSmallestFreeBlockInBytes;
+    pxHeapStats->xNumberOfFreeBlocks = xFast.xNumberOfFreeBlocks + xBulk.xNumberOfFreeBlocks;
+    pxHeapStats->xMinimumEverFreeBytesRemaining = xFast.xMinimumEverFreeBytesRemaining + xBulk.xMinimumEverFreeBytesRemaining;
+    pxHeapStats->xNumberOfSuccessfulAllocations = xFast.xNumberOfSuccessfulAllocations + xBulk.xNumberOfSuccessfulAllocations;
+    pxHeapStats->xNumberOfSuccessfulFrees = xFast.xNumberOfSuccessfulFrees + xBulk.xNumberOfSuccessfulFrees;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
@@ -64,6 +64,10 @@
 	#error configMAX_API_CALL_INTERRUPT_PRIORITY must be less than or equal to configUNIQUE_INTERRUPT_PRIORITIES as the lower the numeric priority value the higher the logical interrupt priority
 #endif
 
+#if( ( configUSE_LAZY_FPU_SWITCHING == 1 ) && ( configUSE_TASK_FPU_SUPPORT != 2 ) )
+	#error configUSE_LAZY_FPU_SWITCHING can only be set to 1 when configUSE_TASK_FPU_SUPPORT is set to 2
+#endif
+
 #if configUSE_PORT_OPTIMISED_TASK_SELECTION == 1
 	/* Check the configuration. */
 	#if( configMAX_PRIORITIES > 32 )
@@ -151,6 +155,11 @@ debugger. */
 registers, plus a 32-bit status register. */
 #define portFPU_REGISTER_WORDS	( ( 32 * 2 ) + 1 )
 
+/* With lazy FPU switching the registers are saved to a fixed area at the top of
+the task's stack rather than pushed with the rest of the context.  The area is
+padded to a whole number of double words to keep the stack 8 byte aligned. */
+#define portFPU_CONTEXT_AREA_WORDS	( portFPU_REGISTER_WORDS + 1 )
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -174,6 +183,14 @@ extern void vPortRestoreTaskContext( void );
  */
 static void prvTaskExitError( void );
 
+#if( configNUMBER_OF_CORES > 1 )
+	/*
+	 * Installs the yield interrupt and starts the other cores, implemented in
+	 * portSmp.c.
+	 */
+	extern void vPortStartSecondaryCores( void );
+#endif
+
 /* 
  * The instance of the interrupt controller used by this port.  This is required
  * by the Xilinx library API functions.
@@ -207,19 +224,77 @@ void vApplicationFPUSafeIRQHandler( uint32_t ulICCIAR ) __attribute__((weak) );
 variable has to be stored as part of the task context and must be initialised to
 a non zero value to ensure interrupts don't inadvertently become unmasked before
 the scheduler starts.  As it is stored as part of the task context it will
-automatically be set to 0 when the first task is started. */
-volatile uint32_t ulCriticalNesting = 9999UL;
+automatically be set to 0 when the first task is started.  With more than one
+core this and the other per task and per interrupt state below is kept per
+core, indexed by the MPIDR CPU ID in portASM.S. */
+#if( configNUMBER_OF_CORES > 1 )
+	volatile uint32_t ulCriticalNesting[ configNUMBER_OF_CORES ] = { [ 0 ... ( configNUMBER_OF_CORES - 1 ) ] = 9999UL };
+	#define portTHIS_CORE( xVariable )	( ( xVariable )[ portGET_CORE_ID() ] )
+#else
+	volatile uint32_t ulCriticalNesting = 9999UL;
+	#define portTHIS_CORE( xVariable )	( xVariable )
+#endif
 
 /* Saved as part of the task context.  If ulPortTaskHasFPUContext is non-zero then
 a floating point context must be saved and restored for the task. */
-volatile uint32_t ulPortTaskHasFPUContext = pdFALSE;
+#if( configNUMBER_OF_CORES > 1 )
+	volatile uint32_t ulPortTaskHasFPUContext[ configNUMBER_OF_CORES ] = { pdFALSE };
+#else
+	volatile uint32_t ulPortTaskHasFPUContext = pdFALSE;
+#endif
+
+#if( configUSE_LAZY_FPU_SWITCHING == 1 )
+
+	/* Saved as part of the task context.  Points to the area that holds the
+	FPU registers of the running task while another task owns the FPU. */
+	volatile uint32_t *pulPortTaskFPUContext = NULL;
+
+	/* The task whose registers are currently loaded in the FPU, and the area
+	they must be saved to when another task claims the FPU.  Only written by
+	the undefined instruction handler and vPortCleanUpTaskFPU(). */
+	volatile void *pvPortFPUOwnerTCB = NULL;
+	volatile uint32_t *pulPortFPUOwnerContext = NULL;
+
+	/* Incremented each time the FPU registers change owner. */
+	volatile uint32_t ulPortLazyFPUSwitches = 0UL;
+
+#endif /* configUSE_LAZY_FPU_SWITCHING */
+
+#if( configNUM_FAST_INTERRUPTS > 0 )
+
+	/* Value of ulInterruptID for an unused entry, the GIC spurious interrupt
+	ID is never dispatched. */
+	#define portFAST_INTERRUPT_UNUSED	( 0x3FFUL )
+
+	typedef struct xFAST_INTERRUPT
+	{
+		volatile uint32_t ulInterruptID;
+		volatile PortFastInterruptHandler_t pxHandler;
+	} FastInterrupt_t;
+
+	/* Searched by FreeRTOS_IRQ_Handler before falling back to
+	vApplicationIRQHandler(). */
+	__attribute__(( used )) FastInterrupt_t xPortFastInterruptTable[ configNUM_FAST_INTERRUPTS ] =
+	{
+		[ 0 ... ( configNUM_FAST_INTERRUPTS - 1 ) ] = { portFAST_INTERRUPT_UNUSED, NULL }
+	};
+
+#endif /* configNUM_FAST_INTERRUPTS */
 
 /* Set to 1 to pend a context switch from an ISR. */
-volatile uint32_t ulPortYieldRequired = pdFALSE;
+#if( configNUMBER_OF_CORES > 1 )
+	volatile uint32_t ulPortYieldRequired[ configNUMBER_OF_CORES ] = { pdFALSE };
+#else
+	volatile uint32_t ulPortYieldRequired = pdFALSE;
+#endif
 
 /* Counts the interrupt nesting depth.  A context switch is only performed if
 if the nesting depth is 0. */
-volatile uint32_t ulPortInterruptNesting = 0UL;
+#if( configNUMBER_OF_CORES > 1 )
+	volatile uint32_t ulPortInterruptNesting[ configNUMBER_OF_CORES ] = { 0UL };
+#else
+	volatile uint32_t ulPortInterruptNesting = 0UL;
+#endif
 /*
  * Global counter used for calculation of run time statistics of tasks.
  * Defined only when the relevant option is turned on
@@ -241,6 +316,17 @@ __attribute__(( used )) const uint32_t ulMaxAPIPriorityMask = ( configMAX_API_CA
  */
 StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
 {
+	#if( configUSE_LAZY_FPU_SWITCHING == 1 )
+		StackType_t *pxFPUContext;
+
+		/* Reserve the area the FPU registers are saved to when the task loses
+		the FPU, and start the task with all registers at 0. */
+		pxTopOfStack -= ( portFPU_CONTEXT_AREA_WORDS - 1 );
+		pxFPUContext = pxTopOfStack;
+		memset( pxFPUContext, 0x00, portFPU_CONTEXT_AREA_WORDS * sizeof( StackType_t ) );
+		pxTopOfStack--;
+	#endif
+
 	/* Setup the initial stack of the task.  The stack is set exactly as
 	expected by the portRESTORE_CONTEXT() macro.
 
@@ -309,6 +395,13 @@ StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t px
 		pxTopOfStack--;
 		*pxTopOfStack = portNO_FLOATING_POINT_CONTEXT;
 	}
+	#elif( configUSE_LAZY_FPU_SWITCHING == 1 )
+	{
+		/* The FPU registers are not part of the stacked context, only the
+		location of the task's save area. */
+		pxTopOfStack--;
+		*pxTopOfStack = ( StackType_t ) pxFPUContext;
+	}
 	#elif( configUSE_TASK_FPU_SUPPORT == 2 )
 	{
 		/* The task will start with a floating point context.  Leave enough
@@ -318,7 +411,7 @@ StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t px
 
 		pxTopOfStack--;
 		*pxTopOfStack = pdTRUE;
-		ulPortTaskHasFPUContext = pdTRUE;
+		portTHIS_CORE( ulPortTaskHasFPUContext ) = pdTRUE;
 	}
 	#else
 	{
@@ -367,6 +460,64 @@ int32_t lReturn;
 }
 /*-----------------------------------------------------------*/
 
+#if( configNUM_FAST_INTERRUPTS > 0 )
+
+	BaseType_t xPortInstallFastInterruptHandler( uint8_t ucInterruptID, PortFastInterruptHandler_t pxHandler, uint8_t ucPriority )
+	{
+	BaseType_t xReturn = pdFAIL;
+	uint32_t ulEntry, ulFree = configNUM_FAST_INTERRUPTS;
+	uint8_t ucOldPriority, ucTrigger;
+
+		configASSERT( ucInterruptID < XSCUGIC_MAX_NUM_INTR_INPUTS );
+		configASSERT( pxHandler != NULL );
+
+		/* A fast handler may use the FromISR API, so it must not run above the
+		maximum API call priority. */
+		configASSERT( ucPriority >= configMAX_API_CALL_INTERRUPT_PRIORITY );
+
+		if( prvEnsureInterruptControllerIsInitialised() == pdPASS )
+		{
+			portCPU_IRQ_DISABLE();
+			{
+				/* Reuse the entry of ucInterruptID if it already has one. */
+				for( ulEntry = 0; ulEntry < configNUM_FAST_INTERRUPTS; ulEntry++ )
+				{
+					if( xPortFastInterruptTable[ ulEntry ].ulInterruptID == ucInterruptID )
+					{
+						ulFree = ulEntry;
+						break;
+					}
+					else if( ( xPortFastInterruptTable[ ulEntry ].ulInterruptID == portFAST_INTERRUPT_UNUSED ) && ( ulFree == configNUM_FAST_INTERRUPTS ) )
+					{
+						ulFree = ulEntry;
+					}
+				}
+
+				if( ulFree < configNUM_FAST_INTERRUPTS )
+				{
+					/* The handler must be valid before the ID can match. */
+					xPortFastInterruptTable[ ulFree ].pxHandler = pxHandler;
+					__asm volatile ( "DMB" ::: "memory" );
+					xPortFastInterruptTable[ ulFree ].ulInterruptID = ucInterruptID;
+					xReturn = pdPASS;
+				}
+			}
+			portCPU_IRQ_ENABLE();
+
+			if( xReturn == pdPASS )
+			{
+				/* Keep the trigger type, only change the priority. */
+				XScuGic_GetPriorityTriggerType( &xInterruptController, ucInterruptID, &ucOldPriority, &ucTrigger );
+				XScuGic_SetPriorityTriggerType( &xInterruptController, ucInterruptID, ucPriority << portPRIORITY_SHIFT, ucTrigger );
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* configNUM_FAST_INTERRUPTS */
+/*-----------------------------------------------------------*/
+
 static int32_t prvEnsureInterruptControllerIsInitialised( void )
 {
 static int32_t lInterruptControllerInitialised = pdFALSE;
@@ -507,6 +658,14 @@ uint32_t ulAPSR;
 			/* Start the timer that generates the tick ISR. */
 			configSETUP_TICK_INTERRUPT();
 
+			#if( configNUMBER_OF_CORES > 1 )
+			{
+				/* Install the yield interrupt and release CPU1 into its first
+				task, see portSmp.c. */
+				vPortStartSecondaryCores();
+			}
+			#endif
+
 			/* Start the first task executing. */
 			vPortRestoreTaskContext();
 		}
@@ -526,10 +685,14 @@ void vPortEndScheduler( void )
 {
 	/* Not implemented in ports where there is nothing to return to.
 	Artificially force an assert. */
-	configASSERT( ulCriticalNesting == 1000UL );
+	configASSERT( portTHIS_CORE( ulCriticalNesting ) == 1000UL );
 }
 /*-----------------------------------------------------------*/
 
+#if( configNUMBER_OF_CORES == 1 )
+
+/* With more than one core tasks.c provides the critical sections, as they also
+take the SMP locks. */
 void vPortEnterCritical( void )
 {
 	/* Mask interrupts up to the max syscall interrupt priority. */
@@ -570,6 +733,8 @@ void vPortExitCritical( void )
 		}
 	}
 }
+
+#endif /* configNUMBER_OF_CORES */
 /*-----------------------------------------------------------*/
 
 void FreeRTOS_Tick_Handler( void )
@@ -601,7 +766,7 @@ void FreeRTOS_Tick_Handler( void )
 	/* Increment the RTOS tick. */
 	if( xTaskIncrementTick() != pdFALSE )
 	{
-		ulPortYieldRequired = pdTRUE;
+		portTHIS_CORE( ulPortYieldRequired ) = pdTRUE;
 	}
 	}
 
@@ -619,7 +784,7 @@ void FreeRTOS_Tick_Handler( void )
 
 		/* A task is registering the fact that it needs an FPU context.  Set the
 		FPU flag (which is saved as part of the task context). */
-		ulPortTaskHasFPUContext = pdTRUE;
+		portTHIS_CORE( ulPortTaskHasFPUContext ) = pdTRUE;
 
 		/* Initialise the floating point status register. */
 		__asm volatile ( "FMXR 	FPSCR, %0" :: "r" (ulInitialFPSCR) : "memory" );
@@ -628,6 +793,32 @@ void FreeRTOS_Tick_Handler( void )
 #endif /* configUSE_TASK_FPU_SUPPORT */
 /*-----------------------------------------------------------*/
 
+#if( configUSE_LAZY_FPU_SWITCHING == 1 )
+
+	void vPortCleanUpTaskFPU( void *pvTCB )
+	{
+		/* A task switch between the test and the write could let another task
+		claim the FPU, which would then lose its registers. */
+		portENTER_CRITICAL();
+		{
+			if( pvPortFPUOwnerTCB == pvTCB )
+			{
+				pvPortFPUOwnerTCB = NULL;
+				pulPortFPUOwnerContext = NULL;
+			}
+		}
+		portEXIT_CRITICAL();
+	}
+	/*-----------------------------------------------------------*/
+
+	uint32_t ulPortGetLazyFPUSwitchCount( void )
+	{
+		return ulPortLazyFPUSwitches;
+	}
+
+#endif /* configUSE_LAZY_FPU_SWITCHING */
+/*-----------------------------------------------------------*/
+
 void vPortClearInterruptMask( uint32_t ulNewMaskValue )
 {
 	if( ulNewMaskValue == pdFALSE )
@@ -0,0 +1,450 @@
+/*
+ * FreeRTOS Kernel V10.5.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ * Copyright (C) 2009-2021 Xilinx, Inc. All rights reserved.
+ * Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * High resolution delays and timeouts (configUSE_HR_TIMER).
+ *
+ * The tick only wakes tasks on 1 / configTICK_RATE_HZ boundaries.
+ * vTaskDelayUs() and xTaskNotifyWaitUs() block with a tick timeout as usual,
+ * but also put their deadline, counted in global timer units, into a list
+ * sorted by deadline.  The comparator of the global timer is programmed with
+ * the earliest deadline, and its one-shot interrupt takes the expired
+ * entries off the list and wakes their tasks with xTaskAbortDelayFromISR().
+ * The tick timeout stays as a fallback, so a missed comparator interrupt
+ * only makes the wait late.
+ *
+ * A deadline can expire between arming the comparator and blocking, if the
+ * task is preempted there.  The handler then finds the task not yet blocked
+ * and retries every portHR_TIMER_RETRY_US until it is, or until the task has
+ * taken its entry off the list.
+ *
+ * Waits shorter than configHR_TIMER_SPIN_US are spun instead, blocking costs
+ * two context switches and an interrupt.
+ *
+ * The list entries live on the stacks of the waiting tasks.  The list is only
+ * touched inside critical sections and by the handler, which is installed as
+ * a fast interrupt at portFAST_INTERRUPT_PRIORITY.
+ */
+
+/* Standard includes. */
+#include <stdlib.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if( configUSE_HR_TIMER == 1 )
+
+#if( INCLUDE_xTaskAbortDelay != 1 )
+	#error configUSE_HR_TIMER needs INCLUDE_xTaskAbortDelay set to 1
+#endif
+
+/* Xilinx includes. */
+#include "xil_io.h"
+#include "xparameters.h"
+#include "xtime_l.h"
+
+#define portHR_TIMER_BASEADDR		XPAR_GLOBAL_TMR_BASEADDR
+#define portHR_TIMER_INTERRUPT_ID	XPAR_GLOBAL_TMR_INTR
+
+/* Global timer registers not named by xtime_l.h. */
+#define portHR_TIMER_ISR_OFFSET		0x0CUL
+#define portHR_TIMER_COMP_LOWER		0x10UL
+#define portHR_TIMER_COMP_UPPER		0x14UL
+
+#define portHR_TIMER_COMP_ENABLE	0x02UL
+#define portHR_TIMER_IRQ_ENABLE		0x04UL
+#define portHR_TIMER_AUTO_INC		0x08UL
+
+#define portHR_TIMER_COUNTS_PER_US	( ( uint64_t ) COUNTS_PER_SECOND / 1000000ULL )
+#define portHR_TIMER_US_PER_TICK	( 1000000UL / configTICK_RATE_HZ )
+#define portHR_TIMER_RETRY_US		20ULL
+
+typedef struct xHR_TIMER_WAIT
+{
+	uint64_t ullDeadline;	/* Global timer count. */
+	uint64_t ullExpiry;		/* List key, the deadline or the next retry. */
+	TaskHandle_t xTask;
+	BaseType_t xQueued;
+	struct xHR_TIMER_WAIT *pxNext;
+} HRTimerWait_t;
+
+static HRTimerWait_t *pxWaitList = NULL;
+static HRTimerStats_t xHrStats = { 0 };
+
+/*-----------------------------------------------------------*/
+
+static void prvHrTimerProgram( uint64_t ullDeadline )
+{
+uint32_t ulControl;
+
+	ulControl = Xil_In32( portHR_TIMER_BASEADDR + GTIMER_CONTROL_OFFSET );
+	ulControl &= ~( portHR_TIMER_COMP_ENABLE | portHR_TIMER_IRQ_ENABLE | portHR_TIMER_AUTO_INC );
+
+	/* The comparator must be disabled while both halves are written. */
+	Xil_Out32( portHR_TIMER_BASEADDR + GTIMER_CONTROL_OFFSET, ulControl );
+	Xil_Out32( portHR_TIMER_BASEADDR + portHR_TIMER_COMP_LOWER, ( uint32_t ) ullDeadline );
+	Xil_Out32( portHR_TIMER_BASEADDR + portHR_TIMER_COMP_UPPER, ( uint32_t ) ( ullDeadline >> 32 ) );
+	Xil_Out32( portHR_TIMER_BASEADDR + GTIMER_CONTROL_OFFSET, ulControl | portHR_TIMER_COMP_ENABLE | portHR_TIMER_IRQ_ENABLE );
+}
+/*-----------------------------------------------------------*/
+
+static void prvHrTimerDisable( void )
+{
+uint32_t ulControl;
+
+	ulControl = Xil_In32( portHR_TIMER_BASEADDR + GTIMER_CONTROL_OFFSET );
+	Xil_Out32( portHR_TIMER_BASEADDR + GTIMER_CONTROL_OFFSET, ulControl & ~( portHR_TIMER_COMP_ENABLE | portHR_TIMER_IRQ_ENABLE ) );
+	Xil_Out32( portHR_TIMER_BASEADDR + portHR_TIMER_ISR_OFFSET, 1UL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvHrTimerInsert( HRTimerWait_t *pxWait )
+{
+HRTimerWait_t **ppxLink = &pxWaitList;
+
+	while( ( *ppxLink != NULL ) && ( ( *ppxLink )->ullExpiry <= pxWait->ullExpiry ) )
+	{
+		ppxLink = &( ( *ppxLink )->pxNext );
+	}
+	pxWait->pxNext = *ppxLink;
+	*ppxLink = pxWait;
+	pxWait->xQueued = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+/* Wakes the tasks whose deadline has passed and programs the comparator with
+the next one.  Called with interrupts masked, returns pdTRUE if a task of
+higher priority than the running one was woken. */
+static BaseType_t prvHrTimerExpire( void )
+{
+HRTimerWait_t *pxWait;
+XTime xNow;
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	for( ;; )
+	{
+		XTime_GetTime( &xNow );
+		while( ( pxWaitList != NULL ) && ( pxWaitList->ullExpiry <= ( uint64_t ) xNow ) )
+		{
+			pxWait = pxWaitList;
+			pxWaitList = pxWait->pxNext;
+			pxWait->xQueued = pdFALSE;
+			if( xTaskAbortDelayFromISR( pxWait->xTask, &xHigherPriorityTaskWoken ) == pdFAIL )
+			{
+				/* Not blocked yet, or already woken by something else and
+				about to take the entry off the list itself. */
+				pxWait->ullExpiry = ( uint64_t ) xNow + ( portHR_TIMER_RETRY_US * portHR_TIMER_COUNTS_PER_US );
+				prvHrTimerInsert( pxWait );
+				xHrStats.ulRetries++;
+			}
+		}
+
+		if( pxWaitList == NULL )
+		{
+			prvHrTimerDisable();
+			break;
+		}
+
+		/* A comparator that only fires on equality would miss a deadline
+		that passes while it is written, so check again afterwards. */
+		prvHrTimerProgram( pxWaitList->ullExpiry );
+		XTime_GetTime( &xNow );
+		if( pxWaitList->ullExpiry > ( uint64_t ) xNow )
+		{
+			break;
+		}
+	}
+
+	return xHigherPriorityTaskWoken;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHrTimerHandler( uint32_t ulICCIAR )
+{
+BaseType_t xHigherPriorityTaskWoken;
+
+	( void ) ulICCIAR;
+
+	Xil_Out32( portHR_TIMER_BASEADDR + portHR_TIMER_ISR_OFFSET, 1UL );
+	xHrStats.ulInterrupts++;
+	xHigherPriorityTaskWoken = prvHrTimerExpire();
+	portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+#if( configNUM_FAST_INTERRUPTS == 0 )
+	static void prvHrTimerGenericHandler( void *pvCallBackRef )
+	{
+		( void ) pvCallBackRef;
+		prvHrTimerHandler( portHR_TIMER_INTERRUPT_ID );
+	}
+#endif
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvHrTimerInstall( void )
+{
+static BaseType_t xInstalled = pdFALSE;
+static BaseType_t xFailed = pdFALSE;
+BaseType_t xStatus;
+
+	if( ( xInstalled == pdFALSE ) && ( xFailed == pdFALSE ) )
+	{
+		#if( configNUM_FAST_INTERRUPTS > 0 )
+			xStatus = xPortInstallFastInterruptHandler( portHR_TIMER_INTERRUPT_ID, prvHrTimerHandler, portFAST_INTERRUPT_PRIORITY );
+		#else
+			xStatus = xPortInstallInterruptHandler( portHR_TIMER_INTERRUPT_ID, prvHrTimerGenericHandler, NULL );
+		#endif
+		if( xStatus != pdPASS )
+		{
+			/* Only the tick timeouts are left, try once. */
+			xFailed = pdTRUE;
+			return pdFAIL;
+		}
+		prvHrTimerDisable();
+		vPortEnableInterrupt( portHR_TIMER_INTERRUPT_ID );
+		xInstalled = pdTRUE;
+	}
+
+	return xInstalled;
+}
+/*-----------------------------------------------------------*/
+
+/* Takes pxWait off the list if the interrupt has not done so already.  Called
+from a critical section, returns pdTRUE if another task was woken and the
+caller should yield. */
+static BaseType_t prvHrTimerUnlink( HRTimerWait_t *pxWait )
+{
+HRTimerWait_t **ppxLink;
+BaseType_t xYieldRequired = pdFALSE;
+
+	if( pxWait->xQueued == pdFALSE )
+	{
+		return pdFALSE;
+	}
+
+	ppxLink = &pxWaitList;
+	while( *ppxLink != pxWait )
+	{
+		ppxLink = &( ( *ppxLink )->pxNext );
+	}
+	*ppxLink = pxWait->pxNext;
+	pxWait->xQueued = pdFALSE;
+
+	if( pxWaitList == NULL )
+	{
+		prvHrTimerDisable();
+	}
+	else if( ppxLink == &pxWaitList )
+	{
+		/* The comparator was set for this entry. */
+		xYieldRequired = prvHrTimerExpire();
+	}
+
+	return xYieldRequired;
+}
+/*-----------------------------------------------------------*/
+
+/* Puts pxWait on the list for the calling task.  Returns pdFALSE if the
+deadline has already passed and the caller should not block. */
+static BaseType_t prvHrTimerArm( HRTimerWait_t *pxWait )
+{
+XTime xNow;
+BaseType_t xBlock = pdFALSE;
+BaseType_t xYieldRequired = pdFALSE;
+
+	pxWait->xTask = xTaskGetCurrentTaskHandle();
+	pxWait->ullExpiry = pxWait->ullDeadline;
+	pxWait->xQueued = pdFALSE;
+	pxWait->pxNext = NULL;
+
+	if( prvHrTimerInstall() == pdFALSE )
+	{
+		/* Block on the tick timeout alone. */
+		return pdTRUE;
+	}
+
+	portENTER_CRITICAL();
+	{
+		XTime_GetTime( &xNow );
+		if( pxWait->ullDeadline > ( uint64_t ) xNow )
+		{
+			prvHrTimerInsert( pxWait );
+			xBlock = pdTRUE;
+
+			if( pxWaitList == pxWait )
+			{
+				prvHrTimerProgram( pxWait->ullExpiry );
+				XTime_GetTime( &xNow );
+				if( pxWait->ullDeadline <= ( uint64_t ) xNow )
+				{
+					/* Passed while the comparator was written. */
+					xYieldRequired = prvHrTimerUnlink( pxWait );
+					xBlock = pdFALSE;
+				}
+			}
+		}
+	}
+	portEXIT_CRITICAL();
+
+	if( xYieldRequired != pdFALSE )
+	{
+		taskYIELD();
+	}
+
+	return xBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHrTimerDisarm( HRTimerWait_t *pxWait )
+{
+BaseType_t xYieldRequired;
+
+	portENTER_CRITICAL();
+	{
+		xYieldRequired = prvHrTimerUnlink( pxWait );
+	}
+	portEXIT_CRITICAL();
+
+	if( xYieldRequired != pdFALSE )
+	{
+		taskYIELD();
+	}
+}
+/*-----------------------------------------------------------*/
+
+static TickType_t prvHrTimerFallbackTicks( uint32_t ulMicroseconds )
+{
+	/* Rounded up, plus one for the partial tick already elapsed. */
+	return ( TickType_t ) ( ( ulMicroseconds + portHR_TIMER_US_PER_TICK - 1UL ) / portHR_TIMER_US_PER_TICK ) + 1;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHrTimerRecordLateness( uint64_t ullDeadline )
+{
+XTime xNow;
+uint64_t ullLate;
+
+	XTime_GetTime( &xNow );
+	if( ( uint64_t ) xNow > ullDeadline )
+	{
+		ullLate = ( uint64_t ) xNow - ullDeadline;
+		if( ullLate > xHrStats.ulMaxLateCounts )
+		{
+			xHrStats.ulMaxLateCounts = ( ullLate > 0xFFFFFFFFULL ) ? 0xFFFFFFFFUL : ( uint32_t ) ullLate;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelayUs( uint32_t ulMicroseconds )
+{
+HRTimerWait_t xWait;
+XTime xNow;
+
+	XTime_GetTime( &xNow );
+	xWait.ullDeadline = ( uint64_t ) xNow + ( ( uint64_t ) ulMicroseconds * portHR_TIMER_COUNTS_PER_US );
+
+	if( ( ulMicroseconds < configHR_TIMER_SPIN_US ) || ( xTaskGetSchedulerState() != taskSCHEDULER_RUNNING ) )
+	{
+		do
+		{
+			XTime_GetTime( &xNow );
+		} while( ( uint64_t ) xNow < xWait.ullDeadline );
+
+		xHrStats.ulSpun++;
+		return;
+	}
+
+	xHrStats.ulBlocked++;
+	for( ;; )
+	{
+		if( prvHrTimerArm( &xWait ) == pdFALSE )
+		{
+			break;
+		}
+		vTaskDelay( prvHrTimerFallbackTicks( ulMicroseconds ) );
+		prvHrTimerDisarm( &xWait );
+
+		XTime_GetTime( &xNow );
+		if( ( uint64_t ) xNow >= xWait.ullDeadline )
+		{
+			break;
+		}
+
+		/* Woken early by another xTaskAbortDelay(), wait for the rest. */
+		ulMicroseconds = ( uint32_t ) ( ( xWait.ullDeadline - ( uint64_t ) xNow ) / portHR_TIMER_COUNTS_PER_US ) + 1UL;
+	}
+
+	prvHrTimerRecordLateness( xWait.ullDeadline );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xTaskNotifyWaitUs( uint32_t ulBitsToClearOnEntry,
+							  uint32_t ulBitsToClearOnExit,
+							  uint32_t *pulNotificationValue,
+							  uint32_t ulTimeoutUs )
+{
+HRTimerWait_t xWait;
+XTime xNow;
+BaseType_t xReturn;
+
+	XTime_GetTime( &xNow );
+	xWait.ullDeadline = ( uint64_t ) xNow + ( ( uint64_t ) ulTimeoutUs * portHR_TIMER_COUNTS_PER_US );
+
+	if( prvHrTimerArm( &xWait ) == pdFALSE )
+	{
+		/* Already expired, only collect a pending notification. */
+		return xTaskNotifyWait( ulBitsToClearOnEntry, ulBitsToClearOnExit, pulNotificationValue, 0 );
+	}
+
+	xHrStats.ulBlocked++;
+	xReturn = xTaskNotifyWait( ulBitsToClearOnEntry, ulBitsToClearOnExit, pulNotificationValue, prvHrTimerFallbackTicks( ulTimeoutUs ) );
+	prvHrTimerDisarm( &xWait );
+
+	if( xReturn == pdFALSE )
+	{
+		prvHrTimerRecordLateness( xWait.ullDeadline );
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHrTimerStats( HRTimerStats_t *pxStats )
+{
+	portENTER_CRITICAL();
+	{
+		*pxStats = xHrStats;
+	}
+	portEXIT_CRITICAL();
+}
+
+#endif /* configUSE_HR_TIMER */
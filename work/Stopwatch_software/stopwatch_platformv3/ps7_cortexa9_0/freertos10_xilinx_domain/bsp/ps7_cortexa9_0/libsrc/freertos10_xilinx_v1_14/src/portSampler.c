@@ -0,0 +1,242 @@
+/*
+ * FreeRTOS Kernel V10.5.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ * Copyright (C) 2009-2021 Xilinx, Inc. All rights reserved.
+ * Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * Statistical sampling profiler (configUSE_SAMPLING_PROFILER).
+ *
+ * The SCU private watchdog, unused otherwise, runs in timer mode and
+ * interrupts configSAMPLING_PROFILER_HZ times a second.  Its handler records
+ * the interrupted PC and the running task into a ring of
+ * configSAMPLING_PROFILER_SAMPLES entries, which needs no compiler
+ * instrumentation and costs one short interrupt per sample.
+ * vPortSamplerDump() prints the samples aggregated per task and PC, and
+ * tools/sample_flamegraph.py turns the dump into folded stacks for flame
+ * graphs.
+ *
+ * The handler is installed as a fast interrupt at portFAST_INTERRUPT_PRIORITY,
+ * so code running with interrupts masked by a critical section is attributed
+ * to the point where the section ends.
+ */
+
+/* Standard includes. */
+#include <stdlib.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if( configUSE_SAMPLING_PROFILER == 1 )
+
+/* Xilinx includes. */
+#include "xil_printf.h"
+#include "xparameters.h"
+#include "xscuwdt_hw.h"
+#include "xtime_l.h"
+
+#define portSAMPLER_BASEADDR		XPAR_SCUWDT_0_BASEADDR
+#define portSAMPLER_INTERRUPT_ID	XPAR_SCUWDT_INTR
+
+/* The watchdog counts at half the CPU clock, like the global timer. */
+#define portSAMPLER_LOAD			( ( COUNTS_PER_SECOND / configSAMPLING_PROFILER_HZ ) - 1UL )
+
+/* Writing these to the disable register switches the watchdog to timer mode. */
+#define portSAMPLER_WDT_DISABLE_1	0x12345678UL
+#define portSAMPLER_WDT_DISABLE_2	0x87654321UL
+
+#define portSAMPLER_MODE_MASK		0x1FUL
+#define portSAMPLER_SYS_MODE		0x1FUL
+
+/* Lines printed by vPortSamplerDump() before it waits for the console. */
+#define portSAMPLER_DUMP_BURST		16UL
+
+typedef struct xSAMPLE
+{
+	uint32_t ulTask;	/* Running TCB, 0 when an interrupt handler was sampled. */
+	uint32_t ulPC;
+} Sample_t;
+
+static Sample_t xSamples[ configSAMPLING_PROFILER_SAMPLES ];
+static TaskStatus_t xTasks[ configSAMPLING_PROFILER_TASKS ];
+static uint32_t ulSamplesTaken = 0;
+static volatile BaseType_t xSamplerRunning = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static void prvSamplerHandler( uint32_t ulICCIAR )
+{
+uint32_t ulIRQStack, ulSPSR;
+Sample_t *pxSample;
+
+	( void ) ulICCIAR;
+
+	XScuWdt_WriteReg( portSAMPLER_BASEADDR, XSCUWDT_ISR_OFFSET, 1UL );
+	if( xSamplerRunning == pdFALSE )
+	{
+		return;
+	}
+
+	/* FreeRTOS_IRQ_Handler pushed the return address and then SPSR on the IRQ
+	mode stack before switching to SVC mode.  IRQs are still masked here, so
+	the top of that stack belongs to this interrupt. */
+	__asm volatile ( "CPS #0x12		\n"
+					 "MOV %0, sp		\n"
+					 "CPS #0x13		\n"
+					 : "=r" ( ulIRQStack ) :: "memory" );
+	ulSPSR = ( ( uint32_t * ) ulIRQStack )[ 0 ];
+
+	pxSample = &( xSamples[ ulSamplesTaken % configSAMPLING_PROFILER_SAMPLES ] );
+	pxSample->ulPC = ( ( uint32_t * ) ulIRQStack )[ 1 ];
+	pxSample->ulTask = ( ( ulSPSR & portSAMPLER_MODE_MASK ) == portSAMPLER_SYS_MODE ) ? ( uint32_t ) xTaskGetCurrentTaskHandle() : 0UL;
+	ulSamplesTaken++;
+}
+/*-----------------------------------------------------------*/
+
+#if( configNUM_FAST_INTERRUPTS == 0 )
+	static void prvSamplerGenericHandler( void *pvCallBackRef )
+	{
+		( void ) pvCallBackRef;
+		prvSamplerHandler( portSAMPLER_INTERRUPT_ID );
+	}
+#endif
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortSamplerStart( void )
+{
+static BaseType_t xInstalled = pdFALSE;
+BaseType_t xStatus;
+
+	if( xInstalled == pdFALSE )
+	{
+		#if( configNUM_FAST_INTERRUPTS > 0 )
+			xStatus = xPortInstallFastInterruptHandler( portSAMPLER_INTERRUPT_ID, prvSamplerHandler, portFAST_INTERRUPT_PRIORITY );
+		#else
+			xStatus = xPortInstallInterruptHandler( portSAMPLER_INTERRUPT_ID, prvSamplerGenericHandler, NULL );
+		#endif
+		if( xStatus != pdPASS )
+		{
+			return pdFAIL;
+		}
+		xInstalled = pdTRUE;
+
+		XScuWdt_WriteReg( portSAMPLER_BASEADDR, XSCUWDT_DISABLE_OFFSET, portSAMPLER_WDT_DISABLE_1 );
+		XScuWdt_WriteReg( portSAMPLER_BASEADDR, XSCUWDT_DISABLE_OFFSET, portSAMPLER_WDT_DISABLE_2 );
+		XScuWdt_WriteReg( portSAMPLER_BASEADDR, XSCUWDT_LOAD_OFFSET, portSAMPLER_LOAD );
+		XScuWdt_WriteReg( portSAMPLER_BASEADDR, XSCUWDT_ISR_OFFSET, 1UL );
+		XScuWdt_WriteReg( portSAMPLER_BASEADDR, XSCUWDT_CONTROL_OFFSET,
+						  XSCUWDT_CONTROL_IT_ENABLE_MASK | XSCUWDT_CONTROL_AUTO_RELOAD_MASK | XSCUWDT_CONTROL_WD_ENABLE_MASK );
+		vPortEnableInterrupt( portSAMPLER_INTERRUPT_ID );
+	}
+
+	xSamplerRunning = pdTRUE;
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vPortSamplerStop( void )
+{
+	/* The timer keeps running, the handler only acknowledges it. */
+	xSamplerRunning = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulPortSamplerGetCount( void )
+{
+	return ulSamplesTaken;
+}
+/*-----------------------------------------------------------*/
+
+static int prvSampleCompare( const void *pvA, const void *pvB )
+{
+const Sample_t *pxA = ( const Sample_t * ) pvA;
+const Sample_t *pxB = ( const Sample_t * ) pvB;
+
+	if( pxA->ulTask != pxB->ulTask )
+	{
+		return ( pxA->ulTask < pxB->ulTask ) ? -1 : 1;
+	}
+	if( pxA->ulPC != pxB->ulPC )
+	{
+		return ( pxA->ulPC < pxB->ulPC ) ? -1 : 1;
+	}
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSamplerPace( uint32_t *pulLines )
+{
+	/* Give the console time to drain between bursts of lines. */
+	if( ( ++( *pulLines ) % portSAMPLER_DUMP_BURST ) == 0UL )
+	{
+		vTaskDelay( pdMS_TO_TICKS( 50 ) + 1 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void vPortSamplerDump( void )
+{
+BaseType_t xWasRunning = xSamplerRunning;
+UBaseType_t uxTasks, uxIndex;
+uint32_t ulStored, ulIndex, ulCount, ulLines = 0;
+
+	/* Sorting reorders the ring, so the samples are consumed by the dump. */
+	xSamplerRunning = pdFALSE;
+	ulStored = ( ulSamplesTaken < configSAMPLING_PROFILER_SAMPLES ) ? ulSamplesTaken : configSAMPLING_PROFILER_SAMPLES;
+	qsort( xSamples, ulStored, sizeof( Sample_t ), prvSampleCompare );
+
+	xil_printf( "SAMPLES %u %u %u\r\n", ulSamplesTaken, ulStored, ( uint32_t ) configSAMPLING_PROFILER_HZ );
+
+	/* Task names, tasks deleted since they were sampled show as addresses.
+	The array is static so a dump allocates nothing, it only holds the tasks
+	when there are configSAMPLING_PROFILER_TASKS at most. */
+	uxTasks = uxTaskGetSystemState( xTasks, configSAMPLING_PROFILER_TASKS, NULL );
+	for( uxIndex = 0; uxIndex < uxTasks; uxIndex++ )
+	{
+		xil_printf( "T %08x %s\r\n", ( uint32_t ) xTasks[ uxIndex ].xHandle, xTasks[ uxIndex ].pcTaskName );
+		prvSamplerPace( &ulLines );
+	}
+
+	/* One line per task and PC with its sample count. */
+	for( ulIndex = 0; ulIndex < ulStored; ulIndex += ulCount )
+	{
+		for( ulCount = 1; ( ulIndex + ulCount < ulStored ) &&
+						  ( prvSampleCompare( &( xSamples[ ulIndex ] ), &( xSamples[ ulIndex + ulCount ] ) ) == 0 ); ulCount++ )
+		{
+		}
+		xil_printf( "S %08x %08x %u\r\n", xSamples[ ulIndex ].ulTask, xSamples[ ulIndex ].ulPC, ulCount );
+		prvSamplerPace( &ulLines );
+	}
+	xil_printf( "END\r\n" );
+
+	ulSamplesTaken = 0;
+	xSamplerRunning = xWasRunning;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_SAMPLING_PROFILER */
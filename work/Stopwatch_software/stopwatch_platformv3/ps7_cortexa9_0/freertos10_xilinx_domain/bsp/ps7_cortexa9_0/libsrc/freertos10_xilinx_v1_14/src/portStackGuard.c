@@ -0,0 +1,367 @@
+/*
+ * FreeRTOS Kernel V10.5.1
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ * Copyright (C) 2009-2021 Xilinx, Inc. All rights reserved.
+ * Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * MMU guard pages under the task stacks (configUSE_STACK_GUARD_PAGES).
+ *
+ * The kernel takes task stacks from pvPortMallocStack(), which carves them
+ * from a pool of configSTACK_GUARD_POOL_SIZE bytes in the
+ * configSTACK_GUARD_SECTION linker section.  A stack is rounded up to whole
+ * 4 KB pages and placed directly above configSTACK_GUARD_PAGES pages that
+ * Xil_MmuSetRegionAttributes() maps as RESERVED, fault entries of the second
+ * level table, so the first access below the stack takes a translation fault
+ * (a data abort), wherever it lands in the guard.  boot.S makes every domain a
+ * manager domain, which skips the access permission checks, so access bits
+ * alone would not fault: a translation fault is taken in any domain.  The
+ * abort handler finds the guard holding the fault address and calls
+ * vApplicationStackOverflowHook() with the running task.
+ *
+ * The abort path has not yet run on hardware, so the Zynq configuration keeps
+ * configCHECK_FOR_STACK_OVERFLOW 2 as well: the pattern check at the context
+ * switches still reports an overflow that the guard missed.
+ *
+ * An access further below the stack than the guard is not caught: a function
+ * whose frame, alloca() or variable length array is larger than the guard
+ * moves the stack pointer over it, and its first store lands in the stack or
+ * data below.  Keep large buffers off the task stacks, or raise
+ * configSTACK_GUARD_PAGES above the largest frame, at that many pages of pool
+ * or static buffer per stack.
+ *
+ * A block, a guard and its stack pages, is carved once and reused whole
+ * by a later stack that fits in it, so a page never goes back from guard to
+ * stack: translations only ever lose access, and a stale TLB entry on the
+ * other core can only delay a detection, never fault a valid access.  A stack
+ * that does not fit in the pool comes from the heap without a guard and is
+ * counted.
+ *
+ * Static stack buffers are laid out the same way by portSTATIC_STACK_WORDS()
+ * and portSTATIC_STACK_ATTRIBUTES, pxPortStaticStack() protects their guard
+ * and records them as blocks that stay in use, a buffer given again when its
+ * task was deleted finds its block and is not protected twice.  Without
+ * configSUPPORT_DYNAMIC_ALLOCATION there is no pool, only static stacks.
+ *
+ * Other data aborts halt as the default BSP handler does, DataAbortAddr
+ * holds the faulting instruction for the debugger.
+ */
+
+/* Standard includes. */
+#include <stdlib.h>
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if( configUSE_STACK_GUARD_PAGES == 1 )
+
+/* Xilinx includes. */
+#include "xil_exception.h"
+#include "xil_mmu.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#include "xstatus.h"
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	#define portSTACK_GUARD_POOL_PAGES	( configSTACK_GUARD_POOL_SIZE / portSTACK_GUARD_PAGE_SIZE )
+#else
+	#define portSTACK_GUARD_POOL_PAGES	0UL
+#endif
+
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	#define portSTACK_GUARD_STATIC_BLOCKS	( ( uint32_t ) configSTACK_GUARD_STATIC_STACKS )
+#else
+	#define portSTACK_GUARD_STATIC_BLOCKS	0UL
+#endif
+
+#define portSTACK_GUARD_PAGES	( ( uint32_t ) configSTACK_GUARD_PAGES )
+
+/* Every pool block takes at least one stack page above its guard. */
+#define portSTACK_GUARD_MAX_BLOCKS	( ( portSTACK_GUARD_POOL_PAGES / ( portSTACK_GUARD_PAGES + 1UL ) ) + portSTACK_GUARD_STATIC_BLOCKS )
+
+#if( ( configSTACK_GUARD_POOL_SIZE % 4096 ) != 0 )
+	#error configSTACK_GUARD_POOL_SIZE must be a multiple of 4 KB
+#endif
+
+#if( configCHECK_FOR_STACK_OVERFLOW == 0 )
+	/* Only declared by task.h for the pattern check. */
+	extern void vApplicationStackOverflowHook( TaskHandle_t xTask, char *pcTaskName );
+#endif
+
+typedef struct xSTACK_GUARD_BLOCK
+{
+	uint8_t *pucGuard;		/* The stack starts portSTACK_GUARD_SIZE above. */
+	uint32_t ulPages;		/* Stack pages. */
+	BaseType_t xInUse;		/* Always set for a static stack. */
+} StackGuardBlock_t;
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	static uint8_t ucStackGuardPool[ configSTACK_GUARD_POOL_SIZE ] __attribute__( ( section( configSTACK_GUARD_SECTION ), aligned( portSTACK_GUARD_PAGE_SIZE ) ) );
+#endif
+static StackGuardBlock_t xBlocks[ portSTACK_GUARD_MAX_BLOCKS ];
+static uint32_t ulBlockCount = 0;
+static uint32_t ulPagesCarved = 0;
+static uint32_t ulStaticStacks = 0;
+static BaseType_t xHandlerInstalled = pdFALSE;
+static StackGuardStats_t xStackGuardStats;
+
+/* Fault address of the guard page hit, for the debugger. */
+volatile uint32_t ulPortStackGuardFaultAddress = 0;
+
+/*-----------------------------------------------------------*/
+
+static void prvStackGuardAbort( void *pvCallBackRef )
+{
+uint32_t ulAddress = mfcp( XREG_CP15_DATA_FAULT_ADDRESS );
+TaskHandle_t xTask;
+uint32_t ul;
+
+	( void ) pvCallBackRef;
+
+	/* Runs on the abort mode stack, the task stack is not touched. */
+	for( ul = 0; ul < ulBlockCount; ul++ )
+	{
+		if( ( ulAddress - ( uint32_t ) xBlocks[ ul ].pucGuard ) < portSTACK_GUARD_SIZE )
+		{
+			/* The access came from the running task, or from an interrupt
+			handler running on its stack. */
+			ulPortStackGuardFaultAddress = ulAddress;
+			xTask = xTaskGetCurrentTaskHandle();
+			vApplicationStackOverflowHook( xTask, pcTaskGetName( xTask ) );
+		}
+	}
+
+	for( ;; )
+	{
+	}
+}
+/*-----------------------------------------------------------*/
+
+/* Called with the scheduler suspended. */
+static BaseType_t prvStackGuardProtect( uint8_t *pucGuard )
+{
+	if( xHandlerInstalled == pdFALSE )
+	{
+		Xil_ExceptionRegisterHandler( XIL_EXCEPTION_ID_DATA_ABORT_INT, prvStackGuardAbort, NULL );
+		xHandlerInstalled = pdTRUE;
+	}
+
+	/* A fault entry (descriptor 0), not an accessible page without access
+	rights: the domains are manager domains.  Fails when the MMU page table
+	pool is exhausted. */
+	if( Xil_MmuSetRegionAttributes( ( INTPTR ) pucGuard, portSTACK_GUARD_SIZE, RESERVED ) != XST_SUCCESS )
+	{
+		return pdFAIL;
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+/* Called with the scheduler suspended.  The block is filled before it is
+counted, so the abort handler only ever sees complete blocks. */
+static StackGuardBlock_t *prvStackGuardAddBlock( uint8_t *pucGuard, uint32_t ulPages, BaseType_t xInUse )
+{
+StackGuardBlock_t *pxBlock = &( xBlocks[ ulBlockCount ] );
+
+	pxBlock->pucGuard = pucGuard;
+	pxBlock->ulPages = ulPages;
+	pxBlock->xInUse = xInUse;
+	portMEMORY_BARRIER();
+	ulBlockCount++;
+
+	return pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+/* Called with the scheduler suspended. */
+static StackGuardBlock_t *prvStackGuardCarve( uint32_t ulPages )
+{
+uint8_t *pucGuard = &( ucStackGuardPool[ ulPagesCarved * portSTACK_GUARD_PAGE_SIZE ] );
+
+	if( ( ulBlockCount == portSTACK_GUARD_MAX_BLOCKS ) || ( ( ulPagesCarved + ulPages + portSTACK_GUARD_PAGES ) > portSTACK_GUARD_POOL_PAGES ) )
+	{
+		return NULL;
+	}
+
+	if( prvStackGuardProtect( pucGuard ) != pdPASS )
+	{
+		return NULL;
+	}
+
+	ulPagesCarved += ulPages + portSTACK_GUARD_PAGES;
+	return prvStackGuardAddBlock( pucGuard, ulPages, pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMallocStack( size_t xSize )
+{
+uint32_t ulPages = ( uint32_t ) ( ( xSize + portSTACK_GUARD_PAGE_SIZE - 1UL ) / portSTACK_GUARD_PAGE_SIZE );
+StackGuardBlock_t *pxBlock = NULL;
+void *pvStack = NULL;
+uint32_t ul;
+
+	vTaskSuspendAll();
+	{
+		/* The smallest free block that fits, else a new one. */
+		for( ul = 0; ul < ulBlockCount; ul++ )
+		{
+			if( ( xBlocks[ ul ].xInUse == pdFALSE ) && ( xBlocks[ ul ].ulPages >= ulPages ) &&
+				( ( pxBlock == NULL ) || ( xBlocks[ ul ].ulPages < pxBlock->ulPages ) ) )
+			{
+				pxBlock = &( xBlocks[ ul ] );
+			}
+		}
+
+		if( pxBlock == NULL )
+		{
+			pxBlock = prvStackGuardCarve( ulPages );
+		}
+
+		if( pxBlock != NULL )
+		{
+			pxBlock->xInUse = pdTRUE;
+			pvStack = pxBlock->pucGuard + portSTACK_GUARD_SIZE;
+			xStackGuardStats.ulGuardedStacks++;
+		}
+		else
+		{
+			xStackGuardStats.ulUnguardedStacks++;
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	if( pvStack == NULL )
+	{
+		pvStack = pvPortMallocFast( xSize );
+	}
+
+	return pvStack;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFreeStack( void *pv )
+{
+uint32_t ul;
+
+	if( ( ( uint32_t ) pv - ( uint32_t ) ucStackGuardPool ) >= sizeof( ucStackGuardPool ) )
+	{
+		vPortFree( pv );
+		return;
+	}
+
+	vTaskSuspendAll();
+	{
+		for( ul = 0; ul < ulBlockCount; ul++ )
+		{
+			if( xBlocks[ ul ].pucGuard + portSTACK_GUARD_SIZE == ( uint8_t * ) pv )
+			{
+				configASSERT( xBlocks[ ul ].xInUse != pdFALSE );
+				xBlocks[ ul ].xInUse = pdFALSE;
+				xStackGuardStats.ulGuardedStacks--;
+				break;
+			}
+		}
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+
+StackType_t *pxPortStaticStack( StackType_t *pxBuffer, uint32_t ulBufferWords, uint32_t *pulStackDepth )
+{
+uint8_t *pucGuard = ( uint8_t * ) pxBuffer;
+uint32_t ulPages = ( ulBufferWords * sizeof( StackType_t ) ) / portSTACK_GUARD_PAGE_SIZE;
+StackGuardBlock_t *pxBlock = NULL;
+StackType_t *pxStack = pxBuffer;
+uint32_t ul;
+
+	/* Declared with portSTATIC_STACK_WORDS() and portSTATIC_STACK_ATTRIBUTES. */
+	configASSERT( ( ( ( uint32_t ) pucGuard % portSTACK_GUARD_PAGE_SIZE ) == 0UL ) && ( ulPages > portSTACK_GUARD_PAGES ) );
+
+	/* Used whole, without a guard, if it cannot be protected. */
+	*pulStackDepth = ulBufferWords;
+
+	vTaskSuspendAll();
+	{
+		/* A buffer given again for a new task keeps its guard and block, it
+		is neither protected nor counted a second time. */
+		for( ul = 0; ul < ulBlockCount; ul++ )
+		{
+			if( xBlocks[ ul ].pucGuard == pucGuard )
+			{
+				pxBlock = &( xBlocks[ ul ] );
+				break;
+			}
+		}
+
+		if( pxBlock == NULL )
+		{
+			if( ( ulStaticStacks < portSTACK_GUARD_STATIC_BLOCKS ) && ( prvStackGuardProtect( pucGuard ) == pdPASS ) )
+			{
+				pxBlock = prvStackGuardAddBlock( pucGuard, ulPages - portSTACK_GUARD_PAGES, pdTRUE );
+				ulStaticStacks++;
+				xStackGuardStats.ulGuardedStacks++;
+			}
+			else
+			{
+				xStackGuardStats.ulUnguardedStacks++;
+			}
+		}
+	}
+	( void ) xTaskResumeAll();
+
+	if( pxBlock != NULL )
+	{
+		pxStack = ( StackType_t * ) ( pxBlock->pucGuard + portSTACK_GUARD_SIZE );
+		*pulStackDepth = pxBlock->ulPages * ( portSTACK_GUARD_PAGE_SIZE / sizeof( StackType_t ) );
+	}
+
+	return pxStack;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configSUPPORT_STATIC_ALLOCATION */
+
+void vPortGetStackGuardStats( StackGuardStats_t *pxStats )
+{
+	vTaskSuspendAll();
+	{
+		*pxStats = xStackGuardStats;
+		pxStats->ulPagesCarved = ulPagesCarved;
+		pxStats->ulPagesFree = portSTACK_GUARD_POOL_PAGES - ulPagesCarved;
+	}
+	( void ) xTaskResumeAll();
+}
+
+#endif /* configUSE_STACK_GUARD_PAGES */
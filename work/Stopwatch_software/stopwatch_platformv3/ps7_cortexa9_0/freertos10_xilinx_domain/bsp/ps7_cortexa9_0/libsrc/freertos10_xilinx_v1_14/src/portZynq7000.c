@@ -39,6 +39,13 @@
 #else
 #include "xiltimer.h"
 #endif
+#if( configUSE_IRQ_STATS == 1 )
+#include <string.h>
+#include "xil_io.h"
+#include "xpseudo_asm.h"
+#include "xil_printf.h"
+#include "xtime_l.h"
+#endif
 
 #define XSCUTIMER_CLOCK_HZ ( XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ / 2UL )
 
@@ -68,6 +75,14 @@ void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer,
                                     StackType_t **ppxIdleTaskStackBuffer,
                                     uint32_t *pulIdleTaskStackSize )
 								__attribute__((weak));
+
+#if ( configNUMBER_OF_CORES > 1 )
+void vApplicationGetPassiveIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer,
+                                           StackType_t **ppxIdleTaskStackBuffer,
+                                           uint32_t *pulIdleTaskStackSize,
+                                           BaseType_t xPassiveIdleTaskIndex )
+								__attribute__((weak));
+#endif
 #endif
 
 /* Timer used to generate the tick interrupt. */
@@ -186,6 +201,127 @@ void FreeRTOS_ClearTickInterrupt( void )
 #endif
 /*-----------------------------------------------------------*/
 
+#if( configUSE_IRQ_STATS == 1 )
+
+/* Deepest nesting level for which the time spent in nested interrupts is
+subtracted from the handler time. */
+#define portIRQ_STATS_MAX_NESTING	16
+
+static IRQStats_t xIRQStats[ XSCUGIC_MAX_NUM_INTR_INPUTS ];
+
+/* Time spent in nested interrupts by the handler running at each depth. */
+static uint32_t ulIRQStatsNestedTicks[ portIRQ_STATS_MAX_NESTING + 1 ];
+
+/* Only the low word of the global timer is read, handlers never run for the
+13 seconds it takes to wrap. */
+static inline uint32_t prvIRQStatsTimestamp( void )
+{
+	return Xil_In32( GLOBAL_TMR_BASEADDR + GTIMER_COUNTER_LOWER_OFFSET );
+}
+
+/* The statistics are written from interrupts of any priority, so readers mask
+IRQs in the CPU rather than using a critical section. */
+static inline uint32_t prvIRQStatsLock( void )
+{
+uint32_t ulCPSR = mfcpsr();
+
+	__asm volatile ( "CPSID i" ::: "memory" );
+	return ulCPSR;
+}
+
+static inline void prvIRQStatsUnlock( uint32_t ulCPSR )
+{
+	mtcpsr( ulCPSR );
+}
+
+static inline uint32_t prvIRQStatsBucket( uint32_t ulTicks, uint32_t ulBuckets )
+{
+uint32_t ulBucket;
+
+	/* Index of the most significant bit set. */
+	ulBucket = ( ulTicks == 0UL ) ? 0UL : ( 31UL - ( uint32_t ) __builtin_clz( ulTicks ) );
+
+	return ( ulBucket < ulBuckets ) ? ulBucket : ( ulBuckets - 1UL );
+}
+
+static void prvIRQStatsRecord( uint32_t ulInterruptID, uint32_t ulDepth, uint32_t ulTicks )
+{
+IRQStats_t *pxStats = &( xIRQStats[ ulInterruptID ] );
+uint32_t ulNesting = ( ulDepth > 0UL ) ? ( ulDepth - 1UL ) : 0UL;
+
+	pxStats->ulCount++;
+	pxStats->ullTotalTicks += ulTicks;
+	if( ulTicks > pxStats->ulMaxTicks )
+	{
+		pxStats->ulMaxTicks = ulTicks;
+	}
+	pxStats->ulDurationHistogram[ prvIRQStatsBucket( ulTicks, portIRQ_STATS_DURATION_BUCKETS ) ]++;
+	pxStats->ulNestingHistogram[ ( ulNesting < portIRQ_STATS_NESTING_BUCKETS ) ? ulNesting : ( portIRQ_STATS_NESTING_BUCKETS - 1 ) ]++;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortGetIRQStats( uint32_t ulInterruptID, IRQStats_t *pxStats )
+{
+uint32_t ulCPSR;
+
+	if( ulInterruptID >= XSCUGIC_MAX_NUM_INTR_INPUTS )
+	{
+		return pdFAIL;
+	}
+
+	ulCPSR = prvIRQStatsLock();
+	*pxStats = xIRQStats[ ulInterruptID ];
+	prvIRQStatsUnlock( ulCPSR );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+void vPortResetIRQStats( void )
+{
+uint32_t ulCPSR;
+
+	ulCPSR = prvIRQStatsLock();
+	memset( xIRQStats, 0x00, sizeof( xIRQStats ) );
+	prvIRQStatsUnlock( ulCPSR );
+}
+/*-----------------------------------------------------------*/
+
+void vPortPrintIRQStats( void )
+{
+IRQStats_t xStats;
+uint32_t ulInterruptID, ulBucket;
+
+	xil_printf( "IRQ   count       max(ticks)  avg(ticks)  log2 histogram (ticks)\r\n" );
+	for( ulInterruptID = 0; ulInterruptID < XSCUGIC_MAX_NUM_INTR_INPUTS; ulInterruptID++ )
+	{
+		( void ) xPortGetIRQStats( ulInterruptID, &xStats );
+		if( xStats.ulCount == 0UL )
+		{
+			continue;
+		}
+
+		xil_printf( "%3d   %10u  %10u  %10u ", ( int ) ulInterruptID, xStats.ulCount, xStats.ulMaxTicks,
+					( uint32_t ) ( xStats.ullTotalTicks / xStats.ulCount ) );
+		for( ulBucket = 0; ulBucket < portIRQ_STATS_DURATION_BUCKETS; ulBucket++ )
+		{
+			if( xStats.ulDurationHistogram[ ulBucket ] != 0UL )
+			{
+				xil_printf( " %u:%u", ( 1UL << ulBucket ), xStats.ulDurationHistogram[ ulBucket ] );
+			}
+		}
+		xil_printf( "  nesting" );
+		for( ulBucket = 0; ulBucket < portIRQ_STATS_NESTING_BUCKETS; ulBucket++ )
+		{
+			xil_printf( " %u", xStats.ulNestingHistogram[ ulBucket ] );
+		}
+		xil_printf( "\r\n" );
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_IRQ_STATS */
+
 void vApplicationIRQHandler( uint32_t ulICCIAR )
 {
 extern XScuGic_Config XScuGic_ConfigTable[];
@@ -200,7 +336,40 @@ const XScuGic_VectorTableEntry *pxVectorEntry;
 	{
 		/* Call the function installed in the array of installed handler functions. */
 		pxVectorEntry = &( pxVectorTable[ ulInterruptID ] );
-		pxVectorEntry->Handler( pxVectorEntry->CallBackRef );
+		#if( configUSE_IRQ_STATS == 1 )
+		{
+		extern volatile uint32_t ulPortInterruptNesting;
+		uint32_t ulDepth = ulPortInterruptNesting;
+		uint32_t ulStart, ulElapsed;
+
+			/* ulPortInterruptNesting already counts this interrupt. */
+			if( ulDepth <= portIRQ_STATS_MAX_NESTING )
+			{
+				ulIRQStatsNestedTicks[ ulDepth ] = 0UL;
+			}
+
+			ulStart = prvIRQStatsTimestamp();
+			pxVectorEntry->Handler( pxVectorEntry->CallBackRef );
+			ulElapsed = prvIRQStatsTimestamp() - ulStart;
+
+			if( ulDepth <= portIRQ_STATS_MAX_NESTING )
+			{
+				/* Charge the time to this handler only, and to the nested time
+				of the handler it interrupted. */
+				if( ulDepth > 1UL )
+				{
+					ulIRQStatsNestedTicks[ ulDepth - 1UL ] += ulElapsed;
+				}
+				ulElapsed -= ulIRQStatsNestedTicks[ ulDepth ];
+			}
+
+			prvIRQStatsRecord( ulInterruptID, ulDepth, ulElapsed );
+		}
+		#else
+		{
+			pxVectorEntry->Handler( pxVectorEntry->CallBackRef );
+		}
+		#endif /* configUSE_IRQ_STATS */
 	}
 }
 /*-----------------------------------------------------------*/
@@ -284,9 +453,10 @@ volatile char *pcOverflowingTaskName = pcTaskName;
 
 #if (configSUPPORT_STATIC_ALLOCATION == 1)
 /* Buffers below are used for static memory allocation for idle
- * task. */
+ * task.  The stacks are laid out by portSTATIC_STACK_WORDS(), with a guard
+ * page below them when configUSE_STACK_GUARD_PAGES is set. */
 static StaticTask_t xIdleTaskTCB;
-static StackType_t  xIdleTaskStack[ configMINIMAL_STACK_SIZE ];
+static StackType_t  xIdleTaskStack[ portSTATIC_STACK_WORDS( configMINIMAL_STACK_SIZE ) ] portSTATIC_STACK_ATTRIBUTES;
 void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer,
                                     StackType_t **ppxIdleTaskStackBuffer,
                                     uint32_t *pulIdleTaskStackSize )
@@ -295,20 +465,32 @@ void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer,
     state will be stored. */
     *ppxIdleTaskTCBBuffer = &xIdleTaskTCB;
 
-    /* Pass out the array that will be used as the Idle task's stack. */
-    *ppxIdleTaskStackBuffer = xIdleTaskStack;
+    /* Pass out the stack in the array and its size.  Note that, as the array
+    is necessarily of type StackType_t, the size is specified in words, not
+    bytes, at least configMINIMAL_STACK_SIZE. */
+    *ppxIdleTaskStackBuffer = pxPortStaticStack( xIdleTaskStack, sizeof( xIdleTaskStack ) / sizeof( StackType_t ), pulIdleTaskStackSize );
+}
 
-    /* Pass out the size of the array pointed to by *ppxIdleTaskStackBuffer.
-    Note that, as the array is necessarily of type StackType_t,
-    configMINIMAL_STACK_SIZE is specified in words, not bytes. */
-    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+#if ( configNUMBER_OF_CORES > 1 )
+/* Idle tasks of the cores other than core 0. */
+static StaticTask_t xPassiveIdleTaskTCBs[ configNUMBER_OF_CORES - 1 ];
+static StackType_t  xPassiveIdleTaskStacks[ configNUMBER_OF_CORES - 1 ][ portSTATIC_STACK_WORDS( configMINIMAL_STACK_SIZE ) ] portSTATIC_STACK_ATTRIBUTES;
+void vApplicationGetPassiveIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer,
+                                           StackType_t **ppxIdleTaskStackBuffer,
+                                           uint32_t *pulIdleTaskStackSize,
+                                           BaseType_t xPassiveIdleTaskIndex )
+{
+    *ppxIdleTaskTCBBuffer = &xPassiveIdleTaskTCBs[ xPassiveIdleTaskIndex ];
+    *ppxIdleTaskStackBuffer = pxPortStaticStack( xPassiveIdleTaskStacks[ xPassiveIdleTaskIndex ],
+                                                 sizeof( xPassiveIdleTaskStacks[ 0 ] ) / sizeof( StackType_t ), pulIdleTaskStackSize );
 }
+#endif
 
 /*-----------------------------------------------*/
 /* Buffers below are used for static memory allocation for timer
  * task. */
 static StaticTask_t xTimerTaskTCB;
-static StackType_t  xTimerTaskStack[ configTIMER_TASK_STACK_DEPTH ];
+static StackType_t  xTimerTaskStack[ portSTATIC_STACK_WORDS( configTIMER_TASK_STACK_DEPTH ) ] portSTATIC_STACK_ATTRIBUTES;
 void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer,
                                      StackType_t **ppxTimerTaskStackBuffer,
                                      uint32_t *pulTimerTaskStackSize )
@@ -317,12 +499,8 @@ void vApplicationGetTimerTaskMemory( StaticTask_t **ppxTimerTaskTCBBuffer,
     task's state will be stored. */
     *ppxTimerTaskTCBBuffer = &xTimerTaskTCB;
 
-    /* Pass out the array that will be used as the Timer task's stack. */
-    *ppxTimerTaskStackBuffer = xTimerTaskStack;
-
-    /* Pass out the size of the array pointed to by *ppxTimerTaskStackBuffer.
-    Note that, as the array is necessarily of type StackType_t,
-    configTIMER_TASK_STACK_DEPTH is specified in words, not bytes. */
-    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+    /* Pass out the stack in the array and its size, in words, at least
+    configTIMER_TASK_STACK_DEPTH. */
+    *ppxTimerTaskStackBuffer = pxPortStaticStack( xTimerTaskStack, sizeof( xTimerTaskStack ) / sizeof( StackType_t ), pulTimerTaskStackSize );
 }
 #endif
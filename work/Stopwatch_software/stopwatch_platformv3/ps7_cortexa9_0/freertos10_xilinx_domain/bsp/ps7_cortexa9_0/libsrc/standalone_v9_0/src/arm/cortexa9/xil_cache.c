@@ -160,6 +160,179 @@ static void Xil_L2CacheSync(void)
 	Xil_Out32(XPS_L2CC_BASEADDR + XPS_L2CC_CACHE_SYNC_OFFSET, 0x0U);
 }
 #endif
+
+#define XIL_CACHE_LINE	32U	/**< L1 and L2 cache line size in bytes */
+#define XIL_CACHE_LINE_MASK	(XIL_CACHE_LINE - 1U)
+
+/***************************************************************************/
+/**
+*
+* Return the length of the next chunk of a range, so that interrupts are not
+* masked for more than XIL_CACHE_RANGE_CHUNK bytes of maintenance at a time.
+* Ranges are walked by length rather than up to an end address, which is 0
+* for a range that ends at the top of the address space (high OCM).
+*
+* @param	len: bytes left in the range.
+*
+* @return	Length of the chunk in bytes.
+*
+****************************************************************************/
+static inline u32 Xil_DCacheChunkLen(u32 len)
+{
+	return (len > XIL_CACHE_RANGE_CHUNK) ? XIL_CACHE_RANGE_CHUNK : len;
+}
+
+/***************************************************************************/
+/**
+*
+* Flush the L1 and L2 Data cache lines of an address range. The L2 clean
+* and invalidate by PA operations are issued back to back; the caller
+* issues the L2 cache sync once for the whole batch.
+*
+* @param	adr: start address of the range.
+* @param	len: length of the range in bytes.
+*
+* @return	None.
+*
+****************************************************************************/
+static void Xil_DCacheFlushSpan(u32 adr, u32 len)
+{
+	u32 currmask;
+	u32 chunklen;
+	u32 offset;
+#ifndef USE_AMP
+	volatile u32 *L2CCOffset = (volatile u32 *)(XPS_L2CC_BASEADDR +
+				    XPS_L2CC_CACHE_INV_CLN_PA_OFFSET);
+#endif
+
+	/* Cover the partial first line from its start */
+	len += adr & XIL_CACHE_LINE_MASK;
+	adr &= ~XIL_CACHE_LINE_MASK;
+
+	while (len != 0U) {
+		chunklen = Xil_DCacheChunkLen(len);
+
+		currmask = mfcpsr();
+		mtcpsr(currmask | IRQ_FIQ_MASK);
+
+		for (offset = 0U; offset < chunklen; offset += XIL_CACHE_LINE) {
+			/* Flush L1 Data cache line */
+#if defined (__GNUC__) || defined (__ICCARM__)
+			asm_cp15_clean_inval_dc_line_mva_poc(adr + offset);
+#else
+			{ volatile register u32 Reg
+				__asm(XREG_CP15_CLEAN_INVAL_DC_LINE_MVA_POC);
+			  Reg = adr + offset; }
+#endif
+		}
+		/* Wait for L1 cache clean and invalidation to complete */
+		dsb();
+
+#ifndef USE_AMP
+		/* Disable Write-back and line fills */
+		Xil_L2WriteDebugCtrl(0x3U);
+		for (offset = 0U; offset < chunklen; offset += XIL_CACHE_LINE) {
+			/* Flush L2 cache line */
+			*L2CCOffset = adr + offset;
+		}
+		/* Enable Write-back and line fills */
+		Xil_L2WriteDebugCtrl(0x0U);
+#endif
+		mtcpsr(currmask);
+		adr += chunklen;
+		len -= chunklen;
+	}
+}
+
+/***************************************************************************/
+/**
+*
+* Invalidate the L1 and L2 Data cache lines of an address range. Partial
+* cache lines at either end are flushed instead, see
+* Xil_DCacheInvalidateRange. Each chunk invalidates L2 first, syncs L2 once
+* and then invalidates L1, so a line fill cannot bring stale L2 data back
+* into L1.
+*
+* @param	adr: start address of the range.
+* @param	len: length of the range in bytes, not 0.
+*
+* @return	None.
+*
+****************************************************************************/
+static void Xil_DCacheInvalidateSpan(u32 adr, u32 len)
+{
+	u32 firstline = adr & ~XIL_CACHE_LINE_MASK;
+	u32 lastline = (adr + len - 1U) & ~XIL_CACHE_LINE_MASK;
+	u32 currmask;
+	u32 chunklen;
+	u32 offset;
+#ifndef USE_AMP
+	volatile u32 *L2CCOffset = (volatile u32 *)(XPS_L2CC_BASEADDR +
+				    XPS_L2CC_CACHE_INVLD_PA_OFFSET);
+#endif
+
+	currmask = mfcpsr();
+	mtcpsr(currmask | IRQ_FIQ_MASK);
+	if ((adr & XIL_CACHE_LINE_MASK) != 0U) {
+		Xil_L1DCacheFlushLine(firstline);
+#ifndef USE_AMP
+		/* Disable Write-back and line fills */
+		Xil_L2WriteDebugCtrl(0x3U);
+		Xil_L2CacheFlushLine(firstline);
+		/* Enable Write-back and line fills */
+		Xil_L2WriteDebugCtrl(0x0U);
+#endif
+		offset = XIL_CACHE_LINE - (adr & XIL_CACHE_LINE_MASK);
+		len = (len > offset) ? (len - offset) : 0U;
+		adr = firstline + XIL_CACHE_LINE;
+	}
+	if ((len != 0U) && (((adr + len) & XIL_CACHE_LINE_MASK) != 0U)) {
+		Xil_L1DCacheFlushLine(lastline);
+#ifndef USE_AMP
+		/* Disable Write-back and line fills */
+		Xil_L2WriteDebugCtrl(0x3U);
+		Xil_L2CacheFlushLine(lastline);
+		/* Enable Write-back and line fills */
+		Xil_L2WriteDebugCtrl(0x0U);
+#endif
+	}
+	mtcpsr(currmask);
+
+	/*
+	 * The flushed last line is invalidated below as well, so a line that
+	 * was prefetched again in the meantime cannot survive.
+	 */
+	while (len != 0U) {
+		chunklen = Xil_DCacheChunkLen(len);
+
+		currmask = mfcpsr();
+		mtcpsr(currmask | IRQ_FIQ_MASK);
+
+#ifndef USE_AMP
+		for (offset = 0U; offset < chunklen; offset += XIL_CACHE_LINE) {
+			/* Invalidate L2 cache line */
+			*L2CCOffset = adr + offset;
+		}
+		Xil_L2CacheSync();
+#endif
+		for (offset = 0U; offset < chunklen; offset += XIL_CACHE_LINE) {
+			/* Invalidate L1 Data cache line */
+#if defined (__GNUC__) || defined (__ICCARM__)
+			asm_cp15_inval_dc_line_mva_poc(adr + offset);
+#else
+			{ volatile register u32 Reg
+				__asm(XREG_CP15_INVAL_DC_LINE_MVA_POC);
+			  Reg = adr + offset; }
+#endif
+		}
+		/* Wait for L1 cache invalidation to complete */
+		dsb();
+
+		mtcpsr(currmask);
+		adr += chunklen;
+		len -= chunklen;
+	}
+}
 /****************************************************************************/
 /**
 * @brief	Enable the Data cache.
@@ -307,77 +480,9 @@ void Xil_DCacheInvalidateLine(u32 adr)
 ****************************************************************************/
 void Xil_DCacheInvalidateRange(INTPTR adr, u32 len)
 {
-	const u32 cacheline = 32U;
-	INTPTR tempadr;
-	INTPTR opendaddr;
-	INTPTR endaddr;
-	u32 currmask;
-	volatile u32 *L2CCOffset = (volatile u32 *)(XPS_L2CC_BASEADDR +
-				    XPS_L2CC_CACHE_INVLD_PA_OFFSET);
-
-	currmask = mfcpsr();
-	mtcpsr(currmask | IRQ_FIQ_MASK);
-
 	if (len != 0U) {
-		opendaddr = adr + len;
-		endaddr = opendaddr;
-
-		if ((adr & (cacheline-1U)) != 0U) {
-			adr &= (~(cacheline - 1U));
-
-			Xil_L1DCacheFlushLine(adr);
-#ifndef USE_AMP
-			/* Disable Write-back and line fills */
-			Xil_L2WriteDebugCtrl(0x3U);
-			Xil_L2CacheFlushLine(adr);
-			/* Enable Write-back and line fills */
-			Xil_L2WriteDebugCtrl(0x0U);
-			Xil_L2CacheSync();
-#endif
-			adr += cacheline;
-		}
-		if ((opendaddr & (cacheline-1U)) != 0U) {
-			opendaddr &= (~(cacheline - 1U));
-
-			if (opendaddr != adr) {
-				Xil_L1DCacheFlushLine(opendaddr);
-#ifndef USE_AMP
-				/* Disable Write-back and line fills */
-				Xil_L2WriteDebugCtrl(0x3U);
-				Xil_L2CacheFlushLine(opendaddr);
-				/* Enable Write-back and line fills */
-				Xil_L2WriteDebugCtrl(0x0U);
-				Xil_L2CacheSync();
-#endif
-			}
-		}
-
-		tempadr = adr;
-
-#ifndef USE_AMP
-		while (tempadr < endaddr) {
-			/* Invalidate L2 cache line */
-			*L2CCOffset = tempadr;
-			Xil_L2CacheSync();
-			tempadr += cacheline;
-		}
-#endif
-
-		while (adr < endaddr) {
-	/* Invalidate L1 Data cache line */
-#if defined (__GNUC__) || defined (__ICCARM__)
-			asm_cp15_inval_dc_line_mva_poc(adr);
-#else
-			{ volatile register u32 Reg
-				__asm(XREG_CP15_INVAL_DC_LINE_MVA_POC);
-			  Reg = adr; }
-#endif
-			adr += cacheline;
-		}
-		/* Wait for L1 cache invalidation to complete */
-		dsb();
+		Xil_DCacheInvalidateSpan((u32)adr, len);
 	}
-	mtcpsr(currmask);
 }
 
 /****************************************************************************/
@@ -448,54 +553,90 @@ void Xil_DCacheFlushLine(u32 adr)
 *
 * @return	None.
 *
+* @note		Ranges of XIL_CACHE_FLUSH_ALL_THRESHOLD bytes or more flush the
+*			whole Data cache by set/way instead, which is cheaper than
+*			walking that many lines. L2 line operations are issued back to
+*			back with a single L2 cache sync, and interrupts are unmasked
+*			every XIL_CACHE_RANGE_CHUNK bytes.
+*
 ****************************************************************************/
 void Xil_DCacheFlushRange(INTPTR adr, u32 len)
 {
-	const u32 cacheline = 32U;
-	u32 opendadr;
-	u32 currmask;
-	u32 tempadr;
-
-	volatile u32 *L2CCOffset = (volatile u32 *)(XPS_L2CC_BASEADDR +
-				    XPS_L2CC_CACHE_INV_CLN_PA_OFFSET);
-
-	currmask = mfcpsr();
-	mtcpsr(currmask | IRQ_FIQ_MASK);
-
-	if (len != 0U) {
-		opendadr = adr + len;
-		adr &= ~(cacheline - 1U);
-
-		tempadr = adr;
-
-		while (tempadr < opendadr) {
-			/* Flush L1 Data cache line */
-#if defined (__GNUC__) || defined (__ICCARM__)
-			asm_cp15_clean_inval_dc_line_mva_poc(tempadr);
-#else
-			{ volatile register u32 Reg
-				__asm(XREG_CP15_CLEAN_INVAL_DC_LINE_MVA_POC);
-			  Reg = tempadr; }
+	if (len >= XIL_CACHE_FLUSH_ALL_THRESHOLD) {
+		Xil_DCacheFlush();
+	} else if (len != 0U) {
+		Xil_DCacheFlushSpan((u32)adr, len);
+#ifndef USE_AMP
+		Xil_L2CacheSync();
 #endif
-			tempadr += cacheline;
+	}
+}
+
+/****************************************************************************/
+/**
+* @brief	Flush the Data cache for a list of address ranges, for example
+*			the buffers of a DMA descriptor chain. Same as calling
+*			Xil_DCacheFlushRange for each range, but the L2 cache is synced
+*			once for the whole list and the whole Data cache is flushed
+*			instead when the ranges add up to XIL_CACHE_FLUSH_ALL_THRESHOLD
+*			bytes or more.
+*
+* @param	Ranges: array of address ranges.
+* @param	Count: number of entries in Ranges.
+*
+* @return	None.
+*
+****************************************************************************/
+void Xil_DCacheFlushRanges(const Xil_CacheRange *Ranges, u32 Count)
+{
+	u32 total = 0U;
+	u32 i;
+
+	for (i = 0U; i < Count; i++) {
+		total += Ranges[i].Len;
+		if (total >= XIL_CACHE_FLUSH_ALL_THRESHOLD) {
+			Xil_DCacheFlush();
+			return;
 		}
-		/* Wait for L1 cache clean and invalidation to complete */
-		dsb();
+	}
 
-#ifndef USE_AMP
-		/* Disable Write-back and line fills */
-		Xil_L2WriteDebugCtrl(0x3U);
-		while ((u32)adr < opendadr) {
-			/* Flush L2 cache line */
-			*L2CCOffset = adr;
-			Xil_L2CacheSync();
-			adr += cacheline;
+	for (i = 0U; i < Count; i++) {
+		if (Ranges[i].Len != 0U) {
+			Xil_DCacheFlushSpan((u32)Ranges[i].Addr, Ranges[i].Len);
 		}
-		Xil_L2WriteDebugCtrl(0x0U);
+	}
+#ifndef USE_AMP
+	Xil_L2CacheSync();
 #endif
+}
+
+/****************************************************************************/
+/**
+* @brief	Invalidate the Data cache for a list of address ranges. Same as
+*			calling Xil_DCacheInvalidateRange for each range; the notes on
+*			unaligned start and end addresses apply to every range.
+*
+* @param	Ranges: array of address ranges.
+* @param	Count: number of entries in Ranges.
+*
+* @return	None.
+*
+* @note		There is no whole cache shortcut for invalidation: invalidating
+*			by set/way would discard unrelated dirty data, and flushing
+*			instead would write stale lines over the DMA data in the ranges.
+*
+****************************************************************************/
+void Xil_DCacheInvalidateRanges(const Xil_CacheRange *Ranges, u32 Count)
+{
+	u32 i;
+
+	for (i = 0U; i < Count; i++) {
+		if (Ranges[i].Len != 0U) {
+			Xil_DCacheInvalidateSpan((u32)Ranges[i].Addr, Ranges[i].Len);
+		}
 	}
-	mtcpsr(currmask);
 }
+
 /****************************************************************************/
 /**
 * @brief	Store a Data cache line. If the byte specified by the address (adr)
@@ -34,9 +34,42 @@
 extern "C" {
 #endif
 
+/************************** Constant Definitions ****************************/
+
+/**
+ * Implementations of Xil_MemCpy, Xil_MemSet and Xil_MemMove, selected at
+ * build time with XIL_MEM_IMPL.
+ */
+#define XIL_MEM_IMPL_C		0U	/**< Portable C, word at a time */
+#define XIL_MEM_IMPL_LDM	1U	/**< Cortex-A9 LDM/STM bursts of 32 bytes */
+#define XIL_MEM_IMPL_NEON	2U	/**< Cortex-A9 NEON, 64 bytes per loop */
+
+/**
+ * The LDM/STM version is the default on ARMv7-A. The NEON version needs
+ * -mfpu=neon and must not be called from interrupt handlers of a kernel
+ * that does not save the FPU registers on interrupt entry.
+ */
+#ifndef XIL_MEM_IMPL
+#if defined(__arm__) && !defined(__aarch64__) && defined(__ARM_ARCH_7A__)
+#define XIL_MEM_IMPL	XIL_MEM_IMPL_LDM
+#else
+#define XIL_MEM_IMPL	XIL_MEM_IMPL_C
+#endif
+#endif
+
+/**
+ * Distance in bytes ahead of the source at which the burst loops issue PLD,
+ * about three cache lines for the latency of the L2 cache.
+ */
+#ifndef XIL_MEM_PLD_OFFSET
+#define XIL_MEM_PLD_OFFSET	96
+#endif
+
 /************************** Function Prototypes *****************************/
 
 void Xil_MemCpy(void* dst, const void* src, u32 cnt);
+void Xil_MemSet(void* dst, u8 val, u32 cnt);
+void Xil_MemMove(void* dst, const void* src, u32 cnt);
 
 #ifdef __cplusplus
 }
@@ -85,12 +85,39 @@ extern "C" {
 *@endcond
 */
 
+/**
+ * Xil_DCacheFlushRange and Xil_DCacheFlushRanges flush the whole Data cache
+ * instead of line by line for ranges of this many bytes or more.
+ */
+#ifndef XIL_CACHE_FLUSH_ALL_THRESHOLD
+#define XIL_CACHE_FLUSH_ALL_THRESHOLD	0x20000U
+#endif
+
+/**
+ * Range maintenance keeps interrupts masked for at most this many bytes of
+ * cache lines at a time.
+ */
+#ifndef XIL_CACHE_RANGE_CHUNK
+#define XIL_CACHE_RANGE_CHUNK	0x2000U
+#endif
+
+/**
+ * One buffer of a scatter list for Xil_DCacheFlushRanges and
+ * Xil_DCacheInvalidateRanges.
+ */
+typedef struct {
+	INTPTR Addr;	/**< Start address of the buffer */
+	u32 Len;	/**< Length of the buffer in bytes */
+} Xil_CacheRange;
+
 void Xil_DCacheEnable(void);
 void Xil_DCacheDisable(void);
 void Xil_DCacheInvalidate(void);
 void Xil_DCacheInvalidateRange(INTPTR adr, u32 len);
 void Xil_DCacheFlush(void);
 void Xil_DCacheFlushRange(INTPTR adr, u32 len);
+void Xil_DCacheFlushRanges(const Xil_CacheRange *Ranges, u32 Count);
+void Xil_DCacheInvalidateRanges(const Xil_CacheRange *Ranges, u32 Count);
 
 void Xil_ICacheEnable(void);
 void Xil_ICacheDisable(void);
@@ -95,10 +95,26 @@
 
 /****************************** Include Files *********************************/
 #include "xil_util.h"
+#include "xil_mem.h"
 #include "sleep.h"
 
 /************************** Constant Definitions ****************************/
 #define MAX_NIBBLES	8U /**< maximum nibbles */
+#define XIL_UTIL_CT_BLOCK	16U /**< bytes per loop of Xil_SMemCmp_CT for aligned buffers */
+
+/**
+ * The secure wrappers use the xil_mem.c primitives when XIL_MEM_IMPL selects
+ * an optimised version, the C library otherwise.
+ */
+#if XIL_MEM_IMPL == XIL_MEM_IMPL_C
+#define XIL_UTIL_MEMCPY(Dst, Src, Len)	(void)memcpy((Dst), (Src), (Len))
+#define XIL_UTIL_MEMSET(Dst, Val, Len)	(void)memset((Dst), (s32)(Val), (Len))
+#define XIL_UTIL_MEMMOVE(Dst, Src, Len)	(void)memmove((Dst), (Src), (Len))
+#else
+#define XIL_UTIL_MEMCPY(Dst, Src, Len)	Xil_MemCpy((Dst), (Src), (Len))
+#define XIL_UTIL_MEMSET(Dst, Val, Len)	Xil_MemSet((Dst), (Val), (Len))
+#define XIL_UTIL_MEMMOVE(Dst, Src, Len)	Xil_MemMove((Dst), (Src), (Len))
+#endif
 
 /************************** Function Prototypes *****************************/
 void (*fptr)(void) = NULL;
@@ -779,13 +795,7 @@ s32 Xil_SecureMemCpy(void *DestPtr, u32 DestPtrLen, const void *SrcPtr, u32 Len)
 		goto END;
 	}
 
-	/* Loop and copy.  */
-	while (Len != 0U) {
-		*Dest = *Src;
-		Dest++;
-		Src++;
-		Len--;
-	}
+	XIL_UTIL_MEMCPY(Dest, Src, Len);
 	Status = XST_SUCCESS;
 
 END:
@@ -818,6 +828,16 @@ s32 Xil_MemCmp(const void *Buf1Ptr, const void *Buf2Ptr, u32 Len)
 		goto END;
 	}
 
+	/* Skip the equal words of aligned buffers, the bytes decide the order */
+	if ((((UINTPTR)Buf1 | (UINTPTR)Buf2) & 3U) == 0U) {
+		while ((Size >= sizeof(u32)) &&
+		       (*(const u32 *)Buf1 == *(const u32 *)Buf2)) {
+			Buf1 += sizeof(u32);
+			Buf2 += sizeof(u32);
+			Size -= sizeof(u32);
+		}
+	}
+
 	/* Loop and compare */
 	while (Size != 0U) {
 		if (*Buf1 > *Buf2) {
@@ -951,6 +971,25 @@ s32 Xil_SMemCmp_CT(const void *Src1, const u32 Src1Size,
 	} else if ((CmpLen == 0U) || (Src1Size < CmpLen) || (Src2Size < CmpLen)) {
 		Status =  XST_INVALID_PARAM;
 	} else {
+		/*
+		 * Aligned buffers are compared four words per loop. The loop
+		 * count depends on the length and alignment only, never on the
+		 * contents.
+		 */
+		if ((((UINTPTR)Src_1 | (UINTPTR)Src_2) & 3U) == 0U) {
+			while (Cnt >= XIL_UTIL_CT_BLOCK) {
+				const u32 *Word_1 = (const u32 *)Src_1;
+				const u32 *Word_2 = (const u32 *)Src_2;
+
+				Data |= (Word_1[0] ^ Word_2[0]) | (Word_1[1] ^ Word_2[1]) |
+					(Word_1[2] ^ Word_2[2]) | (Word_1[3] ^ Word_2[3]);
+				DataRedundant &= ~Data;
+				Src_1 += XIL_UTIL_CT_BLOCK;
+				Src_2 += XIL_UTIL_CT_BLOCK;
+				Cnt -= XIL_UTIL_CT_BLOCK;
+			}
+		}
+
 		while (Cnt >= sizeof(u32)) {
 			Data |= (*(const u32 *)Src_1 ^ * (const u32 *)Src_2);
 			DataRedundant &= ~Data;
@@ -1013,7 +1052,7 @@ s32 Xil_SMemCpy(void *Dest, const u32 DestSize,
 	} else if ((Dst8 < Src8) && (&Dst8[CopyLen - 1U] >= Src8)) {
 		Status =  XST_INVALID_PARAM;
 	} else {
-		(void)memcpy(DestTemp, SrcTemp, CopyLen);
+		XIL_UTIL_MEMCPY(DestTemp, SrcTemp, CopyLen);
 		Status = XST_SUCCESS;
 	}
 
@@ -1045,7 +1084,7 @@ s32 Xil_SMemSet(void *Dest, const u32 DestSize,
 	if ((Dest == NULL) || (DestSize < Len) || (Len == 0U)) {
 		Status =  XST_INVALID_PARAM;
 	} else {
-		(void)memset(Dest, (s32)Data, Len);
+		XIL_UTIL_MEMSET(Dest, Data, Len);
 		Status = XST_SUCCESS;
 	}
 
@@ -1253,17 +1292,14 @@ s32 Xil_SMemMove(void *Dest, const u32 DestSize,
 		 const void *Src, const u32 SrcSize, const u32 CopyLen)
 {
 	volatile int Status = XST_FAILURE;
-	const void *Output = NULL;
 
 	if ((Dest == NULL) || (Src == NULL)) {
 		Status =  XST_INVALID_PARAM;
 	} else if ((CopyLen == 0U) || (DestSize < CopyLen) || (SrcSize < CopyLen)) {
 		Status =  XST_INVALID_PARAM;
 	} else {
-		Output = memmove(Dest, Src, CopyLen);
-		if (Output != NULL) {
-			Status = XST_SUCCESS;
-		}
+		XIL_UTIL_MEMMOVE(Dest, Src, CopyLen);
+		Status = XST_SUCCESS;
 	}
 
 	return Status;
@@ -11,6 +11,13 @@
 * This file contains xil mem copy function to use in case of word aligned
 * data copies.
 *
+* On Cortex-A9 the bulk of Xil_MemCpy and Xil_MemSet runs as LDM/STM bursts
+* of 32 bytes, one cache line, or with NEON as 64 byte loads and stores.
+* XIL_MEM_IMPL in xil_mem.h selects the version at build time. The burst
+* loops prefetch the source XIL_MEM_PLD_OFFSET bytes ahead. A misaligned
+* head is copied bytewise up to a word (LDM/STM) or doubleword (NEON)
+* boundary of the destination. Word, halfword and byte loops copy the tail.
+*
 * <pre>
 * MODIFICATION HISTORY:
 *
@@ -32,23 +39,30 @@
 #include "xil_types.h"
 #include "xil_mem.h"
 
+#if (XIL_MEM_IMPL == XIL_MEM_IMPL_NEON) && !defined(__ARM_NEON__) && !defined(__ARM_NEON)
+#error XIL_MEM_IMPL_NEON needs a NEON enabled build (-mfpu=neon)
+#endif
+
+/************************** Constant Definitions ****************************/
+
+#define XIL_MEM_BURST		32U	/**< Bytes per LDM/STM loop */
+#define XIL_MEM_NEON_BURST	64U	/**< Bytes per NEON loop */
+
 /***************** Inline Functions Definitions ********************/
 /*****************************************************************************/
 /**
-* @brief       This  function copies memory from once location to other.
+* @brief       Copies the tail of a block, words first, then a halfword and
+*              bytes.
 *
-* @param       dst: pointer pointing to destination memory
+* @param       d: pointer pointing to destination memory
 *
-* @param       src: pointer pointing to source memory
+* @param       s: pointer pointing to source memory
 *
 * @param       cnt: 32 bit length of bytes to be copied
 *
 *****************************************************************************/
-void Xil_MemCpy(void* dst, const void* src, u32 cnt)
+static inline void Xil_MemCpyTail(char *d, const char *s, u32 cnt)
 {
-	char *d = (char*)(void *)dst;
-	const char *s = src;
-
 	while (cnt >= sizeof (s32)) {
 		*(s32*)d = *(s32*)s;
 		d += sizeof (s32);
@@ -68,3 +82,180 @@ void Xil_MemCpy(void* dst, const void* src, u32 cnt)
 		cnt -= 1U;
 	}
 }
+
+/*****************************************************************************/
+/**
+* @brief       This  function copies memory from once location to other.
+*              The copy runs forward, so the regions may overlap when dst is
+*              below src.
+*
+* @param       dst: pointer pointing to destination memory
+*
+* @param       src: pointer pointing to source memory
+*
+* @param       cnt: 32 bit length of bytes to be copied
+*
+*****************************************************************************/
+void Xil_MemCpy(void* dst, const void* src, u32 cnt)
+{
+	char *d = (char*)(void *)dst;
+	const char *s = src;
+
+#if XIL_MEM_IMPL == XIL_MEM_IMPL_LDM
+	/* LDM/STM need both word aligned, else the word loop copies unaligned */
+	if ((((UINTPTR)d ^ (UINTPTR)s) & 3U) == 0U) {
+		while ((cnt > 0U) && (((UINTPTR)d & 3U) != 0U)) {
+			*d = *s;
+			d += 1U;
+			s += 1U;
+			cnt -= 1U;
+		}
+		while (cnt >= XIL_MEM_BURST) {
+			__asm__ __volatile__(
+				"pld	[%1, %2]\n"
+				"ldmia	%1!, {r3-r6}\n"
+				"stmia	%0!, {r3-r6}\n"
+				"ldmia	%1!, {r3-r6}\n"
+				"stmia	%0!, {r3-r6}\n"
+				: "+r" (d), "+r" (s)
+				: "I" (XIL_MEM_PLD_OFFSET)
+				: "r3", "r4", "r5", "r6", "memory");
+			cnt -= XIL_MEM_BURST;
+		}
+	}
+#elif XIL_MEM_IMPL == XIL_MEM_IMPL_NEON
+	/* VLD1/VST1 take any alignment, aligned stores are faster */
+	if (cnt >= XIL_MEM_NEON_BURST) {
+		while (((UINTPTR)d & 7U) != 0U) {
+			*d = *s;
+			d += 1U;
+			s += 1U;
+			cnt -= 1U;
+		}
+	}
+	while (cnt >= XIL_MEM_NEON_BURST) {
+		__asm__ __volatile__(
+			"pld	[%1, %2]\n"
+			"vld1.8	{d0-d3}, [%1]!\n"
+			"vld1.8	{d4-d7}, [%1]!\n"
+			"vst1.8	{d0-d3}, [%0]!\n"
+			"vst1.8	{d4-d7}, [%0]!\n"
+			: "+r" (d), "+r" (s)
+			: "I" (XIL_MEM_PLD_OFFSET)
+			: "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "memory");
+		cnt -= XIL_MEM_NEON_BURST;
+	}
+#endif
+
+	Xil_MemCpyTail(d, s, cnt);
+}
+
+/*****************************************************************************/
+/**
+* @brief       This function fills memory with a byte value.
+*
+* @param       dst: pointer pointing to destination memory
+*
+* @param       val: byte value written
+*
+* @param       cnt: 32 bit length of bytes to be written
+*
+*****************************************************************************/
+void Xil_MemSet(void* dst, u8 val, u32 cnt)
+{
+	char *d = (char*)dst;
+	u32 word = (u32)val * 0x01010101U;
+#if XIL_MEM_IMPL != XIL_MEM_IMPL_C
+	u32 blocks;
+#endif
+
+	while ((cnt > 0U) && (((UINTPTR)d & 3U) != 0U)) {
+		*d = (char)val;
+		d += 1U;
+		cnt -= 1U;
+	}
+
+#if XIL_MEM_IMPL == XIL_MEM_IMPL_LDM
+	blocks = cnt / XIL_MEM_BURST;
+	if (blocks != 0U) {
+		__asm__ __volatile__(
+			"mov	r3, %2\n"
+			"mov	r4, %2\n"
+			"mov	r5, %2\n"
+			"mov	r6, %2\n"
+			"1:\n"
+			"stmia	%0!, {r3-r6}\n"
+			"stmia	%0!, {r3-r6}\n"
+			"subs	%1, %1, #1\n"
+			"bne	1b\n"
+			: "+r" (d), "+r" (blocks)
+			: "r" (word)
+			: "r3", "r4", "r5", "r6", "cc", "memory");
+		cnt &= XIL_MEM_BURST - 1U;
+	}
+#elif XIL_MEM_IMPL == XIL_MEM_IMPL_NEON
+	blocks = cnt / XIL_MEM_NEON_BURST;
+	if (blocks != 0U) {
+		__asm__ __volatile__(
+			"vdup.32	q0, %2\n"
+			"vmov	q1, q0\n"
+			"1:\n"
+			"vst1.8	{d0-d3}, [%0]!\n"
+			"vst1.8	{d0-d3}, [%0]!\n"
+			"subs	%1, %1, #1\n"
+			"bne	1b\n"
+			: "+r" (d), "+r" (blocks)
+			: "r" (word)
+			: "d0", "d1", "d2", "d3", "cc", "memory");
+		cnt &= XIL_MEM_NEON_BURST - 1U;
+	}
+#endif
+
+	while (cnt >= sizeof (u32)) {
+		*(u32*)d = word;
+		d += sizeof (u32);
+		cnt -= sizeof (u32);
+	}
+	while (cnt > 0U) {
+		*d = (char)val;
+		d += 1U;
+		cnt -= 1U;
+	}
+}
+
+/*****************************************************************************/
+/**
+* @brief       This function copies memory between regions that may overlap.
+*
+* @param       dst: pointer pointing to destination memory
+*
+* @param       src: pointer pointing to source memory
+*
+* @param       cnt: 32 bit length of bytes to be copied
+*
+*****************************************************************************/
+void Xil_MemMove(void* dst, const void* src, u32 cnt)
+{
+	char *d = (char*)dst;
+	const char *s = src;
+
+	if (((UINTPTR)d <= (UINTPTR)s) || ((UINTPTR)d >= ((UINTPTR)s + cnt))) {
+		Xil_MemCpy(dst, src, cnt);
+	} else {
+		/* Destination above an overlapping source, copy backwards */
+		d += cnt;
+		s += cnt;
+		while (cnt >= sizeof (u32)) {
+			d -= sizeof (u32);
+			s -= sizeof (u32);
+			*(u32*)d = *(const u32*)s;
+			cnt -= sizeof (u32);
+		}
+		while (cnt > 0U) {
+			d -= 1U;
+			s -= 1U;
+			*d = *s;
+			cnt -= 1U;
+		}
+	}
+}
@@ -48,6 +48,8 @@
 #include "xil_types.h"
 #include "xil_mmu.h"
 #include "xil_errata.h"
+#include "xreg_cortexa9.h"
+#include "xstatus.h"
 
 /***************** Macros (Inline Functions) Definitions *********************/
 
@@ -55,17 +57,377 @@
 
 /************************** Constant Definitions *****************************/
 
-#define	ARM_AR_MEM_TTB_SECT_SIZE	1024*1024 /**< Each TTB descriptor
+#define	ARM_AR_MEM_TTB_SECT_SIZE	(1024U*1024U) /**< Each TTB descriptor
                                                    *   covers a 1MB region */
 #define	ARM_AR_MEM_TTB_SECT_SIZE_MASK	(~(ARM_AR_MEM_TTB_SECT_SIZE-1UL))
 /**< Mask off lower bits of addr */
 
+#define	ARM_AR_MEM_PAGE_SIZE		0x1000U	/**< Small page size */
+#define	ARM_AR_MEM_PAGES_PER_SECT	256U	/**< Small pages in a section */
+
+#define	ARM_AR_MEM_DESC_TYPE_MASK	0x3U	/**< First level descriptor type */
+#define	ARM_AR_MEM_DESC_COARSE		0x1U	/**< Points to a page table */
+#define	ARM_AR_MEM_DESC_DOMAIN_MASK	0x1E0U	/**< Domain field, both formats */
+#define	ARM_AR_MEM_COARSE_BASE_MASK	0xFFFFFC00U	/**< Page table address */
+
+/**
+ * Pending TLB invalidations by MVA per batch, beyond that the whole TLB is
+ * invalidated.
+ */
+#define	XIL_MMU_TLB_OPS_MAX		32U
+
+/**
+ * Pending data cache flush ranges per batch, beyond that the whole data
+ * cache is flushed.
+ */
+#define	XIL_MMU_FLUSH_RANGES_MAX	8U
+
 /************************** Variable Definitions *****************************/
 
 extern u32 MMUTable;
 
+/** Second level page tables, 256 small page descriptors each */
+static u32 MmuPageTable[XIL_MMU_NUM_PAGE_TABLES][ARM_AR_MEM_PAGES_PER_SECT]
+		__attribute__ ((aligned(1024)));
+static u32 MmuPageTableUsed;	/**< Bit n set: MmuPageTable[n] in use */
+static u32 MmuPageTableFreeing;	/**< Released, reusable after the next TLB invalidate */
+
+/** State of the current Xil_MmuBeginUpdate/Xil_MmuEndUpdate batch */
+static u32 MmuBatchDepth;
+static u32 MmuTlbMva[XIL_MMU_TLB_OPS_MAX];
+static u32 MmuTlbCount;
+static u32 MmuTlbAll;
+static Xil_CacheRange MmuFlushRange[XIL_MMU_FLUSH_RANGES_MAX];
+static u32 MmuFlushCount;
+static u32 MmuFlushAll;
+
 /************************** Function Prototypes ******************************/
 
+/*****************************************************************************/
+/**
+* @brief	Convert first level section attributes, as defined in xil_mmu.h,
+*			to the equivalent second level small page attributes.
+*
+* @param	attrib  Section attributes.
+*
+* @return	Small page descriptor without the page address, 0 (a fault
+*			entry) for a fault section such as RESERVED.
+*
+******************************************************************************/
+static u32 Xil_MmuSectionToPageAttr(u32 attrib)
+{
+	u32 page = 0x2U;				/* Small page */
+
+	if ((attrib & ARM_AR_MEM_DESC_TYPE_MASK) == 0U) {
+		return 0U;
+	}
+
+	page |= attrib & 0xCU;				/* C, B */
+	page |= ((attrib >> 10) & 0x3U) << 4;		/* AP[1:0] */
+	page |= ((attrib >> 12) & 0x7U) << 6;		/* TEX */
+	page |= ((attrib >> 15) & 0x1U) << 9;		/* AP[2] */
+	page |= ((attrib >> 16) & 0x1U) << 10;		/* S */
+	page |= ((attrib >> 17) & 0x1U) << 11;		/* nG */
+	page |= (attrib >> 4) & 0x1U;			/* XN */
+
+	return page;
+}
+
+/*****************************************************************************/
+/**
+* @brief	Small page descriptor of a page.
+*
+* @param	Addr  Page aligned address.
+* @param	page  Attributes from Xil_MmuSectionToPageAttr.
+*
+* @return	The descriptor, 0 for a fault page.
+*
+******************************************************************************/
+static u32 Xil_MmuPageDesc(u32 Addr, u32 page)
+{
+	return (page != 0U) ? (Addr | page) : 0U;
+}
+
+/*****************************************************************************/
+/**
+* @brief	Queue a TLB invalidation by MVA for the current batch.
+*
+* @param	Addr  Address covered by the changed descriptor.
+*
+* @return	None.
+*
+******************************************************************************/
+static void Xil_MmuQueueTlb(u32 Addr)
+{
+	if (MmuTlbCount < XIL_MMU_TLB_OPS_MAX) {
+		MmuTlbMva[MmuTlbCount] = Addr & ~(ARM_AR_MEM_PAGE_SIZE - 1U);
+		MmuTlbCount++;
+	} else {
+		MmuTlbAll = 1U;
+	}
+}
+
+/*****************************************************************************/
+/**
+* @brief	Queue a data cache flush of a remapped region for the current
+*			batch.
+*
+* @param	Addr  Start address of the region.
+* @param	Size  Size of the region in bytes.
+*
+* @return	None.
+*
+******************************************************************************/
+static void Xil_MmuQueueFlush(u32 Addr, u32 Size)
+{
+	if (MmuFlushCount < XIL_MMU_FLUSH_RANGES_MAX) {
+		MmuFlushRange[MmuFlushCount].Addr = (INTPTR)Addr;
+		MmuFlushRange[MmuFlushCount].Len = Size;
+		MmuFlushCount++;
+	} else {
+		MmuFlushAll = 1U;
+	}
+}
+
+/*****************************************************************************/
+/**
+* @brief	Write a section descriptor. A page table previously referenced
+*			by the entry is released, and since its 4 KB TLB entries cannot
+*			be reached with a single invalidation by MVA, the whole TLB is
+*			invalidated at the end of the batch.
+*
+* @param	Addr  Section aligned address.
+* @param	attrib  Section attributes.
+*
+* @return	None.
+*
+******************************************************************************/
+static void Xil_MmuWriteSection(u32 Addr, u32 attrib)
+{
+	u32 *ptr = &MMUTable + (Addr / ARM_AR_MEM_TTB_SECT_SIZE);
+	u32 old = *ptr;
+	u32 index;
+
+	*ptr = (Addr & ARM_AR_MEM_TTB_SECT_SIZE_MASK) | attrib;
+	Xil_DCacheFlushRange((INTPTR)ptr, sizeof(u32));
+
+	if ((old & ARM_AR_MEM_DESC_TYPE_MASK) == ARM_AR_MEM_DESC_COARSE) {
+		index = ((old & ARM_AR_MEM_COARSE_BASE_MASK) -
+			 (u32)&MmuPageTable[0][0]) / sizeof(MmuPageTable[0]);
+		if (index < XIL_MMU_NUM_PAGE_TABLES) {
+			MmuPageTableFreeing |= (1U << index);
+		}
+		MmuTlbAll = 1U;
+	} else {
+		Xil_MmuQueueTlb(Addr);
+	}
+}
+
+/*****************************************************************************/
+/**
+* @brief	Return the page table of a section, splitting the section into
+*			256 small pages with its current attributes if needed.
+*
+* @param	Addr  Address within the section.
+*
+* @return	Pointer to the page table, NULL if none is left.
+*
+* @note		Unchanged pages keep the address and attributes of the section,
+*			so a stale section entry in the TLB still translates them
+*			correctly and only the changed pages need an invalidation.
+*
+******************************************************************************/
+static u32 *Xil_MmuGetPageTable(u32 Addr)
+{
+	u32 *ptr = &MMUTable + (Addr / ARM_AR_MEM_TTB_SECT_SIZE);
+	u32 section = Addr & ARM_AR_MEM_TTB_SECT_SIZE_MASK;
+	u32 *table;
+	u32 page;
+	u32 index;
+	u32 i;
+
+	if ((*ptr & ARM_AR_MEM_DESC_TYPE_MASK) == ARM_AR_MEM_DESC_COARSE) {
+		return (u32 *)(*ptr & ARM_AR_MEM_COARSE_BASE_MASK);
+	}
+
+	for (index = 0U; index < XIL_MMU_NUM_PAGE_TABLES; index++) {
+		if (((MmuPageTableUsed | MmuPageTableFreeing) & (1U << index)) == 0U) {
+			break;
+		}
+	}
+	if (index == XIL_MMU_NUM_PAGE_TABLES) {
+		return NULL;
+	}
+	MmuPageTableUsed |= (1U << index);
+	table = MmuPageTable[index];
+
+	page = Xil_MmuSectionToPageAttr(*ptr);
+	for (i = 0U; i < ARM_AR_MEM_PAGES_PER_SECT; i++) {
+		table[i] = Xil_MmuPageDesc(section + (i * ARM_AR_MEM_PAGE_SIZE), page);
+	}
+	Xil_DCacheFlushRange((INTPTR)table, sizeof(MmuPageTable[0]));
+
+	/* The table must be visible to the table walk before it is linked */
+	*ptr = (u32)table | (*ptr & ARM_AR_MEM_DESC_DOMAIN_MASK) |
+	       ARM_AR_MEM_DESC_COARSE;
+	Xil_DCacheFlushRange((INTPTR)ptr, sizeof(u32));
+
+	return table;
+}
+
+/*****************************************************************************/
+/**
+* @brief	Start a batch of translation table updates. TLB invalidation,
+*			branch predictor invalidation and the data cache flush of the
+*			remapped regions are deferred to the matching Xil_MmuEndUpdate,
+*			so a set of regions costs one round of maintenance instead of
+*			one per section. Batches can be nested.
+*
+* @return	None.
+*
+******************************************************************************/
+void Xil_MmuBeginUpdate(void)
+{
+	MmuBatchDepth++;
+}
+
+/*****************************************************************************/
+/**
+* @brief	End a batch of translation table updates and apply them. Changed
+*			entries are invalidated in the TLB by MVA, or the whole TLB is
+*			invalidated when more than XIL_MMU_TLB_OPS_MAX entries changed.
+*			Then the remapped regions are flushed from the data cache so no
+*			line cached under the old attributes survives.
+*
+* @return	None.
+*
+******************************************************************************/
+void Xil_MmuEndUpdate(void)
+{
+	u32 i;
+
+	if (MmuBatchDepth == 0U) {
+		return;
+	}
+	MmuBatchDepth--;
+	if (MmuBatchDepth != 0U) {
+		return;
+	}
+
+	/* Make the descriptor writes visible before invalidating */
+	dsb();
+	if (MmuTlbAll != 0U) {
+		mtcp(XREG_CP15_INVAL_UTLB_UNLOCKED, 0U);
+		MmuPageTableUsed &= ~MmuPageTableFreeing;
+		MmuPageTableFreeing = 0U;
+	} else {
+		for (i = 0U; i < MmuTlbCount; i++) {
+			mtcp(XREG_CP15_INVAL_UTLB_MVA, MmuTlbMva[i]);
+		}
+	}
+	/* Invalidate all branch predictors */
+	mtcp(XREG_CP15_INVAL_BRANCH_ARRAY, 0U);
+
+	dsb(); /* ensure completion of the BP and TLB invalidation */
+	isb(); /* synchronize context on this processor */
+
+	if (MmuFlushAll != 0U) {
+		Xil_DCacheFlush();
+	} else if (MmuFlushCount != 0U) {
+		Xil_DCacheFlushRanges(MmuFlushRange, MmuFlushCount);
+	}
+
+	MmuTlbCount = 0U;
+	MmuTlbAll = 0U;
+	MmuFlushCount = 0U;
+	MmuFlushAll = 0U;
+}
+
+/*****************************************************************************/
+/**
+* @brief	Set the memory attributes of an identity mapped region with 4 KB
+*			granularity. Whole 1 MB sections are written as section entries,
+*			other parts of a section are split into a second level page
+*			table taken from a pool of XIL_MMU_NUM_PAGE_TABLES tables.
+*
+*			This makes it possible to give a DMA buffer pool NORM_NONCACHE
+*			or NORM_WRITE_COMBINE attributes, so the drivers using it need
+*			no cache maintenance, without changing the rest of its section.
+*
+* @param	Addr  4 KB aligned start address of the region.
+* @param	Size  Size of the region in bytes, a multiple of 4 KB.
+* @param	attrib  Section attributes as defined in xil_mmu.h, converted to
+*			small page attributes where pages are used.
+*
+* @return	XST_SUCCESS, XST_INVALID_PARAM for a misaligned region or
+*			XST_FAILURE when the page table pool is exhausted. The part of
+*			the region processed before the failure keeps its new
+*			attributes.
+*
+* @note		Applied immediately, or at Xil_MmuEndUpdate inside a batch. The
+*			region is flushed from the data cache, so it must not be the
+*			target of a DMA transfer in progress.
+*
+******************************************************************************/
+s32 Xil_MmuSetRegionAttributes(INTPTR Addr, u32 Size, u32 attrib)
+{
+	u32 adr = (u32)Addr;
+	u32 remaining = Size;
+	u32 currmask;
+	u32 *table;
+	u32 page;
+	u32 count;
+	u32 first;
+	u32 i;
+	s32 Status = XST_SUCCESS;
+
+	if (((adr | Size) & (ARM_AR_MEM_PAGE_SIZE - 1U)) != 0U) {
+		return XST_INVALID_PARAM;
+	}
+
+	Xil_MmuBeginUpdate();
+	if (Size != 0U) {
+		Xil_MmuQueueFlush(adr, Size);
+	}
+	page = Xil_MmuSectionToPageAttr(attrib);
+
+	while (remaining != 0U) {
+		currmask = mfcpsr();
+		mtcpsr(currmask | XREG_CPSR_IRQ_ENABLE | XREG_CPSR_FIQ_ENABLE);
+
+		if (((adr & ~ARM_AR_MEM_TTB_SECT_SIZE_MASK) == 0U) &&
+		    (remaining >= ARM_AR_MEM_TTB_SECT_SIZE)) {
+			Xil_MmuWriteSection(adr, attrib);
+			count = ARM_AR_MEM_PAGES_PER_SECT;
+		} else {
+			table = Xil_MmuGetPageTable(adr);
+			if (table == NULL) {
+				mtcpsr(currmask);
+				Status = XST_FAILURE;
+				break;
+			}
+			first = (adr & ~ARM_AR_MEM_TTB_SECT_SIZE_MASK) /
+				ARM_AR_MEM_PAGE_SIZE;
+			count = ARM_AR_MEM_PAGES_PER_SECT - first;
+			if (count > (remaining / ARM_AR_MEM_PAGE_SIZE)) {
+				count = remaining / ARM_AR_MEM_PAGE_SIZE;
+			}
+			for (i = 0U; i < count; i++) {
+				table[first + i] = Xil_MmuPageDesc(adr + (i * ARM_AR_MEM_PAGE_SIZE), page);
+				Xil_MmuQueueTlb(adr + (i * ARM_AR_MEM_PAGE_SIZE));
+			}
+			Xil_DCacheFlushRange((INTPTR)&table[first], count * sizeof(u32));
+		}
+
+		mtcpsr(currmask);
+		adr += count * ARM_AR_MEM_PAGE_SIZE;
+		remaining -= count * ARM_AR_MEM_PAGE_SIZE;
+	}
+
+	Xil_MmuEndUpdate();
+	return Status;
+}
+
 /*****************************************************************************/
 /**
 * @brief	This function sets the memory attributes for a section covering 1MB
@@ -80,29 +442,24 @@ extern u32 MMUTable;
 * @return	None.
 *
 * @note		The MMU or D-cache does not need to be disabled before changing a
-*			translation table entry.
+*			translation table entry. Inside a Xil_MmuBeginUpdate batch the
+*			TLB invalidation and cache flush are deferred to
+*			Xil_MmuEndUpdate. A page table previously covering the section
+*			is returned to the pool.
 *
 ******************************************************************************/
 void Xil_SetTlbAttributes(INTPTR Addr, u32 attrib)
 {
-	u32 *ptr;
-	u32 section;
-
-	section = Addr / 0x100000U;
-	ptr = &MMUTable;
-	ptr += section;
-	if(ptr != NULL) {
-		*ptr = (Addr & 0xFFF00000U) | attrib;
-	}
-
-	Xil_DCacheFlush();
-
-	mtcp(XREG_CP15_INVAL_UTLB_UNLOCKED, 0U);
-	/* Invalidate all branch predictors */
-	mtcp(XREG_CP15_INVAL_BRANCH_ARRAY, 0U);
+	u32 currmask;
 
-	dsb(); /* ensure completion of the BP and TLB invalidation */
-    isb(); /* synchronize context on this processor */
+	Xil_MmuBeginUpdate();
+	currmask = mfcpsr();
+	mtcpsr(currmask | XREG_CPSR_IRQ_ENABLE | XREG_CPSR_FIQ_ENABLE);
+	Xil_MmuWriteSection((u32)Addr & ARM_AR_MEM_TTB_SECT_SIZE_MASK, attrib);
+	mtcpsr(currmask);
+	Xil_MmuQueueFlush((u32)Addr & ARM_AR_MEM_TTB_SECT_SIZE_MASK,
+			  ARM_AR_MEM_TTB_SECT_SIZE);
+	Xil_MmuEndUpdate();
 }
 
 /*****************************************************************************/
@@ -195,7 +552,9 @@ void* Xil_MemMap(UINTPTR PhysAddr, size_t size, u32 flags)
    PhysAddr &= ARM_AR_MEM_TTB_SECT_SIZE_MASK;
 
    /* Loop through entire region of memory (one MMU section at a time).
-      Each section requires a TTB entry. */
+      Each section requires a TTB entry. The TLB and cache maintenance
+      is done once for the whole region. */
+   Xil_MmuBeginUpdate();
    for (Sectionoffset = 0; Sectionoffset < size;
 		Sectionoffset += ARM_AR_MEM_TTB_SECT_SIZE) {
        /* Calculate translation table entry for this memory section */
@@ -204,5 +563,6 @@ void* Xil_MemMap(UINTPTR PhysAddr, size_t size, u32 flags)
        /* Write translation table entry value to entry address */
        Xil_SetTlbAttributes(Ttbaddr, flags);
    }
+   Xil_MmuEndUpdate();
    return (void*)PhysAddr;
 }
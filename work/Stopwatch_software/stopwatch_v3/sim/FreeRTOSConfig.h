@@ -0,0 +1,73 @@
+/*
+ * FreeRTOS configuration of the host simulation on the POSIX port, see sim.h.
+ *
+ * Same priorities and queue/timer features as the Zynq build (bsp
+ * include/FreeRTOSConfig.h), without the port specific extensions: fast heap
+ * pools, interrupt statistics and the PMU and sampling profilers. The tick
+ * runs at 1 kHz instead of 100 Hz so the scenarios time presses to the
+ * millisecond.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <assert.h>
+
+#define configUSE_PREEMPTION					1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION	0
+#define configUSE_TIME_SLICING					1
+#define configUSE_IDLE_HOOK						0
+#define configUSE_TICK_HOOK						0
+#define configUSE_MALLOC_FAILED_HOOK			0
+#define configCHECK_FOR_STACK_OVERFLOW			0
+#define configTICK_RATE_HZ						( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES					( 8 )
+#define configSTACK_DEPTH_TYPE					uint32_t
+#define configMINIMAL_STACK_SIZE				( ( configSTACK_DEPTH_TYPE ) 8192 )	/* Words, printf on the host needs more than on the target */
+#define configTOTAL_HEAP_SIZE					( ( size_t ) ( 16 * 1024 * 1024 ) )
+#define configMAX_TASK_NAME_LEN					( 16 )
+#define configUSE_16_BIT_TICKS					0
+#define configIDLE_SHOULD_YIELD					1
+#define configUSE_MUTEXES						1
+#define configUSE_RECURSIVE_MUTEXES				1
+#define configUSE_COUNTING_SEMAPHORES			1
+#define configUSE_QUEUE_SETS					1
+#define configQUEUE_REGISTRY_SIZE				10
+#define configUSE_TASK_NOTIFICATIONS			1
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES	2
+/* make STATIC=1 builds without heap, as the static Zynq build, see sim_static.c */
+#ifndef configSUPPORT_DYNAMIC_ALLOCATION
+#define configSUPPORT_DYNAMIC_ALLOCATION		1
+#endif
+#ifndef configSUPPORT_STATIC_ALLOCATION
+#define configSUPPORT_STATIC_ALLOCATION			0
+#endif
+#define configUSE_TRACE_FACILITY				1
+#define configGENERATE_RUN_TIME_STATS			0
+
+#define configUSE_TIMERS						1
+#define configTIMER_TASK_PRIORITY				( configMAX_PRIORITIES - 1 )
+#define configTIMER_QUEUE_LENGTH				10
+#define configTIMER_TASK_STACK_DEPTH			( configMINIMAL_STACK_SIZE )
+
+#define configUSE_FAST_HEAP						0
+#define configUSE_IRQ_STATS						0
+#define configUSE_PMU_PROFILING					0
+#define configUSE_SAMPLING_PROFILER				0
+
+#define configASSERT( x )						assert( x )
+
+#define INCLUDE_vTaskPrioritySet				1
+#define INCLUDE_uxTaskPriorityGet				1
+#define INCLUDE_vTaskDelete						1
+#define INCLUDE_vTaskSuspend					1
+#define INCLUDE_xTaskDelayUntil					1
+#define INCLUDE_vTaskDelay						1
+#define INCLUDE_xTaskGetSchedulerState			1
+#define INCLUDE_xTaskGetCurrentTaskHandle		1
+#define INCLUDE_uxTaskGetStackHighWaterMark		1
+#define INCLUDE_xTaskGetIdleTaskHandle			1
+#define INCLUDE_eTaskGetState					1
+#define INCLUDE_xTimerPendFunctionCall			1
+
+#endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,63 @@
+/*
+ * FreeRTOS configuration of the host EDF comparison (edf_main.c), built
+ * against the kernel of the BSP with the host port in ../smp on one core.
+ *
+ * Same scheduler options as the Zynq build with configUSE_EDF_SCHEDULING set
+ * to 1, and a 10 kHz tick so that the budgets of a few milliseconds scale to
+ * the loads in steps of 100 us. The tick is virtual (configSIM_VIRTUAL_TICK),
+ * its rate costs no host time.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <assert.h>
+
+#define configNUMBER_OF_CORES					1
+#define configUSE_EDF_SCHEDULING				1
+#define configEDF_PRIORITY						2
+#define configEDF_UTILISATION_LIMIT				90
+#define configUSE_PREEMPTION					1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION	0
+#define configUSE_TIME_SLICING					1
+#define configUSE_IDLE_HOOK						1	/* Polls for interrupts, see port.c */
+#define configUSE_TICK_HOOK						0
+#define configUSE_MALLOC_FAILED_HOOK			0
+#define configCHECK_FOR_STACK_OVERFLOW			0
+#define configTICK_RATE_HZ						( ( TickType_t ) 10000 )
+#define configSIM_VIRTUAL_TICK					1	/* See ../smp/portmacro.h */
+#define configMAX_PRIORITIES					( 8 )
+#define configSTACK_DEPTH_TYPE					uint32_t
+#define configMINIMAL_STACK_SIZE				( ( configSTACK_DEPTH_TYPE ) 8192 )	/* Words, printf on the host needs more than on the target */
+#define configTOTAL_HEAP_SIZE					( ( size_t ) ( 16 * 1024 * 1024 ) )
+#define configMAX_TASK_NAME_LEN					( 16 )
+#define configUSE_16_BIT_TICKS					0
+#define configIDLE_SHOULD_YIELD					1
+#define configUSE_MUTEXES						1
+#define configUSE_RECURSIVE_MUTEXES				1
+#define configUSE_COUNTING_SEMAPHORES			1
+#define configUSE_TASK_NOTIFICATIONS			1
+#define configSUPPORT_DYNAMIC_ALLOCATION		1
+#define configSUPPORT_STATIC_ALLOCATION			0
+#define configUSE_TRACE_FACILITY				1
+#define configGENERATE_RUN_TIME_STATS			0
+
+#define configUSE_TIMERS						1
+#define configTIMER_TASK_PRIORITY				( configMAX_PRIORITIES - 1 )
+#define configTIMER_QUEUE_LENGTH				10
+#define configTIMER_TASK_STACK_DEPTH			( configMINIMAL_STACK_SIZE )
+
+#define configASSERT( x )						assert( x )
+
+#define INCLUDE_vTaskPrioritySet				1
+#define INCLUDE_uxTaskPriorityGet				1
+#define INCLUDE_vTaskDelete						1
+#define INCLUDE_vTaskSuspend					1
+#define INCLUDE_xTaskDelayUntil					1
+#define INCLUDE_vTaskDelay						1
+#define INCLUDE_xTaskGetSchedulerState			1
+#define INCLUDE_xTaskGetCurrentTaskHandle		1
+#define INCLUDE_xTaskGetIdleTaskHandle			1
+#define INCLUDE_eTaskGetState					1
+
+#endif /* FREERTOS_CONFIG_H */
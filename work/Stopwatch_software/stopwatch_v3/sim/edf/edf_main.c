@@ -0,0 +1,317 @@
+/*
+ * Host comparison of EDF scheduling (configUSE_EDF_SCHEDULING) with the fixed
+ * priority policies, on the kernel of the BSP and the host port in ../smp
+ * running one core.
+ *
+ * Four periodic tasks shaped like the stopwatch tasks (period/deadline/budget
+ * in ms):
+ *
+ *  capture  10/3/1   button and timer capture, short deadline
+ *  control  10/10/1
+ *  led      20/20/2
+ *  display  33/33/8
+ *
+ * run under each policy at several processor loads, every job of a task
+ * running the same whole number of ticks, its budget scaled by the load over
+ * the load of the budgets (54%), so past that load the jobs overrun:
+ *
+ *  rr   all at priority 0, round robin, as the stopwatch creates them today
+ *  dm   fixed priorities in deadline order
+ *  edf  xTaskCreateEdf(), earliest deadline first
+ *
+ * Time is virtual (configSIM_VIRTUAL_TICK): a job calls vPortSimTick() for
+ * each tick of work and the idle hook for each idle tick, so the runs are the
+ * same on every host, and as every job starts and ends on a tick the kernel
+ * charges each tick to the job that used it.
+ *
+ * One CSV row per task, policy and load ("edf," lines) with the jobs, the
+ * deadline misses and the worst lateness, and a row for the whole set. The
+ * process exits with 1 if admission control accepts a task set it must
+ * refuse, if the EDF run misses a deadline while the densities of the jobs
+ * sum to 100% or less, if the kernel counts other budget overruns than the
+ * jobs longer than their budgets, or if its counts disagree with the tasks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define EDF_CONTROL_PRIORITY	(configMAX_PRIORITIES - 2)
+#define EDF_RUN_MS				1320U	/* Two hyperperiods of the set */
+#define EDF_MS(ms)				pdMS_TO_TICKS(ms)
+
+#define EDF_STACK	configMINIMAL_STACK_SIZE
+
+typedef enum {
+	POLICY_RR,
+	POLICY_DM,
+	POLICY_EDF,
+	POLICIES
+} EdfPolicy;
+
+typedef struct {
+	const char *name;
+	TaskEdfParameters_t edf;
+	UBaseType_t dmPriority;
+} EdfTaskSpec;
+
+typedef struct {
+	const EdfTaskSpec *spec;
+	TaskHandle_t handle;
+	TickType_t work;			/* Ticks run per job */
+	volatile uint32_t jobs;
+	volatile uint32_t misses;
+	volatile TickType_t maxLateness;
+} EdfTaskRun;
+
+static const EdfTaskSpec specs[] = {
+	{ "capture", { EDF_MS(10), EDF_MS(3), EDF_MS(1) }, 4 },
+	{ "control", { EDF_MS(10), EDF_MS(10), EDF_MS(1) }, 3 },
+	{ "led", { EDF_MS(20), EDF_MS(20), EDF_MS(2) }, 2 },
+	{ "display", { EDF_MS(33), EDF_MS(33), EDF_MS(8) }, 1 },
+};
+
+#define EDF_TASKS	(sizeof(specs) / sizeof(specs[0]))
+
+static const char * const policyNames[POLICIES] = { "rr", "dm", "edf" };
+static const uint32_t loads[] = { 50, 80, 100, 120 };	/* Percent of the processor */
+
+static EdfTaskRun runs[EDF_TASKS];
+static EdfPolicy policy;
+static TickType_t xFirstRelease;
+static int failed;
+
+/* Runs for the given number of ticks, preempted at the ticks only */
+static void edfWork(TickType_t ticks)
+{
+	for(TickType_t i = 0; i < ticks; i++) {
+		vPortSimTick();
+	}
+}
+
+static void vJobTask(void *pvParameters)
+{
+	EdfTaskRun *run = pvParameters;
+	const TaskEdfParameters_t *edf = &run->spec->edf;
+	TickType_t release = xFirstRelease;
+
+	while(1) {
+		edfWork(run->work);
+
+		TickType_t end = xTaskGetTickCount();
+		TickType_t deadline = release + edf->xDeadline;
+		BaseType_t met = end < deadline;
+
+		if(policy == POLICY_EDF) {
+			/* The same verdict, from the kernel: the tick at the end of the
+			 * last tick of work is taken before the job ends */
+			met = xTaskEdfWaitForNextPeriod();
+			release += edf->xPeriod;
+		}
+		if(!met) {
+			run->misses++;
+			if(end >= deadline && end - deadline > run->maxLateness) {
+				run->maxLateness = end - deadline;
+			}
+		}
+		run->jobs++;
+		if(policy != POLICY_EDF) {
+			vTaskDelayUntil(&release, edf->xPeriod);
+		}
+	}
+}
+
+/* Budget over period of the task set, in thousandths */
+static uint32_t edfUtilisation(void)
+{
+	uint32_t total = 0;
+
+	for(uint32_t i = 0; i < EDF_TASKS; i++) {
+		total += (uint32_t)((specs[i].edf.xBudget * 1000U) / specs[i].edf.xPeriod);
+	}
+	return total;
+}
+
+/* Sum of work over period (load) or over deadline (density) of the jobs, in
+ * thousandths. A job ending in the tick of its deadline has missed it, so
+ * the densities are taken with deadlines one tick shorter. */
+static uint32_t edfJobShare(int density)
+{
+	uint64_t total = 0;
+
+	for(uint32_t i = 0; i < EDF_TASKS; i++) {
+		TickType_t span = density ? specs[i].edf.xDeadline - 1U : specs[i].edf.xPeriod;
+
+		total += ((uint64_t)runs[i].work * 1000000U) / span;
+	}
+	return (uint32_t)(total / 1000U);
+}
+
+static void edfRun(EdfPolicy p, uint32_t load)
+{
+	const uint32_t utilisation = edfUtilisation();
+	uint32_t jobs = 0, misses = 0, overruns = 0, expected = 0;
+	TickType_t lateness = 0;
+
+	policy = p;
+	vTaskSuspendAll();
+	xFirstRelease = xTaskGetTickCount();
+	for(uint32_t i = 0; i < EDF_TASKS; i++) {
+		EdfTaskRun *run = &runs[i];
+		BaseType_t created;
+
+		run->spec = &specs[i];
+		run->jobs = 0;
+		run->misses = 0;
+		run->maxLateness = 0;
+		/* Budget scaled from the load of the budgets to the load of the run,
+		 * rounded to the nearest tick */
+		run->work = (TickType_t)(((uint64_t)specs[i].edf.xBudget * load * 20U + utilisation) / (2U * utilisation));
+		if(run->work == 0U) {
+			run->work = 1U;
+		}
+
+		if(p == POLICY_EDF) {
+			created = xTaskCreateEdf(vJobTask, specs[i].name, EDF_STACK, run, &specs[i].edf, &run->handle);
+		} else {
+			created = xTaskCreate(vJobTask, specs[i].name, EDF_STACK, run,
+					p == POLICY_DM ? specs[i].dmPriority : tskIDLE_PRIORITY, &run->handle);
+		}
+		if(created != pdPASS) {
+			printf("Error: task %s unsuccessfully created!\n", specs[i].name);
+			exit(2);
+		}
+	}
+	(void)xTaskResumeAll();
+
+	vTaskDelay(EDF_MS(EDF_RUN_MS));
+
+	vTaskSuspendAll();
+	for(uint32_t i = 0; i < EDF_TASKS; i++) {
+		EdfTaskRun *run = &runs[i];
+
+		if(p == POLICY_EDF) {
+			TaskEdfStats_t stats;
+			int overrun = run->work > specs[i].edf.xBudget;
+
+			/* The kernel counts a job when it ends, the task once it is
+			 * released again, the kernel is one job ahead in between. An
+			 * overrun is counted once the job has run past its budget, the
+			 * job running at the end of the run may have. */
+			vTaskEdfGetStats(run->handle, &stats);
+			if(stats.ulJobs - run->jobs > 1U || stats.ulDeadlineMisses - run->misses > stats.ulJobs - run->jobs ||
+					(overrun ? stats.ulBudgetOverruns - stats.ulJobs > 1U : stats.ulBudgetOverruns != 0U)) {
+				printf("Error: %s kernel counts %u jobs %u misses %u overruns, task %u jobs %u misses of %u ticks\n",
+						specs[i].name, (unsigned)stats.ulJobs, (unsigned)stats.ulDeadlineMisses,
+						(unsigned)stats.ulBudgetOverruns, (unsigned)run->jobs, (unsigned)run->misses, (unsigned)run->work);
+				failed = 1;
+			}
+			overruns += stats.ulBudgetOverruns;
+			expected += overrun ? stats.ulJobs : 0U;
+		}
+		vTaskDelete(run->handle);
+		run->handle = NULL;
+
+		printf("edf,%s,%u,%s,%u,%u,%.1f,%.1f\n", policyNames[p], (unsigned)load, specs[i].name,
+				(unsigned)run->jobs, (unsigned)run->misses,
+				run->jobs ? 100.0 * run->misses / run->jobs : 0.0, run->maxLateness * 1000.0 / configTICK_RATE_HZ);
+		jobs += run->jobs;
+		misses += run->misses;
+		if(run->maxLateness > lateness) {
+			lateness = run->maxLateness;
+		}
+	}
+	(void)xTaskResumeAll();
+
+	printf("edf,%s,%u,all,%u,%u,%.1f,%.1f\n", policyNames[p], (unsigned)load,
+			(unsigned)jobs, (unsigned)misses, jobs ? 100.0 * misses / jobs : 0.0, lateness * 1000.0 / configTICK_RATE_HZ);
+	if(p == POLICY_EDF) {
+		const uint32_t density = edfJobShare(1);
+
+		printf("# edf at %u%%: jobs load %.1f%%, density %.1f%%, %u budget overruns of %u jobs past their budgets\n",
+				(unsigned)load, edfJobShare(0) / 10.0, density / 10.0, (unsigned)overruns, (unsigned)expected);
+		/* Densities within 100% are enough for EDF to meet every deadline */
+		if(density <= 1000U && misses != 0U) {
+			printf("Error: EDF missed %u of %u deadlines at a density of %u.%u%%\n", (unsigned)misses, (unsigned)jobs,
+					(unsigned)(density / 10U), (unsigned)(density % 10U));
+			failed = 1;
+		}
+	}
+	fflush(stdout);
+}
+
+static void vIdleJob(void *pvParameters)
+{
+	(void)pvParameters;
+
+	while(1) {
+		(void)xTaskEdfWaitForNextPeriod();
+	}
+}
+
+/* The stopwatch set uses 78% of the processor in densities, budget over
+ * deadline, against a limit of configEDF_UTILISATION_LIMIT (90%) */
+static void checkAdmission(void)
+{
+	const TaskEdfParameters_t tooLarge = { EDF_MS(10), EDF_MS(10), EDF_MS(2) };	/* 20% */
+	const TaskEdfParameters_t fits = { EDF_MS(10), EDF_MS(10), EDF_MS(1) };		/* 10% */
+	TaskHandle_t handles[EDF_TASKS + 1];
+	BaseType_t refused, accepted;
+
+	for(uint32_t i = 0; i < EDF_TASKS; i++) {
+		if(xTaskCreateEdf(vIdleJob, specs[i].name, EDF_STACK, NULL, &specs[i].edf, &handles[i]) != pdPASS) {
+			printf("Error: task %s refused by admission control!\n", specs[i].name);
+			exit(2);
+		}
+	}
+	refused = xTaskCreateEdf(vIdleJob, "large", EDF_STACK, NULL, &tooLarge, NULL) == pdFAIL;
+	accepted = xTaskCreateEdf(vIdleJob, "fits", EDF_STACK, NULL, &fits, &handles[EDF_TASKS]) == pdPASS;
+	for(uint32_t i = 0; i < EDF_TASKS + accepted; i++) {
+		vTaskDelete(handles[i]);
+	}
+
+	printf("# admission %s: 20%% more refused %s, 10%% more accepted %s\n",
+			refused && accepted ? "ok" : "FAIL", refused ? "yes" : "no", accepted ? "yes" : "no");
+	failed |= !(refused && accepted);
+}
+
+static void vControl(void *pvParameters)
+{
+	(void)pvParameters;
+
+	checkAdmission();
+	/* Let the idle task free the deleted tasks */
+	vTaskDelay(pdMS_TO_TICKS(10));
+
+	printf("edf,policy,load_pct,task,jobs,misses,miss_pct,max_lateness_ms\n");
+	for(uint32_t l = 0; l < sizeof(loads) / sizeof(loads[0]); l++) {
+		for(EdfPolicy p = POLICY_RR; p < POLICIES; p++) {
+			edfRun(p, loads[l]);
+			vTaskDelay(pdMS_TO_TICKS(10));
+		}
+	}
+
+	exit(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/* An idle tick passes, unless a round robin job waits behind the idle task
+ * at its priority: the idle task yields to it first */
+void vApplicationIdleHook(void)
+{
+	for(uint32_t i = 0; i < EDF_TASKS; i++) {
+		if(runs[i].handle != NULL && eTaskGetState(runs[i].handle) == eReady) {
+			return;
+		}
+	}
+	vPortSimTick();
+}
+
+int main(void)
+{
+	xTaskCreate(vControl, "control", EDF_STACK, NULL, EDF_CONTROL_PRIORITY, NULL);
+	vTaskStartScheduler();
+
+	printf("Error: scheduler unsuccessfully started!\n");
+	return 1;
+}
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for the standalone BSP header of the same name, see ../sim.h.
+ */
+
+#ifndef SLEEP_H
+#define SLEEP_H
+
+#include <unistd.h>
+
+#endif /* SLEEP_H */
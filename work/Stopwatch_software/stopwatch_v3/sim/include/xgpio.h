@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for the gpio driver header, implemented by the model in
+ * ../sim_gpio.c.
+ */
+
+#ifndef XGPIO_H
+#define XGPIO_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+typedef struct {
+	UINTPTR BaseAddress;	/* Device base address */
+	u32 IsReady;			/* Device is initialized and ready */
+	int InterruptPresent;	/* Are interrupts supported in h/w */
+	int IsDual;				/* Are 2 channels supported in h/w */
+} XGpio;
+
+int XGpio_Initialize(XGpio *InstancePtr, u16 DeviceId);
+void XGpio_SetDataDirection(XGpio *InstancePtr, unsigned Channel, u32 DirectionMask);
+u32 XGpio_GetDataDirection(XGpio *InstancePtr, unsigned Channel);
+u32 XGpio_DiscreteRead(XGpio *InstancePtr, unsigned Channel);
+void XGpio_DiscreteWrite(XGpio *InstancePtr, unsigned Channel, u32 Data);
+void XGpio_DiscreteSet(XGpio *InstancePtr, unsigned Channel, u32 Mask);
+void XGpio_DiscreteClear(XGpio *InstancePtr, unsigned Channel, u32 Mask);
+
+#endif /* XGPIO_H */
@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the standalone BSP header of the same name, see ../sim.h.
+ */
+
+#ifndef XIL_PRINTF_H
+#define XIL_PRINTF_H
+
+#include <stdio.h>
+
+#define xil_printf	printf
+#define print(s)	fputs((s), stdout)
+
+#endif /* XIL_PRINTF_H */
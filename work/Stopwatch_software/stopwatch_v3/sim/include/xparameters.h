@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for the generated BSP header of the same name, see ../sim.h.
+ * Only the peripherals modelled by the simulation, with the values of the
+ * hardware design.
+ */
+
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+
+#define XPAR_GPIO_0_BASEADDR 0x41200000
+#define XPAR_GPIO_0_DEVICE_ID 0
+#define XPAR_GPIO_0_IS_DUAL 1
+
+#define XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ 100000000U
+#define XPAR_TMRCTR_0_DEVICE_ID 0U
+#define XPAR_TMRCTR_0_BASEADDR 0x42800000U
+#define XPAR_TMRCTR_0_CLOCK_FREQ_HZ XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ
+
+#endif /* XPARAMETERS_H */
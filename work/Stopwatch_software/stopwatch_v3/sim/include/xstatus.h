@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for the standalone BSP header of the same name, see ../sim.h.
+ */
+
+#ifndef XSTATUS_H
+#define XSTATUS_H
+
+#define XST_SUCCESS				0L
+#define XST_FAILURE				1L
+#define XST_DEVICE_NOT_FOUND	2L
+
+#endif /* XSTATUS_H */
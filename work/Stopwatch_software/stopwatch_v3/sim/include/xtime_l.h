@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for the standalone BSP header of the same name, see ../sim.h.
+ * The global timer reads the virtual clock of the AXI timer model.
+ */
+
+#ifndef XTIME_L_H
+#define XTIME_L_H
+
+#include "xil_types.h"
+#include "sim.h"
+
+typedef u64 XTime;
+
+#define COUNTS_PER_SECOND	SIM_CLOCK_HZ
+
+static inline void XTime_GetTime(XTime *Xtime_Global)
+{
+	*Xtime_Global = simClock();
+}
+
+#endif /* XTIME_L_H */
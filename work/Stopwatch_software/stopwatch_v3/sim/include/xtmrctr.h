@@ -0,0 +1,39 @@
+/*
+ * Host stand-in for the tmrctr driver header, implemented by the model in
+ * ../sim_tmrctr.c.
+ */
+
+#ifndef XTMRCTR_H
+#define XTMRCTR_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xtmrctr_l.h"
+
+#define XTC_DEVICE_TIMER_COUNT	2
+
+#define XTC_CASCADE_MODE_OPTION		0x00000080UL
+#define XTC_ENABLE_ALL_OPTION		0x00000040UL
+#define XTC_DOWN_COUNT_OPTION		0x00000020UL
+#define XTC_CAPTURE_MODE_OPTION		0x00000010UL
+#define XTC_INT_MODE_OPTION			0x00000008UL
+#define XTC_AUTO_RELOAD_OPTION		0x00000004UL
+#define XTC_EXT_COMPARE_OPTION		0x00000002UL
+
+typedef struct {
+	UINTPTR BaseAddress;	/* Base address of registers */
+	u32 IsReady;			/* Device is initialized and ready */
+	u32 IsStartedTmrCtr0;	/* Is Timer Counter 0 started */
+	u32 IsStartedTmrCtr1;	/* Is Timer Counter 1 started */
+} XTmrCtr;
+
+int XTmrCtr_Initialize(XTmrCtr *InstancePtr, u16 DeviceId);
+void XTmrCtr_SetOptions(XTmrCtr *InstancePtr, u8 TmrCtrNumber, u32 Options);
+u32 XTmrCtr_GetOptions(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+void XTmrCtr_SetResetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber, u32 ResetValue);
+u32 XTmrCtr_GetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+void XTmrCtr_Start(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+void XTmrCtr_Stop(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+void XTmrCtr_Reset(XTmrCtr *InstancePtr, u8 TmrCtrNumber);
+
+#endif /* XTMRCTR_H */
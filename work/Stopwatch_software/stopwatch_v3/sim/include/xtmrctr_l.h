@@ -0,0 +1,30 @@
+/*
+ * Host stand-in for the tmrctr low level header, the register accesses go to
+ * the model in ../sim_tmrctr.c.
+ */
+
+#ifndef XTMRCTR_L_H
+#define XTMRCTR_L_H
+
+#include "xil_types.h"
+
+#define XTC_TIMER_COUNTER_OFFSET	16
+
+#define XTC_TCSR_OFFSET		0	/* Control/Status register */
+#define XTC_TLR_OFFSET		4	/* Load register */
+#define XTC_TCR_OFFSET		8	/* Timer counter register */
+
+#define XTC_CSR_CASC_MASK			0x00000800U
+#define XTC_CSR_ENABLE_TMR_MASK		0x00000080U
+#define XTC_CSR_LOAD_MASK			0x00000020U
+
+u32 simTmrCtrReadReg(UINTPTR BaseAddress, u8 TmrCtrNumber, unsigned RegOffset);
+void simTmrCtrWriteReg(UINTPTR BaseAddress, u8 TmrCtrNumber, unsigned RegOffset, u32 ValueToWrite);
+
+#define XTmrCtr_ReadReg(BaseAddress, TmrCtrNumber, RegOffset) \
+	simTmrCtrReadReg((BaseAddress), (TmrCtrNumber), (RegOffset))
+
+#define XTmrCtr_WriteReg(BaseAddress, TmrCtrNumber, RegOffset, ValueToWrite) \
+	simTmrCtrWriteReg((BaseAddress), (TmrCtrNumber), (RegOffset), (ValueToWrite))
+
+#endif /* XTMRCTR_L_H */
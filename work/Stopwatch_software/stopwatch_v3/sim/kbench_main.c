@@ -0,0 +1,30 @@
+/*
+ * Host build of the kernel benchmarks (../src/kernel_bench.c) on the POSIX
+ * port, without the stopwatch. The suite exits the process once the table is
+ * printed.
+ */
+
+#include <time.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xil_printf.h"
+#include "kernel_bench.h"
+#include "sim.h"
+
+/* Global timer of the work queue timestamps, sim_scenario.c is not linked */
+uint64_t simClock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec) / (1000000000ULL / SIM_CLOCK_HZ);
+}
+
+int main(void)
+{
+	startKernelBenchmark();
+	vTaskStartScheduler();
+
+	xil_printf("Error: scheduler unsuccessfully started!\r\n");
+	return 1;
+}
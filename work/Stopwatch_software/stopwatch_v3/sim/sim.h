@@ -0,0 +1,34 @@
+/*
+ * Host simulation of the stopwatch on the FreeRTOS POSIX port, see
+ * sim_scenario.c.
+ *
+ * stopwatch_v3.c is built unchanged against the stand-in BSP headers in
+ * include/. The GPIO (sim_gpio.c) and the cascaded AXI timer (sim_tmrctr.c)
+ * are modelled on a virtual 100 MHz clock derived from the host monotonic
+ * clock, and report every LED write, timer command and displayed time to the
+ * scenario runner, which presses the buttons from a script and measures the
+ * latencies.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+#define SIM_CLOCK_HZ	100000000ULL	/* XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ */
+
+/* simTimerAction() commands */
+#define SIM_TMR_START	0
+#define SIM_TMR_STOP	1
+#define SIM_TMR_RESET	2
+
+uint64_t simClock(void);
+void simStart(void);
+void simDisplay(uint64_t time);
+
+/* Model hooks */
+uint32_t simButtons(void);
+void simLedWritten(uint32_t leds);
+void simTimerAction(int action, uint64_t value);
+
+#endif /* SIM_H */
@@ -0,0 +1,70 @@
+/*
+ * AXI GPIO model: channel 1 drives the LEDs, channel 2 reads the buttons
+ * pressed by the scenario.
+ *
+ * Channel 2 is all inputs in the hardware design, so the direction mask
+ * written by configGpio() does not change what it reads. Every write to
+ * channel 1 is reported to the scenario runner, also when the value does not
+ * change.
+ */
+
+#include "xgpio.h"
+#include "xparameters.h"
+#include "sim.h"
+
+static u32 leds;
+
+int XGpio_Initialize(XGpio *InstancePtr, u16 DeviceId)
+{
+	if(DeviceId != XPAR_GPIO_0_DEVICE_ID) {
+		return XST_DEVICE_NOT_FOUND;
+	}
+
+	InstancePtr->BaseAddress = XPAR_GPIO_0_BASEADDR;
+	InstancePtr->InterruptPresent = 0;
+	InstancePtr->IsDual = XPAR_GPIO_0_IS_DUAL;
+	InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+
+	return XST_SUCCESS;
+}
+
+void XGpio_SetDataDirection(XGpio *InstancePtr, unsigned Channel, u32 DirectionMask)
+{
+	(void)InstancePtr;
+	(void)Channel;
+	(void)DirectionMask;
+}
+
+u32 XGpio_GetDataDirection(XGpio *InstancePtr, unsigned Channel)
+{
+	(void)InstancePtr;
+
+	return Channel == 2 ? 0xFFFFFFFFU : 0;
+}
+
+u32 XGpio_DiscreteRead(XGpio *InstancePtr, unsigned Channel)
+{
+	(void)InstancePtr;
+
+	return Channel == 2 ? simButtons() : leds;
+}
+
+void XGpio_DiscreteWrite(XGpio *InstancePtr, unsigned Channel, u32 Data)
+{
+	(void)InstancePtr;
+
+	if(Channel == 1) {
+		leds = Data;
+		simLedWritten(leds);
+	}
+}
+
+void XGpio_DiscreteSet(XGpio *InstancePtr, unsigned Channel, u32 Mask)
+{
+	XGpio_DiscreteWrite(InstancePtr, Channel, leds | Mask);
+}
+
+void XGpio_DiscreteClear(XGpio *InstancePtr, unsigned Channel, u32 Mask)
+{
+	XGpio_DiscreteWrite(InstancePtr, Channel, leds & ~Mask);
+}
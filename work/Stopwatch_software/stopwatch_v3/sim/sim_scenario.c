@@ -0,0 +1,431 @@
+/*
+ * Scenario runner of the host simulation.
+ *
+ * A scenario is a text file of timed button presses, read from
+ * $STOPWATCH_SCENARIO or SIM_DEFAULT_SCENARIO:
+ *
+ *     # comment
+ *     limit press_to_led_max_us 20000
+ *     100 press start 50        <ms from start> press <stop|start|reset|user|mask> [hold ms]
+ *     1100 press stop
+ *     2000 end
+ *
+ * The scenario task runs above the stopwatch tasks and wakes every tick. It
+ * sets the buttons read by the GPIO model, releases them after the hold time
+ * and samples how many messages wait in the three stopwatch queues. The model
+ * hooks time each press against the first matching effect:
+ *
+ *  press_to_led      LED write of the colour of the button (vLedDisplay)
+ *  press_to_timer    AXI timer command of the button (vTimerControl)
+ *  press_to_display  displayed time that shows the command took effect
+ *                    (vTimerDisplay): the frozen value after stop, a value
+ *                    past the start value after start, a value below the
+ *                    count before reset after reset
+ *
+ * A press whose effects are not all seen before the next press is counted as
+ * missed. At the end the results are printed on stderr, the stopwatch output
+ * stays on stdout, and the process exits with 1 if a limit is exceeded.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "xil_printf.h"
+#include "static_alloc.h"
+#include "sim.h"
+
+#ifndef SIM_DEFAULT_SCENARIO
+#define SIM_DEFAULT_SCENARIO	"scenarios/default.txt"
+#endif
+
+#define SIM_MAX_STEPS		256
+#define SIM_MAX_LIMITS		16
+#define SIM_DEFAULT_HOLD_MS	50U
+#define SIM_END_AFTER_MS	1000U	/* Run time after the last press without an end line */
+#define SIM_COUNTS_PER_US	(SIM_CLOCK_HZ / 1000000ULL)
+
+/* LED colours written by vLedDisplay, R, G and B in stopwatch_v3.c */
+#define SIM_LED_STOP	0x04U
+#define SIM_LED_START	0x02U
+#define SIM_LED_RESET	0x03U
+#define SIM_LED_USER	(0x04U | 0x02U | 0x03U)
+
+#define SIM_QUEUES	3
+
+extern QueueHandle_t xButtonLedQueue;
+extern QueueHandle_t xButtonTimerControlQueue;
+extern QueueHandle_t xTimerValueDisplayQueue;
+
+typedef struct {
+	uint32_t ulAtMs;
+	uint32_t ulButton;		/* 0 ends the scenario */
+	uint32_t ulHoldMs;
+} SimStep;
+
+typedef struct {
+	char name[40];
+	double value;
+} SimLimit;
+
+typedef struct {
+	uint32_t ulCount;
+	uint64_t sum;			/* In clock counts */
+	uint64_t min;
+	uint64_t max;
+} SimLatency;
+
+/* The press being measured, the scenario task and the hooks never run at the same time */
+typedef struct {
+	int active;
+	uint32_t ulButton;
+	uint64_t at;			/* simClock() when pressed */
+	uint32_t ulLed;			/* Expected LED value */
+	int timerAction;		/* Expected timer command, -1 for none */
+	int ledSeen;
+	int timerSeen;
+	int displaySeen;
+	uint64_t reference;		/* Timer value the display is compared with */
+} SimPress;
+
+STATIC_TASK(scenario, configMINIMAL_STACK_SIZE);
+static const char *scenarioPath;
+static SimStep steps[SIM_MAX_STEPS + 1];	/* One more for the implicit end */
+static uint32_t ulSteps;
+static SimLimit limits[SIM_MAX_LIMITS];
+static uint32_t ulLimits;
+
+static volatile uint32_t ulButtons;
+static SimPress press;
+static SimLatency toLed, toTimer, toDisplay;
+static uint32_t ulPresses, ulMissed;
+static uint32_t ulDisplays;
+static uint64_t firstDisplay, lastDisplay;
+
+static const char * const queueNames[SIM_QUEUES] = {
+	"xButtonLedQueue", "xButtonTimerControlQueue", "xTimerValueDisplayQueue"
+};
+static uint32_t ulQueueSamples;
+static uint32_t ulQueueBusy[SIM_QUEUES];	/* Samples with a message waiting */
+static uint32_t ulQueueMax[SIM_QUEUES];
+
+
+uint64_t simClock(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec) / (1000000000ULL / SIM_CLOCK_HZ);
+}
+
+uint32_t simButtons(void)
+{
+	return ulButtons;
+}
+
+static void latencyAdd(SimLatency *lat, uint64_t now)
+{
+	uint64_t d = now - press.at;
+
+	if(lat->ulCount == 0 || d < lat->min) {
+		lat->min = d;
+	}
+	if(d > lat->max) {
+		lat->max = d;
+	}
+	lat->sum += d;
+	lat->ulCount++;
+}
+
+void simLedWritten(uint32_t leds)
+{
+	if(press.active && !press.ledSeen && leds == press.ulLed) {
+		press.ledSeen = 1;
+		latencyAdd(&toLed, simClock());
+	}
+}
+
+void simTimerAction(int action, uint64_t value)
+{
+	if(press.active && !press.timerSeen && action == press.timerAction) {
+		press.timerSeen = 1;
+		press.reference = value;
+		latencyAdd(&toTimer, simClock());
+	}
+}
+
+void simDisplay(uint64_t time)
+{
+	uint64_t now = simClock();
+	int match = 0;
+
+	if(ulDisplays++ == 0) {
+		firstDisplay = now;
+	}
+	lastDisplay = now;
+
+	if(!press.active || !press.timerSeen || press.displaySeen) {
+		return;
+	}
+	switch(press.timerAction) {
+		case SIM_TMR_STOP:
+			match = time == press.reference;
+			break;
+		case SIM_TMR_START:
+			match = time > press.reference;
+			break;
+		case SIM_TMR_RESET:
+			match = time < press.reference;
+			break;
+		default:
+			break;
+	}
+	if(match) {
+		press.displaySeen = 1;
+		latencyAdd(&toDisplay, now);
+	}
+}
+
+/* Close the measurement of the current press */
+static void pressFinish(void)
+{
+	if(!press.active) {
+		return;
+	}
+	if(!press.ledSeen || (press.timerAction >= 0 && (!press.timerSeen || !press.displaySeen))) {
+		ulMissed++;
+	}
+	press.active = 0;
+}
+
+static void pressBegin(uint32_t button)
+{
+	pressFinish();
+	memset(&press, 0, sizeof(press));
+	press.ulButton = button;
+	switch(button) {
+		case 1:
+			press.ulLed = SIM_LED_STOP;
+			press.timerAction = SIM_TMR_STOP;
+			break;
+		case 2:
+			press.ulLed = SIM_LED_START;
+			press.timerAction = SIM_TMR_START;
+			break;
+		case 4:
+			press.ulLed = SIM_LED_RESET;
+			press.timerAction = SIM_TMR_RESET;
+			break;
+		case 8:
+			press.ulLed = SIM_LED_USER;
+			press.timerAction = -1;
+			break;
+		default:
+			/* Several buttons at once, ignored by vReadButtons */
+			ulButtons = button;
+			return;
+	}
+	ulPresses++;
+	press.at = simClock();
+	press.active = 1;
+	ulButtons = button;
+}
+
+static void printLatency(const char *name, const SimLatency *lat)
+{
+	if(lat->ulCount == 0) {
+		fprintf(stderr, "%-18s %6u %10s %10s %10s\n", name, 0U, "-", "-", "-");
+		return;
+	}
+	fprintf(stderr, "%-18s %6u %10.1f %10.1f %10.1f\n", name, lat->ulCount,
+			(double)lat->min / SIM_COUNTS_PER_US,
+			(double)lat->sum / lat->ulCount / SIM_COUNTS_PER_US,
+			(double)lat->max / SIM_COUNTS_PER_US);
+}
+
+static double latencyMaxUs(const SimLatency *lat)
+{
+	return (double)lat->max / SIM_COUNTS_PER_US;
+}
+
+/* Print the results and check the limits, returns the number of limits exceeded */
+static int report(void)
+{
+	double rate = 0;
+	int failed = 0;
+
+	if(ulDisplays > 1 && lastDisplay > firstDisplay) {
+		rate = (double)(ulDisplays - 1) * SIM_CLOCK_HZ / (double)(lastDisplay - firstDisplay);
+	}
+
+	fprintf(stderr, "\nScenario: %s\n", scenarioPath);
+	fprintf(stderr, "%-18s %6s %10s %10s %10s\n", "latency", "count", "min_us", "mean_us", "max_us");
+	printLatency("press_to_led", &toLed);
+	printLatency("press_to_timer", &toTimer);
+	printLatency("press_to_display", &toDisplay);
+	fprintf(stderr, "%-26s %8s %8s\n", "queue", "busy_pct", "max");
+	for(int i = 0; i < SIM_QUEUES; i++) {
+		fprintf(stderr, "%-26s %8.1f %8u\n", queueNames[i],
+				ulQueueSamples ? 100.0 * ulQueueBusy[i] / ulQueueSamples : 0.0, ulQueueMax[i]);
+	}
+	fprintf(stderr, "presses %u, missed %u, display updates %u (%.0f Hz)\n",
+			ulPresses, ulMissed, ulDisplays, rate);
+
+	for(uint32_t i = 0; i < ulLimits; i++) {
+		const char *name = limits[i].name;
+		double value;
+		int ok;
+
+		if(strcmp(name, "press_to_led_max_us") == 0) {
+			value = latencyMaxUs(&toLed);
+		} else if(strcmp(name, "press_to_timer_max_us") == 0) {
+			value = latencyMaxUs(&toTimer);
+		} else if(strcmp(name, "press_to_display_max_us") == 0) {
+			value = latencyMaxUs(&toDisplay);
+		} else if(strcmp(name, "missed_max") == 0) {
+			value = ulMissed;
+		} else if(strcmp(name, "display_rate_min_hz") == 0) {
+			value = rate;
+		} else {
+			fprintf(stderr, "limit %s: unknown metric\n", name);
+			failed++;
+			continue;
+		}
+		ok = strstr(name, "_min_") ? value >= limits[i].value : value <= limits[i].value;
+		fprintf(stderr, "limit %s %g: %.1f %s\n", name, limits[i].value, value, ok ? "ok" : "FAIL");
+		failed += !ok;
+	}
+
+	return failed;
+}
+
+static void vScenario(void *pvParameters)
+{
+	TickType_t start = xTaskGetTickCount();
+	TickType_t wake = start;
+	uint32_t ulNext = 0;
+	uint32_t ulReleaseMs = 0;
+
+	(void)pvParameters;
+
+	while(1) {
+		xTaskDelayUntil(&wake, 1);
+		uint32_t ms = (uint32_t)((wake - start) * portTICK_PERIOD_MS);
+
+		ulQueueSamples++;
+		QueueHandle_t queues[SIM_QUEUES] = { xButtonLedQueue, xButtonTimerControlQueue, xTimerValueDisplayQueue };
+		for(int i = 0; i < SIM_QUEUES; i++) {
+			uint32_t waiting = (uint32_t)uxQueueMessagesWaiting(queues[i]);
+
+			ulQueueBusy[i] += waiting != 0;
+			if(waiting > ulQueueMax[i]) {
+				ulQueueMax[i] = waiting;
+			}
+		}
+
+		if(ulButtons != 0 && ms >= ulReleaseMs) {
+			ulButtons = 0;
+		}
+
+		while(ulNext < ulSteps && ms >= steps[ulNext].ulAtMs) {
+			const SimStep *step = &steps[ulNext++];
+
+			if(step->ulButton == 0) {
+				pressFinish();
+				fflush(stdout);
+				exit(report() ? EXIT_FAILURE : EXIT_SUCCESS);
+			}
+			pressBegin(step->ulButton);
+			ulReleaseMs = ms + step->ulHoldMs;
+		}
+	}
+}
+
+static uint32_t parseButton(const char *name)
+{
+	static const struct { const char *name; uint32_t button; } buttons[] = {
+		{ "stop", 1 }, { "start", 2 }, { "reset", 4 }, { "user", 8 }
+	};
+	char *end;
+	unsigned long mask;
+
+	for(size_t i = 0; i < sizeof(buttons) / sizeof(buttons[0]); i++) {
+		if(strcmp(name, buttons[i].name) == 0) {
+			return buttons[i].button;
+		}
+	}
+	mask = strtoul(name, &end, 0);
+	return (*end == '\0') ? (uint32_t)mask : 0;
+}
+
+static void scenarioLoad(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char line[256];
+	int lineNo = 0;
+	int ended = 0;
+
+	if(f == NULL) {
+		fprintf(stderr, "Error: scenario %s unsuccessfully opened!\n", path);
+		exit(2);
+	}
+
+	while(fgets(line, sizeof(line), f) != NULL) {
+		char word[40], arg[40];
+		unsigned at, hold;
+		double value;
+		int n;
+
+		lineNo++;
+		line[strcspn(line, "#\r\n")] = '\0';
+		if(sscanf(line, " %39s", word) != 1) {
+			continue;
+		}
+
+		if(strcmp(word, "limit") == 0 && ulLimits < SIM_MAX_LIMITS &&
+				sscanf(line, " limit %39s %lf", limits[ulLimits].name, &value) == 2) {
+			limits[ulLimits++].value = value;
+			continue;
+		}
+
+		hold = SIM_DEFAULT_HOLD_MS;
+		n = sscanf(line, " %u %39s %39s %u", &at, word, arg, &hold);
+		if(n >= 2 && !ended && ulSteps < SIM_MAX_STEPS && (ulSteps == 0 || at >= steps[ulSteps - 1].ulAtMs)) {
+			if(strcmp(word, "end") == 0) {
+				steps[ulSteps++] = (SimStep){ at, 0, 0 };
+				ended = 1;
+				continue;
+			}
+			if(n >= 3 && strcmp(word, "press") == 0 && parseButton(arg) != 0) {
+				steps[ulSteps++] = (SimStep){ at, parseButton(arg), hold };
+				continue;
+			}
+		}
+
+		fprintf(stderr, "Error: scenario %s line %d unsuccessfully parsed!\n", path, lineNo);
+		exit(2);
+	}
+	fclose(f);
+
+	if(!ended) {
+		uint32_t last = ulSteps ? steps[ulSteps - 1].ulAtMs : 0;
+
+		steps[ulSteps++] = (SimStep){ last + SIM_END_AFTER_MS, 0, 0 };
+	}
+}
+
+/* Load the scenario and create its task, called by main() before the scheduler starts */
+void simStart(void)
+{
+	scenarioPath = getenv("STOPWATCH_SCENARIO");
+	if(scenarioPath == NULL || scenarioPath[0] == '\0') {
+		scenarioPath = SIM_DEFAULT_SCENARIO;
+	}
+	scenarioLoad(scenarioPath);
+
+	STATIC_TASK_CREATE(scenario, vScenario, "vScenario", NULL, configMAX_PRIORITIES - 1, NULL);
+	xil_printf("Created scenario task (%s, %u steps)\r\n", scenarioPath, (unsigned)ulSteps);
+}
@@ -0,0 +1,30 @@
+/*
+ * Idle and timer task storage of the build without heap (make STATIC=1), as
+ * portZynq7000.c gives the static Zynq build. Empty in the default build.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if configSUPPORT_STATIC_ALLOCATION == 1
+static StaticTask_t idleTcb;
+static StackType_t idleStack[configMINIMAL_STACK_SIZE];
+static StaticTask_t timerTcb;
+static StackType_t timerStack[configTIMER_TASK_STACK_DEPTH];
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+		uint32_t *pulIdleTaskStackSize)
+{
+	*ppxIdleTaskTCBBuffer = &idleTcb;
+	*ppxIdleTaskStackBuffer = idleStack;
+	*pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+		uint32_t *pulTimerTaskStackSize)
+{
+	*ppxTimerTaskTCBBuffer = &timerTcb;
+	*ppxTimerTaskStackBuffer = timerStack;
+	*pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
@@ -0,0 +1,145 @@
+/*
+ * AXI timer model, the two counters in cascade mode as the stopwatch uses
+ * them: a single 64-bit up counter, counter 0 is the low word and counter 1
+ * the high word.
+ *
+ * Like the hardware, XTmrCtr_Start() and XTmrCtr_Reset() load the load
+ * register (TLR) of the counter into its word of the count, and in cascade
+ * mode counter 0 starts and stops both words. Other modes, down counting and
+ * interrupts are not modelled.
+ */
+
+#include "xtmrctr.h"
+#include "xparameters.h"
+#include "sim.h"
+
+typedef struct {
+	uint64_t count;		/* Count when last started or stopped */
+	uint64_t since;		/* simClock() at that time */
+	int running;
+	u32 load[XTC_DEVICE_TIMER_COUNT];
+	u32 options[XTC_DEVICE_TIMER_COUNT];
+} SimTmrCtr;
+
+static SimTmrCtr tmr;
+
+static uint64_t tmrCount(void)
+{
+	return tmr.running ? tmr.count + (simClock() - tmr.since) : tmr.count;
+}
+
+/* Replace one word of the count, keeping the counter running or stopped */
+static void tmrLoad(u8 TmrCtrNumber)
+{
+	uint64_t now = tmrCount();
+	int shift = TmrCtrNumber ? 32 : 0;
+
+	tmr.count = (now & ~(0xFFFFFFFFULL << shift)) | ((uint64_t)tmr.load[TmrCtrNumber] << shift);
+	tmr.since = simClock();
+}
+
+int XTmrCtr_Initialize(XTmrCtr *InstancePtr, u16 DeviceId)
+{
+	if(DeviceId != XPAR_TMRCTR_0_DEVICE_ID) {
+		return XST_DEVICE_NOT_FOUND;
+	}
+
+	InstancePtr->BaseAddress = XPAR_TMRCTR_0_BASEADDR;
+	InstancePtr->IsStartedTmrCtr0 = 0;
+	InstancePtr->IsStartedTmrCtr1 = 0;
+	InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+
+	return XST_SUCCESS;
+}
+
+void XTmrCtr_SetOptions(XTmrCtr *InstancePtr, u8 TmrCtrNumber, u32 Options)
+{
+	(void)InstancePtr;
+
+	tmr.options[TmrCtrNumber & 1] = Options;
+}
+
+u32 XTmrCtr_GetOptions(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	(void)InstancePtr;
+
+	return tmr.options[TmrCtrNumber & 1];
+}
+
+void XTmrCtr_SetResetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber, u32 ResetValue)
+{
+	(void)InstancePtr;
+
+	tmr.load[TmrCtrNumber & 1] = ResetValue;
+}
+
+u32 XTmrCtr_GetValue(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	(void)InstancePtr;
+
+	return (u32)(tmrCount() >> (TmrCtrNumber ? 32 : 0));
+}
+
+void XTmrCtr_Start(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	TmrCtrNumber &= 1;
+	tmrLoad(TmrCtrNumber);
+	tmr.running = 1;
+	if(TmrCtrNumber == 0) {
+		InstancePtr->IsStartedTmrCtr0 = XIL_COMPONENT_IS_READY;
+	} else {
+		InstancePtr->IsStartedTmrCtr1 = XIL_COMPONENT_IS_READY;
+	}
+	simTimerAction(SIM_TMR_START, tmr.count);
+}
+
+void XTmrCtr_Stop(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	tmr.count = tmrCount();
+	tmr.running = 0;
+	if((TmrCtrNumber & 1) == 0) {
+		InstancePtr->IsStartedTmrCtr0 = 0;
+	} else {
+		InstancePtr->IsStartedTmrCtr1 = 0;
+	}
+	simTimerAction(SIM_TMR_STOP, tmr.count);
+}
+
+void XTmrCtr_Reset(XTmrCtr *InstancePtr, u8 TmrCtrNumber)
+{
+	uint64_t before = tmrCount();
+
+	(void)InstancePtr;
+	tmrLoad(TmrCtrNumber & 1);
+	/* The scenario sees the reset of the low word, the one that always happens first */
+	if((TmrCtrNumber & 1) == 0) {
+		simTimerAction(SIM_TMR_RESET, before);
+	}
+}
+
+u32 simTmrCtrReadReg(UINTPTR BaseAddress, u8 TmrCtrNumber, unsigned RegOffset)
+{
+	(void)BaseAddress;
+
+	switch(RegOffset) {
+		case XTC_TLR_OFFSET:
+			return tmr.load[TmrCtrNumber & 1];
+		case XTC_TCR_OFFSET:
+			return (u32)(tmrCount() >> ((TmrCtrNumber & 1) ? 32 : 0));
+		case XTC_TCSR_OFFSET:
+			return (tmr.running ? XTC_CSR_ENABLE_TMR_MASK : 0) |
+					((tmr.options[0] & XTC_CASCADE_MODE_OPTION) ? XTC_CSR_CASC_MASK : 0);
+		default:
+			return 0;
+	}
+}
+
+void simTmrCtrWriteReg(UINTPTR BaseAddress, u8 TmrCtrNumber, unsigned RegOffset, u32 ValueToWrite)
+{
+	(void)BaseAddress;
+
+	/* Only the load register is written directly by the stopwatch */
+	if(RegOffset == XTC_TLR_OFFSET) {
+		tmr.load[TmrCtrNumber & 1] = ValueToWrite;
+	}
+}
@@ -0,0 +1,58 @@
+/*
+ * FreeRTOS configuration of the host SMP checks (smp_main.c), built against
+ * the kernel of the BSP with the host SMP port in this directory.
+ *
+ * Same scheduler options as the Zynq build with configNUMBER_OF_CORES set to
+ * 2, and a 1 kHz tick.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include <assert.h>
+
+#define configNUMBER_OF_CORES					2
+#define configUSE_PREEMPTION					1
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION	0
+#define configUSE_TIME_SLICING					1
+#define configUSE_IDLE_HOOK						1	/* Polls for interrupts, see port.c */
+#define configUSE_PASSIVE_IDLE_HOOK				1
+#define configUSE_TICK_HOOK						0
+#define configUSE_MALLOC_FAILED_HOOK			0
+#define configCHECK_FOR_STACK_OVERFLOW			0
+#define configTICK_RATE_HZ						( ( TickType_t ) 1000 )
+#define configMAX_PRIORITIES					( 8 )
+#define configSTACK_DEPTH_TYPE					uint32_t
+#define configMINIMAL_STACK_SIZE				( ( configSTACK_DEPTH_TYPE ) 8192 )	/* Words, printf on the host needs more than on the target */
+#define configTOTAL_HEAP_SIZE					( ( size_t ) ( 16 * 1024 * 1024 ) )
+#define configMAX_TASK_NAME_LEN					( 16 )
+#define configUSE_16_BIT_TICKS					0
+#define configIDLE_SHOULD_YIELD					1
+#define configUSE_MUTEXES						1
+#define configUSE_RECURSIVE_MUTEXES				1
+#define configUSE_COUNTING_SEMAPHORES			1
+#define configUSE_TASK_NOTIFICATIONS			1
+#define configSUPPORT_DYNAMIC_ALLOCATION		1
+#define configSUPPORT_STATIC_ALLOCATION			0
+#define configUSE_TRACE_FACILITY				1
+#define configGENERATE_RUN_TIME_STATS			0
+
+#define configUSE_TIMERS						1
+#define configTIMER_TASK_PRIORITY				( configMAX_PRIORITIES - 1 )
+#define configTIMER_QUEUE_LENGTH				10
+#define configTIMER_TASK_STACK_DEPTH			( configMINIMAL_STACK_SIZE )
+
+#define configASSERT( x )						assert( x )
+
+#define INCLUDE_vTaskPrioritySet				1
+#define INCLUDE_uxTaskPriorityGet				1
+#define INCLUDE_vTaskDelete						1
+#define INCLUDE_vTaskSuspend					1
+#define INCLUDE_xTaskDelayUntil					1
+#define INCLUDE_vTaskDelay						1
+#define INCLUDE_xTaskGetSchedulerState			1
+#define INCLUDE_xTaskGetCurrentTaskHandle		1
+#define INCLUDE_xTaskGetIdleTaskHandle			1
+#define INCLUDE_eTaskGetState					1
+
+#endif /* FREERTOS_CONFIG_H */
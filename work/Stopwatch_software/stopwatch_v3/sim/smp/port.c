@@ -0,0 +1,386 @@
+/*
+ * Host port of the SMP scheduler (configNUMBER_OF_CORES > 1), for testing the
+ * kernel of the BSP without the board.
+ *
+ * Each core is a thread, each task a ucontext that any core can resume, so
+ * tasks move between threads like they move between the Cortex-A9 cores. The
+ * core ID is thread specific data read through a call, as a task may read it
+ * before and after moving.
+ *
+ * Interrupts are emulated: the tick thread pends the tick on core 0 and
+ * vPortYieldCore() pends a yield on the target core, and a core only takes
+ * them when it unmasks interrupts or polls (vPortSimPoll()), as if the task
+ * were interrupted at that point. Like the IRQ and SVC handlers of the Zynq
+ * port, the switch runs on a stack of the core and not of the task, because
+ * once vTaskSwitchContext() has given the task up another core may resume
+ * it.
+ *
+ * With configNUMBER_OF_CORES 1 only the thread of core 0 runs, and the
+ * critical sections are the ones of a single core port. With
+ * configSIM_VIRTUAL_TICK 1 there is no tick thread either, the tasks tick
+ * through vPortSimTick() (portmacro.h).
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define SIM_SWITCH_STACK_SIZE	( 64 * 1024 )
+
+/* Saved in the task stack, above the top the kernel sees. */
+typedef struct
+{
+	ucontext_t xContext;
+	uint32_t ulCriticalNesting;
+	TaskFunction_t pxCode;
+	void *pvParameters;
+} SimTaskContext_t;
+
+typedef struct
+{
+	atomic_long xOwner;		/* Core + 1, 0 when free */
+	uint32_t ulCount;
+} SimLock_t;
+
+volatile uint32_t ulCriticalNesting[ configNUMBER_OF_CORES ];
+volatile uint32_t ulPortInterruptNesting[ configNUMBER_OF_CORES ];
+volatile UBaseType_t ulPortYieldRequired[ configNUMBER_OF_CORES ];
+
+#if ( configNUMBER_OF_CORES > 1 )
+extern TaskHandle_t volatile pxCurrentTCBs[ configNUMBER_OF_CORES ];
+#else
+extern TaskHandle_t volatile pxCurrentTCB;
+#endif
+
+static pthread_key_t xCoreKey;
+static volatile UBaseType_t uxInterruptMasked[ configNUMBER_OF_CORES ];
+static atomic_int xTickPending;
+static atomic_int xYieldPending[ configNUMBER_OF_CORES ];
+static ucontext_t xSwitchContexts[ configNUMBER_OF_CORES ];
+static uint64_t ullSwitchStacks[ configNUMBER_OF_CORES ][ SIM_SWITCH_STACK_SIZE / sizeof( uint64_t ) ];
+#if ( configNUMBER_OF_CORES > 1 )
+static SimLock_t xTaskLock, xISRLock;
+#endif
+
+__attribute__(( constructor )) static void prvCreateCoreKey( void )
+{
+	/* Before the scheduler starts every thread reads core 0. */
+	( void ) pthread_key_create( &xCoreKey, NULL );
+}
+
+BaseType_t xPortGetCoreID( void )
+{
+	return ( BaseType_t ) ( intptr_t ) pthread_getspecific( xCoreKey );
+}
+
+static SimTaskContext_t *prvTaskContext( BaseType_t xCoreID )
+{
+	/* pxTopOfStack is the first member of the TCB. */
+#if ( configNUMBER_OF_CORES > 1 )
+	return *( SimTaskContext_t ** ) pxCurrentTCBs[ xCoreID ];
+#else
+	( void ) xCoreID;
+	return *( SimTaskContext_t ** ) pxCurrentTCB;
+#endif
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( configNUMBER_OF_CORES > 1 )
+
+static void prvLockGet( SimLock_t *pxLock )
+{
+	const long xOwner = ( long ) portGET_CORE_ID() + 1;
+	long xFree;
+
+	if( atomic_load_explicit( &pxLock->xOwner, memory_order_relaxed ) == xOwner )
+	{
+		pxLock->ulCount++;
+		return;
+	}
+
+	for( ;; )
+	{
+		xFree = 0;
+		if( atomic_compare_exchange_weak_explicit( &pxLock->xOwner, &xFree, xOwner, memory_order_acquire, memory_order_relaxed ) )
+		{
+			break;
+		}
+		/* The owner may share the host CPU with this thread. */
+		sched_yield();
+	}
+	pxLock->ulCount = 1;
+}
+
+static void prvLockRelease( SimLock_t *pxLock )
+{
+	configASSERT( atomic_load_explicit( &pxLock->xOwner, memory_order_relaxed ) == ( long ) portGET_CORE_ID() + 1 );
+
+	if( --pxLock->ulCount == 0 )
+	{
+		atomic_store_explicit( &pxLock->xOwner, 0, memory_order_release );
+	}
+}
+
+void vPortGetTaskLock( void )
+{
+	prvLockGet( &xTaskLock );
+}
+
+void vPortReleaseTaskLock( void )
+{
+	prvLockRelease( &xTaskLock );
+}
+
+void vPortGetISRLock( void )
+{
+	prvLockGet( &xISRLock );
+}
+
+void vPortReleaseISRLock( void )
+{
+	prvLockRelease( &xISRLock );
+}
+
+#else
+
+void vPortEnterCritical( void )
+{
+	( void ) ulPortSetInterruptMask();
+	ulCriticalNesting[ 0 ]++;
+}
+
+void vPortExitCritical( void )
+{
+	configASSERT( ulCriticalNesting[ 0 ] > 0 );
+
+	if( --ulCriticalNesting[ 0 ] == 0 )
+	{
+		vPortClearInterruptMask( 0 );
+	}
+}
+
+#endif /* configNUMBER_OF_CORES */
+
+/*-----------------------------------------------------------*/
+
+/* Runs on the stack of the core: picks the next task and resumes it, and is
+ * resumed by the next task that switches out on this core. */
+static void prvSwitchLoop( void )
+{
+	BaseType_t xCoreID = portGET_CORE_ID();
+
+	for( ;; )
+	{
+		vTaskSwitchContext();
+		( void ) swapcontext( &xSwitchContexts[ xCoreID ], &prvTaskContext( xCoreID )->xContext );
+	}
+}
+
+/* Called with interrupts masked. Returns once the task is running again,
+ * possibly on another core, where the caller restores its interrupt mask. */
+static void prvSwitchOut( void )
+{
+	BaseType_t xCoreID = portGET_CORE_ID();
+	SimTaskContext_t *pxContext = prvTaskContext( xCoreID );
+
+	pxContext->ulCriticalNesting = ulCriticalNesting[ xCoreID ];
+	( void ) swapcontext( &pxContext->xContext, &xSwitchContexts[ xCoreID ] );
+
+	/* The switch loop left interrupts masked on the new core. */
+	xCoreID = portGET_CORE_ID();
+	ulCriticalNesting[ xCoreID ] = pxContext->ulCriticalNesting;
+}
+
+/* The interrupt handlers of the core, run with interrupts masked. */
+static void prvServiceInterrupts( void )
+{
+	BaseType_t xCoreID;
+
+	for( ;; )
+	{
+		xCoreID = portGET_CORE_ID();
+		ulPortInterruptNesting[ xCoreID ]++;
+
+		if( xCoreID == 0 && atomic_exchange( &xTickPending, 0 ) != 0 )
+		{
+			if( xTaskIncrementTick() != pdFALSE )
+			{
+				ulPortYieldRequired[ xCoreID ] = pdTRUE;
+			}
+		}
+
+		if( atomic_exchange( &xYieldPending[ xCoreID ], 0 ) != 0 )
+		{
+			ulPortYieldRequired[ xCoreID ] = pdTRUE;
+		}
+
+		ulPortInterruptNesting[ xCoreID ]--;
+
+		if( ulPortYieldRequired[ xCoreID ] == pdFALSE )
+		{
+			break;
+		}
+		ulPortYieldRequired[ xCoreID ] = pdFALSE;
+		prvSwitchOut();
+	}
+}
+
+UBaseType_t ulPortSetInterruptMask( void )
+{
+	const BaseType_t xCoreID = portGET_CORE_ID();
+	const UBaseType_t uxPrevious = uxInterruptMasked[ xCoreID ];
+
+	uxInterruptMasked[ xCoreID ] = pdTRUE;
+	return uxPrevious;
+}
+
+void vPortClearInterruptMask( UBaseType_t ulNewMaskValue )
+{
+	if( ulNewMaskValue == 0 )
+	{
+		/* Interrupts pending while masked are taken at once, and do not nest. */
+		uxInterruptMasked[ portGET_CORE_ID() ] = pdTRUE;
+		prvServiceInterrupts();
+	}
+	uxInterruptMasked[ portGET_CORE_ID() ] = ulNewMaskValue;
+}
+
+void vPortSimPoll( void )
+{
+	const UBaseType_t uxMask = ulPortSetInterruptMask();
+
+	vPortClearInterruptMask( uxMask );
+}
+
+#if ( configSIM_VIRTUAL_TICK == 1 )
+void vPortSimTick( void )
+{
+	atomic_store( &xTickPending, 1 );
+	vPortSimPoll();
+}
+#endif
+
+void vPortYield( void )
+{
+	const UBaseType_t uxMask = ulPortSetInterruptMask();
+
+	prvSwitchOut();
+	uxInterruptMasked[ portGET_CORE_ID() ] = uxMask;
+}
+
+#if ( configNUMBER_OF_CORES > 1 )
+void vPortYieldCore( BaseType_t xCoreID )
+{
+	configASSERT( xCoreID != portGET_CORE_ID() );
+	atomic_store( &xYieldPending[ xCoreID ], 1 );
+}
+#endif
+
+/*-----------------------------------------------------------*/
+
+static void prvTaskStart( void )
+{
+	const SimTaskContext_t *pxContext = prvTaskContext( portGET_CORE_ID() );
+
+	/* Tasks start with interrupts enabled and outside a critical section. */
+	ulCriticalNesting[ portGET_CORE_ID() ] = 0;
+	vPortClearInterruptMask( 0 );
+	pxContext->pxCode( pxContext->pvParameters );
+
+	/* Tasks must delete themselves rather than return. */
+	configASSERT( pdFALSE );
+}
+
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, StackType_t *pxEndOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+	uintptr_t uxTop = ( ( uintptr_t ) ( pxTopOfStack + 1 ) - sizeof( SimTaskContext_t ) ) & ~( ( uintptr_t ) portBYTE_ALIGNMENT_MASK );
+	SimTaskContext_t *pxContext = ( SimTaskContext_t * ) uxTop;
+
+	configASSERT( uxTop > ( uintptr_t ) pxEndOfStack + 4096 );
+
+	( void ) getcontext( &pxContext->xContext );
+	pxContext->xContext.uc_stack.ss_sp = pxEndOfStack;
+	pxContext->xContext.uc_stack.ss_size = uxTop - ( uintptr_t ) pxEndOfStack;
+	pxContext->xContext.uc_link = NULL;
+	makecontext( &pxContext->xContext, prvTaskStart, 0 );
+
+	pxContext->ulCriticalNesting = 0;
+	pxContext->pxCode = pxCode;
+	pxContext->pvParameters = pvParameters;
+
+	return ( StackType_t * ) pxContext;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( configSIM_VIRTUAL_TICK == 0 )
+static void *prvTickThread( void *pvParameters )
+{
+	const struct timespec xPeriod = { 0, 1000000000L / configTICK_RATE_HZ };
+
+	( void ) pvParameters;
+
+	for( ;; )
+	{
+		( void ) nanosleep( &xPeriod, NULL );
+		atomic_store( &xTickPending, 1 );
+	}
+	return NULL;
+}
+#endif
+
+static void prvStartCore( BaseType_t xCoreID )
+{
+	( void ) pthread_setspecific( xCoreKey, ( void * ) ( intptr_t ) xCoreID );
+	uxInterruptMasked[ xCoreID ] = pdTRUE;
+
+	( void ) getcontext( &xSwitchContexts[ xCoreID ] );
+	xSwitchContexts[ xCoreID ].uc_stack.ss_sp = ullSwitchStacks[ xCoreID ];
+	xSwitchContexts[ xCoreID ].uc_stack.ss_size = sizeof( ullSwitchStacks[ xCoreID ] );
+	xSwitchContexts[ xCoreID ].uc_link = NULL;
+	makecontext( &xSwitchContexts[ xCoreID ], prvSwitchLoop, 0 );
+
+	/* vTaskStartScheduler() has chosen the first task of every core. */
+	( void ) setcontext( &prvTaskContext( xCoreID )->xContext );
+}
+
+static void *prvCoreThread( void *pvParameters )
+{
+	prvStartCore( ( BaseType_t ) ( intptr_t ) pvParameters );
+	return NULL;
+}
+
+BaseType_t xPortStartScheduler( void )
+{
+	pthread_t xThread;
+	BaseType_t xCoreID;
+	int iError = 0;
+
+	for( xCoreID = 1; xCoreID < configNUMBER_OF_CORES; xCoreID++ )
+	{
+		iError = pthread_create( &xThread, NULL, prvCoreThread, ( void * ) ( intptr_t ) xCoreID );
+		configASSERT( iError == 0 );
+	}
+#if ( configSIM_VIRTUAL_TICK == 0 )
+	iError = pthread_create( &xThread, NULL, prvTickThread, NULL );
+	configASSERT( iError == 0 );
+#endif
+	( void ) iError;
+	( void ) xThread;
+
+	prvStartCore( 0 );
+	return pdFAIL;
+}
+
+void vPortEndScheduler( void )
+{
+	exit( 0 );
+}
@@ -0,0 +1,136 @@
+/*
+ * Host port of the SMP scheduler, see port.c.
+ *
+ * The macros the kernel needs from an SMP port are the ones of the Zynq port
+ * (bsp include/portmacro.h, configNUMBER_OF_CORES > 1), implemented on
+ * pthreads instead of the GIC and LDREX/STREX. With configNUMBER_OF_CORES 1
+ * it is a plain single core port, for the EDF comparison in ../edf.
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define portCHAR		char
+#define portFLOAT		float
+#define portDOUBLE		double
+#define portLONG		long
+#define portSHORT		short
+#define portSTACK_TYPE	uintptr_t
+#define portBASE_TYPE	long
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define portMAX_DELAY				( ( TickType_t ) 0xffffffffUL )
+#define portTICK_TYPE_IS_ATOMIC		1
+#define portPOINTER_SIZE_TYPE		uintptr_t
+
+#define portSTACK_GROWTH			( -1 )
+#define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT			16
+#define portNOP()
+
+/* pxPortInitialiseStack() builds the ucontext stack from the stack limit. */
+#define portHAS_STACK_OVERFLOW_CHECKING	1
+
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters )	void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters )		void vFunction( void *pvParameters )
+
+/* Interrupt masking, per core. */
+UBaseType_t ulPortSetInterruptMask( void );
+void vPortClearInterruptMask( UBaseType_t ulNewMaskValue );
+#define portDISABLE_INTERRUPTS()				ulPortSetInterruptMask()
+#define portENABLE_INTERRUPTS()					vPortClearInterruptMask( 0 )
+
+/* Core of the calling thread. */
+BaseType_t xPortGetCoreID( void );
+#define portGET_CORE_ID()		xPortGetCoreID()
+
+void vPortYield( void );
+#define portYIELD()				vPortYield()
+
+extern volatile UBaseType_t ulPortYieldRequired[ configNUMBER_OF_CORES ];
+#define portEND_SWITCHING_ISR( xSwitchRequired )			\
+	{														\
+		if( xSwitchRequired != pdFALSE )					\
+		{													\
+			ulPortYieldRequired[ portGET_CORE_ID() ] = pdTRUE;	\
+		}													\
+	}
+#define portYIELD_FROM_ISR( x )	portEND_SWITCHING_ISR( x )
+
+extern volatile uint32_t ulCriticalNesting[ configNUMBER_OF_CORES ];
+extern volatile uint32_t ulPortInterruptNesting[ configNUMBER_OF_CORES ];
+#define portASSERT_IF_IN_ISR()	configASSERT( ulPortInterruptNesting[ portGET_CORE_ID() ] == 0 )
+
+#if ( configNUMBER_OF_CORES > 1 )
+
+#define portSET_CORE_INTERRUPT_MASK()			ulPortSetInterruptMask()
+#define portCLEAR_CORE_INTERRUPT_MASK( x )		vPortClearInterruptMask( x )
+
+void vPortYieldCore( BaseType_t xCoreID );
+#define portYIELD_CORE( xCoreID )	vPortYieldCore( xCoreID )
+
+void vPortGetTaskLock( void );
+void vPortReleaseTaskLock( void );
+void vPortGetISRLock( void );
+void vPortReleaseISRLock( void );
+#define portGET_TASK_LOCK()			vPortGetTaskLock()
+#define portRELEASE_TASK_LOCK()		vPortReleaseTaskLock()
+#define portGET_ISR_LOCK()			vPortGetISRLock()
+#define portRELEASE_ISR_LOCK()		vPortReleaseISRLock()
+
+#define portGET_CRITICAL_NESTING_COUNT()		( ulCriticalNesting[ portGET_CORE_ID() ] )
+#define portINCREMENT_CRITICAL_NESTING_COUNT()	( ulCriticalNesting[ portGET_CORE_ID() ]++ )
+#define portDECREMENT_CRITICAL_NESTING_COUNT()	( ulCriticalNesting[ portGET_CORE_ID() ]-- )
+
+extern void vTaskEnterCritical( void );
+extern void vTaskExitCritical( void );
+#define portENTER_CRITICAL()		vTaskEnterCritical()
+#define portEXIT_CRITICAL()			vTaskExitCritical()
+
+UBaseType_t uxTaskEnterCriticalFromISR( void );
+void vTaskExitCriticalFromISR( UBaseType_t uxSavedInterruptStatus );
+#define portSET_INTERRUPT_MASK_FROM_ISR()		uxTaskEnterCriticalFromISR()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )	vTaskExitCriticalFromISR( x )
+
+void vTaskYieldWithinAPI( void );
+#define portYIELD_WITHIN_API()					vTaskYieldWithinAPI()
+
+#else
+
+void vPortEnterCritical( void );
+void vPortExitCritical( void );
+#define portENTER_CRITICAL()		vPortEnterCritical()
+#define portEXIT_CRITICAL()			vPortExitCritical()
+
+#define portSET_INTERRUPT_MASK_FROM_ISR()		ulPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )	vPortClearInterruptMask( x )
+
+#endif /* configNUMBER_OF_CORES */
+
+/* Delivers the interrupts pending on the calling core, for tasks that spin
+ * without calling the kernel. */
+void vPortSimPoll( void );
+
+/* With configSIM_VIRTUAL_TICK set to 1 there is no tick thread, time only
+ * passes when the running task or the idle hook calls vPortSimTick(): the
+ * caller has used up one tick period and takes the tick at once. Runs are
+ * then the same on every host. Needs configNUMBER_OF_CORES 1. */
+#ifndef configSIM_VIRTUAL_TICK
+	#define configSIM_VIRTUAL_TICK	0
+#endif
+
+#if ( configSIM_VIRTUAL_TICK == 1 )
+	#if ( configNUMBER_OF_CORES > 1 )
+		#error configSIM_VIRTUAL_TICK needs configNUMBER_OF_CORES 1
+	#endif
+	void vPortSimTick( void );
+#endif
+
+#endif /* PORTMACRO_H */
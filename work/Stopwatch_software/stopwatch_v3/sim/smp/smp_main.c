@@ -0,0 +1,373 @@
+/*
+ * Host checks of the SMP scheduler (configNUMBER_OF_CORES 2), see port.c.
+ *
+ * A control task runs each check in turn with its own set of tasks and
+ * deletes them afterwards:
+ *
+ *  concurrent  two spinning tasks see each other advance while neither can
+ *              be switched out, so they run on both cores at once
+ *  affinity    tasks pinned to a core only run there, taking turns with an
+ *              unpinned task of their priority, also after the pins are
+ *              swapped while they run
+ *  priority    a task never runs while two higher priority tasks are running,
+ *              as the two cores run the two highest priority ready tasks
+ *  notify      a task on core 1 is woken by notifications given on core 0
+ *  critical    counters incremented in critical sections and with the
+ *              scheduler suspended from both cores lose no increment
+ *
+ * One line per check is printed, and the process exits with 1 if one fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define SMP_CONTROL_PRIORITY	(configMAX_PRIORITIES - 2)
+#define SMP_SPIN_WAIT			100000U	/* Iterations waiting for the other task in one step */
+#define SMP_RUN_MS				200U
+#define SMP_PINNED_STEPS		1000U	/* Steps of each pinned task per half of the affinity check */
+#define SMP_NOTIFICATIONS		100U
+#define SMP_INCREMENTS			100000U
+#define SMP_TIMEOUT_MS			10000U
+
+#define SMP_STACK	configMINIMAL_STACK_SIZE
+
+static volatile uint32_t ulSpin[2];
+static volatile uint32_t ulOverlaps;
+
+static volatile uint32_t ulPinnedRuns[2];
+static volatile uint32_t ulPinnedViolations;
+static volatile BaseType_t xPinnedLastCore[2];
+
+static volatile uint32_t ulHighRunning[2];
+static volatile uint32_t ulLowRuns;
+static volatile uint32_t ulPriorityViolations;
+
+static volatile uint64_t ullNotifyGivenNs;
+static volatile uint32_t ulNotifyReceived;
+static volatile uint64_t ullNotifyMaxNs;
+
+static volatile uint32_t ulCriticalCount;
+static volatile uint32_t ulSuspendedCount;
+static volatile uint32_t ulCriticalDone;
+
+static int failed;
+
+static uint64_t smpNowNs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static void smpResult(const char *name, int ok, const char *fmt, uint32_t a, uint32_t b)
+{
+	printf("%-12s %-4s ", name, ok ? "ok" : "FAIL");
+	printf(fmt, a, b);
+	printf("\n");
+	fflush(stdout);
+	failed += !ok;
+}
+
+/* The tasks below only reach a point where they may be switched out at
+ * vPortSimPoll() and at kernel calls. */
+
+static void vSpinTask(void *pvParameters)
+{
+	const uint32_t me = (uint32_t)(uintptr_t)pvParameters;
+	const uint32_t other = me ^ 1U;
+
+	while(1) {
+		uint32_t seen = ulSpin[other];
+
+		ulSpin[me]++;
+		for(uint32_t i = 0; i < SMP_SPIN_WAIT && ulSpin[other] == seen; i++) {
+		}
+		if(ulSpin[other] != seen) {
+			__atomic_add_fetch(&ulOverlaps, 1, __ATOMIC_RELAXED);
+		}
+		vPortSimPoll();
+	}
+}
+
+static void vPinnedTask(void *pvParameters)
+{
+	const uint32_t me = (uint32_t)(uintptr_t)pvParameters;
+	int wasOff = 0;
+
+	while(1) {
+		UBaseType_t uxMask;
+		BaseType_t xCore;
+
+		taskENTER_CRITICAL();
+		uxMask = uxTaskCoreAffinityGet(NULL);
+		xCore = portGET_CORE_ID();
+		taskEXIT_CRITICAL();
+
+		/* Until it takes the yield of vTaskCoreAffinitySet(), at the end of
+		 * the critical section, the task runs on the core it has to leave.
+		 * It is a violation when it is still there in the next step. */
+		if((uxMask & (1U << xCore)) == 0) {
+			ulPinnedViolations += wasOff;
+			wasOff = 1;
+		} else {
+			wasOff = 0;
+		}
+		xPinnedLastCore[me] = xCore;
+		ulPinnedRuns[me]++;
+		vPortSimPoll();
+	}
+}
+
+static void vFreeSpinTask(void *pvParameters)
+{
+	(void)pvParameters;
+
+	while(1) {
+		vPortSimPoll();
+	}
+}
+
+static void vHighTask(void *pvParameters)
+{
+	const uint32_t me = (uint32_t)(uintptr_t)pvParameters;
+
+	while(1) {
+		TickType_t end = xTaskGetTickCount() + 2 + me;
+
+		ulHighRunning[me] = 1;
+		while(xTaskGetTickCount() < end) {
+			vPortSimPoll();
+		}
+		ulHighRunning[me] = 0;
+		vTaskDelay(1);
+	}
+}
+
+static void vLowTask(void *pvParameters)
+{
+	TickType_t seenAt = 0;
+	int seen = 0;
+
+	(void)pvParameters;
+
+	while(1) {
+		/* The flag of a high task stays set while another high task
+		 * preempts it, so this task may see both set until it takes the
+		 * yield sent to its core. A high task only starts running again
+		 * after a tick, so seeing them set twice in one tick is a
+		 * violation. */
+		if(ulHighRunning[0] && ulHighRunning[1]) {
+			TickType_t now = xTaskGetTickCount();
+
+			ulPriorityViolations += seen && seenAt == now;
+			seen = 1;
+			seenAt = now;
+		} else {
+			seen = 0;
+		}
+		ulLowRuns++;
+		vPortSimPoll();
+	}
+}
+
+static void vWaitTask(void *pvParameters)
+{
+	(void)pvParameters;
+
+	while(1) {
+		(void)ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+
+		uint64_t latency = smpNowNs() - ullNotifyGivenNs;
+		if(latency > ullNotifyMaxNs) {
+			ullNotifyMaxNs = latency;
+		}
+		ulNotifyReceived++;
+	}
+}
+
+static void vCriticalTask(void *pvParameters)
+{
+	(void)pvParameters;
+
+	for(uint32_t i = 0; i < SMP_INCREMENTS; i++) {
+		taskENTER_CRITICAL();
+		ulCriticalCount++;
+		taskEXIT_CRITICAL();
+
+		vTaskSuspendAll();
+		ulSuspendedCount++;
+		(void)xTaskResumeAll();
+	}
+
+	taskENTER_CRITICAL();
+	ulCriticalDone++;
+	taskEXIT_CRITICAL();
+	vTaskDelete(NULL);
+}
+
+static TaskHandle_t smpCreate(TaskFunction_t task, const char *name, uint32_t arg, UBaseType_t priority, UBaseType_t affinity)
+{
+	TaskHandle_t handle = NULL;
+
+	if(xTaskCreate(task, name, SMP_STACK, (void *)(uintptr_t)arg, priority, &handle) != pdPASS) {
+		printf("Error: task %s unsuccessfully created!\n", name);
+		exit(2);
+	}
+	if(affinity != tskNO_AFFINITY) {
+		vTaskCoreAffinitySet(handle, affinity);
+	}
+	return handle;
+}
+
+static void checkConcurrent(void)
+{
+	TaskHandle_t a = smpCreate(vSpinTask, "spin0", 0, 2, tskNO_AFFINITY);
+	TaskHandle_t b = smpCreate(vSpinTask, "spin1", 1, 2, tskNO_AFFINITY);
+
+	vTaskDelay(pdMS_TO_TICKS(SMP_RUN_MS));
+	vTaskDelete(a);
+	vTaskDelete(b);
+
+	smpResult("concurrent", ulOverlaps > 0, "overlaps %u, steps %u", ulOverlaps, ulSpin[0] + ulSpin[1]);
+}
+
+/* Waits until both pinned tasks have taken SMP_PINNED_STEPS steps more than
+ * counted in since, returns 0 on the timeout */
+static int smpWaitPinned(const uint32_t since[2])
+{
+	TickType_t start = xTaskGetTickCount();
+
+	while(ulPinnedRuns[0] - since[0] < SMP_PINNED_STEPS || ulPinnedRuns[1] - since[1] < SMP_PINNED_STEPS) {
+		if(xTaskGetTickCount() - start >= pdMS_TO_TICKS(SMP_TIMEOUT_MS)) {
+			return 0;
+		}
+		vTaskDelay(1);
+	}
+	return 1;
+}
+
+static void checkAffinity(void)
+{
+	TaskHandle_t pinned[2];
+	TaskHandle_t spinner;
+	uint32_t since[2] = { 0, 0 };
+
+	pinned[0] = smpCreate(vPinnedTask, "pinned0", 0, 2, 1U << 0);
+	pinned[1] = smpCreate(vPinnedTask, "pinned1", 1, 2, 1U << 1);
+	spinner = smpCreate(vFreeSpinTask, "free", 0, 2, tskNO_AFFINITY);
+
+	/* Steps counted, not time: each task has to get its core from the free
+	 * spinner by time slicing however the host schedules the cores */
+	int before = smpWaitPinned(since) && xPinnedLastCore[0] == 0 && xPinnedLastCore[1] == 1;
+
+	vTaskCoreAffinitySet(pinned[0], 1U << 1);
+	vTaskCoreAffinitySet(pinned[1], 1U << 0);
+	since[0] = ulPinnedRuns[0];
+	since[1] = ulPinnedRuns[1];
+	int after = smpWaitPinned(since) && xPinnedLastCore[0] == 1 && xPinnedLastCore[1] == 0;
+
+	vTaskDelete(pinned[0]);
+	vTaskDelete(pinned[1]);
+	vTaskDelete(spinner);
+
+	smpResult("affinity", before && after && ulPinnedViolations == 0,
+			"violations %u, runs %u", ulPinnedViolations, ulPinnedRuns[0] + ulPinnedRuns[1]);
+}
+
+static void checkPriority(void)
+{
+	TaskHandle_t high[2];
+	TaskHandle_t low;
+
+	low = smpCreate(vLowTask, "low", 0, 2, tskNO_AFFINITY);
+	high[0] = smpCreate(vHighTask, "high0", 0, 3, tskNO_AFFINITY);
+	high[1] = smpCreate(vHighTask, "high1", 1, 3, tskNO_AFFINITY);
+
+	vTaskDelay(pdMS_TO_TICKS(SMP_RUN_MS));
+	vTaskDelete(high[0]);
+	vTaskDelete(high[1]);
+	vTaskDelete(low);
+
+	smpResult("priority", ulPriorityViolations == 0 && ulLowRuns > 0,
+			"violations %u, low runs %u", ulPriorityViolations, ulLowRuns);
+}
+
+static void checkNotify(void)
+{
+	TaskHandle_t waiter = smpCreate(vWaitTask, "wait", 0, 4, 1U << 1);
+
+	/* Give from core 0 */
+	vTaskCoreAffinitySet(NULL, 1U << 0);
+	for(uint32_t i = 0; i < SMP_NOTIFICATIONS; i++) {
+		vTaskDelay(1);
+		ullNotifyGivenNs = smpNowNs();
+		xTaskNotifyGive(waiter);
+	}
+	vTaskDelay(pdMS_TO_TICKS(10));
+	vTaskCoreAffinitySet(NULL, tskNO_AFFINITY);
+	vTaskDelete(waiter);
+
+	smpResult("notify", ulNotifyReceived == SMP_NOTIFICATIONS, "received %u, max latency %u us",
+			ulNotifyReceived, (uint32_t)(ullNotifyMaxNs / 1000U));
+}
+
+static void checkCritical(void)
+{
+	TickType_t start = xTaskGetTickCount();
+
+	(void)smpCreate(vCriticalTask, "crit0", 0, 2, tskNO_AFFINITY);
+	(void)smpCreate(vCriticalTask, "crit1", 1, 2, tskNO_AFFINITY);
+
+	while(ulCriticalDone < 2 && xTaskGetTickCount() - start < pdMS_TO_TICKS(SMP_TIMEOUT_MS)) {
+		vTaskDelay(pdMS_TO_TICKS(10));
+	}
+
+	smpResult("critical", ulCriticalCount == 2 * SMP_INCREMENTS && ulSuspendedCount == 2 * SMP_INCREMENTS,
+			"critical %u, suspended %u", ulCriticalCount, ulSuspendedCount);
+}
+
+static void vControl(void *pvParameters)
+{
+	(void)pvParameters;
+
+	checkConcurrent();
+	checkAffinity();
+	checkPriority();
+	checkNotify();
+	checkCritical();
+
+	exit(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/* Idle cores take their interrupts here, and leave the host CPU to the
+ * others between polls. */
+static void smpIdle(void)
+{
+	const struct timespec pause = { 0, 20000 };
+
+	vPortSimPoll();
+	nanosleep(&pause, NULL);
+}
+
+void vApplicationIdleHook(void)
+{
+	smpIdle();
+}
+
+void vApplicationPassiveIdleHook(void)
+{
+	smpIdle();
+}
+
+int main(void)
+{
+	xTaskCreate(vControl, "control", SMP_STACK, NULL, SMP_CONTROL_PRIORITY, NULL);
+	vTaskStartScheduler();
+
+	printf("Error: scheduler unsuccessfully started!\n");
+	return 1;
+}
@@ -0,0 +1,228 @@
+/*
+ * Host test of the AMP mailbox (../../src/amp_mailbox.c).
+ *
+ * The high OCM is host memory mapped at its Zynq address and each core is a
+ * thread. The doorbell SGI posts a semaphore of the receiving core, as the GIC
+ * raises the interrupt there. Checks:
+ *
+ *  init      the rings are cleared and the magic published, the OCM is mapped
+ *            non-cacheable, CPU1 is released at its entry point
+ *  ring      a ring holds AMP_MAILBOX_SLOTS messages, keeps their order and
+ *            refuses more, also when the indexes wrap around 2^32
+ *  cores     "CPU1" streams AMP_TEST_MESSAGES time snapshots to "CPU0", which
+ *            sends a button command back every AMP_TEST_COMMAND_EVERY; every
+ *            message arrives once, whole and in order, each one rang the
+ *            doorbell, and CPU0 only drains the ring when woken by it
+ */
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include "unit.h"
+#include "xil_io.h"
+#include "xil_mmu.h"
+#include "amp_mailbox.h"
+
+#define AMP_TEST_MESSAGES		200000U
+#define AMP_TEST_COMMAND_EVERY	100U
+#define AMP_TEST_TIMEOUT_S		10
+
+#define AMP_TEST_OCM_SIZE		0x10000U	/* 0xFFFF0000 to the CPU1 start vector and above */
+
+static UINTPTR mappedAddr;
+static u32 mappedAttrib;
+static sem_t doorbell[2];			/* Indexed by CPU */
+static uint32_t doorbells[2];
+static XScuGic gic;
+
+void Xil_SetTlbAttributes(UINTPTR Addr, u32 attrib)
+{
+	mappedAddr = Addr;
+	mappedAttrib = attrib;
+}
+
+s32 XScuGic_SoftwareIntr(XScuGic *InstancePtr, u32 Int_Id, u32 Cpu_Identifier)
+{
+	(void)InstancePtr;
+
+	for(uint32_t cpu = 0; cpu < 2U; cpu++) {
+		if(Cpu_Identifier & (1U << cpu)) {
+			__atomic_fetch_add(&doorbells[cpu], 1U, __ATOMIC_RELAXED);
+			sem_post(&doorbell[cpu]);
+		}
+	}
+	return Int_Id < 16U ? 0 : 1;
+}
+
+/* 0 once the doorbell rang, -1 on timeout */
+static int waitDoorbell(uint32_t cpu)
+{
+	struct timespec until;
+
+	clock_gettime(CLOCK_REALTIME, &until);
+	until.tv_sec += AMP_TEST_TIMEOUT_S;
+	while(sem_timedwait(&doorbell[cpu], &until) != 0) {
+		if(errno != EINTR) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static AmpMessage timeMessage(uint64_t n)
+{
+	AmpMessage msg = { AMP_MSG_TIME, (uint32_t)(n * 2654435761U), n };
+
+	return msg;
+}
+
+static void testInit(void)
+{
+	memset(AMP_MAILBOX, 0xA5, sizeof(AmpMailbox));
+	UNIT_CHECK(!ampMailboxIsReady());
+	ampMailboxInit();
+
+	UNIT_CHECK(ampMailboxIsReady());
+	UNIT_CHECK(mappedAddr == AMP_MAILBOX_BASEADDR && mappedAttrib == NORM_NONCACHE);
+	UNIT_CHECK(AMP_MAILBOX->toCpu0.head == 0U && AMP_MAILBOX->toCpu0.tail == 0U);
+	UNIT_CHECK(AMP_MAILBOX->toCpu1.head == 0U && AMP_MAILBOX->toCpu1.tail == 0U);
+	/* head and tail on separate cache lines */
+	UNIT_CHECK(offsetof(AmpRing, tail) - offsetof(AmpRing, head) >= 32U);
+	ampStartCpu1();
+	UNIT_CHECK(Xil_In32(AMP_CPU1_START_VECTOR) == AMP_CPU1_START_ADDR);
+	unitResult("init", "mailbox of %u bytes", (unsigned)sizeof(AmpMailbox));
+}
+
+static void testRing(uint32_t start)
+{
+	AmpRing *ring = &AMP_MAILBOX->toCpu1;
+	AmpMessage msg;
+
+	ring->head = start;
+	ring->tail = start;
+	UNIT_CHECK(!ampRingPop(ring, &msg));
+	for(uint32_t i = 0; i < AMP_MAILBOX_SLOTS; i++) {
+		msg = timeMessage(i);
+		UNIT_CHECK(ampRingPush(ring, &msg));
+	}
+	msg = timeMessage(AMP_MAILBOX_SLOTS);
+	UNIT_CHECK(!ampRingPush(ring, &msg));
+
+	for(uint32_t i = 0; i < AMP_MAILBOX_SLOTS; i++) {
+		AmpMessage expected = timeMessage(i);
+
+		UNIT_CHECK(ampRingPop(ring, &msg));
+		UNIT_CHECK(memcmp(&msg, &expected, sizeof(msg)) == 0);
+		/* A freed slot takes a message again */
+		expected = timeMessage(AMP_MAILBOX_SLOTS + i);
+		UNIT_CHECK(ampRingPush(ring, &expected));
+	}
+	for(uint32_t i = 0; i < AMP_MAILBOX_SLOTS; i++) {
+		UNIT_CHECK(ampRingPop(ring, &msg) && msg.time == AMP_MAILBOX_SLOTS + i);
+	}
+	UNIT_CHECK(!ampRingPop(ring, &msg));
+	UNIT_CHECK(ring->head == ring->tail && ring->head == start + 2U * AMP_MAILBOX_SLOTS);
+	ring->head = 0U;
+	ring->tail = 0U;
+	unitResult("ring", "indexes from 0x%08x", start);
+}
+
+static volatile uint32_t cpu1Commands;
+static volatile uint32_t cpu1Errors;
+
+/* CPU1: publish the time snapshots, apply the commands */
+static void *cpu1Main(void *arg)
+{
+	AmpMailbox *mailbox = AMP_MAILBOX;
+	uint64_t sent = 0;
+
+	(void)arg;
+	while(sent < AMP_TEST_MESSAGES) {
+		AmpMessage msg = timeMessage(sent);
+		AmpMessage cmd;
+
+		if(ampRingPush(&mailbox->toCpu0, &msg)) {
+			sent++;
+			ampRingDoorbell(&gic, AMP_DOORBELL_TO_CPU0, XSCUGIC_SPI_CPU0_MASK);
+		}
+		while(ampRingPop(&mailbox->toCpu1, &cmd)) {
+			if(cmd.type != AMP_MSG_BUTTON || cmd.arg != cpu1Commands) {
+				cpu1Errors++;
+			}
+			cpu1Commands++;
+		}
+	}
+	return NULL;
+}
+
+static void testCores(void)
+{
+	AmpMailbox *mailbox = AMP_MAILBOX;
+	pthread_t cpu1;
+	uint64_t received = 0;
+	uint32_t commands = 0, errors = 0, wakeups = 0, refused = 0;
+	int timedOut = 0;
+
+	sem_init(&doorbell[0], 0, 0);
+	sem_init(&doorbell[1], 0, 0);
+	pthread_create(&cpu1, NULL, cpu1Main, NULL);
+
+	/* CPU0: woken by the doorbell, drains the ring as the SGI handler does */
+	while(received < AMP_TEST_MESSAGES) {
+		AmpMessage msg;
+
+		if(waitDoorbell(0) != 0) {
+			timedOut = 1;
+			break;
+		}
+		wakeups++;
+		while(ampRingPop(&mailbox->toCpu0, &msg)) {
+			AmpMessage expected = timeMessage(received);
+
+			if(memcmp(&msg, &expected, sizeof(msg)) != 0) {
+				errors++;
+			}
+			received++;
+			if(received % AMP_TEST_COMMAND_EVERY == 0U) {
+				AmpMessage cmd = { AMP_MSG_BUTTON, commands, 0 };
+
+				if(ampRingPush(&mailbox->toCpu1, &cmd)) {
+					commands++;
+				} else {
+					refused++;
+				}
+			}
+		}
+	}
+	pthread_join(cpu1, NULL);
+	/* Commands sent after the last snapshot are still in the ring */
+	while(ampRingPop(&mailbox->toCpu1, &(AmpMessage){ 0 })) {
+		cpu1Commands++;
+	}
+
+	UNIT_CHECK(!timedOut);
+	UNIT_CHECK(received == AMP_TEST_MESSAGES && errors == 0U);
+	UNIT_CHECK(cpu1Commands == commands && cpu1Errors == 0U);
+	UNIT_CHECK(doorbells[0] == AMP_TEST_MESSAGES);
+	unitResult("cores", "%u messages, %u wakeups, %u commands (%u refused by a full ring)",
+			(unsigned)received, wakeups, commands, refused);
+}
+
+int main(void)
+{
+	if(mmap((void *)(UINTPTR)AMP_MAILBOX_BASEADDR, AMP_TEST_OCM_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != (void *)(UINTPTR)AMP_MAILBOX_BASEADDR) {
+		printf("Error: high OCM unsuccessfully mapped at 0x%08x!\n", AMP_MAILBOX_BASEADDR);
+		return 2;
+	}
+	testInit();
+	testRing(0U);
+	testRing(0xFFFFFFF8U);
+	testCores();
+	return unitExit();
+}
@@ -0,0 +1,335 @@
+/*
+ * Host test of the Data cache range maintenance of the standalone BSP
+ * (xil_cache.c, copied to the build directory so that the stand-in headers
+ * apply).
+ *
+ * The CP15 line operations and the L2 controller registers written with
+ * Xil_Out32() are recorded, the CPSR is a variable. The by-PA L2 registers the
+ * range loops store to directly are host memory mapped at the L2 controller
+ * address: only the last line written is seen there. Checks:
+ *
+ *  flush       an unaligned range cleans every line it touches once, in
+ *              order, with one L2 sync, and leaves the interrupts as found
+ *  top         the same at the top of the address space (high OCM), where
+ *              the end address wraps to 0
+ *  chunks      interrupts are unmasked every XIL_CACHE_RANGE_CHUNK bytes and
+ *              the L2 is still synced once
+ *  threshold   ranges of XIL_CACHE_FLUSH_ALL_THRESHOLD bytes or more flush the
+ *              whole cache by set/way and L2 way, shorter ones line by line
+ *  ranges      the list APIs skip empty ranges, sync once per list and apply
+ *              the threshold to the total
+ *  invalidate  partial end lines are flushed first, a range within one line
+ *              is flushed once and not invalidated, the L2 is synced once per
+ *              chunk, also at the top of the address space
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "unit.h"
+#include "xil_cache.h"
+#include "xil_io.h"
+#include "xparameters.h"
+#include "xreg_cortexa9.h"
+#include "xl2cc.h"
+
+#define CACHE_TEST_LINE		32U
+#define CACHE_TEST_OPS		8192U
+#define CACHE_TEST_IRQ_MASK	0xC0U
+#define CACHE_TEST_CPSR		0x1FU	/* System mode, interrupts enabled */
+#define CACHE_TEST_CCSIDR	0xE01FE019U	/* 32 KB, 4 ways of 32 byte lines */
+#define CACHE_TEST_L1_LINES	1024U
+
+typedef enum {
+	OP_L1_FLUSH,	/* Clean and invalidate by MVA */
+	OP_L1_INV,		/* Invalidate by MVA */
+	OP_L1_SETWAY,	/* Clean and invalidate by set/way */
+	OP_L2_CLEAN,	/* Line operations through Xil_Out32() */
+	OP_L2_INV,
+	OP_L2_FLUSH,
+	OP_L2_WAY,		/* Whole cache by way */
+	OP_L2_SYNC
+} CacheOp;
+
+typedef struct {
+	CacheOp op;
+	u32 addr;
+} CacheRecord;
+
+static CacheRecord ops[CACHE_TEST_OPS];
+static u32 opCount;
+static u32 cpsr = CACHE_TEST_CPSR;
+static u32 masks;				/* Interrupt masking, not nested */
+static u32 maskedLines;			/* L1 line operations since masking */
+static u32 maxMaskedLines;
+static u32 unmaskedOps;			/* L1 line operations with interrupts enabled */
+static volatile u32 *l2cc;		/* Mapped at XPS_L2CC_BASEADDR */
+
+s32 _stack_end;
+s32 __undef_stack;
+
+static void record(CacheOp op, u32 addr)
+{
+	if(opCount < CACHE_TEST_OPS) {
+		ops[opCount] = (CacheRecord){ op, addr };
+	}
+	opCount++;
+}
+
+u32 unitCpsrRead(void)
+{
+	return cpsr;
+}
+
+void unitCpsrWrite(u32 Value)
+{
+	if((Value & CACHE_TEST_IRQ_MASK) && !(cpsr & CACHE_TEST_IRQ_MASK)) {
+		masks++;
+		maskedLines = 0;
+	}
+	cpsr = Value;
+}
+
+u32 unitCp15Read(const char *Reg)
+{
+	return strcmp(Reg, XREG_CP15_CACHE_SIZE_ID) == 0 ? CACHE_TEST_CCSIDR : 0U;
+}
+
+void unitCp15Write(const char *Reg, u32 Value)
+{
+	CacheOp op;
+
+	if(strcmp(Reg, XREG_CP15_CLEAN_INVAL_DC_LINE_MVA_POC) == 0) {
+		op = OP_L1_FLUSH;
+	} else if(strcmp(Reg, XREG_CP15_INVAL_DC_LINE_MVA_POC) == 0) {
+		op = OP_L1_INV;
+	} else if(strcmp(Reg, XREG_CP15_CLEAN_INVAL_DC_LINE_SW) == 0) {
+		op = OP_L1_SETWAY;
+	} else {
+		return;
+	}
+	if(cpsr & CACHE_TEST_IRQ_MASK) {
+		if(++maskedLines > maxMaskedLines) {
+			maxMaskedLines = maskedLines;
+		}
+	} else {
+		unmaskedOps++;
+	}
+	record(op, Value);
+}
+
+/* Background operations of the L2 controller complete at once */
+void unitIoWrite(UINTPTR Addr, u32 Value)
+{
+	u32 offset = (u32)(Addr - XPS_L2CC_BASEADDR);
+
+	switch(offset) {
+	case XPS_L2CC_CACHE_CLEAN_PA_OFFSET:
+		record(OP_L2_CLEAN, Value);
+		break;
+	case XPS_L2CC_CACHE_INVLD_PA_OFFSET:
+		record(OP_L2_INV, Value);
+		break;
+	case XPS_L2CC_CACHE_INV_CLN_PA_OFFSET:
+		record(OP_L2_FLUSH, Value);
+		break;
+	case XPS_L2CC_CACHE_INV_CLN_WAY_OFFSET:
+		record(OP_L2_WAY, Value);
+		Value = 0U;
+		break;
+	case XPS_L2CC_CACHE_SYNC_OFFSET:
+		record(OP_L2_SYNC, Value);
+		Value = 0U;
+		break;
+	default:
+		break;
+	}
+	l2cc[offset / 4U] = Value;
+}
+
+u32 unitIoRead(UINTPTR Addr)
+{
+	return l2cc[(Addr - XPS_L2CC_BASEADDR) / 4U];
+}
+
+static void reset(void)
+{
+	opCount = 0;
+	masks = 0;
+	maxMaskedLines = 0;
+	unmaskedOps = 0;
+	memset((void *)l2cc, 0, 0x1000U);
+}
+
+static u32 countOps(CacheOp op)
+{
+	u32 n = 0;
+
+	for(u32 i = 0; i < opCount && i < CACHE_TEST_OPS; i++) {
+		n += ops[i].op == op;
+	}
+	return n;
+}
+
+/* The op operations cover first to last (inclusive) line by line, in order */
+static int coversLines(CacheOp op, u32 first, u32 last)
+{
+	u32 expected = first;
+	u32 n = 0;
+
+	for(u32 i = 0; i < opCount && i < CACHE_TEST_OPS; i++) {
+		if(ops[i].op != op) {
+			continue;
+		}
+		if(ops[i].addr != expected) {
+			return 0;
+		}
+		expected += CACHE_TEST_LINE;
+		n++;
+	}
+	return n == (last - first) / CACHE_TEST_LINE + 1U;
+}
+
+static u32 l2Register(u32 offset)
+{
+	return l2cc[offset / 4U];
+}
+
+static void testFlush(const char *name, u32 adr, u32 len)
+{
+	u32 first = adr & ~(CACHE_TEST_LINE - 1U);
+	u32 last = (adr + len - 1U) & ~(CACHE_TEST_LINE - 1U);
+
+	reset();
+	Xil_DCacheFlushRange(adr, len);
+	UNIT_CHECK(coversLines(OP_L1_FLUSH, first, last));
+	UNIT_CHECK(countOps(OP_L1_FLUSH) == opCount - 1U);
+	UNIT_CHECK(opCount > 0U && ops[opCount - 1U].op == OP_L2_SYNC);
+	UNIT_CHECK(l2Register(XPS_L2CC_CACHE_INV_CLN_PA_OFFSET) == last);
+	UNIT_CHECK(unmaskedOps == 0U && cpsr == CACHE_TEST_CPSR);
+	unitResult(name, "0x%08x + %u: %u lines", adr, len, countOps(OP_L1_FLUSH));
+}
+
+static void testChunks(void)
+{
+	u32 len = 5U * XIL_CACHE_RANGE_CHUNK / 2U;
+
+	reset();
+	Xil_DCacheFlushRange(0x00100000U, len);
+	UNIT_CHECK(coversLines(OP_L1_FLUSH, 0x00100000U, 0x00100000U + len - CACHE_TEST_LINE));
+	UNIT_CHECK(masks == 3U);
+	UNIT_CHECK(maxMaskedLines == XIL_CACHE_RANGE_CHUNK / CACHE_TEST_LINE);
+	UNIT_CHECK(countOps(OP_L2_SYNC) == 1U);
+	UNIT_CHECK(unmaskedOps == 0U && cpsr == CACHE_TEST_CPSR);
+
+	reset();
+	Xil_DCacheInvalidateRange(0x00100000U, len);
+	UNIT_CHECK(coversLines(OP_L1_INV, 0x00100000U, 0x00100000U + len - CACHE_TEST_LINE));
+	UNIT_CHECK(countOps(OP_L1_FLUSH) == 0U);
+	UNIT_CHECK(masks == 4U);	/* And once for the partial end lines */
+	UNIT_CHECK(maxMaskedLines == XIL_CACHE_RANGE_CHUNK / CACHE_TEST_LINE);
+	UNIT_CHECK(countOps(OP_L2_SYNC) == 3U);
+	UNIT_CHECK(unmaskedOps == 0U && cpsr == CACHE_TEST_CPSR);
+	unitResult("chunks", "%u bytes, at most %u lines with interrupts masked", len, maxMaskedLines);
+}
+
+static void testThreshold(void)
+{
+	reset();
+	Xil_DCacheFlushRange(0x00200000U, XIL_CACHE_FLUSH_ALL_THRESHOLD - 1U);
+	UNIT_CHECK(countOps(OP_L1_FLUSH) == XIL_CACHE_FLUSH_ALL_THRESHOLD / CACHE_TEST_LINE);
+	UNIT_CHECK(countOps(OP_L1_SETWAY) == 0U && countOps(OP_L2_WAY) == 0U);
+
+	reset();
+	Xil_DCacheFlushRange(0x00200000U, XIL_CACHE_FLUSH_ALL_THRESHOLD);
+	UNIT_CHECK(countOps(OP_L1_FLUSH) == 0U);
+	UNIT_CHECK(countOps(OP_L1_SETWAY) == CACHE_TEST_L1_LINES);
+	UNIT_CHECK(countOps(OP_L2_WAY) == 1U);
+	UNIT_CHECK(cpsr == CACHE_TEST_CPSR);
+	unitResult("threshold", "%u bytes and more flush by set/way", XIL_CACHE_FLUSH_ALL_THRESHOLD);
+}
+
+static void testRanges(void)
+{
+	const Xil_CacheRange list[] = {
+		{ 0x00300010U, 100U },
+		{ 0x00400000U, 0U },
+		{ 0x00500000U, 64U },
+	};
+	const Xil_CacheRange large[] = {
+		{ 0x00300000U, XIL_CACHE_FLUSH_ALL_THRESHOLD / 2U },
+		{ 0x00400000U, XIL_CACHE_FLUSH_ALL_THRESHOLD / 2U },
+	};
+	u32 i;
+
+	reset();
+	Xil_DCacheFlushRanges(list, 3U);
+	UNIT_CHECK(opCount == 7U);
+	for(i = 0; i < 4U; i++) {
+		UNIT_CHECK(ops[i].op == OP_L1_FLUSH && ops[i].addr == 0x00300000U + i * CACHE_TEST_LINE);
+	}
+	UNIT_CHECK(ops[4].op == OP_L1_FLUSH && ops[4].addr == 0x00500000U);
+	UNIT_CHECK(ops[5].op == OP_L1_FLUSH && ops[5].addr == 0x00500020U);
+	UNIT_CHECK(ops[6].op == OP_L2_SYNC);
+
+	reset();
+	Xil_DCacheFlushRanges(large, 2U);
+	UNIT_CHECK(countOps(OP_L1_FLUSH) == 0U && countOps(OP_L1_SETWAY) == CACHE_TEST_L1_LINES);
+
+	reset();
+	Xil_DCacheInvalidateRanges(list, 3U);
+	UNIT_CHECK(countOps(OP_L1_INV) == 3U + 2U);
+	UNIT_CHECK(countOps(OP_L2_SYNC) == 2U + 2U);	/* Two partial lines, two ranges */
+	UNIT_CHECK(cpsr == CACHE_TEST_CPSR);
+	unitResult("ranges", "%u ranges, empty ones skipped", 3U);
+}
+
+static void testInvalidate(const char *name, u32 adr, u32 len)
+{
+	u32 end = adr + len;
+	u32 first = adr & ~(CACHE_TEST_LINE - 1U);
+	u32 last = (end - 1U) & ~(CACHE_TEST_LINE - 1U);
+	u32 invFirst = (adr & (CACHE_TEST_LINE - 1U)) ? first + CACHE_TEST_LINE : first;
+	u32 flushed = 0U;
+
+	reset();
+	Xil_DCacheInvalidateRange(adr, len);
+	if(adr & (CACHE_TEST_LINE - 1U)) {
+		UNIT_CHECK(ops[0].op == OP_L1_FLUSH && ops[0].addr == first);
+		flushed++;
+	}
+	if((end & (CACHE_TEST_LINE - 1U)) && last != first) {
+		flushed++;
+	}
+	UNIT_CHECK(countOps(OP_L1_FLUSH) == flushed);
+	UNIT_CHECK(countOps(OP_L2_CLEAN) == flushed && countOps(OP_L2_INV) == flushed);
+	if(last >= invFirst) {
+		/* Invalidation goes on to the last line, flushed or not */
+		UNIT_CHECK(coversLines(OP_L1_INV, invFirst, last));
+		UNIT_CHECK(l2Register(XPS_L2CC_CACHE_INVLD_PA_OFFSET) == last);
+	} else {
+		UNIT_CHECK(countOps(OP_L1_INV) == 0U);
+	}
+	UNIT_CHECK(unmaskedOps == 0U && cpsr == CACHE_TEST_CPSR);
+	unitResult(name, "0x%08x + %u: %u lines flushed, %u invalidated", adr, len, flushed, countOps(OP_L1_INV));
+}
+
+int main(void)
+{
+	l2cc = mmap((void *)(UINTPTR)XPS_L2CC_BASEADDR, 0x1000U, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	if(l2cc != (volatile u32 *)(UINTPTR)XPS_L2CC_BASEADDR) {
+		printf("Error: L2 controller unsuccessfully mapped at 0x%08x!\n", XPS_L2CC_BASEADDR);
+		return 2;
+	}
+	testFlush("flush", 0x00100010U, 100U);
+	testFlush("top", 0xFFFFFF10U, 0xF0U);
+	testChunks();
+	testThreshold();
+	testRanges();
+	testInvalidate("invalidate", 0x00100010U, 0x40U);
+	testInvalidate("invalidate", 0x00100004U, 8U);
+	testInvalidate("invalidate", 0x00100000U, 0x100U);
+	testInvalidate("top", 0xFFFFFF04U, 0xFCU);
+	return unitExit();
+}
@@ -0,0 +1,436 @@
+/*
+ * Host test of the buffered console (../../src/console.c) with the polled
+ * send of the uartps driver (xuartps_hw.c, copied to the build directory).
+ * Built twice by the Makefile, with a 256 byte ring: console_test drops the
+ * newest bytes when the ring is full, console_overwrite_test overwrites the
+ * oldest ones.
+ *
+ * The UART is a model of the TX side: a 64 byte FIFO that the wire empties one
+ * byte per step, either when the test runs it or, for the polled paths, each
+ * time the status register is read. The FIFO becoming empty sets TXEMPTY in
+ * the interrupt status, and the interrupt is taken when it is enabled and the
+ * CPSR does not mask IRQs. Checks:
+ *
+ *  polled      before consoleInit() the bytes go straight to the FIFO
+ *  init        the UART interrupt is installed with TXEMPTY disabled
+ *  wrap        messages of every length around the ring many times, drained
+ *              by the interrupt, arrive whole and in order, the interrupt is
+ *              disabled once the ring is empty
+ *  drop        console_test: the bytes that do not fit are discarded and
+ *              counted, what was queued is sent
+ *  overwrite   console_overwrite_test: the oldest queued bytes make room and
+ *              are counted, a message longer than the ring keeps its end
+ *  flush       consoleFlush() drains the ring by polling with IRQs masked
+ *  usb         output goes to the USB serial port while it is open
+ *
+ * Throughout, the UART is only touched with IRQs masked once the console is
+ * started, and the statistics count every byte.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "unit.h"
+#include "FreeRTOS.h"
+#include "xil_io.h"
+#include "xparameters.h"
+#include "xreg_cortexa9.h"
+#include "xstatus.h"
+#include "xuartps_hw.h"
+#include "console.h"
+#include "usbcdc.h"
+
+#define CONSOLE_TEST_FIFO	64U
+#define CONSOLE_TEST_RING	CONSOLE_TX_BUFFER_SIZE
+#define CONSOLE_TEST_OUT	32768U
+#define CONSOLE_TEST_IRQ	XREG_CPSR_IRQ_ENABLE	/* The I bit, set masks IRQs */
+
+static u32 cpsr = 0x1FU;	/* System mode, IRQs enabled */
+static int inIrq;
+static XInterruptHandler handler;
+static void *handlerRef;
+static uint8_t handlerId;
+static uint8_t enabledId;
+
+/* UART model */
+static uint8_t fifo[CONSOLE_TEST_FIFO];
+static uint32_t fifoHead;
+static uint32_t fifoCount;
+static u32 imr;
+static u32 isr;
+static int wireOnPoll;	/* Each SR read shifts a byte out */
+static int started;
+static uint32_t fifoOverruns;
+static uint32_t unlockedAccesses;
+static uint32_t interrupts;
+
+static char out[CONSOLE_TEST_OUT];	/* What left on the wire */
+static uint32_t outLen;
+static char in[CONSOLE_TEST_OUT];	/* What the test expects */
+static uint32_t inLen;
+
+static uint32_t usbOpen;
+static uint32_t usbBytes;
+
+static void irqCheck(void);
+
+void outbyte(char c);	/* Of console.c, in place of the BSP one */
+
+u32 unitCpsrRead(void)
+{
+	return cpsr;
+}
+
+void unitCpsrWrite(u32 Value)
+{
+	cpsr = Value;
+	irqCheck();
+}
+
+BaseType_t xPortInstallInterruptHandler(uint8_t ucInterruptID, XInterruptHandler pxHandler, void *pvCallBackRef)
+{
+	handlerId = ucInterruptID;
+	handler = pxHandler;
+	handlerRef = pvCallBackRef;
+	return pdPASS;
+}
+
+void vPortEnableInterrupt(uint8_t ucInterruptID)
+{
+	enabledId = ucInterruptID;
+}
+
+int usbcdcIsOpen(void)
+{
+	return (int)usbOpen;
+}
+
+uint32_t usbcdcWrite(const void *buf, uint32_t len)
+{
+	(void)buf;
+	usbBytes += len;
+	return len;
+}
+
+/* Only called by the fatal hooks, which are not run */
+void xil_printf(const char8 *ctrl1, ...)
+{
+	(void)ctrl1;
+}
+
+static void uartShift(void)
+{
+	if(fifoCount == 0U) {
+		return;
+	}
+	if(outLen < CONSOLE_TEST_OUT) {
+		out[outLen] = (char)fifo[fifoHead];
+	}
+	outLen++;
+	fifoHead = (fifoHead + 1U) % CONSOLE_TEST_FIFO;
+	if(--fifoCount == 0U) {
+		isr |= XUARTPS_IXR_TXEMPTY;
+	}
+}
+
+static void irqCheck(void)
+{
+	u32 saved;
+
+	if(inIrq || (cpsr & CONSOLE_TEST_IRQ) || !(imr & isr) || handler == NULL) {
+		return;
+	}
+	inIrq = 1;
+	interrupts++;
+	saved = cpsr;
+	cpsr |= CONSOLE_TEST_IRQ;
+	handler(handlerRef);
+	cpsr = saved;
+	inIrq = 0;
+}
+
+/* The wire sends n bytes, the interrupt is taken as it comes */
+static void uartRun(uint32_t n)
+{
+	while(n--) {
+		uartShift();
+		irqCheck();
+	}
+}
+
+u32 unitIoRead(UINTPTR Addr)
+{
+	switch(Addr - STDOUT_BASEADDRESS) {
+	case XUARTPS_IMR_OFFSET:
+		return imr;
+	case XUARTPS_ISR_OFFSET:
+		return isr;
+	case XUARTPS_SR_OFFSET:
+		if(wireOnPoll) {
+			uartShift();
+		}
+		return (fifoCount == CONSOLE_TEST_FIFO ? XUARTPS_SR_TXFULL : 0U) |
+				(fifoCount == 0U ? XUARTPS_SR_TXEMPTY : 0U);
+	default:
+		return 0U;
+	}
+}
+
+void unitIoWrite(UINTPTR Addr, u32 Value)
+{
+	if(started && !(cpsr & CONSOLE_TEST_IRQ)) {
+		unlockedAccesses++;
+	}
+	switch(Addr - STDOUT_BASEADDRESS) {
+	case XUARTPS_IER_OFFSET:
+		imr |= Value;
+		break;
+	case XUARTPS_IDR_OFFSET:
+		imr &= ~Value;
+		break;
+	case XUARTPS_ISR_OFFSET:
+		isr &= ~Value;
+		break;
+	case XUARTPS_FIFO_OFFSET:
+		if(fifoCount == CONSOLE_TEST_FIFO) {
+			fifoOverruns++;
+			break;
+		}
+		fifo[(fifoHead + fifoCount) % CONSOLE_TEST_FIFO] = (uint8_t)Value;
+		fifoCount++;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Message number n, of length len */
+static void message(char *buf, uint32_t len, uint32_t n)
+{
+	for(uint32_t i = 0; i < len; i++) {
+		buf[i] = (char)('A' + (n + i) % 26U);
+	}
+}
+
+static void expect(const char *buf, uint32_t len)
+{
+	memcpy(&in[inLen], buf, len);
+	inLen += len;
+}
+
+static void drain(void)
+{
+	uint32_t guard = 0;
+
+	while((fifoCount != 0U || (imr & XUARTPS_IXR_TXEMPTY)) && guard++ < 100000U) {
+		uartRun(1);
+	}
+}
+
+static int outMatches(void)
+{
+	return outLen == inLen && memcmp(out, in, inLen) == 0;
+}
+
+static void reset(void)
+{
+	outLen = 0;
+	inLen = 0;
+}
+
+static void statsCheck(uint32_t queued, uint32_t dropped, uint32_t overwritten, uint32_t highWater)
+{
+	ConsoleStats_t stats;
+
+	consoleGetStats(&stats);
+	UNIT_CHECK(stats.ulBytesQueued == queued);
+	UNIT_CHECK(stats.ulBytesDropped == dropped);
+	UNIT_CHECK(stats.ulBytesOverwritten == overwritten);
+	UNIT_CHECK(stats.ulHighWaterMark == highWater);
+}
+
+static void testPolled(void)
+{
+	static const char line[] = "polled output\r\n";
+
+	wireOnPoll = 1;
+	consoleWrite(line, sizeof(line) - 1U);
+	expect(line, sizeof(line) - 1U);
+	outbyte('!');
+	expect("!", 1);
+	while(fifoCount) {
+		uartShift();
+	}
+	wireOnPoll = 0;
+	UNIT_CHECK(outMatches());
+	UNIT_CHECK(imr == 0U && fifoOverruns == 0U);
+	statsCheck(0, 0, 0, 0);
+	unitResult("polled", "%u bytes sent before the ring", (unsigned)outLen);
+	reset();
+}
+
+static void testInit(void)
+{
+	imr = XUARTPS_IXR_TXEMPTY;	/* Left on by whoever had the UART */
+	UNIT_CHECK(consoleInit() == XST_SUCCESS);
+	started = 1;
+	UNIT_CHECK(handler != NULL);
+	UNIT_CHECK(handlerId == XPAR_XUARTPS_0_INTR && enabledId == XPAR_XUARTPS_0_INTR);
+	UNIT_CHECK(imr == 0U);
+	unitResult("init", "interrupt %u installed, TXEMPTY disabled", (unsigned)handlerId);
+}
+
+static void testWrap(void)
+{
+	char buf[CONSOLE_TEST_RING];
+	uint32_t total = 0;
+	uint32_t n = 0;
+	uint32_t irqBefore = interrupts;
+	ConsoleStats_t stats;
+
+	/* Every length from 1 to 150 twice, the wire kept slow enough to fill the
+	ring and never so slow that it overflows */
+	for(uint32_t len = 1; len <= 150U; len += (n & 1U), n++) {
+		for(uint32_t i = 0; (total - outLen) + len > CONSOLE_TEST_RING && i < 1000U; i++) {
+			uartRun(len / 4U + 1U);
+		}
+		message(buf, len, n);
+		expect(buf, len);
+		consoleWrite(buf, len);
+		total += len;
+		uartRun(n % 7U);
+	}
+	drain();
+	UNIT_CHECK(outMatches());
+	UNIT_CHECK(imr == 0U);
+	UNIT_CHECK(fifoOverruns == 0U && unlockedAccesses == 0U);
+	consoleGetStats(&stats);
+	UNIT_CHECK(stats.ulBytesQueued == total);
+	UNIT_CHECK(stats.ulBytesDropped == 0U && stats.ulBytesOverwritten == 0U);
+	UNIT_CHECK(stats.ulHighWaterMark <= CONSOLE_TEST_RING && stats.ulHighWaterMark > CONSOLE_TEST_RING / 2U);
+	unitResult("wrap", "%u messages, %u bytes, %u times around the ring, %u interrupts, high water %u",
+		(unsigned)n, (unsigned)total, (unsigned)(total / CONSOLE_TEST_RING),
+		(unsigned)(interrupts - irqBefore), (unsigned)stats.ulHighWaterMark);
+	reset();
+}
+
+#if CONSOLE_TX_POLICY == CONSOLE_POLICY_OVERWRITE_OLDEST
+
+static void testOverwrite(void)
+{
+	char a[CONSOLE_TEST_RING + 100U];
+	char b[100];
+	ConsoleStats_t before;
+
+	consoleGetStats(&before);
+	message(a, sizeof(a), 0);
+	message(b, sizeof(b), 7);
+
+	/* Longer than the ring: only its end is queued, the FIFO takes the first
+	64 of those */
+	consoleWrite(a, sizeof(a));
+	UNIT_CHECK(fifoCount == CONSOLE_TEST_FIFO);
+	/* 64 bytes of room, the 36 oldest queued ones go */
+	consoleWrite(b, sizeof(b));
+	outbyte('!');
+	expect(&a[100], CONSOLE_TEST_FIFO);
+	expect(&a[100U + CONSOLE_TEST_FIFO + 37U], CONSOLE_TEST_RING - CONSOLE_TEST_FIFO - 37U);
+	expect(b, sizeof(b));
+	expect("!", 1);
+	drain();
+	UNIT_CHECK(outMatches());
+	UNIT_CHECK(fifoOverruns == 0U && unlockedAccesses == 0U);
+	statsCheck(before.ulBytesQueued + CONSOLE_TEST_RING + sizeof(b) + 1U, 0,
+		100U + 36U + 1U, before.ulHighWaterMark > CONSOLE_TEST_RING ? before.ulHighWaterMark : CONSOLE_TEST_RING);
+	unitResult("overwrite", "%u oldest bytes overwritten, the %u newest sent", 137U, (unsigned)outLen);
+	reset();
+}
+
+#else
+
+static void testDrop(void)
+{
+	char a[CONSOLE_TEST_RING + 100U];
+	char b[100];
+	ConsoleStats_t before;
+
+	consoleGetStats(&before);
+	message(a, sizeof(a), 0);
+	message(b, sizeof(b), 7);
+
+	/* The ring takes its size, the FIFO then the first 64 bytes of it */
+	consoleWrite(a, sizeof(a));
+	UNIT_CHECK(fifoCount == CONSOLE_TEST_FIFO);
+	/* 64 bytes of room left */
+	consoleWrite(b, sizeof(b));
+	outbyte('!');
+	expect(a, CONSOLE_TEST_RING);
+	expect(b, CONSOLE_TEST_FIFO);
+	drain();
+	UNIT_CHECK(outMatches());
+	UNIT_CHECK(fifoOverruns == 0U && unlockedAccesses == 0U);
+	statsCheck(before.ulBytesQueued + CONSOLE_TEST_RING + CONSOLE_TEST_FIFO, 100U + 36U + 1U, 0,
+		before.ulHighWaterMark > CONSOLE_TEST_RING ? before.ulHighWaterMark : CONSOLE_TEST_RING);
+	unitResult("drop", "%u newest bytes dropped, the %u oldest sent", 137U, (unsigned)outLen);
+	reset();
+}
+
+#endif /* CONSOLE_TX_POLICY */
+
+static void testFlush(void)
+{
+	char buf[200];
+	u32 cpsrBefore = cpsr;
+	uint32_t irqBefore = interrupts;
+
+	message(buf, sizeof(buf), 3);
+	consoleWrite(buf, sizeof(buf));
+	expect(buf, sizeof(buf));
+	wireOnPoll = 1;
+	consoleFlush();
+	wireOnPoll = 0;
+	UNIT_CHECK(outMatches());
+	UNIT_CHECK(fifoCount == 0U);
+	UNIT_CHECK(cpsr == cpsrBefore);
+	UNIT_CHECK(fifoOverruns == 0U && unlockedAccesses == 0U);
+	/* The TX empty interrupt still armed finds the ring empty */
+	irqCheck();
+	UNIT_CHECK(imr == 0U && outLen == sizeof(buf));
+	unitResult("flush", "%u bytes drained by polling, %u interrupts", (unsigned)outLen,
+		(unsigned)(interrupts - irqBefore));
+	reset();
+}
+
+static void testUsb(void)
+{
+	char buf[50];
+	ConsoleStats_t before;
+	ConsoleStats_t after;
+
+	consoleGetStats(&before);
+	message(buf, sizeof(buf), 5);
+	usbOpen = 1;
+	consoleWrite(buf, sizeof(buf));
+	outbyte('!');
+	usbOpen = 0;
+	uartRun(CONSOLE_TEST_FIFO);
+	consoleGetStats(&after);
+	UNIT_CHECK(usbBytes == sizeof(buf) + 1U);
+	UNIT_CHECK(outLen == 0U && fifoCount == 0U);
+	UNIT_CHECK(after.ulBytesQueued == before.ulBytesQueued);
+	unitResult("usb", "%u bytes to the USB serial port, none to the UART", (unsigned)usbBytes);
+}
+
+int main(void)
+{
+	testPolled();
+	testInit();
+	testWrap();
+#if CONSOLE_TX_POLICY == CONSOLE_POLICY_OVERWRITE_OLDEST
+	testOverwrite();
+#else
+	testDrop();
+#endif
+	testFlush();
+	testUsb();
+	return unitExit();
+}
@@ -0,0 +1,236 @@
+/*
+ * Host test of the deferred log (../../src/dlog.c) and its decoder
+ * (../../tools/dlog_decode.py).
+ *
+ * The console and the USB trace channel are buffers that keep every frame.
+ * The frames written to the console are saved with some plain text in between
+ * to build/unit/dlog_test.dlog, as a UART capture would be, and the decoder
+ * renders them from the .dlog_fmt section of this program (linked at address
+ * 0 by unit/dlog.ld as on the target). The global timer is a virtual clock
+ * set by the test, its low word read in counts of the target timer. Checks:
+ *
+ *  frame     each DLOG() is one consoleWrite() of a 0x00 delimited COBS frame
+ *            of 10 + 4 bytes per argument, without 0x00 inside, whose record
+ *            sums to 0 and carries the low word of the clock
+ *  decode    the decoder prints the text of every record with its timestamp:
+ *            no and eight arguments, negative and full range values, field
+ *            widths, flags and length modifiers, %c and %%, plain text passed
+ *            through, corrupt records and unknown IDs reported
+ *  usb       while the trace channel is open the frames go there and nothing
+ *            to the console
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unit.h"
+#include "console.h"
+#include "usbcdc.h"
+#include "dlog.h"
+
+#define DLOG_TEST_BUF		4096U
+#define DLOG_TEST_OUT		4096U
+#define DLOG_TEST_SECOND	333333333ULL	/* Global timer counts of the target, see dlog_decode.py */
+
+typedef struct {
+	uint8_t data[DLOG_TEST_BUF];
+	uint32_t len;
+	uint32_t writes;
+	uint32_t lastLen;	/* Length of the last write */
+} Sink;
+
+static Sink console;
+static Sink trace;
+static int traceOpen;
+static uint64_t testClock;
+
+uint64_t simClock(void)
+{
+	return testClock;
+}
+
+static void sinkWrite(Sink *sink, const void *buf, uint32_t len)
+{
+	if(sink->len + len <= sizeof(sink->data)) {
+		memcpy(&sink->data[sink->len], buf, len);
+		sink->len += len;
+	}
+	sink->writes++;
+	sink->lastLen = len;
+}
+
+void consoleWrite(const char *buf, uint32_t len)
+{
+	sinkWrite(&console, buf, len);
+}
+
+int usbcdcTraceIsOpen(void)
+{
+	return traceOpen;
+}
+
+uint32_t usbcdcTraceWrite(const void *buf, uint32_t len)
+{
+	sinkWrite(&trace, buf, len);
+	return len;
+}
+
+/* Plain xil_printf() text between the records */
+static void plain(const char *text)
+{
+	consoleWrite(text, (uint32_t)strlen(text));
+}
+
+/* Check the frame of the last write to sink, which carried nargs arguments */
+static void checkFrame(const Sink *sink, uint32_t writes, uint32_t nargs)
+{
+	const uint8_t *frame = &sink->data[sink->len - sink->lastLen];
+	uint8_t record[64];
+	uint32_t len = 0;
+	uint8_t sum = 0;
+
+	UNIT_CHECK(sink->writes == writes + 1U);
+	UNIT_CHECK(sink->lastLen == 10U + 4U * nargs);
+	if(sink->lastLen != 10U + 4U * nargs) {
+		return;
+	}
+	UNIT_CHECK(frame[0] == 0 && frame[sink->lastLen - 1U] == 0);
+	for(uint32_t i = 1; i < sink->lastLen - 1U; i++) {
+		UNIT_CHECK(frame[i] != 0);
+	}
+	/* COBS decode */
+	for(uint32_t i = 1; i < sink->lastLen - 1U; ) {
+		uint32_t code = frame[i];
+
+		for(uint32_t j = 1; j < code; j++) {
+			record[len++] = frame[i + j];
+		}
+		i += code;
+		if(i < sink->lastLen - 1U) {
+			record[len++] = 0;
+		}
+	}
+	UNIT_CHECK(len == 7U + 4U * nargs);
+	for(uint32_t i = 0; i < len; i++) {
+		sum += record[i];
+	}
+	UNIT_CHECK(sum == 0);
+	UNIT_CHECK((uint32_t)record[2] == (uint32_t)(testClock & 0xFFU));
+}
+
+static uint32_t frames;
+
+/* DLOG() and check its frame */
+#define LOG(nargs, ...) do { \
+		uint32_t writes = console.writes; \
+		DLOG(__VA_ARGS__); \
+		checkFrame(&console, writes, nargs); \
+		frames++; \
+	} while(0)
+
+static void testFrame(void)
+{
+	testClock = 0;
+	LOG(0, "Stopwatch started\r\n");
+	plain("plain text\r\n");
+	testClock = (1ULL << 32) + DLOG_TEST_SECOND;	/* Only the low word is sent */
+	LOG(1, "Button %u pressed\r\n", 3);
+	LOG(2, "Lap %d ms, delta %d\r\n", 1234, -56);
+	testClock = 0xFFFFFFFFULL;
+	LOG(6, "Widths [%5u] [%-5d] [%05d] [%x] [%08X] [%c] 100%%\r\n", 42, -7, 42, 0xDEADBEEFU, 0xBEEFU, 'k');
+	LOG(4, "Range %u %d %u %d\r\n", 0xFFFFFFFFU, INT32_MIN, 0, INT32_MAX);
+	LOG(8, "%u %u %u %u %u %u %u %u\r\n", 1, 2, 3, 4, 5, 6, 7, 8);
+	LOG(4, "Length %lu %ld %hu %hhx\r\n", 100000UL, -1L, 65535, 0xABU);
+	unitResult("frame", "%u frames, %u console bytes", frames, console.len);
+}
+
+/* Decode the capture with dlog_decode.py, returns the output length */
+static size_t decode(const char *elf, const char *capture, char *out, size_t size)
+{
+	char cmd[512];
+	FILE *pipe;
+	size_t len;
+
+	snprintf(cmd, sizeof(cmd), "python3 %s -t %s %s", DLOG_DECODE, elf, capture);
+	pipe = popen(cmd, "r");
+	if(pipe == NULL) {
+		return 0;
+	}
+	len = fread(out, 1, size - 1U, pipe);
+	out[len] = '\0';
+	UNIT_CHECK(pclose(pipe) == 0);
+	return len;
+}
+
+static void testDecode(const char *elf)
+{
+	static const char expected[] =
+		"[  0.000000] Stopwatch started\r\n"
+		"plain text\r\n"
+		"[  1.000000] Button 3 pressed\r\n"
+		"[  1.000000] Lap 1234 ms, delta -56\r\n"
+		"[ 12.884902] Widths [   42] [-7   ] [00042] [deadbeef] [0000BEEF] [k] 100%\r\n"
+		"[ 12.884902] Range 4294967295 -2147483648 0 2147483647\r\n"
+		"[ 12.884902] 1 2 3 4 5 6 7 8\r\n"
+		"[ 12.884902] Length 100000 -1 65535 ab\r\n"
+		"more text\r\n"
+		"<dlog: corrupt record>\r\n"
+		"<dlog: unknown format id 65535>\r\n";
+	/* ID 0xFFFF, timestamp 0x01010101, checksum 0xFE */
+	static const uint8_t unknown[] = { 0x00, 0x08, 0xFF, 0xFF, 0x01, 0x01, 0x01, 0x01, 0xFE, 0x00 };
+	char capture[256];
+	static char out[DLOG_TEST_OUT];
+	FILE *f;
+	size_t len;
+
+	plain("more text\r\n");
+	testClock = 0x01010101U;
+	DLOG("Corrupt %u\r\n", 1);
+	console.data[console.len - 14U + 4U] ^= 0x10;	/* Low byte of the timestamp */
+	sinkWrite(&console, unknown, sizeof(unknown));
+
+	snprintf(capture, sizeof(capture), "%s.dlog", elf);
+	f = fopen(capture, "wb");
+	UNIT_CHECK(f != NULL);
+	if(f == NULL) {
+		unitResult("decode", "cannot write %s", capture);
+		return;
+	}
+	fwrite(console.data, 1, console.len, f);
+	fclose(f);
+
+	len = decode(elf, capture, out, sizeof(out));
+	UNIT_CHECK(len == strlen(expected));
+	UNIT_CHECK(strcmp(out, expected) == 0);
+	if(strcmp(out, expected) != 0) {
+		printf("  expected:\n%s  decoded:\n%s", expected, out);
+	}
+	unitResult("decode", "%u bytes of text from %s", (unsigned)len, capture);
+}
+
+static void testUsb(void)
+{
+	uint32_t consoleLen = console.len;
+	uint32_t writes = trace.writes;
+
+	traceOpen = 1;
+	testClock = 5;
+	DLOG("Trace %d %d\r\n", -1, 2);
+	checkFrame(&trace, writes, 2);
+	UNIT_CHECK(console.len == consoleLen);
+	traceOpen = 0;
+	DLOG("Console\r\n");
+	UNIT_CHECK(trace.writes == writes + 1U);
+	UNIT_CHECK(console.len == consoleLen + 10U);
+	unitResult("usb", "%u trace bytes", trace.len);
+}
+
+int main(int argc, char **argv)
+{
+	(void)argc;
+	testFrame();
+	testDecode(argv[0]);
+	testUsb();
+	return unitExit();
+}
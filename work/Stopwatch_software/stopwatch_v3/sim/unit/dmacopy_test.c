@@ -0,0 +1,981 @@
+/*
+ * Host test of the PL330 copy service (../../src/dmacopy.c) with the program
+ * generator of the dmaps driver (xdmaps.c, copied to the build directory so
+ * that the stand-in headers apply).
+ *
+ * The DMA controller is a model that executes the microcode the channels are
+ * started on: DMAMOV, DMALP/DMALPEND with both loop counters, DMALD/DMAST
+ * through a channel FIFO sized by the CCR bursts, DMAWMB, DMASEV and DMAEND.
+ * DMAGO and DMAKILL arrive through the debug registers as from the driver. A
+ * channel runs when the test lets time pass, or when the task blocks on its
+ * notification; its done interrupt is raised once it has stopped, a fault
+ * stops it and raises the abort interrupt. Checks:
+ *
+ *  init      the driver reads the instruction cache geometry, all interrupts
+ *            are installed and enabled, no channel runs
+ *  prog      copies from 4 KB to over two 8 MB chunks with every head and tail
+ *            alignment: the generated programs fit the driver's 128 byte
+ *            buffers, use 128 byte bursts, take the single and the nested loop
+ *            paths and move exactly the whole lines between head and tail
+ *  cache     a program of a known length is patched with the new addresses,
+ *            the least recently built of a full cache is replaced
+ *  cpu       short, differently aligned and early copies stay on the CPU
+ *  queue     eight copies start at once, the rest wait in the request ring
+ *            and start from done interrupts, a copy refused by the full ring
+ *            is done on the CPU, each task is woken on its own index only
+ *  race      the done interrupt of another channel arrives at every register
+ *            access and cache maintenance call of dmacopySubmit()
+ *  fault     a channel fault completes its request as faulted, the channel is
+ *            killed and serves the next copy, dmacopyMemcpy() still copies
+ *  wait      a pending copy times out, then completes
+ *
+ * Throughout, every copy is exact and leaves the bytes around it alone, the
+ * DMA reads only source lines cleaned after the CPU wrote them and writes
+ * whole destination lines invalidated before, the CPU reads them only after
+ * they were invalidated again, a program is read only once cleaned to memory,
+ * a channel is started only while stopped and the driver asserts nothing.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "unit.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xil_cache.h"
+#include "xil_io.h"
+#include "xparameters.h"
+#include "xdmaps.h"
+#include "dmacopy.h"
+
+#define DMA_TEST_BASE			XPAR_XDMAPS_1_BASEADDR
+#define DMA_TEST_CR1			0x74U		/* Eight 16 byte instruction cache lines */
+#define DMA_TEST_CHANNELS		XDMAPS_CHANNELS_PER_DEV
+#define DMA_TEST_LINE			32U
+#define DMA_TEST_CHUNK			(8U << 20)	/* DMACOPY_CHUNK */
+#define DMA_TEST_BURST			128U		/* 16 beats of 8 bytes */
+#define DMA_TEST_FIFO			256U
+#define DMA_TEST_BUF_SIZE		(2U * DMA_TEST_CHUNK + 65536U)
+#define DMA_TEST_GUARD			64U
+#define DMA_TEST_RANGES			4096U
+#define DMA_TEST_WRITES			256U
+#define DMA_TEST_PROGS			64U
+#define DMA_TEST_REQS			48U
+#define DMA_TEST_SLOT			8192U		/* Per request of the queue and race groups */
+#define DMA_TEST_STEPS			(1U << 26)	/* Instructions a program may run */
+
+#define DMA_INSTR_END			0x00U
+#define DMA_INSTR_LD			0x04U
+#define DMA_INSTR_ST			0x08U
+#define DMA_INSTR_RMB			0x12U
+#define DMA_INSTR_WMB			0x13U
+#define DMA_INSTR_NOP			0x18U
+#define DMA_INSTR_LP			0x20U
+#define DMA_INSTR_SEV			0x34U
+#define DMA_INSTR_LPEND			0x38U
+#define DMA_INSTR_GO			0xA0U
+#define DMA_INSTR_MOV			0xBCU
+#define DMA_INSTR_KILL			0x01U
+
+#define DMA_FAULT_INSTR			0x00000001U	/* FTCn undef_instr */
+#define DMA_FAULT_LOAD			0x00010000U	/* FTCn data_read_err */
+
+typedef struct {
+	int active;
+	int faulted;
+	u32 start;			/* Program address */
+	u32 pc;
+	u32 sar;
+	u32 dar;
+	u32 ccr;
+	u32 lc[2];
+	u32 goSeq;
+	u32 fifo;			/* Bytes loaded, not yet stored */
+	uint8_t data[DMA_TEST_FIFO];
+	int barrier;		/* DMAWMB since the last DMAST */
+	u32 lo;				/* Destination written by the program */
+	u32 hi;
+	u32 maxBurst;
+	u32 loops;			/* Loop counters used */
+} DmaChan;
+
+typedef struct {
+	int flush;
+	UINTPTR addr;
+	u32 len;
+	u32 seq;
+} RangeRecord;
+
+typedef struct {
+	u32 addr;
+	u32 len;
+	u32 seq;
+} WriteRecord;
+
+typedef struct {
+	u32 addr;
+	u32 len;
+	u32 seq;			/* End of its last run */
+	uint8_t bytes[XDMAPS_CHAN_BUF_LEN];
+} ProgSnap;
+
+struct unitTask {
+	u32 notify[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+};
+
+/* Controller */
+static DmaChan chans[DMA_TEST_CHANNELS];
+static u32 inten;
+static u32 intStatus;
+static u32 faultStatus;		/* FSC */
+static u32 faultType[DMA_TEST_CHANNELS];
+static u32 dbgInst0;
+static u32 dbgInst1;
+static u32 progsRun;
+static u32 progBytes;		/* Longest program */
+static u32 storedBytes;		/* By the DMA since the test reset it */
+static u32 loopsUsed;		/* Loop counters of the programs run, or-ed */
+static u32 busyStarts;
+static u32 badPrograms;
+static u32 badAccesses;
+static u32 strayAccesses;
+static u32 faultAtLoad;		/* Fault the channel at this DMALD of the next program, 0 never */
+static int stalled;			/* Time does not pass for the DMA */
+static ProgSnap snaps[DMA_TEST_PROGS];
+static u32 snapCount;
+
+/* Interrupt controller */
+static XInterruptHandler handlers[128];
+static void *handlerRefs[128];
+static int enabled[128];
+static int inIrq;
+static u32 irqCalls;
+static const u8 doneIrq[DMA_TEST_CHANNELS] = {
+	XPAR_XDMAPS_0_DONE_INTR_0, XPAR_XDMAPS_0_DONE_INTR_1, XPAR_XDMAPS_0_DONE_INTR_2, XPAR_XDMAPS_0_DONE_INTR_3,
+	XPAR_XDMAPS_0_DONE_INTR_4, XPAR_XDMAPS_0_DONE_INTR_5, XPAR_XDMAPS_0_DONE_INTR_6, XPAR_XDMAPS_0_DONE_INTR_7
+};
+
+/* Cache maintenance, CPU side events and DMA writes */
+static RangeRecord ranges[DMA_TEST_RANGES];
+static u32 rangeCount;
+static u32 now;
+static u32 srcSeq;			/* Last write of the source buffer by the CPU */
+static u32 dstSeq;			/* Last write of the destination buffer by the CPU */
+static WriteRecord writes[DMA_TEST_WRITES];
+static u32 writeCount;
+static u32 raceArm;			/* Complete a channel at this hook event, 0 never */
+static u32 raceHits;
+
+/* Tasks */
+static struct unitTask taskA;
+static struct unitTask taskB;
+static struct unitTask *current = &taskA;
+static BaseType_t schedulerState = taskSCHEDULER_RUNNING;
+static TickType_t tick;
+static u32 asserts;
+
+static uint8_t srcBuf[DMA_TEST_BUF_SIZE] __attribute__((aligned(DMA_TEST_LINE)));
+static uint8_t dstBuf[DMA_TEST_BUF_SIZE] __attribute__((aligned(DMA_TEST_LINE)));
+static DmaCopyReq reqs[DMA_TEST_REQS];
+
+u32 Xil_AssertStatus;
+s32 Xil_AssertWait;
+
+void Xil_Assert(const char8 *File, s32 Line)
+{
+	printf("  assertion %s:%d\n", File, (int)Line);
+	asserts++;
+}
+
+void xil_printf(const char8 *ctrl1, ...)
+{
+	(void)ctrl1;
+}
+
+XDmaPs_Config *XDmaPs_LookupConfig(u16 DeviceId)
+{
+	static XDmaPs_Config config = { XPAR_XDMAPS_1_DEVICE_ID, DMA_TEST_BASE };
+
+	return DeviceId == XPAR_XDMAPS_1_DEVICE_ID ? &config : NULL;
+}
+
+static void dmacRace(void);
+
+BaseType_t xPortInstallInterruptHandler(uint8_t ucInterruptID, XInterruptHandler pxHandler, void *pvCallBackRef)
+{
+	handlers[ucInterruptID] = pxHandler;
+	handlerRefs[ucInterruptID] = pvCallBackRef;
+	return pdPASS;
+}
+
+void vPortEnableInterrupt(uint8_t ucInterruptID)
+{
+	UNIT_CHECK(handlers[ucInterruptID] != NULL);
+	enabled[ucInterruptID] = 1;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return current;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+	return schedulerState;
+}
+
+void vTaskNotifyGiveIndexedFromISR(TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify,
+		BaseType_t *pxHigherPriorityTaskWoken)
+{
+	UNIT_CHECK(inIrq && xTaskToNotify != NULL && uxIndexToNotify < configTASK_NOTIFICATION_ARRAY_ENTRIES);
+	xTaskToNotify->notify[uxIndexToNotify]++;
+	*pxHigherPriorityTaskWoken = pdTRUE;
+}
+
+static int dmacRunOldest(void);
+
+/* Blocking lets the DMA run until the task is notified */
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t uxIndexToWaitOn, BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+	u32 count;
+
+	while(current->notify[uxIndexToWaitOn] == 0U && xTicksToWait != 0U && !stalled && dmacRunOldest()) {
+	}
+	if(current->notify[uxIndexToWaitOn] == 0U) {
+		tick += xTicksToWait;
+	}
+	count = current->notify[uxIndexToWaitOn];
+	current->notify[uxIndexToWaitOn] = xClearCountOnExit ? 0U : (count ? count - 1U : 0U);
+	return count;
+}
+
+void vTaskSetTimeOutState(TimeOut_t *const pxTimeOut)
+{
+	pxTimeOut->xOverflowCount = 0;
+	pxTimeOut->xTimeOnEntering = tick;
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *const pxTimeOut, TickType_t *const pxTicksToWait)
+{
+	TickType_t elapsed = tick - pxTimeOut->xTimeOnEntering;
+
+	if(*pxTicksToWait == portMAX_DELAY) {
+		return pdFALSE;
+	}
+	if(elapsed >= *pxTicksToWait) {
+		*pxTicksToWait = 0;
+		return pdTRUE;
+	}
+	*pxTicksToWait -= elapsed;
+	vTaskSetTimeOutState(pxTimeOut);
+	return pdFALSE;
+}
+
+static void recordRange(int flush, INTPTR adr, u32 len)
+{
+	ranges[rangeCount++ % DMA_TEST_RANGES] = (RangeRecord){ flush, (UINTPTR)adr, len, ++now };
+	dmacRace();
+}
+
+void Xil_DCacheFlushRange(INTPTR adr, u32 len)
+{
+	recordRange(1, adr, len);
+}
+
+void Xil_DCacheInvalidateRange(INTPTR adr, u32 len)
+{
+	recordRange(0, adr, len);
+}
+
+/* A flush or invalidation covering [addr, addr + len) after event seq */
+static int covered(int flush, UINTPTR addr, u32 len, u32 seq)
+{
+	u32 n = rangeCount < DMA_TEST_RANGES ? rangeCount : DMA_TEST_RANGES;
+
+	for(u32 i = 0; i < n; i++) {
+		const RangeRecord *r = &ranges[(rangeCount - 1U - i) % DMA_TEST_RANGES];
+
+		if(r->seq <= seq) {
+			break;
+		}
+		if(r->flush == flush && r->addr <= addr && addr + len <= r->addr + r->len) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* The CPU wrote a buffer, the DMA may only read or overwrite its lines once cleaned or invalidated */
+static void cpuWroteSrc(void)
+{
+	srcSeq = ++now;
+}
+
+static void cpuWroteDst(void)
+{
+	dstSeq = ++now;
+}
+
+/* The CPU reads [addr, addr + len): lines the DMA wrote must have been invalidated since */
+static int cpuRead(const uint8_t *addr, u32 len)
+{
+	u32 a = (u32)(UINTPTR)addr;
+	u32 n = writeCount < DMA_TEST_WRITES ? writeCount : DMA_TEST_WRITES;
+
+	for(u32 i = 0; i < n; i++) {
+		const WriteRecord *w = &writes[(writeCount - 1U - i) % DMA_TEST_WRITES];
+		u32 lo = w->addr > a ? w->addr : a;
+		u32 hi = w->addr + w->len < a + len ? w->addr + w->len : a + len;
+
+		if(lo < hi && !covered(0, lo, hi - lo, w->seq)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void irqRaise(u32 id)
+{
+	UNIT_CHECK(!inIrq && enabled[id] && handlers[id] != NULL);
+	if(!inIrq && enabled[id] && handlers[id] != NULL) {
+		inIrq = 1;
+		irqCalls++;
+		handlers[id](handlerRefs[id]);
+		inIrq = 0;
+	}
+}
+
+/* The program of a channel has stopped: check it was read from memory, remember it */
+static void dmacProgEnd(DmaChan *c)
+{
+	u32 len = c->pc + 1U - c->start;
+	const uint8_t *prog = (const uint8_t *)(UINTPTR)c->start;
+	ProgSnap *snap = NULL;
+
+	for(u32 i = 0; i < snapCount; i++) {
+		if(snaps[i].addr == c->start) {
+			snap = &snaps[i];
+		}
+	}
+	for(u32 i = 0; i < len; i++) {
+		int changed = snap == NULL || i >= snap->len || snap->bytes[i] != prog[i];
+
+		if(changed && !covered(1, c->start + i, 1, snap != NULL ? snap->seq : 0U)) {
+			badPrograms++;
+			break;
+		}
+	}
+	if(snap == NULL && snapCount < DMA_TEST_PROGS) {
+		snap = &snaps[snapCount++];
+	}
+	if(snap != NULL && len <= XDMAPS_CHAN_BUF_LEN) {
+		snap->addr = c->start;
+		snap->len = len;
+		snap->seq = ++now;
+		memcpy(snap->bytes, prog, len);
+	}
+	progBytes = len > progBytes ? len : progBytes;
+	progsRun++;
+	loopsUsed |= c->loops;
+	if(c->hi != c->lo) {
+		writes[writeCount++ % DMA_TEST_WRITES] = (WriteRecord){ c->lo, c->hi - c->lo, ++now };
+		if((c->lo | c->hi) & (DMA_TEST_LINE - 1U)) {
+			badAccesses++;
+		}
+	}
+}
+
+static void dmacFault(unsigned chan, DmaChan *c, u32 type)
+{
+	c->faulted = 1;
+	faultStatus |= 1U << chan;
+	faultType[chan] = type;
+	irqRaise(XPAR_XDMAPS_0_FAULT_INTR);
+}
+
+static u32 imm32(const uint8_t *p)
+{
+	return p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+/* Run the program of chan until it stops, then raise its done interrupt */
+static void dmacRun(unsigned chan)
+{
+	DmaChan *c = &chans[chan];
+	int event = -1;
+	u32 loads = 0;
+
+	for(u32 step = 0; c->active && !c->faulted; step++) {
+		const uint8_t *op = (const uint8_t *)(UINTPTR)c->pc;
+		u32 n;
+
+		if(step == DMA_TEST_STEPS) {
+			dmacFault(chan, c, DMA_FAULT_INSTR);
+			return;
+		}
+		switch(op[0]) {
+		case DMA_INSTR_END:
+			c->active = 0;
+			dmacProgEnd(c);
+			break;
+		case DMA_INSTR_MOV:
+			if(op[1] == 0U) {
+				c->sar = imm32(&op[2]);
+			} else if(op[1] == 1U) {
+				c->ccr = imm32(&op[2]);
+			} else if(op[1] == 2U) {
+				c->dar = imm32(&op[2]);
+			} else {
+				dmacFault(chan, c, DMA_FAULT_INSTR);
+				return;
+			}
+			c->pc += 6U;
+			break;
+		case DMA_INSTR_LP:
+		case DMA_INSTR_LP | 2U:
+			c->lc[(op[0] >> 1) & 1U] = op[1];
+			c->loops |= 1U << ((op[0] >> 1) & 1U);
+			c->pc += 2U;
+			break;
+		case DMA_INSTR_LPEND:
+		case DMA_INSTR_LPEND | 4U:
+			if(c->lc[(op[0] >> 2) & 1U] != 0U) {
+				c->lc[(op[0] >> 2) & 1U]--;
+				c->pc -= op[1];
+			} else {
+				c->pc += 2U;
+			}
+			break;
+		case DMA_INSTR_LD:
+			n = (1U << ((c->ccr >> 1) & 7U)) * (((c->ccr >> 4) & 0x0FU) + 1U);
+			if(faultAtLoad != 0U && ++loads == faultAtLoad) {
+				faultAtLoad = 0;
+				dmacFault(chan, c, DMA_FAULT_LOAD);
+				return;
+			}
+			if(c->fifo + n > DMA_TEST_FIFO) {
+				dmacFault(chan, c, DMA_FAULT_INSTR);
+				return;
+			}
+			if(!covered(1, c->sar, n, srcSeq)) {
+				badAccesses++;
+			}
+			memcpy(&c->data[c->fifo], (const void *)(UINTPTR)c->sar, n);
+			c->fifo += n;
+			c->sar += (c->ccr & 1U) ? n : 0U;
+			c->maxBurst = n > c->maxBurst ? n : c->maxBurst;
+			c->pc++;
+			break;
+		case DMA_INSTR_ST:
+			n = (1U << ((c->ccr >> 15) & 7U)) * (((c->ccr >> 18) & 0x0FU) + 1U);
+			if(n > c->fifo) {
+				dmacFault(chan, c, DMA_FAULT_INSTR);
+				return;
+			}
+			if(!covered(0, c->dar, n, dstSeq) || (c->hi != c->lo && c->dar != c->hi)) {
+				badAccesses++;
+			}
+			memcpy((void *)(UINTPTR)c->dar, c->data, n);
+			memmove(c->data, &c->data[n], c->fifo - n);
+			c->fifo -= n;
+			if(c->hi == c->lo) {
+				c->lo = c->dar;
+			}
+			c->hi = c->dar + n;
+			c->dar += ((c->ccr >> 14) & 1U) ? n : 0U;
+			storedBytes += n;
+			c->barrier = 0;
+			c->pc++;
+			break;
+		case DMA_INSTR_WMB:
+			c->barrier = 1;
+			c->pc++;
+			break;
+		case DMA_INSTR_RMB:
+		case DMA_INSTR_NOP:
+			c->pc++;
+			break;
+		case DMA_INSTR_SEV:
+			event = op[1] >> 3;
+			if(event != (int)chan || !c->barrier || c->fifo != 0U) {
+				badPrograms++;
+			}
+			c->pc += 2U;
+			break;
+		default:
+			dmacFault(chan, c, DMA_FAULT_INSTR);
+			return;
+		}
+	}
+	if(event >= 0 && (inten & (1U << event))) {
+		intStatus |= 1U << event;
+		irqRaise(doneIrq[event]);
+	}
+}
+
+/* Let the channel started first finish, returns 0 if none is running */
+static int dmacRunOldest(void)
+{
+	unsigned oldest = DMA_TEST_CHANNELS;
+
+	for(unsigned chan = 0; chan < DMA_TEST_CHANNELS; chan++) {
+		if(chans[chan].active && !chans[chan].faulted &&
+				(oldest == DMA_TEST_CHANNELS || chans[chan].goSeq < chans[oldest].goSeq)) {
+			oldest = chan;
+		}
+	}
+	if(oldest == DMA_TEST_CHANNELS) {
+		return 0;
+	}
+	dmacRun(oldest);
+	return 1;
+}
+
+static void dmacRunAll(void)
+{
+	while(dmacRunOldest()) {
+	}
+}
+
+static u32 dmacActive(void)
+{
+	u32 n = 0;
+
+	for(unsigned chan = 0; chan < DMA_TEST_CHANNELS; chan++) {
+		n += chans[chan].active ? 1U : 0U;
+	}
+	return n;
+}
+
+/* A hook event of the CPU side: an interrupt may arrive here */
+static void dmacRace(void)
+{
+	if(raceArm != 0U && !inIrq && --raceArm == 0U) {
+		raceHits += dmacRunOldest() ? 1U : 0U;
+	}
+}
+
+static void dmacDebugCmd(void)
+{
+	unsigned chan = (dbgInst0 >> 8) & 7U;
+	u32 b0 = (dbgInst0 >> 16) & 0xFFU;
+	u32 b1 = (dbgInst0 >> 24) & 0xFFU;
+	DmaChan *c;
+
+	if(b0 == DMA_INSTR_GO && (dbgInst0 & 1U) == 0U) {
+		c = &chans[b1 & 7U];
+		if(c->active) {
+			busyStarts++;
+			return;
+		}
+		memset(c, 0, sizeof(*c));
+		c->active = 1;
+		c->start = dbgInst1;
+		c->pc = dbgInst1;
+		c->goSeq = ++now;
+		dmacRace();
+	} else if(b0 == DMA_INSTR_KILL && (dbgInst0 & 1U) != 0U) {
+		chans[chan].active = 0;
+		chans[chan].faulted = 0;
+		faultStatus &= ~(1U << chan);
+	} else {
+		strayAccesses++;
+	}
+}
+
+u32 unitIoRead(UINTPTR Addr)
+{
+	u32 off = (u32)(Addr - DMA_TEST_BASE);
+
+	if(Addr < DMA_TEST_BASE || off >= 0x1000U) {
+		strayAccesses++;
+		return 0;
+	}
+	if(off >= XDMAPS_CS0_OFFSET && off < XDMAPS_CS0_OFFSET + 8U * DMA_TEST_CHANNELS) {
+		unsigned chan = (off - XDMAPS_CS0_OFFSET) / 8U;
+
+		return (off & 4U) ? chans[chan].pc : (chans[chan].faulted ? 0x0FU : chans[chan].active ? 0x01U : 0U);
+	}
+	if(off >= XDMAPS_FTC0_OFFSET && off < XDMAPS_FTC0_OFFSET + 4U * DMA_TEST_CHANNELS) {
+		return faultType[(off - XDMAPS_FTC0_OFFSET) / 4U];
+	}
+	switch(off) {
+	case XDMAPS_DS_OFFSET:
+		return XDMAPS_DS_DMA_STATUS_STOPPED;
+	case XDMAPS_INTEN_OFFSET:
+		return inten;
+	case XDMAPS_INTSTATUS_OFFSET:
+		return intStatus;
+	case XDMAPS_FSM_OFFSET:
+		return 0;
+	case XDMAPS_FSC_OFFSET:
+		return faultStatus;
+	case XDMAPS_DBGSTATUS_OFFSET:
+		return 0;
+	case XDMAPS_CR1_OFFSET:
+		return DMA_TEST_CR1;
+	default:
+		strayAccesses++;
+		return 0;
+	}
+}
+
+void unitIoWrite(UINTPTR Addr, u32 Value)
+{
+	u32 off = (u32)(Addr - DMA_TEST_BASE);
+
+	if(Addr < DMA_TEST_BASE || off >= 0x1000U) {
+		strayAccesses++;
+		return;
+	}
+	switch(off) {
+	case XDMAPS_INTEN_OFFSET:
+		inten = Value;
+		break;
+	case XDMAPS_INTCLR_OFFSET:
+		intStatus &= ~Value;
+		break;
+	case XDMAPS_DBGINST0_OFFSET:
+		dbgInst0 = Value;
+		break;
+	case XDMAPS_DBGINST1_OFFSET:
+		dbgInst1 = Value;
+		break;
+	case XDMAPS_DBGCMD_OFFSET:
+		dmacDebugCmd();
+		break;
+	default:
+		strayAccesses++;
+		break;
+	}
+	dmacRace();
+}
+
+static uint8_t srcByte(u32 i)
+{
+	return (uint8_t)((i * 7U) ^ (i >> 8) ^ (i >> 16) ^ 0x5AU);
+}
+
+/* Fill the source with its pattern and the destination with a marker */
+static void buffersFill(u32 len)
+{
+	for(u32 i = 0; i < len; i++) {
+		srcBuf[i] = srcByte(i);
+	}
+	cpuWroteSrc();
+	memset(dstBuf, 0xA5, len);
+	cpuWroteDst();
+}
+
+/* dst holds src[0, len) and the bytes around it are untouched */
+static int copyExact(const uint8_t *dst, const uint8_t *src, u32 len)
+{
+	if(!cpuRead(dst - DMA_TEST_GUARD, len + 2U * DMA_TEST_GUARD) || memcmp(dst, src, len) != 0) {
+		return 0;
+	}
+	for(u32 i = 1; i <= DMA_TEST_GUARD; i++) {
+		if(dst[-(int)i] != 0xA5U || dst[len + i - 1U] != 0xA5U) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void checkThroughout(void)
+{
+	UNIT_CHECK(badAccesses == 0 && badPrograms == 0 && busyStarts == 0);
+	UNIT_CHECK(asserts == 0 && strayAccesses == 0);
+	UNIT_CHECK(taskA.notify[0] == 0 && taskB.notify[0] == 0);
+}
+
+static void testInit(void)
+{
+	DmaCopyStats_t stats;
+
+	UNIT_CHECK(dmacopyInit() == XST_SUCCESS);
+	UNIT_CHECK(enabled[XPAR_XDMAPS_0_FAULT_INTR]);
+	for(unsigned chan = 0; chan < DMA_TEST_CHANNELS; chan++) {
+		UNIT_CHECK(enabled[doneIrq[chan]]);
+	}
+	UNIT_CHECK(dmacActive() == 0);
+	dmacopyGetStats(&stats);
+	UNIT_CHECK(stats.ulDmaCopies == 0 && stats.ulCpuCopies == 0);
+	checkThroughout();
+	unitResult("init", "8 channels, %u byte instruction cache lines", 1U << (DMA_TEST_CR1 & 7U));
+}
+
+static void testProg(void)
+{
+	static const u32 lengths[] = {
+		DMACOPY_THRESHOLD, DMACOPY_THRESHOLD + 1U, 5000U,
+		255U * DMA_TEST_BURST, 256U * DMA_TEST_BURST - 8U, 256U * DMA_TEST_BURST, 256U * DMA_TEST_BURST + 104U,
+		512U * DMA_TEST_BURST - 32U, 512U * DMA_TEST_BURST, 513U * DMA_TEST_BURST + 40U, 1000000U,
+		DMA_TEST_CHUNK - DMA_TEST_LINE, DMA_TEST_CHUNK, DMA_TEST_CHUNK + 8U * DMA_TEST_LINE + 17U,
+		2U * DMA_TEST_CHUNK + 4160U
+	};
+	static const u32 offsets[][2] = { { 0, 0 }, { 8, 8 }, { 3, 11 }, { 31, 7 }, { 17, 33 } };	/* dst, src */
+	DmaCopyStats_t before, after;
+	u32 dmaBytes = 0;
+	u32 copies = 0;
+	u32 progs = progsRun;
+
+	dmacopyGetStats(&before);
+	storedBytes = 0;
+	loopsUsed = 0;
+	for(u32 l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+		for(u32 o = 0; o < sizeof(offsets) / sizeof(offsets[0]); o++) {
+			u32 len = lengths[l];
+			uint8_t *dst = dstBuf + DMA_TEST_GUARD + offsets[o][0];
+			const uint8_t *src = srcBuf + DMA_TEST_GUARD + offsets[o][1];
+			u32 head = (0U - (u32)(UINTPTR)dst) & (DMA_TEST_LINE - 1U);
+
+			if(len + DMA_TEST_GUARD * 3U > DMA_TEST_BUF_SIZE) {
+				continue;
+			}
+			buffersFill(len + DMA_TEST_GUARD * 3U);
+			UNIT_CHECK(dmacopyMemcpy(dst, src, len) == dst);
+			UNIT_CHECK(copyExact(dst, src, len));
+			UNIT_CHECK(dmacActive() == 0);
+			dmaBytes += (len - head) & ~(DMA_TEST_LINE - 1U);
+			copies++;
+		}
+	}
+	dmacopyGetStats(&after);
+	UNIT_CHECK(after.ulDmaCopies - before.ulDmaCopies == copies && after.ulCpuCopies == before.ulCpuCopies);
+	UNIT_CHECK(after.ulDmaBytes - before.ulDmaBytes == dmaBytes && storedBytes == dmaBytes);
+	UNIT_CHECK(after.ulFaults == before.ulFaults);
+	UNIT_CHECK(progBytes <= XDMAPS_CHAN_BUF_LEN && chans[0].maxBurst == DMA_TEST_BURST);
+	UNIT_CHECK(loopsUsed == 3U);
+	checkThroughout();
+	unitResult("prog", "%u copies, %u MB in %u programs, longest %u bytes", (unsigned)copies,
+			(unsigned)(dmaBytes >> 20), (unsigned)(progsRun - progs), (unsigned)progBytes);
+}
+
+static void testCache(void)
+{
+	DmaCopyStats_t before, after;
+	u32 len = 3U * DMA_TEST_SLOT;
+
+	dmacopyGetStats(&before);
+	buffersFill(DMA_TEST_BUF_SIZE);
+
+	/* The same length to other addresses reuses the program */
+	UNIT_CHECK(dmacopyMemcpy(dstBuf + 64, srcBuf + 64, len) == dstBuf + 64);
+	UNIT_CHECK(copyExact(dstBuf + 64, srcBuf + 64, len));
+	memset(dstBuf, 0xA5, DMA_TEST_BUF_SIZE);
+	cpuWroteDst();
+	UNIT_CHECK(dmacopyMemcpy(dstBuf + 4U * len, srcBuf + 7U * len, len) == dstBuf + 4U * len);
+	UNIT_CHECK(copyExact(dstBuf + 4U * len, srcBuf + 7U * len, len));
+	UNIT_CHECK(dstBuf[64] == 0xA5U && dstBuf[64 + len - 1U] == 0xA5U);
+	dmacopyGetStats(&after);
+	UNIT_CHECK(after.ulProgBuilds - before.ulProgBuilds == 1U && after.ulProgHits - before.ulProgHits == 1U);
+
+	/* DMACOPY_PROG_CACHE other lengths push it out */
+	for(u32 i = 1; i <= DMACOPY_PROG_CACHE; i++) {
+		dmacopyMemcpy(dstBuf + 64, srcBuf + 64, len + i * DMA_TEST_LINE);
+	}
+	dmacopyGetStats(&before);
+	memset(dstBuf, 0xA5, DMA_TEST_BUF_SIZE);
+	cpuWroteDst();
+	UNIT_CHECK(dmacopyMemcpy(dstBuf + 128, srcBuf + 256, len) == dstBuf + 128);
+	UNIT_CHECK(copyExact(dstBuf + 128, srcBuf + 256, len));
+	dmacopyGetStats(&after);
+	UNIT_CHECK(after.ulProgBuilds - before.ulProgBuilds == 1U && after.ulProgHits == before.ulProgHits);
+	checkThroughout();
+	unitResult("cache", "%u programs built, %u reused", (unsigned)after.ulProgBuilds, (unsigned)after.ulProgHits);
+}
+
+static void testCpu(void)
+{
+	DmaCopyStats_t before, after;
+	DmaCopyReq req;
+	u32 progs = progsRun;
+
+	dmacopyGetStats(&before);
+	buffersFill(4U * DMA_TEST_SLOT);
+	UNIT_CHECK(dmacopySubmit(&req, dstBuf + 64, srcBuf + 64, DMACOPY_THRESHOLD - 1U) == pdFALSE);
+	UNIT_CHECK(req.status == DMACOPY_DONE && copyExact(dstBuf + 64, srcBuf + 64, DMACOPY_THRESHOLD - 1U));
+	UNIT_CHECK(dmacopySubmit(&req, dstBuf + DMA_TEST_SLOT, srcBuf + 4, DMA_TEST_SLOT) == pdFALSE);
+	UNIT_CHECK(req.status == DMACOPY_DONE && copyExact(dstBuf + DMA_TEST_SLOT, srcBuf + 4, DMA_TEST_SLOT));
+	schedulerState = taskSCHEDULER_NOT_STARTED;
+	UNIT_CHECK(dmacopySubmit(&req, dstBuf + 2U * DMA_TEST_SLOT + 64U, srcBuf, DMA_TEST_SLOT) == pdFALSE);
+	schedulerState = taskSCHEDULER_RUNNING;
+	UNIT_CHECK(req.status == DMACOPY_DONE && copyExact(dstBuf + 2U * DMA_TEST_SLOT + 64U, srcBuf, DMA_TEST_SLOT));
+	dmacopyGetStats(&after);
+	UNIT_CHECK(after.ulCpuCopies - before.ulCpuCopies == 3U && after.ulDmaCopies == before.ulDmaCopies);
+	UNIT_CHECK(progsRun == progs && dmacActive() == 0);
+	checkThroughout();
+	unitResult("cpu", "%u copies on the CPU", (unsigned)(after.ulCpuCopies - before.ulCpuCopies));
+}
+
+/* Request i copies DMA_TEST_SLOT - 64 bytes between the slots i of both buffers */
+static BaseType_t slotSubmit(u32 i)
+{
+	return dmacopySubmit(&reqs[i], dstBuf + DMA_TEST_GUARD + i * DMA_TEST_SLOT,
+			srcBuf + DMA_TEST_GUARD + i * DMA_TEST_SLOT, DMA_TEST_SLOT - 2U * DMA_TEST_GUARD);
+}
+
+static int slotExact(u32 i)
+{
+	return copyExact(dstBuf + DMA_TEST_GUARD + i * DMA_TEST_SLOT, srcBuf + DMA_TEST_GUARD + i * DMA_TEST_SLOT,
+			DMA_TEST_SLOT - 2U * DMA_TEST_GUARD);
+}
+
+/* Run the DMA, then wait for requests [0, n) of the current task */
+static u32 slotsCollect(u32 n)
+{
+	u32 exact = 0;
+
+	dmacRunAll();
+	for(u32 i = 0; i < n; i++) {
+		exact += (dmacopyWait(&reqs[i], 0) == DMACOPY_DONE && slotExact(i)) ? 1U : 0U;
+	}
+	return exact;
+}
+
+static void testQueue(void)
+{
+	DmaCopyStats_t before, after;
+	u32 queued = 0;
+	u32 n = DMA_TEST_CHANNELS + DMACOPY_RING_SIZE + 1U;
+	u32 calls = irqCalls;
+
+	dmacopyGetStats(&before);
+	buffersFill(n * DMA_TEST_SLOT);
+	taskA.notify[DMACOPY_NOTIFY_INDEX] = 0;
+	taskB.notify[DMACOPY_NOTIFY_INDEX] = 0;
+	for(u32 i = 0; i < n; i++) {
+		current = (i & 1U) ? &taskB : &taskA;
+		queued += slotSubmit(i) ? 1U : 0U;
+		UNIT_CHECK(dmacActive() == (i < DMA_TEST_CHANNELS ? i + 1U : DMA_TEST_CHANNELS));
+	}
+	current = &taskA;
+	UNIT_CHECK(queued == n - 1U && reqs[n - 1U].status == DMACOPY_DONE);
+	dmacRunAll();
+	UNIT_CHECK(taskA.notify[DMACOPY_NOTIFY_INDEX] == (n - 1U + 1U) / 2U);
+	UNIT_CHECK(taskB.notify[DMACOPY_NOTIFY_INDEX] == (n - 1U) / 2U);
+	UNIT_CHECK(irqCalls - calls == n - 1U);
+	taskA.notify[DMACOPY_NOTIFY_INDEX] = 0;
+	taskB.notify[DMACOPY_NOTIFY_INDEX] = 0;
+	UNIT_CHECK(slotsCollect(n) == n);
+	dmacopyGetStats(&after);
+	UNIT_CHECK(after.ulRingFull - before.ulRingFull == 1U && after.ulDmaCopies - before.ulDmaCopies == n - 1U);
+
+	/* All channels are free again */
+	buffersFill(DMA_TEST_CHANNELS * DMA_TEST_SLOT);
+	for(u32 i = 0; i < DMA_TEST_CHANNELS; i++) {
+		UNIT_CHECK(slotSubmit(i));
+	}
+	UNIT_CHECK(dmacActive() == DMA_TEST_CHANNELS);
+	UNIT_CHECK(slotsCollect(DMA_TEST_CHANNELS) == DMA_TEST_CHANNELS);
+	taskA.notify[DMACOPY_NOTIFY_INDEX] = 0;
+	checkThroughout();
+	unitResult("queue", "%u copies, %u queued, %u done interrupts", (unsigned)n, (unsigned)(queued - DMA_TEST_CHANNELS),
+			(unsigned)(irqCalls - calls));
+}
+
+static void testRace(void)
+{
+	u32 busy = DMA_TEST_CHANNELS - 1U;
+	u32 submits = 3;
+	u32 n = busy + submits;
+	u32 runs = 0;
+	u32 exact = 0;
+
+	raceHits = 0;
+	for(u32 at = 1; ; at++) {
+		buffersFill(n * DMA_TEST_SLOT);
+		for(u32 i = 0; i < busy; i++) {
+			slotSubmit(i);
+		}
+		raceArm = at;
+		for(u32 i = busy; i < n; i++) {
+			UNIT_CHECK(slotSubmit(i));
+		}
+		if(raceArm != 0U) {
+			raceArm = 0;
+			dmacRunAll();
+			taskA.notify[DMACOPY_NOTIFY_INDEX] = 0;
+			break;
+		}
+		runs++;
+		exact += slotsCollect(n) == n ? 1U : 0U;
+		UNIT_CHECK(taskA.notify[DMACOPY_NOTIFY_INDEX] == n);
+		taskA.notify[DMACOPY_NOTIFY_INDEX] = 0;
+
+		/* No channel was lost or given twice */
+		buffersFill(DMA_TEST_CHANNELS * DMA_TEST_SLOT);
+		for(u32 i = 0; i < DMA_TEST_CHANNELS; i++) {
+			slotSubmit(i);
+		}
+		UNIT_CHECK(dmacActive() == DMA_TEST_CHANNELS);
+		UNIT_CHECK(slotsCollect(DMA_TEST_CHANNELS) == DMA_TEST_CHANNELS);
+		taskA.notify[DMACOPY_NOTIFY_INDEX] = 0;
+	}
+	UNIT_CHECK(runs > 0 && exact == runs && raceHits == runs);
+	checkThroughout();
+	unitResult("race", "a done interrupt at each of %u points of 3 submits", (unsigned)runs);
+}
+
+static void testFault(void)
+{
+	DmaCopyStats_t before, after;
+	u32 len = 4U * DMA_TEST_SLOT;
+	u32 calls = irqCalls;
+
+	dmacopyGetStats(&before);
+	buffersFill(8U * DMA_TEST_SLOT);
+
+	/* A copy faults half way, the others complete */
+	faultAtLoad = 10;
+	UNIT_CHECK(slotSubmit(0));
+	UNIT_CHECK(slotSubmit(1));
+	UNIT_CHECK(dmacopySubmit(&reqs[2], dstBuf + 4U * DMA_TEST_SLOT, srcBuf + 4U * DMA_TEST_SLOT, len));
+	dmacRunAll();
+	UNIT_CHECK(dmacopyWait(&reqs[0], 0) == DMACOPY_FAULT);
+	UNIT_CHECK(dmacopyWait(&reqs[1], 0) == DMACOPY_DONE && slotExact(1));
+	UNIT_CHECK(dmacopyWait(&reqs[2], 0) == DMACOPY_DONE);
+	UNIT_CHECK(faultStatus == 0 && dmacActive() == 0);
+
+	/* dmacopyMemcpy() falls back to the CPU */
+	buffersFill(8U * DMA_TEST_SLOT);
+	faultAtLoad = 7;
+	UNIT_CHECK(dmacopyMemcpy(dstBuf + DMA_TEST_GUARD, srcBuf + DMA_TEST_GUARD, len) == dstBuf + DMA_TEST_GUARD);
+	UNIT_CHECK(copyExact(dstBuf + DMA_TEST_GUARD, srcBuf + DMA_TEST_GUARD, len));
+	dmacopyGetStats(&after);
+	UNIT_CHECK(after.ulFaults - before.ulFaults == 2U);
+	UNIT_CHECK(irqCalls - calls == 4U);
+	taskA.notify[DMACOPY_NOTIFY_INDEX] = 0;
+	checkThroughout();
+	unitResult("fault", "%u faults, %u interrupts", (unsigned)(after.ulFaults - before.ulFaults),
+			(unsigned)(irqCalls - calls));
+}
+
+static void testWait(void)
+{
+	TickType_t start = tick;
+
+	buffersFill(DMA_TEST_SLOT);
+	UNIT_CHECK(slotSubmit(0));
+	stalled = 1;
+	UNIT_CHECK(dmacopyWait(&reqs[0], 0) == DMACOPY_PENDING);
+	UNIT_CHECK(dmacopyWait(&reqs[0], 10) == DMACOPY_PENDING && tick - start >= 10U);
+	stalled = 0;
+	UNIT_CHECK(dmacopyWait(&reqs[0], 10) == DMACOPY_DONE && slotExact(0));
+	UNIT_CHECK(taskA.notify[DMACOPY_NOTIFY_INDEX] == 0 && dmacActive() == 0);
+	checkThroughout();
+	unitResult("wait", "timed out after %u ticks, then done", (unsigned)(tick - start));
+}
+
+int main(void)
+{
+	testInit();
+	testProg();
+	testCache();
+	testCpu();
+	testQueue();
+	testRace();
+	testFault();
+	testWait();
+	printf("  %u programs run, %u interrupts\n", (unsigned)progsRun, (unsigned)irqCalls);
+	return unitExit();
+}
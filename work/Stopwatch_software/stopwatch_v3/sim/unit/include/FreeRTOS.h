@@ -0,0 +1,45 @@
+/*
+ * Host stand-in for the kernel header of the same name, see ../unit.h. Only
+ * the types and macros the driver level modules use; critical sections are
+ * empty, a test runs its model in the same thread.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "xil_types.h"
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE			((BaseType_t)0)
+#define pdTRUE			((BaseType_t)1)
+#define pdPASS			pdTRUE
+#define pdFAIL			pdFALSE
+#define portMAX_DELAY	((TickType_t)0xFFFFFFFFUL)
+
+#define configTICK_RATE_HZ	1000U
+#ifndef configMAX_TASK_NAME_LEN
+#define configMAX_TASK_NAME_LEN	10	/* As the Zynq build */
+#endif
+#ifndef configTASK_NOTIFICATION_ARRAY_ENTRIES
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES	2	/* As the Zynq build */
+#endif
+#define pdMS_TO_TICKS(xTimeInMs)	((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define taskENTER_CRITICAL_FROM_ISR()	0
+#define taskEXIT_CRITICAL_FROM_ISR(x)	((void)(x))
+#define portYIELD_FROM_ISR(x)	((void)(x))
+#define portDISABLE_INTERRUPTS()
+
+BaseType_t xPortInstallInterruptHandler(uint8_t ucInterruptID, XInterruptHandler pxHandler, void *pvCallBackRef);
+void vPortEnableInterrupt(uint8_t ucInterruptID);
+void vPortDisableInterrupt(uint8_t ucInterruptID);
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,60 @@
+/*
+ * Host stand-in for the kernel header of the same name, see ../unit.h. The
+ * functions are implemented by the test.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct unitTask *TaskHandle_t;
+
+typedef enum {
+	eRunning = 0,
+	eReady,
+	eBlocked,
+	eSuspended,
+	eDeleted,
+	eInvalid
+} eTaskState;
+
+typedef struct xTIME_OUT {
+	BaseType_t xOverflowCount;
+	TickType_t xTimeOnEntering;
+} TimeOut_t;
+
+typedef struct xTASK_STATUS {
+	TaskHandle_t xHandle;
+	const char *pcTaskName;
+	UBaseType_t xTaskNumber;
+	eTaskState eCurrentState;
+	UBaseType_t uxCurrentPriority;
+	UBaseType_t uxBasePriority;
+	uint32_t ulRunTimeCounter;
+	StackType_t *pxStackBase;
+	uint16_t usStackHighWaterMark;
+} TaskStatus_t;
+
+#define taskSCHEDULER_SUSPENDED		((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED	((BaseType_t)1)
+#define taskSCHEDULER_RUNNING		((BaseType_t)2)
+
+#define taskYIELD()
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskGetSchedulerState(void);
+void vTaskDelay(const TickType_t xTicksToDelay);
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken);
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t uxIndexToWaitOn, BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+void vTaskNotifyGiveIndexedFromISR(TaskHandle_t xTaskToNotify, UBaseType_t uxIndexToNotify,
+		BaseType_t *pxHigherPriorityTaskWoken);
+void vTaskSetTimeOutState(TimeOut_t *const pxTimeOut);
+BaseType_t xTaskCheckForTimeOut(TimeOut_t *const pxTimeOut, TickType_t *const pxTicksToWait);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *const pxTaskStatusArray, const UBaseType_t uxArraySize,
+		uint32_t *const pulTotalRunTime);
+
+#endif /* INC_TASK_H */
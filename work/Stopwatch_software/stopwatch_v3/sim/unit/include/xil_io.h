@@ -0,0 +1,43 @@
+/*
+ * Host stand-in for the standalone BSP header of the same name, see ../unit.h.
+ * Addresses are host pointers, or with UNIT_IO_HOOK accesses call functions of
+ * the test that model the registers.
+ */
+
+#ifndef XIL_IO_H
+#define XIL_IO_H
+
+#include "xil_types.h"
+
+#define INLINE inline	/* Used by the drivers, defined here by the BSP header */
+
+#ifdef UNIT_IO_HOOK
+
+u32 unitIoRead(UINTPTR Addr);
+void unitIoWrite(UINTPTR Addr, u32 Value);
+
+static inline u32 Xil_In32(UINTPTR Addr)
+{
+	return unitIoRead(Addr);
+}
+
+static inline void Xil_Out32(UINTPTR Addr, u32 Value)
+{
+	unitIoWrite(Addr, Value);
+}
+
+#else
+
+static inline u32 Xil_In32(UINTPTR Addr)
+{
+	return *(volatile u32 *)Addr;
+}
+
+static inline void Xil_Out32(UINTPTR Addr, u32 Value)
+{
+	*(volatile u32 *)Addr = Value;
+}
+
+#endif /* UNIT_IO_HOOK */
+
+#endif /* XIL_IO_H */
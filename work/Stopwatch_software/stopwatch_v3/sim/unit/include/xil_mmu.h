@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for the standalone BSP header of the same name, see ../unit.h.
+ * Attribute changes are recorded by the test.
+ */
+
+#ifndef XIL_MMU_H
+#define XIL_MMU_H
+
+#include "xil_types.h"
+
+#define NORM_NONCACHE	0x11DE2U
+#define STRONG_ORDERED	0xC02U
+#define DEVICE_MEMORY	0xC06U
+#define NORM_WB_CACHE	0x15DE6U
+
+void Xil_SetTlbAttributes(UINTPTR Addr, u32 attrib);
+s32 Xil_MmuSetRegionAttributes(INTPTR Addr, u32 Size, u32 attrib);
+
+#endif /* XIL_MMU_H */
@@ -0,0 +1,39 @@
+/*
+ * Host stand-in for the standalone BSP header of the same name, see ../unit.h.
+ * The barriers are full fences of the host. CPSR and CP15 accesses call
+ * functions of the test, the CP15 register is named by its XREG_CP15_xxx
+ * string of xreg_cortexa9.h.
+ */
+
+#ifndef XPSEUDO_ASM_H
+#define XPSEUDO_ASM_H
+
+#include "xil_types.h"
+
+#define dmb()	__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define dsb()	__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define isb()	__atomic_signal_fence(__ATOMIC_SEQ_CST)
+
+u32 unitCpsrRead(void);
+void unitCpsrWrite(u32 Value);
+u32 unitCp15Read(const char *Reg);
+void unitCp15Write(const char *Reg, u32 Value);
+
+#define mfcpsr()	unitCpsrRead()
+#define mtcpsr(v)	unitCpsrWrite(v)
+#define mfcp(rn)	unitCp15Read(rn)
+#define mtcp(rn, v)	unitCp15Write((rn), (v))
+
+/* In place of the inline assembly of xil_cache.h, included before */
+#undef asm_cp15_inval_dc_line_mva_poc
+#undef asm_cp15_clean_inval_dc_line_mva_poc
+#undef asm_cp15_inval_ic_line_mva_pou
+#undef asm_cp15_inval_dc_line_sw
+#undef asm_cp15_clean_inval_dc_line_sw
+#define asm_cp15_inval_dc_line_mva_poc(param)	mtcp(XREG_CP15_INVAL_DC_LINE_MVA_POC, (param))
+#define asm_cp15_clean_inval_dc_line_mva_poc(param)	mtcp(XREG_CP15_CLEAN_INVAL_DC_LINE_MVA_POC, (param))
+#define asm_cp15_inval_ic_line_mva_pou(param)	mtcp(XREG_CP15_INVAL_IC_LINE_MVA_POU, (param))
+#define asm_cp15_inval_dc_line_sw(param)	mtcp(XREG_CP15_INVAL_DC_LINE_SW, (param))
+#define asm_cp15_clean_inval_dc_line_sw(param)	mtcp(XREG_CP15_CLEAN_INVAL_DC_LINE_SW, (param))
+
+#endif /* XPSEUDO_ASM_H */
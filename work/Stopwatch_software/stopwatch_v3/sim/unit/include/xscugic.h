@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for the GIC driver header, see ../unit.h. Software interrupts
+ * are delivered by the test.
+ */
+
+#ifndef XSCUGIC_H
+#define XSCUGIC_H
+
+#include "xil_types.h"
+
+#define XSCUGIC_SPI_CPU0_MASK	0x01U
+#define XSCUGIC_SPI_CPU1_MASK	0x02U
+
+typedef struct {
+	u32 IsReady;
+} XScuGic;
+
+s32 XScuGic_SoftwareIntr(XScuGic *InstancePtr, u32 Int_Id, u32 Cpu_Identifier);
+
+#endif /* XSCUGIC_H */
@@ -0,0 +1,365 @@
+/*
+ * Host test of the MMU region manager of the standalone BSP (xil_mmu.c,
+ * copied to the build directory so that the stand-in headers apply, with the
+ * real xil_mmu.h).
+ *
+ * The first level table MMUTable is an array of the test filled as boot.S
+ * does, with 1 MB NORM_WB_CACHE sections of domain 15. The second level
+ * tables of xil_mmu.c are linked below 4 GB (no PIE) so their addresses fit
+ * the coarse descriptors. The CP15 TLB and branch predictor operations and
+ * the data cache maintenance are recorded, the CPSR is a variable. Checks:
+ *
+ *  convert     the small page descriptor of each memory type of xil_mmu.h,
+ *              RESERVED a fault entry (0) as a RESERVED section is, and the
+ *              other pages of the split section unchanged
+ *  split       a region over three sections splits the partial ones, writes
+ *              the whole one as a section, keeps the domain, invalidates the
+ *              changed pages by MVA and flushes the region once
+ *  batch       nested Xil_MmuBeginUpdate/Xil_MmuEndUpdate defer everything to
+ *              the outer end, more than XIL_MMU_TLB_OPS_MAX pages invalidate
+ *              the whole TLB and more than XIL_MMU_FLUSH_RANGES_MAX regions
+ *              flush the whole data cache
+ *  pool        XIL_MMU_NUM_PAGE_TABLES sections can be split, the next one
+ *              fails and keeps its section, the part of a region processed
+ *              before the failure keeps its attributes, and a table released
+ *              by Xil_SetTlbAttributes() is reused only after the TLB
+ *              invalidation of its batch
+ *  irq         descriptors are written and flushed with the interrupts masked,
+ *              the CPSR is restored, misaligned regions are refused untouched
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "unit.h"
+#include "xil_cache.h"
+#include "xil_mmu.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#include "xstatus.h"
+
+#define MMU_TEST_SECTIONS	4096U
+#define MMU_TEST_SECT		0x100000U
+#define MMU_TEST_PAGE		0x1000U
+#define MMU_TEST_DOMAIN		0x1E0U	/* Domain 15, as boot.S */
+#define MMU_TEST_TYPE		0x3U
+#define MMU_TEST_COARSE		0x1U
+#define MMU_TEST_WB_PAGE	0x576U	/* NORM_WB_CACHE as a small page */
+#define MMU_TEST_IRQ_MASK	0xC0U
+#define MMU_TEST_CPSR		0x1FU	/* System mode, interrupts enabled */
+#define MMU_TEST_OPS		1024U
+#define MMU_TEST_TLB_OPS_MAX	32U	/* XIL_MMU_TLB_OPS_MAX of xil_mmu.c */
+#define MMU_TEST_FLUSH_MAX	8U	/* XIL_MMU_FLUSH_RANGES_MAX */
+
+/* Declared u32 by xil_mmu.c, which indexes from its address */
+u32 MMUTable[MMU_TEST_SECTIONS] __attribute__ ((aligned(16384)));
+
+static u32 cpsr = MMU_TEST_CPSR;
+static u32 tlbMva[MMU_TEST_OPS];
+static u32 tlbMvaCount;
+static u32 tlbAll;
+static u32 branchInvalidations;
+static Xil_CacheRange flushed[MMU_TEST_OPS];
+static u32 flushedCount;
+static u32 flushRangesCalls;
+static u32 flushAll;
+static u32 descFlushes;		/* Xil_DCacheFlushRange() of descriptors */
+static u32 unmaskedDescFlushes;
+
+u32 unitCpsrRead(void)
+{
+	return cpsr;
+}
+
+void unitCpsrWrite(u32 Value)
+{
+	cpsr = Value;
+}
+
+u32 unitCp15Read(const char *Reg)
+{
+	(void)Reg;
+	return 0U;
+}
+
+void unitCp15Write(const char *Reg, u32 Value)
+{
+	if(strcmp(Reg, XREG_CP15_INVAL_UTLB_MVA) == 0) {
+		if(tlbMvaCount < MMU_TEST_OPS) {
+			tlbMva[tlbMvaCount] = Value;
+		}
+		tlbMvaCount++;
+	} else if(strcmp(Reg, XREG_CP15_INVAL_UTLB_UNLOCKED) == 0) {
+		tlbAll++;
+	} else if(strcmp(Reg, XREG_CP15_INVAL_BRANCH_ARRAY) == 0) {
+		branchInvalidations++;
+	}
+}
+
+/* xil_mmu.c flushes the descriptors it writes one by one, and the regions
+it remapped as a list or whole at the end of a batch */
+void Xil_DCacheFlushRange(INTPTR adr, u32 len)
+{
+	(void)adr;
+	(void)len;
+	descFlushes++;
+	if(!(cpsr & MMU_TEST_IRQ_MASK)) {
+		unmaskedDescFlushes++;
+	}
+}
+
+void Xil_DCacheFlushRanges(const Xil_CacheRange *Ranges, u32 Count)
+{
+	flushRangesCalls++;
+	for(u32 i = 0; i < Count && flushedCount < MMU_TEST_OPS; i++) {
+		flushed[flushedCount++] = Ranges[i];
+	}
+}
+
+void Xil_DCacheFlush(void)
+{
+	flushAll++;
+}
+
+void Xil_DCacheInvalidate(void)
+{
+}
+
+void Xil_ICacheInvalidate(void)
+{
+}
+
+static void reset(void)
+{
+	tlbMvaCount = 0;
+	tlbAll = 0;
+	branchInvalidations = 0;
+	flushedCount = 0;
+	flushRangesCalls = 0;
+	flushAll = 0;
+	descFlushes = 0;
+	unmaskedDescFlushes = 0;
+}
+
+static u32 sectionOf(u32 addr)
+{
+	return MMUTable[addr / MMU_TEST_SECT];
+}
+
+static int isSplit(u32 addr)
+{
+	return (sectionOf(addr) & MMU_TEST_TYPE) == MMU_TEST_COARSE;
+}
+
+/* Small page descriptor of addr, its section must be split */
+static u32 pageOf(u32 addr)
+{
+	const u32 *table = (const u32 *)(uintptr_t)(sectionOf(addr) & 0xFFFFFC00U);
+
+	return table[(addr / MMU_TEST_PAGE) % 256U];
+}
+
+static int tlbInvalidated(u32 addr)
+{
+	for(u32 i = 0; i < tlbMvaCount && i < MMU_TEST_OPS; i++) {
+		if(tlbMva[i] == addr) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Back to a NORM_WB_CACHE section, a page table it had is free again */
+static void restore(u32 addr)
+{
+	Xil_SetTlbAttributes((INTPTR)addr, NORM_WB_CACHE);
+	UNIT_CHECK(sectionOf(addr) == ((addr & ~(MMU_TEST_SECT - 1U)) | NORM_WB_CACHE));
+}
+
+static void testConvert(void)
+{
+	static const struct {
+		u32 attrib;
+		u32 page;
+	} types[] = {
+		{ NORM_WB_CACHE, MMU_TEST_WB_PAGE },	/* TEX 101, B, AP 11, S */
+		{ NORM_WT_CACHE, 0x5BAU },		/* TEX 110, C, AP 11, S */
+		{ NORM_NONCACHE, 0x472U },		/* TEX 001, AP 11, S */
+		{ STRONG_ORDERED, 0x032U },		/* AP 11 */
+		{ DEVICE_MEMORY, 0x036U },		/* B, AP 11 */
+		{ STRONG_ORDERED | EXECUTE_NEVER, 0x033U },
+		{ NORM_WB_CACHE & NON_SHAREABLE, MMU_TEST_WB_PAGE & ~0x400U },
+		{ RESERVED, 0U },				/* Fault */
+	};
+	const u32 n = sizeof(types) / sizeof(types[0]);
+	const u32 base = 0x00100000U;
+
+	reset();
+	for(u32 i = 0; i < n; i++) {
+		UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)(base + i * MMU_TEST_PAGE), MMU_TEST_PAGE,
+				types[i].attrib) == XST_SUCCESS);
+	}
+	UNIT_CHECK(isSplit(base));
+	for(u32 i = 0; i < n; i++) {
+		u32 addr = base + i * MMU_TEST_PAGE;
+
+		UNIT_CHECK(pageOf(addr) == (types[i].page != 0U ? (addr | types[i].page) : 0U));
+	}
+	for(u32 addr = base + n * MMU_TEST_PAGE; addr < base + MMU_TEST_SECT; addr += MMU_TEST_PAGE) {
+		UNIT_CHECK(pageOf(addr) == (addr | MMU_TEST_WB_PAGE));
+	}
+	restore(base);
+
+	/* The same fault entry as a section */
+	Xil_SetTlbAttributes((INTPTR)0x00200000U, RESERVED);
+	UNIT_CHECK((sectionOf(0x00200000U) & MMU_TEST_TYPE) == 0U);
+	restore(0x00200000U);
+	unitResult("convert", "%u memory types, RESERVED pages fault", (unsigned)n);
+}
+
+static void testSplit(void)
+{
+	const u32 adr = 0x002FF000U;
+	const u32 size = MMU_TEST_PAGE + MMU_TEST_SECT + MMU_TEST_PAGE;
+
+	reset();
+	UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)adr, size, NORM_NONCACHE) == XST_SUCCESS);
+	UNIT_CHECK(isSplit(0x00200000U) && isSplit(0x00400000U));
+	UNIT_CHECK((sectionOf(0x00200000U) & MMU_TEST_DOMAIN) == MMU_TEST_DOMAIN);
+	UNIT_CHECK((sectionOf(0x00400000U) & MMU_TEST_DOMAIN) == MMU_TEST_DOMAIN);
+	UNIT_CHECK(sectionOf(0x00300000U) == (0x00300000U | NORM_NONCACHE));
+	UNIT_CHECK(pageOf(0x002FE000U) == (0x002FE000U | MMU_TEST_WB_PAGE));
+	UNIT_CHECK(pageOf(0x002FF000U) == (0x002FF000U | 0x472U));
+	UNIT_CHECK(pageOf(0x00400000U) == (0x00400000U | 0x472U));
+	UNIT_CHECK(pageOf(0x00401000U) == (0x00401000U | MMU_TEST_WB_PAGE));
+
+	/* Only the changed pages and the section, the split keeps the others */
+	UNIT_CHECK(tlbAll == 0U && tlbMvaCount == 3U);
+	UNIT_CHECK(tlbInvalidated(0x002FF000U) && tlbInvalidated(0x00300000U) && tlbInvalidated(0x00400000U));
+	UNIT_CHECK(branchInvalidations == 1U);
+	UNIT_CHECK(flushRangesCalls == 1U && flushedCount == 1U && flushAll == 0U);
+	UNIT_CHECK(flushed[0].Addr == (INTPTR)adr && flushed[0].Len == size);
+
+	/* A split section overwritten whole gives its table back, the TLB
+	holds its pages, so it is invalidated whole */
+	reset();
+	restore(0x00200000U);
+	UNIT_CHECK(tlbAll == 1U && tlbMvaCount == 0U);
+	restore(0x00300000U);
+	restore(0x00400000U);
+	unitResult("split", "0x%08x + 0x%x: 2 sections split, 1 written, %u TLB entries",
+			adr, size, 3U);
+}
+
+static void testBatch(void)
+{
+	const u32 base = 0x00500000U;
+
+	reset();
+	Xil_MmuBeginUpdate();
+	Xil_MmuBeginUpdate();
+	for(u32 i = 0; i < 3U; i++) {
+		UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)(base + 2U * i * MMU_TEST_PAGE), MMU_TEST_PAGE,
+				NORM_NONCACHE) == XST_SUCCESS);
+	}
+	Xil_MmuEndUpdate();
+	UNIT_CHECK(tlbMvaCount == 0U && tlbAll == 0U && branchInvalidations == 0U);
+	UNIT_CHECK(flushRangesCalls == 0U && flushAll == 0U);
+	UNIT_CHECK(pageOf(base) == (base | 0x472U));	/* Written at once */
+	Xil_MmuEndUpdate();
+	UNIT_CHECK(tlbMvaCount == 3U && tlbAll == 0U && branchInvalidations == 1U);
+	UNIT_CHECK(flushRangesCalls == 1U && flushedCount == 3U && flushAll == 0U);
+	for(u32 i = 0; i < 3U; i++) {
+		UNIT_CHECK(tlbInvalidated(base + 2U * i * MMU_TEST_PAGE));
+		UNIT_CHECK(flushed[i].Addr == (INTPTR)(base + 2U * i * MMU_TEST_PAGE) && flushed[i].Len == MMU_TEST_PAGE);
+	}
+
+	/* An unmatched end does nothing */
+	reset();
+	Xil_MmuEndUpdate();
+	UNIT_CHECK(branchInvalidations == 0U);
+
+	/* Beyond the TLB and flush list limits */
+	reset();
+	UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)base, (MMU_TEST_TLB_OPS_MAX + 1U) * MMU_TEST_PAGE,
+			NORM_WB_CACHE) == XST_SUCCESS);
+	UNIT_CHECK(tlbAll == 1U && tlbMvaCount == 0U);
+
+	reset();
+	Xil_MmuBeginUpdate();
+	for(u32 i = 0; i <= MMU_TEST_FLUSH_MAX; i++) {
+		UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)(base + i * MMU_TEST_PAGE), MMU_TEST_PAGE,
+				NORM_NONCACHE) == XST_SUCCESS);
+	}
+	Xil_MmuEndUpdate();
+	UNIT_CHECK(flushAll == 1U && flushRangesCalls == 0U);
+	UNIT_CHECK(tlbMvaCount == MMU_TEST_FLUSH_MAX + 1U && tlbAll == 0U);
+	restore(base);
+	unitResult("batch", "TLB by MVA up to %u pages, flush list up to %u regions",
+			MMU_TEST_TLB_OPS_MAX, MMU_TEST_FLUSH_MAX);
+}
+
+static void testPool(void)
+{
+	const u32 base = 0x00600000U;
+	const u32 over = base + XIL_MMU_NUM_PAGE_TABLES * MMU_TEST_SECT;
+	u32 i;
+
+	reset();
+	for(i = 0; i < XIL_MMU_NUM_PAGE_TABLES; i++) {
+		UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)(base + i * MMU_TEST_SECT), MMU_TEST_PAGE,
+				NORM_NONCACHE) == XST_SUCCESS);
+		UNIT_CHECK(isSplit(base + i * MMU_TEST_SECT));
+	}
+	UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)over, MMU_TEST_PAGE, NORM_NONCACHE) == XST_FAILURE);
+	UNIT_CHECK(sectionOf(over) == (over | NORM_WB_CACHE));
+
+	/* The last page of a split section is changed, then the next section
+	needs a table */
+	UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)(over - MMU_TEST_PAGE), 2U * MMU_TEST_PAGE,
+			STRONG_ORDERED) == XST_FAILURE);
+	UNIT_CHECK(pageOf(over - MMU_TEST_PAGE) == ((over - MMU_TEST_PAGE) | 0x032U));
+	UNIT_CHECK(sectionOf(over) == (over | NORM_WB_CACHE));
+	UNIT_CHECK(cpsr == MMU_TEST_CPSR);
+
+	/* Released in a batch, the TLB may still walk the table until its end */
+	Xil_MmuBeginUpdate();
+	Xil_SetTlbAttributes((INTPTR)base, NORM_WB_CACHE);
+	UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)over, MMU_TEST_PAGE, NORM_NONCACHE) == XST_FAILURE);
+	Xil_MmuEndUpdate();
+	UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)over, MMU_TEST_PAGE, NORM_NONCACHE) == XST_SUCCESS);
+	UNIT_CHECK(isSplit(over) && pageOf(over) == (over | 0x472U));
+
+	for(i = 1; i <= XIL_MMU_NUM_PAGE_TABLES; i++) {
+		restore(base + i * MMU_TEST_SECT);
+	}
+	unitResult("pool", "%u page tables, the next split fails", (unsigned)XIL_MMU_NUM_PAGE_TABLES);
+}
+
+static void testIrq(void)
+{
+	reset();
+	UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)0x00700000U, 4U * MMU_TEST_PAGE, NORM_NONCACHE) == XST_SUCCESS);
+	UNIT_CHECK(descFlushes == 3U);	/* Page table, section entry, changed pages */
+	UNIT_CHECK(unmaskedDescFlushes == 0U && cpsr == MMU_TEST_CPSR);
+	restore(0x00700000U);
+	UNIT_CHECK(unmaskedDescFlushes == 0U && cpsr == MMU_TEST_CPSR);
+
+	reset();
+	UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)0x00700800U, MMU_TEST_PAGE, NORM_NONCACHE) == XST_INVALID_PARAM);
+	UNIT_CHECK(Xil_MmuSetRegionAttributes((INTPTR)0x00700000U, 0x800U, NORM_NONCACHE) == XST_INVALID_PARAM);
+	UNIT_CHECK(!isSplit(0x00700000U) && descFlushes == 0U && branchInvalidations == 0U);
+	unitResult("irq", "%u descriptor flushes with interrupts masked", 3U);
+}
+
+int main(void)
+{
+	for(u32 i = 0; i < MMU_TEST_SECTIONS; i++) {
+		MMUTable[i] = (i * MMU_TEST_SECT) | NORM_WB_CACHE;
+	}
+	testConvert();
+	testSplit();
+	testBatch();
+	testPool();
+	testIrq();
+	return unitExit();
+}
@@ -0,0 +1,880 @@
+/*
+ * Host test of the zero-copy packet I/O (../../src/pktio.c) with the BD ring
+ * code of the emacps driver (xemacps_bdring.c, copied to the build directory
+ * so that the stand-in headers apply).
+ *
+ * The MAC is a model working on the descriptors in the memory of pktio.c: it
+ * writes received frames into the posted RX buffers and sets the new bit,
+ * sends the TX descriptors handed to it on tx_go and sets their used bit, and
+ * raises its interrupt through the interrupt status and mask registers. The
+ * rest of the driver (setup, PHY, XEmacPs_IntrHandler()) is replaced by short
+ * versions here. The receiving task only blocks in ulTaskNotifyTake(), where
+ * the frames of the next burst arrive. Cache maintenance is recorded, and
+ * each buffer is followed from the pool to the application or the MAC and
+ * back. Checks:
+ *
+ *  init      the descriptor page is non-cacheable, every RX descriptor but
+ *            one is posted with its own buffer, the TX ring belongs to the
+ *            software, the GEM clock matches the link speed, the RX and TX
+ *            interrupts are off once started
+ *  burst     bursts arrive whole and in order with one RX interrupt each, the
+ *            ring is reposted after every call, an idle wait does not take
+ *            the interrupt latched by the last burst
+ *  drop      a frame spanning two buffers is dropped and both are reposted
+ *  overrun   frames without a posted buffer are counted as RX errors, the
+ *            ring is whole again after the backlog is read
+ *  pool      the application holding every buffer empties the ring, which is
+ *            reposted by the next pktioReceive() once buffers are given back
+ *  txlazy    TX descriptors are only reclaimed once fewer than
+ *            PKTIO_TX_RECLAIM_THRESHOLD are free
+ *  txfull    a full TX ring refuses the rest of a batch, which still belongs
+ *            to the caller, nothing is reclaimed while the frames are in
+ *            flight, and the queued frames go out in order
+ *  reclaim   pktioAlloc() reclaims the sent frames when the pool runs dry,
+ *            and no buffer was lost by the groups before
+ *
+ * Throughout, the MAC only writes buffers invalidated since the CPU last
+ * owned them and sends buffers flushed since they were written, and a buffer
+ * is never given to the application twice.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "unit.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xil_cache.h"
+#include "xil_io.h"
+#include "xil_mmu.h"
+#include "xparameters.h"
+#include "xemacps.h"
+#include "pktio.h"
+
+#define PKTIO_TEST_RANGES	32768U
+#define PKTIO_TEST_PHY		7U		/* PHY address on the MDIO bus */
+#define PKTIO_TEST_BMSR_POLLS	3U	/* Reads before auto-negotiation completes */
+#define PKTIO_TEST_MIN_FRAME	60U
+#define PKTIO_TEST_MAX_FRAME	1514U
+#define PKTIO_TEST_RX_POSTED	(PKTIO_RX_BDS - 1U)	/* pktio.c keeps one descriptor of each ring */
+#define PKTIO_TEST_TX_QUEUED	(PKTIO_TX_BDS - 1U)
+
+/* The registers of pktio.c */
+#define SLCR_LOCK				(XPS_SYS_CTRL_BASEADDR + 0x004U)
+#define SLCR_UNLOCK				(XPS_SYS_CTRL_BASEADDR + 0x008U)
+#define SLCR_GEM0_CLK_CTRL		(XPS_SYS_CTRL_BASEADDR + 0x140U)
+#define PHY_REG_BMSR			1U
+#define PHY_REG_ID1				2U
+#define PHY_REG_1000_CTRL		9U
+#define PHY_REG_1000_STAT		10U
+
+typedef enum {
+	BUF_FREE,		/* In the pool, or never seen */
+	BUF_APP,		/* Handed to the application */
+	BUF_RX,			/* Written by the MAC, not yet received */
+	BUF_TX,			/* Queued for the MAC */
+	BUF_TX_DONE		/* Sent, waiting to be reclaimed */
+} BufOwner;
+
+typedef struct {
+	uint8_t *addr;
+	BufOwner owner;
+	u32 cpuSeq;		/* Last written or handed out by the CPU side */
+	u32 macSeq;		/* Last written by the MAC */
+} BufState;
+
+typedef struct {
+	int flush;
+	UINTPTR addr;
+	u32 len;
+	u32 seq;
+} RangeRecord;
+
+static BufState bufs[PKTIO_NUM_BUFS];
+static u32 bufCount;
+static RangeRecord ranges[PKTIO_TEST_RANGES];
+static u32 rangeCount;
+static u32 now;				/* Event sequence */
+
+/* MAC model */
+static u32 imr = XEMACPS_IXR_ALL_MASK;
+static u32 isr;
+static u32 rxsr;
+static u32 nwctrl;
+static XEmacPs_Bd *rxBase;
+static XEmacPs_Bd *txBase;
+static u32 rxNext;
+static u32 txNext;
+static u32 rxNoBuffer;
+static int txStalled;
+static u32 rxFrameNo;		/* Next frame the MAC receives */
+static u32 rxExpect;		/* Next frame the application must get */
+static u32 txFrameNo;		/* Next frame the application builds */
+static u32 txExpect;		/* Next frame the MAC must send */
+
+/* SLCR */
+static int slcrUnlocked;
+static u32 gemClk;
+static u32 lockedWrites;
+static u32 strayAccesses;
+
+/* Interrupt controller and kernel */
+static XInterruptHandler irqHandler;
+static void *irqRef;
+static u32 irqId;
+static int irqEnabled;
+static int inIrq;
+static u32 irqCalls;
+static u32 notified;
+static u32 wirePending;		/* Frames arriving once the task blocks */
+static struct unitTask { int dummy; } rxTaskObject;
+static u32 bmsrPolls;
+static u32 delays;
+static u32 asserts;
+
+static UINTPTR mmuAddr;
+static u32 mmuSize;
+static u32 mmuAttrib;
+static XEmacPs_Config emacConfig = { XPAR_XEMACPS_0_DEVICE_ID, XPAR_XEMACPS_0_BASEADDR, 0 };
+
+u32 Xil_AssertStatus;
+s32 Xil_AssertWait;
+
+void Xil_Assert(const char8 *File, s32 Line)
+{
+	printf("  assertion %s:%d\n", File, (int)Line);
+	asserts++;
+}
+
+static BufState *bufState(const uint8_t *addr)
+{
+	for(u32 i = 0; i < bufCount; i++) {
+		if(bufs[i].addr == addr) {
+			return &bufs[i];
+		}
+	}
+	UNIT_CHECK(bufCount < PKTIO_NUM_BUFS);
+	if(bufCount == PKTIO_NUM_BUFS) {
+		bufCount--;
+	}
+	bufs[bufCount] = (BufState){ (uint8_t *)addr, BUF_FREE, 0, 0 };
+	return &bufs[bufCount++];
+}
+
+/* A cache operation of the given kind covering [addr, addr + len) after seq */
+static int covered(int flush, const uint8_t *addr, u32 len, u32 seq)
+{
+	for(u32 i = (rangeCount < PKTIO_TEST_RANGES ? rangeCount : PKTIO_TEST_RANGES); i != 0; i--) {
+		const RangeRecord *r = &ranges[i - 1U];
+
+		if(r->seq <= seq) {
+			break;
+		}
+		if(r->flush == flush && r->addr <= (UINTPTR)addr && (UINTPTR)addr + len <= r->addr + r->len) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void recordRanges(int flush, const Xil_CacheRange *Ranges, u32 Count)
+{
+	now++;
+	for(u32 i = 0; i < Count; i++) {
+		if(rangeCount < PKTIO_TEST_RANGES) {
+			ranges[rangeCount] = (RangeRecord){ flush, (UINTPTR)Ranges[i].Addr, Ranges[i].Len, now };
+		}
+		rangeCount++;
+	}
+}
+
+void Xil_DCacheFlushRanges(const Xil_CacheRange *Ranges, u32 Count)
+{
+	recordRanges(1, Ranges, Count);
+}
+
+void Xil_DCacheInvalidateRanges(const Xil_CacheRange *Ranges, u32 Count)
+{
+	recordRanges(0, Ranges, Count);
+}
+
+s32 Xil_MmuSetRegionAttributes(INTPTR Addr, u32 Size, u32 attrib)
+{
+	mmuAddr = (UINTPTR)Addr;
+	mmuSize = Size;
+	mmuAttrib = attrib;
+	return XST_SUCCESS;
+}
+
+static u32 frameLen(u32 no)
+{
+	return PKTIO_TEST_MIN_FRAME + (no * 97U) % (PKTIO_TEST_MAX_FRAME - PKTIO_TEST_MIN_FRAME + 1U);
+}
+
+static void frameFill(uint8_t *data, u32 no)
+{
+	memcpy(data, &no, sizeof(no));
+	for(u32 i = sizeof(no); i < frameLen(no); i++) {
+		data[i] = (uint8_t)(no + i);
+	}
+}
+
+static int frameValid(const uint8_t *data, u32 len, u32 no)
+{
+	u32 got;
+
+	memcpy(&got, data, sizeof(got));
+	if(got != no || len != frameLen(no)) {
+		return 0;
+	}
+	for(u32 i = sizeof(no); i < len; i++) {
+		if(data[i] != (uint8_t)(no + i)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void irqUpdate(void)
+{
+	if(irqEnabled && irqHandler != NULL && !inIrq && (isr & ~imr & XEMACPS_IXR_ALL_MASK) != 0) {
+		inIrq = 1;
+		irqHandler(irqRef);
+		inIrq = 0;
+	}
+}
+
+/* Write one buffer of a received frame, 0 when no descriptor is posted */
+static int macRxBuffer(u32 no, u32 len, u32 flags)
+{
+	XEmacPs_Bd *bd = &rxBase[rxNext];
+	u32 addr = XEmacPs_BdRead(bd, XEMACPS_BD_ADDR_OFFSET);
+	uint8_t *buf = (uint8_t *)(UINTPTR)(addr & XEMACPS_RXBUF_ADD_MASK);
+	BufState *state;
+
+	if(addr & XEMACPS_RXBUF_NEW_MASK) {
+		rxNoBuffer++;
+		rxsr |= XEMACPS_RXSR_BUFFNA_MASK;
+		isr |= XEMACPS_IXR_RXUSED_MASK;
+		irqUpdate();
+		return 0;
+	}
+	state = bufState(buf);
+	UNIT_CHECK(state->owner != BUF_APP && state->owner != BUF_TX && state->owner != BUF_TX_DONE);
+	UNIT_CHECK(covered(0, buf, PKTIO_BUF_SIZE, state->cpuSeq));
+	if(flags == (XEMACPS_RXBUF_SOF_MASK | XEMACPS_RXBUF_EOF_MASK)) {
+		frameFill(buf, no);
+	} else {
+		memset(buf, 0xA5, len);
+	}
+	state->owner = BUF_RX;
+	state->macSeq = ++now;
+
+	XEmacPs_BdWrite(bd, XEMACPS_BD_STAT_OFFSET, flags | len);
+	XEmacPs_BdWrite(bd, XEMACPS_BD_ADDR_OFFSET, addr | XEMACPS_RXBUF_NEW_MASK);
+	rxNext = (addr & XEMACPS_RXBUF_WRAP_MASK) ? 0 : rxNext + 1U;
+	if(flags & XEMACPS_RXBUF_EOF_MASK) {
+		isr |= XEMACPS_IXR_FRAMERX_MASK;
+		irqUpdate();
+	}
+	return 1;
+}
+
+static void macRxFrames(u32 count)
+{
+	for(u32 i = 0; i < count; i++) {
+		if(macRxBuffer(rxFrameNo, frameLen(rxFrameNo), XEMACPS_RXBUF_SOF_MASK | XEMACPS_RXBUF_EOF_MASK)) {
+			rxFrameNo++;
+		}
+	}
+}
+
+/* tx_go: send descriptors until one still has the used bit */
+static void macTransmit(void)
+{
+	XEmacPs_Bd *bd;
+	uint8_t *buf;
+	BufState *state;
+	u32 stat;
+	u32 len;
+
+	if(txStalled) {
+		return;
+	}
+	for(;;) {
+		bd = &txBase[txNext];
+		stat = XEmacPs_BdRead(bd, XEMACPS_BD_STAT_OFFSET);
+		if(stat & XEMACPS_TXBUF_USED_MASK) {
+			break;
+		}
+		buf = (uint8_t *)(UINTPTR)XEmacPs_BdRead(bd, XEMACPS_BD_ADDR_OFFSET);
+		len = stat & XEMACPS_TXBUF_LEN_MASK;
+		state = bufState(buf);
+		UNIT_CHECK(stat & XEMACPS_TXBUF_LAST_MASK);
+		UNIT_CHECK(state->owner == BUF_TX);
+		UNIT_CHECK(covered(1, buf, len, state->cpuSeq));
+		UNIT_CHECK(frameValid(buf, len, txExpect));
+		txExpect++;
+		state->owner = BUF_TX_DONE;
+
+		XEmacPs_BdWrite(bd, XEMACPS_BD_STAT_OFFSET, stat | XEMACPS_TXBUF_USED_MASK);
+		txNext = (stat & XEMACPS_TXBUF_WRAP_MASK) ? 0 : txNext + 1U;
+		isr |= XEMACPS_IXR_TXCOMPL_MASK;
+	}
+	irqUpdate();
+}
+
+u32 unitIoRead(UINTPTR Addr)
+{
+	switch(Addr) {
+	case XPAR_XEMACPS_0_BASEADDR + XEMACPS_NWCTRL_OFFSET:
+		return nwctrl;
+	case XPAR_XEMACPS_0_BASEADDR + XEMACPS_RXSR_OFFSET:
+		return rxsr;
+	case XPAR_XEMACPS_0_BASEADDR + XEMACPS_ISR_OFFSET:
+		return isr;
+	case XPAR_XEMACPS_0_BASEADDR + XEMACPS_IMR_OFFSET:
+		return imr;
+	case SLCR_GEM0_CLK_CTRL:
+		return gemClk;
+	default:
+		strayAccesses++;
+		return 0;
+	}
+}
+
+void unitIoWrite(UINTPTR Addr, u32 Value)
+{
+	switch(Addr) {
+	case XPAR_XEMACPS_0_BASEADDR + XEMACPS_NWCTRL_OFFSET:
+		nwctrl = Value & ~XEMACPS_NWCTRL_STARTTX_MASK;
+		if(Value & XEMACPS_NWCTRL_STARTTX_MASK) {
+			macTransmit();
+		}
+		break;
+	case XPAR_XEMACPS_0_BASEADDR + XEMACPS_RXSR_OFFSET:
+		rxsr &= ~Value;
+		break;
+	case XPAR_XEMACPS_0_BASEADDR + XEMACPS_ISR_OFFSET:
+		isr &= ~Value;
+		break;
+	case XPAR_XEMACPS_0_BASEADDR + XEMACPS_IER_OFFSET:
+		imr &= ~Value;
+		irqUpdate();
+		break;
+	case XPAR_XEMACPS_0_BASEADDR + XEMACPS_IDR_OFFSET:
+		imr |= Value;
+		break;
+	case SLCR_UNLOCK:
+		slcrUnlocked = (Value == 0xDF0DU);
+		break;
+	case SLCR_LOCK:
+		slcrUnlocked = !(Value == 0x767BU);
+		break;
+	case SLCR_GEM0_CLK_CTRL:
+		if(!slcrUnlocked) {
+			lockedWrites++;
+		}
+		gemClk = Value;
+		break;
+	default:
+		strayAccesses++;
+		break;
+	}
+}
+
+/* The parts of the emacps driver pktio.c uses besides the BD rings */
+XEmacPs_Config *XEmacPs_LookupConfig(u16 DeviceId)
+{
+	return DeviceId == emacConfig.DeviceId ? &emacConfig : NULL;
+}
+
+LONG XEmacPs_CfgInitialize(XEmacPs *InstancePtr, XEmacPs_Config *CfgPtr, UINTPTR EffectiveAddress)
+{
+	memset(InstancePtr, 0, sizeof(*InstancePtr));
+	InstancePtr->Config = *CfgPtr;
+	InstancePtr->Config.BaseAddress = EffectiveAddress;
+	InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+	return XST_SUCCESS;
+}
+
+LONG XEmacPs_SetMacAddress(XEmacPs *InstancePtr, void *AddressPtr, u8 Index)
+{
+	return XST_SUCCESS;
+}
+
+void XEmacPs_SetMdioDivisor(XEmacPs *InstancePtr, XEmacPs_MdcDiv Divisor)
+{
+}
+
+void XEmacPs_SetOperatingSpeed(XEmacPs *InstancePtr, u16 Speed)
+{
+}
+
+LONG XEmacPs_SetHandler(XEmacPs *InstancePtr, u32 HandlerType, void *FuncPointer, void *CallBackRef)
+{
+	switch(HandlerType) {
+	case XEMACPS_HANDLER_DMASEND:
+		InstancePtr->SendHandler = (XEmacPs_Handler)FuncPointer;
+		InstancePtr->SendRef = CallBackRef;
+		break;
+	case XEMACPS_HANDLER_DMARECV:
+		InstancePtr->RecvHandler = (XEmacPs_Handler)FuncPointer;
+		InstancePtr->RecvRef = CallBackRef;
+		break;
+	case XEMACPS_HANDLER_ERROR:
+		InstancePtr->ErrorHandler = (XEmacPs_ErrHandler)FuncPointer;
+		InstancePtr->ErrorRef = CallBackRef;
+		break;
+	default:
+		return XST_INVALID_PARAM;
+	}
+	return XST_SUCCESS;
+}
+
+LONG XEmacPs_PhyRead(XEmacPs *InstancePtr, u32 PhyAddress, u32 RegisterNum, u16 *PhyDataPtr)
+{
+	*PhyDataPtr = 0xFFFFU;
+	if(PhyAddress != PKTIO_TEST_PHY) {
+		return XST_SUCCESS;
+	}
+	switch(RegisterNum) {
+	case PHY_REG_ID1:
+		*PhyDataPtr = 0x0141U;
+		break;
+	case PHY_REG_BMSR:
+		*PhyDataPtr = (++bmsrPolls >= PKTIO_TEST_BMSR_POLLS) ? 0x796DU : 0x7949U;
+		break;
+	case PHY_REG_1000_CTRL:
+		*PhyDataPtr = 0x0200U;
+		break;
+	case PHY_REG_1000_STAT:
+		*PhyDataPtr = 0x3800U;
+		break;
+	default:
+		*PhyDataPtr = 0x01E1U;
+		break;
+	}
+	return XST_SUCCESS;
+}
+
+void XEmacPs_Start(XEmacPs *InstancePtr)
+{
+	rxBase = (XEmacPs_Bd *)InstancePtr->RxBdRing.BaseBdAddr;
+	txBase = (XEmacPs_Bd *)InstancePtr->TxBdRing.BaseBdAddr;
+	rxNext = 0;
+	txNext = 0;
+	InstancePtr->IsStarted = XIL_COMPONENT_IS_STARTED;
+	XEmacPs_IntEnable(InstancePtr, XEMACPS_IXR_TX_ERR_MASK | XEMACPS_IXR_RX_ERR_MASK |
+			XEMACPS_IXR_FRAMERX_MASK | XEMACPS_IXR_TXCOMPL_MASK);
+}
+
+/* As the driver: acknowledge everything pending, masked or not */
+void XEmacPs_IntrHandler(void *XEmacPsPtr)
+{
+	XEmacPs *emac = XEmacPsPtr;
+	u32 status = XEmacPs_ReadReg(emac->Config.BaseAddress, XEMACPS_ISR_OFFSET);
+	u32 rxStatus;
+
+	irqCalls++;
+	XEmacPs_WriteReg(emac->Config.BaseAddress, XEMACPS_ISR_OFFSET, status);
+	if(status & XEMACPS_IXR_FRAMERX_MASK) {
+		emac->RecvHandler(emac->RecvRef);
+	}
+	if(status & XEMACPS_IXR_TXCOMPL_MASK) {
+		emac->SendHandler(emac->SendRef);
+	}
+	if(status & XEMACPS_IXR_RX_ERR_MASK) {
+		rxStatus = XEmacPs_ReadReg(emac->Config.BaseAddress, XEMACPS_RXSR_OFFSET);
+		XEmacPs_WriteReg(emac->Config.BaseAddress, XEMACPS_RXSR_OFFSET, rxStatus);
+		emac->ErrorHandler(emac->ErrorRef, XEMACPS_RECV, rxStatus);
+	}
+}
+
+BaseType_t xPortInstallInterruptHandler(uint8_t ucInterruptID, XInterruptHandler pxHandler, void *pvCallBackRef)
+{
+	irqId = ucInterruptID;
+	irqHandler = pxHandler;
+	irqRef = pvCallBackRef;
+	return pdPASS;
+}
+
+void vPortEnableInterrupt(uint8_t ucInterruptID)
+{
+	if(ucInterruptID == irqId) {
+		irqEnabled = 1;
+	}
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return &rxTaskObject;
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+	delays++;
+}
+
+/* The task blocks: this is when the next burst arrives */
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+	u32 value;
+
+	if(notified == 0 && wirePending != 0) {
+		UNIT_CHECK(!(imr & XEMACPS_IXR_FRAMERX_MASK));
+		macRxFrames(wirePending);
+		wirePending = 0;
+	}
+	value = notified;
+	notified = xClearCountOnExit ? 0 : (notified != 0 ? notified - 1U : 0);
+	return value;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+	UNIT_CHECK(xTaskToNotify == &rxTaskObject);
+	notified++;
+	*pxHigherPriorityTaskWoken = pdTRUE;
+}
+
+/* RX descriptors owned by the MAC */
+static u32 rxPosted(void)
+{
+	u32 posted = 0;
+
+	for(u32 i = 0; i < PKTIO_RX_BDS; i++) {
+		if(!(XEmacPs_BdRead(&rxBase[i], XEMACPS_BD_ADDR_OFFSET) & XEMACPS_RXBUF_NEW_MASK)) {
+			posted++;
+		}
+	}
+	return posted;
+}
+
+/* Check frames given to the application and take them over */
+static void appReceived(const PktFrame *frames, u32 got)
+{
+	for(u32 i = 0; i < got; i++) {
+		BufState *state = bufState(frames[i].data);
+
+		UNIT_CHECK(state->owner == BUF_RX);
+		UNIT_CHECK(covered(0, frames[i].data, frames[i].len, state->macSeq));
+		UNIT_CHECK(frameValid(frames[i].data, frames[i].len, rxExpect));
+		rxExpect++;
+		state->owner = BUF_APP;
+		state->cpuSeq = ++now;
+	}
+}
+
+static void appFree(uint8_t *buf)
+{
+	BufState *state = bufState(buf);
+
+	UNIT_CHECK(state->owner == BUF_APP);
+	state->owner = BUF_FREE;
+	pktioFree(buf);
+}
+
+/* Receive count frames, keeping them in held when not NULL */
+static u32 appReceive(u32 count, uint8_t **held)
+{
+	PktFrame frames[PKTIO_RX_BDS];
+	u32 total = 0;
+	u32 got;
+
+	while(total < count) {
+		got = pktioReceive(frames, PKTIO_RX_BDS, 10);
+		if(got == 0) {
+			break;
+		}
+		appReceived(frames, got);
+		for(u32 i = 0; i < got; i++) {
+			if(held != NULL) {
+				held[total + i] = frames[i].data;
+			} else {
+				appFree(frames[i].data);
+			}
+		}
+		total += got;
+	}
+	return total;
+}
+
+/* Take a buffer and build the next TX frame in it, NULL when none is left */
+static uint8_t *appBuild(PktFrame *frame)
+{
+	uint8_t *buf = pktioAlloc();
+	BufState *state;
+
+	if(buf == NULL) {
+		return NULL;
+	}
+	state = bufState(buf);
+	UNIT_CHECK(state->owner == BUF_FREE || state->owner == BUF_TX_DONE);
+	frameFill(buf, txFrameNo);
+	frame->data = buf;
+	frame->len = frameLen(txFrameNo++);
+	state->owner = BUF_APP;
+	state->cpuSeq = ++now;
+	return buf;
+}
+
+static u32 appSend(const PktFrame *frames, u32 count)
+{
+	u32 sent;
+
+	for(u32 i = 0; i < count; i++) {
+		bufState(frames[i].data)->owner = BUF_TX;
+	}
+	sent = pktioSend(frames, count);
+	for(u32 i = sent; i < count; i++) {
+		BufState *state = bufState(frames[i].data);
+
+		if(state->owner == BUF_TX) {
+			state->owner = BUF_APP;
+		}
+	}
+	return sent;
+}
+
+static void testInit(void)
+{
+	static const uint8_t mac[6] = { 0x00, 0x0A, 0x35, 0x00, 0x01, 0x02 };
+	u32 slcrWanted = (XPAR_XEMACPS_0_ENET_SLCR_1000Mbps_DIV1 << 20) | (XPAR_XEMACPS_0_ENET_SLCR_1000Mbps_DIV0 << 8);
+	u32 wraps = 0;
+	u32 txOwned = 0;
+
+	gemClk = 0xFC0FC001U;
+	UNIT_CHECK(pktioInit(mac) == XST_SUCCESS);
+
+	UNIT_CHECK(mmuAttrib == NORM_NONCACHE && mmuSize == 0x1000U && (mmuAddr & 0xFFFU) == 0);
+	UNIT_CHECK((UINTPTR)rxBase == mmuAddr && (UINTPTR)txBase >= mmuAddr && (UINTPTR)txBase < mmuAddr + mmuSize);
+	UNIT_CHECK(rxPosted() == PKTIO_TEST_RX_POSTED);
+	for(u32 i = 0; i < PKTIO_RX_BDS; i++) {
+		u32 addr = XEmacPs_BdRead(&rxBase[i], XEMACPS_BD_ADDR_OFFSET);
+
+		if(!(addr & XEMACPS_RXBUF_NEW_MASK)) {
+			bufState((uint8_t *)(UINTPTR)(addr & XEMACPS_RXBUF_ADD_MASK));
+		}
+		wraps += (addr & XEMACPS_RXBUF_WRAP_MASK) ? 1U : 0U;
+	}
+	UNIT_CHECK(bufCount == PKTIO_TEST_RX_POSTED);
+	UNIT_CHECK(wraps == 1U && (XEmacPs_BdRead(&rxBase[PKTIO_RX_BDS - 1U], XEMACPS_BD_ADDR_OFFSET) & XEMACPS_RXBUF_WRAP_MASK));
+	for(u32 i = 0; i < PKTIO_TX_BDS; i++) {
+		txOwned += (XEmacPs_BdRead(&txBase[i], XEMACPS_BD_STAT_OFFSET) & XEMACPS_TXBUF_USED_MASK) ? 1U : 0U;
+	}
+	UNIT_CHECK(txOwned == PKTIO_TX_BDS);
+	UNIT_CHECK(XEmacPs_BdRead(&txBase[PKTIO_TX_BDS - 1U], XEMACPS_BD_STAT_OFFSET) & XEMACPS_TXBUF_WRAP_MASK);
+
+	UNIT_CHECK((gemClk & 0x03F03F00U) == slcrWanted && (gemClk & 0xFC0FC0FFU) == 0xFC0FC001U);
+	UNIT_CHECK(!slcrUnlocked && lockedWrites == 0);
+	UNIT_CHECK(bmsrPolls == PKTIO_TEST_BMSR_POLLS && delays == PKTIO_TEST_BMSR_POLLS - 1U);
+	UNIT_CHECK(irqId == XPAR_XEMACPS_0_INTR && irqEnabled);
+	UNIT_CHECK((imr & (XEMACPS_IXR_FRAMERX_MASK | XEMACPS_IXR_TXCOMPL_MASK)) ==
+			(XEMACPS_IXR_FRAMERX_MASK | XEMACPS_IXR_TXCOMPL_MASK));
+	UNIT_CHECK(!(imr & XEMACPS_IXR_RXUSED_MASK));
+	unitResult("init", "%u RX buffers posted, GEM0 clock 0x%08x", (unsigned)rxPosted(), (unsigned)gemClk);
+}
+
+static void testBurst(void)
+{
+	static const u32 bursts[] = { 1, 5, 16, 17, 40, PKTIO_TEST_RX_POSTED, 3 };
+	PktioStats_t before, after;
+	PktFrame frame;
+	u32 calls = irqCalls;
+	u32 total = 0;
+
+	pktioGetStats(&before);
+	for(u32 b = 0; b < sizeof(bursts) / sizeof(bursts[0]); b++) {
+		u32 irqBefore = irqCalls;
+
+		wirePending = bursts[b];
+		UNIT_CHECK(appReceive(bursts[b], NULL) == bursts[b]);
+		UNIT_CHECK(irqCalls == irqBefore + 1U);
+		UNIT_CHECK(rxPosted() == PKTIO_TEST_RX_POSTED);
+		UNIT_CHECK(imr & XEMACPS_IXR_FRAMERX_MASK);
+		total += bursts[b];
+
+		/* Idle: the FRAMERX status left by the burst must not wake the task */
+		UNIT_CHECK(pktioReceive(&frame, 1, 10) == 0);
+		UNIT_CHECK(irqCalls == irqBefore + 1U);
+		UNIT_CHECK(!(imr & XEMACPS_IXR_FRAMERX_MASK));
+	}
+	pktioGetStats(&after);
+	UNIT_CHECK(after.ulRxFrames - before.ulRxFrames == total);
+	UNIT_CHECK(after.ulRxInterrupts - before.ulRxInterrupts == sizeof(bursts) / sizeof(bursts[0]));
+	UNIT_CHECK(rxExpect == rxFrameNo && rxNoBuffer == 0);
+	unitResult("burst", "%u frames in %u bursts, %u interrupts, %u polls", (unsigned)total,
+			(unsigned)(sizeof(bursts) / sizeof(bursts[0])), (unsigned)(irqCalls - calls),
+			(unsigned)(after.ulRxPolls - before.ulRxPolls));
+}
+
+static void testDrop(void)
+{
+	PktioStats_t before, after;
+
+	pktioGetStats(&before);
+	UNIT_CHECK(macRxBuffer(0, PKTIO_BUF_SIZE, XEMACPS_RXBUF_SOF_MASK));
+	UNIT_CHECK(macRxBuffer(0, 200U, XEMACPS_RXBUF_EOF_MASK));
+	macRxFrames(1);
+	UNIT_CHECK(appReceive(1, NULL) == 1U);
+	pktioGetStats(&after);
+	UNIT_CHECK(after.ulRxDropped - before.ulRxDropped == 2U);
+	UNIT_CHECK(after.ulRxFrames - before.ulRxFrames == 1U);
+	UNIT_CHECK(rxPosted() == PKTIO_TEST_RX_POSTED);
+	unitResult("drop", "%u buffers dropped", (unsigned)(after.ulRxDropped - before.ulRxDropped));
+}
+
+static void testOverrun(void)
+{
+	PktioStats_t before, after;
+	u32 lost = rxNoBuffer;
+
+	pktioGetStats(&before);
+	macRxFrames(PKTIO_TEST_RX_POSTED + 10U);
+	lost = rxNoBuffer - lost;
+	UNIT_CHECK(lost == 10U);
+	UNIT_CHECK(appReceive(PKTIO_TEST_RX_POSTED, NULL) == PKTIO_TEST_RX_POSTED);
+	pktioGetStats(&after);
+	UNIT_CHECK(after.ulRxErrors - before.ulRxErrors == lost);
+	UNIT_CHECK(rxPosted() == PKTIO_TEST_RX_POSTED);
+	UNIT_CHECK(rxExpect == rxFrameNo);
+	unitResult("overrun", "%u frames without buffer, %u RX errors", (unsigned)lost,
+			(unsigned)(after.ulRxErrors - before.ulRxErrors));
+}
+
+static void testPool(void)
+{
+	static uint8_t *held[PKTIO_NUM_BUFS];
+	PktioStats_t before, after;
+	PktFrame frame;
+	u32 count = 0;
+	u32 posted;
+
+	pktioGetStats(&before);
+	/* The application keeps everything: the ring runs out of buffers */
+	while(count < PKTIO_NUM_BUFS && rxPosted() != 0) {
+		u32 n = rxPosted();
+
+		macRxFrames(n);
+		UNIT_CHECK(appReceive(n, &held[count]) == n);
+		count += n;
+	}
+	posted = rxPosted();
+	UNIT_CHECK(count == PKTIO_NUM_BUFS && posted == 0);
+	UNIT_CHECK(pktioAlloc() == NULL);
+	macRxFrames(1);
+	UNIT_CHECK(rxNoBuffer != 0);
+
+	/* Given back, the next call posts them again */
+	for(u32 i = 0; i < count; i++) {
+		appFree(held[i]);
+	}
+	UNIT_CHECK(pktioReceive(&frame, 1, 0) == 0);
+	UNIT_CHECK(rxPosted() == PKTIO_TEST_RX_POSTED);
+	macRxFrames(1);
+	UNIT_CHECK(appReceive(1, NULL) == 1U);
+	pktioGetStats(&after);
+	UNIT_CHECK(after.ulPoolEmpty != before.ulPoolEmpty);
+	unitResult("pool", "%u buffers held, ring reposted with %u", (unsigned)count, (unsigned)rxPosted());
+}
+
+static void testTxLazy(void)
+{
+	const u32 early = PKTIO_TX_BDS - PKTIO_TX_RECLAIM_THRESHOLD;
+	PktFrame frame;
+	u32 reclaimed;
+	u32 reclaimedLate;
+
+	for(u32 i = 0; i < early; i++) {
+		UNIT_CHECK(appBuild(&frame) != NULL);
+		UNIT_CHECK(appSend(&frame, 1) == 1U);
+	}
+	UNIT_CHECK(txExpect == txFrameNo);
+	reclaimed = pktioReclaimTx();
+	UNIT_CHECK(reclaimed == early);
+
+	/* One more than that, the next send reclaims */
+	for(u32 i = 0; i < early + 2U; i++) {
+		UNIT_CHECK(appBuild(&frame) != NULL);
+		UNIT_CHECK(appSend(&frame, 1) == 1U);
+	}
+	reclaimedLate = pktioReclaimTx();
+	UNIT_CHECK(reclaimedLate == 1U);
+	UNIT_CHECK(txExpect == txFrameNo);
+	unitResult("txlazy", "%u sent before a reclaim, %u left after the lazy one", (unsigned)reclaimed,
+			(unsigned)reclaimedLate);
+}
+
+static void testTxFull(void)
+{
+	PktFrame frames[PKTIO_TX_BDS + 6U];
+	PktioStats_t before, after;
+	u32 count = sizeof(frames) / sizeof(frames[0]);
+	u32 sent;
+
+	pktioGetStats(&before);
+	for(u32 i = 0; i < count; i++) {
+		UNIT_CHECK(appBuild(&frames[i]) != NULL);
+	}
+	txStalled = 1;
+	sent = appSend(frames, count);
+	UNIT_CHECK(sent == PKTIO_TEST_TX_QUEUED);
+	UNIT_CHECK(txExpect == txFrameNo - count);
+	UNIT_CHECK(pktioReclaimTx() == 0);
+	txStalled = 0;
+	macTransmit();
+	UNIT_CHECK(txExpect == txFrameNo - (count - sent));
+	pktioGetStats(&after);
+	UNIT_CHECK(after.ulTxRingFull - before.ulTxRingFull == count - sent);
+	UNIT_CHECK(after.ulTxFrames - before.ulTxFrames == sent);
+
+	/* The refused frames are the caller's, sent again in a later call */
+	UNIT_CHECK(pktioReclaimTx() == sent);
+	txExpect += count - sent;
+	for(u32 i = sent; i < count; i++) {
+		appFree(frames[i].data);
+	}
+	unitResult("txfull", "%u queued, %u refused", (unsigned)sent, (unsigned)(count - sent));
+}
+
+static void testReclaim(void)
+{
+	static PktFrame frames[PKTIO_NUM_BUFS];
+	PktioStats_t before, after;
+	u32 count = 0;
+
+	for(u32 i = 0; i < 20U; i++) {
+		UNIT_CHECK(appBuild(&frames[i]) != NULL);
+		UNIT_CHECK(appSend(&frames[i], 1) == 1U);
+	}
+	pktioGetStats(&before);
+	while(count < PKTIO_NUM_BUFS && appBuild(&frames[count]) != NULL) {
+		count++;
+	}
+	pktioGetStats(&after);
+	UNIT_CHECK(count == PKTIO_NUM_BUFS - PKTIO_TEST_RX_POSTED);
+	UNIT_CHECK(after.ulPoolEmpty - before.ulPoolEmpty == 1U);
+	for(u32 i = 0; i < count; i++) {
+		appFree(frames[i].data);
+	}
+	UNIT_CHECK(pktioReclaimTx() == 0);
+	unitResult("reclaim", "%u buffers for the application, %u distinct buffers seen", (unsigned)count,
+			(unsigned)bufCount);
+}
+
+int main(void)
+{
+	testInit();
+	testBurst();
+	testDrop();
+	testOverrun();
+	testPool();
+	testTxLazy();
+	testTxFull();
+	testReclaim();
+
+	UNIT_CHECK(bufCount == PKTIO_NUM_BUFS);
+	UNIT_CHECK(asserts == 0 && strayAccesses == 0 && rangeCount <= PKTIO_TEST_RANGES);
+	unitResult("driver", "%u assertions, %u stray register accesses", (unsigned)asserts, (unsigned)strayAccesses);
+	return unitExit();
+}
@@ -0,0 +1,357 @@
+/*
+ * Host test of the stack guard pages of the Zynq port (portStackGuard.c,
+ * copied to the build directory, with the real FreeRTOS.h and task.h of the
+ * BSP). The Makefile builds it with configUSE_STACK_GUARD_PAGES 1, a pool of
+ * 8 pages, guards of 2 pages and 2 guarded static stacks, so the pool holds
+ * at most 2 blocks.
+ *
+ * The kernel calls, the heap and Xil_MmuSetRegionAttributes() are stubs of
+ * the test, the data abort handler is taken from
+ * Xil_ExceptionRegisterHandler() and called with the fault address of CP15.
+ * The pool is linked below 4 GB (no PIE) as the port keeps addresses in
+ * uint32_t. Checks:
+ *
+ *  fallback    a guard that cannot be mapped leaves the stack to the heap,
+ *              counted unguarded, and vPortFreeStack() gives it back there
+ *  carve       stacks are rounded up to pages above their guard, the guard
+ *              mapped RESERVED once, with the scheduler suspended
+ *  reuse       a freed block goes to the smallest later stack that fits,
+ *              without mapping its guard again, a double free asserts
+ *  full        a stack that no longer fits in the pool comes from the heap
+ *  static      a static buffer loses its guard pages once, given again it
+ *              keeps its block, beyond configSTACK_GUARD_STATIC_STACKS it is
+ *              used whole without a guard
+ *  abort       a fault anywhere in a guard calls the overflow hook with the
+ *              running task, other faults do not
+ */
+
+#include <setjmp.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/time.h>
+#include "unit.h"
+#include "xil_exception.h"
+#include "xil_mmu.h"
+#include "xreg_cortexa9.h"
+#include "xstatus.h"
+
+#define SG_PAGE			4096U
+#define SG_GUARD		(2U * SG_PAGE)	/* configSTACK_GUARD_PAGES of the Makefile */
+#define SG_POOL_PAGES	8U
+#define SG_PROTECTS		16U
+#define SG_HEAP			(4U * SG_PAGE)
+
+/* The TCB is opaque to portStackGuard.c */
+struct tskTaskControlBlock {
+	char name[configMAX_TASK_NAME_LEN];
+};
+
+static struct tskTaskControlBlock task = { "guarded" };
+static int suspended;
+static int maxSuspended;
+
+static uintptr_t protectAddr[SG_PROTECTS];
+static u32 protectSize[SG_PROTECTS];
+static u32 protectAttrib[SG_PROTECTS];
+static unsigned protectCount;
+static int protectFail;
+
+static uint8_t heap[SG_HEAP] __attribute__ ((aligned(8)));
+static size_t heapUsed;
+static unsigned heapAllocs;
+static void *heapFreed;
+static int asserts;
+static jmp_buf assertJump;
+static int assertExpected;
+
+static Xil_ExceptionHandler abortHandler;
+static u32 faultAddress;
+static TaskHandle_t overflowTask;
+static const char *overflowName;
+static jmp_buf overflowJump;
+static sigjmp_buf hangJump;
+
+/* Two static stacks of one page above their guard, and a third one */
+static StackType_t staticA[portSTATIC_STACK_WORDS(1024)] portSTATIC_STACK_ATTRIBUTES;
+static StackType_t staticB[portSTATIC_STACK_WORDS(1024)] portSTATIC_STACK_ATTRIBUTES;
+static StackType_t staticC[portSTATIC_STACK_WORDS(2048)] portSTATIC_STACK_ATTRIBUTES;
+
+void vTaskSuspendAll(void)
+{
+	suspended++;
+	if(suspended > maxSuspended) {
+		maxSuspended = suspended;
+	}
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+	suspended--;
+	return pdFALSE;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return &task;
+}
+
+char *pcTaskGetName(TaskHandle_t xTaskToQuery)
+{
+	return xTaskToQuery->name;
+}
+
+void *pvPortMallocFast(size_t xSize)
+{
+	void *p = &heap[heapUsed];
+
+	heapAllocs++;
+	if(heapUsed + xSize > SG_HEAP) {
+		return NULL;
+	}
+	heapUsed += (xSize + 7U) & ~(size_t)7U;
+	return p;
+}
+
+void vPortFree(void *pv)
+{
+	heapFreed = pv;
+}
+
+/* The target halts there, an expected one goes back to the test */
+void vApplicationAssert(const char *pcFile, uint32_t ulLine)
+{
+	asserts++;
+	if(!assertExpected) {
+		printf("  %s:%u: unexpected assertion\n", pcFile, (unsigned)ulLine);
+		return;
+	}
+	assertExpected = 0;
+	longjmp(assertJump, 1);
+}
+
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
+{
+	overflowTask = xTask;
+	overflowName = pcTaskName;
+	longjmp(overflowJump, 1);
+}
+
+void Xil_ExceptionRegisterHandler(u32 Exception_id, Xil_ExceptionHandler Handler, void *Data)
+{
+	(void)Data;
+	if(Exception_id == XIL_EXCEPTION_ID_DATA_ABORT_INT) {
+		abortHandler = Handler;
+	}
+}
+
+s32 Xil_MmuSetRegionAttributes(INTPTR Addr, u32 Size, u32 attrib)
+{
+	if(!suspended || protectFail) {
+		return XST_FAILURE;
+	}
+	if(protectCount < SG_PROTECTS) {
+		protectAddr[protectCount] = (uintptr_t)Addr;
+		protectSize[protectCount] = Size;
+		protectAttrib[protectCount] = attrib;
+	}
+	protectCount++;
+	return XST_SUCCESS;
+}
+
+u32 unitCp15Read(const char *Reg)
+{
+	return strcmp(Reg, XREG_CP15_DATA_FAULT_ADDRESS) == 0 ? faultAddress : 0U;
+}
+
+static void statsCheck(uint32_t guarded, uint32_t unguarded, uint32_t carved)
+{
+	StackGuardStats_t stats;
+
+	vPortGetStackGuardStats(&stats);
+	UNIT_CHECK(stats.ulGuardedStacks == guarded);
+	UNIT_CHECK(stats.ulUnguardedStacks == unguarded);
+	UNIT_CHECK(stats.ulPagesCarved == carved);
+	UNIT_CHECK(stats.ulPagesFree == SG_POOL_PAGES - carved);
+}
+
+static void hang(int sig)
+{
+	(void)sig;
+	siglongjmp(hangJump, 1);
+}
+
+/* 1 if the abort handler called the overflow hook, 0 if it halted */
+static int abortAt(uintptr_t address)
+{
+	struct itimerval halt = { { 0, 0 }, { 0, 100000 } };
+
+	faultAddress = (u32)address;
+	overflowTask = NULL;
+	overflowName = NULL;
+	if(setjmp(overflowJump)) {
+		return 1;
+	}
+	if(sigsetjmp(hangJump, 1)) {
+		return 0;
+	}
+	signal(SIGALRM, hang);
+	setitimer(ITIMER_REAL, &halt, NULL);
+	abortHandler(NULL);
+	return -1;
+}
+
+static uint8_t *pool;	/* First guard, the lowest block */
+static uint8_t *twoPages;
+static uint8_t *onePage;
+
+static void testFallback(void)
+{
+	void *p;
+
+	protectFail = 1;
+	p = pvPortMallocStack(1000);
+	protectFail = 0;
+	UNIT_CHECK(p == heap);
+	UNIT_CHECK(heapAllocs == 1U);
+	UNIT_CHECK(abortHandler != NULL);
+	statsCheck(0, 1, 0);
+	vPortFreeStack(p);
+	UNIT_CHECK(heapFreed == p);
+	UNIT_CHECK(suspended == 0);
+	unitResult("fallback", "unmapped guard, stack of %u bytes from the heap", 1000U);
+}
+
+static void testCarve(void)
+{
+	twoPages = pvPortMallocStack(SG_PAGE + 1U);
+	UNIT_CHECK(protectCount == 1U);
+	pool = (uint8_t *)protectAddr[0];
+	UNIT_CHECK(twoPages == pool + SG_GUARD);
+	UNIT_CHECK(((uintptr_t)pool % SG_PAGE) == 0U);
+	UNIT_CHECK(protectSize[0] == SG_GUARD);
+	UNIT_CHECK(protectAttrib[0] == RESERVED);
+	statsCheck(1, 1, 4);
+
+	onePage = pvPortMallocStack(SG_PAGE);
+	UNIT_CHECK(protectCount == 2U);
+	UNIT_CHECK(protectAddr[1] == (uintptr_t)(twoPages + 2U * SG_PAGE));
+	UNIT_CHECK(onePage == twoPages + 2U * SG_PAGE + SG_GUARD);
+	UNIT_CHECK(heapAllocs == 1U);
+	statsCheck(2, 1, 7);
+	UNIT_CHECK(maxSuspended == 1 && suspended == 0);
+	unitResult("carve", "blocks of 2 and 1 pages above %u byte guards, 7 of %u pages carved",
+		SG_GUARD, SG_POOL_PAGES);
+}
+
+static void testReuse(void)
+{
+	void *p;
+
+	/* One page fits both free blocks, the smaller one is taken */
+	vPortFreeStack(twoPages);
+	vPortFreeStack(onePage);
+	statsCheck(0, 1, 7);
+	p = pvPortMallocStack(100);
+	UNIT_CHECK(p == onePage);
+	p = pvPortMallocStack(SG_PAGE + 100U);
+	UNIT_CHECK(p == twoPages);
+	UNIT_CHECK(protectCount == 2U);
+	UNIT_CHECK(heapAllocs == 1U);
+	statsCheck(2, 1, 7);
+
+	vPortFreeStack(onePage);
+	if(!setjmp(assertJump)) {
+		assertExpected = 1;
+		vPortFreeStack(onePage);
+	}
+	assertExpected = 0;
+	suspended = 0;	/* Left suspended by the assertion */
+	UNIT_CHECK(asserts == 1);
+	statsCheck(1, 1, 7);
+	p = pvPortMallocStack(SG_PAGE);
+	UNIT_CHECK(p == onePage);
+	UNIT_CHECK(suspended == 0);
+	unitResult("reuse", "smallest fitting block taken again, guard mapped once, %d double free asserted",
+		asserts);
+}
+
+static void testFull(void)
+{
+	void *p;
+
+	/* One page left, a block needs three */
+	p = pvPortMallocStack(100);
+	UNIT_CHECK(p != NULL);
+	UNIT_CHECK((uint8_t *)p < pool || (uint8_t *)p >= pool + SG_POOL_PAGES * SG_PAGE);
+	UNIT_CHECK(heapAllocs == 2U);
+	UNIT_CHECK(protectCount == 2U);
+	statsCheck(2, 2, 7);
+	vPortFreeStack(p);
+	UNIT_CHECK(heapFreed == p);
+	statsCheck(2, 2, 7);
+	unitResult("full", "stack from the heap with %u pool page left", SG_POOL_PAGES - 7U);
+}
+
+static void testStatic(void)
+{
+	StackType_t *stack;
+	uint32_t depth;
+
+	stack = pxPortStaticStack(staticA, portSTATIC_STACK_WORDS(1024), &depth);
+	UNIT_CHECK(stack == staticA + SG_GUARD / sizeof(StackType_t));
+	UNIT_CHECK(depth == 1024U);
+	UNIT_CHECK(protectCount == 3U);
+	UNIT_CHECK(protectAddr[2] == (uintptr_t)staticA && protectSize[2] == SG_GUARD);
+	statsCheck(3, 2, 7);
+
+	/* The task was deleted, the buffer is given to a new one */
+	stack = pxPortStaticStack(staticA, portSTATIC_STACK_WORDS(1024), &depth);
+	UNIT_CHECK(stack == staticA + SG_GUARD / sizeof(StackType_t));
+	UNIT_CHECK(depth == 1024U);
+	UNIT_CHECK(protectCount == 3U);
+	statsCheck(3, 2, 7);
+
+	stack = pxPortStaticStack(staticB, portSTATIC_STACK_WORDS(1024), &depth);
+	UNIT_CHECK(stack == staticB + SG_GUARD / sizeof(StackType_t));
+	UNIT_CHECK(protectCount == 4U);
+	statsCheck(4, 2, 7);
+
+	stack = pxPortStaticStack(staticC, portSTATIC_STACK_WORDS(2048), &depth);
+	UNIT_CHECK(stack == staticC);
+	UNIT_CHECK(depth == portSTATIC_STACK_WORDS(2048));
+	UNIT_CHECK(protectCount == 4U);
+	statsCheck(4, 3, 7);
+	UNIT_CHECK(asserts == 1 && suspended == 0);
+	unitResult("static", "2 buffers guarded once each, the third used whole (%u words)",
+		(unsigned)depth);
+}
+
+static void testAbort(void)
+{
+	UNIT_CHECK(abortAt((uintptr_t)pool) == 1);
+	UNIT_CHECK(overflowTask == &task);
+	UNIT_CHECK(overflowName != NULL && strcmp(overflowName, "guarded") == 0);
+	UNIT_CHECK(abortAt((uintptr_t)pool + SG_PAGE + 100U) == 1);
+	UNIT_CHECK(abortAt((uintptr_t)onePage - 1U) == 1);
+	UNIT_CHECK(abortAt((uintptr_t)staticB + SG_GUARD - 4U) == 1);
+
+	/* The stack itself and the data around the pool are not guards */
+	UNIT_CHECK(abortAt((uintptr_t)twoPages) == 0);
+	UNIT_CHECK(abortAt((uintptr_t)pool - 1U) == 0);
+	UNIT_CHECK(abortAt((uintptr_t)staticC) == 0);
+	UNIT_CHECK(overflowTask == NULL);
+	signal(SIGALRM, SIG_DFL);
+	unitResult("abort", "hook called for the first, last and inner guard bytes, not beside them");
+}
+
+int main(void)
+{
+	testFallback();
+	testCarve();
+	testReuse();
+	testFull();
+	testStatic();
+	testAbort();
+	return unitExit();
+}
@@ -0,0 +1,559 @@
+/*
+ * Host test of the UDP telemetry (../../src/telemetry.c).
+ *
+ * The MAC is a pcap file: pktioSend() appends every frame to
+ * build/unit/telemetry_test.pcap, as a capture of the link would, and the
+ * checks decode the frames read back from it. The capture is left for
+ * tools/telemetry_decode.py --pcap, its timestamps at SIM_CLOCK_HZ. The pool
+ * is a handful of buffers that can be made to run dry, the global timer a
+ * virtual clock that starts half a second before its low word wraps. Checks:
+ *
+ *  time      snapshots are rate limited to one per TELEMETRY_TIME_INTERVAL_MS
+ *            however often they are taken, and a datagram goes out once it
+ *            is TELEMETRY_PERIOD_MS old, across the wrap of the timestamps
+ *  full      records fill a datagram up to the MTU before the next is opened
+ *            and button events carry the last snapshot
+ *  tasks     one record per task with its number, state, priority, stack and
+ *            name, nothing when there are more tasks than fit
+ *  arp       requests for TELEMETRY_LOCAL_IP are answered with a padded
+ *            reply, every other frame is ignored
+ *  drop      records are dropped and counted when the pool is empty or the
+ *            TX ring is full, the lost datagram leaves a sequence gap
+ *  capture   every datagram has valid Ethernet, IPv4 and UDP headers, and no
+ *            buffer is left allocated
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unit.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "sim.h"
+#include "pktio.h"
+#include "telemetry.h"
+
+#define TM_TEST_BUFS		8U
+#define TM_TEST_FRAMES		256U
+#define TM_TEST_RECORDS		2048U
+#define TM_TEST_MS			(SIM_CLOCK_HZ / 1000U)
+#define TM_TEST_PAYLOAD		42U		/* Ethernet, IPv4 and UDP headers */
+#define TM_TEST_HDR			12U		/* Telemetry header */
+#define TM_TEST_MTU_PAYLOAD	1472U
+
+typedef struct {
+	uint8_t data[PKTIO_BUF_SIZE];
+	uint32_t len;
+} Frame;
+
+typedef struct {
+	uint32_t type;
+	uint32_t stamp;
+	uint64_t time;
+	uint32_t button;
+	uint32_t number;
+	uint32_t stack;
+	uint32_t priority;
+	uint32_t state;
+	char name[configMAX_TASK_NAME_LEN + 1];
+} Record;
+
+typedef struct {
+	uint32_t sequence;
+	uint32_t stamp;
+	uint32_t first;		/* Index in records[] */
+	uint32_t count;
+	uint32_t len;		/* Frame length */
+} Datagram;
+
+static const uint8_t boardMac[6] = { 0x00, 0x0A, 0x35, 0x00, 0x01, 0x02 };
+static const uint8_t hostMac[6] = TELEMETRY_HOST_MAC;
+static const uint8_t localIp[4] = TELEMETRY_LOCAL_IP;
+static const uint8_t hostIp[4] = TELEMETRY_HOST_IP;
+static const uint8_t peerMac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x42 };
+static const uint8_t peerIp[4] = { 192, 168, 1, 77 };
+
+static uint64_t vclock = (1ULL << 32) - SIM_CLOCK_HZ / 2U;
+static FILE *pcap;
+static long pcapRead;			/* Offset of the first frame not yet decoded */
+
+static uint8_t pool[TM_TEST_BUFS][PKTIO_BUF_SIZE];
+static uint8_t *freeList[TM_TEST_BUFS];
+static uint32_t freeCount;
+static int poolDry;
+static int ringFull;
+
+static Frame frames[TM_TEST_FRAMES];
+static Record records[TM_TEST_RECORDS];
+static Datagram datagrams[TM_TEST_FRAMES];
+static uint32_t recordCount;
+static uint32_t datagramCount;
+static uint32_t arpCount;
+static uint32_t lostRecords;	/* Packed, then dropped with their datagram */
+static uint32_t nextSequence;
+
+static TaskStatus_t tasks[17];
+static UBaseType_t taskCount;
+
+uint64_t simClock(void)
+{
+	return vclock;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+	return taskCount;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *const pxTaskStatusArray, const UBaseType_t uxArraySize,
+		uint32_t *const pulTotalRunTime)
+{
+	if(taskCount > uxArraySize) {
+		return 0;
+	}
+	memcpy(pxTaskStatusArray, tasks, taskCount * sizeof(tasks[0]));
+	return taskCount;
+}
+
+/* The pool of pktio.c */
+uint8_t *pktioAlloc(void)
+{
+	return (poolDry || freeCount == 0) ? NULL : freeList[--freeCount];
+}
+
+void pktioFree(uint8_t *buf)
+{
+	UNIT_CHECK(freeCount < TM_TEST_BUFS);
+	freeList[freeCount++] = buf;
+}
+
+/* The MAC: the frames are sent to the capture and their buffers reclaimed at once */
+uint32_t pktioSend(const PktFrame *out, uint32_t count)
+{
+	uint32_t record[4];
+
+	if(ringFull) {
+		return 0;
+	}
+	for(uint32_t i = 0; i < count; i++) {
+		record[0] = (uint32_t)(vclock / SIM_CLOCK_HZ);
+		record[1] = (uint32_t)(vclock % SIM_CLOCK_HZ / (SIM_CLOCK_HZ / 1000000U));
+		record[2] = out[i].len;
+		record[3] = out[i].len;
+		UNIT_CHECK(out[i].len <= PKTIO_BUF_SIZE);
+		fwrite(record, sizeof(record), 1, pcap);
+		fwrite(out[i].data, out[i].len, 1, pcap);
+		pktioFree(out[i].data);
+	}
+	fflush(pcap);
+	return count;
+}
+
+static uint32_t get16(const uint8_t *p)
+{
+	return p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return get16(p) | (get16(p + 2) << 16);
+}
+
+static uint32_t getBe16(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 8) | p[1];
+}
+
+/* Frames captured since the last call */
+static uint32_t readCapture(void)
+{
+	uint32_t record[4];
+	uint32_t count = 0;
+
+	fseek(pcap, pcapRead, SEEK_SET);
+	while(count < TM_TEST_FRAMES && fread(record, sizeof(record), 1, pcap) == 1) {
+		UNIT_CHECK(record[2] == record[3] && record[2] <= PKTIO_BUF_SIZE);
+		frames[count].len = record[2];
+		if(fread(frames[count].data, record[2], 1, pcap) != 1) {
+			break;
+		}
+		count++;
+	}
+	pcapRead = ftell(pcap);
+	fseek(pcap, 0, SEEK_END);
+	return count;
+}
+
+static void decodeRecords(const uint8_t *p, uint32_t len, Datagram *d)
+{
+	uint32_t pos = TM_TEST_HDR;
+
+	d->first = recordCount;
+	for(uint32_t i = 0; i < d->count; i++) {
+		Record *r = &records[recordCount < TM_TEST_RECORDS ? recordCount : TM_TEST_RECORDS - 1U];
+		const uint8_t *body = p + pos + 2U;
+		uint32_t size;
+
+		UNIT_CHECK(pos + 2U <= len);
+		if(pos + 2U > len) {
+			return;
+		}
+		size = p[pos + 1U];
+		UNIT_CHECK(pos + 2U + size <= len);
+		memset(r, 0, sizeof(*r));
+		r->type = p[pos];
+		switch(r->type) {
+		case TELEMETRY_REC_TIME:
+			UNIT_CHECK(size == 12U);
+			r->stamp = get32(body);
+			r->time = get32(body + 4) | ((uint64_t)get32(body + 8) << 32);
+			break;
+		case TELEMETRY_REC_EVENT:
+			UNIT_CHECK(size == 16U);
+			r->stamp = get32(body);
+			r->button = get32(body + 4);
+			r->time = get32(body + 8) | ((uint64_t)get32(body + 12) << 32);
+			break;
+		case TELEMETRY_REC_TASK:
+			UNIT_CHECK(size == 10U + configMAX_TASK_NAME_LEN);
+			r->number = get32(body);
+			r->stack = get32(body + 4);
+			r->priority = body[8];
+			r->state = body[9];
+			memcpy(r->name, body + 10, configMAX_TASK_NAME_LEN);
+			break;
+		default:
+			UNIT_CHECK(0);
+			break;
+		}
+		pos += 2U + size;
+		recordCount++;
+	}
+	UNIT_CHECK(pos == len);
+}
+
+/* Check the headers of a captured datagram and decode its records */
+static void decodeDatagram(const Frame *f)
+{
+	const uint8_t *ip = f->data + 14;
+	const uint8_t *udp = ip + 20;
+	const uint8_t *p = udp + 8;
+	Datagram *d = &datagrams[datagramCount < TM_TEST_FRAMES ? datagramCount : TM_TEST_FRAMES - 1U];
+	uint32_t sum = 0;
+	uint32_t len;
+
+	UNIT_CHECK(f->len >= TM_TEST_PAYLOAD + TM_TEST_HDR && f->len <= TM_TEST_PAYLOAD + TM_TEST_MTU_PAYLOAD);
+	UNIT_CHECK(memcmp(f->data, hostMac, 6) == 0 && memcmp(f->data + 6, boardMac, 6) == 0);
+	UNIT_CHECK(ip[0] == 0x45 && getBe16(ip + 2) == f->len - 14U && ip[8] != 0 && ip[9] == 17);
+	UNIT_CHECK(memcmp(ip + 12, localIp, 4) == 0 && memcmp(ip + 16, hostIp, 4) == 0);
+	for(uint32_t i = 0; i < 20U; i += 2U) {
+		sum += getBe16(ip + i);
+	}
+	sum = (sum & 0xFFFFU) + (sum >> 16);
+	UNIT_CHECK(sum == 0xFFFFU);
+	UNIT_CHECK(getBe16(udp) == TELEMETRY_PORT && getBe16(udp + 2) == TELEMETRY_PORT);
+	UNIT_CHECK(getBe16(udp + 4) == f->len - 34U && getBe16(udp + 6) == 0);
+
+	len = f->len - TM_TEST_PAYLOAD;
+	UNIT_CHECK(get16(p) == TELEMETRY_MAGIC && p[2] == TELEMETRY_VERSION);
+	d->sequence = get32(p + 4);
+	d->stamp = get32(p + 8);
+	d->count = p[3];
+	d->len = f->len;
+	decodeRecords(p, len, d);
+	datagramCount++;
+}
+
+/* Decode the frames captured since the last call: returns the first new datagram */
+static uint32_t capture(void)
+{
+	uint32_t first = datagramCount;
+	uint32_t count = readCapture();
+
+	for(uint32_t i = 0; i < count; i++) {
+		if(getBe16(frames[i].data + 12) == 0x0800U) {
+			decodeDatagram(&frames[i]);
+		} else {
+			arpCount++;
+		}
+	}
+	return first;
+}
+
+static void advance(uint32_t ms)
+{
+	vclock += (uint64_t)ms * TM_TEST_MS;
+}
+
+/* Let the open datagram age and go out */
+static void flush(void)
+{
+	advance(TELEMETRY_PERIOD_MS);
+	telemetryPoll();
+}
+
+static void testTime(void)
+{
+	const uint32_t calls = 1000U;
+	TelemetryStats_t before, after;
+	uint32_t first;
+	uint32_t snapshots;
+	uint32_t oldest = 0;
+
+	telemetryGetStats(&before);
+	for(uint32_t ms = 0; ms < calls; ms++) {
+		telemetryTime((uint64_t)ms * 100000U);
+		telemetryPoll();
+		advance(1);
+	}
+	flush();
+	telemetryGetStats(&after);
+	first = capture();
+
+	snapshots = recordCount - datagrams[first].first;
+	UNIT_CHECK(snapshots == calls / TELEMETRY_TIME_INTERVAL_MS);
+	UNIT_CHECK(after.ulRecords - before.ulRecords == snapshots);
+	UNIT_CHECK(after.ulDatagrams - before.ulDatagrams == datagramCount - first);
+	for(uint32_t i = datagrams[first].first; i < recordCount; i++) {
+		uint32_t n = i - datagrams[first].first;
+
+		UNIT_CHECK(records[i].type == TELEMETRY_REC_TIME);
+		UNIT_CHECK(records[i].time == (uint64_t)n * TELEMETRY_TIME_INTERVAL_MS * 100000U);
+		UNIT_CHECK(records[i].stamp - records[datagrams[first].first].stamp ==
+				n * TELEMETRY_TIME_INTERVAL_MS * TM_TEST_MS);
+	}
+	for(uint32_t d = first; d < datagramCount; d++) {
+		uint32_t age = datagrams[d].stamp - records[datagrams[d].first].stamp;
+
+		UNIT_CHECK(datagrams[d].sequence == nextSequence++);
+		UNIT_CHECK(age >= TELEMETRY_PERIOD_MS * TM_TEST_MS);
+		UNIT_CHECK(d + 1U == datagramCount || age <= (TELEMETRY_PERIOD_MS + 1U) * TM_TEST_MS);
+		oldest = age > oldest ? age : oldest;
+	}
+	/* The low word of the timer wrapped in the middle */
+	UNIT_CHECK(records[recordCount - 1U].stamp < records[datagrams[first].first].stamp);
+	unitResult("time", "%u calls, %u snapshots in %u datagrams", (unsigned)calls, (unsigned)snapshots,
+			(unsigned)(datagramCount - first));
+}
+
+static void testFull(void)
+{
+	static const uint32_t buttons[] = { 1, 0, 2, 0, 4, 4, 0, 8, 0 };
+	const uint32_t presses = 500U;
+	const uint32_t perDatagram = (TM_TEST_MTU_PAYLOAD - TM_TEST_HDR) / 18U;
+	const uint64_t last = 0x123456789AULL;
+	uint32_t pressed = 0;
+	uint32_t previous = 0;
+	uint32_t first;
+	uint32_t full = 0;
+
+	telemetryTime(last);
+	flush();
+	capture();
+	nextSequence = datagrams[datagramCount - 1U].sequence + 1U;
+
+	for(uint32_t i = 0; pressed < presses; i++) {
+		uint32_t b = buttons[i % (sizeof(buttons) / sizeof(buttons[0]))];
+
+		if(b != 0 && b != previous) {
+			pressed++;
+		}
+		previous = b;
+		telemetryButton(b);
+	}
+	telemetryButton(0);
+	flush();
+	first = capture();
+
+	UNIT_CHECK(recordCount - datagrams[first].first == presses);
+	for(uint32_t d = first; d < datagramCount; d++) {
+		UNIT_CHECK(datagrams[d].sequence == nextSequence++);
+		if(d + 1U < datagramCount) {
+			UNIT_CHECK(datagrams[d].count == perDatagram);
+			full++;
+		}
+	}
+	for(uint32_t i = datagrams[first].first, n = 0; i < recordCount; i++, n++) {
+		static const uint32_t order[] = { 1, 2, 4, 8 };
+
+		UNIT_CHECK(records[i].type == TELEMETRY_REC_EVENT);
+		UNIT_CHECK(records[i].button == order[n % 4U]);
+		UNIT_CHECK(records[i].time == last);
+	}
+	UNIT_CHECK(full == presses / perDatagram);
+	UNIT_CHECK(datagrams[first].len == TM_TEST_PAYLOAD + TM_TEST_HDR + perDatagram * 18U);
+	unitResult("full", "%u events, %u full datagrams of %u", (unsigned)presses, (unsigned)full,
+			(unsigned)perDatagram);
+}
+
+static void testTasks(void)
+{
+	static const char *names[] = { "IDLE", "Tmr Svc", "display", "buttons", "TenChars10" };
+	uint32_t first;
+	uint32_t recordsBefore;
+
+	taskCount = sizeof(names) / sizeof(names[0]);
+	for(uint32_t i = 0; i < taskCount; i++) {
+		tasks[i] = (TaskStatus_t){ .pcTaskName = names[i], .xTaskNumber = i + 1U, .eCurrentState = (eTaskState)(i % 4U),
+				.uxCurrentPriority = i, .usStackHighWaterMark = (uint16_t)(100U + i) };
+	}
+	telemetryTaskStats();
+	flush();
+	first = capture();
+	UNIT_CHECK(recordCount - datagrams[first].first == taskCount);
+	for(uint32_t i = 0; i < taskCount; i++) {
+		const Record *r = &records[datagrams[first].first + i];
+
+		UNIT_CHECK(r->type == TELEMETRY_REC_TASK && r->number == i + 1U && r->state == i % 4U);
+		UNIT_CHECK(r->priority == i && r->stack == 100U + i);
+		UNIT_CHECK(strncmp(r->name, names[i], configMAX_TASK_NAME_LEN) == 0);
+	}
+	nextSequence = datagrams[datagramCount - 1U].sequence + 1U;
+
+	/* More than telemetryTaskStats() takes */
+	recordsBefore = recordCount;
+	taskCount = sizeof(tasks) / sizeof(tasks[0]);
+	telemetryTaskStats();
+	flush();
+	capture();
+	UNIT_CHECK(recordCount == recordsBefore);
+	taskCount = 0;
+	unitResult("tasks", "%u task records", (unsigned)(sizeof(names) / sizeof(names[0])));
+}
+
+static uint32_t arpRequest(uint8_t *f, const uint8_t *target, uint32_t op)
+{
+	memset(f, 0, 60);
+	memset(f, 0xFF, 6);
+	memcpy(f + 6, peerMac, 6);
+	f[12] = 0x08;
+	f[13] = 0x06;
+	f[14] = 0x00;	/* Ethernet */
+	f[15] = 0x01;
+	f[16] = 0x08;	/* IPv4 */
+	f[17] = 0x00;
+	f[18] = 6;
+	f[19] = 4;
+	f[20] = 0;
+	f[21] = (uint8_t)op;
+	memcpy(f + 22, peerMac, 6);
+	memcpy(f + 28, peerIp, 4);
+	memcpy(f + 38, target, 4);
+	return 60;
+}
+
+static void testArp(void)
+{
+	static const uint8_t otherIp[4] = { 192, 168, 1, 11 };
+	uint8_t request[60];
+	TelemetryStats_t before, after;
+	uint32_t count;
+	const uint8_t *r;
+
+	telemetryGetStats(&before);
+	telemetryInput(request, arpRequest(request, localIp, 1));
+	count = readCapture();
+	arpCount += count;
+	UNIT_CHECK(count == 1U);
+	r = frames[0].data;
+	UNIT_CHECK(frames[0].len == 60U);
+	UNIT_CHECK(memcmp(r, peerMac, 6) == 0 && memcmp(r + 6, boardMac, 6) == 0 && getBe16(r + 12) == 0x0806U);
+	UNIT_CHECK(getBe16(r + 14) == 1U && getBe16(r + 16) == 0x0800U && r[18] == 6 && r[19] == 4);
+	UNIT_CHECK(getBe16(r + 20) == 2U);
+	UNIT_CHECK(memcmp(r + 22, boardMac, 6) == 0 && memcmp(r + 28, localIp, 4) == 0);
+	UNIT_CHECK(memcmp(r + 32, peerMac, 6) == 0 && memcmp(r + 38, peerIp, 4) == 0);
+	for(uint32_t i = 42; i < 60U; i++) {
+		UNIT_CHECK(r[i] == 0);
+	}
+
+	/* Not for us, a reply, an IPv4 frame, a short frame */
+	telemetryInput(request, arpRequest(request, otherIp, 1));
+	telemetryInput(request, arpRequest(request, localIp, 2));
+	arpRequest(request, localIp, 1);
+	request[13] = 0x00;
+	telemetryInput(request, 60);
+	telemetryInput(request, arpRequest(request, localIp, 1) - 19U);
+	UNIT_CHECK(readCapture() == 0);
+	telemetryGetStats(&after);
+	UNIT_CHECK(after.ulArpReplies - before.ulArpReplies == 1U);
+	unitResult("arp", "1 reply of %u bytes, 4 frames ignored", (unsigned)frames[0].len);
+}
+
+static void testDrop(void)
+{
+	TelemetryStats_t before, after;
+	uint32_t first;
+
+	telemetryGetStats(&before);
+	poolDry = 1;
+	telemetryButton(1);
+	telemetryButton(2);
+	telemetryButton(4);
+	poolDry = 0;
+	flush();
+	UNIT_CHECK(readCapture() == 0);
+
+	ringFull = 1;
+	telemetryButton(1);
+	telemetryButton(2);
+	flush();
+	ringFull = 0;
+	lostRecords += 2U;
+	UNIT_CHECK(readCapture() == 0);
+	UNIT_CHECK(freeCount == TM_TEST_BUFS);
+
+	telemetryButton(4);
+	telemetryButton(0);
+	flush();
+	first = capture();
+	telemetryGetStats(&after);
+	UNIT_CHECK(after.ulRecordsDropped - before.ulRecordsDropped == 5U);
+	UNIT_CHECK(datagramCount - first == 1U);
+	UNIT_CHECK(datagrams[first].sequence == nextSequence + 1U);
+	UNIT_CHECK(datagrams[first].count == 1U && records[datagrams[first].first].button == 4U);
+	nextSequence = datagrams[first].sequence + 1U;
+	unitResult("drop", "%u records dropped, sequence gap of 1", (unsigned)(after.ulRecordsDropped - before.ulRecordsDropped));
+}
+
+static void testCapture(void)
+{
+	TelemetryStats_t stats;
+
+	telemetryGetStats(&stats);
+	UNIT_CHECK(stats.ulDatagrams == datagramCount);
+	UNIT_CHECK(stats.ulRecords == recordCount + lostRecords);
+	UNIT_CHECK(freeCount == TM_TEST_BUFS);
+	UNIT_CHECK(recordCount <= TM_TEST_RECORDS && datagramCount <= TM_TEST_FRAMES);
+	unitResult("capture", "%u datagrams, %u records, %u ARP replies", (unsigned)datagramCount,
+			(unsigned)recordCount, (unsigned)arpCount);
+}
+
+int main(int argc, char **argv)
+{
+	static const uint32_t header[6] = { 0xA1B2C3D4U, 0x00040002U, 0, 0, 65535U, 1U };	/* Ethernet */
+	char path[512];
+
+	snprintf(path, sizeof(path), "%s.pcap", argc > 0 ? argv[0] : "telemetry_test");
+	pcap = fopen(path, "w+b");
+	if(pcap == NULL) {
+		perror(path);
+		return EXIT_FAILURE;
+	}
+	fwrite(header, sizeof(header), 1, pcap);
+	pcapRead = (long)sizeof(header);
+	for(uint32_t i = 0; i < TM_TEST_BUFS; i++) {
+		pktioFree(pool[i]);
+	}
+
+	telemetryInit(boardMac);
+	testTime();
+	testFull();
+	testTasks();
+	testArp();
+	testDrop();
+	testCapture();
+
+	fclose(pcap);
+	return unitExit();
+}
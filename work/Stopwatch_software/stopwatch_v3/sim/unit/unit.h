@@ -0,0 +1,48 @@
+/*
+ * Host unit tests of the driver level modules of ../../src and of the BSP,
+ * one program per module (make unit). The BSP and hardware they use are
+ * replaced by the stand-in headers of include/ and by models in the test
+ * itself.
+ *
+ * UNIT_CHECK() counts a failed condition and prints it with its location,
+ * unitResult() prints one "name ok|FAIL details" line per check group and
+ * unitExit() ends the program with 1 if anything failed.
+ */
+
+#ifndef UNIT_H
+#define UNIT_H
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int unitFailed;	/* Failed checks of the program */
+static int unitGroupFailed;	/* Failed checks since the last unitResult() */
+
+#define UNIT_CHECK(cond)	do { \
+		if(!(cond)) { \
+			printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			unitGroupFailed++; \
+		} \
+	} while(0)
+
+static void unitResult(const char *name, const char *fmt, ...)
+{
+	va_list args;
+
+	printf("%-14s %-4s ", name, unitGroupFailed ? "FAIL" : "ok");
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+	printf("\n");
+	fflush(stdout);
+	unitFailed += unitGroupFailed;
+	unitGroupFailed = 0;
+}
+
+static int unitExit(void)
+{
+	return unitFailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif /* UNIT_H */
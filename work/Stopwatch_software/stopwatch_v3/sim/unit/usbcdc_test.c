@@ -0,0 +1,1095 @@
+/*
+ * Host test of the USB CDC-ACM serial port and trace channel
+ * (../../src/usbcdc.c) with the endpoint code of the usbps driver
+ * (xusbps.c, xusbps_endpoint.c and xusbps_intr.c, copied to the build
+ * directory so that the stand-in headers apply).
+ *
+ * The device controller is a model working on the dQH and dTD memory of the
+ * driver. A prime resumes the dTD of the queue head overlay while its token is
+ * active, or else loads the dTD its next link pointer names. Each transaction
+ * of the host moves up to one packet through the buffer pages of the current
+ * dTD, which is retired with its remaining length on a short packet or once
+ * done, then the controller follows the link pointer of the dTD and goes idle
+ * at a terminated or inactive one. A flush stops an endpoint where it is.
+ * Completions set ENDPTCOMPLETE and raise the USB interrupt at the next
+ * interrupt threshold (USBCMD ITC, in microframes), setup packets are written
+ * to the ep0 queue head, a bus reset raises its interrupt at once. The
+ * interrupt is only taken with IRQs unmasked in the CPSR. The host runs
+ * control transfers and polls the bulk endpoints at most
+ * USB_TEST_PACKETS_PER_FRAME packets per microframe. Checks:
+ *
+ *  init      the controller runs in device mode with an interrupt threshold
+ *            of at most one microframe, the queue heads are set up for their
+ *            endpoint without automatic zero length packets
+ *  enum      enumeration at high speed: descriptors, address, configuration
+ *            and line coding, unknown requests stall ep0 until the next setup,
+ *            the bulk queue heads get 512 byte packets
+ *  serial    a lone line goes out at once, output written during a transfer
+ *            leaves as one transfer, a transfer of whole packets ends with a
+ *            zero length packet, output is dropped and counted once both
+ *            buffers are full and refused while the port is closed; input
+ *            arrives in order through both OUT dTDs, an overflow of the input
+ *            ring is counted
+ *  reset     a bus reset with an ep0 reply and a trace transfer in flight,
+ *            ep0 and the trace channel work again after enumeration
+ *  trace     trace channel throughput: no loss below the bus rate, the double
+ *            buffering keeps the bus busy above it
+ *  fullspeed enumeration at full speed: 64 byte bulk packets, the other speed
+ *            descriptor carries the high speed ones
+ *
+ * Throughout, every byte written is received once and in order unless it was
+ * counted as dropped, a transfer of whole packets ends with a zero length
+ * packet and no other does, IN data is flushed after it was written and OUT
+ * data invalidated after the controller wrote it, the buffer pages of each
+ * dTD follow the first, and the driver asserts nothing.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "unit.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xil_cache.h"
+#include "xil_io.h"
+#include "xparameters.h"
+#include "xreg_cortexa9.h"
+#include "xusbps.h"
+#include "xusbps_endpoint.h"
+#include "usbcdc.h"
+
+#define USB_TEST_BASE				XPAR_XUSBPS_0_BASEADDR
+#define USB_TEST_EPS				4U
+#define USB_TEST_EP_ACM				2U
+#define USB_TEST_EP_TRACE			(USBCDC_TRACE_EP & 0x0FU)
+#define USB_TEST_PACKETS_PER_FRAME	13U		/* High speed bulk, 512 byte packets */
+#define USB_TEST_FRAMES_PER_S		8000U
+#define USB_TEST_TIMEOUT_FRAMES		64U
+#define USB_TEST_RANGES				4096U
+#define USB_TEST_SEGMENTS			16384U
+#define USB_TEST_OUT_RECORDS		64U
+#define USB_TEST_TRACE_CHUNK		64U		/* A DLOG record */
+#define USB_TEST_TRACE_FRAMES		8000U	/* One second */
+#define USB_TEST_TRACE_LOSSLESS		2560U	/* Bytes per microframe, 20 MB/s */
+#define USB_TEST_TRACE_OVERLOAD		7680U	/* 61 MB/s, above the 53 MB/s of the bus */
+#define USB_TEST_TRACE_MIN_KBPS		40000U	/* Kept by the double buffering under overload */
+#define USB_TEST_ITC_RESET			(XUSBPS_CMD_ITHRESHOLD_DEFAULT << 16)
+
+#define HOST_NAK	(-1)
+#define HOST_STALL	(-2)
+
+#define PORTSC_SPEED_HS		0x08000000U
+#define PORTSC_SPEED_FS		0x00000000U
+
+typedef struct {
+	u32 cur;		/* dTD being executed */
+	u32 done;		/* Bytes of it moved */
+	int ready;		/* Primed, ENDPTSTATUS */
+	u32 primeSeq;	/* CPU side event at the last prime */
+} UdcEp;
+
+typedef struct {
+	int flush;
+	UINTPTR addr;
+	u32 len;
+	u32 seq;
+} RangeRecord;
+
+/* Bytes offered to a writer, the runs it accepted, and the host reading them back */
+typedef struct {
+	u32 offered;
+	u32 accepted;
+	u32 received;
+	u32 lost;			/* Accepted, then discarded by a bus reset */
+	u32 segStart[USB_TEST_SEGMENTS];
+	u32 segLen[USB_TEST_SEGMENTS];
+	u32 segHead;
+	u32 segTail;
+	u32 segPos;			/* Bytes of segTail received */
+	u32 errors;
+	u32 transfers;		/* Ended by a short packet */
+	u32 zlps;
+	u32 transferLen;	/* Of the transfer being received */
+} Stream;
+
+/* Controller registers */
+static u32 usbcmd = USB_TEST_ITC_RESET;
+static u32 usbsts;
+static u32 usbintr;
+static u32 deviceAddr;
+static u32 epListAddr;
+static u32 usbMode;
+static u32 otgsc;
+static u32 portsc = PORTSC_SPEED_HS;
+static u32 setupStat;
+static u32 epComplete;
+static u32 epcr[USB_TEST_EPS];
+static UdcEp udcEps[USB_TEST_EPS][2];	/* OUT, IN */
+static int uiHeld;			/* USB interrupt waiting for the threshold */
+static u32 frame;
+static u32 strayAccesses;
+
+/* Interrupt controller and CPU */
+static XInterruptHandler irqHandler;
+static void *irqRef;
+static u32 irqId;
+static int irqEnabled;
+static int inIrq;
+static u32 irqCalls;
+static u32 cpsr = XREG_CPSR_SYSTEM_MODE;
+static u32 asserts;
+
+/* Cache maintenance and CPU side events */
+static RangeRecord ranges[USB_TEST_RANGES];
+static u32 rangeCount;
+static u32 now;
+static u32 cpuSeq;			/* Last write of IN data by the CPU side */
+static UINTPTR outAddr[USB_TEST_OUT_RECORDS];
+static u32 outLen[USB_TEST_OUT_RECORDS];
+static u32 outSeq[USB_TEST_OUT_RECORDS];
+static u32 outCount;		/* OUT packets not yet checked */
+
+/* Host */
+static Stream acm;
+static Stream trace;
+static u32 dtdsChecked;
+static uint8_t hostBuf[512];
+static uint8_t writeBuf[USBCDC_TRACE_BUF_SIZE];
+
+u32 Xil_AssertStatus;
+s32 Xil_AssertWait;
+
+void Xil_Assert(const char8 *File, s32 Line)
+{
+	printf("  assertion %s:%d\n", File, (int)Line);
+	asserts++;
+}
+
+XUsbPs_Config *XUsbPs_LookupConfig(u16 DeviceId)
+{
+	static XUsbPs_Config config = { XPAR_XUSBPS_0_DEVICE_ID, USB_TEST_BASE };
+
+	return DeviceId == XPAR_XUSBPS_0_DEVICE_ID ? &config : NULL;
+}
+
+static void udcIrqUpdate(void);
+
+BaseType_t xPortInstallInterruptHandler(uint8_t ucInterruptID, XInterruptHandler pxHandler, void *pvCallBackRef)
+{
+	irqId = ucInterruptID;
+	irqHandler = pxHandler;
+	irqRef = pvCallBackRef;
+	return pdPASS;
+}
+
+void vPortEnableInterrupt(uint8_t ucInterruptID)
+{
+	UNIT_CHECK(ucInterruptID == irqId);
+	irqEnabled = 1;
+	udcIrqUpdate();
+}
+
+u32 unitCpsrRead(void)
+{
+	return cpsr;
+}
+
+/* An interrupt raised while IRQs were masked is taken when they are unmasked */
+void unitCpsrWrite(u32 Value)
+{
+	cpsr = Value;
+	udcIrqUpdate();
+}
+
+static void recordRange(int flush, INTPTR adr, u32 len)
+{
+	ranges[rangeCount++ % USB_TEST_RANGES] = (RangeRecord){ flush, (UINTPTR)adr, len, ++now };
+}
+
+void Xil_DCacheFlushRange(INTPTR adr, u32 len)
+{
+	recordRange(1, adr, len);
+}
+
+void Xil_DCacheInvalidateRange(INTPTR adr, u32 len)
+{
+	recordRange(0, adr, len);
+}
+
+/* A flush or invalidation covering [addr, addr + len) after event seq */
+static int covered(int flush, UINTPTR addr, u32 len, u32 seq)
+{
+	u32 n = rangeCount < USB_TEST_RANGES ? rangeCount : USB_TEST_RANGES;
+
+	for(u32 i = 0; i < n; i++) {
+		const RangeRecord *r = &ranges[(rangeCount - 1U - i) % USB_TEST_RANGES];
+
+		if(r->seq <= seq) {
+			break;
+		}
+		if(r->flush == flush && r->addr <= addr && addr + len <= r->addr + r->len) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static u32 rd32(u32 addr, u32 off)
+{
+	return *(volatile u32 *)(UINTPTR)(addr + off);
+}
+
+static void wr32(u32 addr, u32 off, u32 value)
+{
+	*(volatile u32 *)(UINTPTR)(addr + off) = value;
+}
+
+static u32 udcQh(u32 ep, u32 in)
+{
+	return epListAddr + (ep * 2U + in) * XUSBPS_dQH_ALIGN;
+}
+
+static u32 udcMaxPacket(u32 ep, u32 in)
+{
+	return (rd32(udcQh(ep, in), XUSBPS_dQHCFG) & XUSBPS_dQHCFG_MPL_MASK) >> XUSBPS_dQHCFG_MPL_SHIFT;
+}
+
+static void udcIrqUpdate(void)
+{
+	while(irqEnabled && irqHandler != NULL && !inIrq && !(cpsr & XREG_CPSR_IRQ_ENABLE) &&
+			(usbsts & usbintr) != 0) {
+		u32 saved = cpsr;
+
+		inIrq = 1;
+		cpsr |= XREG_CPSR_IRQ_ENABLE;
+		irqCalls++;
+		irqHandler(irqRef);
+		cpsr = saved;
+		inIrq = 0;
+	}
+}
+
+/* A transfer completed or a setup packet arrived, the interrupt follows at the threshold */
+static void udcComplete(void)
+{
+	if((usbcmd & XUSBPS_CMD_ITC_MASK) == 0) {
+		usbsts |= XUSBPS_IXR_UI_MASK;
+		udcIrqUpdate();
+	} else {
+		uiHeld = 1;
+	}
+}
+
+/* End of a microframe */
+static void udcFrame(void)
+{
+	u32 itc = (usbcmd & XUSBPS_CMD_ITC_MASK) >> 16;
+
+	frame++;
+	if(uiHeld && (itc == 0 || frame % itc == 0)) {
+		uiHeld = 0;
+		usbsts |= XUSBPS_IXR_UI_MASK;
+	}
+	udcIrqUpdate();
+}
+
+/* Execute the dTD named by a link pointer, or go idle with the overlay pointing at it */
+static void udcLoad(UdcEp *m, u32 qh, u32 next)
+{
+	u32 dtd = next & XUSBPS_dTDNLP_ADDR_MASK;
+
+	if((next & XUSBPS_dTDNLP_T_MASK) != 0 || !(rd32(dtd, XUSBPS_dTDTOKEN) & XUSBPS_dTDTOKEN_ACTIVE_MASK)) {
+		m->ready = 0;
+		wr32(qh, XUSBPS_dQHdTDNLP, next);
+		return;
+	}
+	m->cur = dtd;
+	m->done = 0;
+	m->ready = 1;
+	wr32(qh, XUSBPS_dQHCPTR, dtd);
+	wr32(qh, XUSBPS_dQHdTDNLP, rd32(dtd, XUSBPS_dTDNLP));
+	wr32(qh, XUSBPS_dQHdTDTOKEN, rd32(dtd, XUSBPS_dTDTOKEN));
+}
+
+static void udcPrime(u32 ep, u32 in)
+{
+	UdcEp *m = &udcEps[ep][in];
+	u32 qh = udcQh(ep, in);
+
+	m->primeSeq = cpuSeq;
+	if(m->ready) {
+		return;
+	}
+	if((rd32(qh, XUSBPS_dQHdTDTOKEN) & XUSBPS_dTDTOKEN_ACTIVE_MASK) && m->cur != 0) {
+		m->ready = 1;	/* Resume the dTD of the overlay */
+		return;
+	}
+	udcLoad(m, qh, rd32(qh, XUSBPS_dQHdTDNLP));
+}
+
+/* Byte offset of the buffer of a dTD through its page pointers, with the room left in that page */
+static uint8_t *udcBuf(u32 dtd, u32 offset, u32 *room)
+{
+	u32 first = rd32(dtd, XUSBPS_dTDBPTR0);
+	u32 pos = (first & 0xFFFU) + offset;
+	u32 page = pos >> 12;
+	u32 base = page == 0 ? first : rd32(dtd, XUSBPS_dTDBPTR(page));
+
+	*room = 0x1000U - (pos & 0xFFFU);
+	return (uint8_t *)(UINTPTR)((base & ~0xFFFU) + (pos & 0xFFFU));
+}
+
+/* At the first packet of a dTD: its buffer pages follow the first one */
+static void udcCheckPages(u32 dtd, u32 len)
+{
+	u32 first = rd32(dtd, XUSBPS_dTDBPTR0);
+	u32 pages = ((first & 0xFFFU) + len + 0xFFFU) >> 12;
+
+	UNIT_CHECK(len <= XUSBPS_dTD_BUF_MAX_SIZE && pages <= 5U);
+	for(u32 p = 1; p < pages && p < 5U; p++) {
+		UNIT_CHECK(rd32(dtd, XUSBPS_dTDBPTR(p)) == (first & ~0xFFFU) + p * 0x1000U);
+	}
+	dtdsChecked++;
+}
+
+static void udcCopy(u32 dtd, u32 offset, uint8_t *data, u32 len, int toHost)
+{
+	while(len > 0) {
+		u32 room;
+		uint8_t *p = udcBuf(dtd, offset, &room);
+		u32 n = len < room ? len : room;
+
+		if(toHost) {
+			memcpy(data, p, n);
+		} else {
+			memcpy(p, data, n);
+		}
+		offset += n;
+		data += n;
+		len -= n;
+	}
+}
+
+/* A packet of n bytes moved: retire the dTD on a short packet or once done */
+static void udcAdvance(u32 ep, u32 in, u32 left, u32 n)
+{
+	UdcEp *m = &udcEps[ep][in];
+	u32 qh = udcQh(ep, in);
+	u32 token = rd32(m->cur, XUSBPS_dTDTOKEN) & ~XUSBPS_dTDTOKEN_LEN_MASK;
+
+	m->done += n;
+	token |= (left - n) << 16;
+	if(n == udcMaxPacket(ep, in) && n < left) {
+		wr32(m->cur, XUSBPS_dTDTOKEN, token);
+		wr32(qh, XUSBPS_dQHdTDTOKEN, token);
+		return;
+	}
+	token &= ~XUSBPS_dTDTOKEN_ACTIVE_MASK;
+	wr32(m->cur, XUSBPS_dTDTOKEN, token);
+	wr32(qh, XUSBPS_dQHdTDTOKEN, token);
+	if(token & XUSBPS_dTDTOKEN_IOC_MASK) {
+		epComplete |= 1U << (ep + (in ? 16U : 0U));
+		udcComplete();
+	}
+	udcLoad(m, qh, rd32(m->cur, XUSBPS_dTDNLP));
+}
+
+/* IN token: the next packet of the endpoint into data, its length, HOST_NAK or HOST_STALL */
+static int udcIn(u32 ep, uint8_t *data)
+{
+	UdcEp *m = &udcEps[ep][1];
+	u32 mps = udcMaxPacket(ep, 1);
+	u32 left, n;
+
+	if(epcr[ep] & XUSBPS_EPCR_TXS_MASK) {
+		return HOST_STALL;
+	}
+	if(!m->ready || !(epcr[ep] & XUSBPS_EPCR_TXE_MASK)) {
+		return HOST_NAK;
+	}
+	left = (rd32(m->cur, XUSBPS_dTDTOKEN) & XUSBPS_dTDTOKEN_LEN_MASK) >> 16;
+	if(m->done == 0) {
+		udcCheckPages(m->cur, left);
+		UNIT_CHECK(left == 0 || covered(1, rd32(m->cur, XUSBPS_dTDBPTR0), left, m->primeSeq));
+	}
+	n = left < mps ? left : mps;
+	udcCopy(m->cur, m->done, data, n, 1);
+	udcAdvance(ep, 1, left, n);
+	return (int)n;
+}
+
+/* OUT token with len bytes of data: the bytes taken, HOST_NAK or HOST_STALL */
+static int udcOut(u32 ep, const uint8_t *data, u32 len)
+{
+	UdcEp *m = &udcEps[ep][0];
+	u32 left, room;
+
+	if(epcr[ep] & XUSBPS_EPCR_RXS_MASK) {
+		return HOST_STALL;
+	}
+	if(!m->ready || !(epcr[ep] & XUSBPS_EPCR_RXE_MASK)) {
+		return HOST_NAK;
+	}
+	UNIT_CHECK(len <= udcMaxPacket(ep, 0));
+	left = (rd32(m->cur, XUSBPS_dTDTOKEN) & XUSBPS_dTDTOKEN_LEN_MASK) >> 16;
+	if(m->done == 0) {
+		udcCheckPages(m->cur, left);
+	}
+	UNIT_CHECK(len <= left);
+	len = len < left ? len : left;
+	if(len > 0 && outCount < USB_TEST_OUT_RECORDS) {
+		outAddr[outCount] = (UINTPTR)udcBuf(m->cur, m->done, &room);
+		outLen[outCount] = len;
+		outSeq[outCount++] = ++now;
+	}
+	udcCopy(m->cur, m->done, (uint8_t *)data, len, 0);
+	udcAdvance(ep, 0, left, len);
+	return (int)len;
+}
+
+/* The CPU invalidated the OUT data it was handed after the controller wrote it */
+static void udcCheckOut(void)
+{
+	for(u32 i = 0; i < outCount; i++) {
+		UNIT_CHECK(covered(0, outAddr[i], outLen[i], outSeq[i]));
+	}
+	outCount = 0;
+}
+
+/* A setup packet stops both directions of ep0 and clears their stall */
+static void udcSetup(const uint8_t setup[8])
+{
+	u32 qh = udcQh(0, 0);
+
+	memcpy((uint8_t *)(UINTPTR)(qh + XUSBPS_dQHSUB0), setup, 8);
+	udcEps[0][0].ready = 0;
+	udcEps[0][1].ready = 0;
+	epcr[0] &= ~(XUSBPS_EPCR_TXS_MASK | XUSBPS_EPCR_RXS_MASK);
+	setupStat |= 1U;
+	usbcmd &= ~XUSBPS_CMD_SUTW_MASK;
+	cpuSeq = ++now;
+	udcComplete();
+}
+
+/* Bus reset at the given speed, the port reset is signalled while the interrupt is handled */
+static void udcBusReset(u32 speed)
+{
+	portsc = speed | XUSBPS_PORTSCR_PR_MASK;
+	deviceAddr = 0;
+	usbsts |= XUSBPS_IXR_UR_MASK;
+	udcIrqUpdate();
+	portsc = speed;
+}
+
+static void udcControllerReset(void)
+{
+	memset(udcEps, 0, sizeof(udcEps));
+	memset(epcr, 0, sizeof(epcr));
+	epcr[0] = XUSBPS_EPCR_TXE_MASK | XUSBPS_EPCR_RXE_MASK;
+	usbcmd = USB_TEST_ITC_RESET;
+	usbsts = 0;
+	usbintr = 0;
+	deviceAddr = 0;
+	setupStat = 0;
+	epComplete = 0;
+	uiHeld = 0;
+}
+
+u32 unitIoRead(UINTPTR Addr)
+{
+	u32 ready = 0;
+
+	switch(Addr - USB_TEST_BASE) {
+	case XUSBPS_CMD_OFFSET:
+		return usbcmd;
+	case XUSBPS_ISR_OFFSET:
+		return usbsts;
+	case XUSBPS_IER_OFFSET:
+		return usbintr;
+	case XUSBPS_DEVICEADDR_OFFSET:
+		return deviceAddr;
+	case XUSBPS_EPLISTADDR_OFFSET:
+		return epListAddr;
+	case XUSBPS_PORTSCR1_OFFSET:
+		return portsc;
+	case XUSBPS_OTGCSR_OFFSET:
+		return otgsc;
+	case XUSBPS_MODE_OFFSET:
+		return usbMode;
+	case XUSBPS_EPSTAT_OFFSET:
+		return setupStat;
+	case XUSBPS_EPPRIME_OFFSET:
+		return 0;	/* Primes take effect at once */
+	case XUSBPS_EPRDY_OFFSET:
+		for(u32 ep = 0; ep < USB_TEST_EPS; ep++) {
+			ready |= (udcEps[ep][0].ready ? 1U : 0U) << ep;
+			ready |= (udcEps[ep][1].ready ? 1U : 0U) << (ep + 16U);
+		}
+		return ready;
+	case XUSBPS_EPCOMPL_OFFSET:
+		return epComplete;
+	case XUSBPS_EPNAKISR_OFFSET:
+		return 0;
+	default:
+		for(u32 ep = 0; ep < USB_TEST_EPS; ep++) {
+			if(Addr - USB_TEST_BASE == XUSBPS_EPCRn_OFFSET(ep)) {
+				return epcr[ep];
+			}
+		}
+		strayAccesses++;
+		return 0;
+	}
+}
+
+void unitIoWrite(UINTPTR Addr, u32 Value)
+{
+	switch(Addr - USB_TEST_BASE) {
+	case XUSBPS_CMD_OFFSET:
+		if(Value & XUSBPS_CMD_RST_MASK) {
+			udcControllerReset();
+		} else {
+			usbcmd = Value;
+		}
+		return;
+	case XUSBPS_ISR_OFFSET:
+		usbsts &= ~Value;
+		return;
+	case XUSBPS_IER_OFFSET:
+		usbintr = Value;
+		udcIrqUpdate();
+		return;
+	case XUSBPS_DEVICEADDR_OFFSET:
+		deviceAddr = Value;
+		return;
+	case XUSBPS_EPLISTADDR_OFFSET:
+		UNIT_CHECK((Value & (XUSBPS_dQH_BASE_ALIGN - 1U)) == 0);
+		epListAddr = Value;
+		return;
+	case XUSBPS_OTGCSR_OFFSET:
+		otgsc = Value;
+		return;
+	case XUSBPS_MODE_OFFSET:
+		usbMode = Value;
+		return;
+	case XUSBPS_EPSTAT_OFFSET:
+		setupStat &= ~Value;
+		return;
+	case XUSBPS_EPPRIME_OFFSET:
+		for(u32 ep = 0; ep < USB_TEST_EPS; ep++) {
+			if(Value & (1U << ep)) {
+				udcPrime(ep, 0);
+			}
+			if(Value & (1U << (ep + 16U))) {
+				udcPrime(ep, 1);
+			}
+		}
+		return;
+	case XUSBPS_EPFLUSH_OFFSET:
+		for(u32 ep = 0; ep < USB_TEST_EPS; ep++) {
+			if(Value & (1U << ep)) {
+				udcEps[ep][0].ready = 0;
+			}
+			if(Value & (1U << (ep + 16U))) {
+				udcEps[ep][1].ready = 0;
+			}
+		}
+		return;
+	case XUSBPS_EPCOMPL_OFFSET:
+		epComplete &= ~Value;
+		return;
+	default:
+		for(u32 ep = 0; ep < USB_TEST_EPS; ep++) {
+			if(Addr - USB_TEST_BASE == XUSBPS_EPCRn_OFFSET(ep)) {
+				if(ep == 0) {
+					Value |= XUSBPS_EPCR_TXE_MASK | XUSBPS_EPCR_RXE_MASK;	/* Always enabled */
+				}
+				if(!(Value & XUSBPS_EPCR_RXE_MASK)) {
+					udcEps[ep][0].ready = 0;
+				}
+				if(!(Value & XUSBPS_EPCR_TXE_MASK)) {
+					udcEps[ep][1].ready = 0;
+				}
+				epcr[ep] = Value & ~(XUSBPS_EPCR_TXR_MASK | XUSBPS_EPCR_RXR_MASK);
+				return;
+			}
+		}
+		strayAccesses++;
+		return;
+	}
+}
+
+static uint8_t streamByte(u32 pos)
+{
+	return (uint8_t)((pos * 2654435761U) >> 24);
+}
+
+/* Offer the next len bytes of the stream to write(), returns the bytes accepted */
+static u32 streamWrite(Stream *s, uint32_t (*write)(const void *, uint32_t), u32 len)
+{
+	u32 last = (s->segHead - 1U) % USB_TEST_SEGMENTS;
+	u32 n;
+
+	for(u32 i = 0; i < len; i++) {
+		writeBuf[i] = streamByte(s->offered + i);
+	}
+	cpuSeq = ++now;
+	n = write(writeBuf, len);
+	UNIT_CHECK(n <= len);
+	if(n > 0 && s->segHead != s->segTail && s->segStart[last] + s->segLen[last] == s->offered) {
+		s->segLen[last] += n;
+	} else if(n > 0) {
+		UNIT_CHECK(s->segHead - s->segTail < USB_TEST_SEGMENTS);
+		s->segStart[s->segHead % USB_TEST_SEGMENTS] = s->offered;
+		s->segLen[s->segHead % USB_TEST_SEGMENTS] = n;
+		s->segHead++;
+	}
+	s->offered += len;
+	s->accepted += n;
+	return n;
+}
+
+/* A packet read by the host: each byte must be the next one accepted */
+static void streamReceive(Stream *s, const uint8_t *data, u32 len, u32 mps)
+{
+	for(u32 i = 0; i < len; i++) {
+		u32 t = s->segTail % USB_TEST_SEGMENTS;
+
+		if(s->segTail == s->segHead) {
+			s->errors++;
+			break;
+		}
+		if(data[i] != streamByte(s->segStart[t] + s->segPos)) {
+			s->errors++;
+		}
+		if(++s->segPos == s->segLen[t]) {
+			s->segPos = 0;
+			s->segTail++;
+		}
+	}
+	s->received += len;
+	s->transferLen += len;
+	if(len == mps) {
+		return;
+	}
+	if(len == 0) {
+		s->zlps++;
+		if(s->transferLen == 0 || s->transferLen % mps != 0) {
+			s->errors++;	/* A zero length packet that was not due */
+		}
+	}
+	s->transfers++;
+	s->transferLen = 0;
+}
+
+/* Bytes accepted but never sent, a bus reset dropped the transfer in flight */
+static void streamDiscard(Stream *s)
+{
+	s->lost = s->accepted - s->received;
+	s->segTail = s->segHead;
+	s->segPos = 0;
+	s->transferLen = 0;
+}
+
+/* The host polls a bulk IN endpoint for at most budget packets, returns the packets read */
+static u32 hostBulkIn(u32 ep, Stream *s, u32 budget)
+{
+	u32 mps = udcMaxPacket(ep, 1);
+	u32 packets;
+
+	for(packets = 0; packets < budget; packets++) {
+		int n = udcIn(ep, hostBuf);
+
+		if(n < 0) {
+			UNIT_CHECK(n == HOST_NAK);
+			break;
+		}
+		streamReceive(s, hostBuf, (u32)n, mps);
+	}
+	return packets;
+}
+
+/* Poll until the endpoint stays idle */
+static void hostDrain(u32 ep, Stream *s)
+{
+	for(u32 idle = 0; idle < USB_TEST_TIMEOUT_FRAMES; idle++) {
+		if(hostBulkIn(ep, s, USB_TEST_PACKETS_PER_FRAME) != 0) {
+			idle = 0;
+		}
+		udcFrame();
+	}
+}
+
+/* A transaction, retried each microframe while the device NAKs */
+static int hostIn(u32 ep, uint8_t *data)
+{
+	for(u32 f = 0; f < USB_TEST_TIMEOUT_FRAMES; f++) {
+		int n = udcIn(ep, data);
+
+		if(n != HOST_NAK) {
+			return n;
+		}
+		udcFrame();
+	}
+	return HOST_NAK;
+}
+
+static int hostOut(u32 ep, const uint8_t *data, u32 len)
+{
+	for(u32 f = 0; f < USB_TEST_TIMEOUT_FRAMES; f++) {
+		int n = udcOut(ep, data, len);
+
+		if(n != HOST_NAK) {
+			return n;
+		}
+		udcFrame();
+	}
+	return HOST_NAK;
+}
+
+/*
+ * A control transfer, returns the length of the IN data stage, 0 for an OUT
+ * request, HOST_NAK or HOST_STALL. The next setup may follow in the microframe
+ * of the status stage.
+ */
+static int hostControl(u32 type, u32 request, u32 value, u32 index, u32 length, uint8_t *data)
+{
+	const uint8_t setup[8] = {
+		(uint8_t)type, (uint8_t)request, (uint8_t)value, (uint8_t)(value >> 8),
+		(uint8_t)index, (uint8_t)(index >> 8), (uint8_t)length, (uint8_t)(length >> 8)
+	};
+	u32 mps = udcMaxPacket(0, 0);
+	u32 got = 0;
+	int n;
+
+	udcSetup(setup);
+	udcFrame();
+	udcCheckOut();
+	if(type & 0x80U) {
+		do {
+			n = hostIn(0, data + got);
+			if(n < 0) {
+				return n;
+			}
+			got += (u32)n;
+		} while((u32)n == mps && got < length);
+		n = hostOut(0, NULL, 0);
+	} else {
+		for(n = 0; got < length && n >= 0; got += (u32)n) {
+			n = hostOut(0, data + got, length - got < mps ? length - got : mps);
+		}
+		n = n < 0 ? n : hostIn(0, hostBuf);
+	}
+	return n < 0 ? n : (int)(type & 0x80U ? got : 0U);
+}
+
+/* The packet size of the bulk endpoints of a configuration descriptor, 0 when they differ */
+static u32 configBulkPacket(const uint8_t *desc, u32 len, u32 *endpoints)
+{
+	u32 mps = 0;
+
+	*endpoints = 0;
+	for(u32 i = 0; i + 1U < len && desc[i] >= 2U; i += desc[i]) {
+		if(desc[i + 1U] == 0x05U && desc[i + 3U] == 0x02U) {
+			u32 m = desc[i + 4U] | ((u32)desc[i + 5U] << 8);
+
+			if(mps != 0 && m != mps) {
+				return 0;
+			}
+			mps = m;
+			(*endpoints)++;
+		}
+	}
+	return mps;
+}
+
+/* Read a configuration or other speed descriptor, returns its bulk packet size */
+static u32 hostConfigDesc(u32 type, uint8_t *desc)
+{
+	u32 endpoints = 0;
+	u32 mps = 0;
+	int n;
+
+	UNIT_CHECK(hostControl(0x80, 0x06, type << 8, 0, 9, desc) == 9 && desc[1] == type);
+	n = hostControl(0x80, 0x06, type << 8, 0, desc[2] | ((u32)desc[3] << 8), desc);
+	UNIT_CHECK(n > 0 && (u32)n == (desc[2] | ((u32)desc[3] << 8)) && desc[4] == 3);
+	if(n > 0) {
+		mps = configBulkPacket(desc, (u32)n, &endpoints);
+	}
+	UNIT_CHECK(endpoints == 3);
+	return mps;
+}
+
+/* Enumerate and open both channels, returns the bulk packet size of the configuration */
+static u32 hostEnumerate(u32 *stalls)
+{
+	static const uint8_t coding[7] = { 0x00, 0x10, 0x0E, 0x00, 0, 0, 8 };	/* 921600 8N1 */
+	uint8_t desc[256];
+	u32 mps;
+	int n;
+
+	n = hostControl(0x80, 0x06, 0x0100, 0, 64, desc);
+	UNIT_CHECK(n == 18 && desc[1] == 0x01 && desc[7] == 64);
+	UNIT_CHECK((desc[8] | (desc[9] << 8)) == USBCDC_VID && (desc[10] | (desc[11] << 8)) == USBCDC_PID);
+	UNIT_CHECK(hostControl(0x00, 0x05, 12, 0, 0, NULL) == 0);
+	UNIT_CHECK(deviceAddr == ((12U << XUSBPS_DEVICEADDR_ADDR_SHIFT) | XUSBPS_DEVICEADDR_DEVICEAADV_MASK));
+	mps = hostConfigDesc(0x02, desc);
+	n = hostControl(0x80, 0x06, 0x0300, 0, 255, desc);
+	UNIT_CHECK(n == 4 && desc[2] == 0x09 && desc[3] == 0x04);
+	n = hostControl(0x80, 0x06, 0x0302, 0x0409, 255, desc);
+	UNIT_CHECK(n == 2 + 2 * 9 && desc[0] == n && desc[2] == 'S' && desc[3] == 0 && desc[18] == 'h');
+
+	/* An unknown request stalls ep0, the next setup clears it */
+	UNIT_CHECK(hostControl(0x80, 0x06, 0x0900, 0, 64, desc) == HOST_STALL);
+	UNIT_CHECK(hostControl(0x80, 0x06, 0x0309, 0x0409, 64, desc) == HOST_STALL);
+	*stalls = 2;
+
+	UNIT_CHECK(hostControl(0x00, 0x09, 1, 0, 0, NULL) == 0);
+	UNIT_CHECK(hostControl(0x80, 0x08, 0, 0, 1, desc) == 1 && desc[0] == 1);
+	UNIT_CHECK(hostControl(0x21, 0x20, 0, 0, 7, (uint8_t *)coding) == 0);
+	UNIT_CHECK(hostControl(0xA1, 0x21, 0, 0, 7, desc) == 7 && memcmp(desc, coding, 7) == 0);
+	UNIT_CHECK(!usbcdcIsOpen() && !usbcdcTraceIsOpen());
+	UNIT_CHECK(hostControl(0x21, 0x22, 0x0003, 0, 0, NULL) == 0);
+	UNIT_CHECK(hostControl(0x41, USBCDC_REQ_TRACE, 1, USBCDC_TRACE_INTERFACE, 0, NULL) == 0);
+	UNIT_CHECK(usbcdcIsOpen() && usbcdcTraceIsOpen());
+	return mps;
+}
+
+/* Serial port input in packets of at most mps, a zero length packet ends whole packets */
+static void hostSerialOut(const uint8_t *data, u32 len, u32 mps)
+{
+	for(u32 off = 0; off < len; off += mps) {
+		u32 n = len - off < mps ? len - off : mps;
+
+		UNIT_CHECK(hostOut(USB_TEST_EP_ACM, data + off, n) == (int)n);
+		udcFrame();
+	}
+	if(len % mps == 0) {
+		UNIT_CHECK(hostOut(USB_TEST_EP_ACM, NULL, 0) == 0);
+		udcFrame();
+	}
+	udcCheckOut();
+}
+
+static void checkThroughout(void)
+{
+	UNIT_CHECK(acm.errors == 0 && trace.errors == 0);
+	UNIT_CHECK(asserts == 0 && strayAccesses == 0);
+}
+
+static void testInit(void)
+{
+	u32 itc;
+
+	UNIT_CHECK(usbcdcInit() == XST_SUCCESS);
+	itc = (usbcmd & XUSBPS_CMD_ITC_MASK) >> 16;
+	UNIT_CHECK((usbMode & XUSBPS_MODE_CM_MASK) == XUSBPS_MODE_CM_DEVICE_MASK);
+	UNIT_CHECK(usbcmd & XUSBPS_CMD_RS_MASK);
+	UNIT_CHECK(itc <= XUSBPS_CMD_ITHRESHOLD_1);
+	UNIT_CHECK(usbintr == (XUSBPS_IXR_UR_MASK | XUSBPS_IXR_UI_MASK));
+	UNIT_CHECK(irqEnabled && irqId == XPAR_XUSBPS_0_INTR);
+	UNIT_CHECK(udcMaxPacket(0, 0) == 64 && udcMaxPacket(0, 1) == 64);
+	UNIT_CHECK(rd32(udcQh(0, 0), XUSBPS_dQHCFG) & XUSBPS_dQHCFG_IOS_MASK);
+	for(u32 ep = 0; ep < USB_TEST_EPS; ep++) {
+		UNIT_CHECK(rd32(udcQh(ep, 1), XUSBPS_dQHCFG) & XUSBPS_dQHCFG_ZLT_MASK);
+	}
+	checkThroughout();
+	unitResult("init", "queue heads at 0x%08x, interrupt threshold %u microframes", (unsigned)epListAddr,
+			(unsigned)itc);
+}
+
+static void testEnum(void)
+{
+	u32 stalls;
+	u32 mps = hostEnumerate(&stalls);
+
+	UNIT_CHECK(mps == 512U);
+	UNIT_CHECK(udcMaxPacket(USB_TEST_EP_ACM, 0) == 512U && udcMaxPacket(USB_TEST_EP_ACM, 1) == 512U);
+	UNIT_CHECK(udcMaxPacket(USB_TEST_EP_TRACE, 1) == 512U);
+	UNIT_CHECK(udcEps[USB_TEST_EP_ACM][0].ready);
+	checkThroughout();
+	unitResult("enum", "high speed, %u byte bulk packets, %u requests stalled, %u dTDs executed", (unsigned)mps,
+			(unsigned)stalls, (unsigned)dtdsChecked);
+}
+
+static void testSerial(void)
+{
+	UsbCdcStats_t before, after;
+	uint8_t in[1024];
+	uint8_t got[USBCDC_RX_BUF_SIZE];
+	u32 mps = udcMaxPacket(USB_TEST_EP_ACM, 0);
+	u32 transfers;
+	u32 n;
+
+	usbcdcGetStats(&before);
+
+	/* A lone line goes out at once */
+	streamWrite(&acm, usbcdcWrite, 7);
+	UNIT_CHECK(hostBulkIn(USB_TEST_EP_ACM, &acm, 1) == 1 && acm.transfers == 1);
+	udcFrame();
+
+	/* Lines written during a transfer leave as one */
+	streamWrite(&acm, usbcdcWrite, 700);
+	UNIT_CHECK(hostBulkIn(USB_TEST_EP_ACM, &acm, 1) == 1);
+	for(u32 i = 0; i < 10; i++) {
+		streamWrite(&acm, usbcdcWrite, 80);
+	}
+	hostDrain(USB_TEST_EP_ACM, &acm);
+	UNIT_CHECK(acm.transfers == 3 && acm.zlps == 0);
+
+	/* Whole packets end with a zero length packet */
+	streamWrite(&acm, usbcdcWrite, 2 * mps);
+	hostDrain(USB_TEST_EP_ACM, &acm);
+	UNIT_CHECK(acm.transfers == 4 && acm.zlps == 1);
+
+	/* Both buffers full: one transfer in flight, the other buffer takes what fits */
+	transfers = acm.transfers;
+	UNIT_CHECK(streamWrite(&acm, usbcdcWrite, 100) == 100);
+	UNIT_CHECK(streamWrite(&acm, usbcdcWrite, 2 * USBCDC_TX_BUF_SIZE) == USBCDC_TX_BUF_SIZE);
+	hostDrain(USB_TEST_EP_ACM, &acm);
+	UNIT_CHECK(acm.transfers == transfers + 2);
+
+	/* Closed port */
+	UNIT_CHECK(hostControl(0x21, 0x22, 0x0000, 0, 0, NULL) == 0);
+	UNIT_CHECK(!usbcdcIsOpen() && streamWrite(&acm, usbcdcWrite, 10) == 0);
+	UNIT_CHECK(hostControl(0x21, 0x22, 0x0001, 0, 0, NULL) == 0);
+
+	/* Input through both OUT dTDs, then past the end of the ring */
+	for(u32 i = 0; i < sizeof(in); i++) {
+		in[i] = streamByte(i + 77U);
+	}
+	hostSerialOut(in, 300, mps);
+	hostSerialOut(in + 300, mps, mps);
+	n = usbcdcRead(got, sizeof(got));
+	UNIT_CHECK(n == USBCDC_RX_BUF_SIZE && memcmp(got, in, n) == 0);
+	UNIT_CHECK(usbcdcRead(got, sizeof(got)) == 0);
+	hostSerialOut(in + 812, 100, mps);
+	n = usbcdcRead(got, 60);
+	n += usbcdcRead(got + 60, sizeof(got) - 60);
+	UNIT_CHECK(n == 100 && memcmp(got, in + 812, 100) == 0);
+
+	usbcdcGetStats(&after);
+	UNIT_CHECK(after.ulTxBytes - before.ulTxBytes == acm.accepted);
+	UNIT_CHECK(after.ulTxDropped - before.ulTxDropped == USBCDC_TX_BUF_SIZE);
+	UNIT_CHECK(after.ulTransfers - before.ulTransfers == acm.transfers);
+	UNIT_CHECK(acm.received == acm.accepted);
+	UNIT_CHECK(after.ulRxBytes - before.ulRxBytes == USBCDC_RX_BUF_SIZE + 100U);
+	UNIT_CHECK(after.ulRxDropped - before.ulRxDropped == 300U + mps - USBCDC_RX_BUF_SIZE);
+	checkThroughout();
+	unitResult("serial", "%u bytes out in %u transfers, %u dropped, %u bytes in, %u dropped",
+			(unsigned)acm.received, (unsigned)acm.transfers, (unsigned)(after.ulTxDropped - before.ulTxDropped),
+			(unsigned)(after.ulRxBytes - before.ulRxBytes), (unsigned)(after.ulRxDropped - before.ulRxDropped));
+}
+
+static void testReset(void)
+{
+	static const uint8_t getDevice[8] = { 0x80, 0x06, 0x00, 0x01, 0x00, 0x00, 0x40, 0x00 };
+	UsbCdcStats_t before, after;
+	u32 stalls;
+	u32 mps;
+
+	usbcdcGetStats(&before);
+
+	/* The host resets the bus before reading the reply to a request, and during a trace transfer */
+	udcSetup(getDevice);
+	udcFrame();
+	streamWrite(&trace, usbcdcTraceWrite, 5000);
+	UNIT_CHECK(hostBulkIn(USB_TEST_EP_TRACE, &trace, 2) == 2);
+	udcBusReset(PORTSC_SPEED_HS);
+	streamDiscard(&trace);
+	UNIT_CHECK(!usbcdcIsOpen() && !usbcdcTraceIsOpen());
+	UNIT_CHECK(streamWrite(&trace, usbcdcTraceWrite, 100) == 0);
+
+	mps = hostEnumerate(&stalls);
+	UNIT_CHECK(mps == 512U);
+	streamWrite(&trace, usbcdcTraceWrite, 3000);
+	streamWrite(&acm, usbcdcWrite, 40);
+	hostDrain(USB_TEST_EP_TRACE, &trace);
+	hostDrain(USB_TEST_EP_ACM, &acm);
+
+	usbcdcGetStats(&after);
+	UNIT_CHECK(after.ulBusResets - before.ulBusResets == 1);
+	UNIT_CHECK(trace.received + trace.lost == trace.accepted && trace.received == 2 * 512U + 3000U);
+	UNIT_CHECK(acm.received == acm.accepted);
+	checkThroughout();
+	unitResult("reset", "%u trace bytes lost with the bus reset, %u received after it", (unsigned)trace.lost,
+			(unsigned)(trace.received - 2 * 512U));
+}
+
+/* The trace writer offers bytesPerFrame each microframe, returns the received rate in kB/s */
+static u32 traceRun(u32 bytesPerFrame, u32 frames)
+{
+	u32 received = trace.received;
+
+	for(u32 f = 0; f < frames; f++) {
+		for(u32 n = 0; n < bytesPerFrame; n += USB_TEST_TRACE_CHUNK) {
+			streamWrite(&trace, usbcdcTraceWrite, USB_TEST_TRACE_CHUNK);
+		}
+		hostBulkIn(USB_TEST_EP_TRACE, &trace, USB_TEST_PACKETS_PER_FRAME);
+		udcFrame();
+	}
+	received = trace.received - received;
+	hostDrain(USB_TEST_EP_TRACE, &trace);
+	return (u32)((uint64_t)received * USB_TEST_FRAMES_PER_S / frames / 1000U);
+}
+
+static void testTrace(void)
+{
+	UsbCdcStats_t before, after;
+	u32 lossless, overload;
+	u32 dropped;
+
+	usbcdcGetStats(&before);
+	lossless = traceRun(USB_TEST_TRACE_LOSSLESS, USB_TEST_TRACE_FRAMES);
+	usbcdcGetStats(&after);
+	UNIT_CHECK(after.ulTraceDropped == before.ulTraceDropped);
+
+	overload = traceRun(USB_TEST_TRACE_OVERLOAD, USB_TEST_TRACE_FRAMES);
+	usbcdcGetStats(&after);
+	dropped = after.ulTraceDropped - before.ulTraceDropped;
+	UNIT_CHECK(overload >= USB_TEST_TRACE_MIN_KBPS);
+	UNIT_CHECK(after.ulTraceBytes - before.ulTraceBytes + dropped ==
+			(USB_TEST_TRACE_LOSSLESS + USB_TEST_TRACE_OVERLOAD) * USB_TEST_TRACE_FRAMES);
+	UNIT_CHECK(trace.received + trace.lost == trace.accepted);
+	checkThroughout();
+	unitResult("trace", "%u kB/s offered, %u kB/s lossless; %u kB/s offered, %u kB/s received, %u%% dropped",
+			(unsigned)(USB_TEST_TRACE_LOSSLESS * USB_TEST_FRAMES_PER_S / 1000U), (unsigned)lossless,
+			(unsigned)(USB_TEST_TRACE_OVERLOAD * USB_TEST_FRAMES_PER_S / 1000U), (unsigned)overload,
+			(unsigned)((uint64_t)dropped * 100U / ((uint64_t)USB_TEST_TRACE_OVERLOAD * USB_TEST_TRACE_FRAMES)));
+}
+
+static void testFullSpeed(void)
+{
+	uint8_t desc[256];
+	u32 stalls;
+	u32 mps;
+	u32 zlps;
+
+	udcBusReset(PORTSC_SPEED_FS);
+	streamDiscard(&acm);
+	streamDiscard(&trace);
+	mps = hostEnumerate(&stalls);
+	UNIT_CHECK(mps == 64U);
+	UNIT_CHECK(udcMaxPacket(USB_TEST_EP_ACM, 0) == 64U && udcMaxPacket(USB_TEST_EP_ACM, 1) == 64U);
+	UNIT_CHECK(udcMaxPacket(USB_TEST_EP_TRACE, 1) == 64U);
+	UNIT_CHECK(hostConfigDesc(0x07, desc) == 512U);
+
+	zlps = acm.zlps;
+	streamWrite(&acm, usbcdcWrite, 200);
+	hostDrain(USB_TEST_EP_ACM, &acm);
+	streamWrite(&acm, usbcdcWrite, 2 * mps);
+	hostDrain(USB_TEST_EP_ACM, &acm);
+	UNIT_CHECK(acm.zlps == zlps + 1 && acm.received + acm.lost == acm.accepted);
+	checkThroughout();
+	unitResult("fullspeed", "%u byte bulk packets, %u at high speed", (unsigned)mps, 512U);
+}
+
+int main(void)
+{
+	testInit();
+	testEnum();
+	testSerial();
+	testReset();
+	testTrace();
+	testFullSpeed();
+	printf("  %u interrupts in %u microframes\n", (unsigned)irqCalls, (unsigned)frame);
+	return unitExit();
+}
@@ -0,0 +1,371 @@
+/*
+ * Host test of the memory primitives of the standalone BSP (xil_mem.c and
+ * the secure wrappers of xil_util.c, copied to the build directory so that
+ * the stand-in headers apply).
+ *
+ * On the host XIL_MEM_IMPL selects the portable C version, the LDM/STM and
+ * NEON loops build for the A9 only; the head and tail handling around them
+ * is the same code. Every result is compared with the C library. Checks:
+ *
+ *  memcpy    every length up to 300 bytes and a few long ones, at every
+ *            source and destination offset within a doubleword
+ *  memset    the same lengths and offsets, with the values 0x00, 0x5A and
+ *            0xFF
+ *  memmove   overlapping copies in both directions at every distance up to
+ *            40 bytes, and disjoint ones
+ *  memcmp    Xil_MemCmp() orders like memcmp() for a difference at every
+ *            position and offset, equal buffers compare 0
+ *  ct        Xil_SMemCmp_CT() fails for a difference at every position and
+ *            in every bit, succeeds for equal buffers, checks its arguments
+ *  secure    Xil_SMemCpy(), Xil_SMemSet(), Xil_SMemMove() and
+ *            Xil_SecureMemCpy() copy, fill and move, and refuse invalid sizes
+ *            and overlaps without touching the destination
+ *
+ * Throughout, the bytes around a destination are left alone. Then the copy,
+ * fill and move rates are printed in GB/s for a few lengths and alignments,
+ * next to the C library. They are host figures and not checked.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "unit.h"
+#include "xil_types.h"
+#include "xil_mem.h"
+#include "xil_util.h"
+#include "xstatus.h"
+
+#define MEM_TEST_MAX		300U	/* Every length up to this */
+#define MEM_TEST_GUARD		64U		/* Bytes checked around a destination */
+#define MEM_TEST_OFFSETS	8U
+#define MEM_TEST_BUF		(2U * 65536U + 2U * MEM_TEST_GUARD)
+#define MEM_TEST_FILL		0xA5U
+#define MEM_TEST_BENCH_MAX	(1U << 20)
+#define MEM_TEST_BENCH_BYTES	(64U << 20)	/* Moved per rate figure */
+
+static const u32 longLengths[] = { 1024U, 4095U, 4096U + 7U, 65536U };
+
+static uint8_t src[MEM_TEST_BUF] __attribute__((aligned(64)));
+static uint8_t dst[MEM_TEST_BUF] __attribute__((aligned(64)));
+static uint8_t ref[MEM_TEST_BUF] __attribute__((aligned(64)));
+static uint8_t benchSrc[MEM_TEST_BENCH_MAX + 64U] __attribute__((aligned(64)));
+static uint8_t benchDst[MEM_TEST_BENCH_MAX + 64U] __attribute__((aligned(64)));
+static u32 cases;
+
+static void pattern(uint8_t *p, u32 len, u32 seed)
+{
+	for(u32 i = 0; i < len; i++) {
+		seed = seed * 1103515245U + 12345U;
+		p[i] = (uint8_t)(seed >> 16);
+	}
+}
+
+/* Compares len bytes at off of dst with ref, and the guards around them */
+static int sameAround(u32 off, u32 len)
+{
+	return memcmp(&dst[off - MEM_TEST_GUARD], &ref[off - MEM_TEST_GUARD], len + 2U * MEM_TEST_GUARD) == 0;
+}
+
+static void resetDst(void)
+{
+	memset(dst, MEM_TEST_FILL, sizeof(dst));
+	memset(ref, MEM_TEST_FILL, sizeof(ref));
+}
+
+static int copyCase(u32 len, u32 so, u32 doff)
+{
+	u32 d = MEM_TEST_GUARD + doff;
+
+	resetDst();
+	pattern(&src[so], len, len * 31U + so);
+	Xil_MemCpy(&dst[d], &src[so], len);
+	memcpy(&ref[d], &src[so], len);
+	cases++;
+	return sameAround(d, len);
+}
+
+static void testMemcpy(void)
+{
+	u32 bad = 0;
+
+	cases = 0;
+	for(u32 len = 0; len <= MEM_TEST_MAX; len++) {
+		for(u32 so = 0; so < MEM_TEST_OFFSETS; so++) {
+			for(u32 doff = 0; doff < MEM_TEST_OFFSETS; doff++) {
+				bad += copyCase(len, so, doff) ? 0U : 1U;
+			}
+		}
+	}
+	for(u32 i = 0; i < sizeof(longLengths) / sizeof(longLengths[0]); i++) {
+		for(u32 so = 0; so < MEM_TEST_OFFSETS; so++) {
+			bad += copyCase(longLengths[i], so, (so * 3U) % MEM_TEST_OFFSETS) ? 0U : 1U;
+		}
+	}
+	UNIT_CHECK(bad == 0U);
+	unitResult("memcpy", "%u copies, %u wrong", cases, bad);
+}
+
+static int fillCase(u32 len, u8 val, u32 doff)
+{
+	u32 d = MEM_TEST_GUARD + doff;
+
+	resetDst();
+	Xil_MemSet(&dst[d], val, len);
+	memset(&ref[d], val, len);
+	cases++;
+	return sameAround(d, len);
+}
+
+static void testMemset(void)
+{
+	static const u8 values[] = { 0x00U, 0x5AU, 0xFFU };
+	u32 bad = 0;
+
+	cases = 0;
+	for(u32 v = 0; v < sizeof(values); v++) {
+		for(u32 len = 0; len <= MEM_TEST_MAX; len++) {
+			for(u32 doff = 0; doff < MEM_TEST_OFFSETS; doff++) {
+				bad += fillCase(len, values[v], doff) ? 0U : 1U;
+			}
+		}
+		for(u32 i = 0; i < sizeof(longLengths) / sizeof(longLengths[0]); i++) {
+			bad += fillCase(longLengths[i], values[v], i) ? 0U : 1U;
+		}
+	}
+	UNIT_CHECK(bad == 0U);
+	unitResult("memset", "%u fills, %u wrong", cases, bad);
+}
+
+/* Moves len bytes by dist within dst (negative: down), the same in ref */
+static int moveCase(u32 len, u32 base, int dist)
+{
+	u32 from = MEM_TEST_GUARD + base;
+	u32 to = (u32)((int)from + dist);
+	u32 lo = from < to ? from : to;
+
+	pattern(&dst[MEM_TEST_GUARD], MEM_TEST_MAX + 2U * MEM_TEST_OFFSETS, len + base);
+	memcpy(ref, dst, sizeof(ref));
+	Xil_MemMove(&dst[to], &dst[from], len);
+	memmove(&ref[to], &ref[from], len);
+	cases++;
+	return sameAround(lo, len + (u32)(dist < 0 ? -dist : dist));
+}
+
+static void testMemmove(void)
+{
+	u32 bad = 0;
+
+	cases = 0;
+	resetDst();
+	for(u32 len = 0; len <= 2U * 40U; len++) {
+		for(u32 base = 0; base < MEM_TEST_OFFSETS; base++) {
+			for(int dist = -40; dist <= 40; dist++) {
+				bad += moveCase(len, base + 40U, dist) ? 0U : 1U;
+			}
+		}
+	}
+	for(u32 base = 0; base < MEM_TEST_OFFSETS; base++) {
+		bad += moveCase(MEM_TEST_MAX / 2U, base, MEM_TEST_MAX / 2U + base) ? 0U : 1U;
+		bad += moveCase(MEM_TEST_MAX / 2U, MEM_TEST_MAX / 2U + base, -(int)(MEM_TEST_MAX / 2U)) ? 0U : 1U;
+	}
+	UNIT_CHECK(bad == 0U);
+	unitResult("memmove", "%u moves, %u wrong", cases, bad);
+}
+
+static int sign(int v)
+{
+	return v > 0 ? 1 : v < 0 ? -1 : 0;
+}
+
+static void testMemcmp(void)
+{
+	u32 bad = 0;
+
+	cases = 0;
+	for(u32 len = 1; len <= 70U; len++) {
+		for(u32 off = 0; off < MEM_TEST_OFFSETS; off++) {
+			uint8_t *a = &src[off];
+			uint8_t *b = &dst[(off * 5U) % MEM_TEST_OFFSETS];
+
+			pattern(a, len, len);
+			memcpy(b, a, len);
+			bad += Xil_MemCmp(a, b, len) == 0 ? 0U : 1U;
+			for(u32 pos = 0; pos < len; pos++) {
+				uint8_t keep = b[pos];
+
+				b[pos] = (uint8_t)(keep + 1U + (pos & 0x7FU));
+				bad += Xil_MemCmp(a, b, len) == sign(memcmp(a, b, len)) ? 0U : 1U;
+				bad += Xil_MemCmp(b, a, len) == sign(memcmp(b, a, len)) ? 0U : 1U;
+				b[pos] = keep;
+				cases += 2U;
+			}
+		}
+	}
+	/* The bytes decide the order, not the words they are in */
+	memcpy(dst, "\x01\x00\x00\x00", 4U);
+	memcpy(src, "\x00\x00\x00\x02", 4U);
+	UNIT_CHECK(Xil_MemCmp(dst, src, 4U) == 1);
+	UNIT_CHECK(Xil_MemCmp(src, dst, 4U) == -1);
+	UNIT_CHECK(bad == 0U);
+	unitResult("memcmp", "%u differences ordered, %u wrong", cases, bad);
+}
+
+static void testCt(void)
+{
+	u32 bad = 0;
+
+	cases = 0;
+	for(u32 len = 1; len <= 70U; len++) {
+		for(u32 off = 0; off < MEM_TEST_OFFSETS; off += 3U) {
+			uint8_t *a = &src[off];
+			uint8_t *b = &dst[off & 4U];
+
+			pattern(a, len, len + off);
+			memcpy(b, a, len);
+			bad += Xil_SMemCmp_CT(a, len, b, len, len) == XST_SUCCESS ? 0U : 1U;
+			for(u32 pos = 0; pos < len; pos++) {
+				for(u32 bit = 0; bit < 8U; bit++) {
+					b[pos] ^= (uint8_t)(1U << bit);
+					bad += Xil_SMemCmp_CT(a, len, b, len, len) != XST_SUCCESS ? 0U : 1U;
+					b[pos] ^= (uint8_t)(1U << bit);
+					cases++;
+				}
+			}
+		}
+	}
+	UNIT_CHECK(Xil_SMemCmp_CT(NULL, 8U, dst, 8U, 8U) == XST_INVALID_PARAM);
+	UNIT_CHECK(Xil_SMemCmp_CT(src, 8U, dst, 8U, 0U) == XST_INVALID_PARAM);
+	UNIT_CHECK(Xil_SMemCmp_CT(src, 7U, dst, 8U, 8U) == XST_INVALID_PARAM);
+	UNIT_CHECK(Xil_SMemCmp_CT(src, 8U, dst, 7U, 8U) == XST_INVALID_PARAM);
+	UNIT_CHECK(bad == 0U);
+	unitResult("ct", "%u differences found, %u missed", cases, bad);
+}
+
+static void testSecure(void)
+{
+	u32 d = MEM_TEST_GUARD + 3U;
+	u32 bad = 0;
+
+	cases = 0;
+	for(u32 len = 1; len <= 100U; len++) {
+		resetDst();
+		pattern(&src[1], len, len);
+		bad += Xil_SMemCpy(&dst[d], len, &src[1], len, len) == XST_SUCCESS ? 0U : 1U;
+		memcpy(&ref[d], &src[1], len);
+		bad += sameAround(d, len) ? 0U : 1U;
+
+		bad += Xil_SMemSet(&dst[d], len, 0x3CU, len) == XST_SUCCESS ? 0U : 1U;
+		memset(&ref[d], 0x3C, len);
+		bad += sameAround(d, len) ? 0U : 1U;
+
+		bad += Xil_SecureMemCpy(&dst[d], len, &src[1], len) == XST_SUCCESS ? 0U : 1U;
+		memcpy(&ref[d], &src[1], len);
+		bad += sameAround(d, len) ? 0U : 1U;
+
+		bad += Xil_SMemMove(&dst[d + 1U], len, &dst[d], len, len) == XST_SUCCESS ? 0U : 1U;
+		memmove(&ref[d + 1U], &ref[d], len);
+		bad += sameAround(d, len + 1U) ? 0U : 1U;
+		cases += 4U;
+	}
+
+	/* Refused without a write */
+	resetDst();
+	UNIT_CHECK(Xil_SMemCpy(&dst[d], 8U, src, 16U, 16U) == XST_INVALID_PARAM);
+	UNIT_CHECK(Xil_SMemCpy(&dst[d], 16U, src, 8U, 16U) == XST_INVALID_PARAM);
+	UNIT_CHECK(Xil_SMemCpy(&dst[d], 16U, &dst[d + 8U], 16U, 16U) == XST_INVALID_PARAM);
+	UNIT_CHECK(Xil_SMemCpy(&dst[d + 8U], 16U, &dst[d], 16U, 16U) == XST_INVALID_PARAM);
+	UNIT_CHECK(Xil_SMemCpy(&dst[d], 16U, NULL, 16U, 16U) == XST_INVALID_PARAM);
+	UNIT_CHECK(Xil_SMemSet(&dst[d], 8U, 0U, 16U) == XST_INVALID_PARAM);
+	UNIT_CHECK(Xil_SMemSet(&dst[d], 8U, 0U, 0U) == XST_INVALID_PARAM);
+	UNIT_CHECK(Xil_SMemMove(&dst[d], 8U, src, 16U, 16U) == XST_INVALID_PARAM);
+	UNIT_CHECK(sameAround(d, 32U));
+	/* Xil_SecureMemCpy() clears a destination too short instead */
+	UNIT_CHECK(Xil_SecureMemCpy(&dst[d], 8U, src, 16U) == XST_FAILURE);
+	memset(&ref[d], 0, 8U);
+	UNIT_CHECK(sameAround(d, 8U));
+
+	UNIT_CHECK(bad == 0U);
+	unitResult("secure", "%u calls, %u wrong", cases, bad);
+}
+
+static double seconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+typedef enum {
+	BENCH_XIL_MEMCPY,
+	BENCH_MEMCPY,
+	BENCH_XIL_MEMSET,
+	BENCH_MEMSET,
+	BENCH_XIL_MEMMOVE,
+	BENCH_MEMMOVE
+} BenchFn;
+
+static const char *const benchNames[] = {
+	"Xil_MemCpy", "memcpy", "Xil_MemSet", "memset", "Xil_MemMove", "memmove"
+};
+
+/* GB/s of fn moving len bytes, the destination at doff and the source at soff */
+static double benchRate(BenchFn fn, u32 len, u32 doff, u32 soff)
+{
+	uint8_t *d = &benchDst[doff];
+	const uint8_t *s = &benchSrc[soff];
+	u32 rounds = MEM_TEST_BENCH_BYTES / len;
+	double start = seconds();
+
+	for(u32 i = 0; i < rounds; i++) {
+		switch(fn) {
+		case BENCH_XIL_MEMCPY:
+			Xil_MemCpy(d, s, len);
+			break;
+		case BENCH_MEMCPY:
+			memcpy(d, s, len);
+			break;
+		case BENCH_XIL_MEMSET:
+			Xil_MemSet(d, (u8)i, len);
+			break;
+		case BENCH_MEMSET:
+			memset(d, (int)(i & 0xFFU), len);
+			break;
+		case BENCH_XIL_MEMMOVE:
+			Xil_MemMove(d + 8U, d, len - 8U);
+			break;
+		case BENCH_MEMMOVE:
+			memmove(d + 8U, d, len - 8U);
+			break;
+		}
+		__asm__ __volatile__("" : : "r" (d) : "memory");
+	}
+	return (double)rounds * len / (seconds() - start) * 1e-9;
+}
+
+static void bench(void)
+{
+	static const u32 lengths[] = { 64U, 512U, 4096U, 65536U, MEM_TEST_BENCH_MAX };
+
+	pattern(benchSrc, sizeof(benchSrc), 1U);
+	printf("  GB/s on the host  %8s %8s %8s %8s\n", "aligned", "dst+1", "src+1", "both+3");
+	for(u32 fn = BENCH_XIL_MEMCPY; fn <= BENCH_MEMMOVE; fn++) {
+		for(u32 i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+			printf("  %-11s %7u %8.2f %8.2f %8.2f %8.2f\n", benchNames[fn], lengths[i],
+				benchRate((BenchFn)fn, lengths[i], 0U, 0U), benchRate((BenchFn)fn, lengths[i], 1U, 0U),
+				benchRate((BenchFn)fn, lengths[i], 0U, 1U), benchRate((BenchFn)fn, lengths[i], 3U, 3U));
+		}
+	}
+}
+
+int main(void)
+{
+	testMemcpy();
+	testMemset();
+	testMemmove();
+	testMemcmp();
+	testCt();
+	testSecure();
+	bench();
+	return unitExit();
+}
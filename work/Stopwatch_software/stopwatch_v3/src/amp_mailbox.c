@@ -0,0 +1,85 @@
+/*
+ * Lock-free SPSC mailbox shared by CPU0 and CPU1, see amp_mailbox.h.
+ */
+
+#include <string.h>
+#include "xil_io.h"
+#include "xil_mmu.h"
+#include "xpseudo_asm.h"
+#include "amp_mailbox.h"
+
+/* Mark the OCM section holding the mailbox as shareable and non-cacheable, the
+ * two cores do not run in SMP mode so their L1 caches are not kept coherent.
+ * Must be called by both cores before touching the mailbox.
+ */
+void ampMapSharedMemory(void)
+{
+	Xil_SetTlbAttributes(AMP_MAILBOX_BASEADDR, NORM_NONCACHE);
+}
+
+/* Called once by CPU0 before CPU1 is released */
+void ampMailboxInit(void)
+{
+	AmpMailbox *mailbox = AMP_MAILBOX;
+
+	ampMapSharedMemory();
+	memset((void *)mailbox, 0, sizeof(AmpMailbox));
+	dmb();
+	mailbox->magic = AMP_MAILBOX_MAGIC;
+	dsb();
+}
+
+bool ampMailboxIsReady(void)
+{
+	return AMP_MAILBOX->magic == AMP_MAILBOX_MAGIC;
+}
+
+/* Producer side. Returns false if the ring is full, the message is dropped. */
+bool ampRingPush(AmpRing *ring, const AmpMessage *msg)
+{
+	uint32_t head = ring->head;
+
+	if((head - ring->tail) >= AMP_MAILBOX_SLOTS) {
+		return false;
+	}
+
+	ring->slots[head & (AMP_MAILBOX_SLOTS - 1U)] = *msg;
+	/* The slot must be visible before the consumer can see the new head */
+	dmb();
+	ring->head = head + 1U;
+	return true;
+}
+
+/* Consumer side. Returns false if the ring is empty. */
+bool ampRingPop(AmpRing *ring, AmpMessage *msg)
+{
+	uint32_t tail = ring->tail;
+
+	if(tail == ring->head) {
+		return false;
+	}
+
+	/* Do not read the slot before the head that published it */
+	dmb();
+	*msg = ring->slots[tail & (AMP_MAILBOX_SLOTS - 1U)];
+	dmb();
+	ring->tail = tail + 1U;
+	return true;
+}
+
+/* Raise the doorbell SGI on the cores in cpuMask (XSCUGIC_SPI_CPUx_MASK) */
+void ampRingDoorbell(XScuGic *gic, uint32_t doorbell, uint32_t cpuMask)
+{
+	dsb();
+	XScuGic_SoftwareIntr(gic, doorbell, cpuMask);
+}
+
+/* Release CPU1 from the boot ROM wait loop and let it jump to its image */
+void ampStartCpu1(void)
+{
+	Xil_Out32(AMP_CPU1_START_VECTOR, AMP_CPU1_START_ADDR);
+	dsb();
+#if !STOPWATCH_SIM
+	__asm__ __volatile__("sev");
+#endif
+}
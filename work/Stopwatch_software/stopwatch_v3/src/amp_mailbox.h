@@ -0,0 +1,68 @@
+/*
+ * Inter-core mailbox for the AMP build of the stopwatch.
+ *
+ * CPU0 (FreeRTOS) handles the buttons, LEDs and UART display. CPU1 (bare-metal)
+ * owns the AXI timer and runs the capture/timekeeping loop. The two cores talk
+ * through two single-producer/single-consumer rings placed in the high OCM,
+ * which neither linker script uses. Each ring has exactly one writer for head
+ * and one writer for tail, so no lock is needed; the producer can ring a
+ * software generated interrupt (SGI) on the other core as a doorbell.
+ */
+
+#ifndef AMP_MAILBOX_H
+#define AMP_MAILBOX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "xscugic.h"
+
+#define AMP_MAILBOX_BASEADDR	0xFFFF0000U	/* High OCM, shared by both cores */
+#define AMP_MAILBOX_MAGIC		0x414D5031U	/* "AMP1", written once CPU0 initialized the rings */
+#define AMP_MAILBOX_SLOTS		16U			/* Must be a power of two */
+
+#define AMP_CPU1_START_ADDR		0x10000000U	/* Entry point of the CPU1 image (lscript_cpu1.ld) */
+#define AMP_CPU1_START_VECTOR	0xFFFFFFF0U	/* Address polled by CPU1 while waiting in the boot ROM */
+
+/* SGI numbers used as doorbells */
+#define AMP_DOORBELL_TO_CPU0	0U
+#define AMP_DOORBELL_TO_CPU1	1U
+
+/* Message types */
+#define AMP_MSG_BUTTON	1U	/* CPU0 -> CPU1, arg = button value */
+#define AMP_MSG_TIME	2U	/* CPU1 -> CPU0, time = 64-bit AXI timer value */
+
+typedef struct {
+	uint32_t type;
+	uint32_t arg;
+	uint64_t time;
+} AmpMessage;
+
+/* head is only written by the producer and tail only by the consumer. They are
+ * kept in separate 32 byte cache lines so the two cores never write the same line.
+ */
+typedef struct {
+	volatile uint32_t head;
+	uint32_t reserved0[7];
+	volatile uint32_t tail;
+	uint32_t reserved1[7];
+	AmpMessage slots[AMP_MAILBOX_SLOTS];
+} AmpRing;
+
+typedef struct {
+	volatile uint32_t magic;
+	uint32_t reserved[7];
+	AmpRing toCpu0;	/* capture events */
+	AmpRing toCpu1;	/* commands */
+} AmpMailbox;
+
+#define AMP_MAILBOX ((AmpMailbox *)AMP_MAILBOX_BASEADDR)
+
+void ampMailboxInit(void);
+bool ampMailboxIsReady(void);
+void ampMapSharedMemory(void);
+bool ampRingPush(AmpRing *ring, const AmpMessage *msg);
+bool ampRingPop(AmpRing *ring, AmpMessage *msg);
+void ampRingDoorbell(XScuGic *gic, uint32_t doorbell, uint32_t cpuMask);
+void ampStartCpu1(void);
+
+#endif /* AMP_MAILBOX_H */
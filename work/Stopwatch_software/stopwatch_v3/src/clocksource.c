@@ -0,0 +1,216 @@
+/*
+ * Clocksources: one read interface, mult/shift conversions and AXI timer
+ * drift tracking.
+ *
+ * A conversion by the ratio num/den is stored as value = (count * mult) >>
+ * shift, with the largest shift that keeps mult below 2^32. The product is
+ * formed from two 32x32 bit multiplies to 96 bits, so the result is the
+ * floor of the exact value for every 64-bit count that fits the result, and
+ * no division runs after clocksourceInit().
+ *
+ * Each clocksource holds two sets of scales and publishes one through a
+ * pointer. clocksourceSetFreq() rewrites the unpublished set and then swaps
+ * the pointer, so readers never lock and never see a half updated set. A
+ * reader only sees a torn set if it is delayed across two recalibrations,
+ * which are at least CLOCKSOURCE_DRIFT_WINDOW_MS apart.
+ *
+ * The global timer is the reference. While the AXI timer runs without being
+ * stopped, clocksourceDriftSample() compares the two over the whole run and
+ * reports the AXI timer's error in parts per billion. With
+ * CLOCKSOURCE_CALIBRATE the AXI conversions then use the measured frequency,
+ * which absorbs the rounding of the PL clock and of
+ * XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ.
+ */
+
+#include <stdint.h>
+#include "xparameters.h"
+#include "clocksource.h"
+
+#define NS_PER_SEC	1000000000ULL
+#define MS_PER_SEC	1000ULL
+
+#define CLOCKSOURCE_DRIFT_MIN_RUN	((uint64_t)COUNTS_PER_SECOND * CLOCKSOURCE_DRIFT_WINDOW_MS / 1000U)
+#define CLOCKSOURCE_DRIFT_MAX_PPB	1000000	/* Larger errors mean the timer was paused */
+
+static uint64_t clocksourceReadGlobal(const Clocksource_t *cs);
+static uint64_t clocksourceReadAxi(const Clocksource_t *cs);
+
+Clocksource_t clocksourceGlobal = { .name = "global", .read = clocksourceReadGlobal };
+Clocksource_t clocksourceAxi = { .name = "axi", .read = clocksourceReadAxi };
+
+/* AXI timer run being compared with the global timer */
+static struct {
+	int started;
+	uint64_t axiStart;
+	uint64_t globalStart;
+	uint64_t lastEval;		/* Global timer at the last evaluation */
+	ClockScale_t nominal;	/* Global timer counts to nominal AXI timer counts */
+} drift;
+
+static ClocksourceStats_t clocksourceStats;
+
+/* XTime_GetTime() already rereads the upper word until it is stable */
+static uint64_t clocksourceReadGlobal(const Clocksource_t *cs)
+{
+	(void)cs;
+	return clocksourceNow();
+}
+
+/* Because of the high clock frequency of IN/OUT (100 MHz) the AXI timer runs in
+ * 64-bit mode: TMRCTR0 and TMRCTR1 are cascaded, and TMRCTR1 counts the
+ * carries of TMRCTR0. The upper counter is read before and after the lower
+ * one, so a carry between the two reads cannot give a value 2^32 counts off.
+ */
+static uint64_t clocksourceReadAxi(const Clocksource_t *cs)
+{
+	uint32_t high, low, check;
+
+	if(cs->tmrCtr == NULL) {
+		return 0;
+	}
+
+	high = XTmrCtr_GetValue(cs->tmrCtr, 1);
+	do {
+		check = high;
+		low = XTmrCtr_GetValue(cs->tmrCtr, 0);
+		high = XTmrCtr_GetValue(cs->tmrCtr, 1);
+	} while(high != check);
+
+	return ((uint64_t)high << 32) | (uint64_t)low;
+}
+
+/* Scale for num/den with the most precision that keeps mult in 32 bits.
+ * mult is rounded up, so exact multiples of den/num do not convert to one
+ * unit less (a full second showing as 999 ms).
+ */
+static ClockScale_t clocksourceCalcScale(uint64_t num, uint64_t den)
+{
+	ClockScale_t scale = { 0, 0 };
+	uint64_t mult;
+
+	for(uint32_t shift = 63; shift > 0; shift--) {
+		if(num >> (64 - shift)) {
+			continue;	/* num << shift would overflow */
+		}
+		mult = ((num << shift) + den - 1) / den;
+		if(mult <= 0xFFFFFFFFULL) {
+			scale.mult = (uint32_t)mult;
+			scale.shift = shift;
+			break;
+		}
+	}
+	return scale;
+}
+
+uint64_t clocksourceScale(const ClockScale_t *scale, uint64_t count)
+{
+	uint32_t mult = scale->mult;
+	uint32_t shift = scale->shift;
+	uint64_t lo = (uint64_t)(uint32_t)count * mult;
+	uint64_t hi = (count >> 32) * mult;
+	uint64_t mid = (lo >> 32) + (uint32_t)hi;
+	uint64_t top = (hi >> 32) + (mid >> 32);	/* Bits 64 to 95 of the product */
+
+	mid = (uint32_t)mid;
+	if(shift >= 32) {
+		return (top << (64 - shift)) | (mid >> (shift - 32));
+	}
+	return (top << (64 - shift)) | (mid << (32 - shift)) | ((uint32_t)lo >> shift);
+}
+
+void clocksourceSetFreq(Clocksource_t *cs, uint32_t freq)
+{
+	ClockScales_t *next = (cs->current == &cs->scales[0]) ? &cs->scales[1] : &cs->scales[0];
+
+	next->freq = freq;
+	next->toNs = clocksourceCalcScale(NS_PER_SEC, freq);
+	next->fromNs = clocksourceCalcScale(freq, NS_PER_SEC);
+	next->toMs = clocksourceCalcScale(MS_PER_SEC, freq);
+
+	/* The set must be complete before it is published */
+	__sync_synchronize();
+	cs->current = next;
+}
+
+uint64_t clocksourceConvert(const Clocksource_t *from, const Clocksource_t *to, uint64_t count)
+{
+	return clocksourceFromNs(to, clocksourceToNs(from, count));
+}
+
+void clocksourceInit(XTmrCtr *axiTimer)
+{
+	clocksourceGlobal.current = &clocksourceGlobal.scales[1];
+	clocksourceSetFreq(&clocksourceGlobal, COUNTS_PER_SECOND);
+
+	clocksourceAxi.tmrCtr = axiTimer;
+	clocksourceAxi.current = &clocksourceAxi.scales[1];
+	clocksourceSetFreq(&clocksourceAxi, XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ);
+
+	clocksourceStats.ulAxiHz = XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ;
+	drift.nominal = clocksourceCalcScale(XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ, COUNTS_PER_SECOND);
+	drift.started = 0;
+}
+
+/* The AXI timer was stopped, started or reset: the run being measured ends */
+void clocksourceDriftReset(void)
+{
+	drift.started = 0;
+}
+
+/* Call often while the AXI timer runs, returns at once between evaluations */
+void clocksourceDriftSample(void)
+{
+	uint64_t before, after, axi, global;
+	uint64_t axiRun, globalRun, expected;
+	int64_t ppb;
+
+	before = clocksourceNow();
+	if(drift.started && before - drift.lastEval < CLOCKSOURCE_DRIFT_MIN_RUN) {
+		return;
+	}
+
+	/* Take the global time halfway through the AXI read */
+	axi = clocksourceRead(&clocksourceAxi);
+	after = clocksourceNow();
+	global = before + (after - before) / 2;
+
+	if(!drift.started) {
+		drift.started = 1;
+		drift.axiStart = axi;
+		drift.globalStart = global;
+		drift.lastEval = global;
+		return;
+	}
+	drift.lastEval = global;
+
+	/* AXI counts the nominal frequency gives over the same run */
+	axiRun = axi - drift.axiStart;
+	globalRun = global - drift.globalStart;
+	expected = clocksourceScale(&drift.nominal, globalRun);
+	ppb = ((int64_t)(axiRun - expected) * 1000000) / (int64_t)(expected / 1000U);
+	if(axi <= drift.axiStart || ppb > CLOCKSOURCE_DRIFT_MAX_PPB || ppb < -CLOCKSOURCE_DRIFT_MAX_PPB) {
+		/* Stopped or reset without a clocksourceDriftReset() */
+		drift.started = 0;
+		return;
+	}
+
+	clocksourceStats.lDriftPpb = (int32_t)ppb;
+	clocksourceStats.ulRunMs = (uint32_t)clocksourceToMs(&clocksourceGlobal, globalRun);
+	clocksourceStats.ulWindows++;
+
+#if CLOCKSOURCE_CALIBRATE
+	uint32_t freq = (uint32_t)(XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ +
+			((int64_t)XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ * ppb) / (int64_t)NS_PER_SEC);
+
+	if(freq != clocksourceFreq(&clocksourceAxi)) {
+		clocksourceSetFreq(&clocksourceAxi, freq);
+		clocksourceStats.ulAxiHz = freq;
+		clocksourceStats.ulCalibrations++;
+	}
+#endif
+}
+
+void clocksourceGetStats(ClocksourceStats_t *stats)
+{
+	*stats = clocksourceStats;
+}
@@ -0,0 +1,125 @@
+/*
+ * Clocksources and time conversions, see clocksource.c.
+ *
+ * Two free running counters are exposed through one interface:
+ *
+ *   clocksourceGlobal  the SCU global timer (COUNTS_PER_SECOND), always
+ *                      running, the time base of the logs and telemetry
+ *   clocksourceAxi     the cascaded 64-bit AXI timer, the stopwatch counter
+ *
+ * Counts are converted to and from nanoseconds, and to milliseconds, with a
+ * multiply and a shift instead of 64-bit divides. The AXI timer is compared
+ * with the global timer while it runs, and its frequency is recalibrated
+ * from the measured drift.
+ *
+ * Does not depend on FreeRTOS, so CPU1 uses it too.
+ */
+
+#ifndef CLOCKSOURCE_H
+#define CLOCKSOURCE_H
+
+#include <stdint.h>
+#if !STOPWATCH_SIM
+#include "xil_io.h"
+#endif
+#include "xtime_l.h"
+#include "xtmrctr.h"
+
+#ifndef CLOCKSOURCE_DRIFT_WINDOW_MS
+#define CLOCKSOURCE_DRIFT_WINDOW_MS	10000U	/* Minimum AXI timer run before the drift is evaluated */
+#endif
+
+#ifndef CLOCKSOURCE_CALIBRATE
+#define CLOCKSOURCE_CALIBRATE	1	/* 1: apply the measured AXI timer frequency to its conversions */
+#endif
+
+/* value = (count * mult) >> shift, mult < 2^32 */
+typedef struct {
+	uint32_t mult;
+	uint32_t shift;
+} ClockScale_t;
+
+typedef struct {
+	uint32_t freq;			/* Hz the scales were computed for */
+	ClockScale_t toNs;
+	ClockScale_t fromNs;
+	ClockScale_t toMs;
+} ClockScales_t;
+
+typedef struct Clocksource {
+	const char *name;
+	uint64_t (*read)(const struct Clocksource *cs);
+	XTmrCtr *tmrCtr;		/* AXI timer instance, NULL for the global timer */
+	ClockScales_t scales[2];
+	ClockScales_t *volatile current;	/* Published set, the other one is rewritten */
+} Clocksource_t;
+
+typedef struct {
+	uint32_t ulAxiHz;		/* Current AXI timer frequency, measured once calibrated */
+	int32_t lDriftPpb;		/* AXI timer against the global timer, over the last run */
+	uint32_t ulRunMs;		/* Length of that run */
+	uint32_t ulWindows;		/* Drift evaluations */
+	uint32_t ulCalibrations;
+} ClocksourceStats_t;
+
+extern Clocksource_t clocksourceGlobal;
+extern Clocksource_t clocksourceAxi;
+
+void clocksourceInit(XTmrCtr *axiTimer);
+void clocksourceSetFreq(Clocksource_t *cs, uint32_t freq);
+uint64_t clocksourceScale(const ClockScale_t *scale, uint64_t count);
+uint64_t clocksourceConvert(const Clocksource_t *from, const Clocksource_t *to, uint64_t count);
+void clocksourceDriftReset(void);
+void clocksourceDriftSample(void);
+void clocksourceGetStats(ClocksourceStats_t *stats);
+
+static inline uint64_t clocksourceRead(const Clocksource_t *cs)
+{
+	return cs->read(cs);
+}
+
+static inline uint32_t clocksourceFreq(const Clocksource_t *cs)
+{
+	return cs->current->freq;
+}
+
+static inline uint64_t clocksourceToNs(const Clocksource_t *cs, uint64_t count)
+{
+	return clocksourceScale(&cs->current->toNs, count);
+}
+
+static inline uint64_t clocksourceFromNs(const Clocksource_t *cs, uint64_t ns)
+{
+	return clocksourceScale(&cs->current->fromNs, ns);
+}
+
+static inline uint64_t clocksourceToMs(const Clocksource_t *cs, uint64_t count)
+{
+	return clocksourceScale(&cs->current->toMs, count);
+}
+
+/* Global timer, 64 bits */
+static inline uint64_t clocksourceNow(void)
+{
+	XTime now;
+
+	XTime_GetTime(&now);
+	return (uint64_t)now;
+}
+
+static inline uint64_t clocksourceNowNs(void)
+{
+	return clocksourceToNs(&clocksourceGlobal, clocksourceNow());
+}
+
+/* Low word of the global timer, one load, for 32-bit timestamps and intervals */
+static inline uint32_t clocksourceNow32(void)
+{
+#if STOPWATCH_SIM
+	return (uint32_t)clocksourceNow();
+#else
+	return Xil_In32(GLOBAL_TMR_BASEADDR + GTIMER_COUNTER_LOWER_OFFSET);
+#endif
+}
+
+#endif /* CLOCKSOURCE_H */
@@ -0,0 +1,248 @@
+/*
+ * Buffered, interrupt driven console.
+ *
+ * Replaces the BSP outbyte() so xil_printf() no longer busy-waits on the UART
+ * FIFO (about 87 us per character at 115200 baud). Once consoleInit() has run,
+ * characters are copied into a TX ring and the PS UART TX FIFO empty interrupt
+ * refills the 64 byte hardware FIFO from it. Before that, output stays polled
+ * like the BSP version, and the fatal hooks below flush the ring by polling.
+ *
+ * When the ring is full, CONSOLE_TX_POLICY selects whether the new bytes or the
+ * oldest queued bytes are discarded; both are counted in ConsoleStats_t.
+ *
+ * With CONSOLE_USB, output written while a host has the USB serial port open
+ * goes to usbcdcWrite() instead, and the UART stays idle. The fatal hooks go
+ * back to the UART, which can be drained by polling.
+ *
+ * The ring indices are free running and only touched with IRQs masked on this
+ * core (consoleLock()), which keeps writers in tasks, in nested interrupts and
+ * the TX handler apart without a critical section nesting count. The ring is
+ * not lock-free: the IRQ mask is its lock, held for the copy into the ring and
+ * at most one refill of the FIFO, and only this core writes to the console.
+ *
+ * xil_printf() calls outbyte() for each character, so each character goes
+ * through consoleWrite() on its own: the USB check, the IRQ mask and a one
+ * byte ring update, a few dozen instructions against the 87 us of a polled
+ * character. Output that is already in a buffer (dlog.c) is best passed to
+ * consoleWrite() whole.
+ */
+
+#ifndef STOPWATCH_AMP_CPU1
+
+#include <stdint.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xil_printf.h"
+#include "xparameters.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#include "xstatus.h"
+#include "xuartps_hw.h"
+#include "console.h"
+#if CONSOLE_USB
+#include "usbcdc.h"
+#endif
+
+#define CONSOLE_BASEADDR	STDOUT_BASEADDRESS
+#define CONSOLE_INTR		XPAR_XUARTPS_0_INTR	/* STDOUT_BASEADDRESS is UART0 */
+#define CONSOLE_TX_MASK		(CONSOLE_TX_BUFFER_SIZE - 1U)
+
+#if (CONSOLE_TX_BUFFER_SIZE & CONSOLE_TX_MASK) != 0
+#error CONSOLE_TX_BUFFER_SIZE must be a power of two
+#endif
+
+static char txRing[CONSOLE_TX_BUFFER_SIZE];
+static uint32_t txHead;	/* Next byte written by consoleWrite() */
+static uint32_t txTail;	/* Next byte moved to the UART FIFO */
+static uint32_t txActive;	/* TX empty interrupt armed */
+static volatile uint32_t consoleStarted;
+static volatile uint32_t consoleUartOnly;	/* Set by the fatal hooks */
+static ConsoleStats_t consoleStats;
+
+/* Masks IRQs on this core, an interrupt taken between the read and the write
+ * returns with the same CPSR. mtcpsr() is no compiler barrier, the empty asm
+ * keeps the ring accesses inside. */
+static inline uint32_t consoleLock(void)
+{
+	uint32_t cpsr = mfcpsr();
+
+	mtcpsr(cpsr | XREG_CPSR_IRQ_ENABLE);
+	__asm volatile ("" ::: "memory");
+	return cpsr;
+}
+
+static inline void consoleUnlock(uint32_t cpsr)
+{
+	__asm volatile ("" ::: "memory");
+	mtcpsr(cpsr);
+}
+
+/* Move queued bytes to the UART until the FIFO or the ring is empty, lock held */
+static void consoleFillFifo(void)
+{
+	while((txTail != txHead) && !XUartPs_IsTransmitFull(CONSOLE_BASEADDR)) {
+		XUartPs_WriteReg(CONSOLE_BASEADDR, XUARTPS_FIFO_OFFSET, (uint8_t)txRing[txTail & CONSOLE_TX_MASK]);
+		txTail++;
+	}
+}
+
+/* UART0 interrupt, only TX FIFO empty is enabled */
+static void consoleTxHandler(void *CallBackRef)
+{
+	uint32_t status;
+	uint32_t cpsr;
+
+	status = XUartPs_ReadReg(CONSOLE_BASEADDR, XUARTPS_IMR_OFFSET) &
+			XUartPs_ReadReg(CONSOLE_BASEADDR, XUARTPS_ISR_OFFSET);
+	XUartPs_WriteReg(CONSOLE_BASEADDR, XUARTPS_ISR_OFFSET, status);
+
+	if(status & XUARTPS_IXR_TXEMPTY) {
+		cpsr = consoleLock();
+		consoleFillFifo();
+		if(txTail == txHead) {
+			XUartPs_WriteReg(CONSOLE_BASEADDR, XUARTPS_IDR_OFFSET, XUARTPS_IXR_TXEMPTY);
+			txActive = 0;
+		}
+		consoleUnlock(cpsr);
+	}
+}
+
+/* Hook the UART0 interrupt, from now on outbyte() only queues */
+int consoleInit(void)
+{
+	XUartPs_WriteReg(CONSOLE_BASEADDR, XUARTPS_IDR_OFFSET, XUARTPS_IXR_TXEMPTY);
+	if(xPortInstallInterruptHandler(CONSOLE_INTR, consoleTxHandler, NULL) != pdPASS) {
+		return XST_FAILURE;
+	}
+	vPortEnableInterrupt(CONSOLE_INTR);
+	consoleStarted = 1;
+	return XST_SUCCESS;
+}
+
+/* Queue len bytes, the UART is only touched when the TX interrupt is idle */
+void consoleWrite(const char *buf, uint32_t len)
+{
+	uint32_t cpsr;
+	uint32_t room;
+	uint32_t used;
+	uint32_t offset;
+	uint32_t chunk;
+
+#if CONSOLE_USB
+	if(!consoleUartOnly && usbcdcIsOpen()) {
+		usbcdcWrite(buf, len);
+		return;
+	}
+#endif
+
+	if(!consoleStarted) {
+		while(len--) {
+			XUartPs_SendByte(CONSOLE_BASEADDR, *buf++);
+		}
+		return;
+	}
+
+	cpsr = consoleLock();
+	room = CONSOLE_TX_BUFFER_SIZE - (txHead - txTail);
+	if(len > room) {
+#if CONSOLE_TX_POLICY == CONSOLE_POLICY_OVERWRITE_OLDEST
+		if(len > CONSOLE_TX_BUFFER_SIZE) {
+			/* Only the tail of the message can survive */
+			consoleStats.ulBytesOverwritten += len - CONSOLE_TX_BUFFER_SIZE;
+			buf += len - CONSOLE_TX_BUFFER_SIZE;
+			len = CONSOLE_TX_BUFFER_SIZE;
+		}
+		if(len > room) {
+			consoleStats.ulBytesOverwritten += len - room;
+			txTail += len - room;
+		}
+#else
+		consoleStats.ulBytesDropped += len - room;
+		len = room;
+#endif
+	}
+
+	/* Copy in at most two pieces around the end of the ring */
+	offset = txHead & CONSOLE_TX_MASK;
+	chunk = CONSOLE_TX_BUFFER_SIZE - offset;
+	if(chunk > len) {
+		chunk = len;
+	}
+	memcpy(&txRing[offset], buf, chunk);
+	memcpy(txRing, buf + chunk, len - chunk);
+	txHead += len;
+	consoleStats.ulBytesQueued += len;
+
+	used = txHead - txTail;
+	if(used > consoleStats.ulHighWaterMark) {
+		consoleStats.ulHighWaterMark = used;
+	}
+
+	if(!txActive && (txTail != txHead)) {
+		/* Prime the FIFO, the TX empty interrupt takes over from here */
+		XUartPs_WriteReg(CONSOLE_BASEADDR, XUARTPS_ISR_OFFSET, XUARTPS_IXR_TXEMPTY);
+		consoleFillFifo();
+		XUartPs_WriteReg(CONSOLE_BASEADDR, XUARTPS_IER_OFFSET, XUARTPS_IXR_TXEMPTY);
+		txActive = 1;
+	}
+	consoleUnlock(cpsr);
+}
+
+/* Drain the ring by polling, usable with interrupts masked */
+void consoleFlush(void)
+{
+	uint32_t cpsr = consoleLock();
+
+	while(txTail != txHead) {
+		consoleFillFifo();
+	}
+	while(!(XUartPs_ReadReg(CONSOLE_BASEADDR, XUARTPS_SR_OFFSET) & XUARTPS_SR_TXEMPTY)) {
+	}
+	consoleUnlock(cpsr);
+}
+
+void consoleGetStats(ConsoleStats_t *stats)
+{
+	uint32_t cpsr = consoleLock();
+
+	*stats = consoleStats;
+	consoleUnlock(cpsr);
+}
+
+/* Overrides the polled BSP version used by xil_printf() */
+void outbyte(char c)
+{
+	consoleWrite(&c, 1);
+}
+
+/* The BSP hooks print and then spin with the TX interrupt masked, so the
+ * message has to be pushed out by polling before halting. */
+void vApplicationAssert(const char *pcFileName, uint32_t ulLine)
+{
+	volatile uint32_t ul = 0;
+
+	consoleUartOnly = 1;
+	xil_printf("Assert failed in file %s, line %lu\r\n", pcFileName, ulLine);
+	consoleFlush();
+
+	/* Set ul to a non-zero value from the debugger to step out */
+	taskENTER_CRITICAL();
+	while(ul == 0) {
+		__asm volatile ("NOP");
+	}
+	taskEXIT_CRITICAL();
+}
+
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
+{
+	(void)xTask;
+
+	consoleUartOnly = 1;
+	xil_printf("HALT: Task %s overflowed its stack.", pcTaskName);
+	consoleFlush();
+	portDISABLE_INTERRUPTS();
+	for(;;);
+}
+
+#endif /* STOPWATCH_AMP_CPU1 */
@@ -0,0 +1,38 @@
+/*
+ * Buffered, interrupt driven console, see console.c.
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+
+#ifndef CONSOLE_TX_BUFFER_SIZE
+#define CONSOLE_TX_BUFFER_SIZE	2048U	/* Must be a power of two */
+#endif
+
+/* What to do with new output when the TX ring is full */
+#define CONSOLE_POLICY_DROP_NEWEST		0	/* Discard the bytes that do not fit */
+#define CONSOLE_POLICY_OVERWRITE_OLDEST	1	/* Discard the oldest queued bytes to make room */
+
+#ifndef CONSOLE_TX_POLICY
+#define CONSOLE_TX_POLICY	CONSOLE_POLICY_DROP_NEWEST
+#endif
+
+#ifndef CONSOLE_USB
+#define CONSOLE_USB	1	/* 1: output goes to the USB serial port (usbcdc.c) while a host has it open */
+#endif
+
+typedef struct {
+	uint32_t ulBytesQueued;		/* Bytes accepted into the ring */
+	uint32_t ulBytesDropped;	/* New bytes discarded (drop newest) */
+	uint32_t ulBytesOverwritten;	/* Queued bytes discarded (overwrite oldest) */
+	uint32_t ulHighWaterMark;	/* Highest ring fill level seen */
+} ConsoleStats_t;
+
+int consoleInit(void);
+void consoleWrite(const char *buf, uint32_t len);
+void consoleFlush(void);
+void consoleGetStats(ConsoleStats_t *stats);
+
+#endif /* CONSOLE_H */
@@ -0,0 +1,139 @@
+/*
+ * Context switch benchmark.
+ *
+ * Two tasks of the same priority hand the CPU to each other with taskYIELD()
+ * and the time of the whole run is divided by the number of switches. The run
+ * is done with two integer-only tasks (like the GPIO and queue tasks of the
+ * stopwatch), with one integer and one FPU task (the display task is the only
+ * one using floating point) and with two tasks that use the FPU between every
+ * yield, which is the worst case for lazy FPU switching.
+ *
+ * Both schemes are printed side by side. The scheme the BSP is built with is
+ * measured. With configUSE_TASK_FPU_SUPPORT 2 every task has an FPU context,
+ * so without lazy switching every switch saves and restores D0-D31 and FPSCR:
+ * the other row adds (eager) or removes (lazy, no trap) the measured cost of
+ * that save and restore. The lazy FPU run of an eager build is left out, its
+ * trap cost can only be measured with configUSE_LAZY_FPU_SWITCHING 1.
+ */
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xil_printf.h"
+#include "xparameters.h"
+#include "xtime_l.h"
+#include "static_alloc.h"
+#include "ctxswitch_bench.h"
+
+#define BENCH_SWITCHES	10000U	/* Yields per task and run */
+#define BENCH_PRIORITY	(configMAX_PRIORITIES - 2)
+
+/* The global timer runs at half the CPU clock */
+#define BENCH_CPU_CYCLES_PER_TICK	(XPAR_CPU_CORTEXA9_CORE_CLOCK_FREQ_HZ / COUNTS_PER_SECOND)
+
+static TaskHandle_t xBenchControlHandler = NULL;
+STATIC_TASK(benchControl, configMINIMAL_STACK_SIZE * 2);
+/* Two tasks per run, the tasks delete themselves so each run has its own */
+STATIC_TASKS(benchTasks, 6, configMINIMAL_STACK_SIZE);
+static volatile double benchFpuSink;
+
+static void vBenchIntegerTask(void *pvParameters)
+{
+	for(uint32_t i = 0; i < BENCH_SWITCHES; i++) {
+		taskYIELD();
+	}
+
+	xTaskNotifyGive(xBenchControlHandler);
+	vTaskDelete(NULL);
+}
+
+static void vBenchFpuTask(void *pvParameters)
+{
+	double value = (double)(uintptr_t)pvParameters;
+
+	for(uint32_t i = 0; i < BENCH_SWITCHES; i++) {
+		value = value * 1.000001 + 0.5;
+		benchFpuSink = value;
+		taskYIELD();
+	}
+
+	xTaskNotifyGive(xBenchControlHandler);
+	vTaskDelete(NULL);
+}
+
+/* Run the two tasks to completion and return the CPU cycles per switch */
+static uint32_t runBenchmark(TaskFunction_t task0, TaskFunction_t task1, uint32_t run)
+{
+	XTime start, end;
+
+	XTime_GetTime(&start);
+	STATIC_TASKS_CREATE(benchTasks, run * 2U, task0, "bench0", (void*)1, BENCH_PRIORITY, NULL);
+	STATIC_TASKS_CREATE(benchTasks, run * 2U + 1U, task1, "bench1", (void*)2, BENCH_PRIORITY, NULL);
+	ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+	ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+	XTime_GetTime(&end);
+
+	return (uint32_t)(((end - start) * BENCH_CPU_CYCLES_PER_TICK) / (2U * BENCH_SWITCHES));
+}
+
+/* CPU cycles of the FPU save and restore done by portSAVE_CONTEXT and
+ * portRESTORE_CONTEXT without lazy switching, less the loop itself
+ */
+static uint32_t measureFpuSaveRestore(void)
+{
+	XTime start, middle, end;
+
+	XTime_GetTime(&start);
+	for(uint32_t i = 0; i < BENCH_SWITCHES; i++) {
+		__asm__ volatile("" ::: "memory");
+	}
+	XTime_GetTime(&middle);
+	for(uint32_t i = 0; i < BENCH_SWITCHES; i++) {
+		__asm__ volatile(
+			"fmrx	r0, fpscr\n\t"
+			"vpush	{d0-d15}\n\t"
+			"vpush	{d16-d31}\n\t"
+			"push	{r0}\n\t"
+			"pop	{r0}\n\t"
+			"vpop	{d16-d31}\n\t"
+			"vpop	{d0-d15}\n\t"
+			"vmsr	fpscr, r0\n\t"
+			::: "r0", "memory");
+	}
+	XTime_GetTime(&end);
+
+	return (uint32_t)((((end - middle) - (middle - start)) * BENCH_CPU_CYCLES_PER_TICK) / BENCH_SWITCHES);
+}
+
+static void vBenchControl(void *pvParameters)
+{
+	uint32_t integerCycles = runBenchmark(vBenchIntegerTask, vBenchIntegerTask, 0);
+	uint32_t mixedCycles = runBenchmark(vBenchIntegerTask, vBenchFpuTask, 1);
+	uint32_t fpuCycles = runBenchmark(vBenchFpuTask, vBenchFpuTask, 2);
+	uint32_t saveCycles = measureFpuSaveRestore();
+
+	xil_printf("Context switch cycles   integer    mixed      FPU\r\n");
+#if configUSE_LAZY_FPU_SWITCHING == 1
+	xil_printf("lazy FPU (measured)    %8d %8d %8d  %d FPU switches\r\n",
+			integerCycles, mixedCycles, fpuCycles, ulPortGetLazyFPUSwitchCount());
+	/* The FPU tasks of the eager scheme do not trap, they pay the save and
+	 * restore like the integer tasks */
+	xil_printf("eager FPU (estimated)  %8d %8d %8d\r\n",
+			integerCycles + saveCycles, integerCycles + saveCycles, integerCycles + saveCycles);
+#else
+	xil_printf("lazy FPU (estimated)   %8d %8d %8s\r\n",
+			integerCycles - saveCycles, mixedCycles - saveCycles, "-");
+	xil_printf("eager FPU (measured)   %8d %8d %8d\r\n", integerCycles, mixedCycles, fpuCycles);
+#endif
+	xil_printf("FPU save and restore   %8d cycles\r\n", saveCycles);
+
+	vTaskDelete(NULL);
+}
+
+/* Create the benchmark control task, it runs before the stopwatch tasks as soon
+ * as the scheduler starts and deletes itself when done.
+ */
+void startContextSwitchBenchmark(void)
+{
+	STATIC_TASK_CREATE(benchControl, vBenchControl, "bench", (void*)NULL, BENCH_PRIORITY + 1, &xBenchControlHandler);
+}
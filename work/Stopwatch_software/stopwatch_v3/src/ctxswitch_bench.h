@@ -0,0 +1,10 @@
+/*
+ * Context switch benchmark, see ctxswitch_bench.c.
+ */
+
+#ifndef CTXSWITCH_BENCH_H
+#define CTXSWITCH_BENCH_H
+
+void startContextSwitchBenchmark(void);
+
+#endif /* CTXSWITCH_BENCH_H */
@@ -0,0 +1,99 @@
+/*
+ * Deferred (format on host) logging.
+ *
+ * Each DLOG() call becomes one binary record:
+ *
+ *   u16 format ID | u32 timestamp | u32 argument * n | u8 checksum
+ *
+ * little endian, where the format ID is the string's offset in .dlog_fmt, the
+ * timestamp is the low word of the global timer (COUNTS_PER_SECOND) and the
+ * checksum makes all record bytes sum to 0. The record is COBS encoded and
+ * framed by a 0x00 byte on each side, so it can share the UART with plain
+ * xil_printf() text: everything between two 0x00 bytes is a record.
+ *
+ * The frame goes to the console ring in one consoleWrite() call, so records
+ * from different tasks and interrupts never interleave. A typical two argument
+ * line is 18 bytes on the wire instead of 40 to 60 characters, and no number
+ * formatting runs on the target.
+ *
+ * While a host runs tools/usb_trace_capture.py, the frames go to the USB trace
+ * channel instead, and the console keeps only the plain text.
+ */
+
+#ifndef STOPWATCH_AMP_CPU1
+
+#include <stdint.h>
+#include "clocksource.h"
+#include "console.h"
+#include "dlog.h"
+#if CONSOLE_USB
+#include "usbcdc.h"
+#endif
+
+#if DLOG_ENABLE
+
+#define DLOG_RECORD_MAX		(2U + 4U + (DLOG_MAX_ARGS * 4U) + 1U)
+#define DLOG_FRAME_MAX		(DLOG_RECORD_MAX + 1U + 2U)	/* COBS overhead and delimiters */
+
+static inline uint8_t *dlogPut32(uint8_t *p, uint32_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+	p[2] = (uint8_t)(value >> 16);
+	p[3] = (uint8_t)(value >> 24);
+	return p + 4;
+}
+
+/* COBS encode len (< 254) bytes from src to dst, returns the encoded length */
+static uint32_t dlogCobsEncode(const uint8_t *src, uint32_t len, uint8_t *dst)
+{
+	uint32_t code = 0;	/* Index of the pending code byte */
+	uint32_t out = 1;
+
+	for(uint32_t i = 0; i < len; i++) {
+		if(src[i] == 0) {
+			dst[code] = (uint8_t)(out - code);
+			code = out++;
+		} else {
+			dst[out++] = src[i];
+		}
+	}
+	dst[code] = (uint8_t)(out - code);
+	return out;
+}
+
+void dlogWrite(const char *fmt, const uint32_t *args, uint32_t nargs)
+{
+	uint8_t record[DLOG_RECORD_MAX];
+	uint8_t frame[DLOG_FRAME_MAX];
+	uint8_t *p = record;
+	uint8_t sum = 0;
+	uint32_t id = (uintptr_t)fmt;	/* .dlog_fmt is linked at address 0 */
+	uint32_t len;
+
+	*p++ = (uint8_t)id;
+	*p++ = (uint8_t)(id >> 8);
+	p = dlogPut32(p, clocksourceNow32());
+	for(uint32_t i = 0; i < nargs; i++) {
+		p = dlogPut32(p, args[i]);
+	}
+	for(uint8_t *q = record; q < p; q++) {
+		sum += *q;
+	}
+	*p++ = (uint8_t)(0U - sum);
+
+	frame[0] = 0;
+	len = dlogCobsEncode(record, (uint32_t)(p - record), &frame[1]);
+	frame[len + 1] = 0;
+#if CONSOLE_USB
+	if(usbcdcTraceIsOpen()) {
+		usbcdcTraceWrite(frame, len + 2);
+		return;
+	}
+#endif
+	consoleWrite((const char *)frame, len + 2);
+}
+
+#endif /* DLOG_ENABLE */
+
+#endif /* STOPWATCH_AMP_CPU1 */
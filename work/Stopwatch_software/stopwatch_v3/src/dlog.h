@@ -0,0 +1,46 @@
+/*
+ * Deferred (format on host) logging, see dlog.c.
+ *
+ * DLOG("Button %u pressed\r\n", button) places the format string in the
+ * non-loaded .dlog_fmt section and sends only its ID, a timestamp and the raw
+ * arguments. tools/dlog_decode.py renders the text from the ELF.
+ *
+ * Arguments are sent as 32-bit words: integers and characters only, %s and
+ * 64-bit conversions are not supported. With DLOG_ENABLE set to 0 the same call
+ * sites print through xil_printf().
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdint.h>
+
+#ifndef DLOG_ENABLE
+#define DLOG_ENABLE	1
+#endif
+
+#define DLOG_MAX_ARGS	8U
+
+#if DLOG_ENABLE
+
+void dlogWrite(const char *fmt, const uint32_t *args, uint32_t nargs);
+
+/* Number of variadic arguments, 0 to DLOG_MAX_ARGS */
+#define DLOG_NARGS(...)	DLOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...)	N
+
+#define DLOG(fmt, ...) do { \
+		static const char dlogFmt[] __attribute__((section(".dlog_fmt"), used)) = fmt; \
+		const uint32_t dlogArgs[] = { 0, ##__VA_ARGS__ }; \
+		dlogWrite(dlogFmt, &dlogArgs[1], DLOG_NARGS(__VA_ARGS__)); \
+	} while(0)
+
+#else
+
+#include "xil_printf.h"
+
+#define DLOG(fmt, ...)	xil_printf(fmt, ##__VA_ARGS__)
+
+#endif /* DLOG_ENABLE */
+
+#endif /* DLOG_H */
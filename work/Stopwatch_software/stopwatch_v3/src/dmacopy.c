@@ -0,0 +1,447 @@
+/*
+ * Asynchronous memcpy on the 8 channels of the PS DMA controller (PL330).
+ *
+ * - A copy is split so that the DMA only writes whole cache lines. The
+ *   unaligned head and tail of the destination are copied by the CPU in
+ *   dmacopySubmit(), which also cleans the source and invalidates the
+ *   destination lines, so neither the channel start in the interrupt handler
+ *   nor a neighbouring variable sharing a line can race with the transfer.
+ *   dmacopyWait() invalidates the destination lines again once the copy is
+ *   done, the A9 may have fetched them speculatively while the DMA ran.
+ * - The microcode of a copy only depends on its length once the addresses
+ *   are aligned. Each channel keeps DMACOPY_PROG_CACHE programs generated by
+ *   the driver, keyed by length; a hit only rewrites the immediates of the
+ *   two leading DMAMOV SAR/DAR instructions and cleans that one line.
+ * - Requests go through a bounded lock-free ring (sequence numbered cells),
+ *   free channels are claimed from a bitmap with atomic operations, so
+ *   neither submitting tasks nor the done interrupt mask interrupts. The
+ *   submitter starts a channel itself when one is free, otherwise the done
+ *   interrupt of the next channel to finish takes the request from the ring.
+ * - Copies longer than DMACOPY_CHUNK run as several programs in a row on the
+ *   same channel, the largest a two level PL330 loop can express.
+ * - Completion sets the request status and notifies the submitting task on
+ *   its own notification index.
+ */
+
+#ifndef STOPWATCH_AMP_CPU1
+
+#include <stdint.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xil_cache.h"
+#include "xparameters.h"
+#include "xstatus.h"
+#include "xdmaps.h"
+#include "dmacopy.h"
+
+#define DMACOPY_DEVICE_ID	XPAR_XDMAPS_1_DEVICE_ID	/* Secure instance, the CPU runs secure */
+#define DMACOPY_CHANNELS	XDMAPS_CHANNELS_PER_DEV
+#define DMACOPY_CACHE_LINE	32U
+#define DMACOPY_BEAT		8U		/* 64-bit AXI master */
+#define DMACOPY_BURST_LEN	16U		/* Beats per burst, 128 bytes */
+#define DMACOPY_CHUNK		(256U * 256U * DMACOPY_BEAT * DMACOPY_BURST_LEN)	/* 8 MB, two nested 256 loops */
+#define DMACOPY_ALL_CHANNELS	((1U << DMACOPY_CHANNELS) - 1U)
+
+/* Immediate of the DMAMOV SAR and DAR instructions that start every program */
+#define DMACOPY_PROG_SAR	2U
+#define DMACOPY_PROG_DAR	8U
+
+#if (DMACOPY_RING_SIZE & (DMACOPY_RING_SIZE - 1U)) != 0
+#error DMACOPY_RING_SIZE must be a power of two
+#endif
+
+#if DMACOPY_THRESHOLD < (2U * DMACOPY_CACHE_LINE)
+#error DMACOPY_THRESHOLD must leave at least one whole line for the DMA
+#endif
+
+#define DMACOPY_COUNT(field, n)	__atomic_fetch_add(&dmaStats.field, (n), __ATOMIC_RELAXED)
+
+typedef struct {
+	uint8_t prog[XDMAPS_CHAN_BUF_LEN];
+	uint32_t len;			/* Copy length, 0 while the slot is empty */
+	int progLen;
+} __attribute__((aligned(DMACOPY_CACHE_LINE))) DmaCopyProg;
+
+typedef struct {
+	volatile uint32_t seq;
+	DmaCopyReq *req;
+} DmaCopyCell;
+
+static XDmaPs dma;
+static XDmaPs_Cmd chanCmd[DMACOPY_CHANNELS];
+static DmaCopyReq *chanReq[DMACOPY_CHANNELS];
+static DmaCopyProg progCache[DMACOPY_CHANNELS][DMACOPY_PROG_CACHE];
+static uint8_t progNext[DMACOPY_CHANNELS];
+static uint32_t chanFree;
+static DmaCopyCell ring[DMACOPY_RING_SIZE];
+static uint32_t ringHead;	/* Next cell to fill */
+static uint32_t ringTail;	/* Next cell to take */
+static int dmaReady;
+static DmaCopyStats_t dmaStats;
+
+static BaseType_t ringPush(DmaCopyReq *req)
+{
+	uint32_t pos = __atomic_load_n(&ringHead, __ATOMIC_RELAXED);
+	DmaCopyCell *cell;
+	int32_t diff;
+
+	for(;;) {
+		cell = &ring[pos & (DMACOPY_RING_SIZE - 1U)];
+		diff = (int32_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+		if(diff == 0) {
+			if(__atomic_compare_exchange_n(&ringHead, &pos, pos + 1U, pdTRUE,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if(diff < 0) {
+			return pdFALSE;
+		} else {
+			pos = __atomic_load_n(&ringHead, __ATOMIC_RELAXED);
+		}
+	}
+	cell->req = req;
+	__atomic_store_n(&cell->seq, pos + 1U, __ATOMIC_RELEASE);
+	return pdTRUE;
+}
+
+static DmaCopyReq *ringPop(void)
+{
+	uint32_t pos = __atomic_load_n(&ringTail, __ATOMIC_RELAXED);
+	DmaCopyCell *cell;
+	DmaCopyReq *req;
+	int32_t diff;
+
+	for(;;) {
+		cell = &ring[pos & (DMACOPY_RING_SIZE - 1U)];
+		diff = (int32_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (pos + 1U));
+		if(diff == 0) {
+			if(__atomic_compare_exchange_n(&ringTail, &pos, pos + 1U, pdTRUE,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if(diff < 0) {
+			return NULL;
+		} else {
+			pos = __atomic_load_n(&ringTail, __ATOMIC_RELAXED);
+		}
+	}
+	req = cell->req;
+	__atomic_store_n(&cell->seq, pos + DMACOPY_RING_SIZE, __ATOMIC_RELEASE);
+	return req;
+}
+
+/* Claim a free channel, DMACOPY_CHANNELS if all are busy */
+static unsigned chanClaim(void)
+{
+	uint32_t mask = __atomic_load_n(&chanFree, __ATOMIC_RELAXED);
+
+	while(mask != 0U) {
+		if(__atomic_compare_exchange_n(&chanFree, &mask, mask & (mask - 1U), pdTRUE,
+				__ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			return (unsigned)__builtin_ctz(mask);
+		}
+	}
+	return DMACOPY_CHANNELS;
+}
+
+static void chanRelease(unsigned chan)
+{
+	__atomic_fetch_or(&chanFree, 1U << chan, __ATOMIC_RELEASE);
+}
+
+static void progPatch(uint8_t *at, uint32_t addr)
+{
+	at[0] = (uint8_t)addr;
+	at[1] = (uint8_t)(addr >> 8);
+	at[2] = (uint8_t)(addr >> 16);
+	at[3] = (uint8_t)(addr >> 24);
+}
+
+/* Program copying len bytes from src to dst on chan, NULL if it cannot be built. Channel owned by the caller */
+static DmaCopyProg *progGet(unsigned chan, uint32_t src, uint32_t dst, uint32_t len)
+{
+	XDmaPs_Cmd gen;
+	DmaCopyProg *p;
+	unsigned i;
+
+	for(i = 0; i < DMACOPY_PROG_CACHE; i++) {
+		p = &progCache[chan][i];
+		if(p->len == len) {
+			progPatch(&p->prog[DMACOPY_PROG_SAR], src);
+			progPatch(&p->prog[DMACOPY_PROG_DAR], dst);
+			Xil_DCacheFlushRange((INTPTR)p->prog, DMACOPY_CACHE_LINE);
+			DMACOPY_COUNT(ulProgHits, 1U);
+			return p;
+		}
+	}
+
+	/* Miss, let the driver generate it in its channel buffer pool and keep a copy */
+	gen = chanCmd[chan];
+	gen.BD.SrcAddr = src;
+	gen.BD.DstAddr = dst;
+	gen.BD.Length = len;
+	if(XDmaPs_GenDmaProg(&dma, chan, &gen) != XST_SUCCESS) {
+		return NULL;
+	}
+	p = &progCache[chan][progNext[chan]];
+	progNext[chan] = (progNext[chan] + 1U) % DMACOPY_PROG_CACHE;
+	memcpy(p->prog, gen.GeneratedDmaProg, gen.GeneratedDmaProgLength);
+	p->progLen = gen.GeneratedDmaProgLength;
+	p->len = len;
+	XDmaPs_FreeDmaProg(&dma, chan, &gen);
+	Xil_DCacheFlushRange((INTPTR)p->prog, p->progLen);
+	DMACOPY_COUNT(ulProgBuilds, 1U);
+	return p;
+}
+
+static void reqComplete(DmaCopyReq *req, int32_t status, BaseType_t *pxHigherPriorityTaskWoken)
+{
+	TaskHandle_t task = req->task;
+
+	__atomic_store_n(&req->status, status, __ATOMIC_RELEASE);
+	vTaskNotifyGiveIndexedFromISR(task, DMACOPY_NOTIFY_INDEX, pxHigherPriorityTaskWoken);
+}
+
+/* Start the next chunk of req on chan, on failure req completes as faulted and chan stays claimed */
+static BaseType_t chanStart(unsigned chan, DmaCopyReq *req, BaseType_t *pxHigherPriorityTaskWoken)
+{
+	XDmaPs_Cmd *cmd = &chanCmd[chan];
+	DmaCopyProg *p;
+
+	req->chunk = (req->len < DMACOPY_CHUNK) ? req->len : DMACOPY_CHUNK;
+	p = progGet(chan, (uint32_t)req->src, (uint32_t)req->dst, req->chunk);
+	if(p != NULL) {
+		cmd->UserDmaProg = p->prog;
+		cmd->UserDmaProgLength = p->progLen;
+		chanReq[chan] = req;
+		if(XDmaPs_Start(&dma, chan, cmd, 0) == XST_SUCCESS) {
+			return pdTRUE;
+		}
+	}
+	chanReq[chan] = NULL;
+	DMACOPY_COUNT(ulFaults, 1U);
+	reqComplete(req, DMACOPY_FAULT, pxHigherPriorityTaskWoken);
+	return pdFALSE;
+}
+
+/* Give the channel to the next queued request, or back to the free set */
+static void chanNext(unsigned chan, BaseType_t *pxHigherPriorityTaskWoken)
+{
+	DmaCopyReq *req;
+
+	while((req = ringPop()) != NULL) {
+		if(chanStart(chan, req, pxHigherPriorityTaskWoken)) {
+			return;
+		}
+	}
+	chanRelease(chan);
+}
+
+/* Called by XDmaPs_DoneISR_n() */
+static void dmacopyDoneHandler(unsigned int Channel, XDmaPs_Cmd *DmaCmd, void *CallbackRef)
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	DmaCopyReq *req = chanReq[Channel];
+
+	chanReq[Channel] = NULL;
+	if(req != NULL) {
+		req->src += req->chunk;
+		req->dst += req->chunk;
+		req->len -= req->chunk;
+		if(req->len != 0U) {
+			if(chanStart(Channel, req, &xHigherPriorityTaskWoken)) {
+				portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+				return;
+			}
+		} else {
+			reqComplete(req, DMACOPY_DONE, &xHigherPriorityTaskWoken);
+		}
+	}
+	chanNext(Channel, &xHigherPriorityTaskWoken);
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/* Called by XDmaPs_FaultISR(), which has already killed the channel thread */
+static void dmacopyFaultHandler(unsigned int Channel, XDmaPs_Cmd *DmaCmd, void *CallbackRef)
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	DmaCopyReq *req = chanReq[Channel];
+
+	chanReq[Channel] = NULL;
+	DMACOPY_COUNT(ulFaults, 1U);
+	if(req != NULL) {
+		reqComplete(req, DMACOPY_FAULT, &xHigherPriorityTaskWoken);
+	}
+	chanNext(Channel, &xHigherPriorityTaskWoken);
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+static void dmacopyCpu(DmaCopyReq *req, void *dst, const void *src, uint32_t len)
+{
+	memcpy(dst, src, len);
+	DMACOPY_COUNT(ulCpuCopies, 1U);
+	DMACOPY_COUNT(ulCpuBytes, len);
+	req->len = 0;
+	req->linesLen = 0;
+	req->status = DMACOPY_DONE;
+}
+
+/* Returns pdTRUE if the copy was queued to the DMA, pdFALSE if it is already complete */
+BaseType_t dmacopySubmit(DmaCopyReq *req, void *dst, const void *src, uint32_t len)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	uint32_t head = (0U - (uint32_t)d) & (DMACOPY_CACHE_LINE - 1U);
+	uint32_t tail;
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+	unsigned chan;
+
+	req->task = xTaskGetCurrentTaskHandle();
+	if(!dmaReady || (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) || (len < DMACOPY_THRESHOLD) ||
+			((((uint32_t)d ^ (uint32_t)s) & (DMACOPY_BEAT - 1U)) != 0U)) {
+		dmacopyCpu(req, dst, src, len);
+		return pdFALSE;
+	}
+
+	/* The DMA writes whole destination lines only */
+	memcpy(d, s, head);
+	d += head;
+	s += head;
+	len -= head;
+	tail = len & (DMACOPY_CACHE_LINE - 1U);
+	len -= tail;
+	memcpy(d + len, s + len, tail);
+
+	Xil_DCacheFlushRange((INTPTR)s, len);
+	Xil_DCacheInvalidateRange((INTPTR)d, len);
+
+	req->src = s;
+	req->dst = d;
+	req->len = len;
+	req->lines = d;
+	req->linesLen = len;
+	req->status = DMACOPY_PENDING;
+	if(!ringPush(req)) {
+		DMACOPY_COUNT(ulRingFull, 1U);
+		dmacopyCpu(req, d, s, len);
+		return pdFALSE;
+	}
+	DMACOPY_COUNT(ulDmaCopies, 1U);
+	DMACOPY_COUNT(ulDmaBytes, len);
+
+	/* Start it now if a channel is free, else a done interrupt will */
+	while((chan = chanClaim()) != DMACOPY_CHANNELS) {
+		DmaCopyReq *next = ringPop();
+
+		if(next == NULL) {
+			chanRelease(chan);
+			break;
+		}
+		if(chanStart(chan, next, &xHigherPriorityTaskWoken)) {
+			continue;
+		}
+		chanRelease(chan);
+	}
+	/* Only a failed start completes a request here */
+	if(xHigherPriorityTaskWoken != pdFALSE) {
+		taskYIELD();
+	}
+	return pdTRUE;
+}
+
+/* Wait for a request of the calling task, returns its status, DMACOPY_PENDING on timeout */
+int32_t dmacopyWait(DmaCopyReq *req, TickType_t wait)
+{
+	TimeOut_t timeout;
+
+	vTaskSetTimeOutState(&timeout);
+	while(__atomic_load_n(&req->status, __ATOMIC_ACQUIRE) == DMACOPY_PENDING) {
+		if(xTaskCheckForTimeOut(&timeout, &wait) != pdFALSE) {
+			break;
+		}
+		ulTaskNotifyTakeIndexed(DMACOPY_NOTIFY_INDEX, pdTRUE, wait);
+	}
+	if((req->status != DMACOPY_PENDING) && (req->linesLen != 0U)) {
+		Xil_DCacheInvalidateRange((INTPTR)req->lines, req->linesLen);
+		req->linesLen = 0;
+	}
+	return req->status;
+}
+
+/* Blocking copy, the calling task sleeps while the DMA runs */
+void *dmacopyMemcpy(void *dst, const void *src, uint32_t len)
+{
+	DmaCopyReq req;
+
+	if(dmacopySubmit(&req, dst, src, len) && (dmacopyWait(&req, portMAX_DELAY) != DMACOPY_DONE)) {
+		memcpy(dst, src, len);
+	}
+	return dst;
+}
+
+int dmacopyInit(void)
+{
+	XDmaPs_Config *config;
+	unsigned chan;
+	uint32_t i;
+
+	config = XDmaPs_LookupConfig(DMACOPY_DEVICE_ID);
+	if(config == NULL || XDmaPs_CfgInitialize(&dma, config, config->BaseAddress) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	for(i = 0; i < DMACOPY_RING_SIZE; i++) {
+		ring[i].seq = i;
+	}
+
+	for(chan = 0; chan < DMACOPY_CHANNELS; chan++) {
+		XDmaPs_ChanCtrl *ctrl = &chanCmd[chan].ChanCtrl;
+
+		memset(&chanCmd[chan], 0, sizeof(chanCmd[chan]));
+		ctrl->SrcBurstSize = DMACOPY_BEAT;
+		ctrl->SrcBurstLen = DMACOPY_BURST_LEN;
+		ctrl->SrcInc = 1;
+		ctrl->DstBurstSize = DMACOPY_BEAT;
+		ctrl->DstBurstLen = DMACOPY_BURST_LEN;
+		ctrl->DstInc = 1;
+		/* Cache maintenance is done once in dmacopySubmit(), the driver only uses BD for it with a user program */
+		chanCmd[chan].BD.Length = 0;
+		XDmaPs_SetDoneHandler(&dma, chan, dmacopyDoneHandler, NULL);
+	}
+	XDmaPs_SetFaultHandler(&dma, dmacopyFaultHandler, NULL);
+
+	if(xPortInstallInterruptHandler(XPAR_XDMAPS_0_FAULT_INTR, (XInterruptHandler)XDmaPs_FaultISR, &dma) != pdPASS ||
+			xPortInstallInterruptHandler(XPAR_XDMAPS_0_DONE_INTR_0, (XInterruptHandler)XDmaPs_DoneISR_0, &dma) != pdPASS ||
+			xPortInstallInterruptHandler(XPAR_XDMAPS_0_DONE_INTR_1, (XInterruptHandler)XDmaPs_DoneISR_1, &dma) != pdPASS ||
+			xPortInstallInterruptHandler(XPAR_XDMAPS_0_DONE_INTR_2, (XInterruptHandler)XDmaPs_DoneISR_2, &dma) != pdPASS ||
+			xPortInstallInterruptHandler(XPAR_XDMAPS_0_DONE_INTR_3, (XInterruptHandler)XDmaPs_DoneISR_3, &dma) != pdPASS ||
+			xPortInstallInterruptHandler(XPAR_XDMAPS_0_DONE_INTR_4, (XInterruptHandler)XDmaPs_DoneISR_4, &dma) != pdPASS ||
+			xPortInstallInterruptHandler(XPAR_XDMAPS_0_DONE_INTR_5, (XInterruptHandler)XDmaPs_DoneISR_5, &dma) != pdPASS ||
+			xPortInstallInterruptHandler(XPAR_XDMAPS_0_DONE_INTR_6, (XInterruptHandler)XDmaPs_DoneISR_6, &dma) != pdPASS ||
+			xPortInstallInterruptHandler(XPAR_XDMAPS_0_DONE_INTR_7, (XInterruptHandler)XDmaPs_DoneISR_7, &dma) != pdPASS) {
+		return XST_FAILURE;
+	}
+	vPortEnableInterrupt(XPAR_XDMAPS_0_FAULT_INTR);
+	vPortEnableInterrupt(XPAR_XDMAPS_0_DONE_INTR_0);
+	vPortEnableInterrupt(XPAR_XDMAPS_0_DONE_INTR_1);
+	vPortEnableInterrupt(XPAR_XDMAPS_0_DONE_INTR_2);
+	vPortEnableInterrupt(XPAR_XDMAPS_0_DONE_INTR_3);
+	vPortEnableInterrupt(XPAR_XDMAPS_0_DONE_INTR_4);
+	vPortEnableInterrupt(XPAR_XDMAPS_0_DONE_INTR_5);
+	vPortEnableInterrupt(XPAR_XDMAPS_0_DONE_INTR_6);
+	vPortEnableInterrupt(XPAR_XDMAPS_0_DONE_INTR_7);
+
+	__atomic_store_n(&chanFree, DMACOPY_ALL_CHANNELS, __ATOMIC_RELEASE);
+	dmaReady = 1;
+	return XST_SUCCESS;
+}
+
+void dmacopyGetStats(DmaCopyStats_t *stats)
+{
+	taskENTER_CRITICAL();
+	*stats = dmaStats;
+	taskEXIT_CRITICAL();
+}
+
+#endif /* STOPWATCH_AMP_CPU1 */
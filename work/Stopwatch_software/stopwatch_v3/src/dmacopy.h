@@ -0,0 +1,77 @@
+/*
+ * Asynchronous memcpy offloaded to the PS DMA controller (PL330), see
+ * dmacopy.c.
+ *
+ * dmacopySubmit() starts a copy and returns at once, the caller keeps working
+ * and collects the result with dmacopyWait(). Only the submitting task may
+ * wait, it is woken through task notification index DMACOPY_NOTIFY_INDEX.
+ * Copies shorter than DMACOPY_THRESHOLD, or whose source and destination are
+ * not equally aligned to 8 bytes, are done on the CPU before dmacopySubmit()
+ * returns.
+ *
+ * Until dmacopyWait() has returned the status of a copy the destination must
+ * not be read or written, and the source must not be written.
+ */
+
+#ifndef DMACOPY_H
+#define DMACOPY_H
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef DMACOPY_THRESHOLD
+#define DMACOPY_THRESHOLD	4096U	/* Shorter copies are done on the CPU */
+#endif
+
+#ifndef DMACOPY_RING_SIZE
+#define DMACOPY_RING_SIZE	32U		/* Pending requests, must be a power of two */
+#endif
+
+#ifndef DMACOPY_PROG_CACHE
+#define DMACOPY_PROG_CACHE	4U		/* Cached programs per channel */
+#endif
+
+#ifndef DMACOPY_NOTIFY_INDEX
+#define DMACOPY_NOTIFY_INDEX	1U	/* Task notification used for completions, index 0 is left to the application */
+#endif
+
+#if DMACOPY_NOTIFY_INDEX >= configTASK_NOTIFICATION_ARRAY_ENTRIES
+#error DMACOPY_NOTIFY_INDEX needs configTASK_NOTIFICATION_ARRAY_ENTRIES > DMACOPY_NOTIFY_INDEX
+#endif
+
+/* DmaCopyReq status */
+#define DMACOPY_DONE		0
+#define DMACOPY_PENDING		1
+#define DMACOPY_FAULT		(-1)	/* DMA fault, the destination is partly written */
+
+/* One copy, owned by the caller until it has completed */
+typedef struct {
+	const uint8_t *src;		/* Part still to be copied by the DMA */
+	uint8_t *dst;
+	uint32_t len;
+	uint32_t chunk;			/* Bytes of the program running now */
+	uint8_t *lines;			/* Destination lines written by the DMA, invalidated again once done */
+	uint32_t linesLen;
+	TaskHandle_t task;		/* Notified on completion */
+	volatile int32_t status;
+} DmaCopyReq;
+
+typedef struct {
+	uint32_t ulDmaCopies;		/* Copies queued to the DMA */
+	uint32_t ulDmaBytes;
+	uint32_t ulCpuCopies;		/* Copies done on the CPU, short, misaligned or ring full */
+	uint32_t ulCpuBytes;
+	uint32_t ulProgHits;		/* Programs reused from the cache */
+	uint32_t ulProgBuilds;		/* Programs generated by the driver */
+	uint32_t ulRingFull;		/* Copies refused by the full request ring */
+	uint32_t ulFaults;
+} DmaCopyStats_t;
+
+int dmacopyInit(void);
+BaseType_t dmacopySubmit(DmaCopyReq *req, void *dst, const void *src, uint32_t len);
+int32_t dmacopyWait(DmaCopyReq *req, TickType_t wait);
+void *dmacopyMemcpy(void *dst, const void *src, uint32_t len);
+void dmacopyGetStats(DmaCopyStats_t *stats);
+
+#endif /* DMACOPY_H */
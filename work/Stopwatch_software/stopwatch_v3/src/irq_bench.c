@@ -0,0 +1,102 @@
+/*
+ * Interrupt to task notification latency benchmark.
+ *
+ * A task raises a software generated interrupt (SGI) on its own core and waits
+ * for the handler to notify it. The time from raising the SGI to the task
+ * running again is measured once with the handler installed through the
+ * generic XScuGic dispatch (xPortInstallInterruptHandler) and once through the
+ * port fast path (xPortInstallFastInterruptHandler).
+ */
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xil_printf.h"
+#include "xparameters.h"
+#include "xscugic.h"
+#include "xtime_l.h"
+#include "static_alloc.h"
+#include "irq_bench.h"
+
+#define IRQ_BENCH_SGI		2U		/* SGI 0 is the AMP doorbell */
+#define IRQ_BENCH_RUNS		1000U
+#define IRQ_BENCH_PRIORITY	(configMAX_PRIORITIES - 3)	/* Below the context switch benchmark */
+
+/* The global timer runs at half the CPU clock */
+#define IRQ_BENCH_CPU_CYCLES_PER_TICK	(XPAR_CPU_CORTEXA9_CORE_CLOCK_FREQ_HZ / COUNTS_PER_SECOND)
+
+extern XScuGic xInterruptController; /* GIC instance set up by the FreeRTOS port */
+
+static TaskHandle_t xIrqBenchHandler = NULL;
+STATIC_TASK(irqBench, configMINIMAL_STACK_SIZE * 2);
+
+static void irqBenchNotify(void)
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	vTaskNotifyGiveFromISR(xIrqBenchHandler, &xHigherPriorityTaskWoken);
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+static void irqBenchGenericHandler(void *CallBackRef)
+{
+	irqBenchNotify();
+}
+
+#if configNUM_FAST_INTERRUPTS > 0
+static void irqBenchFastHandler(uint32_t ulICCIAR)
+{
+	irqBenchNotify();
+}
+#endif
+
+/* Raise the SGI IRQ_BENCH_RUNS times and print min/avg/max CPU cycles until the task is notified */
+static void runIrqBenchmark(const char *name)
+{
+	XTime start, end;
+	uint64_t total = 0;
+	uint32_t min = UINT32_MAX;
+	uint32_t max = 0;
+
+	for(uint32_t i = 0; i < IRQ_BENCH_RUNS; i++) {
+		XTime_GetTime(&start);
+		XScuGic_SoftwareIntr(&xInterruptController, IRQ_BENCH_SGI, XSCUGIC_SPI_CPU0_MASK);
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		XTime_GetTime(&end);
+
+		uint32_t cycles = (uint32_t)((end - start) * IRQ_BENCH_CPU_CYCLES_PER_TICK);
+		total += cycles;
+		if(cycles < min) {
+			min = cycles;
+		}
+		if(cycles > max) {
+			max = cycles;
+		}
+	}
+
+	xil_printf("IRQ to task notify (%s): min %d, avg %d, max %d cycles\r\n", name, min, (uint32_t)(total / IRQ_BENCH_RUNS), max);
+}
+
+static void vIrqBench(void *pvParameters)
+{
+	/* The GIC is initialized by vTaskStartScheduler(), install the handlers from the task */
+	xPortInstallInterruptHandler(IRQ_BENCH_SGI, irqBenchGenericHandler, NULL);
+	vPortEnableInterrupt(IRQ_BENCH_SGI);
+	runIrqBenchmark("generic dispatch");
+
+#if configNUM_FAST_INTERRUPTS > 0
+	xPortInstallFastInterruptHandler(IRQ_BENCH_SGI, irqBenchFastHandler, portFAST_INTERRUPT_PRIORITY);
+	runIrqBenchmark("fast path");
+#endif
+
+	vPortDisableInterrupt(IRQ_BENCH_SGI);
+	vTaskDelete(NULL);
+}
+
+/* Create the benchmark task, it runs before the stopwatch tasks as soon as the
+ * scheduler starts and deletes itself when done.
+ */
+void startIrqBenchmark(void)
+{
+	STATIC_TASK_CREATE(irqBench, vIrqBench, "irqbench", (void*)NULL, IRQ_BENCH_PRIORITY, &xIrqBenchHandler);
+}
@@ -0,0 +1,10 @@
+/*
+ * Interrupt to task notification latency benchmark, see irq_bench.c.
+ */
+
+#ifndef IRQ_BENCH_H
+#define IRQ_BENCH_H
+
+void startIrqBenchmark(void);
+
+#endif /* IRQ_BENCH_H */
@@ -0,0 +1,503 @@
+/*
+ * Kernel primitive microbenchmarks.
+ *
+ * Each benchmark takes KBENCH_ITERATIONS samples of one kernel operation and
+ * prints a CSV row (lines starting with "kbench,") with the minimum, median,
+ * mean, 99th percentile and maximum. tools/kernel_bench_compare.py compares
+ * two runs. On the Zynq the samples are PMU cycle counter deltas. The same
+ * file builds against the POSIX port (sim/Makefile, make kbench), where the
+ * samples are host nanoseconds: only the relative change between two host
+ * runs means something there.
+ *
+ * Handoff benchmarks time from the call that wakes a higher priority task to
+ * that task running, so they include the context switch. pend_call_handoff
+ * and workq_handoff time deferred work from the submission to the function
+ * running in the timer task and the urgent work queue worker. The others time the
+ * call alone in the benchmark task. read_overhead, two back to back counter
+ * reads, is included in every sample and is not subtracted. heap_malloc and
+ * heap_free are only run when the kernel has a heap
+ * (configSUPPORT_DYNAMIC_ALLOCATION).
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+#include "timers.h"
+#include "xil_printf.h"
+#include "xstatus.h"
+#include "workq.h"
+#include "static_alloc.h"
+#include "kernel_bench.h"
+
+#if STOPWATCH_SIM
+#include <stdio.h>
+#include <time.h>
+#else
+#include "xparameters.h"
+#include "xscugic.h"
+#include "xpm_counter.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#endif
+
+#define KBENCH_PRIORITY			(configMAX_PRIORITIES - 3)	/* Benchmark task */
+#define KBENCH_PRIORITY_HIGH	(configMAX_PRIORITIES - 2)	/* Woken tasks, below the timer task */
+
+#define KBENCH_SYNC_LOW		0x01U	/* Event group bits of the sync benchmark */
+#define KBENCH_SYNC_HIGH	0x02U
+
+#if STOPWATCH_SIM
+#define KBENCH_UNIT		"ns"
+#define KBENCH_PORT		"posix"
+#else
+#define KBENCH_UNIT		"cycles"
+#define KBENCH_PORT		"zynq"
+#define KBENCH_SGI		3U		/* SGI 0 is the AMP doorbell, 2 the IRQ benchmark */
+
+#define KBENCH_PMCR_ENABLE			0x1UL
+#define KBENCH_PMCR_DIVIDER			0x8UL	/* Count every 64th cycle */
+#define KBENCH_CYCLE_COUNTER_ENABLE	0x80000000UL
+
+extern XScuGic xInterruptController; /* GIC instance set up by the FreeRTOS port */
+#endif
+
+static TaskHandle_t xKbenchHandler = NULL;
+static TaskHandle_t xKbenchWaiter = NULL;
+STATIC_TASK(kbench, configMINIMAL_STACK_SIZE * 2);
+/* Deleted by the benchmark task while blocked, its storage serves every run */
+STATIC_TASK(kbenchWaiter, configMINIMAL_STACK_SIZE);
+/* The yield tasks delete themselves, each of the two runs has its own pair */
+STATIC_TASKS(kbenchYield, 4, configMINIMAL_STACK_SIZE);
+
+static uint32_t kbenchSamples[KBENCH_ITERATIONS];
+static volatile uint32_t ulKbenchCount;
+static uint32_t ulKbenchTarget;
+
+/* Start time of the operation timed by another task */
+static volatile uint32_t ulKbenchStart;
+static volatile int kbenchArmed;
+
+static QueueHandle_t xKbenchQueue;
+static SemaphoreHandle_t xKbenchSemaphore;
+static EventGroupHandle_t xKbenchEvents;
+static TimerHandle_t xKbenchTimer;
+STATIC_QUEUE(kbench, 1, sizeof(uint32_t));
+STATIC_SEMAPHORE(kbench);
+STATIC_EVENT_GROUP(kbench);
+STATIC_TIMER(kbench);
+static volatile int kbenchExpired;
+static volatile double kbenchFpuSink;
+static WorkqItem_t xKbenchWork;
+
+#if STOPWATCH_SIM
+static inline uint32_t kbenchNow(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#else
+static inline uint32_t kbenchNow(void)
+{
+	return Xpm_ReadCycleCounterVal();
+}
+
+/* Run the cycle counter at the CPU clock, it may already run for the PMU profiler */
+static void kbenchCounterInit(void)
+{
+	mtcp(XREG_CP15_COUNT_ENABLE_SET, mfcp(XREG_CP15_COUNT_ENABLE_SET) | KBENCH_CYCLE_COUNTER_ENABLE);
+	mtcp(XREG_CP15_PERF_MONITOR_CTRL, (mfcp(XREG_CP15_PERF_MONITOR_CTRL) | KBENCH_PMCR_ENABLE) & ~KBENCH_PMCR_DIVIDER);
+	isb();
+}
+#endif
+
+static void kbenchBegin(uint32_t samples)
+{
+	ulKbenchCount = 0;
+	ulKbenchTarget = samples;
+	kbenchArmed = 0;
+}
+
+static inline void kbenchRecord(uint32_t delta)
+{
+	if(ulKbenchCount < ulKbenchTarget) {
+		kbenchSamples[ulKbenchCount++] = delta;
+	}
+}
+
+static int kbenchCompare(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Print the row of the samples taken since kbenchBegin() */
+static void kbenchReport(const char *name)
+{
+	uint32_t n = ulKbenchCount;
+	uint64_t total = 0;
+
+	if(n == 0) {
+		xil_printf("kbench,%s,%s,0,,,,,\r\n", name, KBENCH_UNIT);
+		return;
+	}
+
+	qsort(kbenchSamples, n, sizeof(kbenchSamples[0]), kbenchCompare);
+	for(uint32_t i = 0; i < n; i++) {
+		total += kbenchSamples[i];
+	}
+	xil_printf("kbench,%s,%s,%u,%u,%u,%u,%u,%u\r\n", name, KBENCH_UNIT, n,
+			kbenchSamples[0], kbenchSamples[n / 2], (uint32_t)(total / n),
+			kbenchSamples[(n * 99U) / 100U], kbenchSamples[n - 1]);
+}
+
+/* Two tasks of the same priority yielding to each other, each sample is one switch */
+static void vKbenchYield(void *pvParameters)
+{
+	double value = 1.0;
+
+	for(uint32_t i = 0; i <= KBENCH_ITERATIONS / 2U; i++) {
+		uint32_t now = kbenchNow();
+
+		if(kbenchArmed) {
+			kbenchRecord(now - ulKbenchStart);
+		}
+		if(pvParameters != NULL) {
+			/* Leave the FPU context dirty for the switch */
+			value = value * 1.000001 + 0.5;
+			kbenchFpuSink = value;
+		}
+		kbenchArmed = 1;
+		ulKbenchStart = kbenchNow();
+		taskYIELD();
+	}
+
+	xTaskNotifyGive(xKbenchHandler);
+	vTaskDelete(NULL);
+}
+
+static void runYield(const char *name, void *fpu)
+{
+	const uint32_t run = fpu != NULL ? 2U : 0U;
+
+	kbenchBegin(KBENCH_ITERATIONS);
+	STATIC_TASKS_CREATE(kbenchYield, run, vKbenchYield, "kbyield0", fpu, KBENCH_PRIORITY_HIGH, NULL);
+	STATIC_TASKS_CREATE(kbenchYield, run + 1U, vKbenchYield, "kbyield1", fpu, KBENCH_PRIORITY_HIGH, NULL);
+	ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+	ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+	kbenchReport(name);
+}
+
+static void waitQueue(void)
+{
+	uint32_t value;
+
+	xQueueReceive(xKbenchQueue, &value, portMAX_DELAY);
+}
+
+static void wakeQueue(void)
+{
+	uint32_t value = 0;
+
+	xQueueSendToBack(xKbenchQueue, &value, 0);
+}
+
+static void waitSemaphore(void)
+{
+	xSemaphoreTake(xKbenchSemaphore, portMAX_DELAY);
+}
+
+static void wakeSemaphore(void)
+{
+	xSemaphoreGive(xKbenchSemaphore);
+}
+
+static void waitNotify(void)
+{
+	ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+static void wakeNotify(void)
+{
+	xTaskNotifyGive(xKbenchWaiter);
+}
+
+static void waitSync(void)
+{
+	xEventGroupSync(xKbenchEvents, KBENCH_SYNC_HIGH, KBENCH_SYNC_LOW | KBENCH_SYNC_HIGH, portMAX_DELAY);
+}
+
+static void wakeSync(void)
+{
+	xEventGroupSync(xKbenchEvents, KBENCH_SYNC_LOW, KBENCH_SYNC_LOW | KBENCH_SYNC_HIGH, portMAX_DELAY);
+}
+
+#if !STOPWATCH_SIM
+static void kbenchSgiHandler(void *CallBackRef)
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	vTaskNotifyGiveFromISR(xKbenchWaiter, &xHigherPriorityTaskWoken);
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+static void wakeSgi(void)
+{
+	XScuGic_SoftwareIntr(&xInterruptController, KBENCH_SGI, XSCUGIC_SPI_CPU0_MASK);
+}
+#endif
+
+/* Higher priority task blocked in wait(), samples the time since the benchmark task called wake() */
+static void vKbenchWaiter(void *pvParameters)
+{
+	void (*wait)(void) = (void (*)(void))pvParameters;
+
+	while(1) {
+		wait();
+		kbenchRecord(kbenchNow() - ulKbenchStart);
+	}
+}
+
+static void runHandoff(const char *name, void (*wait)(void), void (*wake)(void))
+{
+	kbenchBegin(KBENCH_ITERATIONS);
+	/* Runs at once and blocks in wait() */
+	STATIC_TASK_CREATE(kbenchWaiter, vKbenchWaiter, "kbwaiter", (void*)wait, KBENCH_PRIORITY_HIGH, &xKbenchWaiter);
+
+	for(uint32_t i = 0; i < KBENCH_ITERATIONS; i++) {
+		ulKbenchStart = kbenchNow();
+		wake();
+	}
+
+	vTaskDelete(xKbenchWaiter);
+	xKbenchWaiter = NULL;
+	kbenchReport(name);
+}
+
+static void runQueue(void)
+{
+	uint32_t value = 0;
+	uint32_t start;
+
+	kbenchBegin(KBENCH_ITERATIONS);
+	for(uint32_t i = 0; i < KBENCH_ITERATIONS; i++) {
+		start = kbenchNow();
+		xQueueSendToBack(xKbenchQueue, &value, 0);
+		kbenchRecord(kbenchNow() - start);
+		xQueueReceive(xKbenchQueue, &value, 0);
+	}
+	kbenchReport("queue_send");
+
+	kbenchBegin(KBENCH_ITERATIONS);
+	for(uint32_t i = 0; i < KBENCH_ITERATIONS; i++) {
+		xQueueSendToBack(xKbenchQueue, &value, 0);
+		start = kbenchNow();
+		xQueueReceive(xKbenchQueue, &value, 0);
+		kbenchRecord(kbenchNow() - start);
+	}
+	kbenchReport("queue_receive");
+}
+
+static void runSemaphore(void)
+{
+	uint32_t start;
+
+	kbenchBegin(KBENCH_ITERATIONS);
+	for(uint32_t i = 0; i < KBENCH_ITERATIONS; i++) {
+		start = kbenchNow();
+		xSemaphoreGive(xKbenchSemaphore);
+		kbenchRecord(kbenchNow() - start);
+		xSemaphoreTake(xKbenchSemaphore, 0);
+	}
+	kbenchReport("sem_give");
+
+	kbenchBegin(KBENCH_ITERATIONS);
+	for(uint32_t i = 0; i < KBENCH_ITERATIONS; i++) {
+		xSemaphoreGive(xKbenchSemaphore);
+		start = kbenchNow();
+		xSemaphoreTake(xKbenchSemaphore, 0);
+		kbenchRecord(kbenchNow() - start);
+	}
+	kbenchReport("sem_take");
+}
+
+#if configSUPPORT_DYNAMIC_ALLOCATION == 1
+static void runHeap(void)
+{
+	static void *blocks[KBENCH_ITERATIONS];
+	uint32_t start;
+
+	kbenchBegin(KBENCH_ITERATIONS);
+	for(uint32_t i = 0; i < KBENCH_ITERATIONS; i++) {
+		start = kbenchNow();
+		blocks[i] = pvPortMalloc(KBENCH_ALLOC_SIZE);
+		kbenchRecord(kbenchNow() - start);
+		/* Free at once, the heap may be too small to hold them all */
+		vPortFree(blocks[i]);
+	}
+	kbenchReport("heap_malloc");
+
+	kbenchBegin(KBENCH_ITERATIONS);
+	for(uint32_t i = 0; i < KBENCH_ITERATIONS; i++) {
+		blocks[i] = pvPortMalloc(KBENCH_ALLOC_SIZE);
+		start = kbenchNow();
+		vPortFree(blocks[i]);
+		kbenchRecord(kbenchNow() - start);
+	}
+	kbenchReport("heap_free");
+}
+#endif
+
+static void kbenchTimerCallback(TimerHandle_t xTimer)
+{
+	(void)xTimer;
+
+	if(kbenchArmed) {
+		kbenchRecord(kbenchNow() - ulKbenchStart);
+	}
+	kbenchExpired = 1;
+}
+
+static void kbenchDeferred(void *pvParameter1, uint32_t ulParameter2)
+{
+	(void)pvParameter1;
+	(void)ulParameter2;
+
+	kbenchRecord(kbenchNow() - ulKbenchStart);
+}
+
+static void kbenchWork(void *arg)
+{
+	(void)arg;
+
+	kbenchRecord(kbenchNow() - ulKbenchStart);
+}
+
+/* Deferred function calls, both run above the benchmark task and preempt it */
+static void runDeferred(void)
+{
+	kbenchBegin(KBENCH_ITERATIONS);
+	for(uint32_t i = 0; i < KBENCH_ITERATIONS; i++) {
+		ulKbenchStart = kbenchNow();
+		xTimerPendFunctionCall(kbenchDeferred, NULL, 0, 0);
+	}
+	kbenchReport("pend_call_handoff");
+
+	kbenchBegin(KBENCH_ITERATIONS);
+	if(workqInit() != XST_SUCCESS) {
+		kbenchReport("workq_handoff");
+		return;
+	}
+	workqInitItem(&xKbenchWork, kbenchWork, NULL, WORKQ_URGENT);
+	for(uint32_t i = 0; i < KBENCH_ITERATIONS; i++) {
+		ulKbenchStart = kbenchNow();
+		workqSubmit(&xKbenchWork);
+	}
+	kbenchReport("workq_handoff");
+}
+
+/* One-shot timer of one tick. timer_start includes the timer task taking the
+ * command, it preempts the benchmark task. timer_expire times from the last
+ * counter read of the spinning benchmark task before the tick interrupt to the
+ * callback.
+ */
+static void runTimer(void)
+{
+	uint32_t start;
+
+	kbenchBegin(KBENCH_TIMER_ITERATIONS);
+	for(uint32_t i = 0; i < KBENCH_TIMER_ITERATIONS; i++) {
+		kbenchExpired = 0;
+		start = kbenchNow();
+		xTimerStart(xKbenchTimer, 0);
+		kbenchRecord(kbenchNow() - start);
+		while(!kbenchExpired) {
+		}
+	}
+	kbenchReport("timer_start");
+
+	kbenchBegin(KBENCH_TIMER_ITERATIONS);
+	kbenchArmed = 1;
+	for(uint32_t i = 0; i < KBENCH_TIMER_ITERATIONS; i++) {
+		kbenchExpired = 0;
+		xTimerStart(xKbenchTimer, 0);
+		while(!kbenchExpired) {
+			ulKbenchStart = kbenchNow();
+		}
+	}
+	kbenchArmed = 0;
+	kbenchReport("timer_expire");
+}
+
+static void vKernelBench(void *pvParameters)
+{
+	uint32_t start;
+
+	(void)pvParameters;
+
+	xKbenchQueue = STATIC_QUEUE_CREATE(kbench);
+	xKbenchSemaphore = STATIC_SEMAPHORE_CREATE_BINARY(kbench);
+	xKbenchEvents = STATIC_EVENT_GROUP_CREATE(kbench);
+	xKbenchTimer = STATIC_TIMER_CREATE(kbench, "kbtimer", 1, pdFALSE, NULL, kbenchTimerCallback);
+	configASSERT(xKbenchQueue && xKbenchSemaphore && xKbenchEvents && xKbenchTimer);
+#if !STOPWATCH_SIM
+	kbenchCounterInit();
+#endif
+
+	xil_printf("# Kernel benchmark, %s port\r\n", KBENCH_PORT);
+	xil_printf("kbench,name,unit,samples,min,median,mean,p99,max\r\n");
+
+	kbenchBegin(KBENCH_ITERATIONS);
+	for(uint32_t i = 0; i < KBENCH_ITERATIONS; i++) {
+		start = kbenchNow();
+		kbenchRecord(kbenchNow() - start);
+	}
+	kbenchReport("read_overhead");
+
+	runYield("yield_int", NULL);
+	runYield("yield_fpu", (void*)1);
+	runQueue();
+	runHandoff("queue_handoff", waitQueue, wakeQueue);
+	runSemaphore();
+	runHandoff("sem_handoff", waitSemaphore, wakeSemaphore);
+	runHandoff("notify_handoff", waitNotify, wakeNotify);
+	runHandoff("event_sync", waitSync, wakeSync);
+	runTimer();
+	runDeferred();
+#if configSUPPORT_DYNAMIC_ALLOCATION == 1
+	runHeap();
+#endif
+#if !STOPWATCH_SIM
+	/* The GIC is initialized by vTaskStartScheduler(), install the handler from the task */
+	xPortInstallInterruptHandler(KBENCH_SGI, kbenchSgiHandler, NULL);
+	vPortEnableInterrupt(KBENCH_SGI);
+	runHandoff("isr_handoff", waitNotify, wakeSgi);
+	vPortDisableInterrupt(KBENCH_SGI);
+#endif
+
+	xTimerDelete(xKbenchTimer, 0);
+	vEventGroupDelete(xKbenchEvents);
+	vSemaphoreDelete(xKbenchSemaphore);
+	vQueueDelete(xKbenchQueue);
+#if STOPWATCH_SIM
+	/* The host build runs the suite alone, see sim/kbench_main.c */
+	fflush(stdout);
+	exit(EXIT_SUCCESS);
+#endif
+	vTaskDelete(NULL);
+}
+
+/* Create the benchmark task, it runs before the stopwatch tasks as soon as the
+ * scheduler starts and deletes itself when done.
+ */
+void startKernelBenchmark(void)
+{
+	STATIC_TASK_CREATE(kbench, vKernelBench, "kbench", (void*)NULL, KBENCH_PRIORITY, &xKbenchHandler);
+}
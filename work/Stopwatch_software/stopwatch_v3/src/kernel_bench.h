@@ -0,0 +1,22 @@
+/*
+ * Kernel primitive microbenchmarks, see kernel_bench.c.
+ */
+
+#ifndef KERNEL_BENCH_H
+#define KERNEL_BENCH_H
+
+#ifndef KBENCH_ITERATIONS
+#define KBENCH_ITERATIONS	1000U	/* Samples per benchmark */
+#endif
+
+#ifndef KBENCH_TIMER_ITERATIONS
+#define KBENCH_TIMER_ITERATIONS	100U	/* Samples of the timer benchmarks, each one waits for a tick */
+#endif
+
+#ifndef KBENCH_ALLOC_SIZE
+#define KBENCH_ALLOC_SIZE	64U		/* Bytes per pvPortMalloc() */
+#endif
+
+void startKernelBenchmark(void);
+
+#endif /* KERNEL_BENCH_H */
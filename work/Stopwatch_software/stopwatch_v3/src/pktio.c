@@ -0,0 +1,521 @@
+/*
+ * Zero-copy packet I/O on the PS Ethernet MAC (GEM0).
+ *
+ * Built on the BD ring primitives of the emacps driver:
+ *
+ * - The RX ring is kept full of buffers from the pool. Received buffers are
+ *   handed to the application unchanged, and their descriptors are reposted
+ *   with fresh pool buffers in the same call.
+ * - Completed TX descriptors are not reclaimed per frame from an interrupt.
+ *   pktioSend() and pktioAlloc() reclaim them in one batch once fewer than
+ *   PKTIO_TX_RECLAIM_THRESHOLD are free or the pool runs dry.
+ * - The RX interrupt is only armed while the ring is empty. The first frame
+ *   wakes the receiving task and disables it again, and from then on
+ *   pktioReceive() polls the ring until it finds no new frame. A busy link
+ *   costs one interrupt per burst instead of one per frame.
+ * - XEmacPs_BdRingFromHwRx() and XEmacPs_BdRingFromHwTx() look at the
+ *   descriptor after the last one handed to the MAC, and the TX one also
+ *   past frames still in flight. They are only asked for as many descriptors
+ *   as the MAC holds, for TX as many as were seen sent. One descriptor of each
+ *   ring is never handed over: with all of them the ring tail is the head
+ *   again, and both stop after one descriptor.
+ *
+ * The descriptors sit in a 4 KB page mapped non-cacheable with
+ * Xil_MmuSetRegionAttributes(). The buffers stay cacheable for the protocol
+ * code, and each batch is cleaned or invalidated with one call of the
+ * Xil_DCache*Ranges() scatter list API.
+ *
+ * pktioReceive() must always be called from the same task, which owns the RX
+ * ring. The pool and the TX ring are shared and only touched in short
+ * critical sections.
+ */
+
+#ifndef STOPWATCH_AMP_CPU1
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xil_cache.h"
+#include "xil_io.h"
+#include "xil_mmu.h"
+#include "xparameters.h"
+#include "xpseudo_asm.h"
+#include "xstatus.h"
+#include "xemacps.h"
+#include "pktio.h"
+
+#define PKTIO_EMAC_ID		XPAR_XEMACPS_0_DEVICE_ID
+#define PKTIO_EMAC_INTR		XPAR_XEMACPS_0_INTR
+#define PKTIO_BD_SPACE		0x1000U	/* One page, RX ring first, TX ring at PKTIO_TX_BD_OFFSET */
+#define PKTIO_TX_BD_OFFSET	0x800U
+#define PKTIO_CACHE_LINE	32U
+#define PKTIO_BATCH			16U		/* Frames per cache maintenance call */
+#define PKTIO_LINK_TIMEOUT_MS	5000U
+
+#if ((PKTIO_RX_BDS * 8U) > PKTIO_TX_BD_OFFSET) || ((PKTIO_TX_BDS * 8U) > (PKTIO_BD_SPACE - PKTIO_TX_BD_OFFSET))
+#error Too many descriptors for the descriptor page
+#endif
+
+/* Standard PHY registers */
+#define PHY_REG_BMSR		1U
+#define PHY_REG_ID1			2U
+#define PHY_REG_ANAR		4U
+#define PHY_REG_ANLPAR		5U
+#define PHY_REG_1000_CTRL	9U
+#define PHY_REG_1000_STAT	10U
+#define PHY_BMSR_LINK		0x0004U
+#define PHY_BMSR_ANEG_DONE	0x0020U
+#define PHY_ANAR_100		0x0180U	/* 100BASE-TX full and half duplex */
+#define PHY_1000_CTRL_FD	0x0200U
+#define PHY_1000_STAT_LP_FD	0x0800U
+
+/* GEM0 reference clock divisors in the SLCR */
+#define SLCR_LOCK_OFFSET		0x004U
+#define SLCR_UNLOCK_OFFSET		0x008U
+#define SLCR_GEM0_CLK_CTRL		0x140U
+#define SLCR_LOCK_KEY			0x767BU
+#define SLCR_UNLOCK_KEY			0xDF0DU
+#define SLCR_GEM_DIV0_SHIFT		8U
+#define SLCR_GEM_DIV1_SHIFT		20U
+#define SLCR_GEM_DIV_MASK		0x3FU
+
+static XEmacPs emac;
+static uint8_t bdSpace[PKTIO_BD_SPACE] __attribute__((aligned(PKTIO_BD_SPACE)));
+static uint8_t bufPool[PKTIO_NUM_BUFS][PKTIO_BUF_SIZE] __attribute__((aligned(PKTIO_CACHE_LINE)));
+static uint8_t *freeList[PKTIO_NUM_BUFS];
+static uint32_t freeCount;
+static TaskHandle_t rxTask;
+static PktioStats_t pktioStats;
+
+/* Pool, lock held */
+static uint8_t *poolGet(void)
+{
+	return (freeCount != 0) ? freeList[--freeCount] : NULL;
+}
+
+static void poolPut(uint8_t *buf)
+{
+	freeList[freeCount++] = buf;
+}
+
+/* Called by XEmacPs_IntrHandler() */
+static void pktioRxHandler(void *CallBackRef)
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	/* The driver also calls this for a frame latched while the interrupt was off */
+	if(!(XEmacPs_ReadReg(emac.Config.BaseAddress, XEMACPS_IMR_OFFSET) & XEMACPS_IXR_FRAMERX_MASK)) {
+		XEmacPs_IntDisable(&emac, XEMACPS_IXR_FRAMERX_MASK);
+		pktioStats.ulRxInterrupts++;
+	}
+	if(rxTask != NULL) {
+		vTaskNotifyGiveFromISR(rxTask, &xHigherPriorityTaskWoken);
+	}
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/* TX completion is reclaimed lazily, the interrupt stays disabled */
+static void pktioTxHandler(void *CallBackRef)
+{
+}
+
+static void pktioErrorHandler(void *CallBackRef, u8 Direction, u32 ErrorWord)
+{
+	if(Direction == XEMACPS_RECV) {
+		pktioStats.ulRxErrors++;
+	} else {
+		pktioStats.ulTxErrors++;
+	}
+}
+
+/* Wait for auto-negotiation and return the link speed in Mbit/s, 0 on failure */
+static u16 pktioLinkUp(void)
+{
+	u16 phyId = 0xFFFFU;
+	u16 bmsr = 0;
+	u16 anar, anlpar, ctrl1000, stat1000;
+	u32 phy;
+	u32 waited;
+
+	for(phy = 0; phy < 32U; phy++) {
+		XEmacPs_PhyRead(&emac, phy, PHY_REG_ID1, &phyId);
+		if((phyId != 0xFFFFU) && (phyId != 0U)) {
+			break;
+		}
+	}
+	if(phy == 32U) {
+		return 0;
+	}
+
+	for(waited = 0; waited < PKTIO_LINK_TIMEOUT_MS; waited += 100U) {
+		XEmacPs_PhyRead(&emac, phy, PHY_REG_BMSR, &bmsr);
+		if((bmsr & (PHY_BMSR_LINK | PHY_BMSR_ANEG_DONE)) == (PHY_BMSR_LINK | PHY_BMSR_ANEG_DONE)) {
+			break;
+		}
+		vTaskDelay(pdMS_TO_TICKS(100));
+	}
+	if(waited >= PKTIO_LINK_TIMEOUT_MS) {
+		return 0;
+	}
+
+	XEmacPs_PhyRead(&emac, phy, PHY_REG_1000_CTRL, &ctrl1000);
+	XEmacPs_PhyRead(&emac, phy, PHY_REG_1000_STAT, &stat1000);
+	if((ctrl1000 & PHY_1000_CTRL_FD) && (stat1000 & PHY_1000_STAT_LP_FD)) {
+		return 1000;
+	}
+	XEmacPs_PhyRead(&emac, phy, PHY_REG_ANAR, &anar);
+	XEmacPs_PhyRead(&emac, phy, PHY_REG_ANLPAR, &anlpar);
+	return (anar & anlpar & PHY_ANAR_100) ? 100 : 10;
+}
+
+/* Match the GEM0 reference clock to the negotiated speed */
+static void pktioSetClock(u16 speed)
+{
+	u32 div0 = XPAR_XEMACPS_0_ENET_SLCR_10Mbps_DIV0;
+	u32 div1 = XPAR_XEMACPS_0_ENET_SLCR_10Mbps_DIV1;
+	u32 reg;
+
+	if(speed == 1000) {
+		div0 = XPAR_XEMACPS_0_ENET_SLCR_1000Mbps_DIV0;
+		div1 = XPAR_XEMACPS_0_ENET_SLCR_1000Mbps_DIV1;
+	} else if(speed == 100) {
+		div0 = XPAR_XEMACPS_0_ENET_SLCR_100Mbps_DIV0;
+		div1 = XPAR_XEMACPS_0_ENET_SLCR_100Mbps_DIV1;
+	}
+
+	Xil_Out32(XPS_SYS_CTRL_BASEADDR + SLCR_UNLOCK_OFFSET, SLCR_UNLOCK_KEY);
+	reg = Xil_In32(XPS_SYS_CTRL_BASEADDR + SLCR_GEM0_CLK_CTRL);
+	reg &= ~((SLCR_GEM_DIV_MASK << SLCR_GEM_DIV1_SHIFT) | (SLCR_GEM_DIV_MASK << SLCR_GEM_DIV0_SHIFT));
+	reg |= (div1 << SLCR_GEM_DIV1_SHIFT) | (div0 << SLCR_GEM_DIV0_SHIFT);
+	Xil_Out32(XPS_SYS_CTRL_BASEADDR + SLCR_GEM0_CLK_CTRL, reg);
+	Xil_Out32(XPS_SYS_CTRL_BASEADDR + SLCR_LOCK_OFFSET, SLCR_LOCK_KEY);
+}
+
+/* Post pool buffers on every free RX descriptor, RX task only */
+static void pktioRefillRx(void)
+{
+	static uint8_t *bufs[PKTIO_RX_BDS];
+	static Xil_CacheRange ranges[PKTIO_RX_BDS];
+	XEmacPs_BdRing *ring = &XEmacPs_GetRxRing(&emac);
+	XEmacPs_Bd *first;
+	XEmacPs_Bd *bd;
+	uint32_t want = (ring->FreeCnt != 0) ? ring->FreeCnt - 1U : 0;	/* One stays free */
+	uint32_t count = 0;
+
+	taskENTER_CRITICAL();
+	while(count < want) {
+		bufs[count] = poolGet();
+		if(bufs[count] == NULL) {
+			pktioStats.ulPoolEmpty++;
+			break;
+		}
+		count++;
+	}
+	taskEXIT_CRITICAL();
+
+	if(count == 0 || XEmacPs_BdRingAlloc(ring, count, &first) != XST_SUCCESS) {
+		taskENTER_CRITICAL();
+		while(count != 0) {
+			poolPut(bufs[--count]);
+		}
+		taskEXIT_CRITICAL();
+		return;
+	}
+
+	/* Drop stale lines once before the MAC owns the buffers */
+	for(uint32_t i = 0; i < count; i++) {
+		ranges[i].Addr = (INTPTR)bufs[i];
+		ranges[i].Len = PKTIO_BUF_SIZE;
+	}
+	Xil_DCacheInvalidateRanges(ranges, count);
+
+	bd = first;
+	for(uint32_t i = 0; i < count; i++) {
+		XEmacPs_BdWrite(bd, XEMACPS_BD_STAT_OFFSET, 0U);
+		/* Clears the new bit, which hands the descriptor to the MAC */
+		XEmacPs_BdWrite(bd, XEMACPS_BD_ADDR_OFFSET,
+				(XEmacPs_BdRead(bd, XEMACPS_BD_ADDR_OFFSET) & XEMACPS_RXBUF_WRAP_MASK) | (UINTPTR)bufs[i]);
+		bd = XEmacPs_BdRingNext(ring, bd);
+	}
+	dsb();
+	XEmacPs_BdRingToHw(ring, count, first);
+}
+
+/* Move received frames out of the RX ring, RX task only */
+static uint32_t pktioHarvestRx(PktFrame *frames, uint32_t max)
+{
+	Xil_CacheRange ranges[PKTIO_BATCH];
+	XEmacPs_BdRing *ring = &XEmacPs_GetRxRing(&emac);
+	XEmacPs_Bd *first;
+	XEmacPs_Bd *bd;
+	uint32_t count;
+	uint32_t got = 0;
+	uint8_t *buf;
+
+	if(max > PKTIO_BATCH) {
+		max = PKTIO_BATCH;
+	}
+	/* The driver does not stop at the last posted descriptor by itself */
+	if(max > ring->HwCnt) {
+		max = ring->HwCnt;
+	}
+	count = (max != 0) ? XEmacPs_BdRingFromHwRx(ring, max, &first) : 0;
+	if(count == 0) {
+		/* Buffers given back after the pool ran dry */
+		if(ring->FreeCnt > 1U) {
+			pktioRefillRx();
+		}
+		return 0;
+	}
+
+	bd = first;
+	for(uint32_t i = 0; i < count; i++) {
+		buf = (uint8_t *)(XEmacPs_BdGetBufAddr(bd) & XEMACPS_RXBUF_ADD_MASK);
+		if(XEmacPs_BdIsRxSOF(bd) && XEmacPs_BdIsRxEOF(bd)) {
+			frames[got].data = buf;
+			frames[got].len = XEmacPs_BdGetLength(bd);
+			/* Lines speculatively filled while the MAC was writing */
+			ranges[got].Addr = (INTPTR)buf;
+			ranges[got].Len = (frames[got].len + PKTIO_CACHE_LINE - 1U) & ~(PKTIO_CACHE_LINE - 1U);
+			got++;
+		} else {
+			pktioStats.ulRxDropped++;
+			taskENTER_CRITICAL();
+			poolPut(buf);
+			taskEXIT_CRITICAL();
+		}
+		bd = XEmacPs_BdRingNext(ring, bd);
+	}
+	XEmacPs_BdRingFree(ring, count, first);
+
+	Xil_DCacheInvalidateRanges(ranges, got);
+	pktioRefillRx();
+
+	pktioStats.ulRxFrames += got;
+	return got;
+}
+
+/* Return the buffers of transmitted frames to the pool, lock held */
+static uint32_t pktioReclaimTxLocked(void)
+{
+	XEmacPs_BdRing *ring = &XEmacPs_GetTxRing(&emac);
+	XEmacPs_Bd *first;
+	XEmacPs_Bd *bd = ring->HwHead;
+	uint32_t count = 0;
+
+	/* Sent frames are at the head, one descriptor each */
+	while(count < ring->HwCnt && (XEmacPs_BdRead(bd, XEMACPS_BD_STAT_OFFSET) & XEMACPS_TXBUF_USED_MASK)) {
+		count++;
+		bd = XEmacPs_BdRingNext(ring, bd);
+	}
+	if(count == 0 || XEmacPs_BdRingFromHwTx(ring, count, &first) != count) {
+		return 0;
+	}
+	bd = first;
+	for(uint32_t i = 0; i < count; i++) {
+		poolPut((uint8_t *)XEmacPs_BdGetBufAddr(bd));
+		bd = XEmacPs_BdRingNext(ring, bd);
+	}
+	XEmacPs_BdRingFree(ring, count, first);
+	return count;
+}
+
+/* Bring up the PHY link and the MAC. Blocks for up to PKTIO_LINK_TIMEOUT_MS, so
+ * it has to run in a task.
+ */
+int pktioInit(const uint8_t mac[6])
+{
+	XEmacPs_Config *config;
+	XEmacPs_Bd bdTemplate;
+	u16 speed;
+
+	freeCount = 0;
+	for(uint32_t i = PKTIO_NUM_BUFS; i != 0; i--) {
+		poolPut(bufPool[i - 1]);
+	}
+
+	if(Xil_MmuSetRegionAttributes((INTPTR)bdSpace, sizeof(bdSpace), NORM_NONCACHE) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	config = XEmacPs_LookupConfig(PKTIO_EMAC_ID);
+	if(config == NULL || XEmacPs_CfgInitialize(&emac, config, config->BaseAddress) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	XEmacPs_SetMacAddress(&emac, (void *)mac, 1);
+	XEmacPs_SetMdioDivisor(&emac, MDC_DIV_224);
+	XEmacPs_SetHandler(&emac, XEMACPS_HANDLER_DMARECV, (void *)pktioRxHandler, NULL);
+	XEmacPs_SetHandler(&emac, XEMACPS_HANDLER_DMASEND, (void *)pktioTxHandler, NULL);
+	XEmacPs_SetHandler(&emac, XEMACPS_HANDLER_ERROR, (void *)pktioErrorHandler, NULL);
+
+	/* RX descriptors start with the new bit, the MAC skips them until posted */
+	XEmacPs_BdClear(&bdTemplate);
+	XEmacPs_BdWrite(&bdTemplate, XEMACPS_BD_ADDR_OFFSET, XEMACPS_RXBUF_NEW_MASK);
+	if(XEmacPs_BdRingCreate(&XEmacPs_GetRxRing(&emac), (UINTPTR)bdSpace, (UINTPTR)bdSpace,
+			XEMACPS_BD_ALIGNMENT, PKTIO_RX_BDS) != XST_SUCCESS ||
+			XEmacPs_BdRingClone(&XEmacPs_GetRxRing(&emac), &bdTemplate, XEMACPS_RECV) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	XEmacPs_BdClear(&bdTemplate);
+	XEmacPs_BdSetStatus(&bdTemplate, XEMACPS_TXBUF_USED_MASK);
+	if(XEmacPs_BdRingCreate(&XEmacPs_GetTxRing(&emac), (UINTPTR)&bdSpace[PKTIO_TX_BD_OFFSET],
+			(UINTPTR)&bdSpace[PKTIO_TX_BD_OFFSET], XEMACPS_BD_ALIGNMENT, PKTIO_TX_BDS) != XST_SUCCESS ||
+			XEmacPs_BdRingClone(&XEmacPs_GetTxRing(&emac), &bdTemplate, XEMACPS_SEND) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	speed = pktioLinkUp();
+	if(speed == 0) {
+		return XST_FAILURE;
+	}
+	XEmacPs_SetOperatingSpeed(&emac, speed);
+	pktioSetClock(speed);
+
+	rxTask = NULL;
+	pktioRefillRx();
+
+	if(xPortInstallInterruptHandler(PKTIO_EMAC_INTR, XEmacPs_IntrHandler, &emac) != pdPASS) {
+		return XST_FAILURE;
+	}
+	vPortEnableInterrupt(PKTIO_EMAC_INTR);
+	XEmacPs_Start(&emac);
+	/* RX is armed by pktioReceive() when the ring runs empty, TX is reclaimed lazily */
+	XEmacPs_IntDisable(&emac, XEMACPS_IXR_FRAMERX_MASK | XEMACPS_IXR_TXCOMPL_MASK);
+
+	return XST_SUCCESS;
+}
+
+/* Return up to max received frames, waiting up to wait ticks when none is
+ * pending. Each frame must be given back with pktioFree().
+ */
+uint32_t pktioReceive(PktFrame *frames, uint32_t max, TickType_t wait)
+{
+	uint32_t got;
+
+	rxTask = xTaskGetCurrentTaskHandle();
+
+	got = pktioHarvestRx(frames, max);
+	if(got != 0) {
+		pktioStats.ulRxPolls++;
+		return got;
+	}
+
+	for(;;) {
+		/* Idle: arm the interrupt, then look again to close the race */
+		XEmacPs_WriteReg(emac.Config.BaseAddress, XEMACPS_ISR_OFFSET, XEMACPS_IXR_FRAMERX_MASK);
+		XEmacPs_IntEnable(&emac, XEMACPS_IXR_FRAMERX_MASK);
+		got = pktioHarvestRx(frames, max);
+		if(got != 0) {
+			XEmacPs_IntDisable(&emac, XEMACPS_IXR_FRAMERX_MASK);
+			return got;
+		}
+
+		if(ulTaskNotifyTake(pdTRUE, wait) == 0) {
+			return 0;
+		}
+		got = pktioHarvestRx(frames, max);
+		if(got != 0) {
+			return got;
+		}
+	}
+}
+
+/* Take a buffer for a frame to send, NULL when the pool is empty */
+uint8_t *pktioAlloc(void)
+{
+	uint8_t *buf;
+
+	taskENTER_CRITICAL();
+	buf = poolGet();
+	if(buf == NULL && pktioReclaimTxLocked() != 0) {
+		buf = poolGet();
+	}
+	if(buf == NULL) {
+		pktioStats.ulPoolEmpty++;
+	}
+	taskEXIT_CRITICAL();
+	return buf;
+}
+
+/* Give back a received frame or an unsent buffer */
+void pktioFree(uint8_t *buf)
+{
+	taskENTER_CRITICAL();
+	poolPut(buf);
+	taskEXIT_CRITICAL();
+}
+
+/* Queue frames built in pool buffers. Returns how many were queued; the rest
+ * (when the TX ring is full) still belong to the caller.
+ */
+uint32_t pktioSend(const PktFrame *frames, uint32_t count)
+{
+	Xil_CacheRange ranges[PKTIO_BATCH];
+	XEmacPs_BdRing *ring = &XEmacPs_GetTxRing(&emac);
+	XEmacPs_Bd *first;
+	XEmacPs_Bd *bd;
+	uint32_t sent = 0;
+	uint32_t n;
+
+	while(sent < count) {
+		n = count - sent;
+		if(n > PKTIO_BATCH) {
+			n = PKTIO_BATCH;
+		}
+		for(uint32_t i = 0; i < n; i++) {
+			ranges[i].Addr = (INTPTR)frames[sent + i].data;
+			ranges[i].Len = frames[sent + i].len;
+		}
+		Xil_DCacheFlushRanges(ranges, n);
+
+		taskENTER_CRITICAL();
+		if(ring->FreeCnt < PKTIO_TX_RECLAIM_THRESHOLD) {
+			pktioReclaimTxLocked();
+		}
+		if(n >= ring->FreeCnt) {
+			n = (ring->FreeCnt != 0) ? ring->FreeCnt - 1U : 0;	/* One stays free */
+		}
+		if(n == 0 || XEmacPs_BdRingAlloc(ring, n, &first) != XST_SUCCESS) {
+			pktioStats.ulTxRingFull += count - sent;
+			taskEXIT_CRITICAL();
+			break;
+		}
+		bd = first;
+		for(uint32_t i = 0; i < n; i++) {
+			XEmacPs_BdSetAddressTx(bd, (UINTPTR)frames[sent + i].data);
+			/* Clears the used bit, which hands the descriptor to the MAC */
+			XEmacPs_BdWrite(bd, XEMACPS_BD_STAT_OFFSET,
+					(XEmacPs_BdRead(bd, XEMACPS_BD_STAT_OFFSET) & XEMACPS_TXBUF_WRAP_MASK) |
+					XEMACPS_TXBUF_LAST_MASK | frames[sent + i].len);
+			bd = XEmacPs_BdRingNext(ring, bd);
+		}
+		XEmacPs_BdRingToHw(ring, n, first);
+		pktioStats.ulTxFrames += n;
+		taskEXIT_CRITICAL();
+
+		dsb();
+		XEmacPs_Transmit(&emac);
+		sent += n;
+	}
+	return sent;
+}
+
+/* Reclaim transmitted buffers now, returns how many were freed */
+uint32_t pktioReclaimTx(void)
+{
+	uint32_t count;
+
+	taskENTER_CRITICAL();
+	count = pktioReclaimTxLocked();
+	taskEXIT_CRITICAL();
+	return count;
+}
+
+void pktioGetStats(PktioStats_t *stats)
+{
+	taskENTER_CRITICAL();
+	*stats = pktioStats;
+	taskEXIT_CRITICAL();
+}
+
+#endif /* STOPWATCH_AMP_CPU1 */
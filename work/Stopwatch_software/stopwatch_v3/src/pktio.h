@@ -0,0 +1,62 @@
+/*
+ * Zero-copy packet I/O on the PS Ethernet MAC (GEM0), see pktio.c.
+ *
+ * Frames live in fixed size buffers from one static pool. pktioReceive() hands
+ * the received buffers to the caller as they are; the caller gives each back
+ * with pktioFree() once done, which recycles it into the RX ring. For sending,
+ * take a buffer with pktioAlloc(), build the frame in place and queue it with
+ * pktioSend(); the buffer returns to the pool when its TX descriptor is
+ * reclaimed.
+ */
+
+#ifndef PKTIO_H
+#define PKTIO_H
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+#ifndef PKTIO_RX_BDS
+#define PKTIO_RX_BDS	64U	/* RX descriptors, all but one kept posted with a buffer */
+#endif
+
+#ifndef PKTIO_TX_BDS
+#define PKTIO_TX_BDS	64U	/* TX descriptors, up to PKTIO_TX_BDS - 1 frames queued */
+#endif
+
+#ifndef PKTIO_NUM_BUFS
+#define PKTIO_NUM_BUFS	(PKTIO_RX_BDS + PKTIO_TX_BDS + 32U)	/* Pool size, the extra buffers are held by the application */
+#endif
+
+#define PKTIO_BUF_SIZE	1536U	/* One untagged frame without FCS fits, a multiple of the cache line */
+
+/* Completed TX descriptors are reclaimed once fewer than this many are free */
+#ifndef PKTIO_TX_RECLAIM_THRESHOLD
+#define PKTIO_TX_RECLAIM_THRESHOLD	(PKTIO_TX_BDS / 4U)
+#endif
+
+typedef struct {
+	uint8_t *data;
+	uint32_t len;
+} PktFrame;
+
+typedef struct {
+	uint32_t ulRxFrames;		/* Frames handed to the application */
+	uint32_t ulTxFrames;		/* Frames queued for transmission */
+	uint32_t ulRxInterrupts;	/* RX interrupts, one per idle to busy transition */
+	uint32_t ulRxPolls;			/* pktioReceive() calls that found frames without waiting */
+	uint32_t ulRxErrors;		/* RX error status, including no buffer available */
+	uint32_t ulTxErrors;		/* TX error status */
+	uint32_t ulRxDropped;		/* Frames spanning several buffers, dropped */
+	uint32_t ulTxRingFull;		/* Frames refused because no TX descriptor was free */
+	uint32_t ulPoolEmpty;		/* pktioAlloc() or RX refills that found no buffer */
+} PktioStats_t;
+
+int pktioInit(const uint8_t mac[6]);
+uint32_t pktioReceive(PktFrame *frames, uint32_t max, TickType_t wait);
+uint8_t *pktioAlloc(void);
+void pktioFree(uint8_t *buf);
+uint32_t pktioSend(const PktFrame *frames, uint32_t count);
+uint32_t pktioReclaimTx(void);
+void pktioGetStats(PktioStats_t *stats);
+
+#endif /* PKTIO_H */
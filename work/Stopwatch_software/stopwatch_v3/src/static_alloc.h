@@ -0,0 +1,118 @@
+/*
+ * Kernel objects in static storage (configSUPPORT_STATIC_ALLOCATION).
+ *
+ * The storage of each task, queue, semaphore, event group and timer is
+ * declared at file scope with one of the STATIC_xxx(name, ...) macros, sized
+ * at compile time, and the object is created in it with the matching
+ * STATIC_xxx_CREATE(name, ...). The static build of the Zynq has no heap
+ * (configSUPPORT_DYNAMIC_ALLOCATION 0, selected with -D, see FreeRTOSConfig.h
+ * of the BSP): startup cannot run out of memory and tools/ram_report.py lists
+ * every object from the ELF, as nameTcb, nameStack, nameQueue, nameStorage...
+ *
+ * Task stacks are sized with portSTATIC_STACK_WORDS(), with room for MMU guard
+ * pages when configUSE_STACK_GUARD_PAGES is 1. The storage of a task is used
+ * again only once the task is deleted by another task: the idle task frees a
+ * task that deleted itself, so such a task needs storage of its own each time
+ * it is created.
+ *
+ * Without static allocation (the host simulation by default) the same lines
+ * create the objects from the heap.
+ */
+
+#ifndef STATIC_ALLOC_H
+#define STATIC_ALLOC_H
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+#include "timers.h"
+
+/* Ports without guard pages (POSIX) */
+#ifndef portSTATIC_STACK_WORDS
+#define portSTATIC_STACK_WORDS(uxDepth)	(uxDepth)
+#define portSTATIC_STACK_ATTRIBUTES
+#define pxPortStaticStack(pxBuffer, ulBufferWords, pulStackDepth)	(*(pulStackDepth) = (ulBufferWords), (pxBuffer))
+#endif
+
+#if configSUPPORT_STATIC_ALLOCATION == 1
+
+/* Create a task in a stack of portSTATIC_STACK_WORDS() words */
+static inline BaseType_t staticTaskCreate(TaskFunction_t fn, const char *label, StackType_t *stack,
+		uint32_t stackWords, void *arg, UBaseType_t priority, StaticTask_t *tcb, TaskHandle_t *handle)
+{
+	uint32_t depth;
+	StackType_t *base = pxPortStaticStack(stack, stackWords, &depth);
+	TaskHandle_t task = xTaskCreateStatic(fn, label, depth, arg, priority, base, tcb);
+
+	if(handle != NULL) {
+		*handle = task;
+	}
+	return task != NULL ? pdPASS : pdFAIL;
+}
+
+#define STATIC_TASK(name, depth) \
+	static StaticTask_t name##Tcb; \
+	static StackType_t name##Stack[portSTATIC_STACK_WORDS(depth)] portSTATIC_STACK_ATTRIBUTES
+#define STATIC_TASK_CREATE(name, fn, label, arg, priority, handle) \
+	staticTaskCreate((fn), (label), name##Stack, sizeof(name##Stack) / sizeof(StackType_t), \
+			(arg), (priority), &name##Tcb, (handle))
+
+/* count tasks of the same stack depth, created by index */
+#define STATIC_TASKS(name, count, depth) \
+	static StaticTask_t name##Tcb[count]; \
+	static StackType_t name##Stack[count][portSTATIC_STACK_WORDS(depth)] portSTATIC_STACK_ATTRIBUTES
+#define STATIC_TASKS_CREATE(name, i, fn, label, arg, priority, handle) \
+	staticTaskCreate((fn), (label), name##Stack[i], sizeof(name##Stack[0]) / sizeof(StackType_t), \
+			(arg), (priority), &name##Tcb[i], (handle))
+
+#define STATIC_QUEUE(name, length, itemSize) \
+	enum { name##Length = (length), name##ItemSize = (itemSize) }; \
+	static StaticQueue_t name##Queue; \
+	static uint8_t name##Storage[(length) * (itemSize)]
+#define STATIC_QUEUE_CREATE(name) \
+	xQueueCreateStatic(name##Length, name##ItemSize, name##Storage, &name##Queue)
+
+#define STATIC_SEMAPHORE(name)				static StaticSemaphore_t name##Semaphore
+#define STATIC_SEMAPHORE_CREATE_BINARY(name)	xSemaphoreCreateBinaryStatic(&name##Semaphore)
+
+#define STATIC_EVENT_GROUP(name)			static StaticEventGroup_t name##Events
+#define STATIC_EVENT_GROUP_CREATE(name)		xEventGroupCreateStatic(&name##Events)
+
+#define STATIC_TIMER(name)					static StaticTimer_t name##Timer
+#define STATIC_TIMER_CREATE(name, label, period, autoReload, id, callback) \
+	xTimerCreateStatic((label), (period), (autoReload), (id), (callback), &name##Timer)
+
+#else
+
+/* Only the sizes are kept, the other storage macros just name its type */
+#define STATIC_TASK(name, depth) \
+	enum { name##Depth = (depth) }
+#define STATIC_TASK_CREATE(name, fn, label, arg, priority, handle) \
+	xTaskCreate((fn), (label), name##Depth, (arg), (priority), (handle))
+
+#define STATIC_TASKS(name, count, depth) \
+	enum { name##Depth = (depth) }
+#define STATIC_TASKS_CREATE(name, i, fn, label, arg, priority, handle) \
+	((void)(i), xTaskCreate((fn), (label), name##Depth, (arg), (priority), (handle)))
+
+#define STATIC_QUEUE(name, length, itemSize) \
+	enum { name##Length = (length), name##ItemSize = (itemSize) }
+#define STATIC_QUEUE_CREATE(name) \
+	xQueueCreate(name##Length, name##ItemSize)
+
+#define STATIC_SEMAPHORE(name)				typedef StaticSemaphore_t name##Semaphore##_t
+#define STATIC_SEMAPHORE_CREATE_BINARY(name)	xSemaphoreCreateBinary()
+
+#define STATIC_EVENT_GROUP(name)			typedef StaticEventGroup_t name##Events##_t
+#define STATIC_EVENT_GROUP_CREATE(name)		xEventGroupCreate()
+
+#define STATIC_TIMER(name)					typedef StaticTimer_t name##Timer##_t
+#define STATIC_TIMER_CREATE(name, label, period, autoReload, id, callback) \
+	xTimerCreate((label), (period), (autoReload), (id), (callback))
+
+#endif /* configSUPPORT_STATIC_ALLOCATION */
+
+#endif /* STATIC_ALLOC_H */
@@ -0,0 +1,115 @@
+/*
+ * CPU1 side of the AMP stopwatch (bare-metal, standalone BSP for ps7_cortexa9_1).
+ *
+ * Built from the same sources as the CPU0 application with STOPWATCH_AMP_CPU1
+ * defined, USE_AMP=1 for the BSP and lscript_cpu1.ld as linker script. CPU1
+ * owns the AXI timer: it applies the button commands sent by CPU0 and publishes
+ * the 64-bit timer value every AMP_CAPTURE_PERIOD_US, so capture latency does
+ * not depend on the UART and display load of CPU0.
+ */
+
+#ifdef STOPWATCH_AMP_CPU1
+
+#include <stdint.h>
+#include "xparameters.h"
+#include "xscugic.h"
+#include "xtime_l.h"
+#include "xtmrctr.h"
+#include "xtmrctr_l.h"
+#include "amp_mailbox.h"
+#include "clocksource.h"
+
+#define AMP_CAPTURE_PERIOD_US	1000U	/* Time snapshot rate sent to CPU0 */
+
+static XTmrCtr TimerCounter;
+static XScuGic Gic;
+
+/* Same cascade (64-bit) configuration as configTmrCtr() on the single core build */
+static void cpu1TimerInit(void)
+{
+	XTmrCtr_Initialize(&TimerCounter, XPAR_TMRCTR_0_DEVICE_ID);
+	XTmrCtr_SetOptions(&TimerCounter, 0, XTC_INT_MODE_OPTION | XTC_AUTO_RELOAD_OPTION | XTC_CASCADE_MODE_OPTION);
+	XTmrCtr_SetResetValue(&TimerCounter, 0, 0);
+	XTmrCtr_SetResetValue(&TimerCounter, 1, 0);
+}
+
+/* Only needed to send SGIs, the distributor is owned and configured by CPU0 */
+static void cpu1GicInit(void)
+{
+	XScuGic_Config *config = XScuGic_LookupConfig(XPAR_SCUGIC_SINGLE_DEVICE_ID);
+	XScuGic_CfgInitialize(&Gic, config, config->CpuBaseAddress);
+}
+
+/* Same button semantics as vTimerControl() */
+static void cpu1HandleButton(uint32_t button)
+{
+	uint32_t lastTime;
+
+	switch(button) {
+		case 1:
+			XTmrCtr_Stop(&TimerCounter, 0);
+			break;
+		case 2:
+			lastTime = XTmrCtr_GetValue(&TimerCounter, 0);
+			XTmrCtr_WriteReg(TimerCounter.BaseAddress, 0, XTC_TLR_OFFSET, lastTime);
+			XTmrCtr_Start(&TimerCounter, 0);
+			break;
+		case 4:
+			XTmrCtr_Stop(&TimerCounter, 0);
+			XTmrCtr_SetResetValue(&TimerCounter, 0, 0);
+			XTmrCtr_SetResetValue(&TimerCounter, 1, 0);
+			XTmrCtr_Reset(&TimerCounter, 0);
+			XTmrCtr_Reset(&TimerCounter, 1);
+			break;
+		default:
+			break;
+	}
+}
+
+int main(void)
+{
+	AmpMessage msg;
+	XTime now;
+	XTime nextCapture;
+	const XTime capturePeriod = (XTime)COUNTS_PER_SECOND * AMP_CAPTURE_PERIOD_US / 1000000U;
+
+	ampMapSharedMemory();
+
+	/* CPU0 initializes the mailbox before releasing this core, wait in case
+	 * CPU1 was started by the debugger first.
+	 */
+	while(!ampMailboxIsReady()) {
+	}
+
+	cpu1TimerInit();
+	clocksourceInit(&TimerCounter);
+	cpu1GicInit();
+
+	XTime_GetTime(&nextCapture);
+
+	while(1) {
+		/* Commands from CPU0 */
+		while(ampRingPop(&AMP_MAILBOX->toCpu1, &msg)) {
+			if(msg.type == AMP_MSG_BUTTON) {
+				cpu1HandleButton(msg.arg);
+			}
+		}
+
+		/* Periodic time snapshot to CPU0 */
+		XTime_GetTime(&now);
+		if(now >= nextCapture) {
+			nextCapture += capturePeriod;
+
+			msg.type = AMP_MSG_TIME;
+			msg.arg = 0;
+			msg.time = clocksourceRead(&clocksourceAxi);
+			if(ampRingPush(&AMP_MAILBOX->toCpu0, &msg)) {
+				ampRingDoorbell(&Gic, AMP_DOORBELL_TO_CPU0, XSCUGIC_SPI_CPU0_MASK);
+			}
+		}
+	}
+
+	return 0;
+}
+
+#endif /* STOPWATCH_AMP_CPU1 */
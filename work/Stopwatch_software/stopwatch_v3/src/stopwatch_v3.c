@@ -16,8 +16,15 @@
  *   uartns550   9600
  *   uartlite    Configurable only in HW design
  *   ps7_uart    115200 (configured by bootrom/bsp)
+ *
+ * Build with STOPWATCH_AMP=1 to run the AXI timer on CPU1 (stopwatch_cpu1.c)
+ * and keep only the buttons, LEDs and display on this core. That build links
+ * with lscript_amp.ld, which leaves the upper DDR to the CPU1 image.
  */
 
+/* The CPU1 image of the AMP build is compiled from the same directory */
+#ifndef STOPWATCH_AMP_CPU1
+
 #include <stdio.h>
 #include <time.h>	// class needs this inclusion
 #include <stdbool.h>
@@ -27,6 +34,7 @@
 #include "task.h"
 #include "queue.h"
 #include "timers.h"
+#include "static_alloc.h"
 /* Xilinx includes. */
 #include "sleep.h"
 #include "xil_printf.h"
@@ -37,6 +45,114 @@
 #include "xtmrctr.h"
 #include "xtmrctr_l.h"
 
+#ifndef STOPWATCH_AMP
+#define STOPWATCH_AMP	0	/* 1: AXI timer handled by CPU1 through the OCM mailbox */
+#endif
+
+#if STOPWATCH_AMP && configNUMBER_OF_CORES > 1
+#error STOPWATCH_AMP needs CPU1, which the SMP scheduler runs tasks on
+#endif
+
+#if STOPWATCH_AMP
+#include "xscugic.h"
+#include "amp_mailbox.h"
+#endif
+
+#ifndef STOPWATCH_CTXSWITCH_BENCH
+#define STOPWATCH_CTXSWITCH_BENCH	0	/* 1: measure the context switch cost before starting the stopwatch */
+#endif
+
+#if STOPWATCH_CTXSWITCH_BENCH
+#include "ctxswitch_bench.h"
+#endif
+
+#ifndef STOPWATCH_IRQ_BENCH
+#define STOPWATCH_IRQ_BENCH	0	/* 1: measure the interrupt to task notification time before starting the stopwatch */
+#endif
+
+#if STOPWATCH_IRQ_BENCH
+#include "irq_bench.h"
+#endif
+
+#ifndef STOPWATCH_KERNEL_BENCH
+#define STOPWATCH_KERNEL_BENCH	0	/* 1: run the kernel primitive benchmarks before starting the stopwatch, see kernel_bench.c */
+#endif
+
+#if STOPWATCH_KERNEL_BENCH
+#include "kernel_bench.h"
+#endif
+
+#ifndef STOPWATCH_BUFFERED_CONSOLE
+#define STOPWATCH_BUFFERED_CONSOLE	0	/* 1: xil_printf output drained by the UART interrupt once the tasks are created */
+#endif
+
+#ifndef STOPWATCH_NET
+#define STOPWATCH_NET	0	/* 1: bring up GEM0 and serve frames through pktio.c */
+#endif
+
+#if STOPWATCH_NET
+#include "pktio.h"
+
+#define NET_MAC_ADDR	{ 0x00, 0x0A, 0x35, 0x00, 0x01, 0x02 }
+#define NET_RX_BATCH	16	/* Frames taken from pktioReceive() at a time */
+
+#ifndef STOPWATCH_TELEMETRY
+#define STOPWATCH_TELEMETRY	0	/* 1: stream time snapshots, button events and task statistics over UDP, see telemetry.h */
+#endif
+#endif
+
+#if STOPWATCH_NET && STOPWATCH_TELEMETRY
+#include "telemetry.h"
+#endif
+
+#ifndef STOPWATCH_DMA_COPY
+#define STOPWATCH_DMA_COPY	0	/* 1: offload large copies to the PS DMA controller, see dmacopy.h */
+#endif
+
+#if STOPWATCH_DMA_COPY
+#include "dmacopy.h"
+#endif
+
+#ifndef STOPWATCH_WORKQ
+#define STOPWATCH_WORKQ	0	/* 1: prioritised worker tasks for deferred interrupt work, see workq.h */
+#endif
+
+#if STOPWATCH_WORKQ
+#include "workq.h"
+#endif
+
+#ifndef STOPWATCH_SIM
+#define STOPWATCH_SIM	0	/* 1: host build on the FreeRTOS POSIX port with modelled peripherals, see sim/sim.h */
+#endif
+
+#if STOPWATCH_SIM
+#include "sim.h"
+#endif
+
+#include "clocksource.h"
+#include "console.h"
+#if CONSOLE_USB
+#include "usbcdc.h"
+#endif
+#include "dlog.h"	/* DLOG_ENABLE: run time output sent as binary records for tools/dlog_decode.py */
+
+#define STATS_PERIOD_MS	10000UL	/* Interrupt, profiling and console statistics dump period */
+#define SAMPLER_DUMP_PERIODS	6	/* Sampling profiler dump every this many statistics periods */
+#define BUTTON_POLL_US	1000U	/* Button sampling period with the high resolution timer (configUSE_HR_TIMER) */
+
+/* Code regions measured with the PMU (configUSE_PMU_PROFILING) */
+#define PROFILE_FORMAT_TIME	0	/* Time formatting and output */
+#define PROFILE_QUEUE_SEND	1	/* Timer value copy into xTimerValueDisplayQueue */
+#define PROFILE_NET_RX		2	/* Received frame batch handling, divide by the frame count for the cost per packet */
+
+#if configUSE_PMU_PROFILING == 1
+#define PROFILE_BEGIN(region)	vPortProfileRegionBegin(region)
+#define PROFILE_END(region)		vPortProfileRegionEnd(region)
+#else
+#define PROFILE_BEGIN(region)
+#define PROFILE_END(region)
+#endif
+
 #define TIMER_ID	1
 #define DELAY_10_SECONDS	10000UL
 #define DELAY_1_SECOND		1000UL
@@ -60,6 +176,15 @@ QueueHandle_t xButtonLedQueue; /* sends button state to led task */
 QueueHandle_t xButtonTimerControlQueue; /* sends button state to timer control task */
 QueueHandle_t xTimerValueDisplayQueue; /* sends button state to timer display task */
 
+STATIC_QUEUE(buttonLed, 1, sizeof(int32_t));
+STATIC_QUEUE(buttonTimerControl, 1, sizeof(int32_t));
+STATIC_QUEUE(timerValueDisplay, 1, sizeof(uint64_t));
+
+#if STOPWATCH_AMP
+extern XScuGic xInterruptController; /* GIC instance set up by the FreeRTOS port */
+TaskHandle_t xAmpDisplayTask = NULL; /* woken by the CPU1 doorbell */
+#endif
+
 
 /* Initialize gpio (buttons + LEDs) and the AXI Timer + check if they were initialized
  * successfully.
@@ -115,6 +240,9 @@ void vReadButtons(void* pvParameters)
     while(1)
 	{
 		uint32_t button = XGpio_DiscreteRead(&gpio, 2);
+#if STOPWATCH_NET && STOPWATCH_TELEMETRY
+		telemetryButton(button);
+#endif
 
 		/* Check that any button is pressed, but only one at a time
 		 * button == 1 -> STOP AXI TIMER (STOPWATCH)
@@ -126,8 +254,19 @@ void vReadButtons(void* pvParameters)
 		{
 			/* Send button press to vLedDisplay and vTimerControl */
 			xQueueSendToBack(xButtonLedQueue, (void*)&button, (TickType_t)0);
+#if STOPWATCH_AMP
+			/* The timer runs on CPU1, forward the command through the mailbox */
+			AmpMessage msg = { AMP_MSG_BUTTON, button, 0 };
+			ampRingPush(&AMP_MAILBOX->toCpu1, &msg);
+#else
 			xQueueSendToBack(xButtonTimerControlQueue, (void*)&button, (TickType_t)0);
+#endif
 		}
+#if configUSE_HR_TIMER == 1
+		/* Below the tick period, so the button latency stays under a millisecond
+		 * without spinning on the GPIO */
+		vTaskDelayUs(BUTTON_POLL_US);
+#endif
 	}
 }
 
@@ -181,24 +320,10 @@ void XTmrCtr_SetCompareRegisterToLastValue(XTmrCtr *TmrCtrInstancePtr)
 	XTmrCtr_WriteReg(TmrCtrInstancePtr->BaseAddress, 0, XTC_TLR_OFFSET, lastTime);
 }
 
-/* Because of the high clock frequency of IN/OUT (100 MHz) it was needed to operate the
- * counter on 64-bit mode. The timer has two counters TMRCTR0 and TMRCTR1. Counters are
- * configured to work in cascade mode. When TMRCTR0 overflows, TMRCTR1 receives the
- * carry-out bit and increments its value.
- */
-uint64_t XTmrCtr_GetValue64(XTmrCtr *TmrCtrInstancePtr)
-{
-	/* Get the low timer (TMRCTR0) and the high timer (TMRCTR1) values and store in low and high vars */
-	uint32_t low = XTmrCtr_GetValue(&TimerCounter, 0);
-	uint32_t high = XTmrCtr_GetValue(&TimerCounter, 1);
-	/* Concatenate both high and low registers values in a single 64 bit register */
-	uint64_t time = ((uint64_t)high << 32) | (uint64_t)low;
-	return time;
-}
-
 void vTimerControl()
 {
 	XTmrCtr *TmrCtrInstancePtr = &TimerCounter;
+	bool running = false;
 
 	while(1){
 
@@ -211,13 +336,16 @@ void vTimerControl()
 			switch(button) {
 				case 1:
 					XTmrCtr_Stop(TmrCtrInstancePtr, 0); /* Stops the low AXI timer (TMRCTR0)*/
+					running = false;
 					break;
 				case 2:
 					XTmrCtr_SetCompareRegisterToLastValue(TmrCtrInstancePtr); /* Save the last known value to the internal compare register */
 					XTmrCtr_Start(TmrCtrInstancePtr, 0); /* Starts the low AXI timer from the compare register value */
+					running = true;
 					break;
 				case 4:
 					XTmrCtr_Stop(TmrCtrInstancePtr, 0); /* Stops the low AXI timer */
+					running = false;
 					XTmrCtr_SetResetValue(TmrCtrInstancePtr, 0, 0); /* Sets the low timer reset value to 0 */
 					XTmrCtr_SetResetValue(TmrCtrInstancePtr, 0, 1); /* Sets the high timer reset value to 0 */
 					XTmrCtr_Reset(TmrCtrInstancePtr, 0); /* Reset the low timer (set to reset value) */
@@ -228,71 +356,416 @@ void vTimerControl()
 				default:
 					break;
 			}
+			/* Drift is only measured over uninterrupted runs */
+			clocksourceDriftReset();
 		}
 
 		/* Send timer value to vTimerDisplay */
-		uint64_t time = XTmrCtr_GetValue64(&TimerCounter);
+		uint64_t time = clocksourceRead(&clocksourceAxi);
+		if(running) {
+			clocksourceDriftSample();
+		}
+		PROFILE_BEGIN(PROFILE_QUEUE_SEND);
 		xQueueSendToBack(xTimerValueDisplayQueue, (void*)&time, (TickType_t)0);
+		PROFILE_END(PROFILE_QUEUE_SEND);
 	}
 }
+/* Split a stopwatch time into whole seconds and milliseconds. The
+ * milliseconds stay 64-bit up to the one divide, 32 bits of them would wrap
+ * after 49.7 days; the seconds fit 32 bits for 136 years. */
+static uint32_t splitTime(uint64_t time, uint32_t *milis)
+{
+	uint64_t totalMilis = clocksourceToMs(&clocksourceAxi, time);
+	uint64_t totalSeconds = totalMilis / MS_PER_SEC;
+
+	*milis = (uint32_t)(totalMilis - totalSeconds * MS_PER_SEC);
+	return (uint32_t)totalSeconds;
+}
+
 /* Format the time into HH:MM:SS:MSMSMS */
 void FormatTime(uint64_t time, char* buffer)
 {
-	uint64_t totalSeconds = time / XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ;
-	uint64_t milis = (time % XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ) / (XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ / MS_PER_SEC);
-	uint64_t hours = totalSeconds / SEC_PER_H;
-	uint64_t minutes = (totalSeconds % SEC_PER_H) / SEC_PER_MIN;
-	uint64_t seconds = totalSeconds % SEC_PER_MIN;
+	uint32_t milis;
+	uint32_t totalSeconds = splitTime(time, &milis);
+	uint32_t hours = totalSeconds / SEC_PER_H;
+	uint32_t minutes = (totalSeconds % SEC_PER_H) / SEC_PER_MIN;
+	uint32_t seconds = totalSeconds % SEC_PER_MIN;
+
+	sprintf(buffer, "%02lu:%02lu:%02lu:%03lu", (unsigned long)hours, (unsigned long)minutes,
+			(unsigned long)seconds, (unsigned long)milis);
+}
+
+/* Overwrite the time shown on the current terminal line */
+void printTime(uint64_t time)
+{
+#if STOPWATCH_NET && STOPWATCH_TELEMETRY
+	telemetryTime(time);
+#endif
+	PROFILE_BEGIN(PROFILE_FORMAT_TIME);
+#if DLOG_ENABLE
+	/* Only the fields are sent, the host renders the line */
+	uint32_t milis;
+	uint32_t totalSeconds = splitTime(time, &milis);
+
+	DLOG("\r                 \rTime: %02u:%02u:%02u:%03u",
+			totalSeconds / SEC_PER_H, (totalSeconds % SEC_PER_H) / SEC_PER_MIN,
+			totalSeconds % SEC_PER_MIN, milis);
+#else
+	char buffer[50];
 
-	sprintf(buffer, "%02llu:%02llu:%02llu:%03llu", hours, minutes, seconds, milis);
+	xil_printf("\r                 ");
+	FormatTime(time, buffer);
+	xil_printf("\rTime: %s", buffer);
+#endif
+#if STOPWATCH_SIM
+	simDisplay(time);
+#endif
+	PROFILE_END(PROFILE_FORMAT_TIME);
 }
 
-/* Display the timer with carriage return character to auto-update its value for a user friendly display */
+#if STOPWATCH_AMP
+/* SGI from CPU1: a new time snapshot is in the mailbox */
+void ampDoorbellHandler(void *CallBackRef)
+{
+	BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	vTaskNotifyGiveFromISR(xAmpDisplayTask, &xHigherPriorityTaskWoken);
+	portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/* Display the last time snapshot published by CPU1 each time the doorbell rings */
 void vTimerDisplay()
 {
-	char buffer[50];
+	AmpMessage msg;
+
+	/* The GIC is initialized by vTaskStartScheduler(), so the doorbell can only be
+	 * hooked up once the tasks are running.
+	 */
+	xAmpDisplayTask = xTaskGetCurrentTaskHandle();
+	XScuGic_Connect(&xInterruptController, AMP_DOORBELL_TO_CPU0, ampDoorbellHandler, NULL);
+	XScuGic_Enable(&xInterruptController, AMP_DOORBELL_TO_CPU0);
 
+	while(1){
+		uint64_t time = 0;
+		bool updated = false;
+
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		while(ampRingPop(&AMP_MAILBOX->toCpu0, &msg))
+		{
+			if(msg.type == AMP_MSG_TIME)
+			{
+				time = msg.time;
+				updated = true;
+			}
+		}
+
+		if(updated)
+		{
+			printTime(time);
+		}
+	}
+}
+#else
+/* Display the timer with carriage return character to auto-update its value for a user friendly display */
+void vTimerDisplay()
+{
 	while(1){
 		uint64_t time;
     	/* Wait until vTimerControl sends a timer value */
 		if(xQueueReceive(xTimerValueDisplayQueue, (void*)&time, (TickType_t)0) == pdTRUE)
 		{
-			xil_printf("\r                 ");
-			FormatTime(time, &buffer);
-			xil_printf("\rTime: %s", buffer);
+			printTime(time);
 		}
 	}
 }
+#endif
+
+
+#if STOPWATCH_NET
+/* Bring up the Ethernet link and serve the received frames */
+void vNetwork(void* pvParameters)
+{
+	static const uint8_t mac[6] = NET_MAC_ADDR;
+	PktFrame frames[NET_RX_BATCH];
+
+	if(pktioInit(mac) != XST_SUCCESS) {
+		xil_printf("Error: Ethernet unsuccessfully initialized!\r\n");
+		vTaskDelete(NULL);
+	}
+	xil_printf("Info: Ethernet link up!\r\n");
+#if STOPWATCH_TELEMETRY
+	telemetryInit(mac);
+#endif
+
+	while(1){
+#if STOPWATCH_TELEMETRY
+		/* Wake up at least once per period to send the pending datagram */
+		uint32_t count = pktioReceive(frames, NET_RX_BATCH, pdMS_TO_TICKS(TELEMETRY_PERIOD_MS));
+#else
+		uint32_t count = pktioReceive(frames, NET_RX_BATCH, portMAX_DELAY);
+#endif
+
+		PROFILE_BEGIN(PROFILE_NET_RX);
+		for(uint32_t i = 0; i < count; i++) {
+#if STOPWATCH_TELEMETRY
+			telemetryInput(frames[i].data, frames[i].len);
+#endif
+			pktioFree(frames[i].data);
+		}
+		PROFILE_END(PROFILE_NET_RX);
+#if STOPWATCH_TELEMETRY
+		telemetryPoll();
+#endif
+	}
+}
+#endif
+
+
+#define STATS_REPORT	((configUSE_IRQ_STATS == 1) || (configUSE_PMU_PROFILING == 1) || \
+						(configUSE_SAMPLING_PROFILER == 1) || STOPWATCH_BUFFERED_CONSOLE || STOPWATCH_NET || CONSOLE_USB || \
+						STOPWATCH_DMA_COPY || STOPWATCH_WORKQ || (configUSE_HR_TIMER == 1) || (configUSE_STACK_GUARD_PAGES == 1))
+
+#if STATS_REPORT
+/* Periodically dump the statistics collected by the port and the console */
+void vStatsReport(void* pvParameters)
+{
+#if configUSE_SAMPLING_PROFILER == 1
+	uint32_t periods = 0;
+
+	if(xPortSamplerStart() != pdPASS) {
+		xil_printf("Error: sampling profiler unsuccessfully started!\r\n");
+	}
+#endif
+
+	while(1){
+		vTaskDelay(pdMS_TO_TICKS(STATS_PERIOD_MS));
+		xil_printf("\r\n");
+#if configUSE_IRQ_STATS == 1
+		vPortPrintIRQStats();
+#endif
+#if configUSE_PMU_PROFILING == 1
+		vPortPrintProfile();
+#endif
+#if configUSE_SAMPLING_PROFILER == 1
+		/* Folded into flame graphs on the host by tools/sample_flamegraph.py */
+		if(++periods % SAMPLER_DUMP_PERIODS == 0) {
+			vPortSamplerDump();
+		}
+#endif
+#if STOPWATCH_BUFFERED_CONSOLE
+		ConsoleStats_t console;
+
+		consoleGetStats(&console);
+		DLOG("Console: %u bytes queued, %u dropped, %u overwritten, %u high water\r\n",
+				console.ulBytesQueued, console.ulBytesDropped,
+				console.ulBytesOverwritten, console.ulHighWaterMark);
+#endif
+#if CONSOLE_USB
+		UsbCdcStats_t usb;
+
+		usbcdcGetStats(&usb);
+		DLOG("USB: %u tx, %u tx dropped, %u rx, %u rx dropped, %u transfers, %u resets\r\n",
+				usb.ulTxBytes, usb.ulTxDropped, usb.ulRxBytes, usb.ulRxDropped,
+				usb.ulTransfers, usb.ulBusResets);
+		DLOG("USB: %u trace bytes, %u trace dropped\r\n", usb.ulTraceBytes, usb.ulTraceDropped);
+#endif
+#if STOPWATCH_DMA_COPY
+		DmaCopyStats_t dma;
+
+		dmacopyGetStats(&dma);
+		DLOG("DMA: %u copies, %u bytes, %u on CPU, %u CPU bytes, %u ring full, %u faults\r\n",
+				dma.ulDmaCopies, dma.ulDmaBytes, dma.ulCpuCopies, dma.ulCpuBytes,
+				dma.ulRingFull, dma.ulFaults);
+		DLOG("DMA: %u programs built, %u reused\r\n", dma.ulProgBuilds, dma.ulProgHits);
+#endif
+#if STOPWATCH_WORKQ
+		WorkqStats_t wq;
+
+		/* DLOG takes words only: the worker by number, WORKQ_URGENT first */
+		for(uint32_t i = 0; i < WORKQ_WORKERS; i++) {
+			workqGetStats(i, &wq);
+			DLOG("Workq %u: %u run, %u coalesced, %u overflows, %u high water, %u us worst latency\r\n",
+					i, wq.ulRun, wq.ulCoalesced, wq.ulOverflows, wq.ulHighWater,
+					(unsigned)(wq.ulMaxLatency / (COUNTS_PER_SECOND / 1000000U)));
+		}
+#endif
+#if !STOPWATCH_AMP
+		ClocksourceStats_t clock;
+
+		clocksourceGetStats(&clock);
+		DLOG("Clock: AXI timer %u Hz, %d ppb drift over %u ms, %u windows, %u calibrations\r\n",
+				clock.ulAxiHz, clock.lDriftPpb, clock.ulRunMs, clock.ulWindows, clock.ulCalibrations);
+#endif
+#if configUSE_HR_TIMER == 1
+		HRTimerStats_t hr;
+
+		vPortGetHrTimerStats(&hr);
+		DLOG("HR timer: %u blocked, %u spun, %u irqs, %u retries, %u us worst late\r\n",
+				hr.ulBlocked, hr.ulSpun, hr.ulInterrupts, hr.ulRetries,
+				(unsigned)(hr.ulMaxLateCounts / (COUNTS_PER_SECOND / 1000000U)));
+#endif
+#if configUSE_STACK_GUARD_PAGES == 1
+		StackGuardStats_t guard;
+
+		vPortGetStackGuardStats(&guard);
+		DLOG("Stacks: %u guarded, %u unguarded, %u pool pages used, %u free\r\n",
+				guard.ulGuardedStacks, guard.ulUnguardedStacks, guard.ulPagesCarved, guard.ulPagesFree);
+#endif
+#if STOPWATCH_NET
+		PktioStats_t net;
+
+		pktioGetStats(&net);
+		DLOG("Net: %u rx, %u tx, %u rx irqs, %u rx polls, %u rx errors, %u tx errors\r\n",
+				net.ulRxFrames, net.ulTxFrames, net.ulRxInterrupts, net.ulRxPolls,
+				net.ulRxErrors, net.ulTxErrors);
+		DLOG("Net: %u rx dropped, %u tx ring full, %u pool empty\r\n",
+				net.ulRxDropped, net.ulTxRingFull, net.ulPoolEmpty);
+#if STOPWATCH_TELEMETRY
+		TelemetryStats_t telemetry;
+
+		telemetryTaskStats();
+		telemetryGetStats(&telemetry);
+		DLOG("Telemetry: %u datagrams, %u records, %u dropped, %u arp replies\r\n",
+				telemetry.ulDatagrams, telemetry.ulRecords, telemetry.ulRecordsDropped,
+				telemetry.ulArpReplies);
+#endif
+#endif
+	}
+}
+#endif
+
+
+/* Task storage, see static_alloc.h */
+STATIC_TASK(buttons, configMINIMAL_STACK_SIZE);
+STATIC_TASK(ledDisplay, configMINIMAL_STACK_SIZE);
+#if !STOPWATCH_AMP
+STATIC_TASK(timerControl, configMINIMAL_STACK_SIZE * 2);
+#endif
+STATIC_TASK(timerDisplay, configMINIMAL_STACK_SIZE * 2);
+#if STOPWATCH_NET
+STATIC_TASK(network, configMINIMAL_STACK_SIZE * 2);
+#endif
+#if STATS_REPORT
+STATIC_TASK(stats, configMINIMAL_STACK_SIZE * 4);
+#endif
+
+
+#if configSUPPORT_DYNAMIC_ALLOCATION == 1
+/* Print how much of each FreeRTOS heap pool (OCM and DDR) is in use */
+void printHeapStats()
+{
+	HeapStats_t stats;
+
+#if configUSE_FAST_HEAP == 1
+	vPortGetHeapPoolStats(eHeapPoolFast, &stats);
+	xil_printf("Heap OCM: %d bytes free, %d allocations, %d fallbacks to DDR\r\n",
+			stats.xAvailableHeapSpaceInBytes, stats.xNumberOfSuccessfulAllocations,
+			xPortGetHeapPoolFallbacks(eHeapPoolFast));
+
+	vPortGetHeapPoolStats(eHeapPoolBulk, &stats);
+	xil_printf("Heap DDR: %d bytes free, %d allocations\r\n",
+			stats.xAvailableHeapSpaceInBytes, stats.xNumberOfSuccessfulAllocations);
+#else
+	vPortGetHeapStats(&stats);
+	xil_printf("Heap: %d bytes free, %d allocations\r\n",
+			(int)stats.xAvailableHeapSpaceInBytes, (int)stats.xNumberOfSuccessfulAllocations);
+#endif
+}
+#endif
 
 
 int main( void )
 {
     driverInit();
     configGpio();
+#if STOPWATCH_AMP
+    /* CPU1 owns the AXI timer, hand it over through the mailbox */
+    clocksourceInit(NULL);
+    ampMailboxInit();
+    ampStartCpu1();
+    xil_printf("Started CPU1\r\n");
+#else
     configTmrCtr();
+    clocksourceInit(&TimerCounter);
+#endif
 
     /* Create the queues needed for avoiding the concurrency and manage the tasks properly*/
-    xButtonLedQueue = xQueueCreate(1, sizeof(int32_t));
-    xButtonTimerControlQueue = xQueueCreate(1, sizeof(int32_t));
-    xTimerValueDisplayQueue = xQueueCreate(1, sizeof(uint64_t));
+    xButtonLedQueue = STATIC_QUEUE_CREATE(buttonLed);
+    xButtonTimerControlQueue = STATIC_QUEUE_CREATE(buttonTimerControl);
+    xTimerValueDisplayQueue = STATIC_QUEUE_CREATE(timerValueDisplay);
 
     TaskHandle_t xButtonsHandler = NULL;
     TaskHandle_t xLedDisplayHandler = NULL;
+#if !STOPWATCH_AMP
     TaskHandle_t xTimerControlHandler = NULL;
+#endif
     TaskHandle_t xTimerDisplayHandler = NULL;
 
 /* Creating the FreeRTOS tasks */
-    xTaskCreate(vReadButtons, "vReadButtons", configMINIMAL_STACK_SIZE, (void*)NULL, 0, &xButtonsHandler);
+    STATIC_TASK_CREATE(buttons, vReadButtons, "vReadButtons", (void*)NULL, 0, &xButtonsHandler);
     xil_printf("Created button task\r\n");
 
-    xTaskCreate(vLedDisplay, "vLedDisplay", configMINIMAL_STACK_SIZE, (void*)NULL, 0, &xLedDisplayHandler);
+    STATIC_TASK_CREATE(ledDisplay, vLedDisplay, "vLedDisplay", (void*)NULL, 0, &xLedDisplayHandler);
     xil_printf("Created led task\r\n");
 
-    xTaskCreate(vTimerControl, "vTimerControl", configMINIMAL_STACK_SIZE * 2, (void*)NULL, 0, &xTimerControlHandler);
+#if !STOPWATCH_AMP
+    STATIC_TASK_CREATE(timerControl, vTimerControl, "vTimerControl", (void*)NULL, 0, &xTimerControlHandler);
     xil_printf("Created timer control task\r\n");
+#endif
 
-    xTaskCreate(vTimerDisplay, "vTimerDisplay", configMINIMAL_STACK_SIZE * 2, (void*)NULL, 0, &xTimerDisplayHandler);
+    STATIC_TASK_CREATE(timerDisplay, vTimerDisplay, "vTimerDisplay", (void*)NULL, 0, &xTimerDisplayHandler);
     xil_printf("Created timer display task\r\n");
+#if configUSE_PMU_PROFILING == 1
+    vPortProfileSetRegionName(PROFILE_FORMAT_TIME, "FormatTime");
+    vPortProfileSetRegionName(PROFILE_QUEUE_SEND, "QueueSend");
+#if STOPWATCH_NET
+    vPortProfileSetRegionName(PROFILE_NET_RX, "NetRx");
+#endif
+#endif
+#if STOPWATCH_NET
+    STATIC_TASK_CREATE(network, vNetwork, "vNetwork", (void*)NULL, 1, NULL);
+    xil_printf("Created network task\r\n");
+#endif
+#if STATS_REPORT
+    STATIC_TASK_CREATE(stats, vStatsReport, "vStats", (void*)NULL, 1, NULL);
+    xil_printf("Created statistics task\r\n");
+#endif
+
+#if STOPWATCH_CTXSWITCH_BENCH
+    startContextSwitchBenchmark();
+#endif
+#if STOPWATCH_IRQ_BENCH
+    startIrqBenchmark();
+#endif
+#if STOPWATCH_KERNEL_BENCH
+    startKernelBenchmark();
+#endif
+#if configSUPPORT_DYNAMIC_ALLOCATION == 1
+    printHeapStats();
+#endif
+#if STOPWATCH_BUFFERED_CONSOLE
+    if(consoleInit() != XST_SUCCESS) {
+        xil_printf("Error: buffered console unsuccessfully initialized!\r\n");
+    }
+#endif
+#if CONSOLE_USB
+    if(usbcdcInit() != XST_SUCCESS) {
+        xil_printf("Error: USB serial port unsuccessfully initialized!\r\n");
+    }
+#endif
+#if STOPWATCH_DMA_COPY
+    if(dmacopyInit() != XST_SUCCESS) {
+        xil_printf("Error: DMA copy service unsuccessfully initialized!\r\n");
+    }
+#endif
+#if STOPWATCH_WORKQ
+    if(workqInit() != XST_SUCCESS) {
+        xil_printf("Error: work queues unsuccessfully initialized!\r\n");
+    }
+#endif
+#if STOPWATCH_SIM
+    simStart();
+#endif
 /* Scheduling the tasks using a queue system */
     xil_printf("Starting scheduler...\r\n\r\n");
     vTaskStartScheduler();
@@ -303,3 +776,5 @@ int main( void )
     return 0;
 }
 
+#endif /* STOPWATCH_AMP_CPU1 */
+
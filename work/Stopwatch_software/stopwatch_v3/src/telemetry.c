@@ -0,0 +1,383 @@
+/*
+ * UDP telemetry over GEM0.
+ *
+ * There is no TCP/IP stack: the Ethernet, IPv4 and UDP headers are written
+ * directly in a pktio.c buffer, addressed to the host configured in
+ * telemetry.h (static ARP). The only received frames handled are ARP requests
+ * for our address, so the host can also reach the board without a static
+ * entry of its own.
+ *
+ * Records are appended to the datagram being filled, which is built in place
+ * in its pool buffer and queued with no copy once full or when
+ * telemetryPoll() finds it older than TELEMETRY_PERIOD_MS. Timer snapshots
+ * are rate limited to one per TELEMETRY_TIME_INTERVAL_MS, so the datagram
+ * rate stays bounded however fast the display loop runs. Records are dropped
+ * and counted, never waited for, when the pool is empty.
+ *
+ * The UDP checksum is left 0 (none), which IPv4 allows.
+ */
+
+#ifndef STOPWATCH_AMP_CPU1
+
+#include <stdint.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "clocksource.h"
+#include "pktio.h"
+#include "telemetry.h"
+
+#define ETH_HDR_LEN		14U
+#define IP_HDR_LEN		20U
+#define UDP_HDR_LEN		8U
+#define TM_HDR_LEN		12U
+#define ETH_MIN_LEN		60U		/* Without FCS */
+#define ETH_TYPE_IP		0x0800U
+#define ETH_TYPE_ARP	0x0806U
+#define ARP_LEN			28U
+
+#define TM_PAYLOAD_OFFSET	(ETH_HDR_LEN + IP_HDR_LEN + UDP_HDR_LEN)
+#define TM_RECORDS_OFFSET	(TM_PAYLOAD_OFFSET + TM_HDR_LEN)
+#define TM_PAYLOAD_MAX		1472U	/* 1500 byte MTU less the IPv4 and UDP headers */
+#define TM_FRAME_MAX		(TM_PAYLOAD_OFFSET + TM_PAYLOAD_MAX)
+
+#define TM_REC_HDR_LEN	2U
+#define TM_REC_MAX		(TM_REC_HDR_LEN + 10U + configMAX_TASK_NAME_LEN)	/* TELEMETRY_REC_TASK is the longest */
+
+#define TM_COUNTS_PER_MS	(COUNTS_PER_SECOND / 1000U)
+
+static const uint8_t hostMac[6] = TELEMETRY_HOST_MAC;
+static const uint8_t hostIp[4] = TELEMETRY_HOST_IP;
+static const uint8_t localIp[4] = TELEMETRY_LOCAL_IP;
+static uint8_t localMac[6];
+
+static volatile uint32_t tmActive;
+static uint8_t *tmBuf;			/* Datagram being filled, NULL when none is */
+static uint32_t tmLen;			/* Frame length so far */
+static uint32_t tmRecords;		/* Records in tmBuf */
+static uint32_t tmOpened;		/* Global timer when tmBuf was taken */
+static uint32_t tmSequence;
+static uint16_t tmIpId;
+static uint32_t tmLastSnapshot;
+static uint64_t tmLastTime;
+static uint32_t tmLastButton;
+static TelemetryStats_t tmStats;
+
+static inline uint32_t tmNow(void)
+{
+	return clocksourceNow32();
+}
+
+static inline uint8_t *tmPut16(uint8_t *p, uint32_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+	return p + 2;
+}
+
+static inline uint8_t *tmPut32(uint8_t *p, uint32_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+	p[2] = (uint8_t)(value >> 16);
+	p[3] = (uint8_t)(value >> 24);
+	return p + 4;
+}
+
+static inline uint8_t *tmPut64(uint8_t *p, uint64_t value)
+{
+	p = tmPut32(p, (uint32_t)value);
+	return tmPut32(p, (uint32_t)(value >> 32));
+}
+
+/* Network byte order, for the protocol headers */
+static inline uint8_t *tmPutBe16(uint8_t *p, uint32_t value)
+{
+	p[0] = (uint8_t)(value >> 8);
+	p[1] = (uint8_t)value;
+	return p + 2;
+}
+
+static uint8_t *tmPutEth(uint8_t *p, const uint8_t *dst, uint32_t type)
+{
+	memcpy(p, dst, 6);
+	memcpy(p + 6, localMac, 6);
+	return tmPutBe16(p + 12, type);
+}
+
+/* Write the Ethernet, IPv4 and UDP headers for a payload of len bytes */
+static void tmPutHeaders(uint8_t *frame, uint32_t len, uint16_t id)
+{
+	uint8_t *ip = frame + ETH_HDR_LEN;
+	uint8_t *p;
+	uint32_t sum = 0;
+
+	p = tmPutEth(frame, hostMac, ETH_TYPE_IP);
+	*p++ = 0x45;	/* IPv4, no options */
+	*p++ = 0;
+	p = tmPutBe16(p, IP_HDR_LEN + UDP_HDR_LEN + len);
+	p = tmPutBe16(p, id);
+	p = tmPutBe16(p, 0x4000);	/* Don't fragment */
+	*p++ = 64;		/* TTL */
+	*p++ = 17;		/* UDP */
+	p = tmPutBe16(p, 0);
+	memcpy(p, localIp, 4);
+	memcpy(p + 4, hostIp, 4);
+	p += 8;
+	for(uint32_t i = 0; i < IP_HDR_LEN; i += 2) {
+		sum += ((uint32_t)ip[i] << 8) | ip[i + 1];
+	}
+	sum = (sum & 0xFFFFU) + (sum >> 16);
+	sum += sum >> 16;
+	tmPutBe16(ip + 10, ~sum & 0xFFFFU);
+
+	p = tmPutBe16(p, TELEMETRY_PORT);
+	p = tmPutBe16(p, TELEMETRY_PORT);
+	p = tmPutBe16(p, UDP_HDR_LEN + len);
+	tmPutBe16(p, 0);
+}
+
+/* Queue a filled datagram, called outside the critical section */
+static void tmSend(uint8_t *frame, uint32_t len, uint32_t records, uint32_t sequence, uint16_t id)
+{
+	PktFrame out;
+	uint8_t *p = frame + TM_PAYLOAD_OFFSET;
+
+	tmPutHeaders(frame, len - TM_PAYLOAD_OFFSET, id);
+	p = tmPut16(p, TELEMETRY_MAGIC);
+	*p++ = TELEMETRY_VERSION;
+	*p++ = (uint8_t)records;
+	p = tmPut32(p, sequence);
+	tmPut32(p, tmNow());
+
+	out.data = frame;
+	out.len = len;
+	if(pktioSend(&out, 1) == 1) {
+		taskENTER_CRITICAL();
+		tmStats.ulDatagrams++;
+		taskEXIT_CRITICAL();
+	} else {
+		taskENTER_CRITICAL();
+		tmStats.ulRecordsDropped += records;
+		taskEXIT_CRITICAL();
+		pktioFree(frame);
+	}
+}
+
+/* Detach the datagram being filled, in a critical section. Returns NULL when empty. */
+static uint8_t *tmTakeLocked(uint32_t *len, uint32_t *records, uint32_t *sequence, uint16_t *id)
+{
+	uint8_t *frame = tmBuf;
+
+	if(frame == NULL || tmRecords == 0) {
+		return NULL;
+	}
+	*len = tmLen;
+	*records = tmRecords;
+	*sequence = tmSequence++;
+	*id = tmIpId++;
+	tmBuf = NULL;
+	return frame;
+}
+
+/* Append one record, sending the current datagram first when it is full */
+static void tmAppend(const uint8_t *rec, uint32_t len)
+{
+	uint8_t *full = NULL;
+	uint8_t *fresh = NULL;
+	uint32_t fullLen = 0, fullRecords = 0, fullSequence = 0;
+	uint16_t fullId = 0;
+
+	taskENTER_CRITICAL();
+	if(tmBuf != NULL && tmLen + len > TM_FRAME_MAX) {
+		full = tmTakeLocked(&fullLen, &fullRecords, &fullSequence, &fullId);
+	}
+	taskEXIT_CRITICAL();
+
+	if(full != NULL) {
+		tmSend(full, fullLen, fullRecords, fullSequence, fullId);
+	}
+
+	/* Outside the critical section, pktioAlloc() may reclaim a batch of TX descriptors */
+	if(tmBuf == NULL) {
+		fresh = pktioAlloc();
+	}
+
+	taskENTER_CRITICAL();
+	if(tmBuf == NULL && fresh != NULL) {
+		tmBuf = fresh;
+		tmLen = TM_RECORDS_OFFSET;
+		tmRecords = 0;
+		tmOpened = tmNow();
+		fresh = NULL;
+	}
+	if(tmBuf != NULL && tmLen + len <= TM_FRAME_MAX) {
+		memcpy(tmBuf + tmLen, rec, len);
+		tmLen += len;
+		tmRecords++;
+		tmStats.ulRecords++;
+	} else {
+		tmStats.ulRecordsDropped++;
+	}
+	taskEXIT_CRITICAL();
+
+	/* Lost the race for the empty slot to another task */
+	if(fresh != NULL) {
+		pktioFree(fresh);
+	}
+}
+
+/* Start sending, once the link is up. mac is the board address given to pktioInit(). */
+void telemetryInit(const uint8_t mac[6])
+{
+	memcpy(localMac, mac, 6);
+	tmLastSnapshot = tmNow() - TELEMETRY_TIME_INTERVAL_MS * TM_COUNTS_PER_MS;
+	tmActive = 1;
+}
+
+/* Record a stopwatch time snapshot (AXI timer counts), at most one per TELEMETRY_TIME_INTERVAL_MS */
+void telemetryTime(uint64_t time)
+{
+	uint8_t rec[TM_REC_HDR_LEN + 12U];
+	uint32_t now = tmNow();
+	uint8_t *p = rec;
+
+	taskENTER_CRITICAL();
+	tmLastTime = time;
+	taskEXIT_CRITICAL();
+	if(!tmActive || now - tmLastSnapshot < TELEMETRY_TIME_INTERVAL_MS * TM_COUNTS_PER_MS) {
+		return;
+	}
+	tmLastSnapshot = now;
+
+	*p++ = TELEMETRY_REC_TIME;
+	*p++ = sizeof(rec) - TM_REC_HDR_LEN;
+	p = tmPut32(p, now);
+	tmPut64(p, time);
+	tmAppend(rec, sizeof(rec));
+}
+
+/* Record a button press along with the last time snapshot. Call with every
+ * read of the buttons, only changes to a pressed state are recorded.
+ */
+void telemetryButton(uint32_t button)
+{
+	uint8_t rec[TM_REC_HDR_LEN + 16U];
+	uint8_t *p = rec;
+	uint64_t time;
+
+	if(button == tmLastButton) {
+		return;
+	}
+	tmLastButton = button;
+	if(!tmActive || button == 0) {
+		return;
+	}
+
+	*p++ = TELEMETRY_REC_EVENT;
+	*p++ = sizeof(rec) - TM_REC_HDR_LEN;
+	p = tmPut32(p, tmNow());
+	p = tmPut32(p, button);
+	taskENTER_CRITICAL();
+	time = tmLastTime;
+	taskEXIT_CRITICAL();
+	tmPut64(p, time);
+	tmAppend(rec, sizeof(rec));
+}
+
+/* Record the state, priority and stack high water mark of every task */
+void telemetryTaskStats(void)
+{
+	TaskStatus_t status[16];
+	uint8_t rec[TM_REC_MAX];
+	UBaseType_t count;
+
+	if(!tmActive || uxTaskGetNumberOfTasks() > sizeof(status) / sizeof(status[0])) {
+		return;
+	}
+	count = uxTaskGetSystemState(status, sizeof(status) / sizeof(status[0]), NULL);
+	for(UBaseType_t i = 0; i < count; i++) {
+		uint8_t *p = rec + TM_REC_HDR_LEN;
+
+		p = tmPut32(p, status[i].xTaskNumber);
+		p = tmPut32(p, status[i].usStackHighWaterMark);
+		*p++ = (uint8_t)status[i].uxCurrentPriority;
+		*p++ = (uint8_t)status[i].eCurrentState;
+		/* Zero padded, not terminated when the name fills the field */
+		memset(p, 0, configMAX_TASK_NAME_LEN);
+		memcpy(p, status[i].pcTaskName, strnlen(status[i].pcTaskName, configMAX_TASK_NAME_LEN));
+		rec[0] = TELEMETRY_REC_TASK;
+		rec[1] = TM_REC_MAX - TM_REC_HDR_LEN;
+		tmAppend(rec, TM_REC_MAX);
+	}
+}
+
+/* Answer ARP requests for TELEMETRY_LOCAL_IP, other frames are ignored */
+void telemetryInput(const uint8_t *frame, uint32_t len)
+{
+	const uint8_t *arp = frame + ETH_HDR_LEN;
+	PktFrame out;
+	uint8_t *p;
+
+	if(!tmActive || len < ETH_HDR_LEN + ARP_LEN ||
+			frame[12] != (ETH_TYPE_ARP >> 8) || frame[13] != (ETH_TYPE_ARP & 0xFF)) {
+		return;
+	}
+	/* Ethernet/IPv4 request for our address */
+	if(arp[0] != 0 || arp[1] != 1 || arp[2] != 0x08 || arp[3] != 0x00 ||
+			arp[4] != 6 || arp[5] != 4 || arp[6] != 0 || arp[7] != 1 ||
+			memcmp(arp + 24, localIp, 4) != 0) {
+		return;
+	}
+	if((out.data = pktioAlloc()) == NULL) {
+		return;
+	}
+
+	p = tmPutEth(out.data, arp + 8, ETH_TYPE_ARP);
+	memcpy(p, arp, 6);	/* Same hardware and protocol types and sizes */
+	p += 6;
+	p = tmPutBe16(p, 2);	/* Reply */
+	memcpy(p, localMac, 6);
+	memcpy(p + 6, localIp, 4);
+	memcpy(p + 10, arp + 8, 10);	/* Sender becomes target */
+	p += 20;
+	memset(p, 0, ETH_MIN_LEN - (uint32_t)(p - out.data));
+	out.len = ETH_MIN_LEN;
+
+	if(pktioSend(&out, 1) == 1) {
+		taskENTER_CRITICAL();
+		tmStats.ulArpReplies++;
+		taskEXIT_CRITICAL();
+	} else {
+		pktioFree(out.data);
+	}
+}
+
+/* Send the datagram being filled once it is TELEMETRY_PERIOD_MS old. Call at
+ * least that often.
+ */
+void telemetryPoll(void)
+{
+	uint8_t *frame = NULL;
+	uint32_t len = 0, records = 0, sequence = 0;
+	uint16_t id = 0;
+
+	taskENTER_CRITICAL();
+	if(tmBuf != NULL && tmNow() - tmOpened >= TELEMETRY_PERIOD_MS * TM_COUNTS_PER_MS) {
+		frame = tmTakeLocked(&len, &records, &sequence, &id);
+	}
+	taskEXIT_CRITICAL();
+
+	if(frame != NULL) {
+		tmSend(frame, len, records, sequence, id);
+	}
+}
+
+void telemetryGetStats(TelemetryStats_t *stats)
+{
+	taskENTER_CRITICAL();
+	*stats = tmStats;
+	taskEXIT_CRITICAL();
+}
+
+#endif /* STOPWATCH_AMP_CPU1 */
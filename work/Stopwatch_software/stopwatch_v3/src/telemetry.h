@@ -0,0 +1,69 @@
+/*
+ * UDP telemetry over GEM0, see telemetry.c.
+ *
+ * Timer snapshots, button events and task statistics are packed as binary
+ * records into UDP datagrams sent to a fixed host. tools/telemetry_decode.py
+ * prints them, live from the socket or from a pcap capture.
+ *
+ * Datagram payload, little endian:
+ *
+ *   u16 magic | u8 version | u8 record count | u32 sequence | u32 timestamp
+ *   then per record: u8 type | u8 payload length | payload
+ *
+ * Timestamps are the low word of the global timer (COUNTS_PER_SECOND).
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+/* Static addressing, there is no ARP resolution of the host */
+#ifndef TELEMETRY_LOCAL_IP
+#define TELEMETRY_LOCAL_IP	{ 192, 168, 1, 10 }
+#endif
+
+#ifndef TELEMETRY_HOST_IP
+#define TELEMETRY_HOST_IP	{ 192, 168, 1, 100 }
+#endif
+
+#ifndef TELEMETRY_HOST_MAC
+#define TELEMETRY_HOST_MAC	{ 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }	/* Broadcast works on a direct link */
+#endif
+
+#ifndef TELEMETRY_PORT
+#define TELEMETRY_PORT	5005U	/* Source and destination UDP port */
+#endif
+
+#ifndef TELEMETRY_PERIOD_MS
+#define TELEMETRY_PERIOD_MS	100U	/* A partly filled datagram is sent after this long */
+#endif
+
+#ifndef TELEMETRY_TIME_INTERVAL_MS
+#define TELEMETRY_TIME_INTERVAL_MS	10U	/* Minimum interval between two timer snapshots */
+#endif
+
+#define TELEMETRY_MAGIC		0x5754U	/* "TW" */
+#define TELEMETRY_VERSION	1U
+
+/* Record types */
+#define TELEMETRY_REC_TIME	1U	/* u32 timestamp, u64 stopwatch time */
+#define TELEMETRY_REC_EVENT	2U	/* u32 timestamp, u32 button, u64 last stopwatch time */
+#define TELEMETRY_REC_TASK	3U	/* u32 task number, u32 stack high water mark (words), u8 priority, u8 state, name */
+
+typedef struct {
+	uint32_t ulDatagrams;		/* Datagrams queued to the MAC */
+	uint32_t ulRecords;			/* Records packed */
+	uint32_t ulRecordsDropped;	/* Records lost because no buffer was free */
+	uint32_t ulArpReplies;		/* ARP requests for TELEMETRY_LOCAL_IP answered */
+} TelemetryStats_t;
+
+void telemetryInit(const uint8_t mac[6]);
+void telemetryTime(uint64_t time);
+void telemetryButton(uint32_t button);
+void telemetryTaskStats(void);
+void telemetryInput(const uint8_t *frame, uint32_t len);
+void telemetryPoll(void);
+void telemetryGetStats(TelemetryStats_t *stats);
+
+#endif /* TELEMETRY_H */
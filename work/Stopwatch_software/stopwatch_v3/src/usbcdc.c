@@ -0,0 +1,710 @@
+/*
+ * USB device on the PS USB0 controller: a CDC-ACM serial port and a bulk
+ * trace channel.
+ *
+ * Built on the dQH/dTD primitives of the usbps driver, which has no class
+ * support. The device answers the chapter 9 requests and the CDC-ACM line
+ * coding and control line state requests on endpoint 0.
+ *
+ *   EP1 IN   interrupt  CDC notifications (never sent)
+ *   EP2 OUT  bulk       serial port input, two dTDs so the controller fills
+ *                       one buffer while the other is copied out
+ *   EP2 IN   bulk       serial port output
+ *   EP3 IN   bulk       trace channel, vendor specific interface 2
+ *
+ * Each IN channel is double buffered: writers append to one buffer while the
+ * other is on the wire, and the transfer complete interrupt swaps them. A
+ * transfer is started as soon as the endpoint is idle, so a lone line goes
+ * out at once, and output written during a transfer leaves as one large
+ * transfer. When both buffers are full, the new bytes are dropped and
+ * counted.
+ *
+ * Output is only queued while the host has the channel open: DTR set with
+ * SET_CONTROL_LINE_STATE for the serial port, and USBCDC_REQ_TRACE for the
+ * trace channel. State shared with the USB interrupt is only touched with
+ * IRQs masked on this core, as in console.c.
+ */
+
+#ifndef STOPWATCH_AMP_CPU1
+
+#include <stdint.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xil_cache.h"
+#include "xparameters.h"
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#include "xstatus.h"
+#include "xusbps.h"
+#include "xusbps_endpoint.h"
+#include "xusbps_hw.h"
+#include "usbcdc.h"
+
+#define USBCDC_EP_NOTIFY	1U
+#define USBCDC_EP_ACM		2U
+#define USBCDC_EP_TRACE		3U
+#define USBCDC_NUM_EPS		4U
+
+#define USBCDC_EP0_MPS		64U
+#define USBCDC_NOTIFY_MPS	16U
+#define USBCDC_HS_BULK_MPS	512U
+#define USBCDC_FS_BULK_MPS	64U
+#define USBCDC_RX_BUFS		2U		/* OUT dTDs of the serial port */
+#define USBCDC_IN_DTDS		4U		/* A transfer and its zero length packet, plus the terminating dTD */
+
+/* Queue heads, dTDs and OUT buffers, with room for the 2 KB queue head alignment */
+#define USBCDC_DMA_SIZE		8192U
+
+#define USBCDC_RX_MASK		(USBCDC_RX_BUF_SIZE - 1U)
+
+#if (USBCDC_RX_BUF_SIZE & USBCDC_RX_MASK) != 0
+#error USBCDC_RX_BUF_SIZE must be a power of two
+#endif
+
+#if USBCDC_TRACE_BUF_SIZE > XUSBPS_dTD_BUF_MAX_SIZE || USBCDC_TX_BUF_SIZE > XUSBPS_dTD_BUF_MAX_SIZE
+#error IN buffers are sent with a single dTD
+#endif
+
+/* bmRequestType */
+#define REQ_DIR_IN			0x80U
+#define REQ_TYPE_MASK		0x60U
+#define REQ_TYPE_STANDARD	0x00U
+#define REQ_TYPE_CLASS		0x20U
+#define REQ_TYPE_VENDOR		0x40U
+#define REQ_RECIP_MASK		0x1FU
+#define REQ_RECIP_DEVICE	0x00U
+#define REQ_RECIP_ENDPOINT	0x02U
+
+/* Standard requests */
+#define REQ_GET_STATUS			0x00U
+#define REQ_CLEAR_FEATURE		0x01U
+#define REQ_SET_FEATURE			0x03U
+#define REQ_SET_ADDRESS			0x05U
+#define REQ_GET_DESCRIPTOR		0x06U
+#define REQ_GET_CONFIGURATION	0x08U
+#define REQ_SET_CONFIGURATION	0x09U
+#define REQ_GET_INTERFACE		0x0AU
+#define REQ_SET_INTERFACE		0x0BU
+
+/* CDC-ACM requests */
+#define CDC_SET_LINE_CODING			0x20U
+#define CDC_GET_LINE_CODING			0x21U
+#define CDC_SET_CONTROL_LINE_STATE	0x22U
+#define CDC_SEND_BREAK				0x23U
+
+#define DESC_DEVICE			0x01U
+#define DESC_CONFIG			0x02U
+#define DESC_STRING			0x03U
+#define DESC_INTERFACE		0x04U
+#define DESC_ENDPOINT		0x05U
+#define DESC_QUALIFIER		0x06U
+#define DESC_OTHER_SPEED	0x07U
+#define DESC_IAD			0x0BU
+#define DESC_CS_INTERFACE	0x24U
+
+#define FEATURE_ENDPOINT_HALT	0x00U
+
+#define USBCDC_CONFIG_LEN	91U
+
+typedef struct {
+	uint8_t *buf[2];
+	uint32_t size;
+	uint32_t fillLen;		/* Bytes in buf[fill] */
+	uint32_t *open;
+	uint32_t *bytes;
+	uint32_t *dropped;
+	uint8_t ep;
+	uint8_t fill;			/* Buffer being filled, the other one may be on the wire */
+	uint8_t busy;			/* A transfer is in flight */
+	uint8_t pending;		/* dTDs of that transfer not completed yet */
+} UsbCdcStream;
+
+static const uint8_t deviceDesc[18] = {
+	18, DESC_DEVICE, 0x00, 0x02,
+	0xEF, 0x02, 0x01,		/* Miscellaneous class with interface association */
+	USBCDC_EP0_MPS,
+	USBCDC_VID & 0xFF, USBCDC_VID >> 8, USBCDC_PID & 0xFF, USBCDC_PID >> 8,
+	0x00, 0x01,				/* bcdDevice 1.00 */
+	1, 2, 3,				/* Manufacturer, product and serial number strings */
+	1
+};
+
+static const uint8_t qualifierDesc[10] = {
+	10, DESC_QUALIFIER, 0x00, 0x02, 0xEF, 0x02, 0x01, USBCDC_EP0_MPS, 1, 0
+};
+
+/* High speed values, usbcdcConfigDesc() patches the packet sizes and interval for full speed */
+static const uint8_t configDesc[USBCDC_CONFIG_LEN] = {
+	9, DESC_CONFIG, USBCDC_CONFIG_LEN, 0, 3, 1, 0, 0xC0, 50,	/* Self powered, 100 mA */
+	/* CDC-ACM function: interfaces 0 and 1 */
+	8, DESC_IAD, 0, 2, 0x02, 0x02, 0x01, 4,
+	9, DESC_INTERFACE, 0, 0, 1, 0x02, 0x02, 0x01, 4,
+	5, DESC_CS_INTERFACE, 0x00, 0x10, 0x01,				/* Header, CDC 1.10 */
+	5, DESC_CS_INTERFACE, 0x01, 0x00, 1,				/* Call management over interface 1 */
+	4, DESC_CS_INTERFACE, 0x02, 0x02,					/* ACM: line coding and control line state */
+	5, DESC_CS_INTERFACE, 0x06, 0, 1,					/* Union: interface 0 controls interface 1 */
+	7, DESC_ENDPOINT, 0x80 | USBCDC_EP_NOTIFY, 0x03, USBCDC_NOTIFY_MPS, 0, 8,
+	9, DESC_INTERFACE, 1, 0, 2, 0x0A, 0x00, 0x00, 0,
+	7, DESC_ENDPOINT, USBCDC_EP_ACM, 0x02, USBCDC_HS_BULK_MPS & 0xFF, USBCDC_HS_BULK_MPS >> 8, 0,
+	7, DESC_ENDPOINT, 0x80 | USBCDC_EP_ACM, 0x02, USBCDC_HS_BULK_MPS & 0xFF, USBCDC_HS_BULK_MPS >> 8, 0,
+	/* Trace channel: interface 2 */
+	9, DESC_INTERFACE, USBCDC_TRACE_INTERFACE, 0, 1, 0xFF, 0x00, 0x00, 5,
+	7, DESC_ENDPOINT, USBCDC_TRACE_EP, 0x02, USBCDC_HS_BULK_MPS & 0xFF, USBCDC_HS_BULK_MPS >> 8, 0,
+};
+
+static const char *const strings[] = {
+	NULL, "Xilinx", "Stopwatch", "0001", "Stopwatch console", "Stopwatch trace"
+};
+
+static XUsbPs usb;
+static XUsbPs_DeviceConfig usbConfig;
+static uint8_t usbDma[USBCDC_DMA_SIZE] __attribute__((aligned(32)));
+static uint8_t ep0Buf[128] __attribute__((aligned(32)));
+static uint8_t acmBufs[2][USBCDC_TX_BUF_SIZE] __attribute__((aligned(32)));
+static uint8_t traceBufs[2][USBCDC_TRACE_BUF_SIZE] __attribute__((aligned(32)));
+static uint8_t rxRing[USBCDC_RX_BUF_SIZE];
+static uint32_t rxHead;
+static uint32_t rxTail;
+static uint8_t lineCoding[7] = { 0x00, 0xC2, 0x01, 0x00, 0, 0, 8 };	/* 115200 8N1 */
+static uint32_t ep0Request;		/* Request waiting for its OUT data stage */
+static uint32_t configured;
+static uint32_t acmOpen;
+static uint32_t traceOpen;
+static UsbCdcStats_t usbStats;
+
+static UsbCdcStream acmStream = {
+	{ acmBufs[0], acmBufs[1] }, USBCDC_TX_BUF_SIZE, 0, &acmOpen,
+	&usbStats.ulTxBytes, &usbStats.ulTxDropped, USBCDC_EP_ACM, 0, 0, 0
+};
+static UsbCdcStream traceStream = {
+	{ traceBufs[0], traceBufs[1] }, USBCDC_TRACE_BUF_SIZE, 0, &traceOpen,
+	&usbStats.ulTraceBytes, &usbStats.ulTraceDropped, USBCDC_EP_TRACE, 0, 0, 0
+};
+
+static inline uint32_t usbcdcLock(void)
+{
+	uint32_t cpsr = mfcpsr();
+
+	mtcpsr(cpsr | XREG_CPSR_IRQ_ENABLE);
+	return cpsr;
+}
+
+static inline void usbcdcUnlock(uint32_t cpsr)
+{
+	mtcpsr(cpsr);
+}
+
+static int usbcdcHighSpeed(void)
+{
+	return (XUsbPs_ReadReg(usb.Config.BaseAddress, XUSBPS_PORTSCR1_OFFSET) &
+			XUSBPS_PORTSCR_PSPD_MASK) == 0x08000000U;
+}
+
+/* Start a transfer of the filled buffer if the endpoint is idle, lock held */
+static void usbcdcKick(UsbCdcStream *s)
+{
+	uint32_t mps;
+
+	if(s->busy || s->fillLen == 0 || !configured) {
+		return;
+	}
+	mps = usb.DeviceConfig.EpCfg[s->ep].In.MaxPacketSize;
+	if(XUsbPs_EpBufferSendWithZLT(&usb, s->ep, s->buf[s->fill], s->fillLen) != XST_SUCCESS) {
+		return;
+	}
+	/* The driver adds a zero length dTD when the transfer ends on a full packet */
+	s->pending = (s->fillLen % mps == 0) ? 2 : 1;
+	s->busy = 1;
+	s->fill ^= 1;
+	s->fillLen = 0;
+	usbStats.ulTransfers++;
+}
+
+static void usbcdcStreamReset(UsbCdcStream *s)
+{
+	s->busy = 0;
+	s->pending = 0;
+	s->fillLen = 0;
+}
+
+static uint32_t usbcdcStreamWrite(UsbCdcStream *s, const void *buf, uint32_t len)
+{
+	uint32_t cpsr = usbcdcLock();
+	uint32_t room;
+
+	if(!*s->open) {
+		usbcdcUnlock(cpsr);
+		return 0;
+	}
+	room = s->size - s->fillLen;
+	if(len > room) {
+		*s->dropped += len - room;
+		len = room;
+	}
+	memcpy(s->buf[s->fill] + s->fillLen, buf, len);
+	s->fillLen += len;
+	*s->bytes += len;
+	usbcdcKick(s);
+	usbcdcUnlock(cpsr);
+	return len;
+}
+
+/* IN transfer complete, called once per dTD */
+static void usbcdcInHandler(void *CallBackRef, u8 EpNum, u8 EventType, void *Data)
+{
+	UsbCdcStream *s = CallBackRef;
+	uint32_t cpsr;
+
+	if(EventType != XUSBPS_EP_EVENT_DATA_TX) {
+		return;
+	}
+	cpsr = usbcdcLock();
+	if(s->pending != 0 && --s->pending == 0) {
+		s->busy = 0;
+		usbcdcKick(s);
+	}
+	usbcdcUnlock(cpsr);
+}
+
+/* Serial port input, copied into the ring so the dTD can be reposted at once */
+static void usbcdcRxHandler(void *CallBackRef, u8 EpNum, u8 EventType, void *Data)
+{
+	u8 *buf;
+	u32 len;
+	u32 handle;
+	uint32_t cpsr;
+
+	if(EventType != XUSBPS_EP_EVENT_DATA_RX ||
+			XUsbPs_EpBufferReceive(&usb, EpNum, &buf, &len, &handle) != XST_SUCCESS) {
+		return;
+	}
+	Xil_DCacheInvalidateRange((INTPTR)buf, len);
+
+	cpsr = usbcdcLock();
+	for(u32 i = 0; i < len; i++) {
+		if(rxHead - rxTail == USBCDC_RX_BUF_SIZE) {
+			usbStats.ulRxDropped += len - i;
+			break;
+		}
+		rxRing[rxHead++ & USBCDC_RX_MASK] = buf[i];
+		usbStats.ulRxBytes++;
+	}
+	usbcdcUnlock(cpsr);
+	XUsbPs_EpBufferRelease(handle);
+}
+
+/* Copy the configuration descriptor for the given speed into buf */
+static uint32_t usbcdcConfigDesc(uint8_t *buf, int highSpeed, uint8_t type)
+{
+	uint32_t mps = highSpeed ? USBCDC_HS_BULK_MPS : USBCDC_FS_BULK_MPS;
+
+	memcpy(buf, configDesc, sizeof(configDesc));
+	buf[1] = type;
+	for(uint32_t i = 0; i < sizeof(configDesc); i += buf[i]) {
+		if(buf[i + 1] != DESC_ENDPOINT) {
+			continue;
+		}
+		if(buf[i + 3] == 0x02) {
+			buf[i + 4] = (uint8_t)mps;
+			buf[i + 5] = (uint8_t)(mps >> 8);
+		} else {
+			buf[i + 6] = highSpeed ? 8 : 16;	/* 16 ms, in 2^(n-1) microframes or in frames */
+		}
+	}
+	return sizeof(configDesc);
+}
+
+/* Build a descriptor in ep0Buf, returns its length or -1 when there is none */
+static int usbcdcGetDescriptor(uint32_t type, uint32_t index)
+{
+	const char *s;
+	uint32_t len;
+
+	switch(type) {
+	case DESC_DEVICE:
+		memcpy(ep0Buf, deviceDesc, sizeof(deviceDesc));
+		return sizeof(deviceDesc);
+	case DESC_QUALIFIER:
+		memcpy(ep0Buf, qualifierDesc, sizeof(qualifierDesc));
+		return sizeof(qualifierDesc);
+	case DESC_CONFIG:
+		return usbcdcConfigDesc(ep0Buf, usbcdcHighSpeed(), DESC_CONFIG);
+	case DESC_OTHER_SPEED:
+		return usbcdcConfigDesc(ep0Buf, !usbcdcHighSpeed(), DESC_OTHER_SPEED);
+	case DESC_STRING:
+		if(index == 0) {
+			ep0Buf[0] = 4;
+			ep0Buf[1] = DESC_STRING;
+			ep0Buf[2] = 0x09;	/* English (US) */
+			ep0Buf[3] = 0x04;
+			return 4;
+		}
+		if(index >= sizeof(strings) / sizeof(strings[0])) {
+			return -1;
+		}
+		/* ASCII to UTF-16LE */
+		s = strings[index];
+		for(len = 2; *s != '\0' && len + 2 <= sizeof(ep0Buf); s++, len += 2) {
+			ep0Buf[len] = (uint8_t)*s;
+			ep0Buf[len + 1] = 0;
+		}
+		ep0Buf[0] = (uint8_t)len;
+		ep0Buf[1] = DESC_STRING;
+		return len;
+	default:
+		return -1;
+	}
+}
+
+/*
+ * Start an IN endpoint over at its first dTD. XUsbPs_ReconfigureEp() relinks
+ * the ring but leaves the tokens: a dTD the host never took is still active,
+ * the driver reports the ring full and the controller would send it first.
+ */
+static void usbcdcInRingReset(uint32_t ep)
+{
+	XUsbPs_EpIn *in = &usb.DeviceConfig.Ep[ep].In;
+
+	XUsbPs_ReconfigureEp(&usb, &usb.DeviceConfig, ep, XUSBPS_EP_DIRECTION_IN, FALSE);
+	for(uint32_t i = 0; i < usb.DeviceConfig.EpCfg[ep].In.NumBufs; i++) {
+		XUsbPs_WritedTD(&in->dTDs[i], XUSBPS_dTDTOKEN, 0);
+		XUsbPs_dTDFlushCache(&in->dTDs[i]);
+	}
+}
+
+/* SET_CONFIGURATION: (re)initialize the data endpoints, or disable them for configuration 0 */
+static void usbcdcConfigure(uint32_t config)
+{
+	uint32_t mps = usbcdcHighSpeed() ? USBCDC_HS_BULK_MPS : USBCDC_FS_BULK_MPS;
+	uint32_t cpsr;
+
+	XUsbPs_EpDisable(&usb, USBCDC_EP_NOTIFY, XUSBPS_EP_DIRECTION_IN);
+	XUsbPs_EpDisable(&usb, USBCDC_EP_ACM, XUSBPS_EP_DIRECTION_IN | XUSBPS_EP_DIRECTION_OUT);
+	XUsbPs_EpDisable(&usb, USBCDC_EP_TRACE, XUSBPS_EP_DIRECTION_IN);
+
+	cpsr = usbcdcLock();
+	configured = 0;
+	acmOpen = 0;
+	traceOpen = 0;
+	usbcdcStreamReset(&acmStream);
+	usbcdcStreamReset(&traceStream);
+	usbcdcUnlock(cpsr);
+	if(config == 0) {
+		return;
+	}
+
+	/* Fresh dTD rings, so nothing left over from before a bus reset is completed twice */
+	usb.DeviceConfig.EpCfg[USBCDC_EP_ACM].Out.MaxPacketSize = mps;
+	usb.DeviceConfig.EpCfg[USBCDC_EP_ACM].In.MaxPacketSize = mps;
+	usb.DeviceConfig.EpCfg[USBCDC_EP_TRACE].In.MaxPacketSize = mps;
+	usbcdcInRingReset(USBCDC_EP_NOTIFY);
+	XUsbPs_ReconfigureEp(&usb, &usb.DeviceConfig, USBCDC_EP_ACM, XUSBPS_EP_DIRECTION_OUT, FALSE);
+	usbcdcInRingReset(USBCDC_EP_ACM);
+	usbcdcInRingReset(USBCDC_EP_TRACE);
+
+	/* The unused direction of an endpoint must not be left as a control endpoint */
+	XUsbPs_SetBits(&usb, XUSBPS_EPCRn_OFFSET(USBCDC_EP_NOTIFY),
+			XUSBPS_EPCR_TXT_INTR_MASK | XUSBPS_EPCR_TXR_MASK | XUSBPS_EPCR_RXT_BULK_MASK);
+	XUsbPs_SetBits(&usb, XUSBPS_EPCRn_OFFSET(USBCDC_EP_ACM),
+			XUSBPS_EPCR_TXT_BULK_MASK | XUSBPS_EPCR_TXR_MASK |
+			XUSBPS_EPCR_RXT_BULK_MASK | XUSBPS_EPCR_RXR_MASK);
+	XUsbPs_SetBits(&usb, XUSBPS_EPCRn_OFFSET(USBCDC_EP_TRACE),
+			XUSBPS_EPCR_TXT_BULK_MASK | XUSBPS_EPCR_TXR_MASK | XUSBPS_EPCR_RXT_BULK_MASK);
+	XUsbPs_EpEnable(&usb, USBCDC_EP_NOTIFY, XUSBPS_EP_DIRECTION_IN);
+	XUsbPs_EpEnable(&usb, USBCDC_EP_ACM, XUSBPS_EP_DIRECTION_IN | XUSBPS_EP_DIRECTION_OUT);
+	XUsbPs_EpEnable(&usb, USBCDC_EP_TRACE, XUSBPS_EP_DIRECTION_IN);
+	XUsbPs_EpPrime(&usb, USBCDC_EP_ACM, XUSBPS_EP_DIRECTION_OUT);
+
+	cpsr = usbcdcLock();
+	configured = config;
+	usbcdcUnlock(cpsr);
+}
+
+/* Returns the length of the reply in ep0Buf, or -1 to stall */
+static int usbcdcStandardRequest(const XUsbPs_SetupData *setup)
+{
+	uint8_t ep = setup->wIndex & 0x0FU;
+	uint8_t dir = (setup->wIndex & 0x80U) ? XUSBPS_EP_DIRECTION_IN : XUSBPS_EP_DIRECTION_OUT;
+	uint32_t epcr;
+
+	switch(setup->bRequest) {
+	case REQ_GET_STATUS:
+		ep0Buf[0] = 0;
+		ep0Buf[1] = 0;
+		if((setup->bmRequestType & REQ_RECIP_MASK) == REQ_RECIP_DEVICE) {
+			ep0Buf[0] = 0x01;	/* Self powered */
+		} else if((setup->bmRequestType & REQ_RECIP_MASK) == REQ_RECIP_ENDPOINT && ep < USBCDC_NUM_EPS) {
+			epcr = XUsbPs_ReadReg(usb.Config.BaseAddress, XUSBPS_EPCRn_OFFSET(ep));
+			ep0Buf[0] = (epcr & (dir == XUSBPS_EP_DIRECTION_IN ? XUSBPS_EPCR_TXS_MASK : XUSBPS_EPCR_RXS_MASK)) ? 1 : 0;
+		}
+		return 2;
+	case REQ_CLEAR_FEATURE:
+	case REQ_SET_FEATURE:
+		if((setup->bmRequestType & REQ_RECIP_MASK) != REQ_RECIP_ENDPOINT) {
+			return 0;	/* Remote wakeup is not supported, accept and ignore */
+		}
+		if(setup->wValue != FEATURE_ENDPOINT_HALT || ep == 0 || ep >= USBCDC_NUM_EPS) {
+			return -1;
+		}
+		if(setup->bRequest == REQ_SET_FEATURE) {
+			XUsbPs_EpStall(&usb, ep, dir);
+		} else {
+			XUsbPs_EpUnStall(&usb, ep, dir);
+			XUsbPs_SetBits(&usb, XUSBPS_EPCRn_OFFSET(ep),
+					dir == XUSBPS_EP_DIRECTION_IN ? XUSBPS_EPCR_TXR_MASK : XUSBPS_EPCR_RXR_MASK);
+		}
+		return 0;
+	case REQ_SET_ADDRESS:
+		/* Takes effect after the status stage */
+		return XUsbPs_SetDeviceAddress(&usb, (u8)setup->wValue) == XST_SUCCESS ? 0 : -1;
+	case REQ_GET_DESCRIPTOR:
+		return usbcdcGetDescriptor(setup->wValue >> 8, setup->wValue & 0xFFU);
+	case REQ_GET_CONFIGURATION:
+		ep0Buf[0] = (uint8_t)configured;
+		return 1;
+	case REQ_SET_CONFIGURATION:
+		if(setup->wValue > 1) {
+			return -1;
+		}
+		usbcdcConfigure(setup->wValue);
+		return 0;
+	case REQ_GET_INTERFACE:
+		ep0Buf[0] = 0;
+		return setup->wIndex <= USBCDC_TRACE_INTERFACE ? 1 : -1;
+	case REQ_SET_INTERFACE:
+		return setup->wValue == 0 ? 0 : -1;	/* Only alternate setting 0 */
+	default:
+		return -1;
+	}
+}
+
+static int usbcdcClassRequest(const XUsbPs_SetupData *setup)
+{
+	uint32_t cpsr;
+
+	switch(setup->bRequest) {
+	case CDC_SET_LINE_CODING:
+		/* Only stored for GET_LINE_CODING, the port has no baud rate */
+		ep0Request = CDC_SET_LINE_CODING;
+		return 0;
+	case CDC_GET_LINE_CODING:
+		memcpy(ep0Buf, lineCoding, sizeof(lineCoding));
+		return sizeof(lineCoding);
+	case CDC_SET_CONTROL_LINE_STATE:
+		cpsr = usbcdcLock();
+		acmOpen = configured && (setup->wValue & 0x01U);	/* DTR */
+		usbcdcUnlock(cpsr);
+		return 0;
+	case CDC_SEND_BREAK:
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+static int usbcdcVendorRequest(const XUsbPs_SetupData *setup)
+{
+	uint32_t cpsr;
+
+	if(setup->bRequest != USBCDC_REQ_TRACE || setup->wIndex != USBCDC_TRACE_INTERFACE) {
+		return -1;
+	}
+	cpsr = usbcdcLock();
+	traceOpen = configured && setup->wValue;
+	usbcdcUnlock(cpsr);
+	return 0;
+}
+
+static void usbcdcSetup(const XUsbPs_SetupData *setup)
+{
+	int len;
+
+	ep0Request = 0;
+	switch(setup->bmRequestType & REQ_TYPE_MASK) {
+	case REQ_TYPE_STANDARD:
+		len = usbcdcStandardRequest(setup);
+		break;
+	case REQ_TYPE_CLASS:
+		len = usbcdcClassRequest(setup);
+		break;
+	case REQ_TYPE_VENDOR:
+		len = usbcdcVendorRequest(setup);
+		break;
+	default:
+		len = -1;
+		break;
+	}
+
+	if(len < 0) {
+		XUsbPs_EpStall(&usb, 0, XUSBPS_EP_DIRECTION_IN | XUSBPS_EP_DIRECTION_OUT);
+	} else if(setup->bmRequestType & REQ_DIR_IN) {
+		if((uint32_t)len >= setup->wLength) {
+			XUsbPs_EpBufferSend(&usb, 0, ep0Buf, setup->wLength);
+		} else {
+			/* Shorter than asked for: a zero length packet ends a reply of whole packets */
+			XUsbPs_EpBufferSendWithZLT(&usb, 0, ep0Buf, (u32)len);
+		}
+	} else if(setup->wLength == 0) {
+		XUsbPs_EpBufferSend(&usb, 0, NULL, 0);	/* Status stage */
+	}
+	/* Otherwise the status follows the OUT data stage, see usbcdcEp0Handler() */
+}
+
+static void usbcdcEp0Handler(void *CallBackRef, u8 EpNum, u8 EventType, void *Data)
+{
+	XUsbPs_SetupData setup;
+	u8 *buf;
+	u32 len;
+	u32 handle;
+
+	switch(EventType) {
+	case XUSBPS_EP_EVENT_SETUP_DATA_RECEIVED:
+		if(XUsbPs_EpGetSetupData(&usb, 0, &setup) == XST_SUCCESS) {
+			usbcdcSetup(&setup);
+		}
+		break;
+	case XUSBPS_EP_EVENT_DATA_RX:
+		/* An OUT data stage, or the status stage of an IN request */
+		if(XUsbPs_EpBufferReceive(&usb, 0, &buf, &len, &handle) != XST_SUCCESS) {
+			break;
+		}
+		/*
+		 * The status stage of the request before may complete in the same
+		 * interrupt as the next setup packet, after it: only a data stage
+		 * ends the request waiting for one.
+		 */
+		if(ep0Request == CDC_SET_LINE_CODING && len >= sizeof(lineCoding)) {
+			Xil_DCacheInvalidateRange((INTPTR)buf, len);
+			memcpy(lineCoding, buf, sizeof(lineCoding));
+			XUsbPs_EpBufferSend(&usb, 0, NULL, 0);
+			ep0Request = 0;
+		}
+		XUsbPs_EpBufferRelease(handle);
+		break;
+	default:
+		break;
+	}
+}
+
+/* Bus reset: the host starts over from the default state, the driver has flushed the endpoints */
+static void usbcdcIntrHandler(void *CallBackRef, u32 Mask)
+{
+	uint32_t cpsr;
+
+	if(Mask & XUSBPS_IXR_UR_MASK) {
+		usbcdcInRingReset(0);	/* A reply the host did not read */
+		cpsr = usbcdcLock();
+		configured = 0;
+		acmOpen = 0;
+		traceOpen = 0;
+		ep0Request = 0;
+		usbcdcStreamReset(&acmStream);
+		usbcdcStreamReset(&traceStream);
+		usbStats.ulBusResets++;
+		usbcdcUnlock(cpsr);
+	}
+}
+
+static void usbcdcEpSetup(XUsbPs_EpSetup *ep, u32 type, u32 bufs, u32 bufSize, u16 mps)
+{
+	ep->Type = type;
+	ep->NumBufs = bufs;
+	ep->BufSize = bufSize;
+	ep->MaxPacketSize = mps;
+}
+
+/* Configure the controller and connect to the bus, the host enumerates once the scheduler runs */
+int usbcdcInit(void)
+{
+	XUsbPs_Config *config;
+
+	config = XUsbPs_LookupConfig(XPAR_XUSBPS_0_DEVICE_ID);
+	if(config == NULL || XUsbPs_CfgInitialize(&usb, config, config->BaseAddress) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	memset(&usbConfig, 0, sizeof(usbConfig));
+	usbConfig.NumEndpoints = USBCDC_NUM_EPS;
+	usbcdcEpSetup(&usbConfig.EpCfg[0].Out, XUSBPS_EP_TYPE_CONTROL, 2, USBCDC_EP0_MPS, USBCDC_EP0_MPS);
+	usbcdcEpSetup(&usbConfig.EpCfg[0].In, XUSBPS_EP_TYPE_CONTROL, USBCDC_IN_DTDS, 0, USBCDC_EP0_MPS);
+	usbcdcEpSetup(&usbConfig.EpCfg[USBCDC_EP_NOTIFY].In, XUSBPS_EP_TYPE_INTERRUPT, 2, 0, USBCDC_NOTIFY_MPS);
+	usbcdcEpSetup(&usbConfig.EpCfg[USBCDC_EP_ACM].Out, XUSBPS_EP_TYPE_BULK, USBCDC_RX_BUFS,
+			USBCDC_HS_BULK_MPS, USBCDC_HS_BULK_MPS);
+	usbcdcEpSetup(&usbConfig.EpCfg[USBCDC_EP_ACM].In, XUSBPS_EP_TYPE_BULK, USBCDC_IN_DTDS, 0, USBCDC_HS_BULK_MPS);
+	usbcdcEpSetup(&usbConfig.EpCfg[USBCDC_EP_TRACE].In, XUSBPS_EP_TYPE_BULK, USBCDC_IN_DTDS, 0, USBCDC_HS_BULK_MPS);
+	usbConfig.DMAMemPhys = (u32)usbDma;
+
+	if(XUsbPs_ConfigureDevice(&usb, &usbConfig) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	XUsbPs_EpSetHandler(&usb, 0, XUSBPS_EP_DIRECTION_OUT, usbcdcEp0Handler, NULL);
+	XUsbPs_EpSetHandler(&usb, USBCDC_EP_ACM, XUSBPS_EP_DIRECTION_OUT, usbcdcRxHandler, NULL);
+	XUsbPs_EpSetHandler(&usb, USBCDC_EP_ACM, XUSBPS_EP_DIRECTION_IN, usbcdcInHandler, &acmStream);
+	XUsbPs_EpSetHandler(&usb, USBCDC_EP_TRACE, XUSBPS_EP_DIRECTION_IN, usbcdcInHandler, &traceStream);
+	XUsbPs_IntrSetHandler(&usb, usbcdcIntrHandler, NULL, XUSBPS_IXR_UR_MASK);
+
+	if(xPortInstallInterruptHandler(XPAR_XUSBPS_0_INTR, XUsbPs_IntrHandler, &usb) != pdPASS) {
+		return XST_FAILURE;
+	}
+	vPortEnableInterrupt(XPAR_XUSBPS_0_INTR);
+	XUsbPs_IntrEnable(&usb, XUSBPS_IXR_UR_MASK | XUSBPS_IXR_UI_MASK);
+	/*
+	 * Interrupt at the end of the microframe of a completion (ITC field, bits
+	 * 23:16). At the reset value of 8 microframes an IN channel waits up to
+	 * 1 ms for its next transfer, which caps the trace channel near 16 MB/s.
+	 */
+	XUsbPs_WriteReg(usb.Config.BaseAddress, XUSBPS_CMD_OFFSET,
+			(XUsbPs_ReadReg(usb.Config.BaseAddress, XUSBPS_CMD_OFFSET) & ~XUSBPS_CMD_ITC_MASK) |
+			(XUSBPS_CMD_ITHRESHOLD_1 << 16));
+	XUsbPs_Start(&usb);
+	return XST_SUCCESS;
+}
+
+/* A host has the serial port open (DTR set) */
+int usbcdcIsOpen(void)
+{
+	return acmOpen;
+}
+
+/* Queue serial port output from any context. Returns the bytes accepted, 0 while the port is closed. */
+uint32_t usbcdcWrite(const void *buf, uint32_t len)
+{
+	return usbcdcStreamWrite(&acmStream, buf, len);
+}
+
+/* Take up to len bytes of serial port input, does not block */
+uint32_t usbcdcRead(void *buf, uint32_t len)
+{
+	uint8_t *p = buf;
+	uint32_t cpsr = usbcdcLock();
+	uint32_t n = 0;
+
+	while(n < len && rxTail != rxHead) {
+		p[n++] = rxRing[rxTail++ & USBCDC_RX_MASK];
+	}
+	usbcdcUnlock(cpsr);
+	return n;
+}
+
+/* A host has started the trace channel */
+int usbcdcTraceIsOpen(void)
+{
+	return traceOpen;
+}
+
+/* Queue trace channel output from any context. Returns the bytes accepted, 0 while the channel is stopped. */
+uint32_t usbcdcTraceWrite(const void *buf, uint32_t len)
+{
+	return usbcdcStreamWrite(&traceStream, buf, len);
+}
+
+void usbcdcGetStats(UsbCdcStats_t *stats)
+{
+	uint32_t cpsr = usbcdcLock();
+
+	*stats = usbStats;
+	usbcdcUnlock(cpsr);
+}
+
+#endif /* STOPWATCH_AMP_CPU1 */
@@ -0,0 +1,60 @@
+/*
+ * USB device on the PS USB0 controller, see usbcdc.c.
+ *
+ * A CDC-ACM serial port (a tty on the host) that carries the console while
+ * the host holds it open, plus a vendor specific bulk IN trace channel for
+ * bulk binary output such as the DLOG records. The trace channel is started
+ * and stopped by the host with the USBCDC_REQ_TRACE vendor request, see
+ * tools/usb_trace_capture.py.
+ */
+
+#ifndef USBCDC_H
+#define USBCDC_H
+
+#include <stdint.h>
+
+#ifndef USBCDC_VID
+#define USBCDC_VID	0x03FDU	/* Xilinx */
+#endif
+
+#ifndef USBCDC_PID
+#define USBCDC_PID	0x0106U
+#endif
+
+#ifndef USBCDC_TX_BUF_SIZE
+#define USBCDC_TX_BUF_SIZE		2048U	/* Each of the two serial port IN buffers */
+#endif
+
+#ifndef USBCDC_TRACE_BUF_SIZE
+#define USBCDC_TRACE_BUF_SIZE	16384U	/* Each of the two trace IN buffers, at most one dTD (16 KB) */
+#endif
+
+#ifndef USBCDC_RX_BUF_SIZE
+#define USBCDC_RX_BUF_SIZE		512U	/* Serial port input ring, must be a power of two */
+#endif
+
+/* Vendor request to the trace interface, wValue 1 starts and 0 stops the channel */
+#define USBCDC_REQ_TRACE		0x01U
+#define USBCDC_TRACE_INTERFACE	2U
+#define USBCDC_TRACE_EP			0x83U
+
+typedef struct {
+	uint32_t ulTxBytes;			/* Serial port bytes queued */
+	uint32_t ulTxDropped;		/* Serial port bytes discarded, both buffers full */
+	uint32_t ulRxBytes;			/* Serial port bytes received */
+	uint32_t ulRxDropped;		/* Received bytes discarded, input ring full */
+	uint32_t ulTraceBytes;		/* Trace channel bytes queued */
+	uint32_t ulTraceDropped;	/* Trace channel bytes discarded */
+	uint32_t ulTransfers;		/* IN transfers started on both channels */
+	uint32_t ulBusResets;
+} UsbCdcStats_t;
+
+int usbcdcInit(void);
+int usbcdcIsOpen(void);
+uint32_t usbcdcWrite(const void *buf, uint32_t len);
+uint32_t usbcdcRead(void *buf, uint32_t len);
+int usbcdcTraceIsOpen(void);
+uint32_t usbcdcTraceWrite(const void *buf, uint32_t len);
+void usbcdcGetStats(UsbCdcStats_t *stats);
+
+#endif /* USBCDC_H */
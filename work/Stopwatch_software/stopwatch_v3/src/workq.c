@@ -0,0 +1,229 @@
+/*
+ * Deferred work queues on WORKQ_WORKERS worker tasks.
+ *
+ * - Each worker has its own bounded lock-free ring of item pointers
+ *   (sequence numbered cells, as the request ring of dmacopy.c), so
+ *   submitting tasks and interrupt handlers neither take a lock nor mask
+ *   interrupts, and a flood of bulk work cannot fill the ring
+ *   of the urgent worker. A full ring refuses the item and counts an
+ *   overflow, the submitter decides whether to retry.
+ * - An item is queued at most once: the submitter sets its queued flag with
+ *   an atomic exchange and only pushes it when the flag was clear, a repeated
+ *   submission is counted as coalesced and costs no ring cell.
+ * - A worker only needs a notification when it is about to block. It arms
+ *   before checking its ring a last time, a submitter disarms and notifies,
+ *   so a submission to a busy worker does not enter the kernel.
+ */
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xstatus.h"
+#include "clocksource.h"
+#include "static_alloc.h"
+#include "workq.h"
+
+#if (WORKQ_RING_SIZE & (WORKQ_RING_SIZE - 1U)) != 0
+#error WORKQ_RING_SIZE must be a power of two
+#endif
+
+#define WORKQ_COUNT(w, field, n)	__atomic_fetch_add(&(w)->stats.field, (n), __ATOMIC_RELAXED)
+
+typedef struct {
+	volatile uint32_t seq;
+	WorkqItem_t *item;
+} WorkqCell;
+
+typedef struct {
+	WorkqCell ring[WORKQ_RING_SIZE];
+	uint32_t head;				/* Next cell to fill */
+	uint32_t tail;				/* Next cell to take, only moved by the worker */
+	uint32_t armed;				/* Set while the worker may block */
+	TaskHandle_t task;
+	WorkqStats_t stats;
+} Workq;
+
+static const char * const workqNames[WORKQ_WORKERS] = { "wq_urgent", "wq_normal", "wq_bulk" };
+static const UBaseType_t workqPriorities[WORKQ_WORKERS] = {
+	WORKQ_PRIORITY_URGENT, WORKQ_PRIORITY_NORMAL, WORKQ_PRIORITY_BULK
+};
+
+static Workq workq[WORKQ_WORKERS];
+STATIC_TASKS(workqTasks, WORKQ_WORKERS, WORKQ_STACK);
+static int workqReady;
+
+static BaseType_t ringPush(Workq *w, WorkqItem_t *item)
+{
+	uint32_t pos = __atomic_load_n(&w->head, __ATOMIC_RELAXED);
+	WorkqCell *cell;
+	int32_t diff;
+
+	for(;;) {
+		cell = &w->ring[pos & (WORKQ_RING_SIZE - 1U)];
+		diff = (int32_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+		if(diff == 0) {
+			if(__atomic_compare_exchange_n(&w->head, &pos, pos + 1U, pdTRUE,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if(diff < 0) {
+			return pdFALSE;
+		} else {
+			pos = __atomic_load_n(&w->head, __ATOMIC_RELAXED);
+		}
+	}
+	cell->item = item;
+	__atomic_store_n(&cell->seq, pos + 1U, __ATOMIC_RELEASE);
+	return pdTRUE;
+}
+
+/* Single consumer, the worker */
+static WorkqItem_t *ringPop(Workq *w)
+{
+	WorkqCell *cell = &w->ring[w->tail & (WORKQ_RING_SIZE - 1U)];
+	WorkqItem_t *item;
+
+	if(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != w->tail + 1U) {
+		return NULL;
+	}
+	item = cell->item;
+	__atomic_store_n(&cell->seq, w->tail + WORKQ_RING_SIZE, __ATOMIC_RELEASE);
+	w->tail++;
+	return item;
+}
+
+static BaseType_t ringEmpty(Workq *w)
+{
+	const WorkqCell *cell = &w->ring[w->tail & (WORKQ_RING_SIZE - 1U)];
+
+	return __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != w->tail + 1U;
+}
+
+/* Queue the item unless it is queued already, *wake is set to the worker to
+ * notify */
+static BaseType_t workqQueue(WorkqItem_t *item, Workq **wake)
+{
+	Workq *w;
+
+	configASSERT(item->worker < WORKQ_WORKERS && workqReady);
+	w = &workq[item->worker];
+	*wake = NULL;
+
+	if(__atomic_exchange_n(&item->queued, 1U, __ATOMIC_ACQUIRE) != 0U) {
+		WORKQ_COUNT(w, ulCoalesced, 1U);
+		return pdPASS;
+	}
+	item->queuedAt = clocksourceNow32();
+	if(ringPush(w, item) == pdFALSE) {
+		__atomic_store_n(&item->queued, 0U, __ATOMIC_RELEASE);
+		WORKQ_COUNT(w, ulOverflows, 1U);
+		return pdFAIL;
+	}
+	WORKQ_COUNT(w, ulSubmitted, 1U);
+
+	/* Pairs with the fence of the worker, one of the two sees the other */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(__atomic_exchange_n(&w->armed, 0U, __ATOMIC_RELAXED) != 0U) {
+		*wake = w;
+	}
+	return pdPASS;
+}
+
+BaseType_t workqSubmit(WorkqItem_t *item)
+{
+	Workq *wake;
+	BaseType_t xResult = workqQueue(item, &wake);
+
+	if(wake != NULL) {
+		xTaskNotifyGive(wake->task);
+	}
+	return xResult;
+}
+
+BaseType_t workqSubmitFromISR(WorkqItem_t *item, BaseType_t *pxHigherPriorityTaskWoken)
+{
+	Workq *wake;
+	BaseType_t xResult = workqQueue(item, &wake);
+
+	if(wake != NULL) {
+		vTaskNotifyGiveFromISR(wake->task, pxHigherPriorityTaskWoken);
+	}
+	return xResult;
+}
+
+static void vWorkqTask(void *pvParameters)
+{
+	Workq *w = (Workq *)pvParameters;
+	WorkqItem_t *item;
+
+	while(1) {
+		uint32_t depth = __atomic_load_n(&w->head, __ATOMIC_RELAXED) - w->tail;
+
+		if(depth > w->stats.ulHighWater) {
+			w->stats.ulHighWater = depth;
+		}
+
+		while((item = ringPop(w)) != NULL) {
+			uint32_t latency = clocksourceNow32() - item->queuedAt;
+
+			if(latency > w->stats.ulMaxLatency) {
+				w->stats.ulMaxLatency = latency;
+			}
+			__atomic_store_n(&item->queued, 0U, __ATOMIC_RELEASE);
+			item->fn(item->arg);
+			WORKQ_COUNT(w, ulRun, 1U);
+		}
+
+		__atomic_store_n(&w->armed, 1U, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if(!ringEmpty(w)) {
+			/* A submitter that disarmed first leaves a notification, the
+			 * next wait then returns at once */
+			(void)__atomic_exchange_n(&w->armed, 0U, __ATOMIC_RELAXED);
+			continue;
+		}
+		(void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	}
+}
+
+void workqInitItem(WorkqItem_t *item, WorkqFunction_t fn, void *arg, uint32_t worker)
+{
+	item->fn = fn;
+	item->arg = arg;
+	item->worker = worker;
+	item->queued = 0U;
+	item->queuedAt = 0U;
+}
+
+int workqInit(void)
+{
+	if(workqReady) {
+		return XST_SUCCESS;
+	}
+
+	for(uint32_t i = 0; i < WORKQ_WORKERS; i++) {
+		Workq *w = &workq[i];
+
+		/* Workers created before a failure are kept for the next call */
+		if(w->task != NULL) {
+			continue;
+		}
+		for(uint32_t c = 0; c < WORKQ_RING_SIZE; c++) {
+			w->ring[c].seq = c;
+		}
+		if(STATIC_TASKS_CREATE(workqTasks, i, vWorkqTask, workqNames[i], w, workqPriorities[i], &w->task) != pdPASS) {
+			return XST_FAILURE;
+		}
+	}
+	workqReady = 1;
+	return XST_SUCCESS;
+}
+
+void workqGetStats(uint32_t worker, WorkqStats_t *stats)
+{
+	configASSERT(worker < WORKQ_WORKERS);
+
+	taskENTER_CRITICAL();
+	*stats = workq[worker].stats;
+	taskEXIT_CRITICAL();
+}
@@ -0,0 +1,78 @@
+/*
+ * Deferred work queues, see workq.c.
+ *
+ * Interrupt handlers and tasks hand work to one of WORKQ_WORKERS worker tasks
+ * of different priorities instead of xTimerPendFunctionCallFromISR(), whose
+ * single queue is shared with the timer commands. A work item is a function
+ * and its argument, owned by the submitter and submitted again each time the
+ * work is needed: an item that is already queued is not queued twice, the
+ * pending run covers both requests. The item must stay valid until it has
+ * run.
+ *
+ * The worker clears the queued flag before it calls the function, so an item
+ * submitted while its function runs runs once more.
+ */
+
+#ifndef WORKQ_H
+#define WORKQ_H
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef WORKQ_RING_SIZE
+#define WORKQ_RING_SIZE		32U		/* Queued items per worker, must be a power of two */
+#endif
+
+#ifndef WORKQ_STACK
+#define WORKQ_STACK			(configMINIMAL_STACK_SIZE * 2)
+#endif
+
+/* Worker priorities, the urgent worker stays below the timer task so a flood
+ * of work does not delay timer expiries */
+#ifndef WORKQ_PRIORITY_URGENT
+#define WORKQ_PRIORITY_URGENT	(configMAX_PRIORITIES - 2)
+#endif
+
+#ifndef WORKQ_PRIORITY_NORMAL
+#define WORKQ_PRIORITY_NORMAL	(configMAX_PRIORITIES - 4)
+#endif
+
+#ifndef WORKQ_PRIORITY_BULK
+#define WORKQ_PRIORITY_BULK		(tskIDLE_PRIORITY + 1)
+#endif
+
+/* Workers */
+#define WORKQ_URGENT	0U		/* Latency critical, short functions only */
+#define WORKQ_NORMAL	1U
+#define WORKQ_BULK		2U		/* Long running work, behind the application tasks */
+#define WORKQ_WORKERS	3U
+
+typedef void (*WorkqFunction_t)(void *arg);
+
+typedef struct {
+	WorkqFunction_t fn;
+	void *arg;
+	uint32_t worker;			/* WORKQ_URGENT, WORKQ_NORMAL or WORKQ_BULK */
+	volatile uint32_t queued;	/* Set from submission until the worker takes it */
+	uint32_t queuedAt;			/* Global timer low word at the first submission */
+} WorkqItem_t;
+
+#define WORKQ_ITEM_INIT(function, argument, w)	{ (function), (argument), (w), 0U, 0U }
+
+typedef struct {
+	uint32_t ulSubmitted;		/* Items queued */
+	uint32_t ulCoalesced;		/* Submissions of an item already queued */
+	uint32_t ulOverflows;		/* Submissions refused by the full ring */
+	uint32_t ulRun;				/* Functions called */
+	uint32_t ulHighWater;		/* Most items queued at once */
+	uint32_t ulMaxLatency;		/* Longest submission to run, global timer counts */
+} WorkqStats_t;
+
+int workqInit(void);
+void workqInitItem(WorkqItem_t *item, WorkqFunction_t fn, void *arg, uint32_t worker);
+BaseType_t workqSubmit(WorkqItem_t *item);
+BaseType_t workqSubmitFromISR(WorkqItem_t *item, BaseType_t *pxHigherPriorityTaskWoken);
+void workqGetStats(uint32_t worker, WorkqStats_t *stats);
+
+#endif /* WORKQ_H */
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Render the deferred log records (src/dlog.c) sent by the stopwatch.
+
+The format strings are read from the .dlog_fmt section of the application
+ELF. The UART capture is read from a file or a serial device set up with
+stty (115200 8N1 raw); plain text around the records is passed through.
+
+    stty -F /dev/ttyUSB1 115200 raw
+    tools/dlog_decode.py Debug/stopwatch_v3.elf /dev/ttyUSB1
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+COUNTS_PER_SECOND = 333333333  # Global timer, CPU clock / 2
+SPEC = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l)?([diuxXc%])")
+
+
+def read_formats(elf_path):
+    """Map format ID (address in .dlog_fmt) to format string."""
+    with open(elf_path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF" or elf[4] not in (1, 2) or elf[5] != 1:
+        sys.exit("%s: not a little endian ELF file" % elf_path)
+    # The Zynq ELF is 32-bit, the host unit test (sim/unit/dlog_test.c) 64-bit
+    if elf[4] == 1:
+        shoff, = struct.unpack_from("<I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+        shdr = "<IIIIII"
+    else:
+        shoff, = struct.unpack_from("<Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x3A)
+        shdr = "<IIQQQQ"
+
+    def section(i):
+        name, _, _, addr, off, size = struct.unpack_from(shdr, elf, shoff + i * shentsize)
+        return name, addr, elf[off:off + size]
+
+    strtab = section(shstrndx)[2]
+    for i in range(shnum):
+        name, addr, data = section(i)
+        if strtab[name:strtab.index(b"\0", name)] == b".dlog_fmt":
+            formats = {}
+            start = 0
+            for end in range(len(data)):
+                if data[end] == 0:
+                    if end > start:
+                        formats[addr + start] = data[start:end].decode("latin-1")
+                    start = end + 1
+            return formats
+    sys.exit("%s: no .dlog_fmt section" % elf_path)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def render(fmt, args):
+    """Apply a C printf format to 32-bit argument words."""
+    args = list(args)
+
+    def conv(m):
+        flags, kind = m.group(1), m.group(2)
+        if kind == "%":
+            return "%"
+        value = args.pop(0) if args else 0
+        if kind in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+            kind = "d"
+        elif kind == "u":
+            kind = "d"
+        elif kind == "c":
+            value = chr(value & 0xFF)
+        return ("%" + flags + kind) % value
+
+    return SPEC.sub(conv, fmt)
+
+
+def decode_record(record, formats, timestamps):
+    if record is None or len(record) < 7 or (len(record) - 7) % 4 or sum(record) & 0xFF:
+        return "<dlog: corrupt record>\r\n"
+    fid, stamp = struct.unpack_from("<HI", record)
+    args = struct.unpack_from("<%dI" % ((len(record) - 7) // 4), record, 6)
+    fmt = formats.get(fid)
+    if fmt is None:
+        return "<dlog: unknown format id %d>\r\n" % fid
+    text = render(fmt, args)
+    if timestamps:
+        text = "[%10.6f] %s" % (stamp / COUNTS_PER_SECOND, text)
+    return text
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="application ELF with the .dlog_fmt section")
+    parser.add_argument("capture", help="UART capture file or serial device")
+    parser.add_argument("-t", "--timestamps", action="store_true",
+                        help="prefix records with the global timer time (wraps every ~12.9 s)")
+    opts = parser.parse_args()
+
+    formats = read_formats(opts.elf)
+    out = sys.stdout
+    frame = None  # Bytes of the record being received, None outside a record
+    with open(opts.capture, "rb", buffering=0) as stream:
+        while True:
+            chunk = stream.read(256)
+            if not chunk:
+                break
+            for byte in chunk:
+                if byte == 0:
+                    if frame is None:
+                        frame = bytearray()
+                    elif frame:
+                        out.write(decode_record(cobs_decode(frame), formats, opts.timestamps))
+                        frame = None
+                    # An empty frame is a closing delimiter directly followed by an opening one
+                elif frame is None:
+                    out.write(chr(byte))
+                else:
+                    frame.append(byte)
+            out.flush()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Compare two kernel benchmark runs (src/kernel_bench.c).
+
+Reads the "kbench," rows of two console captures or CSV files and prints the
+change of the median of every benchmark. Exits with 1 when a median grew by
+more than the threshold, so a CI job can keep the table of the last good run
+as the baseline:
+
+    make -C sim kbench
+    tools/kernel_bench_compare.py baseline.csv sim/build/kernel_bench.csv --threshold 20
+"""
+
+import argparse
+import sys
+
+FIELDS = ("name", "unit", "samples", "min", "median", "mean", "p99", "max")
+
+
+def read_table(path):
+    """name -> row dict of the last run in the file."""
+    rows = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            fields = line.strip().split(",")
+            if fields[0] != "kbench" or len(fields) != len(FIELDS) + 1:
+                continue
+            row = dict(zip(FIELDS, fields[1:]))
+            if row["name"] == "name":
+                rows = {}      # Header, a new run starts
+            elif row["samples"] != "0":
+                rows[row["name"]] = row
+    if not rows:
+        sys.exit("%s: no kbench rows" % path)
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline", help="earlier run")
+    parser.add_argument("current", help="run to check")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed median increase in percent (default %(default)s)")
+    opts = parser.parse_args()
+
+    old, new = read_table(opts.baseline), read_table(opts.current)
+    regressions = 0
+    print("%-18s %-7s %10s %10s %8s" % ("benchmark", "unit", "baseline", "current", "change"))
+    for name, row in new.items():
+        if name not in old:
+            print("%-18s %-7s %10s %10s %8s" % (name, row["unit"], "-", row["median"], "new"))
+            continue
+        if old[name]["unit"] != row["unit"]:
+            sys.exit("%s: %s against %s, runs of different ports" % (name, row["unit"], old[name]["unit"]))
+        before, after = int(old[name]["median"]), int(row["median"])
+        change = 100.0 * (after - before) / before if before else 0.0
+        flag = ""
+        if change > opts.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-18s %-7s %10d %10d %+7.1f%%%s" % (name, row["unit"], before, after, change, flag))
+    for name in old.keys() - new.keys():
+        print("%-18s %-7s %10s %10s %8s" % (name, old[name]["unit"], old[name]["median"], "-", "missing"))
+
+    sys.exit(1 if regressions else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Report the RAM of every object of the application ELF.
+
+Lists the data objects of each writable section (.data, .bss, .ocm_stacks...)
+by size, with the section totals. In the static allocation build every task,
+queue and timer is one of them (src/static_alloc.h: nameTcb, nameStack,
+nameQueue, nameStorage...), so the table is the whole RAM budget, fixed at
+link time. Also tells whether an allocator is linked; with --no-heap the
+script exits with 1 when one is, run it as a post-build step:
+
+    tools/ram_report.py --no-heap Debug/stopwatch_v3.elf
+"""
+
+import argparse
+import struct
+import sys
+
+SHT_SYMTAB = 2
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+STT_OBJECT = 1
+STT_FUNC = 2
+
+ALLOCATORS = ("pvPortMalloc", "vPortFree", "pvPortMallocStack", "vPortFreeStack",
+              "malloc", "_malloc_r", "calloc", "_calloc_r", "realloc", "_realloc_r")
+
+
+def read_elf(elf_path):
+    """RAM sections [(name, addr, size)] and symbols [(name, type, value, size, section index)]."""
+    with open(elf_path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF" or elf[4] != 1:
+        sys.exit("%s: not a 32-bit ELF file" % elf_path)
+    shoff, = struct.unpack_from("<I", elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+
+    def header(i):
+        return struct.unpack_from("<IIIIIIIIII", elf, shoff + i * shentsize)
+
+    def string(table, offset):
+        return table[offset:table.index(b"\0", offset)].decode("latin-1")
+
+    headers = [header(i) for i in range(shnum)]
+    shstrtab = elf[headers[shstrndx][4]:headers[shstrndx][4] + headers[shstrndx][5]]
+    sections = {}
+    symbols = []
+    for i, (name, kind, flags, addr, off, size, link, _, _, entsize) in enumerate(headers):
+        if flags & (SHF_ALLOC | SHF_WRITE) == SHF_ALLOC | SHF_WRITE and size:
+            sections[i] = (string(shstrtab, name), addr, size)
+        if kind == SHT_SYMTAB:
+            strtab = elf[headers[link][4]:headers[link][4] + headers[link][5]]
+            for s in range(off, off + size, entsize):
+                sname, value, ssize, info, _, shndx = struct.unpack_from("<IIIBBH", elf, s)
+                symbols.append((string(strtab, sname), info & 0xF, value, ssize, shndx))
+    if not symbols:
+        sys.exit("%s: no symbol table, link without -s" % elf_path)
+    return sections, symbols
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="application ELF")
+    parser.add_argument("--min", type=int, default=64, metavar="BYTES",
+                        help="hide objects smaller than this, they are still counted (default 64)")
+    parser.add_argument("--no-heap", action="store_true",
+                        help="exit with 1 when an allocator is linked")
+    opts = parser.parse_args()
+
+    sections, symbols = read_elf(opts.elf)
+    objects = {}
+    for name, kind, value, size, shndx in symbols:
+        if kind == STT_OBJECT and size and shndx in sections:
+            objects.setdefault(shndx, {})[value] = (size, name)
+
+    total = 0
+    for shndx, (section, addr, size) in sorted(sections.items(), key=lambda s: s[1][1]):
+        found = sorted(objects.get(shndx, {}).values(), reverse=True)
+        listed = [o for o in found if o[0] >= opts.min]
+        print("%-14s 0x%08x %8d bytes, %d objects" % (section, addr, size, len(found)))
+        for osize, oname in listed:
+            print("    %8d  %s" % (osize, oname))
+        rest = sum(o[0] for o in found) - sum(o[0] for o in listed)
+        if rest:
+            print("    %8d  (%d objects under %d bytes)" % (rest, len(found) - len(listed), opts.min))
+        total += size
+    print("%-14s %19d bytes" % ("total", total))
+
+    linked = sorted({name for name, kind, _, _, shndx in symbols
+                     if kind == STT_FUNC and shndx and name in ALLOCATORS})
+    print("allocator: %s" % (", ".join(linked) if linked else "none linked"))
+    if opts.no_heap and linked:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Turn a sampling profiler dump (vPortSamplerDump) into folded stacks.
+
+The output has one "task;function count" line per sampled function, the
+input format of flamegraph.pl and speedscope. PCs are resolved against the
+function symbols of the application ELF, read with nm.
+
+    tools/sample_flamegraph.py Debug/stopwatch_v3.elf console.log > stopwatch.folded
+    flamegraph.pl stopwatch.folded > stopwatch.svg
+"""
+
+import argparse
+import bisect
+import collections
+import subprocess
+import sys
+
+
+def read_symbols(elf, nm):
+    """Sorted (address, name) list of the function symbols."""
+    out = subprocess.run([nm, "-n", "--defined-only", elf], check=True,
+                         stdout=subprocess.PIPE, universal_newlines=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[1] in "tTwW":
+            symbols.append((int(fields[0], 16), fields[2]))
+    return symbols
+
+
+def read_dump(path):
+    """Task names and (task, pc) -> count of the last complete dump."""
+    tasks, samples, current = {}, None, None
+    with open(path, errors="replace") as f:
+        for line in f:
+            fields = line.split()
+            if not fields:
+                continue
+            if fields[0] == "SAMPLES":
+                tasks, current = {}, collections.Counter()
+            elif current is None:
+                continue
+            elif fields[0] == "T" and len(fields) >= 3:
+                tasks[int(fields[1], 16)] = " ".join(fields[2:])
+            elif fields[0] == "S" and len(fields) == 4:
+                current[(int(fields[1], 16), int(fields[2], 16))] += int(fields[3])
+            elif fields[0] == "END":
+                samples, current = current, None
+    if samples is None:
+        sys.exit("%s: no complete SAMPLES ... END dump" % path)
+    return tasks, samples
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="application ELF")
+    parser.add_argument("dump", help="console capture containing the dump")
+    parser.add_argument("--nm", default="arm-none-eabi-nm", help="nm for the target (default %(default)s)")
+    opts = parser.parse_args()
+
+    symbols = read_symbols(opts.elf, opts.nm)
+    addresses = [address for address, _ in symbols]
+    tasks, samples = read_dump(opts.dump)
+
+    folded = collections.Counter()
+    for (task, pc), count in samples.items():
+        index = bisect.bisect_right(addresses, pc) - 1
+        function = symbols[index][1] if index >= 0 else "0x%08x" % pc
+        if task == 0:
+            name = "[interrupt]"
+        else:
+            name = tasks.get(task, "task@%08x" % task)
+        folded["%s;%s" % (name, function)] += count
+
+    for stack, count in sorted(folded.items()):
+        print("%s %d" % (stack, count))
+
+
+if __name__ == "__main__":
+    main()
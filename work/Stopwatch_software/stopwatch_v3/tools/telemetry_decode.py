@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""Print the UDP telemetry records (src/telemetry.c) sent by the stopwatch.
+
+Datagrams are received live on the telemetry port, or read back from a pcap
+capture of the link (tcpdump -w, Ethernet link type), which also allows
+checking the frames sent through a TAP interface without the board.
+
+    tools/telemetry_decode.py --port 5005
+    tools/telemetry_decode.py --pcap capture.pcap
+"""
+
+import argparse
+import socket
+import struct
+import sys
+
+COUNTS_PER_SECOND = 333333333  # Global timer, CPU clock / 2
+AXI_TIMER_HZ = 100000000       # XPAR_AXI_TIMER_0_CLOCK_FREQ_HZ
+MAGIC = 0x5754
+VERSION = 1
+REC_TIME, REC_EVENT, REC_TASK = 1, 2, 3
+STATES = ("running", "ready", "blocked", "suspended", "deleted", "invalid")
+BUTTONS = {1: "stop", 2: "start", 4: "reset", 8: "user"}
+
+
+def stopwatch(time):
+    ms = time * 1000 // AXI_TIMER_HZ
+    return "%02d:%02d:%02d:%03d" % (ms // 3600000, ms // 60000 % 60, ms // 1000 % 60, ms % 1000)
+
+
+def decode_record(kind, body):
+    if kind == REC_TIME and len(body) == 12:
+        stamp, time = struct.unpack("<IQ", body)
+        return stamp, "time  %s" % stopwatch(time)
+    if kind == REC_EVENT and len(body) == 16:
+        stamp, button, time = struct.unpack("<IIQ", body)
+        return stamp, "event %s at %s" % (BUTTONS.get(button, "button %d" % button), stopwatch(time))
+    if kind == REC_TASK and len(body) >= 10:
+        number, stack, prio, state = struct.unpack_from("<IIBB", body)
+        name = body[10:].split(b"\0", 1)[0].decode("latin-1")
+        state = STATES[state] if state < len(STATES) else str(state)
+        return None, "task  #%-2d %-10s prio %d %-9s stack %d words free" % (number, name, prio, state, stack)
+    return None, "<telemetry: unknown record type %d, %d bytes>" % (kind, len(body))
+
+
+def decode_datagram(data, out):
+    if len(data) < 12:
+        out.write("<telemetry: short datagram>\n")
+        return
+    magic, version, count, seq, stamp = struct.unpack_from("<HBBII", data)
+    if magic != MAGIC or version != VERSION:
+        out.write("<telemetry: bad magic or version>\n")
+        return
+    out.write("# datagram %d, %d records, sent at %.6f\n" % (seq, count, stamp / COUNTS_PER_SECOND))
+    pos = 12
+    for _ in range(count):
+        if pos + 2 > len(data) or pos + 2 + data[pos + 1] > len(data):
+            out.write("<telemetry: truncated record>\n")
+            return
+        kind, size = data[pos], data[pos + 1]
+        rec_stamp, text = decode_record(kind, data[pos + 2:pos + 2 + size])
+        if rec_stamp is None:
+            out.write("             %s\n" % text)
+        else:
+            out.write("[%10.6f] %s\n" % (rec_stamp / COUNTS_PER_SECOND, text))
+        pos += 2 + size
+
+
+def pcap_datagrams(path, port):
+    """UDP payloads to port from an Ethernet pcap file."""
+    with open(path, "rb") as f:
+        header = f.read(24)
+        if len(header) < 24:
+            sys.exit("%s: not a pcap file" % path)
+        magic, = struct.unpack_from("<I", header)
+        if magic in (0xA1B2C3D4, 0xA1B23C4D):
+            endian = "<"
+        elif magic in (0xD4C3B2A1, 0x4D3CB2A1):
+            endian = ">"
+        else:
+            sys.exit("%s: not a pcap file" % path)
+        if struct.unpack_from(endian + "I", header, 20)[0] != 1:
+            sys.exit("%s: not an Ethernet capture" % path)
+        while True:
+            record = f.read(16)
+            if len(record) < 16:
+                return
+            caplen, = struct.unpack_from(endian + "I", record, 8)
+            frame = f.read(caplen)
+            if len(frame) < 42 or frame[12:14] != b"\x08\x00" or frame[23] != 17:
+                continue
+            ip = 14
+            udp = ip + (frame[ip] & 0x0F) * 4
+            dport, length = struct.unpack_from(">HH", frame, udp + 2)
+            if dport == port:
+                yield frame[udp + 8:udp + length]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=5005, help="telemetry UDP port (TELEMETRY_PORT)")
+    parser.add_argument("--pcap", help="decode a pcap capture instead of listening")
+    opts = parser.parse_args()
+
+    out = sys.stdout
+    if opts.pcap:
+        for data in pcap_datagrams(opts.pcap, opts.port):
+            decode_datagram(data, out)
+        return
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("", opts.port))
+    while True:
+        data = sock.recv(2048)
+        decode_datagram(data, out)
+        out.flush()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""Capture the USB trace channel (src/usbcdc.c) of the stopwatch.
+
+Starts the channel with the vendor request, then copies the bulk IN stream
+to a file or stdout until interrupted. While the channel runs, the DLOG
+records are sent there instead of the console, so the output is decoded
+with dlog_decode.py. Needs pyusb, and access to the device (udev rule or
+root).
+
+    tools/usb_trace_capture.py | tools/dlog_decode.py Debug/stopwatch_v3.elf /dev/stdin
+"""
+
+import argparse
+import sys
+
+import usb.core
+import usb.util
+
+VID = 0x03FD            # USBCDC_VID
+PID = 0x0106            # USBCDC_PID
+TRACE_INTERFACE = 2     # USBCDC_TRACE_INTERFACE
+TRACE_EP = 0x83         # USBCDC_TRACE_EP
+REQ_TRACE = 0x01        # USBCDC_REQ_TRACE
+REQ_TYPE = 0x41         # Host to device, vendor, interface
+READ_SIZE = 16384       # USBCDC_TRACE_BUF_SIZE
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("output", nargs="?", help="capture file (default stdout)")
+    parser.add_argument("--vid", type=lambda v: int(v, 0), default=VID)
+    parser.add_argument("--pid", type=lambda v: int(v, 0), default=PID)
+    opts = parser.parse_args()
+
+    dev = usb.core.find(idVendor=opts.vid, idProduct=opts.pid)
+    if dev is None:
+        sys.exit("device %04x:%04x not found" % (opts.vid, opts.pid))
+    usb.util.claim_interface(dev, TRACE_INTERFACE)
+    out = open(opts.output, "wb") if opts.output else sys.stdout.buffer
+    dev.ctrl_transfer(REQ_TYPE, REQ_TRACE, 1, TRACE_INTERFACE)
+    try:
+        while True:
+            try:
+                data = dev.read(TRACE_EP, READ_SIZE, timeout=1000)
+            except usb.core.USBTimeoutError:
+                continue
+            out.write(data)
+            out.flush()
+    except (KeyboardInterrupt, BrokenPipeError):
+        pass
+    finally:
+        dev.ctrl_transfer(REQ_TYPE, REQ_TRACE, 0, TRACE_INTERFACE)
+        usb.util.release_interface(dev, TRACE_INTERFACE)
+
+
+if __name__ == "__main__":
+    main()